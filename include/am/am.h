@@ -3,8 +3,10 @@
 
 #include <types.h>
 #include <am/concept/DataType.h>
+#include <am/concept/WriteBatch.h>
 #include <util/ThreadModel.h>
 #include <memory>
+#include <vector>
 #include <string.h>
 #include <cstdio>
 
@@ -53,6 +55,60 @@ public:
         return false;
     }
 
+    /**
+     * @brief look up all @p keys at once.
+     *
+     * @p values and @p found are resized to keys.size(), values[i] is only
+     * meaningful when found[i] is true. Backends override this to amortize
+     * lock, transaction and seek costs over the whole batch.
+     *
+     * @return the number of keys found
+     */
+    virtual std::size_t multiGet(const std::vector<KeyType>& keys,
+                                 std::vector<ValueType>& values,
+                                 std::vector<bool>& found)
+    {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            if (get(keys[i], values[i]))
+            {
+                found[i] = true;
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief apply all operations in @p batch in order.
+     *
+     * @return true if every operation succeeded
+     */
+    virtual bool writeBatch(const WriteBatch<KeyType, ValueType>& batch)
+    {
+        bool ret = true;
+        typedef typename WriteBatch<KeyType, ValueType>::const_iterator iterator;
+        for (iterator it = batch.begin(); it != batch.end(); ++it)
+        {
+            switch (it->type)
+            {
+            case BATCH_INSERT:
+                ret = insert(it->key, it->value) && ret;
+                break;
+            case BATCH_UPDATE:
+                ret = update(it->key, it->value) && ret;
+                break;
+            case BATCH_DEL:
+                ret = del(it->key) && ret;
+                break;
+            }
+        }
+        return ret;
+    }
+
     virtual ~AccessMethod()
     {
     }
@@ -0,0 +1,130 @@
+#ifndef IZENELIB_AM_APPROXIMATE_MATCHING_QGRAM_MATCH_INDEX_H
+#define IZENELIB_AM_APPROXIMATE_MATCHING_QGRAM_MATCH_INDEX_H
+
+#include <util/ustring/UString.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/tss.hpp>
+
+#include <iostream>
+#include <vector>
+
+namespace izenelib
+{
+namespace am
+{
+
+/**
+ * Finds the texts within an edit distance of a query, as MatchIndex does.
+ *
+ * Each distinct q-gram (q chars) of the texts has the list of the texts
+ * having it, as the varint coded gaps of their ids. A text within k edits of
+ * a query shares at least g - k * q of the g distinct q-grams of the query,
+ * as an edit breaks at most q of them, so the lists of the query grams are
+ * counted, and only the texts reaching that count and of a close length are
+ * verified, by MyersEditDistance. When the query is too short for its grams
+ * to filter anything, the lists of its chars are counted the same way, as
+ * those of 1-grams, and failing that all the texts of the close lengths are
+ * verified.
+ *
+ * Match() is const and may be called from several threads, each keeping its
+ * own buffers. BatchMatch() serves queries on the threads of the index, set
+ * by SetThreadNum(), and returns once those threads are all idle.
+ */
+class QGramMatchIndex
+{
+public:
+    typedef izenelib::util::UString UString;
+    typedef UString::value_type CharT;
+
+    static const uint32_t MaxQ = 4;
+
+    explicit QGramMatchIndex(uint32_t q = 2);
+    ~QGramMatchIndex();
+
+    /// @return the id of @p text, from 0 in the order added
+    uint32_t Add(const UString& text);
+    void Add(const std::vector<UString>& textVec);
+
+    /// builds the lists of all the texts, those added after it are not matched until built again
+    void BuildIndex();
+    bool Hasbuild() const;
+
+    /// appends the texts within @p maxError of @p query, in the order of their ids
+    void Match(const UString& query, int maxError, std::vector<UString>& ret) const;
+    void MatchIds(const UString& query, int maxError, std::vector<uint32_t>& ids) const;
+
+    /// sets the threads of BatchMatch(), 0 to match in the calling thread,
+    /// not to be called while matching
+    void SetThreadNum(size_t threadNum);
+
+    /// @p ret is resized to the queries, and has the texts of each query as Match() appends them
+    void BatchMatch(const std::vector<UString>& queries, int maxError,
+            std::vector<std::vector<UString> >& ret) const;
+
+    const UString& GetText(uint32_t id) const;
+    size_t TextSize() const;
+
+    void Save(std::ostream& ofs) const;
+    void Load(std::istream& ifs);
+    void Clear();
+    void Show() const;
+
+private:
+    QGramMatchIndex(const QGramMatchIndex&);
+    QGramMatchIndex& operator=(const QGramMatchIndex&);
+
+    struct Scratch;
+
+    /// the lists of the grams of one length
+    struct GramLists
+    {
+        std::vector<uint64_t> grams; ///< sorted
+        std::vector<uint32_t> sizes; ///< the number of ids of each list
+        std::vector<uint64_t> offsets; ///< the offset of each list in bytes, and the end
+        std::vector<uint8_t> bytes;
+
+        void clear();
+    };
+
+    /// the distinct grams of @p q chars of @p text, sorted
+    static void Grams(const UString& text, uint32_t q, std::vector<uint64_t>& grams);
+
+    void BuildLists(uint32_t q, GramLists& lists) const;
+
+    /// the list of @p gram, its size 0 if none
+    static void FindList(const GramLists& lists, uint64_t gram, const uint8_t*& list, uint32_t& size);
+
+    /// the ids in at least @p threshold of the lists of @p scratch.grams
+    void CountLists(const GramLists& lists, size_t threshold, Scratch& scratch) const;
+
+    void Verify(const UString& query, size_t maxError, const std::vector<uint32_t>& candidates,
+            Scratch& scratch, std::vector<uint32_t>& ids) const;
+
+    Scratch& GetScratch() const;
+
+    void MatchRange(const std::vector<UString>* queries, int maxError,
+            std::vector<std::vector<UString> >* ret, size_t begin, size_t end) const;
+
+private:
+    uint32_t q_;
+    bool build_;
+
+    std::vector<UString> texts_;
+
+    GramLists qgramLists_;
+    GramLists charLists_; ///< empty if q_ is 1
+
+    std::vector<uint32_t> lengthIds_; ///< the ids by the lengths of their texts
+    std::vector<uint32_t> lengthOffsets_; ///< the offset of each length in lengthIds_, and the end
+
+    mutable boost::thread_specific_ptr<Scratch> scratch_;
+
+    struct Pool;
+    boost::shared_ptr<Pool> pool_;
+};
+
+}
+}
+
+#endif // IZENELIB_AM_APPROXIMATE_MATCHING_QGRAM_MATCH_INDEX_H
@@ -0,0 +1,1121 @@
+/**
+ * @file art_map.hpp
+ * @brief An ordered map on an adaptive radix tree.
+ *
+ * The tree is the one of "The Adaptive Radix Tree: ARTful Indexing for
+ * Main-Memory Databases" (Leis et al.): inner nodes of 4, 16, 48 and 256
+ * children by the next byte of the key, the 16 keys of a Node16 compared at
+ * once with SSE2, path compression (a node keeps the bytes all its keys have
+ * below it, the first 8 of them in the node, the rest read from a leaf) and
+ * lazy expansion (a leaf keeps its whole key, and a subtree of one key is
+ * the leaf only). A lookup then reads one node per distinct byte of the key,
+ * whatever the number of keys, and compares the key once at the leaf.
+ *
+ * The keys are ordered by their bytes, as given by art_key_traits: the
+ * strings as they are, so a key comes before the keys it is a prefix of, and
+ * the integers big endian, the signed ones with the sign bit flipped, so in
+ * the order of their values.
+ *
+ * Not thread safe; see concurrent::ART for concurrent inserts and reads.
+ */
+#ifndef IZENELIB_AM_ART_ART_MAP_HPP
+#define IZENELIB_AM_ART_ART_MAP_HPP
+
+#include <am/am.h>
+#include <am/concept/DataType.h>
+
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_signed.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+NS_IZENELIB_AM_BEGIN
+
+/**
+ * @brief the bytes of a string key, std::string or a string of wider chars,
+ * in the order of the chars for one byte chars only
+ */
+template <class KeyType, class Enable = void>
+struct art_key_traits
+{
+    typedef typename KeyType::value_type char_type;
+
+    enum { BUFFER_SIZE = 1 };
+
+    static const char* bytes(const KeyType& key, char*, size_t& len)
+    {
+        len = key.size() * sizeof(char_type);
+        return reinterpret_cast<const char*>(key.data());
+    }
+
+    static void decode(const char* bytes, size_t len, KeyType& key)
+    {
+        key = KeyType(reinterpret_cast<const char_type*>(bytes), len / sizeof(char_type));
+    }
+};
+
+/// the bytes of an integer key, big endian and with the sign bit flipped
+template <class KeyType>
+struct art_key_traits<KeyType, typename boost::enable_if<boost::is_integral<KeyType> >::type>
+{
+    enum { BUFFER_SIZE = sizeof(KeyType) };
+
+    static const char* bytes(const KeyType& key, char* buffer, size_t& len)
+    {
+        uint64_t v = (uint64_t)key ^ signBit_();
+        for (size_t i = 0; i < sizeof(KeyType); ++i)
+            buffer[i] = (char)(v >> (8 * (sizeof(KeyType) - 1 - i)));
+        len = sizeof(KeyType);
+        return buffer;
+    }
+
+    static void decode(const char* bytes, size_t, KeyType& key)
+    {
+        uint64_t v = 0;
+        for (size_t i = 0; i < sizeof(KeyType); ++i)
+            v = (v << 8) | (uint8_t)bytes[i];
+        key = (KeyType)(v ^ signBit_());
+    }
+
+private:
+    static uint64_t signBit_()
+    {
+        return boost::is_signed<KeyType>::value ? 1ULL << (sizeof(KeyType) * 8 - 1) : 0;
+    }
+};
+
+template <class KeyType, class ValueType>
+class art_map : public AccessMethod<KeyType, ValueType>
+{
+    typedef art_key_traits<KeyType> key_traits;
+
+    typedef uintptr_t child_t; ///< a node, or a leaf with the lowest bit set
+
+    enum NodeType { NODE4, NODE16, NODE48, NODE256 };
+
+    enum { MAX_PREFIX_LENGTH = 8 };
+
+    struct Leaf
+    {
+        ValueType value;
+        uint32_t length;
+        char key[1];
+    };
+
+    struct Node
+    {
+        uint8_t type;
+        uint16_t count;
+        uint32_t prefixLength;
+        uint8_t prefix[MAX_PREFIX_LENGTH]; ///< the first bytes of the prefix
+        child_t end; ///< the leaf of the key ending at the node
+
+        explicit Node(uint8_t t)
+            : type(t), count(0), prefixLength(0), end(0)
+        {
+        }
+    };
+
+    struct Node4 : public Node
+    {
+        uint8_t keys[4];
+        child_t children[4];
+
+        Node4() : Node(NODE4) {}
+    };
+
+    struct Node16 : public Node
+    {
+        uint8_t keys[16];
+        child_t children[16];
+
+        Node16() : Node(NODE16) {}
+    };
+
+    struct Node48 : public Node
+    {
+        uint8_t index[256]; ///< the slot of each byte in children, from 1
+        child_t children[48];
+
+        Node48() : Node(NODE48)
+        {
+            std::memset(index, 0, sizeof(index));
+            std::memset(children, 0, sizeof(children));
+        }
+    };
+
+    struct Node256 : public Node
+    {
+        child_t children[256];
+
+        Node256() : Node(NODE256)
+        {
+            std::memset(children, 0, sizeof(children));
+        }
+    };
+
+public:
+    typedef KeyType key_type;
+    typedef ValueType value_type;
+    typedef DataType<KeyType, ValueType> data_type;
+
+    /**
+     * @brief the position of a key, with the path of nodes to it; any insert
+     * or del invalidates the cursors
+     */
+    class cursor_type
+    {
+    public:
+        cursor_type() : leaf_(NULL) {}
+
+        bool operator==(const cursor_type& other) const
+        {
+            return leaf_ == other.leaf_;
+        }
+
+        bool operator!=(const cursor_type& other) const
+        {
+            return leaf_ != other.leaf_;
+        }
+
+    private:
+        friend class art_map;
+
+        /// the nodes from the root, with the byte of the child taken, -1 for the end
+        std::vector<std::pair<Node*, int> > path_;
+        Leaf* leaf_;
+    };
+
+    art_map()
+        : root_(0), size_(0)
+    {
+    }
+
+    ~art_map()
+    {
+        clear();
+    }
+
+    bool insert(const KeyType& key, const ValueType& value)
+    {
+        bool inserted = false;
+        char buffer[key_traits::BUFFER_SIZE];
+        size_t len;
+        const char* bytes = key_traits::bytes(key, buffer, len);
+        insert_(root_, bytes, len, 0, value, inserted);
+        if (inserted) ++size_;
+        return inserted;
+    }
+
+    bool insert(const DataType<KeyType, ValueType>& rec)
+    {
+        return insert(rec.key, rec.value);
+    }
+
+    /**
+     * @brief sets the value of key, inserting it if not in the map
+     */
+    bool update(const KeyType& key, const ValueType& value)
+    {
+        bool inserted = false;
+        char buffer[key_traits::BUFFER_SIZE];
+        size_t len;
+        const char* bytes = key_traits::bytes(key, buffer, len);
+        Leaf* leaf = insert_(root_, bytes, len, 0, value, inserted);
+        if (inserted)
+            ++size_;
+        else
+            leaf->value = value;
+        return true;
+    }
+
+    bool update(const DataType<KeyType, ValueType>& rec)
+    {
+        return update(rec.key, rec.value);
+    }
+
+    bool get(const KeyType& key, ValueType& value)
+    {
+        ValueType* found = find(key);
+        if (found)
+        {
+            value = *found;
+            return true;
+        }
+        return false;
+    }
+
+    ValueType* find(const KeyType& key)
+    {
+        char buffer[key_traits::BUFFER_SIZE];
+        size_t len;
+        const char* bytes = key_traits::bytes(key, buffer, len);
+        Leaf* leaf = findLeaf_(bytes, len);
+        return leaf ? &leaf->value : NULL;
+    }
+
+    bool del(const KeyType& key)
+    {
+        char buffer[key_traits::BUFFER_SIZE];
+        size_t len;
+        const char* bytes = key_traits::bytes(key, buffer, len);
+        if (!del_(root_, bytes, len, 0))
+            return false;
+        --size_;
+        return true;
+    }
+
+    int num_items()
+    {
+        return size_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    void clear()
+    {
+        if (root_) destroy_(root_);
+        root_ = 0;
+        size_ = 0;
+    }
+
+    /// the first key
+    cursor_type begin()
+    {
+        cursor_type cursor;
+        if (root_) descendFirst_(cursor, root_);
+        return cursor;
+    }
+
+    /// the first key not less than key
+    cursor_type begin(const KeyType& key)
+    {
+        char buffer[key_traits::BUFFER_SIZE];
+        size_t len;
+        const char* bytes = key_traits::bytes(key, buffer, len);
+        cursor_type cursor;
+        seek_(cursor, bytes, len);
+        return cursor;
+    }
+
+    /// the last key
+    cursor_type rbegin()
+    {
+        cursor_type cursor;
+        if (root_) descendLast_(cursor, root_);
+        return cursor;
+    }
+
+    bool fetch(cursor_type& cursor, KeyType& key, ValueType& value)
+    {
+        if (!cursor.leaf_)
+            return false;
+        key_traits::decode(cursor.leaf_->key, cursor.leaf_->length, key);
+        value = cursor.leaf_->value;
+        return true;
+    }
+
+    /// @return false if no key after the cursor
+    bool iterNext(cursor_type& cursor)
+    {
+        return cursor.leaf_ && next_(cursor);
+    }
+
+    /// @return false if no key before the cursor
+    bool iterPrev(cursor_type& cursor)
+    {
+        return cursor.leaf_ && prev_(cursor);
+    }
+
+private:
+    art_map(const art_map&);
+    art_map& operator=(const art_map&);
+
+    static bool isLeaf_(child_t c)
+    {
+        return c & 1;
+    }
+
+    static Leaf* asLeaf_(child_t c)
+    {
+        return reinterpret_cast<Leaf*>(c & ~(child_t)1);
+    }
+
+    static Node* asNode_(child_t c)
+    {
+        return reinterpret_cast<Node*>(c);
+    }
+
+    static child_t leafChild_(Leaf* leaf)
+    {
+        return reinterpret_cast<child_t>(leaf) | 1;
+    }
+
+    static child_t nodeChild_(Node* node)
+    {
+        return reinterpret_cast<child_t>(node);
+    }
+
+    static Leaf* newLeaf_(const char* key, size_t len, const ValueType& value)
+    {
+        Leaf* leaf = static_cast<Leaf*>(::operator new(sizeof(Leaf) + len));
+        new (&leaf->value) ValueType(value);
+        leaf->length = len;
+        if (len) std::memcpy(leaf->key, key, len);
+        return leaf;
+    }
+
+    static void deleteLeaf_(Leaf* leaf)
+    {
+        leaf->value.~ValueType();
+        ::operator delete(leaf);
+    }
+
+    static bool leafMatches_(const Leaf* leaf, const char* key, size_t len)
+    {
+        return leaf->length == len && std::memcmp(leaf->key, key, len) == 0;
+    }
+
+    static int compareLeaf_(const Leaf* leaf, const char* key, size_t len)
+    {
+        int ret = std::memcmp(leaf->key, key, std::min<size_t>(leaf->length, len));
+        if (ret) return ret;
+        return leaf->length < len ? -1 : leaf->length > len;
+    }
+
+    static void deleteNode_(Node* node)
+    {
+        switch (node->type)
+        {
+        case NODE4: delete static_cast<Node4*>(node); break;
+        case NODE16: delete static_cast<Node16*>(node); break;
+        case NODE48: delete static_cast<Node48*>(node); break;
+        default: delete static_cast<Node256*>(node); break;
+        }
+    }
+
+    static void setPrefix_(Node* node, const uint8_t* prefix, size_t len)
+    {
+        std::memcpy(node->prefix, prefix, std::min<size_t>(len, MAX_PREFIX_LENGTH));
+        node->prefixLength = len;
+    }
+
+    static child_t* findChild_(Node* node, uint8_t b)
+    {
+        switch (node->type)
+        {
+        case NODE4:
+        {
+            Node4* n = static_cast<Node4*>(node);
+            for (size_t i = 0; i < n->count; ++i)
+            {
+                if (n->keys[i] == b) return &n->children[i];
+            }
+            return NULL;
+        }
+        case NODE16:
+        {
+            Node16* n = static_cast<Node16*>(node);
+#ifdef __SSE2__
+            __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char)b),
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(n->keys)));
+            unsigned mask = _mm_movemask_epi8(cmp) & ((1U << n->count) - 1);
+            return mask ? &n->children[__builtin_ctz(mask)] : NULL;
+#else
+            for (size_t i = 0; i < n->count; ++i)
+            {
+                if (n->keys[i] == b) return &n->children[i];
+            }
+            return NULL;
+#endif
+        }
+        case NODE48:
+        {
+            Node48* n = static_cast<Node48*>(node);
+            return n->index[b] ? &n->children[n->index[b] - 1] : NULL;
+        }
+        default:
+        {
+            Node256* n = static_cast<Node256*>(node);
+            return n->children[b] ? &n->children[b] : NULL;
+        }
+        }
+    }
+
+    static bool isFull_(const Node* node)
+    {
+        switch (node->type)
+        {
+        case NODE4: return node->count == 4;
+        case NODE16: return node->count == 16;
+        case NODE48: return node->count == 48;
+        default: return false;
+        }
+    }
+
+    /// the position of b in the sorted keys of a Node4 or Node16
+    static size_t lowerBound_(const uint8_t* keys, size_t count, uint8_t b)
+    {
+        size_t pos = 0;
+        while (pos < count && keys[pos] < b) ++pos;
+        return pos;
+    }
+
+    static size_t lowerBound_(const Node16* node, uint8_t b)
+    {
+#ifdef __SSE2__
+        // the bytes compared signed, so with their highest bits flipped
+        const __m128i flip = _mm_set1_epi8((char)0x80);
+        __m128i keys = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(node->keys)), flip);
+        __m128i cmp = _mm_cmplt_epi8(keys, _mm_set1_epi8((char)(b ^ 0x80)));
+        unsigned mask = ~_mm_movemask_epi8(cmp) & ((1U << node->count) - 1);
+        return mask ? __builtin_ctz(mask) : node->count;
+#else
+        return lowerBound_(node->keys, node->count, b);
+#endif
+    }
+
+    template <class SortedNode>
+    static void insertSorted_(SortedNode* node, size_t pos, uint8_t b, child_t child)
+    {
+        std::memmove(node->keys + pos + 1, node->keys + pos, node->count - pos);
+        std::memmove(node->children + pos + 1, node->children + pos, (node->count - pos) * sizeof(child_t));
+        node->keys[pos] = b;
+        node->children[pos] = child;
+        ++node->count;
+    }
+
+    /// inserts a child of a byte not in @p node, which is not full
+    static void insertChild_(Node* node, uint8_t b, child_t child)
+    {
+        switch (node->type)
+        {
+        case NODE4:
+        {
+            Node4* n = static_cast<Node4*>(node);
+            insertSorted_(n, lowerBound_(n->keys, n->count, b), b, child);
+            break;
+        }
+        case NODE16:
+        {
+            Node16* n = static_cast<Node16*>(node);
+            insertSorted_(n, lowerBound_(n, b), b, child);
+            break;
+        }
+        case NODE48:
+        {
+            Node48* n = static_cast<Node48*>(node);
+            size_t slot = 0;
+            while (n->children[slot]) ++slot;
+            n->children[slot] = child;
+            n->index[b] = slot + 1;
+            ++n->count;
+            break;
+        }
+        default:
+        {
+            Node256* n = static_cast<Node256*>(node);
+            n->children[b] = child;
+            ++n->count;
+            break;
+        }
+        }
+    }
+
+    template <class SortedNode>
+    static void removeSorted_(SortedNode* node, uint8_t b)
+    {
+        size_t pos = lowerBound_(node->keys, node->count, b);
+        std::memmove(node->keys + pos, node->keys + pos + 1, node->count - pos - 1);
+        std::memmove(node->children + pos, node->children + pos + 1, (node->count - pos - 1) * sizeof(child_t));
+        --node->count;
+    }
+
+    /// removes the child of a byte in @p node
+    static void removeChild_(Node* node, uint8_t b)
+    {
+        switch (node->type)
+        {
+        case NODE4:
+            removeSorted_(static_cast<Node4*>(node), b);
+            break;
+        case NODE16:
+            removeSorted_(static_cast<Node16*>(node), b);
+            break;
+        case NODE48:
+        {
+            Node48* n = static_cast<Node48*>(node);
+            n->children[n->index[b] - 1] = 0;
+            n->index[b] = 0;
+            --n->count;
+            break;
+        }
+        default:
+        {
+            Node256* n = static_cast<Node256*>(node);
+            n->children[b] = 0;
+            --n->count;
+            break;
+        }
+        }
+    }
+
+    /// the first byte after @p after with a child, 256 if none
+    static int nextByte_(const Node* node, int after)
+    {
+        switch (node->type)
+        {
+        case NODE4:
+        {
+            const Node4* n = static_cast<const Node4*>(node);
+            for (size_t i = 0; i < n->count; ++i)
+            {
+                if (n->keys[i] > after) return n->keys[i];
+            }
+            return 256;
+        }
+        case NODE16:
+        {
+            const Node16* n = static_cast<const Node16*>(node);
+            for (size_t i = 0; i < n->count; ++i)
+            {
+                if (n->keys[i] > after) return n->keys[i];
+            }
+            return 256;
+        }
+        case NODE48:
+        {
+            const Node48* n = static_cast<const Node48*>(node);
+            for (int b = after + 1; b < 256; ++b)
+            {
+                if (n->index[b]) return b;
+            }
+            return 256;
+        }
+        default:
+        {
+            const Node256* n = static_cast<const Node256*>(node);
+            for (int b = after + 1; b < 256; ++b)
+            {
+                if (n->children[b]) return b;
+            }
+            return 256;
+        }
+        }
+    }
+
+    /// the last byte before @p before with a child, -1 if none
+    static int prevByte_(const Node* node, int before)
+    {
+        switch (node->type)
+        {
+        case NODE4:
+        {
+            const Node4* n = static_cast<const Node4*>(node);
+            for (size_t i = n->count; i > 0; --i)
+            {
+                if (n->keys[i - 1] < before) return n->keys[i - 1];
+            }
+            return -1;
+        }
+        case NODE16:
+        {
+            const Node16* n = static_cast<const Node16*>(node);
+            for (size_t i = n->count; i > 0; --i)
+            {
+                if (n->keys[i - 1] < before) return n->keys[i - 1];
+            }
+            return -1;
+        }
+        case NODE48:
+        {
+            const Node48* n = static_cast<const Node48*>(node);
+            for (int b = before - 1; b >= 0; --b)
+            {
+                if (n->index[b]) return b;
+            }
+            return -1;
+        }
+        default:
+        {
+            const Node256* n = static_cast<const Node256*>(node);
+            for (int b = before - 1; b >= 0; --b)
+            {
+                if (n->children[b]) return b;
+            }
+            return -1;
+        }
+        }
+    }
+
+    /// a node of @p type with the children and prefix of @p node, which is deleted
+    static Node* resize_(Node* node, NodeType type)
+    {
+        Node* copy;
+        switch (type)
+        {
+        case NODE4: copy = new Node4; break;
+        case NODE16: copy = new Node16; break;
+        case NODE48: copy = new Node48; break;
+        default: copy = new Node256; break;
+        }
+        copy->prefixLength = node->prefixLength;
+        std::memcpy(copy->prefix, node->prefix, MAX_PREFIX_LENGTH);
+        copy->end = node->end;
+        for (int b = nextByte_(node, -1); b < 256; b = nextByte_(node, b))
+            insertChild_(copy, b, *findChild_(node, b));
+        deleteNode_(node);
+        return copy;
+    }
+
+    /// inserts a child into the node of @p ref, growing it if full
+    static void addChild_(child_t& ref, uint8_t b, child_t child)
+    {
+        Node* node = asNode_(ref);
+        if (isFull_(node))
+        {
+            node = resize_(node, (NodeType)(node->type + 1));
+            ref = nodeChild_(node);
+        }
+        insertChild_(node, b, child);
+    }
+
+    /// the first leaf below @p child, all of them having the whole prefix of a node
+    static const Leaf* minimum_(child_t child)
+    {
+        while (!isLeaf_(child))
+        {
+            Node* node = asNode_(child);
+            child = node->end ? node->end : *findChild_(node, nextByte_(node, -1));
+        }
+        return asLeaf_(child);
+    }
+
+    /// the ith byte of the prefix of @p node, from a leaf for the ones not kept in it
+    static uint8_t prefixByte_(const Node* node, size_t i, const Leaf* leaf, size_t depth)
+    {
+        return i < MAX_PREFIX_LENGTH ? node->prefix[i] : (uint8_t)leaf->key[depth + i];
+    }
+
+    /// the length of the prefix of @p node matching the key from @p depth
+    static size_t prefixMismatch_(Node* node, const char* key, size_t len, size_t depth)
+    {
+        size_t stored = std::min<size_t>(node->prefixLength, MAX_PREFIX_LENGTH);
+        for (size_t i = 0; i < stored; ++i)
+        {
+            if (depth + i >= len || node->prefix[i] != (uint8_t)key[depth + i])
+                return i;
+        }
+        if (node->prefixLength > MAX_PREFIX_LENGTH)
+        {
+            const Leaf* leaf = minimum_(nodeChild_(node));
+            for (size_t i = MAX_PREFIX_LENGTH; i < node->prefixLength; ++i)
+            {
+                if (depth + i >= len || leaf->key[depth + i] != key[depth + i])
+                    return i;
+            }
+        }
+        return node->prefixLength;
+    }
+
+    /// puts @p leaf under @p node, at @p depth after its prefix
+    static void placeLeaf_(Node* node, Leaf* leaf, size_t depth)
+    {
+        if (depth == leaf->length)
+            node->end = leafChild_(leaf);
+        else
+            insertChild_(node, (uint8_t)leaf->key[depth], leafChild_(leaf));
+    }
+
+    /// @return the leaf of the key, inserted or found
+    static Leaf* insert_(child_t& ref, const char* key, size_t len, size_t depth,
+            const ValueType& value, bool& inserted)
+    {
+        if (!ref)
+        {
+            Leaf* added = newLeaf_(key, len, value);
+            ref = leafChild_(added);
+            inserted = true;
+            return added;
+        }
+
+        if (isLeaf_(ref))
+        {
+            Leaf* leaf = asLeaf_(ref);
+            if (leafMatches_(leaf, key, len))
+                return leaf;
+
+            // expand the leaf into a node of the bytes both keys have
+            size_t common = 0;
+            while (depth + common < len && depth + common < leaf->length
+                    && key[depth + common] == leaf->key[depth + common])
+                ++common;
+            Node* expanded = new Node4;
+            setPrefix_(expanded, reinterpret_cast<const uint8_t*>(key + depth), common);
+            Leaf* added = newLeaf_(key, len, value);
+            placeLeaf_(expanded, leaf, depth + common);
+            placeLeaf_(expanded, added, depth + common);
+            ref = nodeChild_(expanded);
+            inserted = true;
+            return added;
+        }
+
+        Node* node = asNode_(ref);
+        if (node->prefixLength)
+        {
+            size_t mismatch = prefixMismatch_(node, key, len, depth);
+            if (mismatch < node->prefixLength)
+            {
+                // split the prefix at the first byte not matched
+                const Leaf* leaf = node->prefixLength > MAX_PREFIX_LENGTH ? minimum_(ref) : NULL;
+                Node* split = new Node4;
+                setPrefix_(split, reinterpret_cast<const uint8_t*>(key + depth), mismatch);
+                insertChild_(split, prefixByte_(node, mismatch, leaf, depth), ref);
+
+                uint8_t rest[MAX_PREFIX_LENGTH];
+                size_t restLength = node->prefixLength - mismatch - 1;
+                for (size_t i = 0; i < restLength && i < MAX_PREFIX_LENGTH; ++i)
+                    rest[i] = prefixByte_(node, mismatch + 1 + i, leaf, depth);
+                setPrefix_(node, rest, restLength);
+
+                Leaf* added = newLeaf_(key, len, value);
+                placeLeaf_(split, added, depth + mismatch);
+                ref = nodeChild_(split);
+                inserted = true;
+                return added;
+            }
+            depth += node->prefixLength;
+        }
+
+        if (depth == len)
+        {
+            if (node->end)
+                return asLeaf_(node->end);
+            Leaf* added = newLeaf_(key, len, value);
+            node->end = leafChild_(added);
+            inserted = true;
+            return added;
+        }
+
+        child_t* child = findChild_(node, (uint8_t)key[depth]);
+        if (child)
+            return insert_(*child, key, len, depth + 1, value, inserted);
+
+        Leaf* added = newLeaf_(key, len, value);
+        addChild_(ref, (uint8_t)key[depth], leafChild_(added));
+        inserted = true;
+        return added;
+    }
+
+    Leaf* findLeaf_(const char* key, size_t len) const
+    {
+        child_t child = root_;
+        size_t depth = 0;
+        while (child)
+        {
+            if (isLeaf_(child))
+            {
+                Leaf* leaf = asLeaf_(child);
+                return leafMatches_(leaf, key, len) ? leaf : NULL;
+            }
+
+            // the prefix bytes not in the node are checked with the whole key at the leaf
+            Node* node = asNode_(child);
+            size_t stored = std::min<size_t>(node->prefixLength, MAX_PREFIX_LENGTH);
+            for (size_t i = 0; i < stored; ++i)
+            {
+                if (depth + i >= len || node->prefix[i] != (uint8_t)key[depth + i])
+                    return NULL;
+            }
+            depth += node->prefixLength;
+            if (depth > len)
+                return NULL;
+
+            if (depth == len)
+            {
+                child = node->end;
+            }
+            else
+            {
+                child_t* next = findChild_(node, (uint8_t)key[depth]);
+                child = next ? *next : 0;
+                ++depth;
+            }
+        }
+        return NULL;
+    }
+
+    /// @return false if the key is not in the tree
+    static bool del_(child_t& ref, const char* key, size_t len, size_t depth)
+    {
+        if (!ref)
+            return false;
+
+        if (isLeaf_(ref))
+        {
+            if (!leafMatches_(asLeaf_(ref), key, len))
+                return false;
+            deleteLeaf_(asLeaf_(ref));
+            ref = 0;
+            return true;
+        }
+
+        Node* node = asNode_(ref);
+        size_t nodeDepth = depth;
+        depth += node->prefixLength;
+        if (depth > len)
+            return false;
+
+        if (depth == len)
+        {
+            if (!node->end || !leafMatches_(asLeaf_(node->end), key, len))
+                return false;
+            deleteLeaf_(asLeaf_(node->end));
+            node->end = 0;
+            shrink_(ref, nodeDepth);
+            return true;
+        }
+
+        uint8_t b = key[depth];
+        child_t* child = findChild_(node, b);
+        if (!child)
+            return false;
+        if (!isLeaf_(*child))
+            return del_(*child, key, len, depth + 1);
+
+        if (!leafMatches_(asLeaf_(*child), key, len))
+            return false;
+        deleteLeaf_(asLeaf_(*child));
+        removeChild_(node, b);
+        shrink_(ref, nodeDepth);
+        return true;
+    }
+
+    /**
+     * replaces the node of @p ref, starting at @p depth, by its only child,
+     * or by a smaller node, after a child removed
+     */
+    static void shrink_(child_t& ref, size_t depth)
+    {
+        Node* node = asNode_(ref);
+        if (node->count + (node->end ? 1 : 0) == 1)
+        {
+            child_t child = node->end ? node->end : *findChild_(node, nextByte_(node, -1));
+            if (!isLeaf_(child))
+            {
+                // the child takes the prefix, the byte and its own prefix
+                Node* only = asNode_(child);
+                const Leaf* leaf = minimum_(child);
+                size_t length = node->prefixLength + 1 + only->prefixLength;
+                setPrefix_(only, reinterpret_cast<const uint8_t*>(leaf->key + depth), length);
+            }
+            deleteNode_(node);
+            ref = child;
+            return;
+        }
+
+        switch (node->type)
+        {
+        case NODE16:
+            if (node->count <= 3) ref = nodeChild_(resize_(node, NODE4));
+            break;
+        case NODE48:
+            if (node->count <= 12) ref = nodeChild_(resize_(node, NODE16));
+            break;
+        case NODE256:
+            if (node->count <= 37) ref = nodeChild_(resize_(node, NODE48));
+            break;
+        default:
+            break;
+        }
+    }
+
+    static void destroy_(child_t child)
+    {
+        if (isLeaf_(child))
+        {
+            deleteLeaf_(asLeaf_(child));
+            return;
+        }
+        Node* node = asNode_(child);
+        if (node->end) destroy_(node->end);
+        for (int b = nextByte_(node, -1); b < 256; b = nextByte_(node, b))
+            destroy_(*findChild_(node, b));
+        deleteNode_(node);
+    }
+
+    static void descendFirst_(cursor_type& cursor, child_t child)
+    {
+        while (!isLeaf_(child))
+        {
+            Node* node = asNode_(child);
+            if (node->end)
+            {
+                cursor.path_.push_back(std::make_pair(node, -1));
+                child = node->end;
+            }
+            else
+            {
+                int b = nextByte_(node, -1);
+                cursor.path_.push_back(std::make_pair(node, b));
+                child = *findChild_(node, b);
+            }
+        }
+        cursor.leaf_ = asLeaf_(child);
+    }
+
+    static void descendLast_(cursor_type& cursor, child_t child)
+    {
+        while (!isLeaf_(child))
+        {
+            Node* node = asNode_(child);
+            int b = prevByte_(node, 256);
+            if (b >= 0)
+            {
+                cursor.path_.push_back(std::make_pair(node, b));
+                child = *findChild_(node, b);
+            }
+            else
+            {
+                cursor.path_.push_back(std::make_pair(node, -1));
+                child = node->end;
+            }
+        }
+        cursor.leaf_ = asLeaf_(child);
+    }
+
+    static bool next_(cursor_type& cursor)
+    {
+        while (!cursor.path_.empty())
+        {
+            std::pair<Node*, int>& top = cursor.path_.back();
+            int b = nextByte_(top.first, top.second);
+            if (b < 256)
+            {
+                top.second = b;
+                descendFirst_(cursor, *findChild_(top.first, b));
+                return true;
+            }
+            cursor.path_.pop_back();
+        }
+        cursor.leaf_ = NULL;
+        return false;
+    }
+
+    static bool prev_(cursor_type& cursor)
+    {
+        while (!cursor.path_.empty())
+        {
+            std::pair<Node*, int>& top = cursor.path_.back();
+            if (top.second >= 0)
+            {
+                int b = prevByte_(top.first, top.second);
+                if (b >= 0)
+                {
+                    top.second = b;
+                    descendLast_(cursor, *findChild_(top.first, b));
+                    return true;
+                }
+                if (top.first->end)
+                {
+                    top.second = -1;
+                    cursor.leaf_ = asLeaf_(top.first->end);
+                    return true;
+                }
+            }
+            cursor.path_.pop_back();
+        }
+        cursor.leaf_ = NULL;
+        return false;
+    }
+
+    /// moves @p cursor to the first key not less than @p key
+    void seek_(cursor_type& cursor, const char* key, size_t len) const
+    {
+        child_t child = root_;
+        size_t depth = 0;
+        while (child)
+        {
+            if (isLeaf_(child))
+            {
+                cursor.leaf_ = asLeaf_(child);
+                if (compareLeaf_(cursor.leaf_, key, len) < 0)
+                    next_(cursor);
+                return;
+            }
+
+            // the keys below the node are all less, or all greater, when the
+            // prefix does not match
+            Node* node = asNode_(child);
+            if (node->prefixLength)
+            {
+                const Leaf* leaf = node->prefixLength > MAX_PREFIX_LENGTH ? minimum_(child) : NULL;
+                for (size_t i = 0; i < node->prefixLength; ++i)
+                {
+                    if (depth + i == len)
+                    {
+                        descendFirst_(cursor, child);
+                        return;
+                    }
+                    uint8_t p = prefixByte_(node, i, leaf, depth);
+                    uint8_t k = key[depth + i];
+                    if (p < k)
+                    {
+                        next_(cursor);
+                        return;
+                    }
+                    if (p > k)
+                    {
+                        descendFirst_(cursor, child);
+                        return;
+                    }
+                }
+                depth += node->prefixLength;
+            }
+
+            if (depth == len)
+            {
+                descendFirst_(cursor, child);
+                return;
+            }
+
+            uint8_t b = key[depth];
+            cursor.path_.push_back(std::make_pair(node, (int)b));
+            child_t* next = findChild_(node, b);
+            if (!next)
+            {
+                next_(cursor);
+                return;
+            }
+            child = *next;
+            ++depth;
+        }
+    }
+
+private:
+    child_t root_;
+
+    size_t size_;
+};
+
+NS_IZENELIB_AM_END
+
+#endif
@@ -8,6 +8,8 @@
 
 #include <boost/shared_array.hpp>
 
+#include <vector>
+
 NS_IZENELIB_AM_BEGIN
 
 class RoaringChunk;
@@ -30,6 +32,19 @@ public:
     void add(uint32_t x);
     bool contains(uint32_t x) const;
 
+    /// appends sorted values, all of them not less than the last added one
+    void addMany(const uint32_t* begin, const uint32_t* end);
+
+    /// converts chunks to run containers where smaller
+    bool runOptimize();
+
+    void toArray(std::vector<uint32_t>& values) const;
+
+    /// see RoaringBitmapView.h for the format
+    size_t serializedSizeInBytes() const;
+    size_t serialize(char* buf) const;
+    bool deserialize(const char* buf, size_t size);
+
     array_type getArray() const;
 
     self_type operator&(const self_type& b) const;
@@ -37,6 +52,11 @@ public:
     self_type operator^(const self_type& b) const;
     self_type operator-(const self_type& b) const;
 
+    /// union of many bitmaps, each chunk key is accumulated in a scratch bitmap
+    static self_type fastOr(const std::vector<const self_type*>& bitmaps);
+    /// intersection of many bitmaps, starting from the smallest ones
+    static self_type fastAnd(const std::vector<const self_type*>& bitmaps);
+
     void swap(self_type& b);
 
     size_t getCardinality() const
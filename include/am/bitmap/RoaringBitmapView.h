@@ -0,0 +1,239 @@
+#ifndef IZENELIB_AM_BITMAP_ROARING_BITMAP_VIEW_H
+#define IZENELIB_AM_BITMAP_ROARING_BITMAP_VIEW_H
+
+#include "consts.h"
+#include "RoaringChunk.h"
+
+#include <vector>
+#include <algorithm>
+#include <string.h>
+
+NS_IZENELIB_AM_BEGIN
+
+/**
+ * Serialized RoaringBitmap, in the native byte order of the host, which
+ * must be little endian: an image of a big endian host has a byte swapped
+ * cookie and is rejected.
+ *
+ *   [uint32 cookie][uint32 chunk number][uint64 cardinality]
+ *   [RoaringSerialHeader] * chunk number
+ *   payloads, each at an 8 bytes aligned offset:
+ *     ARRAY:  sorted uint16 values
+ *     BITMAP: 1024 uint64 words
+ *     RUN:    (start, length - 1) uint16 pairs
+ *     FULL:   nothing
+ */
+struct RoaringSerialHeader
+{
+    uint16_t key;
+    uint16_t type;
+    uint32_t cardinality;
+    uint32_t offset;
+    uint32_t size;
+};
+
+static const uint32_t ROARING_SERIAL_COOKIE = 0x52424d31;
+static const uint32_t ROARING_SERIAL_PREFIX = 16;
+
+/**
+ * Read only access to a serialized bitmap in place, e.g. in a mmapped file.
+ * The buffer must outlive the view and be 8 bytes aligned.
+ */
+class RoaringBitmapView
+{
+public:
+    RoaringBitmapView()
+        : data_(NULL)
+        , headers_(NULL)
+        , chunkNum_(0)
+        , cardinality_(0)
+    {
+    }
+
+    /**
+     * @return false if the buffer is not a whole image: a wrong cookie, or a
+     * header inconsistent with its payload, so that neither the view nor
+     * RoaringChunk::deserialize() could read outside the buffer
+     */
+    bool init(const char* data, size_t size)
+    {
+        data_ = NULL;
+        if (size < ROARING_SERIAL_PREFIX) return false;
+
+        uint32_t cookie, chunkNum;
+        uint64_t cardinality;
+        memcpy(&cookie, data, sizeof(cookie));
+        memcpy(&chunkNum, data + 4, sizeof(chunkNum));
+        memcpy(&cardinality, data + 8, sizeof(cardinality));
+        if (cookie != ROARING_SERIAL_COOKIE
+                || size < ROARING_SERIAL_PREFIX + (size_t)chunkNum * sizeof(RoaringSerialHeader))
+            return false;
+
+        const RoaringSerialHeader* headers = reinterpret_cast<const RoaringSerialHeader*>(data + ROARING_SERIAL_PREFIX);
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < chunkNum; ++i)
+        {
+            const RoaringSerialHeader& header = headers[i];
+            if (i > 0 && header.key <= headers[i - 1].key) return false;
+            if (header.offset % 8 != 0 || (size_t)header.offset + header.size > size) return false;
+            if (!validChunk(header, data + header.offset)) return false;
+            sum += header.cardinality;
+        }
+        if (sum != cardinality) return false;
+
+        data_ = data;
+        headers_ = headers;
+        chunkNum_ = chunkNum;
+        cardinality_ = cardinality;
+        return true;
+    }
+
+    size_t getCardinality() const
+    {
+        return cardinality_;
+    }
+
+    uint32_t getChunkNum() const
+    {
+        return chunkNum_;
+    }
+
+    const RoaringSerialHeader& getHeader(uint32_t i) const
+    {
+        return headers_[i];
+    }
+
+    const char* getPayload(uint32_t i) const
+    {
+        return data_ + headers_[i].offset;
+    }
+
+    bool contains(uint32_t x) const
+    {
+        uint32_t hb = x >> 16;
+        uint16_t lb = x & 0xffff;
+
+        uint32_t begin = 0, end = chunkNum_;
+        while (begin < end)
+        {
+            uint32_t middle = (begin + end) / 2;
+            if (headers_[middle].key < hb) begin = middle + 1;
+            else end = middle;
+        }
+        if (begin == chunkNum_ || headers_[begin].key != hb) return false;
+
+        const RoaringSerialHeader& header = headers_[begin];
+        switch (header.type)
+        {
+        case RoaringChunk::FULL:
+            return true;
+
+        case RoaringChunk::ARRAY:
+        {
+            const uint16_t* data = reinterpret_cast<const uint16_t*>(getPayload(begin));
+            const uint16_t* pos = std::lower_bound(data, data + header.cardinality, lb);
+            return pos != data + header.cardinality && *pos == lb;
+        }
+
+        case RoaringChunk::BITMAP:
+        {
+            const uint64_t* data = reinterpret_cast<const uint64_t*>(getPayload(begin));
+            return data[lb / 64] & (1ULL << (lb % 64));
+        }
+
+        case RoaringChunk::RUN:
+        {
+            const uint16_t* runs = reinterpret_cast<const uint16_t*>(getPayload(begin));
+            uint32_t low = 0, high = header.size / 4;
+            while (low < high)
+            {
+                uint32_t middle = (low + high) / 2;
+                if (runs[2 * middle] <= lb) low = middle + 1;
+                else high = middle;
+            }
+            return low > 0 && lb <= (uint32_t)runs[2 * low - 2] + runs[2 * low - 1];
+        }
+
+        default:
+            return false;
+        }
+    }
+
+    void toArray(std::vector<uint32_t>& values) const
+    {
+        for (uint32_t i = 0; i < chunkNum_; ++i)
+        {
+            const RoaringSerialHeader& header = headers_[i];
+            uint32_t high = (uint32_t)header.key << 16;
+
+            if (header.type == RoaringChunk::FULL)
+            {
+                for (uint32_t j = 0; j < MAX_CHUNK_CAPACITY; ++j)
+                    values.push_back(high | j);
+            }
+            else if (header.type == RoaringChunk::ARRAY)
+            {
+                const uint16_t* data = reinterpret_cast<const uint16_t*>(getPayload(i));
+                for (uint32_t j = 0; j < header.cardinality; ++j)
+                    values.push_back(high | data[j]);
+            }
+            else if (header.type == RoaringChunk::BITMAP)
+            {
+                const uint64_t* data = reinterpret_cast<const uint64_t*>(getPayload(i));
+                for (uint32_t j = 0; j < BITMAP_SIZE; ++j)
+                {
+                    uint64_t block = data[j];
+                    while (block)
+                    {
+                        values.push_back(high | (j * 64 + __builtin_ctzll(block)));
+                        block &= block - 1;
+                    }
+                }
+            }
+            else if (header.type == RoaringChunk::RUN)
+            {
+                const uint16_t* runs = reinterpret_cast<const uint16_t*>(getPayload(i));
+                for (uint32_t j = 0; j < header.size / 4; ++j)
+                {
+                    for (uint32_t val = runs[2 * j]; val <= (uint32_t)runs[2 * j] + runs[2 * j + 1]; ++val)
+                        values.push_back(high | val);
+                }
+            }
+        }
+    }
+
+private:
+    /// the payload is inside the buffer
+    static bool validChunk(const RoaringSerialHeader& header, const char* payload)
+    {
+        switch (header.type)
+        {
+        case RoaringChunk::ARRAY:
+            return header.cardinality <= MAX_ARRAY_SIZE && header.size == 2 * header.cardinality;
+
+        case RoaringChunk::BITMAP:
+            return header.cardinality <= MAX_CHUNK_CAPACITY && header.size == MAX_CHUNK_CAPACITY / 8;
+
+        case RoaringChunk::RUN:
+            return header.cardinality <= MAX_CHUNK_CAPACITY && header.size % 4 == 0
+                && header.size / 4 <= MAX_CHUNK_CAPACITY / 2
+                && RoaringChunk::validRuns(reinterpret_cast<const uint16_t*>(payload), header.size / 4, header.cardinality);
+
+        case RoaringChunk::FULL:
+            return header.cardinality == MAX_CHUNK_CAPACITY && header.size == 0;
+
+        default:
+            return false;
+        }
+    }
+
+private:
+    const char* data_;
+    const RoaringSerialHeader* headers_;
+    uint32_t chunkNum_;
+    uint64_t cardinality_;
+};
+
+NS_IZENELIB_AM_END
+
+#endif
@@ -9,6 +9,8 @@
 #include <boost/shared_array.hpp>
 #include <boost/atomic.hpp>
 
+#include <vector>
+
 NS_IZENELIB_AM_BEGIN
 
 class RoaringChunk
@@ -23,6 +25,7 @@ public:
         BITMAP,
         EMPTY,
         FULL,
+        RUN,
         TYPE_END
     };
 
@@ -35,10 +38,31 @@ public:
     bool operator==(const self_type& b) const;
 
     void init(uint32_t key, uint32_t value);
+    void init(uint32_t key, const uint32_t* begin, const uint32_t* end);
     void trim();
     void add(uint32_t x);
     bool contains(uint32_t x) const;
 
+    /// converts to a run container when it is the smallest representation
+    bool runOptimize();
+
+    /// appends the values, with the key in the high 16 bits
+    void toArray(std::vector<uint32_t>& values) const;
+
+    uint32_t getType() const;
+    uint32_t serializedSizeInBytes() const;
+    uint32_t serialize(char* buf) const;
+    /// @return false if a run payload is not a valid chunk of @p cardinality
+    bool deserialize(uint32_t key, uint32_t type, uint32_t cardinality, const char* buf, uint32_t size);
+
+    /// checks that the runs are sorted, disjoint, inside the chunk and hold @p cardinality values
+    static bool validRuns(const uint16_t* runs, uint32_t num, uint32_t cardinality);
+
+    /// ors the values into a scratch bitmap of BITMAP_SIZE words, without counting them
+    void lazyOr(uint64_t* words) const;
+    /// builds the chunk from a scratch bitmap, counting its cardinality once
+    void initBitmap(uint32_t key, const uint64_t* words);
+
     void resetChunk(Type type, uint32_t capacity);
     void cloneChunk(const data_type& chunk);
     void atomicCopy(const self_type& b);
@@ -62,6 +86,8 @@ public:
     }
 
 private:
+    static data_type expandRun(const data_type& a);
+
     void not_Bitmap(const data_type& a);
     void not_Array(const data_type& a);
 
@@ -82,6 +108,9 @@ private:
     void andNot_ArrayBitmap(const data_type& a, const data_type& b);
     void andNot_ArrayArray(const data_type& a, const data_type& b);
 
+    void and_RunRun(const data_type& a, const data_type& b);
+    void or_RunRun(const data_type& a, const data_type& b);
+
     friend class boost::serialization::access;
     template<class Archive>
     void save(Archive & ar, const unsigned int version) const
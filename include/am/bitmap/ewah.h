@@ -1799,6 +1799,173 @@ size_t EWAHBoolArray<uword>::sizeOnDisk() const {
     return sizeof(sizeinbits) + sizeof(size_t) + sizeof(uword) * buffer.size();
 }
 
+/**
+ * Walks the uncompressed words of a compressed bitmap, many words at
+ * a time. This is used by horizontalOr.
+ */
+template<class uword>
+class EWAHBoolArrayWordCursor {
+public:
+    EWAHBoolArrayWordCursor(const EWAHBoolArray<uword> & p) :
+        buffer(&p.getBuffer()), pointer(0), rl(0), lw(0), b(false),
+                literals(NULL) {
+        readNewRunningLengthWord();
+    }
+
+    bool hasNext() const {
+        return rl + lw > 0;
+    }
+
+    /**
+     * how many words of zeroes follow, an exhausted bitmap only has
+     * zeroes left.
+     */
+    size_t zeroRun() const {
+        if (!hasNext())
+            return static_cast<size_t>(-1);
+        return b ? 0 : rl;
+    }
+
+    /**
+     * skip the next n words.
+     */
+    void discardFirstWords(size_t n) {
+        while (n > 0 && hasNext()) {
+            if (rl > 0) {
+                const size_t k = std::min(rl, n);
+                rl -= k;
+                n -= k;
+            } else {
+                const size_t k = std::min(lw, n);
+                literals += k;
+                lw -= k;
+                n -= k;
+            }
+            if (rl + lw == 0)
+                readNewRunningLengthWord();
+        }
+    }
+
+    /**
+     * or the next (at most) n words into out, returns the number of
+     * words consumed.
+     */
+    size_t orNextWords(uword * out, const size_t n) {
+        size_t done = 0;
+        while (done < n && hasNext()) {
+            if (rl > 0) {
+                const size_t k = std::min(rl, n - done);
+                if (b)
+                    std::fill(out + done, out + done + k, notzero);
+                rl -= k;
+                done += k;
+            } else {
+                const size_t k = std::min(lw, n - done);
+                for (size_t j = 0; j < k; ++j)
+                    out[done + j] |= literals[j];
+                literals += k;
+                lw -= k;
+                done += k;
+            }
+            if (rl + lw == 0)
+                readNewRunningLengthWord();
+        }
+        return done;
+    }
+
+    static const uword notzero = static_cast<uword>(~static_cast<uword>(0));
+private:
+    void readNewRunningLengthWord() {
+        while (rl + lw == 0 && pointer < buffer->size()) {
+            ConstRunningLengthWord<uword> rlw((*buffer)[pointer]);
+            rl = static_cast<size_t>(rlw.getRunningLength());
+            lw = static_cast<size_t>(rlw.getNumberOfLiteralWords());
+            b = rlw.getRunningBit();
+            literals = lw > 0 ? &(*buffer)[pointer + 1] : NULL;
+            pointer += lw + 1;
+        }
+    }
+
+    const std::vector<uword> * buffer;
+    size_t pointer;
+    size_t rl, lw;
+    bool b;
+    const uword * literals;
+};
+
+/**
+ * Computes the logical or of many compressed bitmaps at once, the
+ * answer goes into container.
+ *
+ * Unlike folding logicalor pairwise, no intermediate bitmap is built:
+ * the inputs are ored a window of words at a time into a scratch buffer
+ * which is then compressed into the container, and the runs of zeroes
+ * common to all inputs are skipped without touching the buffer.
+ */
+template<class uword>
+void horizontalOr(const std::vector<const EWAHBoolArray<uword> *> & bitmaps,
+        EWAHBoolArray<uword> & container, const size_t windowsize = 1024) {
+    typedef EWAHBoolArrayWordCursor<uword> cursor_type;
+    container.reset();
+
+    size_t sizeinbits = 0;
+    std::vector<cursor_type> cursors;
+    cursors.reserve(bitmaps.size());
+    for (size_t k = 0; k < bitmaps.size(); ++k) {
+        sizeinbits = std::max(sizeinbits, bitmaps[k]->sizeInBits());
+        cursors.push_back(cursor_type(*bitmaps[k]));
+    }
+
+    std::vector<uword> window(windowsize);
+    while (true) {
+        for (size_t k = 0; k < cursors.size();) {
+            if (cursors[k].hasNext()) {
+                ++k;
+            } else {
+                cursors[k] = cursors.back();
+                cursors.pop_back();
+            }
+        }
+        if (cursors.empty())
+            break;
+
+        size_t zeroes = cursors[0].zeroRun();
+        for (size_t k = 1; k < cursors.size() && zeroes > 0; ++k)
+            zeroes = std::min(zeroes, cursors[k].zeroRun());
+        if (zeroes > 0) {
+            container.addStreamOfEmptyWords(false, zeroes);
+            for (size_t k = 0; k < cursors.size(); ++k)
+                cursors[k].discardFirstWords(zeroes);
+            continue;
+        }
+
+        std::fill(window.begin(), window.end(), static_cast<uword>(0));
+        size_t length = 0;
+        for (size_t k = 0; k < cursors.size(); ++k)
+            length = std::max(length, cursors[k].orNextWords(&window[0], windowsize));
+
+        for (size_t i = 0; i < length;) {
+            const uword w = window[i];
+            size_t j = i + 1;
+            if (w == 0 || w == cursor_type::notzero) {
+                while (j < length && window[j] == w)
+                    ++j;
+                container.addStreamOfEmptyWords(w != 0, j - i);
+            } else {
+                while (j < length && window[j] != 0 && window[j] != cursor_type::notzero)
+                    ++j;
+                container.addStreamOfDirtyWords(&window[i], j - i);
+            }
+            i = j;
+        }
+    }
+
+    if (container.sizeInBits() < sizeinbits)
+        container.padWithZeroes(sizeinbits);
+    else
+        container.setSizeInBits(sizeinbits);
+}
+
 NS_IZENELIB_AM_END
 
 MAKE_FEBIRD_SERIALIZATION(izenelib::am::EWAHBoolArray<uint16_t>)
@@ -0,0 +1,108 @@
+#ifndef AM_CONCEPT_WRITEBATCH_H
+#define AM_CONCEPT_WRITEBATCH_H
+/**
+ * @file am/concept/WriteBatch.h
+ * @brief A list of insert/update/del operations applied by an access method
+ * in one call, so that the backend can use its native batch mechanism (a
+ * leveldb WriteBatch, a single LMDB write transaction, ...) instead of paying
+ * the per-operation commit cost.
+ */
+
+#include <types.h>
+
+#include <vector>
+
+NS_IZENELIB_AM_BEGIN
+
+enum BatchOpType
+{
+    BATCH_INSERT,
+    BATCH_UPDATE,
+    BATCH_DEL
+};
+
+template<typename KeyType, typename ValueType>
+struct BatchOp
+{
+    BatchOpType type;
+    KeyType key;
+    ValueType value;
+
+    BatchOp()
+        : type(BATCH_UPDATE)
+    {
+    }
+
+    BatchOp(BatchOpType t, const KeyType& k, const ValueType& v = ValueType())
+        : type(t), key(k), value(v)
+    {
+    }
+};
+
+/**
+ * @brief Operations are applied in the order they were added.
+ */
+template<typename KeyType, typename ValueType>
+class WriteBatch
+{
+public:
+    typedef BatchOp<KeyType, ValueType> op_type;
+    typedef typename std::vector<op_type>::const_iterator const_iterator;
+
+    void insert(const KeyType& key, const ValueType& value)
+    {
+        ops_.push_back(op_type(BATCH_INSERT, key, value));
+    }
+
+    void update(const KeyType& key, const ValueType& value)
+    {
+        ops_.push_back(op_type(BATCH_UPDATE, key, value));
+    }
+
+    void del(const KeyType& key)
+    {
+        ops_.push_back(op_type(BATCH_DEL, key));
+    }
+
+    void clear()
+    {
+        ops_.clear();
+    }
+
+    void reserve(std::size_t n)
+    {
+        ops_.reserve(n);
+    }
+
+    std::size_t size() const
+    {
+        return ops_.size();
+    }
+
+    bool empty() const
+    {
+        return ops_.empty();
+    }
+
+    const op_type& operator[](std::size_t i) const
+    {
+        return ops_[i];
+    }
+
+    const_iterator begin() const
+    {
+        return ops_.begin();
+    }
+
+    const_iterator end() const
+    {
+        return ops_.end();
+    }
+
+private:
+    std::vector<op_type> ops_;
+};
+
+NS_IZENELIB_AM_END
+
+#endif // AM_CONCEPT_WRITEBATCH_H
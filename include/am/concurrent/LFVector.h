@@ -2,22 +2,34 @@
 * @file        LFVector.h
 * @version     SF1 v5.0
 * @brief Lock free concurrent vector
+*
+* The vector of "Lock-free Dynamic and Resizable Arrays" (Dechev et al.):
+* the elements are in buckets of doubling sizes, never moved, and the size
+* with the pending write of the last push_back are in a descriptor, replaced
+* by a compare and swap. The replaced descriptors are retired to the
+* EpochManager, as other threads may still read them.
 */
 
 #ifndef LFVECTOR_H
 #define LFVECTOR_H
 
-#include<stddef.h>
+#include "epoch.hpp"
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <stdexcept>
+#include <stddef.h>
+
 namespace izenelib{ namespace am { namespace concurrent {
 
     template<class T>
-    class LFVector{
+    class LFVector : private boost::noncopyable{
         public:
             static size_t const INITIAL_CAPACITY = 32;
             static size_t const INITIAL_SIZE = 8;
             LFVector();
-            LFVector(size_t);
-            LFVector(const LFVector&);
+            explicit LFVector(size_t);
             ~LFVector();
             void push_back(const T&);
             void pop_back();
@@ -25,54 +37,27 @@ namespace izenelib{ namespace am { namespace concurrent {
             size_t size()const;
             const T& at(size_t n)const;
             T& at(size_t n);
-            LFVector<T>& operator=(const LFVector<T>& x);
 
         private:
             class WriteDescriptor{
                 public:
-                    WriteDescriptor(){
-                        completed = true;
-                    }
-                    WriteDescriptor(const T& oldv, const T& newv, size_t loc)
-                        :old_value(oldv), new_value(newv), location(loc), completed(false){
-                    }
-                    ~WriteDescriptor(){
-                    }
+                    enum { PENDING, WRITING, COMPLETED };
 
-                    friend bool operator==(const WriteDescriptor& lhs, const WriteDescriptor& rhs){
-                        return (lhs.old_value == rhs.old_value && lhs.new_value == rhs.new_value
-                            && lhs.location == rhs.location && lhs.completed == rhs.completed);
+                    WriteDescriptor():state(COMPLETED){
                     }
-
-                    friend bool operator!=(const WriteDescriptor& lhs, const WriteDescriptor& rhs){
-                        return !(lhs == rhs);
+                    WriteDescriptor(const T& newv, size_t loc)
+                        :new_value(newv), location(loc), state(PENDING){
                     }
 
-                    T old_value;
                     T new_value;
                     size_t location;
-                    bool completed;
+                    boost::atomic<int> state;
             };
             class Descriptor{
                 public:
-                    Descriptor(size_t s, WriteDescriptor& wd):size(s), wdesc(wd){
+                    Descriptor(size_t s):size(s){
                     }
-
-                    ~Descriptor(){
-                    }
-
-                    Descriptor& operator=(const Descriptor& desc){
-                        size = desc.size;
-                        wdesc = desc.wdesc;
-                        return *this;
-                    }
-
-                    friend bool operator==(const Descriptor& lhs, const Descriptor& rhs){
-                        return (lhs.size == rhs.size && lhs.wdesc == rhs.wdesc);
-                    }
-
-                    friend bool operator!=(const Descriptor& lhs, const Descriptor& rhs){
-                        return !(lhs == rhs);
+                    Descriptor(size_t s, const T& newv, size_t loc):size(s), wdesc(newv, loc){
                     }
 
                     size_t size;
@@ -82,12 +67,140 @@ namespace izenelib{ namespace am { namespace concurrent {
         private:
             void complete_write(WriteDescriptor& wd);
             void alloc_bucket(size_t bucket);
-            size_t highest_bit(size_t n);
-            T at_nocheck(size_t n);
+            static size_t highest_bit(size_t n);
+            T& at_nocheck(size_t n)const;
 
         private:
-            Descriptor* desc;
-            T** data;
+            boost::atomic<Descriptor*> desc;
+            boost::atomic<T*> data[INITIAL_CAPACITY];
     };
+
+    template<class T>
+    LFVector<T>::LFVector():desc(new Descriptor(0)) {
+        for(size_t i = 0; i < INITIAL_CAPACITY; ++i)
+            data[i].store(NULL, boost::memory_order_relaxed);
+        data[0].store(new T[INITIAL_SIZE], boost::memory_order_relaxed);
+    }
+
+    template<class T>
+    LFVector<T>::LFVector(size_t s):desc(new Descriptor(s)) {
+        for(size_t i = 0; i < INITIAL_CAPACITY; ++i)
+            data[i].store(NULL, boost::memory_order_relaxed);
+        data[0].store(new T[INITIAL_SIZE], boost::memory_order_relaxed);
+        if(s > 0){
+            size_t last = highest_bit(s - 1 + INITIAL_SIZE) - highest_bit(INITIAL_SIZE);
+            for(size_t b = 1; b <= last; ++b)
+                alloc_bucket(b);
+        }
+    }
+
+    template<class T>
+    LFVector<T>::~LFVector(){
+        delete desc.load(boost::memory_order_acquire);
+        for(size_t i = 0; i < INITIAL_CAPACITY; ++i)
+            delete[] data[i].load(boost::memory_order_acquire);
+    }
+
+    template<class T>
+    void LFVector<T>::push_back(const T& elem){
+        EpochGuard epoch;
+        size_t ini_bit = highest_bit(INITIAL_SIZE);
+        Descriptor* current = desc.load(boost::memory_order_acquire);
+        Descriptor* next = NULL;
+        do{
+            complete_write(current -> wdesc);
+            size_t bucket = highest_bit(current -> size + INITIAL_SIZE) - ini_bit;
+            if(bucket >= INITIAL_CAPACITY)
+                throw std::length_error("vector full.");
+            if(data[bucket].load(boost::memory_order_acquire) == NULL)
+                alloc_bucket(bucket);
+
+            delete next;
+            next = new Descriptor(current -> size + 1, elem, current -> size);
+        }while(!desc.compare_exchange_weak(current, next, boost::memory_order_acq_rel));
+        complete_write(next -> wdesc);
+        EpochManager::instance().retire(current);
+    }
+
+    template<class T>
+    void LFVector<T>::pop_back(){
+        EpochGuard epoch;
+        Descriptor* current = desc.load(boost::memory_order_acquire);
+        Descriptor* next = NULL;
+        do{
+            complete_write(current -> wdesc);
+            if(current -> size == 0){
+                delete next;
+                return;
+            }
+            if(next == NULL)
+                next = new Descriptor(0);
+            next -> size = current -> size - 1;
+        }while(!desc.compare_exchange_weak(current, next, boost::memory_order_acq_rel));
+        EpochManager::instance().retire(current);
+    }
+
+    template<class T>
+    bool LFVector<T>::empty() const{
+        return size() == 0;
+    }
+
+    template<class T>
+    size_t LFVector<T>::size() const{
+        EpochGuard epoch;
+        return desc.load(boost::memory_order_acquire) -> size;
+    }
+
+    template<class T>
+    T& LFVector<T>::at(size_t n){
+        if(n >= size())
+            throw std::out_of_range("out of vector range.");
+        return at_nocheck(n);
+    }
+
+    template<class T>
+    const T& LFVector<T>::at(size_t n)const{
+        if(n >= size())
+            throw std::out_of_range("out of vector range.");
+        return at_nocheck(n);
+    }
+
+
+    //Follows are the private methods
+    template<class T>
+    void LFVector<T>::complete_write(WriteDescriptor& wd){
+        int state = WriteDescriptor::PENDING;
+        if(wd.state.compare_exchange_strong(state, WriteDescriptor::WRITING, boost::memory_order_acquire)){
+            at_nocheck(wd.location) = wd.new_value;
+            wd.state.store(WriteDescriptor::COMPLETED, boost::memory_order_release);
+            return;
+        }
+        // another thread is writing the element, the next push_back or
+        // pop_back should not begin before the element is written
+        while(state != WriteDescriptor::COMPLETED)
+            state = wd.state.load(boost::memory_order_acquire);
+    }
+
+    template<class T>
+    void LFVector<T>::alloc_bucket(size_t bucket){
+        size_t bucket_size = INITIAL_SIZE << bucket;
+        T* mem = new T[bucket_size];
+        T* expected = NULL;
+        if(!data[bucket].compare_exchange_strong(expected, mem, boost::memory_order_acq_rel))
+            delete[] mem;
+    }
+
+    template<class T>
+    size_t LFVector<T>::highest_bit(size_t n){
+        return sizeof(unsigned long) * 8 - 1 - __builtin_clzl(n);
+    }
+
+    template<class T>
+    T& LFVector<T>::at_nocheck(size_t n)const{
+        size_t pos = n + INITIAL_SIZE;
+        size_t hi_bit = highest_bit(pos);
+        size_t idx = pos ^ ((size_t)1 << hi_bit);
+        return data[hi_bit - highest_bit(INITIAL_SIZE)].load(boost::memory_order_acquire)[idx];
+    }
 }}}
 #endif
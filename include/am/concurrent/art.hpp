@@ -0,0 +1,963 @@
+/**
+ * @file art.hpp
+ * @brief An adaptive radix tree (ART) of byte string keys, with optimistic
+ * lock coupling for concurrent inserts and lock free reads.
+ *
+ * The nodes are the ones of "The Adaptive Radix Tree: ARTful Indexing for
+ * Main-Memory Databases" (Leis et al.), Node4, Node16, Node48 and Node256,
+ * with path compression (up to 8 bytes of the prefix kept in the node, the
+ * rest read from a leaf below) and lazy expansion (a leaf keeps its whole
+ * key). The synchronization is the one of "The ART of Practical
+ * Synchronization" (Leis et al.): each node has a version, a writer locks
+ * only the nodes it changes, by a compare and swap of their versions, and a
+ * reader never writes, but checks the versions of the nodes it read have not
+ * changed, and restarts if they did.
+ *
+ * A key may be a prefix of another, the key ending at a node being kept in
+ * an extra slot of the node. The values are copied while they may be
+ * written, and checked afterwards, so ValueType should be trivially copyable
+ * (an id, a count, a pointer).
+ *
+ * The nodes replaced by bigger ones are kept until the tree is destroyed, as
+ * readers may still be in them; keys are not removed.
+ */
+#ifndef IZENELIB_AM_CONCURRENT_ART_HPP
+#define IZENELIB_AM_CONCURRENT_ART_HPP
+
+#include <types.h>
+
+#include <boost/atomic.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include <new>
+
+namespace izenelib{ namespace am { namespace concurrent {
+
+template <typename ValueType>
+class ART
+{
+    typedef uintptr_t child_t; ///< a node, or a leaf with the lowest bit set
+
+    enum NodeType { NODE4, NODE16, NODE48, NODE256 };
+
+    static const size_t MAX_PREFIX_LENGTH = 8;
+
+    struct Leaf
+    {
+        ValueType value;
+        uint32_t length;
+        char key[1];
+    };
+
+    struct Node
+    {
+        /// the lowest bit for obsolete, the next for locked, the rest counted
+        boost::atomic<uint64_t> version;
+        uint8_t type;
+        boost::atomic<uint16_t> count;
+        boost::atomic<uint32_t> prefixLength;
+        boost::atomic<uint64_t> prefix; ///< the first bytes of the prefix, from the lowest
+        boost::atomic<child_t> end; ///< the leaf of the key ending at the node
+
+        explicit Node(uint8_t t)
+            : version(0), type(t), count(0), prefixLength(0), prefix(0), end(0)
+        {
+        }
+    };
+
+    template <uint8_t TYPE, size_t CAPACITY>
+    struct SortedNode : public Node
+    {
+        boost::atomic<uint8_t> keys[CAPACITY];
+        boost::atomic<child_t> children[CAPACITY];
+
+        SortedNode() : Node(TYPE)
+        {
+            for (size_t i = 0; i < CAPACITY; ++i)
+            {
+                keys[i].store(0, boost::memory_order_relaxed);
+                children[i].store(0, boost::memory_order_relaxed);
+            }
+        }
+    };
+
+    typedef SortedNode<NODE4, 4> Node4;
+    typedef SortedNode<NODE16, 16> Node16;
+
+    struct Node48 : public Node
+    {
+        boost::atomic<uint8_t> index[256]; ///< the slot of each byte in children, from 1
+        boost::atomic<child_t> children[48];
+
+        Node48() : Node(NODE48)
+        {
+            for (size_t i = 0; i < 256; ++i)
+                index[i].store(0, boost::memory_order_relaxed);
+            for (size_t i = 0; i < 48; ++i)
+                children[i].store(0, boost::memory_order_relaxed);
+        }
+    };
+
+    struct Node256 : public Node
+    {
+        boost::atomic<child_t> children[256];
+
+        Node256() : Node(NODE256)
+        {
+            for (size_t i = 0; i < 256; ++i)
+                children[i].store(0, boost::memory_order_relaxed);
+        }
+    };
+
+    /// a child of a node read by a scan, with the value if a leaf
+    struct Entry
+    {
+        child_t child;
+        ValueType value;
+    };
+
+    struct KeepValue
+    {
+        void operator()(ValueType&) const {}
+    };
+
+    struct AssignValue
+    {
+        explicit AssignValue(const ValueType& v) : value(v) {}
+        void operator()(ValueType& v) const { v = value; }
+        const ValueType& value;
+    };
+
+public:
+    typedef std::string key_type;
+    typedef ValueType value_type;
+
+    ART()
+        : root_(new Node256), size_(0)
+    {
+    }
+
+    ~ART()
+    {
+        destroy_(reinterpret_cast<child_t>(root_));
+        for (size_t i = 0; i < retired_.size(); ++i)
+            deleteNode_(retired_[i]);
+    }
+
+    /**
+     * @brief inserts @p key if it is not in the tree
+     * @return false if @p key is in the tree already
+     */
+    bool insert(const char* key, size_t len, const ValueType& value)
+    {
+        return insert_(key, len, value, KeepValue());
+    }
+
+    bool insert(const key_type& key, const ValueType& value)
+    {
+        return insert(key.data(), key.size(), value);
+    }
+
+    /**
+     * @brief inserts @p key, or sets its value if it is in the tree
+     * @return true if @p key is inserted
+     */
+    bool set(const char* key, size_t len, const ValueType& value)
+    {
+        return insert_(key, len, value, AssignValue(value));
+    }
+
+    bool set(const key_type& key, const ValueType& value)
+    {
+        return set(key.data(), key.size(), value);
+    }
+
+    /**
+     * @brief inserts @p key with @p init, or calls @p update on its value if
+     * it is in the tree; the value is locked while being updated, and
+     * @p update should only change it
+     * @return true if @p key is inserted
+     */
+    template <class UpdateFunc>
+    bool update(const char* key, size_t len, const ValueType& init, UpdateFunc update)
+    {
+        return insert_(key, len, init, update);
+    }
+
+    template <class UpdateFunc>
+    bool update(const key_type& key, const ValueType& init, UpdateFunc update)
+    {
+        return insert_(key.data(), key.size(), init, update);
+    }
+
+    bool get(const char* key, size_t len, ValueType& value) const
+    {
+        for (;;)
+        {
+            bool found = false;
+            if (get_(key, len, value, found)) return found;
+        }
+    }
+
+    bool get(const key_type& key, ValueType& value) const
+    {
+        return get(key.data(), key.size(), value);
+    }
+
+    bool contains(const key_type& key) const
+    {
+        ValueType value;
+        return get(key, value);
+    }
+
+    /**
+     * @brief calls visitor(key, len, value) on each key beginning with
+     * @p prefix, in the order of the keys, until it returns false.
+     *
+     * No lock is taken: each node is read as it is at some time during the
+     * scan, so the keys inserted while scanning may or may not be visited.
+     */
+    template <class Visitor>
+    void scanPrefix(const char* prefix, size_t len, Visitor& visitor) const
+    {
+        for (;;)
+        {
+            if (scanPrefix_(prefix, len, visitor)) return;
+        }
+    }
+
+    template <class Visitor>
+    void scanPrefix(const key_type& prefix, Visitor& visitor) const
+    {
+        scanPrefix(prefix.data(), prefix.size(), visitor);
+    }
+
+    /// visits all the keys, as scanPrefix() does
+    template <class Visitor>
+    void scan(Visitor& visitor) const
+    {
+        scanPrefix("", 0, visitor);
+    }
+
+    size_t size() const
+    {
+        return size_.load(boost::memory_order_relaxed);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+private:
+    ART(const ART&);
+    ART& operator=(const ART&);
+
+    static bool isLeaf_(child_t c)
+    {
+        return c & 1;
+    }
+
+    static Leaf* asLeaf_(child_t c)
+    {
+        return reinterpret_cast<Leaf*>(c & ~(child_t)1);
+    }
+
+    static Node* asNode_(child_t c)
+    {
+        return reinterpret_cast<Node*>(c);
+    }
+
+    static child_t leafChild_(Leaf* leaf)
+    {
+        return reinterpret_cast<child_t>(leaf) | 1;
+    }
+
+    static child_t nodeChild_(Node* node)
+    {
+        return reinterpret_cast<child_t>(node);
+    }
+
+    static Leaf* newLeaf_(const char* key, size_t len, const ValueType& value)
+    {
+        Leaf* leaf = static_cast<Leaf*>(::operator new(sizeof(Leaf) + len));
+        new (&leaf->value) ValueType(value);
+        leaf->length = len;
+        if (len) std::memcpy(leaf->key, key, len);
+        return leaf;
+    }
+
+    static void deleteLeaf_(Leaf* leaf)
+    {
+        leaf->value.~ValueType();
+        ::operator delete(leaf);
+    }
+
+    static bool leafMatches_(const Leaf* leaf, const char* key, size_t len)
+    {
+        return leaf->length == len && std::memcmp(leaf->key, key, len) == 0;
+    }
+
+    static bool leafHasPrefix_(const Leaf* leaf, const char* prefix, size_t len)
+    {
+        return leaf->length >= len && std::memcmp(leaf->key, prefix, len) == 0;
+    }
+
+    /// @return false if @p node is locked or obsolete
+    static bool readLock_(const Node* node, uint64_t& version)
+    {
+        version = node->version.load(boost::memory_order_acquire);
+        return (version & 3) == 0;
+    }
+
+    /// @return false if @p node changed since @p version was read
+    static bool validate_(const Node* node, uint64_t version)
+    {
+        boost::atomic_thread_fence(boost::memory_order_acquire);
+        return node->version.load(boost::memory_order_relaxed) == version;
+    }
+
+    static bool upgradeToWriteLock_(Node* node, uint64_t version)
+    {
+        return node->version.compare_exchange_strong(version, version + 2,
+                boost::memory_order_acquire, boost::memory_order_relaxed);
+    }
+
+    static void writeUnlock_(Node* node)
+    {
+        node->version.fetch_add(2, boost::memory_order_release);
+    }
+
+    static void writeUnlockObsolete_(Node* node)
+    {
+        node->version.fetch_add(3, boost::memory_order_release);
+    }
+
+    static void backoff_()
+    {
+        boost::this_thread::yield();
+    }
+
+    static uint8_t prefixByte_(const Node* node, size_t i)
+    {
+        return (uint8_t)(node->prefix.load(boost::memory_order_relaxed) >> (8 * i));
+    }
+
+    static void setPrefix_(Node* node, const uint8_t* prefix, size_t len)
+    {
+        uint64_t packed = 0;
+        for (size_t i = 0; i < len && i < MAX_PREFIX_LENGTH; ++i)
+            packed |= (uint64_t)prefix[i] << (8 * i);
+        node->prefix.store(packed, boost::memory_order_relaxed);
+        node->prefixLength.store(len, boost::memory_order_relaxed);
+    }
+
+    static child_t getChild_(const Node* node, uint8_t b)
+    {
+        switch (node->type)
+        {
+        case NODE4:
+            return findSorted_(static_cast<const Node4*>(node), b);
+        case NODE16:
+            return findSorted_(static_cast<const Node16*>(node), b);
+        case NODE48:
+        {
+            const Node48* n = static_cast<const Node48*>(node);
+            uint8_t slot = n->index[b].load(boost::memory_order_acquire);
+            return slot ? n->children[slot - 1].load(boost::memory_order_acquire) : 0;
+        }
+        default:
+            return static_cast<const Node256*>(node)->children[b].load(boost::memory_order_acquire);
+        }
+    }
+
+    template <class SortedNodeT>
+    static child_t findSorted_(const SortedNodeT* node, uint8_t b)
+    {
+        size_t count = std::min<size_t>(node->count.load(boost::memory_order_acquire),
+                sizeof(node->keys) / sizeof(node->keys[0]));
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (node->keys[i].load(boost::memory_order_relaxed) == b)
+                return node->children[i].load(boost::memory_order_acquire);
+        }
+        return 0;
+    }
+
+    static bool isFull_(const Node* node)
+    {
+        uint16_t count = node->count.load(boost::memory_order_relaxed);
+        switch (node->type)
+        {
+        case NODE4: return count == 4;
+        case NODE16: return count == 16;
+        case NODE48: return count == 48;
+        default: return false;
+        }
+    }
+
+    /// inserts a child of a byte not in @p node, which is locked and not full
+    static void insertChild_(Node* node, uint8_t b, child_t child)
+    {
+        switch (node->type)
+        {
+        case NODE4:
+            insertSorted_(static_cast<Node4*>(node), b, child);
+            break;
+        case NODE16:
+            insertSorted_(static_cast<Node16*>(node), b, child);
+            break;
+        case NODE48:
+        {
+            Node48* n = static_cast<Node48*>(node);
+            uint16_t slot = n->count.load(boost::memory_order_relaxed);
+            n->children[slot].store(child, boost::memory_order_release);
+            n->index[b].store(slot + 1, boost::memory_order_release);
+            n->count.store(slot + 1, boost::memory_order_release);
+            break;
+        }
+        default:
+        {
+            Node256* n = static_cast<Node256*>(node);
+            n->children[b].store(child, boost::memory_order_release);
+            n->count.store(n->count.load(boost::memory_order_relaxed) + 1, boost::memory_order_release);
+            break;
+        }
+        }
+    }
+
+    template <class SortedNodeT>
+    static void insertSorted_(SortedNodeT* node, uint8_t b, child_t child)
+    {
+        size_t count = node->count.load(boost::memory_order_relaxed);
+        size_t pos = 0;
+        while (pos < count && node->keys[pos].load(boost::memory_order_relaxed) < b) ++pos;
+        for (size_t i = count; i > pos; --i)
+        {
+            node->keys[i].store(node->keys[i - 1].load(boost::memory_order_relaxed), boost::memory_order_relaxed);
+            node->children[i].store(node->children[i - 1].load(boost::memory_order_relaxed), boost::memory_order_relaxed);
+        }
+        node->keys[pos].store(b, boost::memory_order_relaxed);
+        node->children[pos].store(child, boost::memory_order_release);
+        node->count.store(count + 1, boost::memory_order_release);
+    }
+
+    /// replaces the child of a byte in @p node, which is locked
+    static void changeChild_(Node* node, uint8_t b, child_t child)
+    {
+        switch (node->type)
+        {
+        case NODE4:
+            changeSorted_(static_cast<Node4*>(node), b, child);
+            break;
+        case NODE16:
+            changeSorted_(static_cast<Node16*>(node), b, child);
+            break;
+        case NODE48:
+        {
+            Node48* n = static_cast<Node48*>(node);
+            n->children[n->index[b].load(boost::memory_order_relaxed) - 1].store(child, boost::memory_order_release);
+            break;
+        }
+        default:
+            static_cast<Node256*>(node)->children[b].store(child, boost::memory_order_release);
+            break;
+        }
+    }
+
+    template <class SortedNodeT>
+    static void changeSorted_(SortedNodeT* node, uint8_t b, child_t child)
+    {
+        size_t count = node->count.load(boost::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (node->keys[i].load(boost::memory_order_relaxed) == b)
+            {
+                node->children[i].store(child, boost::memory_order_release);
+                return;
+            }
+        }
+    }
+
+    /// calls f(byte, child) on the children of @p node, in the order of the bytes
+    template <class Func>
+    static void forEachChild_(const Node* node, Func& f)
+    {
+        switch (node->type)
+        {
+        case NODE4:
+            forEachSorted_(static_cast<const Node4*>(node), f);
+            break;
+        case NODE16:
+            forEachSorted_(static_cast<const Node16*>(node), f);
+            break;
+        case NODE48:
+        {
+            const Node48* n = static_cast<const Node48*>(node);
+            for (size_t b = 0; b < 256; ++b)
+            {
+                uint8_t slot = n->index[b].load(boost::memory_order_acquire);
+                if (!slot) continue;
+                child_t child = n->children[slot - 1].load(boost::memory_order_acquire);
+                if (child) f((uint8_t)b, child);
+            }
+            break;
+        }
+        default:
+        {
+            const Node256* n = static_cast<const Node256*>(node);
+            for (size_t b = 0; b < 256; ++b)
+            {
+                child_t child = n->children[b].load(boost::memory_order_acquire);
+                if (child) f((uint8_t)b, child);
+            }
+            break;
+        }
+        }
+    }
+
+    template <class SortedNodeT, class Func>
+    static void forEachSorted_(const SortedNodeT* node, Func& f)
+    {
+        size_t count = std::min<size_t>(node->count.load(boost::memory_order_acquire),
+                sizeof(node->keys) / sizeof(node->keys[0]));
+        for (size_t i = 0; i < count; ++i)
+        {
+            child_t child = node->children[i].load(boost::memory_order_acquire);
+            if (child) f(node->keys[i].load(boost::memory_order_relaxed), child);
+        }
+    }
+
+    struct ChildInserter
+    {
+        explicit ChildInserter(Node* n) : node(n) {}
+        void operator()(uint8_t b, child_t child) { insertChild_(node, b, child); }
+        Node* node;
+    };
+
+    struct FirstChild
+    {
+        FirstChild() : child(0) {}
+        void operator()(uint8_t, child_t c) { if (!child) child = c; }
+        child_t child;
+    };
+
+    /// a copy of @p node, which is locked, of the next size
+    static Node* grow_(const Node* node)
+    {
+        Node* big;
+        switch (node->type)
+        {
+        case NODE4: big = new Node16; break;
+        case NODE16: big = new Node48; break;
+        default: big = new Node256; break;
+        }
+        big->prefixLength.store(node->prefixLength.load(boost::memory_order_relaxed), boost::memory_order_relaxed);
+        big->prefix.store(node->prefix.load(boost::memory_order_relaxed), boost::memory_order_relaxed);
+        big->end.store(node->end.load(boost::memory_order_relaxed), boost::memory_order_relaxed);
+        ChildInserter inserter(big);
+        forEachChild_(node, inserter);
+        return big;
+    }
+
+    /// a leaf below @p node, all of them having the whole prefix of @p node
+    static const Leaf* minLeaf_(const Node* node)
+    {
+        for (;;)
+        {
+            child_t child = node->end.load(boost::memory_order_acquire);
+            if (!child)
+            {
+                FirstChild first;
+                forEachChild_(node, first);
+                child = first.child;
+            }
+            // an inner node has two children at least, one may be in a move
+            if (!child)
+            {
+                backoff_();
+                continue;
+            }
+            if (isLeaf_(child)) return asLeaf_(child);
+            node = asNode_(child);
+        }
+    }
+
+    /// the ith byte of the prefix of @p node, from a leaf for the ones not kept in it
+    static uint8_t fullPrefixByte_(const Node* node, size_t i, const Leaf* leaf, size_t depth)
+    {
+        return i < MAX_PREFIX_LENGTH ? prefixByte_(node, i) : (uint8_t)leaf->key[depth + i];
+    }
+
+    /// puts @p leaf under @p node, at @p depth after its prefix
+    static void placeLeaf_(Node* node, Leaf* leaf, size_t depth)
+    {
+        if (depth == leaf->length)
+            node->end.store(leafChild_(leaf), boost::memory_order_release);
+        else
+            insertChild_(node, (uint8_t)leaf->key[depth], leafChild_(leaf));
+    }
+
+    template <class UpdateFunc>
+    bool insert_(const char* key, size_t len, const ValueType& value, UpdateFunc update)
+    {
+    restart:
+        Node* parent = NULL;
+        uint64_t parentVersion = 0;
+        uint8_t parentKey = 0;
+        Node* node = root_;
+        size_t depth = 0;
+
+        for (;;)
+        {
+            uint64_t version;
+            if (!readLock_(node, version))
+            {
+                backoff_();
+                goto restart;
+            }
+            // the prefix of the node is not changed by a split above it
+            if (parent && !validate_(parent, parentVersion)) goto restart;
+
+            size_t prefixLength = node->prefixLength.load(boost::memory_order_relaxed);
+            if (prefixLength)
+            {
+                const Leaf* minLeaf = prefixLength > MAX_PREFIX_LENGTH ? minLeaf_(node) : NULL;
+                size_t i = 0;
+                for (; i < prefixLength; ++i)
+                {
+                    if (depth + i == len || fullPrefixByte_(node, i, minLeaf, depth) != (uint8_t)key[depth + i])
+                        break;
+                }
+
+                if (i < prefixLength)
+                {
+                    // split the prefix at the first byte not matched
+                    if (!upgradeToWriteLock_(parent, parentVersion)) goto restart;
+                    if (!upgradeToWriteLock_(node, version))
+                    {
+                        writeUnlock_(parent);
+                        goto restart;
+                    }
+
+                    Node* split = new Node4;
+                    setPrefix_(split, reinterpret_cast<const uint8_t*>(key + depth), i);
+                    insertChild_(split, fullPrefixByte_(node, i, minLeaf, depth), nodeChild_(node));
+                    placeLeaf_(split, newLeaf_(key, len, value), depth + i);
+
+                    uint8_t rest[MAX_PREFIX_LENGTH];
+                    size_t restLength = prefixLength - i - 1;
+                    for (size_t j = 0; j < restLength && j < MAX_PREFIX_LENGTH; ++j)
+                        rest[j] = fullPrefixByte_(node, i + 1 + j, minLeaf, depth);
+                    setPrefix_(node, rest, restLength);
+
+                    changeChild_(parent, parentKey, nodeChild_(split));
+                    writeUnlock_(node);
+                    writeUnlock_(parent);
+                    size_.fetch_add(1, boost::memory_order_relaxed);
+                    return true;
+                }
+                depth += prefixLength;
+            }
+
+            if (depth == len)
+            {
+                if (!upgradeToWriteLock_(node, version)) goto restart;
+                child_t end = node->end.load(boost::memory_order_relaxed);
+                if (end)
+                {
+                    update(asLeaf_(end)->value);
+                    writeUnlock_(node);
+                    return false;
+                }
+                node->end.store(leafChild_(newLeaf_(key, len, value)), boost::memory_order_release);
+                writeUnlock_(node);
+                size_.fetch_add(1, boost::memory_order_relaxed);
+                return true;
+            }
+
+            uint8_t b = key[depth];
+            child_t next = getChild_(node, b);
+            if (!validate_(node, version)) goto restart;
+
+            if (!next)
+            {
+                if (isFull_(node))
+                {
+                    if (!upgradeToWriteLock_(parent, parentVersion)) goto restart;
+                    if (!upgradeToWriteLock_(node, version))
+                    {
+                        writeUnlock_(parent);
+                        goto restart;
+                    }
+                    Node* big = grow_(node);
+                    insertChild_(big, b, leafChild_(newLeaf_(key, len, value)));
+                    changeChild_(parent, parentKey, nodeChild_(big));
+                    writeUnlockObsolete_(node);
+                    retire_(node);
+                    writeUnlock_(parent);
+                }
+                else
+                {
+                    if (!upgradeToWriteLock_(node, version)) goto restart;
+                    insertChild_(node, b, leafChild_(newLeaf_(key, len, value)));
+                    writeUnlock_(node);
+                }
+                size_.fetch_add(1, boost::memory_order_relaxed);
+                return true;
+            }
+
+            if (isLeaf_(next))
+            {
+                if (!upgradeToWriteLock_(node, version)) goto restart;
+                Leaf* leaf = asLeaf_(next);
+                if (leafMatches_(leaf, key, len))
+                {
+                    update(leaf->value);
+                    writeUnlock_(node);
+                    return false;
+                }
+
+                // expand the leaf into a node of the bytes both keys have
+                size_t start = depth + 1;
+                size_t common = 0;
+                while (start + common < len && start + common < leaf->length
+                        && key[start + common] == leaf->key[start + common])
+                    ++common;
+                Node* expanded = new Node4;
+                setPrefix_(expanded, reinterpret_cast<const uint8_t*>(key + start), common);
+                placeLeaf_(expanded, leaf, start + common);
+                placeLeaf_(expanded, newLeaf_(key, len, value), start + common);
+                changeChild_(node, b, nodeChild_(expanded));
+                writeUnlock_(node);
+                size_.fetch_add(1, boost::memory_order_relaxed);
+                return true;
+            }
+
+            parent = node;
+            parentVersion = version;
+            parentKey = b;
+            node = asNode_(next);
+            depth += 1;
+        }
+    }
+
+    /// @return false to restart
+    bool get_(const char* key, size_t len, ValueType& value, bool& found) const
+    {
+        const Node* parent = NULL;
+        uint64_t parentVersion = 0;
+        const Node* node = root_;
+        size_t depth = 0;
+
+        for (;;)
+        {
+            uint64_t version;
+            if (!readLock_(node, version))
+            {
+                backoff_();
+                return false;
+            }
+            if (parent && !validate_(parent, parentVersion)) return false;
+
+            // the prefix is checked with the whole key at the leaf
+            depth += node->prefixLength.load(boost::memory_order_relaxed);
+            if (depth > len)
+            {
+                found = false;
+                return validate_(node, version);
+            }
+
+            child_t child = depth == len ? node->end.load(boost::memory_order_acquire)
+                : getChild_(node, (uint8_t)key[depth]);
+            if (!child)
+            {
+                found = false;
+                return validate_(node, version);
+            }
+            if (isLeaf_(child))
+            {
+                const Leaf* leaf = asLeaf_(child);
+                found = leafMatches_(leaf, key, len);
+                ValueType copy = leaf->value;
+                if (!validate_(node, version)) return false;
+                if (found) value = copy;
+                return true;
+            }
+            if (!validate_(node, version)) return false;
+
+            parent = node;
+            parentVersion = version;
+            node = asNode_(child);
+            depth += 1;
+        }
+    }
+
+    struct EntryCollector
+    {
+        explicit EntryCollector(std::vector<Entry>& e) : entries(e) {}
+
+        void operator()(uint8_t, child_t child)
+        {
+            add(child);
+        }
+
+        void add(child_t child)
+        {
+            Entry entry;
+            entry.child = child;
+            if (isLeaf_(child)) entry.value = asLeaf_(child)->value;
+            entries.push_back(entry);
+        }
+
+        std::vector<Entry>& entries;
+    };
+
+    /// @return false to restart
+    template <class Visitor>
+    bool scanPrefix_(const char* prefix, size_t len, Visitor& visitor) const
+    {
+        const Node* parent = NULL;
+        uint64_t parentVersion = 0;
+        const Node* node = root_;
+        size_t depth = 0;
+
+        for (;;)
+        {
+            uint64_t version;
+            if (!readLock_(node, version))
+            {
+                backoff_();
+                return false;
+            }
+            if (parent && !validate_(parent, parentVersion)) return false;
+
+            size_t prefixLength = node->prefixLength.load(boost::memory_order_relaxed);
+            for (size_t i = 0; i < prefixLength && i < MAX_PREFIX_LENGTH && depth + i < len; ++i)
+            {
+                if (prefixByte_(node, i) != (uint8_t)prefix[depth + i])
+                    return validate_(node, version);
+            }
+            if (depth + prefixLength >= len)
+            {
+                if (!validate_(node, version)) return false;
+                scanNode_(node, prefix, len, visitor);
+                return true;
+            }
+            depth += prefixLength;
+
+            child_t child = getChild_(node, (uint8_t)prefix[depth]);
+            if (!child) return validate_(node, version);
+            if (isLeaf_(child))
+            {
+                const Leaf* leaf = asLeaf_(child);
+                ValueType copy = leaf->value;
+                if (!validate_(node, version)) return false;
+                if (leafHasPrefix_(leaf, prefix, len))
+                    visitor(leaf->key, (size_t)leaf->length, copy);
+                return true;
+            }
+            if (!validate_(node, version)) return false;
+
+            parent = node;
+            parentVersion = version;
+            node = asNode_(child);
+            depth += 1;
+        }
+    }
+
+    /// @return false if the visitor stops
+    template <class Visitor>
+    bool scanNode_(const Node* node, const char* prefix, size_t len, Visitor& visitor) const
+    {
+        // the children as they are at one version; an obsolete node is not
+        // changed any more, and the nodes it points to are still in the tree
+        std::vector<Entry> entries;
+        for (;;)
+        {
+            uint64_t version = node->version.load(boost::memory_order_acquire);
+            if (version & 2)
+            {
+                backoff_();
+                continue;
+            }
+            entries.clear();
+            EntryCollector collector(entries);
+            child_t end = node->end.load(boost::memory_order_acquire);
+            if (end) collector.add(end);
+            forEachChild_(node, collector);
+            if (validate_(node, version)) break;
+        }
+
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            if (isLeaf_(entries[i].child))
+            {
+                const Leaf* leaf = asLeaf_(entries[i].child);
+                if (leafHasPrefix_(leaf, prefix, len)
+                        && !visitor(leaf->key, (size_t)leaf->length, entries[i].value))
+                    return false;
+            }
+            else if (!scanNode_(asNode_(entries[i].child), prefix, len, visitor))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void retire_(Node* node)
+    {
+        boost::mutex::scoped_lock lock(retiredMutex_);
+        retired_.push_back(node);
+    }
+
+    static void deleteNode_(Node* node)
+    {
+        switch (node->type)
+        {
+        case NODE4: delete static_cast<Node4*>(node); break;
+        case NODE16: delete static_cast<Node16*>(node); break;
+        case NODE48: delete static_cast<Node48*>(node); break;
+        default: delete static_cast<Node256*>(node); break;
+        }
+    }
+
+    struct ChildDestroyer
+    {
+        void operator()(uint8_t, child_t child) { destroy_(child); }
+    };
+
+    static void destroy_(child_t child)
+    {
+        if (isLeaf_(child))
+        {
+            deleteLeaf_(asLeaf_(child));
+            return;
+        }
+        Node* node = asNode_(child);
+        child_t end = node->end.load(boost::memory_order_relaxed);
+        if (end) destroy_(end);
+        ChildDestroyer destroyer;
+        forEachChild_(node, destroyer);
+        deleteNode_(node);
+    }
+
+private:
+    /// a Node256 without prefix, never replaced
+    Node* root_;
+
+    boost::atomic<size_t> size_;
+
+    boost::mutex retiredMutex_;
+    std::vector<Node*> retired_;
+};
+
+}}} // namespace izenelib::am::concurrent
+
+#endif
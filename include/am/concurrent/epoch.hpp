@@ -0,0 +1,279 @@
+/**
+ * @file epoch.hpp
+ * @brief Epoch based reclamation of the memory unlinked from the lock free
+ * structures of am/concurrent.
+ *
+ * A reader enters an epoch (EpochGuard) before reading the shared nodes and
+ * leaves it after. A writer having unlinked a node retires it, instead of
+ * deleting it, the node being tagged by the global epoch of the time. The
+ * global epoch is advanced when all the threads in an epoch are in the
+ * current one, so the nodes retired two epochs before the current one can
+ * no longer be reached by any thread and are deleted, by the thread which
+ * retired them, every COLLECT_THRESHOLD retirements.
+ *
+ * Entering and leaving costs a store and a load to the thread record, and
+ * nests, so a structure may enter again what its caller entered. A thread
+ * staying long in an epoch delays the deletion by the other threads, it
+ * never blocks them. The nodes retired by a thread which exits are deleted
+ * by the next collect() of another thread.
+ *
+ * There is a single EpochManager of the process, never destroyed, so the
+ * nodes retired by a structure may be deleted after it was, their deleter
+ * must not refer to the structure.
+ */
+#ifndef IZENELIB_AM_CONCURRENT_EPOCH_HPP
+#define IZENELIB_AM_CONCURRENT_EPOCH_HPP
+
+#include <types.h>
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
+
+#include <vector>
+
+namespace izenelib{ namespace am { namespace concurrent {
+
+class EpochManager : private boost::noncopyable
+{
+public:
+    typedef void (*Deleter)(void*);
+
+    /// retirements of a thread between two collections
+    enum { COLLECT_THRESHOLD = 64 };
+
+    static EpochManager& instance()
+    {
+        // never deleted, the records of the exiting threads refer to it
+        static EpochManager* manager = new EpochManager;
+        return *manager;
+    }
+
+    void enter()
+    {
+        ThreadRecord* record = getRecord();
+        if (record->nesting++ > 0)
+            return;
+
+        uint64_t epoch = epoch_.load(boost::memory_order_relaxed);
+        while (true)
+        {
+            record->state.store(epoch << 1 | 1, boost::memory_order_seq_cst);
+            uint64_t current = epoch_.load(boost::memory_order_seq_cst);
+            if (current == epoch)
+                break;
+            epoch = current;
+        }
+    }
+
+    void leave()
+    {
+        ThreadRecord* record = getRecord();
+        if (--record->nesting == 0)
+            record->state.store(0, boost::memory_order_release);
+    }
+
+    /**
+     * @brief Delete p by deleter once no thread may read it any more, p
+     * should be unlinked from the structure already.
+     */
+    void retire(void* p, Deleter deleter)
+    {
+        ThreadRecord* record = getRecord();
+        record->retired.push_back(Retired(epoch_.load(boost::memory_order_seq_cst), p, deleter));
+        pending_.fetch_add(1, boost::memory_order_relaxed);
+        if (record->retired.size() % COLLECT_THRESHOLD == 0)
+            collect(record);
+    }
+
+    template <typename T>
+    void retire(T* p)
+    {
+        retire(p, &deleteObject<T>);
+    }
+
+    template <typename T>
+    void retireArray(T* p)
+    {
+        retire(p, &deleteArray<T>);
+    }
+
+    /**
+     * @brief Advance the epoch if possible, and delete the nodes retired by
+     * this thread, and by the exited threads, no thread may read.
+     */
+    void collect()
+    {
+        collect(getRecord());
+    }
+
+    /**
+     * @return the number of the nodes retired and not deleted yet.
+     */
+    size_t pending() const
+    {
+        return pending_.load(boost::memory_order_relaxed);
+    }
+
+private:
+    struct Retired
+    {
+        Retired(uint64_t e, void* p, Deleter d) : epoch(e), pointer(p), deleter(d) {}
+
+        uint64_t epoch;
+        void* pointer;
+        Deleter deleter;
+    };
+
+    struct ThreadRecord
+    {
+        ThreadRecord() : state(0), used(true), nesting(0), next(NULL) {}
+
+        /// the epoch shifted by one, with the lowest bit set when in it
+        boost::atomic<uint64_t> state;
+        boost::atomic<bool> used;
+        size_t nesting;
+        std::vector<Retired> retired;
+        ThreadRecord* next;
+    };
+
+    EpochManager() : epoch_(1), records_(NULL), pending_(0), threadRecord_(&releaseRecord) {}
+
+    template <typename T>
+    static void deleteObject(void* p)
+    {
+        delete static_cast<T*>(p);
+    }
+
+    template <typename T>
+    static void deleteArray(void* p)
+    {
+        delete[] static_cast<T*>(p);
+    }
+
+    ThreadRecord* getRecord()
+    {
+        ThreadRecord* record = threadRecord_.get();
+        if (record)
+            return record;
+
+        // the record of an exited thread, or a new one
+        for (record = records_.load(boost::memory_order_acquire); record; record = record->next)
+        {
+            bool used = false;
+            if (!record->used.load(boost::memory_order_relaxed)
+                    && record->used.compare_exchange_strong(used, true))
+                break;
+        }
+        if (!record)
+        {
+            record = new ThreadRecord;
+            ThreadRecord* head = records_.load(boost::memory_order_relaxed);
+            do
+            {
+                record->next = head;
+            }
+            while (!records_.compare_exchange_weak(head, record));
+        }
+        threadRecord_.reset(record);
+        return record;
+    }
+
+    /// at the exit of a thread, its retired nodes are left to the others
+    static void releaseRecord(ThreadRecord* record)
+    {
+        EpochManager& manager = instance();
+        if (!record->retired.empty())
+        {
+            boost::mutex::scoped_lock lock(manager.orphanMutex_);
+            manager.orphans_.insert(manager.orphans_.end(), record->retired.begin(), record->retired.end());
+            record->retired.clear();
+        }
+        record->nesting = 0;
+        record->state.store(0, boost::memory_order_release);
+        record->used.store(false, boost::memory_order_release);
+    }
+
+    /// advance the epoch if all the threads in an epoch are in the current one
+    void tryAdvance()
+    {
+        uint64_t epoch = epoch_.load(boost::memory_order_seq_cst);
+        for (ThreadRecord* record = records_.load(boost::memory_order_acquire); record; record = record->next)
+        {
+            uint64_t state = record->state.load(boost::memory_order_seq_cst);
+            if ((state & 1) && (state >> 1) != epoch)
+                return;
+        }
+        epoch_.compare_exchange_strong(epoch, epoch + 1);
+    }
+
+    /// delete the nodes retired two epochs before the current one
+    size_t reclaim(std::vector<Retired>& retired)
+    {
+        uint64_t epoch = epoch_.load(boost::memory_order_seq_cst);
+        size_t kept = 0;
+        for (size_t i = 0; i < retired.size(); ++i)
+        {
+            if (retired[i].epoch + 2 <= epoch)
+                retired[i].deleter(retired[i].pointer);
+            else
+                retired[kept++] = retired[i];
+        }
+        size_t deleted = retired.size() - kept;
+        retired.resize(kept, Retired(0, NULL, NULL));
+        pending_.fetch_sub(deleted, boost::memory_order_relaxed);
+        return deleted;
+    }
+
+    void collect(ThreadRecord* record)
+    {
+        tryAdvance();
+        reclaim(record->retired);
+
+        boost::mutex::scoped_try_lock lock(orphanMutex_);
+        if (lock.owns_lock() && !orphans_.empty())
+            reclaim(orphans_);
+    }
+
+private:
+    boost::atomic<uint64_t> epoch_;
+    boost::atomic<ThreadRecord*> records_;
+    boost::atomic<size_t> pending_;
+    boost::thread_specific_ptr<ThreadRecord> threadRecord_;
+
+    boost::mutex orphanMutex_;
+    std::vector<Retired> orphans_;
+};
+
+/**
+ * @brief Keep the calling thread in an epoch while it lives, a copy keeps it
+ * in the same one, so the copies should stay in the thread.
+ */
+class EpochGuard
+{
+public:
+    EpochGuard()
+    {
+        EpochManager::instance().enter();
+    }
+
+    EpochGuard(const EpochGuard&)
+    {
+        EpochManager::instance().enter();
+    }
+
+    EpochGuard& operator=(const EpochGuard&)
+    {
+        return *this;
+    }
+
+    ~EpochGuard()
+    {
+        EpochManager::instance().leave();
+    }
+};
+
+}}}
+
+#endif
@@ -4,8 +4,9 @@
 #include <boost/thread.hpp>
 #include <boost/io/ios_state.hpp>
 #include <boost/array.hpp>
+#include <boost/atomic.hpp>
 #include <boost/noncopyable.hpp>
-#include <boost/shared_ptr.hpp>
+#include <boost/scoped_array.hpp>
 
 #include <vector>
 #include <iostream>
@@ -16,8 +17,7 @@ template <typename key, typename value>
 struct node : public boost::noncopyable
 {
     typedef node<key,value> node_t;
-    typedef boost::shared_ptr<node_t> shared_node;
-    typedef std::vector<shared_node> next_array;
+    typedef boost::scoped_array<boost::atomic<node_t*> > next_array;
 
 
     typedef boost::mutex::scoped_lock scoped_lock;
@@ -26,11 +26,15 @@ struct node : public boost::noncopyable
     const int top_layer;
     boost::mutex guard;
     next_array next;
-    volatile bool marked;
-    volatile bool fullylinked;
+    boost::atomic<bool> marked;
+    boost::atomic<bool> fullylinked;
     node(const key& k_, const value& v_, size_t top)
-        :first(k_),second(v_),top_layer(top),next(top+1),marked(false),fullylinked(false)
+        :first(k_),second(v_),top_layer(top),next(new boost::atomic<node_t*>[top+1]),marked(false),fullylinked(false)
     {
+        for(size_t i=0; i<=top; i++)
+        {
+            next[i].store(NULL, boost::memory_order_relaxed);
+        }
     }
     ~node()
     {
@@ -47,9 +51,10 @@ struct node : public boost::noncopyable
             boost::io::ios_flags_saver dec(std::cerr);
             for(int i=0; i<=top_layer; i++)
             {
-                if(next[i] != NULL)
+                const node_t* n = next[i].load(boost::memory_order_acquire);
+                if(n != NULL)
                 {
-                    std::cerr << i << ":" << next[i]->first << " ";
+                    std::cerr << i << ":" << n->first << " ";
                 }
                 else
                 {
@@ -1,39 +1,39 @@
 /*****
-* This is a C++ implementation of the paper "A Simple Optimistic skip-list Algorithm" 
+* This is a C++ implementation of the paper "A Simple Optimistic skip-list Algorithm"
 *   written by Maurice Herlihy, Yossi Lev, Victor Luchangco, Nir Shavit.
 *   http://www.cs.bgu.ac.il/~mpam092/wiki.files/LazySkipList.pdf
 *   Author: Kumagi
+*
+* The links are atomic pointers, read without lock, and the removed nodes
+* are retired to the EpochManager, each operation being in an epoch, so they
+* are deleted once no reader may be in them. An iterator keeps its thread in
+* an epoch, so the node it is on is not deleted while it lives, it should
+* not be passed to another thread, nor kept long, as it delays the deletion
+* of the removed nodes.
 */
 #ifndef IZENELIB_AM_CONCURRENT_SKIPLIST_HPP
 #define IZENELIB_AM_CONCURRENT_SKIPLIST_HPP
 #include "node.hpp"
-#include <boost/foreach.hpp>
-#include <boost/random.hpp>
-#include <boost/weak_ptr.hpp>
+#include "epoch.hpp"
+#include <boost/atomic.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 #include <boost/optional.hpp>
 #include <utility>
+#include <memory>
+#include <cassert>
+#include <unistd.h>
 
 namespace izenelib{ namespace am { namespace concurrent {
-template <typename T>
-void nothing_deleter(const T*)
-{
-    //std::cerr << "good morning all!" << std::endl;
-} // do nothing
 
 template <typename key,typename value, int height = 8>
 class SkipList
 {
     typedef SkipList<key,value,height> skipList_t;
     typedef node<key,value> node_t;
-    typedef boost::shared_ptr<node_t> shared_node;
-    typedef boost::weak_ptr<node_t> weak_node;
     typedef boost::array<node_t*, height> ptr_node_array;
-    typedef boost::array<weak_node, height> weak_node_array;
-    typedef boost::array<shared_node, height> locked_node_array;
 
-    typedef std::pair<weak_node_array,weak_node_array> nodelists;
+    typedef std::pair<ptr_node_array,ptr_node_array> nodelists;
     typedef typename node_t::scoped_lock scoped_lock;
 
     typedef boost::shared_ptr<scoped_lock> scoped_lock_ptr;
@@ -42,10 +42,11 @@ class SkipList
 public:
     class iterator
     {
-        shared_node node;
+        node_t* node;
+        EpochGuard epoch;
     public:
-        iterator() {}
-        explicit iterator(shared_node& s):node(s) {}
+        iterator():node(NULL) {}
+        explicit iterator(node_t* s):node(s) {}
         node_t& operator*()
         {
             return *node;
@@ -64,17 +65,13 @@ public:
         }
         bool operator==(const iterator& rhs)const
         {
-            return node.get() == rhs.node.get();
+            return node == rhs.node;
         }
         bool operator!=(const iterator& rhs)const
         {
             return !operator==(rhs);
         }
-        shared_node& get()
-        {
-            return node;
-        }
-        const shared_node& get()const
+        node_t* get()const
         {
             return node;
         }
@@ -82,56 +79,52 @@ public:
         {
             while(true)
             {
-                if(node->next[0].get() != NULL)
+                node_t* next = node->next[0].load(boost::memory_order_acquire);
+                if(next != NULL)
                 {
-                    node = node->next[0];
+                    node = next;
                 }
-                if(node->marked) continue;
+                if(node->marked.load(boost::memory_order_acquire)) continue;
                 break;
             }
             return *this;
         }
-    private:
-
-//		iterator(const iterator&);
     };
 
 private:
     node_t head;
-    iterator shared_head, shared_tail;
-    boost::mt19937 engine;
-    boost::uniform_smallint<> range;
-    mutable boost::variate_generator<boost::mt19937&, boost::uniform_smallint<> > rand;
+    node_t* tail;
+    mutable boost::atomic<uint32_t> seed;
 public:
     SkipList(const key& min, const key& max, int randomseed = 0)
         :head(min ,value(), height)
-        ,engine(static_cast<unsigned long>(randomseed))
-        ,range(0,(1<<height) -1),rand(engine,range)
+        ,tail(new node_t(max,value(),0))
+        ,seed(static_cast<uint32_t>(randomseed))
     {
-        shared_node head_node(&head,nothing_deleter<node_t>);
-        shared_node tail_node(new node_t(max,value(),0));
-        iterator head_iter(head_node);
-        iterator tail_iter(tail_node);
-        shared_head = head_iter;
-        shared_tail = tail_iter;
-        shared_node& tail = shared_tail.get();
         for(int i=0; i<height; i++)
         {
-            head.next[i] = tail;
+            head.next[i].store(tail, boost::memory_order_relaxed);
         }
         head.fullylinked = true;
     }
     ~SkipList()
     {
+        // the removed nodes are left to the EpochManager
+        node_t* p = head.next[0].load(boost::memory_order_acquire);
+        while(p != NULL)
+        {
+            node_t* next = p->next[0].load(boost::memory_order_relaxed);
+            delete p;
+            p = next;
+        }
     }
     bool contains(const key& k)
     {
+        EpochGuard epoch;
         nodelists lists;
         const int lv = find(k, &lists);
-        weak_node_array& succs = lists.second;
         if(lv == -1) return false;
-        shared_node succ = succs[lv].lock();
-        if(!succ) return false;
+        const node_t* succ = lists.second[lv];
         return succ->fullylinked
                && !succ->marked;
     }
@@ -139,12 +132,11 @@ public:
 
     iterator get(const key& k)
     {
+        EpochGuard epoch;
         nodelists lists;
         const int lv = find(k, &lists);
-        weak_node_array& succs = lists.second;
         if(lv == -1) return end();
-        shared_node succ = succs[lv].lock();
-        if(!succ) return end();
+        node_t* succ = lists.second[lv];
         if(succ->fullylinked && !succ->marked)
         {
             return iterator(succ);
@@ -157,27 +149,24 @@ public:
 
     iterator lower_bound(const key& k)
     {
+        EpochGuard epoch;
         nodelists lists;
         const int lv = find(k, &lists);
-        weak_node_array& currs = lists.first;
-        weak_node_array& succs = lists.second;
-        shared_node curr = currs[0].lock();
-        if(lv == -1) return iterator(curr);
-        shared_node succ = succs[lv].lock();
-        if(!succ) return end();
+        if(lv == -1) return iterator(lists.first[0]);
+        node_t* succ = lists.second[lv];
         if(succ->fullylinked && !succ->marked)
         {
             return iterator(succ);
         }
         else
         {
-            shared_node curr = currs[0].lock();
-            return iterator(curr);
+            return iterator(lists.first[0]);
         }
     }
 
     bool add(const key& k, const value& v)
     {
+        EpochGuard epoch;
         const int top_layer = random_level();
         assert(top_layer < height);
         nodelists lists;
@@ -185,13 +174,12 @@ public:
         while(true)
         {
             const int lv = find(k, &lists);
-            weak_node_array& preds = lists.first;
-            weak_node_array& succs = lists.second;
+            ptr_node_array& preds = lists.first;
+            ptr_node_array& succs = lists.second;
 
             if(lv != -1)
             {
-                const node_t* found = succs[lv].lock().get();
-                if(!found) continue;
+                const node_t* found = succs[lv];
                 if(!found->marked)
                 {
                     while(!found->fullylinked)
@@ -205,31 +193,12 @@ public:
             }
             bool valid = true;
 
-
-            // get shared_ptr from weak_ptr array
-            locked_node_array locked_preds;
-            locked_node_array locked_succs;
-            for(int i=0; i<=top_layer; ++i)
-            {
-                locked_preds[i] = preds[i].lock();
-                locked_succs[i] = succs[i].lock();
-                if(!locked_preds[i] || !locked_succs[i])
-                {
-                    valid = false;
-                    break;
-                }
-            }
-            if(!valid)
-            {
-                continue;
-            }
-
             node_t *prev_pred = NULL;
             std::vector<scoped_lock_ptr> pred_locks(top_layer+1);
             for(int layer = 0; valid && (layer <= top_layer); ++layer)
             {
-                node_t* pred = locked_preds[layer].get();
-                const node_t* succ = locked_succs[layer].get();
+                node_t* pred = preds[layer];
+                const node_t* succ = succs[layer];
 
                 if(pred != prev_pred)
                 {
@@ -240,7 +209,7 @@ public:
                 assert(succ);
                 valid = !pred->marked
                         && !succ->marked
-                        && pred->next[layer].get() == succ;
+                        && pred->next[layer].load(boost::memory_order_acquire) == succ;
 
             }
             if(!valid)
@@ -252,15 +221,14 @@ public:
             // start to insert
             for(int i = 0; i<=top_layer; ++i)
             {
-                newnode->next[i] = shared_node(succs[i]);
+                newnode->next[i].store(succs[i], boost::memory_order_relaxed);
                 //std::cerr << "[" << newnode->next[i] << "]f";
             }
 
-            shared_node newnode_insert(newnode.get());
-            newnode.release(); // it's all reason why I use auto_ptr
+            node_t* newnode_insert = newnode.release(); // it's all reason why I use auto_ptr
             for(int layer = 0; layer <= top_layer; ++layer)
             {
-                locked_preds[layer]->next[layer] = newnode_insert;
+                preds[layer]->next[layer].store(newnode_insert, boost::memory_order_release);
             }
             newnode_insert->fullylinked = true;
             return true;
@@ -268,41 +236,32 @@ public:
         assert(!"never reach");
     }
 
-    iterator& begin()
-    {
-        return shared_head;
-    }
-    const iterator& begin()const
-    {
-        return shared_head;
-    }
-    iterator& end()
+    iterator begin()
     {
-        return shared_tail;
+        return iterator(&head);
     }
-    const iterator& end()const
+    iterator end()
     {
-        return shared_tail;
+        return iterator(tail);
     }
 
     bool remove(const key& k)
     {
+        EpochGuard epoch;
         nodelists lists;
         bool is_marked = false;
         int top_layer = -1;
-        shared_node victim;
-        assert(victim.get() == NULL);
+        node_t* victim = NULL;
         while(true)
         {
 
             int lv = find(k, &lists);
-            weak_node_array& preds = lists.first;
-            weak_node_array& succs = lists.second;
+            ptr_node_array& preds = lists.first;
+            ptr_node_array& succs = lists.second;
 
             if(lv != -1)
             {
-                victim = succs[lv].lock();
-                if(!victim) return false;
+                victim = succs[lv];
             }
             if(is_marked ||
                     (lv != -1 && (victim->fullylinked
@@ -323,36 +282,18 @@ public:
                 }
 
                 bool valid = true;
-                // get shared_ptr from weak_ptr array
-                locked_node_array locked_preds;
-                locked_node_array locked_succs;
-                for(int i=0; i<=top_layer; ++i)
-                {
-                    locked_preds[i] = preds[i].lock();
-                    locked_succs[i] = succs[i].lock();
-                    if(!locked_preds[i] || !locked_succs[i])
-                    {
-                        valid = false;
-                        break;
-                    }
-                }
-                if(!valid)
-                {
-                    continue;
-                }
-
                 node_t *prev_pred = NULL;
                 std::vector<scoped_lock_ptr> pred_locks(top_layer+1);
                 for(int layer = 0; valid && (layer <= top_layer); ++layer)
                 {
-                    node_t *pred = locked_preds[layer].get();
-                    const node_t *succ = locked_succs[layer].get();
+                    node_t *pred = preds[layer];
+                    const node_t *succ = succs[layer];
                     if(pred != prev_pred)
                     {
                         pred_locks[layer] = scoped_lock_ptr(new scoped_lock(pred->guard));
                         prev_pred = pred;
                     }
-                    valid = !pred->marked && pred->next[layer].get() == succ;
+                    valid = !pred->marked && pred->next[layer].load(boost::memory_order_acquire) == succ;
                 }
                 if(!valid)
                 {
@@ -361,9 +302,13 @@ public:
 
                 for(int layer = top_layer; layer>=0; --layer)
                 {
-                    locked_preds[layer]->next[layer] = victim->next[layer];
+                    preds[layer]->next[layer].store(victim->next[layer].load(boost::memory_order_acquire),
+                                                    boost::memory_order_release);
                 }
                 victim->guard.unlock();
+                pred_locks.clear();
+                // the readers already in it still may read it
+                EpochManager::instance().retire(victim);
                 return true;
             }
             else
@@ -371,28 +316,27 @@ public:
         }
     }
 
+    /// should be called in an epoch, the nodes found are valid in it
     int find(const key& target, nodelists* lists)
     {
         int found = -1;
 
-        shared_node pred = shared_head.get();
-        shared_node curr;
-        *lists = nodelists();
-        //lists->second.resize(height);
+        node_t* pred = &head;
+        node_t* curr;
         for(int lv = height-1; lv >= 0; --lv)
         {
-            curr = pred->next[lv];
+            curr = pred->next[lv].load(boost::memory_order_acquire);
             while(curr->first < target)
             {
                 pred = curr;
-                curr = pred->next[lv];
+                curr = pred->next[lv].load(boost::memory_order_acquire);
             }
             if(found == -1 && target == curr->first)
             {
                 found = lv;
             }
-            lists->first[lv] = weak_node(pred);
-            lists->second[lv] = weak_node(curr);
+            lists->first[lv] = pred;
+            lists->second[lv] = curr;
         }
 
         return found;
@@ -400,34 +344,40 @@ public:
 
     void dump()const
     {
+        EpochGuard epoch;
         const node_t* p = &head;
         while(p != NULL)
         {
             p->dump();
-            p = p->next[0].get();
+            p = p->next[0].load(boost::memory_order_acquire);
             std::cerr << std::endl;
         }
     }
 
     bool is_empty()const
     {
-        return head.next[0].get() == end().get().get();
+        return head.next[0].load(boost::memory_order_acquire) == tail;
     }
 
     void clear()
     {
-        while(shared_head->next[0] != shared_tail.get())
+        EpochGuard epoch;
+        node_t* first;
+        while((first = head.next[0].load(boost::memory_order_acquire)) != tail)
         {
-            for(int i=0; i<height; i++)
-            {
-                shared_tail->next[i] = shared_tail->next[0]->next[0];
-            }
+            remove(first->first);
         }
     }
 public:
     uint32_t random_level()const
     {
-        const uint32_t gen = rand();
+        // a step of the golden ratio, mixed as in MurmurHash3, lock free
+        uint32_t gen = seed.fetch_add(0x9e3779b9U, boost::memory_order_relaxed);
+        gen ^= gen >> 16;
+        gen *= 0x85ebca6bU;
+        gen ^= gen >> 13;
+        gen *= 0xc2b2ae35U;
+        gen ^= gen >> 16;
         int bit = 1;
         int cnt=0;
         while(cnt < height-1)
@@ -18,6 +18,9 @@
 #include <boost/bind.hpp>
 #include "sort_runner.hpp"
 #include "sort_merger.hpp"
+#include "parallel_sort_runner.hpp"
+#include "parallel_sort_merger.hpp"
+#include <boost/type_traits/is_same.hpp>
 #include <math.h>
 #include <sys/time.h>
 
@@ -39,10 +42,13 @@ public:
   typedef IzeneSort<KEY_TYPE, LEN_TYPE, COMPARE_ALL,IO_TYPE> self_t;
   typedef SortRunner<KEY_TYPE, LEN_TYPE, COMPARE_ALL,IO_TYPE> run_t;
   typedef SortMerger<KEY_TYPE, LEN_TYPE, COMPARE_ALL,IO_TYPE> merge_t;
+  typedef ParallelSortRunner<KEY_TYPE, LEN_TYPE, COMPARE_ALL> prun_t;
+  typedef ParallelSortMerger<KEY_TYPE, LEN_TYPE, COMPARE_ALL> pmerge_t;
 private:
   std::string filenm_;
   uint32_t buf_size_;
   uint32_t buf_num_;
+  uint32_t thread_num_;
   uint64_t count_;
 
   run_t* run_;
@@ -65,7 +71,7 @@ private:
 public:
   IzeneSort(const char* filenm, uint32_t buf_size = 100000000, uint32_t buf_num=2)
     :filenm_(filenm), buf_size_(buf_size), buf_num_(buf_num),
-     count_(0), run_(NULL), merge_(NULL), buffer_(NULL),
+     thread_num_(1), count_(0), run_(NULL), merge_(NULL), buffer_(NULL),
      pos_(0), f_(NULL)
   {
   }
@@ -86,6 +92,16 @@ public:
   {
     buf_size_ = size;
   }
+
+  /**
+     @brief sorting threads of run generation. With more than one thread,
+     runs are sorted in parallel and merged by a loser tree with
+     asynchronous reads, which is only available for DirectIO.
+   */
+  void set_thread_num(uint32_t num)
+  {
+    thread_num_ = num;
+  }
   
   void add_data(LEN_TYPE len, const char* data)
   {
@@ -169,6 +185,21 @@ public:
     if (count_ <= 1)
       return true;
 
+    if (thread_num_ > 1 && boost::is_same<IO_TYPE, DirectIO>::value)
+    {
+      prun_t prun(filenm_.c_str(), buf_size_, thread_num_);
+      prun.run();
+
+      pmerge_t pmerge(filenm_.c_str(), prun.run_num(), buf_size_);
+      pmerge.set_params(prun.max_record_len(), prun.min_run_buf_size_for_merger());
+      pmerge.run();
+
+      gettimeofday (&tvafter , &tz);
+      std::cout<<"\nIt takes "<<((tvafter.tv_sec-tvpre.tv_sec)*1000+(tvafter.tv_usec-tvpre.tv_usec)/1000.)/60000
+               <<" minutes to sort("<<count_<<") with "<<thread_num_<<" threads\n";
+      return true;
+    }
+
     if (run_)
       delete run_;
     
@@ -0,0 +1,348 @@
+/**
+   @file parallel_sort_merger.hpp
+   @brief k-way merging of the runs of ParallelSortRunner (or SortRunner).
+
+   Every run owns two input buffers: the merger consumes one while an IO
+   thread refills the other with pread(). The winner is chosen by a loser
+   tree, so a record costs log(k) comparisons. Output is double buffered as
+   well and written by its own thread.
+ */
+#ifndef PARALLEL_SORT_MERGER_HPP
+#define PARALLEL_SORT_MERGER_HPP
+
+#include <util/log.h>
+#include <util/concurrent_queue.h>
+#include "parallel_sort_runner.hpp"
+#include <vector>
+#include <string>
+#include <types.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <sys/time.h>
+
+NS_IZENELIB_AM_BEGIN
+
+/**
+   @class ParallelSortMerger
+ **/
+template<
+  class KEY_TYPE = uint32_t,//pre-key type, indicate the length of the pre-key.
+  class LEN_TYPE = uint8_t,//
+  bool  COMPARE_ALL = false
+>
+class ParallelSortMerger
+{
+  typedef ParallelSortMerger<KEY_TYPE, LEN_TYPE, COMPARE_ALL> self_t;
+  typedef SortRecordCompare<KEY_TYPE, LEN_TYPE, COMPARE_ALL> cmp_t;
+
+  struct RUN
+  {
+    uint64_t file_pos;//!< next file address to be loaded
+    uint64_t end;//!< end file address of the run
+    char* buf[2];
+    uint32_t size[2];
+    bool ready[2];
+    uint32_t curr;//!< index of the buffer being merged
+    uint32_t pos;//!< position in the buffer being merged
+  };
+
+  struct OUT_BUF
+  {
+    char* buf;
+    uint32_t size;
+  };
+
+  std::string filenm_;
+  uint32_t run_num_;
+  const uint32_t BS_SIZE_;
+  uint32_t max_record_len_;
+  uint32_t RUN_BUF_SIZE_;//!< size of one of the two buffers of a run
+  uint32_t OUT_BUF_SIZE_;
+
+  int fd_;
+  uint64_t count_;
+  std::vector<RUN> runs_;
+  std::vector<uint32_t> tree_;//!< loser tree, tree_[0] is the winner
+
+  boost::mutex io_mtx_;
+  boost::condition io_con_;
+  izenelib::util::concurrent_queue<std::pair<uint32_t, uint32_t> > io_req_;//!< (run, buffer) to be loaded
+
+  OUT_BUF out_[2];
+  izenelib::util::concurrent_queue<OUT_BUF*> out_free_;
+  izenelib::util::concurrent_queue<OUT_BUF*> out_full_;
+
+  void load_(uint32_t r, uint32_t b)
+  {
+    RUN& run = runs_[r];
+    uint64_t left = run.end - run.file_pos;
+    uint32_t s = (uint32_t)(left > RUN_BUF_SIZE_? RUN_BUF_SIZE_: left);
+    IASSERT(pread(fd_, run.buf[b], s, run.file_pos) == (ssize_t)s);
+
+    //keep complete records only
+    uint32_t p = 0;
+    while (p+sizeof(LEN_TYPE) <= s && p+cmp_t::len(run.buf[b]+p)+sizeof(LEN_TYPE) <= s)
+      p += cmp_t::len(run.buf[b]+p)+sizeof(LEN_TYPE);
+    IASSERT(p > 0);
+
+    boost::mutex::scoped_lock lock(io_mtx_);
+    run.file_pos += p;
+    run.size[b] = p;
+    run.ready[b] = true;
+    io_con_.notify_all();
+  }
+
+  void io_()
+  {
+    while (true)
+    {
+      std::pair<uint32_t, uint32_t> req;
+      io_req_.pop(req);
+      if (req.first == (uint32_t)-1)
+        break;
+      load_(req.first, req.second);
+    }
+  }
+
+  void output_(FILE* f)
+  {
+    while (true)
+    {
+      OUT_BUF* o = NULL;
+      out_full_.pop(o);
+      if (o == NULL)
+        break;
+      IASSERT(fwrite(o->buf, o->size, 1, f)==1);
+      out_free_.push(o);
+    }
+  }
+
+  inline const char* record_(uint32_t r)const
+  {
+    const RUN& run = runs_[r];
+    return run.buf[run.curr]+run.pos;
+  }
+
+  inline bool exhausted_(uint32_t r)const
+  {
+    const RUN& run = runs_[r];
+    return run.curr == (uint32_t)-1;
+  }
+
+  /**
+     @brief whether the current record of run a goes after the one of run
+     b. run_num_ stands for a run smaller than any other, it is only used
+     while building the tree. Exhausted runs are the largest.
+   */
+  inline bool greater_(uint32_t a, uint32_t b)const
+  {
+    if (a == run_num_)
+      return false;
+    if (b == run_num_)
+      return true;
+    if (exhausted_(a))
+      return !exhausted_(b) || a > b;
+    if (exhausted_(b))
+      return false;
+
+    int c = cmp_t::compare(record_(a), record_(b));
+    return c > 0 || (c == 0 && a > b);
+  }
+
+  inline void adjust_(uint32_t s)
+  {
+    for (uint32_t t = (s+run_num_)/2; t > 0; t /= 2)
+      if (greater_(s, tree_[t]))
+        std::swap(s, tree_[t]);
+    tree_[0] = s;
+  }
+
+  /// move run r to its next record, switching buffers at the end of one
+  void advance_(uint32_t r)
+  {
+    RUN& run = runs_[r];
+    run.pos += cmp_t::len(run.buf[run.curr]+run.pos)+sizeof(LEN_TYPE);
+    if (run.pos < run.size[run.curr])
+      return;
+
+    uint32_t done = run.curr;
+    uint32_t next = 1-done;
+    boost::mutex::scoped_lock lock(io_mtx_);
+    run.ready[done] = false;
+    while (!run.ready[next] && run.file_pos < run.end)
+      io_con_.wait(lock);
+
+    if (!run.ready[next])
+    {
+      run.curr = (uint32_t)-1;
+      return;
+    }
+
+    run.curr = next;
+    run.pos = 0;
+    if (run.file_pos < run.end)
+      io_req_.push(std::make_pair(r, done));
+  }
+
+  void init_()
+  {
+    uint64_t file_len = lseek(fd_, 0, SEEK_END);
+    IASSERT(pread(fd_, &count_, sizeof(uint64_t), 0) == sizeof(uint64_t));
+
+    uint64_t pos = sizeof(uint64_t);
+    while (pos < file_len)
+    {
+      uint32_t size;
+      uint64_t next;
+      IASSERT(pread(fd_, &size, sizeof(uint32_t), pos) == sizeof(uint32_t));
+      IASSERT(pread(fd_, &next, sizeof(uint64_t), pos+2*sizeof(uint32_t)) == sizeof(uint64_t));
+
+      RUN run;
+      run.file_pos = pos+2*sizeof(uint32_t)+sizeof(uint64_t);
+      run.end = run.file_pos+size;
+      run.buf[0] = run.buf[1] = NULL;
+      run.size[0] = run.size[1] = 0;
+      run.ready[0] = run.ready[1] = false;
+      run.curr = run.pos = 0;
+      if (size > 0)
+        runs_.push_back(run);
+      pos = next;
+    }
+    run_num_ = runs_.size();
+
+    if (run_num_ > 0)
+      RUN_BUF_SIZE_ = (uint32_t)(BS_SIZE_*.8/(2*run_num_));
+    if (RUN_BUF_SIZE_ < max_record_len_)
+      RUN_BUF_SIZE_ = max_record_len_;
+    OUT_BUF_SIZE_ = (uint32_t)(BS_SIZE_*.1);
+    if (OUT_BUF_SIZE_ < max_record_len_)
+      OUT_BUF_SIZE_ = max_record_len_;
+
+    for (uint32_t i=0; i<run_num_; ++i)
+    {
+      runs_[i].buf[0] = (char*)malloc(RUN_BUF_SIZE_);
+      runs_[i].buf[1] = (char*)malloc(RUN_BUF_SIZE_);
+      load_(i, 0);
+      if (runs_[i].file_pos < runs_[i].end)
+        io_req_.push(std::make_pair(i, 1u));
+    }
+
+    for (uint32_t i=0; i<2; ++i)
+    {
+      out_[i].buf = (char*)malloc(OUT_BUF_SIZE_);
+      out_[i].size = 0;
+      out_free_.push(&out_[i]);
+    }
+  }
+
+  void merge_()
+  {
+    tree_.assign(run_num_ > 0? run_num_: 1, run_num_);
+    for (uint32_t i=run_num_; i>0; --i)
+      adjust_(i-1);
+
+    OUT_BUF* o = NULL;
+    out_free_.pop(o);
+    o->size = 0;
+    while (run_num_ > 0 && !exhausted_(tree_[0]))
+    {
+      uint32_t w = tree_[0];
+      const char* rec = record_(w);
+      uint32_t len = cmp_t::len(rec)+sizeof(LEN_TYPE);
+      if (o->size+len > OUT_BUF_SIZE_)
+      {
+        out_full_.push(o);
+        out_free_.pop(o);
+        o->size = 0;
+      }
+      memcpy(o->buf+o->size, rec, len);
+      o->size += len;
+
+      advance_(w);
+      adjust_(w);
+    }
+
+    if (o->size > 0)
+      out_full_.push(o);
+    out_full_.push(NULL);
+  }
+
+public:
+  ParallelSortMerger(const char* filenm, uint32_t run_num, uint32_t buf_size = 100000000)
+    :filenm_(filenm), run_num_(run_num), BS_SIZE_(buf_size), max_record_len_(0),
+     RUN_BUF_SIZE_(0), OUT_BUF_SIZE_(0), fd_(-1), count_(0)
+  {
+    out_[0].buf = out_[1].buf = NULL;
+  }
+
+  ~ParallelSortMerger()
+  {
+    for (size_t i=0; i<runs_.size(); ++i)
+    {
+      free(runs_[i].buf[0]);
+      free(runs_[i].buf[1]);
+    }
+    for (uint32_t i=0; i<2; ++i)
+      if (out_[i].buf)
+        free(out_[i].buf);
+  }
+
+  /**
+     @brief the second parameter is kept for compatibility with SortMerger,
+     both buffers of a run only need to hold the longest record.
+   */
+  void set_params(uint32_t max_record_len, uint32_t min_buff_size_required = 0)
+  {
+    max_record_len_ = max_record_len;
+  }
+
+  void run()
+  {
+    struct timeval tvafter, tvpre;
+    struct timezone tz;
+
+    gettimeofday (&tvpre , &tz);
+
+    fd_ = open(filenm_.c_str(), O_RDONLY);
+    IASSERT(fd_ >= 0);
+
+    init_();
+
+    FILE* out_f = fopen((filenm_+".out").c_str(), "w+");
+    IASSERT(out_f);
+    IASSERT(fwrite(&count_, sizeof(uint64_t), 1, out_f)==1);
+
+    boost::thread io_thre(boost::bind(&self_t::io_, this));
+    boost::thread out_thre(boost::bind(&self_t::output_, this, out_f));
+
+    merge_();
+
+    io_req_.push(std::make_pair((uint32_t)-1, 0u));
+    io_thre.join();
+    out_thre.join();
+
+    close(fd_);
+    fclose(out_f);
+
+    gettimeofday (&tvafter , &tz);
+    LOG(INFO) << "Merging is done(" << count_ << ", " << run_num_ << " runs): "
+              << ((tvafter.tv_sec-tvpre.tv_sec)*1000+(tvafter.tv_usec-tvpre.tv_usec)/1000.)/60000 << " min";
+
+    if (boost::filesystem::exists(filenm_))
+      boost::filesystem::remove(filenm_);
+    if (boost::filesystem::exists(filenm_+".out"))
+      boost::filesystem::rename(filenm_+".out", filenm_);
+  }
+}
+  ;
+
+NS_IZENELIB_AM_END
+
+#endif
@@ -0,0 +1,405 @@
+/**
+   @file parallel_sort_runner.hpp
+   @brief run generation of IzeneSort with several sorting threads.
+
+   One thread reads the input in chunks, a pool of threads sorts the chunks
+   in memory and one thread writes every sorted chunk as a run. The output
+   has the same layout as the one of SortRunner, so it can be merged by
+   either SortMerger or ParallelSortMerger.
+
+   Integral pre-keys are sorted with a LSD radix sort on (pre-key, position)
+   pairs, records with equal pre-keys are then ordered by the rest of the
+   record when COMPARE_ALL is set.
+ */
+#ifndef PARALLEL_SORT_RUNNER_HPP
+#define PARALLEL_SORT_RUNNER_HPP
+
+#include <util/log.h>
+#include <util/concurrent_queue.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <types.h>
+#include <stdio.h>
+#include <string.h>
+#include <boost/filesystem.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/type_traits.hpp>
+#include <boost/bind.hpp>
+#include <sys/time.h>
+
+NS_IZENELIB_AM_BEGIN
+
+/**
+   @brief ordering of two records, pre-key first then, if COMPARE_ALL, the
+   following KEY_TYPE words and the length. Same as SortRunner::KEY_PTR.
+ **/
+template<class KEY_TYPE, class LEN_TYPE, bool COMPARE_ALL>
+struct SortRecordCompare
+{
+  static KEY_TYPE key(const char* rec, uint32_t i = 0)
+  {
+    KEY_TYPE k;
+    memcpy(&k, rec + sizeof(LEN_TYPE) + i*sizeof(KEY_TYPE), sizeof(KEY_TYPE));
+    return k;
+  }
+
+  static LEN_TYPE len(const char* rec)
+  {
+    LEN_TYPE l;
+    memcpy(&l, rec, sizeof(LEN_TYPE));
+    return l;
+  }
+
+  /// compare what follows the pre-key
+  static int compare_tail(const char* a, const char* b)
+  {
+    if (!COMPARE_ALL)
+      return 0;
+
+    LEN_TYPE len1 = len(a)/sizeof(KEY_TYPE);
+    LEN_TYPE len2 = len(b)/sizeof(KEY_TYPE);
+    for (LEN_TYPE i=1; i<len1 && i<len2; ++i)
+    {
+      KEY_TYPE k1 = key(a, i);
+      KEY_TYPE k2 = key(b, i);
+      if (k1 > k2)
+        return 1;
+      if (k1 < k2)
+        return -1;
+    }
+
+    if (len1 == len2)
+      return 0;
+    return len1>len2? 1: -1;
+  }
+
+  static int compare(const char* a, const char* b)
+  {
+    KEY_TYPE k1 = key(a);
+    KEY_TYPE k2 = key(b);
+    if (k1 > k2)
+      return 1;
+    if (k1 < k2)
+      return -1;
+    return compare_tail(a, b);
+  }
+};
+
+/**
+   @class ParallelSortRunner
+ **/
+template<
+  class KEY_TYPE = uint32_t,//pre-key type, indicate the length of the pre-key.
+  class LEN_TYPE = uint8_t,//
+  bool  COMPARE_ALL = false
+>
+class ParallelSortRunner
+{
+  typedef ParallelSortRunner<KEY_TYPE, LEN_TYPE, COMPARE_ALL> self_t;
+  typedef SortRecordCompare<KEY_TYPE, LEN_TYPE, COMPARE_ALL> cmp_t;
+
+  struct CHUNK
+  {
+    char* in;
+    char* out;
+    uint32_t capacity;
+    uint32_t size;
+    uint32_t num;
+    uint32_t max_len;
+  };
+
+  /// sort entry: pre-key and position of the record in the chunk
+  struct KEY_POS
+  {
+    KEY_TYPE key;
+    uint32_t pos;
+  };
+
+  struct KEY_POS_LESS
+  {
+    const char* buf;
+    explicit KEY_POS_LESS(const char* b):buf(b){}
+    bool operator()(const KEY_POS& a, const KEY_POS& b)const
+    {
+      if (a.key != b.key)
+        return a.key < b.key;
+      return cmp_t::compare_tail(buf+a.pos, buf+b.pos) < 0;
+    }
+  };
+
+  std::string filenm_;
+  uint32_t thread_num_;
+  uint32_t CHUNK_SIZE_;
+
+  std::vector<CHUNK> chunks_;
+  izenelib::util::concurrent_queue<CHUNK*> free_;
+  izenelib::util::concurrent_queue<CHUNK*> todo_;
+  izenelib::util::concurrent_queue<CHUNK*> done_;
+
+  uint64_t count_;
+  uint32_t run_num_;
+  uint32_t max_record_len_;
+  uint32_t min_run_buff_size_for_merger_;
+
+  static void radix_sort_(std::vector<KEY_POS>& keys, std::vector<KEY_POS>& tmp)
+  {
+    typedef typename boost::make_unsigned<KEY_TYPE>::type ukey_t;
+    const ukey_t SIGN = boost::is_signed<KEY_TYPE>::value?
+      (ukey_t)((ukey_t)1<<(sizeof(KEY_TYPE)*8-1)): (ukey_t)0;
+
+    tmp.resize(keys.size());
+    for (uint32_t shift = 0; shift < sizeof(KEY_TYPE)*8; shift += 8)
+    {
+      uint32_t hist[256] = {0};
+      for (size_t i=0; i<keys.size(); ++i)
+        ++hist[(((ukey_t)keys[i].key ^ SIGN) >> shift) & 0xff];
+
+      //all the keys share this byte
+      if (hist[(((ukey_t)keys[0].key ^ SIGN) >> shift) & 0xff] == keys.size())
+        continue;
+
+      uint32_t sum = 0;
+      for (uint32_t b=0; b<256; ++b)
+      {
+        uint32_t c = hist[b];
+        hist[b] = sum;
+        sum += c;
+      }
+      for (size_t i=0; i<keys.size(); ++i)
+        tmp[hist[(((ukey_t)keys[i].key ^ SIGN) >> shift) & 0xff]++] = keys[i];
+      keys.swap(tmp);
+    }
+  }
+
+  void sort_chunk_(CHUNK* c, std::vector<KEY_POS>& keys, std::vector<KEY_POS>& tmp)
+  {
+    keys.resize(c->num);
+    uint32_t pos = 0;
+    for (uint32_t i=0; i<c->num; ++i)
+    {
+      keys[i].key = cmp_t::key(c->in+pos);
+      keys[i].pos = pos;
+      pos += cmp_t::len(c->in+pos)+sizeof(LEN_TYPE);
+    }
+    IASSERT(pos == c->size);
+
+    if (boost::is_integral<KEY_TYPE>::value && c->num > 64)
+    {
+      radix_sort_(keys, tmp);
+      if (COMPARE_ALL)
+      {
+        //order the records sharing a pre-key
+        KEY_POS_LESS less(c->in);
+        for (size_t i=0; i<keys.size();)
+        {
+          size_t j = i+1;
+          while (j<keys.size() && keys[j].key == keys[i].key)
+            ++j;
+          if (j-i > 1)
+            std::sort(keys.begin()+i, keys.begin()+j, less);
+          i = j;
+        }
+      }
+    }
+    else
+      std::sort(keys.begin(), keys.end(), KEY_POS_LESS(c->in));
+
+    uint32_t out = 0;
+    c->max_len = 0;
+    for (uint32_t i=0; i<c->num; ++i)
+    {
+      uint32_t len = cmp_t::len(c->in+keys[i].pos)+sizeof(LEN_TYPE);
+      memcpy(c->out+out, c->in+keys[i].pos, len);
+      out += len;
+      if (len > c->max_len)
+        c->max_len = len;
+    }
+  }
+
+  void sort_()
+  {
+    std::vector<KEY_POS> keys;
+    std::vector<KEY_POS> tmp;
+    while (true)
+    {
+      CHUNK* c = NULL;
+      todo_.pop(c);
+      if (c == NULL)
+        break;
+      sort_chunk_(c, keys, tmp);
+      done_.push(c);
+    }
+    done_.push(NULL);
+  }
+
+  void output_(FILE* f)
+  {
+    uint32_t finished = 0;
+    while (finished < thread_num_)
+    {
+      CHUNK* c = NULL;
+      done_.pop(c);
+      if (c == NULL)
+      {
+        ++finished;
+        continue;
+      }
+
+      IASSERT(fwrite(&c->size, sizeof(uint32_t), 1, f)==1);
+      IASSERT(fwrite(&c->num, sizeof(uint32_t), 1, f)==1);
+      uint64_t nextStart = (uint64_t)ftell(f) + sizeof(uint64_t) + c->size;
+      IASSERT(fwrite(&nextStart, sizeof(uint64_t), 1, f)==1);
+      IASSERT(fwrite(c->out, c->size, 1, f)==1);
+
+      ++run_num_;
+      min_run_buff_size_for_merger_ += c->max_len;
+      if (c->max_len > max_record_len_)
+        max_record_len_ = c->max_len;
+
+      free_.push(c);
+    }
+  }
+
+  /// make sure a chunk can hold a record of @p len bytes
+  void reserve_(CHUNK* c, uint32_t len)
+  {
+    if (c->capacity >= len)
+      return;
+    c->capacity = len;
+    c->in = (char*)realloc(c->in, len);
+    c->out = (char*)realloc(c->out, len);
+  }
+
+  void prefetch_(FILE* f)
+  {
+    fseek(f, 0, SEEK_END);
+    const uint64_t FILE_LEN = ftell(f);
+    uint64_t pos = sizeof(uint64_t);
+    uint64_t count = 0;
+
+    while (pos < FILE_LEN && count < count_)
+    {
+      CHUNK* c = NULL;
+      free_.pop(c);
+
+      uint32_t s = (uint32_t)(FILE_LEN-pos>c->capacity? c->capacity: FILE_LEN-pos);
+      fseek(f, pos, SEEK_SET);
+      IASSERT(fread(c->in, s, 1, f)==1);
+
+      c->size = c->num = 0;
+      while (c->size+sizeof(LEN_TYPE) <= s
+             && c->size+cmp_t::len(c->in+c->size)+sizeof(LEN_TYPE) <= s
+             && count+c->num < count_)
+      {
+        c->size += cmp_t::len(c->in+c->size)+sizeof(LEN_TYPE);
+        ++c->num;
+      }
+
+      if (c->num == 0)
+      {
+        //a record is longer than the chunk, read it again with a bigger one
+        LEN_TYPE len;
+        fseek(f, pos, SEEK_SET);
+        IASSERT(fread(&len, sizeof(LEN_TYPE), 1, f)==1);
+        reserve_(c, (uint32_t)len+sizeof(LEN_TYPE));
+        free_.push(c);
+        continue;
+      }
+
+      pos += c->size;
+      count += c->num;
+      todo_.push(c);
+    }
+
+    for (uint32_t i=0; i<thread_num_; ++i)
+      todo_.push(NULL);
+  }
+
+public:
+  ParallelSortRunner(const char* filenm, uint32_t buf_size = 100000000, uint32_t thread_num = 4)
+    :filenm_(filenm), thread_num_(thread_num>0? thread_num: 1),
+     //sorting chunks, one being read and one being written, each needs an input and an output buffer
+     CHUNK_SIZE_((uint32_t)(1.*buf_size/(2*(thread_num_+2)))),
+     count_(0), run_num_(0), max_record_len_(0), min_run_buff_size_for_merger_(0)
+  {
+  }
+
+  ~ParallelSortRunner()
+  {
+    for (size_t i=0; i<chunks_.size(); ++i)
+    {
+      free(chunks_[i].in);
+      free(chunks_[i].out);
+    }
+  }
+
+  void run()
+  {
+    struct timeval tvafter, tvpre;
+    struct timezone tz;
+    gettimeofday (&tvpre , &tz);
+
+    FILE* f = fopen(filenm_.c_str(), "r");
+    IASSERT(f);
+    IASSERT(fread(&count_, sizeof(uint64_t), 1, f)==1);
+
+    chunks_.resize(thread_num_+2);
+    for (size_t i=0; i<chunks_.size(); ++i)
+    {
+      CHUNK& c = chunks_[i];
+      c.capacity = CHUNK_SIZE_ > sizeof(LEN_TYPE)? CHUNK_SIZE_: sizeof(LEN_TYPE);
+      c.in = (char*)malloc(c.capacity);
+      c.out = (char*)malloc(c.capacity);
+      c.size = c.num = c.max_len = 0;
+      free_.push(&c);
+    }
+
+    FILE* out_f = fopen((filenm_+".out").c_str(), "w+");
+    IASSERT(out_f);
+    IASSERT(fwrite(&count_, sizeof(uint64_t), 1, out_f)==1);
+
+    boost::thread_group sort_thres;
+    for (uint32_t i=0; i<thread_num_; ++i)
+      sort_thres.create_thread(boost::bind(&self_t::sort_, this));
+    boost::thread out_thre(boost::bind(&self_t::output_, this, out_f));
+
+    prefetch_(f);
+
+    sort_thres.join_all();
+    out_thre.join();
+
+    fclose(f);
+    fclose(out_f);
+
+    if (boost::filesystem::exists(filenm_))
+      boost::filesystem::remove(filenm_);
+    if (boost::filesystem::exists(filenm_+".out"))
+      boost::filesystem::rename(filenm_+".out", filenm_);
+
+    gettimeofday (&tvafter , &tz);
+    std::cout<<"Parallel runs are over("<<count_<<", "<<thread_num_<<" threads): "
+             <<((tvafter.tv_sec-tvpre.tv_sec)*1000+(tvafter.tv_usec-tvpre.tv_usec)/1000.)/60000<<" min\n";
+  }
+
+  uint32_t run_num()const
+  {
+    return run_num_;
+  }
+
+  uint32_t max_record_len()const
+  {
+    return max_record_len_;
+  }
+
+  uint32_t min_run_buf_size_for_merger()const
+  {
+    return min_run_buff_size_for_merger_;
+  }
+}
+  ;
+
+NS_IZENELIB_AM_END
+
+#endif
@@ -9,10 +9,12 @@
  */
 
 #include <am/concept/DataType.h>
+#include <am/concept/WriteBatch.h>
 #include <am/raw/Buffer.h>
 
 #include <3rdparty/am/leveldb/db.h>
 #include <3rdparty/am/leveldb/comparator.h>
+#include <3rdparty/am/leveldb/write_batch.h>
 #include <glog/logging.h>
 #include <boost/filesystem.hpp>
 #include <boost/shared_ptr.hpp>
@@ -223,6 +225,65 @@ public:
         return false;
     }
 
+    /**
+     * @brief Get values of all @p keys from one snapshot.
+     *
+     * @return number of keys found, found[i] tells whether values[i] is set.
+     */
+    std::size_t multiGet(const std::vector<Buffer>& keys,
+                         std::vector<Buffer>& values,
+                         std::vector<bool>& found) const
+    {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+        if (!checkHandle_(db_))
+            return 0;
+
+        ::leveldb::ReadOptions options;
+        options.snapshot = db_->GetSnapshot();
+
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            ::leveldb::Status s = db_->Get(options,
+                    ::leveldb::Slice(keys[i].data(), keys[i].size()),
+                    &(values[i].strbuffer()));
+            if (s.ok())
+            {
+                values[i].attach();
+                found[i] = true;
+                ++count;
+            }
+        }
+
+        db_->ReleaseSnapshot(options.snapshot);
+        return count;
+    }
+
+    /**
+     * @brief Apply all operations atomically through a leveldb WriteBatch.
+     *
+     * As with insert(), BATCH_INSERT overwrites an existing record.
+     */
+    bool writeBatch(const WriteBatch<Buffer, Buffer>& batch)
+    {
+        if (!checkHandle_(db_))
+            return false;
+
+        ::leveldb::WriteBatch rawBatch;
+        for (WriteBatch<Buffer, Buffer>::const_iterator it = batch.begin();
+                it != batch.end(); ++it)
+        {
+            ::leveldb::Slice key(it->key.data(), it->key.size());
+            if (it->type == BATCH_DEL)
+                rawBatch.Delete(key);
+            else
+                rawBatch.Put(key, ::leveldb::Slice(it->value.data(), it->value.size()));
+        }
+
+        return db_->Write(::leveldb::WriteOptions(), &rawBatch).ok();
+    }
+
     bool del(const Buffer& key)
     {
         return checkHandle_(db_) &&
@@ -13,6 +13,60 @@ namespace izenelib {
 namespace am {
 namespace lmdb {
 
+/**
+ * @brief View of a serialized record living in the LMDB memory map.
+ *
+ * Nothing is decoded until get() is called, so callers only checking
+ * presence or size, or forwarding raw bytes, never pay for
+ * izene_deserialization. Valid as long as the ReadTxn it came from.
+ */
+template<typename T>
+class MdbView
+{
+public:
+    MdbView()
+    {
+        val_.mv_size = 0;
+        val_.mv_data = NULL;
+    }
+
+    explicit MdbView(const MDB_val& val)
+        : val_(val)
+    {
+    }
+
+    const char* data() const
+    {
+        return static_cast<const char*>(val_.mv_data);
+    }
+
+    std::size_t size() const
+    {
+        return val_.mv_size;
+    }
+
+    const MDB_val& raw() const
+    {
+        return val_;
+    }
+
+    void get(T& value) const
+    {
+        izenelib::util::izene_deserialization<T> izd(data(), size());
+        izd.read_image(value);
+    }
+
+    T get() const
+    {
+        T value;
+        get(value);
+        return value;
+    }
+
+private:
+    MDB_val val_;
+};
+
 template<typename KeyType,
          typename ValueType >
 class Mdb
@@ -22,8 +76,11 @@ class Mdb
                                           ValueType>
 {
     typedef Mdb<KeyType, ValueType> self_type;
+    typedef izenelib::am::raw::AmWrapper<self_type, raw::Mdb, KeyType, ValueType> base_type;
 
 public:
+    using base_type::get;
+
     typedef KeyType key_type;
     typedef ValueType value_type;
     typedef DataType<KeyType, ValueType> data_type;
@@ -31,11 +88,75 @@ public:
 
     typedef raw::Mdb raw_am_type;
 
+    typedef raw::Mdb::ReadTxn read_txn_type;
+    typedef MdbView<KeyType> key_view_type;
+    typedef MdbView<ValueType> value_view_type;
+
     explicit Mdb(const std::string& file = "", unsigned int maxSizeInMb = 1024)
     : table_(file, maxSizeInMb)
     {
     }
 
+    /**
+     * @brief Get a view of the value of @p key without copying it.
+     *
+     * @param txn transaction created by @c read_txn_type txn(db.rawTable())
+     */
+    bool get(const read_txn_type& txn, const KeyType& key, value_view_type& view) const
+    {
+        izenelib::am::raw::Buffer keyBuffer;
+        izenelib::util::izene_serialization<KeyType> izsKey(key);
+        write_image(izsKey, keyBuffer);
+
+        MDB_val mvalue;
+        if (!txn.get(keyBuffer, mvalue))
+            return false;
+
+        view = value_view_type(mvalue);
+        return true;
+    }
+
+    /**
+     * @brief Call @p func(key_view, value_view) for each record with key in
+     * [@p lowKey, @p highKey] in database order, stop early when it returns
+     * false.
+     *
+     * @return number of records visited
+     */
+    template<typename Func>
+    std::size_t scan(const read_txn_type& txn,
+                     const KeyType& lowKey,
+                     const KeyType& highKey,
+                     Func func) const
+    {
+        izenelib::am::raw::Buffer lowBuffer;
+        izenelib::util::izene_serialization<KeyType> izsLow(lowKey);
+        write_image(izsLow, lowBuffer);
+
+        izenelib::am::raw::Buffer highBuffer;
+        izenelib::util::izene_serialization<KeyType> izsHigh(highKey);
+        write_image(izsHigh, highBuffer);
+        MDB_val high = {highBuffer.size(), highBuffer.data()};
+
+        std::size_t count = 0;
+        raw::Mdb::ViewCursor cursor(txn);
+        for (bool ok = cursor.seek(lowBuffer); ok; ok = cursor.next())
+        {
+            if (txn.compare(cursor.key(), high) > 0)
+                break;
+
+            ++count;
+            if (!func(key_view_type(cursor.key()), value_view_type(cursor.value())))
+                break;
+        }
+        return count;
+    }
+
+    const raw::Mdb& rawTable() const
+    {
+        return table_;
+    }
+
 private:
     raw::Mdb table_;
 
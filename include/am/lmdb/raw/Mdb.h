@@ -2,6 +2,7 @@
 #define AM_LMDB_RAW_MDB_H
 
 #include <am/concept/DataType.h>
+#include <am/concept/WriteBatch.h>
 #include <am/raw/Buffer.h>
 
 #include <3rdparty/am/lmdb/lmdb.h>
@@ -9,9 +10,11 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <glog/logging.h>
 #include <list>
+#include <vector>
 
 namespace izenelib {
 namespace am {
@@ -36,8 +39,10 @@ public:
     typedef Mdb* raw_type_ptr;
     typedef boost::interprocess::unique_ptr<MDB_txn, void(*)(MDB_txn*)> transaction_type;
 
+    enum { DEFAULT_READER_POOL_SIZE = 64 };
+
     explicit Mdb(const std::string& fullPath = "" , unsigned int maxSizeInMb = 1024 )
-        : dbi_(NULL),file_(fullPath)
+        : dbi_(NULL),file_(fullPath),readerPoolSize_(DEFAULT_READER_POOL_SIZE)
     {
         bfs::create_directories(fullPath);
         MDB_env* env = 0; 
@@ -47,13 +52,149 @@ public:
         rc = ::mdb_env_set_mapsize (env, maxSizeInMb * 1024 * 1024);
         if (rc) throw MdbEx (std::string ("mdb_env_set_mapsize: ") + ::strerror (rc));
         envConf (env);
-        rc = ::mdb_env_open (env, fullPath.c_str(), MDB_NOSYNC, 0664);
+        // MDB_NOTLS binds read txns to objects instead of threads, so that
+        // pooled readers can be renewed from any thread.
+        rc = ::mdb_env_open (env, fullPath.c_str(), MDB_NOSYNC | MDB_NOTLS, 0664);
         open ();
     }
 
     ~Mdb()
     {
         close();
+        clearReaders_();
+    }
+
+    /**
+     * @brief Read-only transaction handing out views into the memory map.
+     *
+     * The @c MDB_val results stay valid until the transaction is destroyed,
+     * no value is copied. The underlying @c MDB_txn comes from a pool of
+     * reset readers owned by the Mdb, so opening one is a renew rather than
+     * a fresh reader slot.
+     */
+    class ReadTxn : boost::noncopyable
+    {
+    public:
+        explicit ReadTxn(const Mdb& db)
+            : db_(db), txn_(db.acquireReader_())
+        {
+        }
+
+        ~ReadTxn()
+        {
+            db_.releaseReader_(txn_);
+        }
+
+        bool get(const MDB_val& key, MDB_val& value) const
+        {
+            MDB_val mkey = key;
+            return ::mdb_get (txn_, db_.dbi_, &mkey, &value) == 0;
+        }
+
+        bool get(const Buffer& key, MDB_val& value) const
+        {
+            MDB_val mkey = {key.size(), (void*) key.data()};
+            return get(mkey, value);
+        }
+
+        /** Compare two keys in the order of the database. */
+        int compare(const MDB_val& a, const MDB_val& b) const
+        {
+            return ::mdb_cmp (txn_, db_.dbi_, &a, &b);
+        }
+
+        MDB_txn* txn() const
+        {
+            return txn_;
+        }
+
+        MDB_dbi dbi() const
+        {
+            return db_.dbi_;
+        }
+
+    private:
+        const Mdb& db_;
+        MDB_txn* txn_;
+    };
+
+    /**
+     * @brief Cursor over a ReadTxn yielding key/value views in key order.
+     *
+     * Usage: @code
+     * Mdb::ViewCursor cursor(txn);
+     * for (bool ok = cursor.seek(low); ok; ok = cursor.next()) cursor.key() ...
+     * @endcode
+     */
+    class ViewCursor : boost::noncopyable
+    {
+    public:
+        explicit ViewCursor(const ReadTxn& txn)
+            : cursor_(NULL)
+        {
+            key_.mv_size = 0; key_.mv_data = NULL;
+            value_.mv_size = 0; value_.mv_data = NULL;
+            int rc = ::mdb_cursor_open (txn.txn(), txn.dbi(), &cursor_);
+            if (rc) throw MdbEx (std::string ("mdb_cursor_open: ") + ::strerror (rc));
+        }
+
+        ~ViewCursor()
+        {
+            ::mdb_cursor_close (cursor_);
+        }
+
+        bool first()
+        {
+            return move_(::MDB_FIRST);
+        }
+
+        /** Position at the first key not less than @p key. */
+        bool seek(const MDB_val& key)
+        {
+            key_ = key;
+            return move_(::MDB_SET_RANGE);
+        }
+
+        bool seek(const Buffer& key)
+        {
+            MDB_val mkey = {key.size(), (void*) key.data()};
+            return seek(mkey);
+        }
+
+        bool next()
+        {
+            return move_(::MDB_NEXT);
+        }
+
+        const MDB_val& key() const
+        {
+            return key_;
+        }
+
+        const MDB_val& value() const
+        {
+            return value_;
+        }
+
+    private:
+        bool move_(MDB_cursor_op op)
+        {
+            return ::mdb_cursor_get (cursor_, &key_, &value_, op) == 0;
+        }
+
+        MDB_cursor* cursor_;
+        MDB_val key_;
+        MDB_val value_;
+    };
+
+    /**
+     * @brief Upper bound of reset readers kept for reuse, the rest are
+     * aborted when released.
+     */
+    void setReaderPoolSize(std::size_t size)
+    {
+        boost::mutex::scoped_lock lock(readersMutex_);
+        readerPoolSize_ = size;
     }
 
     transaction_type beginTransaction (unsigned flags = 0) const
@@ -248,6 +389,68 @@ public:
         return true;
     }
 
+    /**
+     * @brief Get values of all @p keys inside a single read transaction.
+     *
+     * Values are copied out before the transaction ends.
+     *
+     * @return number of keys found, found[i] tells whether values[i] is set.
+     */
+    std::size_t multiGet(const std::vector<Buffer>& keys,
+                         std::vector<Buffer>& values,
+                         std::vector<bool>& found) const
+    {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+
+        transaction_type txn (beginTransaction (MDB_RDONLY));
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            MDB_val mkey = {keys[i].size(), (void*) keys[i].data()};
+            MDB_val mvalue;
+            if (::mdb_get (txn.get(), dbi_, &mkey, &mvalue)) continue;
+            values[i].copyAttach(static_cast<const char*>(mvalue.mv_data),
+                    static_cast<std::size_t>(mvalue.mv_size));
+            found[i] = true;
+            ++count;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Apply all operations inside a single write transaction.
+     *
+     * The batch is all-or-nothing: a failed operation, e.g. @c MDB_MAP_FULL,
+     * aborts the transaction and none of the batch is applied. Deleting a
+     * missing key is not a failure.
+     *
+     * @return true if the batch is committed
+     */
+    bool writeBatch(const WriteBatch<Buffer, Buffer>& batch)
+    {
+        transaction_type txn (beginTransaction());
+        for (WriteBatch<Buffer, Buffer>::const_iterator it = batch.begin();
+                it != batch.end(); ++it)
+        {
+            MDB_val mkey = {it->key.size(), (void*) it->key.data()};
+            int rc;
+            if (it->type == BATCH_DEL)
+            {
+                rc = ::mdb_del (txn.get(), dbi_, &mkey, NULL);
+            }
+            else
+            {
+                MDB_val mvalue = {it->value.size(), (void*) it->value.data()};
+                rc = ::mdb_put (txn.get(), dbi_, &mkey, &mvalue, 0);
+            }
+            if (rc == MDB_NOTFOUND && it->type == BATCH_DEL) continue;
+            if (rc) return false; // txn is aborted on destruction
+        }
+        commitTransaction (txn);
+        return true;
+    }
+
     bool del(const Buffer& key)
     {
         transaction_type txn (beginTransaction());
@@ -379,11 +582,59 @@ private:
         return h;
     }
 
+    MDB_txn* acquireReader_() const
+    {
+        MDB_txn* txn = NULL;
+        {
+            boost::mutex::scoped_lock lock(readersMutex_);
+            if (!readers_.empty())
+            {
+                txn = readers_.back();
+                readers_.pop_back();
+            }
+        }
+        if (txn)
+        {
+            int rc = ::mdb_txn_renew (txn);
+            if (rc == 0) return txn;
+            ::mdb_txn_abort (txn);
+        }
+        int rc = ::mdb_txn_begin (env_.get(), NULL, MDB_RDONLY, &txn);
+        if (rc) throw MdbEx (std::string ("mdb_txn_begin: ") + ::strerror (rc));
+        return txn;
+    }
+
+    void releaseReader_(MDB_txn* txn) const
+    {
+        ::mdb_txn_reset (txn);
+        {
+            boost::mutex::scoped_lock lock(readersMutex_);
+            if (readers_.size() < readerPoolSize_)
+            {
+                readers_.push_back(txn);
+                return;
+            }
+        }
+        ::mdb_txn_abort (txn);
+    }
+
+    void clearReaders_()
+    {
+        boost::mutex::scoped_lock lock(readersMutex_);
+        for (std::size_t i = 0; i < readers_.size(); ++i)
+            ::mdb_txn_abort (readers_[i]);
+        readers_.clear();
+    }
+
     boost::shared_ptr<MDB_env> env_;
 
     MDB_dbi dbi_;
 
     std::string file_;
+
+    mutable boost::mutex readersMutex_;
+    mutable std::vector<MDB_txn*> readers_;
+    std::size_t readerPoolSize_;
 };
 
 }}}} // namespace izenelib::am::lmdb::raw
@@ -0,0 +1,197 @@
+/**
+ * @brief The in memory counterpart of MtTrie: the terms are counted into a
+ *        concurrent adaptive radix tree as they are inserted, from any number
+ *        of threads, and searched at once, without the write cache, the
+ *        partitions and the merge of MtTrie::executeTask().
+ */
+
+#ifndef _CONCURRENT_MT_TRIE_H_
+#define _CONCURRENT_MT_TRIE_H_
+
+#include <am/concurrent/art.hpp>
+#include <util/string/automata/WildcardAutomaton.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+NS_IZENELIB_AM_BEGIN
+
+template <typename StringType>
+class ConcurrentMtTrie
+{
+public:
+    typedef typename StringType::value_type CharType;
+    typedef concurrent::ART<uint32_t> TrieType;
+
+public:
+    /**
+     * @brief Count one more occurrence of term, thread safe.
+     */
+    void insert(const StringType & term)
+    {
+        trie_.update((const char*)term.data(), term.length() * sizeof(CharType), 1, Increase());
+    }
+
+    /**
+     * @return the number of the insertions of term, 0 if never inserted.
+     */
+    uint32_t count(const StringType & term) const
+    {
+        uint32_t count = 0;
+        trie_.get((const char*)term.data(), term.length() * sizeof(CharType), count);
+        return count;
+    }
+
+    /**
+     * @brief Get a list of the most frequent keys which match the wildcard query,
+     * "*", "?", "[a-z]" as in WildcardAutomaton, legal input looks like "ea?th",
+     * "her*", or "*ear?h". The keys are read while they are inserted, so a key
+     * inserted during the search may or may not be found.
+     * @return true at leaset one result found.
+     *         false nothing found.
+     */
+    bool findRegExp(const StringType& regexp,
+        std::vector<StringType>& keyList,
+        int maximumResultNumber) const
+    {
+        izenelib::util::WildcardAutomaton<CharType> automaton;
+        if (!automaton.compile(regexp))
+            return false;
+
+        // only the keys beginning with the chars before the first wildcard
+        size_t literal = 0;
+        while (literal < regexp.length() && regexp[literal] != '*' && regexp[literal] != '?'
+                && regexp[literal] != '[' && regexp[literal] != '\\')
+            ++literal;
+
+        RegExpCollector collector(automaton, maximumResultNumber);
+        trie_.scanPrefix((const char*)regexp.data(), literal * sizeof(CharType), collector);
+        collector.getKeys(keyList);
+        return keyList.size()==0 ? false:true;
+    }
+
+    /**
+     * @brief Get a list of the most frequent keys beginning with prefix.
+     * @return true at leaset one result found.
+     */
+    bool findPrefix(const StringType& prefix,
+        std::vector<StringType>& keyList,
+        int maximumResultNumber) const
+    {
+        PrefixCollector collector(maximumResultNumber);
+        trie_.scanPrefix((const char*)prefix.data(), prefix.length() * sizeof(CharType), collector);
+        collector.getKeys(keyList);
+        return keyList.size()==0 ? false:true;
+    }
+
+    /**
+     * @return the number of distinct terms.
+     */
+    size_t size() const
+    {
+        return trie_.size();
+    }
+
+private:
+    struct Increase
+    {
+        void operator()(uint32_t& count) const { ++count; }
+    };
+
+    /// the most frequent keys visited, the first visited for the same count
+    class TopKeys
+    {
+    public:
+        explicit TopKeys(int max) : max_(max > 0 ? max : 0), order_(0) {}
+
+        void add(const char* key, size_t len, uint32_t count)
+        {
+            if (max_ == 0) return;
+            if (heap_.size() == max_)
+            {
+                if (!(Candidate(count, order_, std::string()) < heap_.front())) return;
+                std::pop_heap(heap_.begin(), heap_.end());
+                heap_.pop_back();
+            }
+            heap_.push_back(Candidate(count, order_++, std::string(key, len)));
+            std::push_heap(heap_.begin(), heap_.end());
+        }
+
+        void getKeys(std::vector<StringType>& keyList)
+        {
+            std::sort_heap(heap_.begin(), heap_.end());
+            for (size_t i = 0; i < heap_.size(); ++i)
+            {
+                const std::string& key = heap_[i].key;
+                keyList.push_back(StringType((const CharType*)key.data(), key.size() / sizeof(CharType)));
+            }
+        }
+
+    private:
+        /// ordered best first, so the heap keeps the worst on top
+        struct Candidate
+        {
+            Candidate(uint32_t c, size_t o, const std::string& k) : count(c), order(o), key(k) {}
+
+            bool operator<(const Candidate& other) const
+            {
+                return count != other.count ? count > other.count : order < other.order;
+            }
+
+            uint32_t count;
+            size_t order;
+            std::string key;
+        };
+
+        size_t max_;
+        size_t order_;
+        std::vector<Candidate> heap_;
+    };
+
+    class PrefixCollector : public TopKeys
+    {
+    public:
+        explicit PrefixCollector(int max) : TopKeys(max) {}
+
+        bool operator()(const char* key, size_t len, uint32_t count)
+        {
+            this->add(key, len, count);
+            return true;
+        }
+    };
+
+    class RegExpCollector : public TopKeys
+    {
+    public:
+        RegExpCollector(const izenelib::util::WildcardAutomaton<CharType>& automaton, int max)
+            : TopKeys(max), automaton_(automaton)
+        {
+        }
+
+        bool operator()(const char* key, size_t len, uint32_t count)
+        {
+            typename izenelib::util::WildcardAutomaton<CharType>::State state = automaton_.start();
+            for (size_t i = 0; i + sizeof(CharType) <= len; i += sizeof(CharType))
+            {
+                CharType c;
+                std::memcpy(&c, key + i, sizeof(CharType));
+                if (!automaton_.next(state, c, state)) return true;
+            }
+            if (automaton_.isFinal(state)) this->add(key, len, count);
+            return true;
+        }
+
+    private:
+        const izenelib::util::WildcardAutomaton<CharType>& automaton_;
+    };
+
+private:
+    TrieType trie_;
+};
+
+NS_IZENELIB_AM_END
+
+#endif
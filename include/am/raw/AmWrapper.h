@@ -12,7 +12,9 @@
 #include "WriteImage.h"
 
 #include <am/concept/DataType.h>
+#include <am/concept/WriteBatch.h>
 #include <iostream>
+#include <vector>
 namespace izenelib
 {
 namespace am
@@ -181,6 +183,83 @@ public:
 
         return status;
     }
+    /**
+     * @brief look up all @p keys with one call into the raw am.
+     *
+     * @return the number of keys found, found[i] tells whether values[i]
+     * has been filled.
+     */
+    std::size_t multiGet(const std::vector<key_type>& keys,
+                         std::vector<value_type>& values,
+                         std::vector<bool>& found) const
+    {
+        // serialize all keys into one arena instead of one malloc per key
+        std::string arena;
+        std::vector<std::size_t> offsets(keys.size() + 1, 0);
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            Buffer image;
+            izenelib::util::izene_serialization<key_type> izsKey(keys[i]);
+            write_image(izsKey, image);
+            arena.append(image.data(), image.size());
+            offsets[i + 1] = arena.size();
+        }
+
+        std::vector<Buffer> keyBuffers(keys.size());
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            keyBuffers[i].attach(const_cast<char*>(arena.data()) + offsets[i],
+                                 offsets[i + 1] - offsets[i]);
+        }
+
+        std::vector<Buffer> valueBuffers;
+        std::size_t count = rawAm().multiGet(keyBuffers, valueBuffers, found);
+
+        values.resize(keys.size());
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            if (found[i])
+            {
+                izenelib::util::izene_deserialization<value_type> izdValue(
+                    valueBuffers[i].data(), valueBuffers[i].size()
+                );
+                izdValue.read_image(values[i]);
+            }
+        }
+
+        return count;
+    }
+    /**
+     * @brief apply all operations in @p batch with one call into the raw am.
+     *
+     * @return true if every operation succeeded
+     */
+    bool writeBatch(const WriteBatch<key_type, value_type>& batch)
+    {
+        WriteBatch<Buffer, Buffer> rawBatch;
+        rawBatch.reserve(batch.size());
+
+        typedef typename WriteBatch<key_type, value_type>::const_iterator iterator;
+        for (iterator it = batch.begin(); it != batch.end(); ++it)
+        {
+            Buffer keyBuffer;
+            toBuffer_(it->key, keyBuffer);
+            if (it->type == BATCH_DEL)
+            {
+                rawBatch.del(keyBuffer);
+                continue;
+            }
+
+            Buffer valueBuffer;
+            toBuffer_(it->value, valueBuffer);
+            if (it->type == BATCH_INSERT)
+                rawBatch.insert(keyBuffer, valueBuffer);
+            else
+                rawBatch.update(keyBuffer, valueBuffer);
+        }
+
+        return rawAm().writeBatch(rawBatch);
+    }
     bool exist(const key_type& key) const
     {
         Buffer keyBuffer;
@@ -406,6 +485,17 @@ public:
 
 
 private:
+    /// the image written by izene_serialization only lives as long as the
+    /// serializer, so batch buffers keep their own copy.
+    template<typename T>
+    static void toBuffer_(const T& v, Buffer& buf)
+    {
+        Buffer image;
+        izenelib::util::izene_serialization<T> izs(v);
+        write_image(izs, image);
+        buf.copyAttach(image.data(), image.size());
+    }
+
     const raw_am_type& rawAm() const
     {
         return detail::AmWrapperAccess::rawAm<raw_am_type>(
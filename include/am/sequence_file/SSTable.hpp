@@ -0,0 +1,682 @@
+///
+/// @file SSTable.hpp
+/// @brief An immutable sorted string table: sorted key/value records packed
+/// into blocks with prefix-compressed keys, a sparse block index, an optional
+/// bloom filter and optional per-block compression.
+///
+/// File layout:
+///   [data block]...[bloom filter][block index][footer]
+/// Data block (before compression):
+///   {[varint shared][varint unshared][varint value len][key suffix][value]}...
+///   [uint32 restart offset]...[uint32 restart number]
+///   Keys are stored whole every restartInterval records (restart points) so a
+///   block can be binary searched.
+/// Stored block:
+///   [uint8 compressed][uint32 raw size][payload]
+/// Block index: one {[varint key len][last key][varint offset][varint size]}
+///   per data block.
+/// Footer: index offset, index size, bloom offset, bloom size, record number
+///   (uint64 each), compression type and magic (uint32 each).
+///
+
+#ifndef _SSTABLE_HPP_
+#define _SSTABLE_HPP_
+
+#include <types.h>
+#include <util/Exception.h>
+#include <util/hashFunction.h>
+#include <compression/compressor.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+NS_IZENELIB_AM_BEGIN
+
+enum SSTableCompression
+{
+    SSTABLE_NO_COMPRESSION = 0,
+    SSTABLE_LZO,
+    SSTABLE_LZ4,
+    SSTABLE_SNAPPY
+};
+
+struct SSTableOptions
+{
+    /// raw size of a data block before it is cut
+    uint32_t blockSize;
+    /// records between two whole keys in a block
+    uint32_t restartInterval;
+    /// 0 means no bloom filter
+    uint32_t bloomBitsPerKey;
+    SSTableCompression compression;
+
+    SSTableOptions()
+    : blockSize(4096), restartInterval(16), bloomBitsPerKey(10), compression(SSTABLE_NO_COMPRESSION)
+    {
+    }
+};
+
+namespace sstable_detail {
+
+static const uint32_t MAGIC = 0x5354424c;
+static const uint32_t FOOTER_SIZE = 5*sizeof(uint64_t) + 2*sizeof(uint32_t);
+static const uint32_t BLOCK_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint32_t);
+
+inline void putVarint(std::string& dst, uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        dst.push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    dst.push_back((char)v);
+}
+
+inline const char* getVarint(const char* p, const char* limit, uint64_t& v)
+{
+    v = 0;
+    for (uint32_t shift = 0; shift <= 63 && p < limit; shift += 7)
+    {
+        uint64_t byte = (unsigned char)*p++;
+        v |= (byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return p;
+    }
+    return NULL;
+}
+
+template <typename T>
+inline void putFixed(std::string& dst, T v)
+{
+    dst.append((const char*)&v, sizeof(T));
+}
+
+template <typename T>
+inline T getFixed(const char* p)
+{
+    T v;
+    memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+inline int compareKey(const char* a, size_t alen, const char* b, size_t blen)
+{
+    int r = memcmp(a, b, std::min(alen, blen));
+    if (r != 0)
+        return r;
+    return alen < blen ? -1 : (alen > blen ? 1 : 0);
+}
+
+inline Compressor* newCompressor(SSTableCompression type)
+{
+    switch (type)
+    {
+    case SSTABLE_LZO:
+        return new LzoCompressor;
+    case SSTABLE_LZ4:
+        return new Lz4Compressor;
+    case SSTABLE_SNAPPY:
+        return new SnappyCompressor;
+    default:
+        return NULL;
+    }
+}
+
+/// probes of a key, Kirsch-Mitzenmacher double hashing over one 64 bits hash
+inline uint64_t bloomHash(const std::string& key)
+{
+    return izenelib::util::MurmurHash64A(key.data(), key.size(), 0x5354424cULL);
+}
+
+inline uint32_t bloomProbes(uint32_t bitsPerKey)
+{
+    uint32_t k = (uint32_t)(bitsPerKey * 0.69);
+    return k < 1 ? 1 : (k > 30 ? 30 : k);
+}
+
+}
+
+class SSTableWriter : private boost::noncopyable
+{
+public:
+    SSTableWriter(const std::string& file, const SSTableOptions& options = SSTableOptions())
+    : file_(file), options_(options), isOpen_(false), offset_(0), count_(0), blockCount_(0)
+    {
+        if (options_.restartInterval == 0)
+            options_.restartInterval = 1;
+    }
+
+    ~SSTableWriter()
+    {
+        close();
+    }
+
+    void open()
+    {
+        if (isOpen()) return;
+        stream_.open(file_.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!stream_.is_open())
+        {
+            IZENELIB_THROW("SSTableWriter open on "+file_);
+        }
+        compressor_.reset(sstable_detail::newCompressor(options_.compression));
+        offset_ = count_ = 0;
+        blockCount_ = 0;
+        lastKey_.clear();
+        block_.clear();
+        restarts_.clear();
+        index_.clear();
+        hashes_.clear();
+        isOpen_ = true;
+    }
+
+    bool isOpen() const
+    {
+        return isOpen_;
+    }
+
+    /**
+     * @brief appends a record, keys must be added in strictly increasing
+     * bytewise order.
+     * @return false if @p key is not greater than the previous one
+     */
+    bool add(const std::string& key, const std::string& value)
+    {
+        if (!isOpen()) return false;
+        if (count_ > 0 && sstable_detail::compareKey(key.data(), key.size(), lastKey_.data(), lastKey_.size()) <= 0)
+            return false;
+
+        size_t shared = 0;
+        if (blockCount_ % options_.restartInterval == 0)
+        {
+            restarts_.push_back(block_.size());
+        }
+        else
+        {
+            size_t limit = std::min(key.size(), lastKey_.size());
+            while (shared < limit && key[shared] == lastKey_[shared])
+                ++shared;
+        }
+
+        sstable_detail::putVarint(block_, shared);
+        sstable_detail::putVarint(block_, key.size() - shared);
+        sstable_detail::putVarint(block_, value.size());
+        block_.append(key.data() + shared, key.size() - shared);
+        block_.append(value);
+
+        lastKey_ = key;
+        ++blockCount_;
+        ++count_;
+        if (options_.bloomBitsPerKey > 0)
+            hashes_.push_back(sstable_detail::bloomHash(key));
+
+        if (block_.size() >= options_.blockSize)
+            flushBlock_();
+        return true;
+    }
+
+    uint64_t getItemCount() const
+    {
+        return count_;
+    }
+
+    void close()
+    {
+        if (!isOpen()) return;
+        flushBlock_();
+
+        uint64_t bloomOffset = offset_;
+        std::string bloom;
+        if (!hashes_.empty())
+        {
+            uint64_t bits = std::max<uint64_t>(64, hashes_.size() * options_.bloomBitsPerKey);
+            bits = (bits + 7) / 8 * 8;
+            bloom.assign(bits / 8, '\0');
+            uint32_t probes = sstable_detail::bloomProbes(options_.bloomBitsPerKey);
+            for (size_t i = 0; i < hashes_.size(); ++i)
+            {
+                uint64_t h = hashes_[i];
+                uint64_t delta = (h >> 33) | (h << 31);
+                for (uint32_t j = 0; j < probes; ++j, h += delta)
+                    bloom[(h % bits) / 8] |= (char)(1 << ((h % bits) % 8));
+            }
+            bloom.push_back((char)probes);
+        }
+        write_(bloom);
+
+        uint64_t indexOffset = offset_;
+        write_(index_);
+
+        std::string footer;
+        sstable_detail::putFixed<uint64_t>(footer, indexOffset);
+        sstable_detail::putFixed<uint64_t>(footer, index_.size());
+        sstable_detail::putFixed<uint64_t>(footer, bloomOffset);
+        sstable_detail::putFixed<uint64_t>(footer, bloom.size());
+        sstable_detail::putFixed<uint64_t>(footer, count_);
+        sstable_detail::putFixed<uint32_t>(footer, options_.compression);
+        sstable_detail::putFixed<uint32_t>(footer, sstable_detail::MAGIC);
+        write_(footer);
+
+        stream_.close();
+        std::vector<uint64_t>().swap(hashes_);
+        isOpen_ = false;
+    }
+
+private:
+    void write_(const std::string& data)
+    {
+        stream_.write(data.data(), data.size());
+        if (stream_.fail())
+        {
+            IZENELIB_THROW("SSTableWriter write on "+file_);
+        }
+        offset_ += data.size();
+    }
+
+    void flushBlock_()
+    {
+        if (blockCount_ == 0) return;
+
+        for (size_t i = 0; i < restarts_.size(); ++i)
+            sstable_detail::putFixed<uint32_t>(block_, restarts_[i]);
+        sstable_detail::putFixed<uint32_t>(block_, restarts_.size());
+
+        std::string stored;
+        stored.push_back('\0');
+        sstable_detail::putFixed<uint32_t>(stored, block_.size());
+        if (compressor_)
+        {
+            compressed_.resize(compressor_->compressBound(block_.size()));
+            size_t len = compressed_.size();
+            //keep the block raw unless it saves at least 1/8
+            if (compressor_->compress((const unsigned char*)block_.data(), block_.size(),
+                                      (unsigned char*)&compressed_[0], len)
+                && len < block_.size() - block_.size() / 8)
+            {
+                stored[0] = 1;
+                stored.append(compressed_.data(), len);
+            }
+        }
+        if (stored[0] == 0)
+            stored.append(block_);
+
+        sstable_detail::putVarint(index_, lastKey_.size());
+        index_.append(lastKey_);
+        sstable_detail::putVarint(index_, offset_);
+        sstable_detail::putVarint(index_, stored.size());
+        write_(stored);
+
+        block_.clear();
+        restarts_.clear();
+        blockCount_ = 0;
+    }
+
+private:
+    std::string file_;
+    SSTableOptions options_;
+    bool isOpen_;
+    std::ofstream stream_;
+    boost::scoped_ptr<Compressor> compressor_;
+
+    uint64_t offset_;
+    uint64_t count_;
+    uint32_t blockCount_;
+    std::string lastKey_;
+    std::string block_;
+    std::vector<uint32_t> restarts_;
+    std::string compressed_;
+    std::string index_;
+    std::vector<uint64_t> hashes_;
+};
+
+class SSTableReader : private boost::noncopyable
+{
+    struct IndexEntry
+    {
+        std::string lastKey;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    struct IndexLess
+    {
+        bool operator()(const IndexEntry& e, const std::string& key) const
+        {
+            return sstable_detail::compareKey(e.lastKey.data(), e.lastKey.size(), key.data(), key.size()) < 0;
+        }
+    };
+
+    /// a decompressed data block
+    struct Block
+    {
+        std::string data;
+        uint32_t restartOffset;
+        uint32_t restartNum;
+
+        uint32_t restart(uint32_t i) const
+        {
+            return sstable_detail::getFixed<uint32_t>(data.data() + restartOffset + i * sizeof(uint32_t));
+        }
+    };
+
+public:
+    /**
+     * @brief a cursor over the records in key order. Cursors are not thread
+     * safe, but any number of them may be used at once on one reader.
+     */
+    class Iterator
+    {
+    public:
+        explicit Iterator(const SSTableReader* reader)
+        : reader_(reader), blockIdx_(0), next_(0), valid_(false)
+        {
+        }
+
+        bool valid() const
+        {
+            return valid_;
+        }
+
+        const std::string& key() const
+        {
+            return key_;
+        }
+
+        const std::string& value() const
+        {
+            return value_;
+        }
+
+        void seekToFirst()
+        {
+            valid_ = false;
+            if (reader_->index_.empty()) return;
+            loadBlock_(0);
+            next_ = 0;
+            key_.clear();
+            parseNext_();
+        }
+
+        /// positions at the first record whose key is not less than @p target
+        void seek(const std::string& target)
+        {
+            valid_ = false;
+            std::vector<IndexEntry>::const_iterator it = std::lower_bound(
+                reader_->index_.begin(), reader_->index_.end(), target, IndexLess());
+            if (it == reader_->index_.end()) return;
+            loadBlock_(it - reader_->index_.begin());
+
+            //the last restart point whose key is less than target
+            uint32_t left = 0, right = block_.restartNum - 1;
+            while (left < right)
+            {
+                uint32_t mid = (left + right + 1) / 2;
+                next_ = block_.restart(mid);
+                key_.clear();
+                parseNext_();
+                if (sstable_detail::compareKey(key_.data(), key_.size(), target.data(), target.size()) < 0)
+                    left = mid;
+                else
+                    right = mid - 1;
+            }
+
+            next_ = block_.restart(left);
+            key_.clear();
+            for (parseNext_(); valid_; next())
+            {
+                if (sstable_detail::compareKey(key_.data(), key_.size(), target.data(), target.size()) >= 0)
+                    return;
+            }
+        }
+
+        void next()
+        {
+            if (!valid_) return;
+            if (next_ >= block_.restartOffset)
+            {
+                valid_ = false;
+                if (blockIdx_ + 1 >= reader_->index_.size()) return;
+                loadBlock_(blockIdx_ + 1);
+                next_ = 0;
+                key_.clear();
+            }
+            parseNext_();
+        }
+
+    private:
+        void loadBlock_(size_t idx)
+        {
+            blockIdx_ = idx;
+            reader_->readBlock_(idx, block_);
+        }
+
+        void parseNext_()
+        {
+            const char* p = block_.data.data() + next_;
+            const char* limit = block_.data.data() + block_.restartOffset;
+            uint64_t shared, unshared, vlen;
+            if (p >= limit
+                || !(p = sstable_detail::getVarint(p, limit, shared))
+                || !(p = sstable_detail::getVarint(p, limit, unshared))
+                || !(p = sstable_detail::getVarint(p, limit, vlen))
+                || shared > key_.size() || p + unshared + vlen > limit)
+            {
+                valid_ = false;
+                return;
+            }
+            key_.resize(shared);
+            key_.append(p, unshared);
+            value_.assign(p + unshared, vlen);
+            next_ = p + unshared + vlen - block_.data.data();
+            valid_ = true;
+        }
+
+    private:
+        const SSTableReader* reader_;
+        Block block_;
+        size_t blockIdx_;
+        uint32_t next_;
+        bool valid_;
+        std::string key_;
+        std::string value_;
+    };
+
+    explicit SSTableReader(const std::string& file)
+    : file_(file), fd_(-1), count_(0), bloomBits_(0), bloomProbes_(0)
+    {
+    }
+
+    ~SSTableReader()
+    {
+        close();
+    }
+
+    void open()
+    {
+        if (isOpen()) return;
+        fd_ = ::open(file_.c_str(), O_RDONLY);
+        if (fd_ < 0)
+        {
+            IZENELIB_THROW("SSTableReader open on "+file_);
+        }
+
+        off_t size = lseek(fd_, 0, SEEK_END);
+        std::string footer;
+        if (size < (off_t)sstable_detail::FOOTER_SIZE
+            || !read_(size - sstable_detail::FOOTER_SIZE, sstable_detail::FOOTER_SIZE, footer)
+            || sstable_detail::getFixed<uint32_t>(&footer[sstable_detail::FOOTER_SIZE - sizeof(uint32_t)]) != sstable_detail::MAGIC)
+        {
+            close();
+            IZENELIB_THROW("SSTableReader bad footer on "+file_);
+        }
+
+        const char* p = footer.data();
+        uint64_t indexOffset = sstable_detail::getFixed<uint64_t>(p);
+        uint64_t indexSize = sstable_detail::getFixed<uint64_t>(p + 8);
+        uint64_t bloomOffset = sstable_detail::getFixed<uint64_t>(p + 16);
+        uint64_t bloomSize = sstable_detail::getFixed<uint64_t>(p + 24);
+        count_ = sstable_detail::getFixed<uint64_t>(p + 32);
+        compressor_.reset(sstable_detail::newCompressor(
+            (SSTableCompression)sstable_detail::getFixed<uint32_t>(p + 40)));
+
+        std::string index;
+        if (!read_(indexOffset, indexSize, index) || !read_(bloomOffset, bloomSize, bloom_))
+        {
+            close();
+            IZENELIB_THROW("SSTableReader read index on "+file_);
+        }
+        if (!bloom_.empty())
+        {
+            bloomProbes_ = (unsigned char)bloom_[bloom_.size() - 1];
+            bloom_.resize(bloom_.size() - 1);
+            bloomBits_ = bloom_.size() * 8;
+        }
+
+        const char* q = index.data();
+        const char* limit = q + index.size();
+        while (q < limit)
+        {
+            IndexEntry e;
+            uint64_t klen;
+            if (!(q = sstable_detail::getVarint(q, limit, klen)) || q + klen > limit)
+                break;
+            e.lastKey.assign(q, klen);
+            q += klen;
+            if (!(q = sstable_detail::getVarint(q, limit, e.offset))
+                || !(q = sstable_detail::getVarint(q, limit, e.size)))
+                break;
+            index_.push_back(e);
+        }
+    }
+
+    bool isOpen() const
+    {
+        return fd_ >= 0;
+    }
+
+    void close()
+    {
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        index_.clear();
+        bloom_.clear();
+        bloomBits_ = 0;
+    }
+
+    uint64_t getItemCount() const
+    {
+        return count_;
+    }
+
+    size_t getBlockCount() const
+    {
+        return index_.size();
+    }
+
+    /// false means @p key is surely absent
+    bool mayContain(const std::string& key) const
+    {
+        if (bloomBits_ == 0) return true;
+        uint64_t h = sstable_detail::bloomHash(key);
+        uint64_t delta = (h >> 33) | (h << 31);
+        for (uint32_t j = 0; j < bloomProbes_; ++j, h += delta)
+        {
+            uint64_t bit = h % bloomBits_;
+            if (!(bloom_[bit / 8] & (1 << (bit % 8))))
+                return false;
+        }
+        return true;
+    }
+
+    /// point lookup, reads at most one data block
+    bool get(const std::string& key, std::string& value) const
+    {
+        if (!isOpen() || !mayContain(key)) return false;
+        Iterator it(this);
+        it.seek(key);
+        if (!it.valid() || it.key() != key) return false;
+        value = it.value();
+        return true;
+    }
+
+    /// visits the records in [low, high) in key order until @p func returns false
+    template <typename Func>
+    void scan(const std::string& low, const std::string& high, Func func) const
+    {
+        if (!isOpen()) return;
+        Iterator it(this);
+        for (it.seek(low); it.valid(); it.next())
+        {
+            if (sstable_detail::compareKey(it.key().data(), it.key().size(), high.data(), high.size()) >= 0)
+                break;
+            if (!func(it.key(), it.value()))
+                break;
+        }
+    }
+
+private:
+    bool read_(uint64_t offset, uint64_t size, std::string& data) const
+    {
+        data.resize(size);
+        if (size == 0) return true;
+        return pread(fd_, &data[0], size, offset) == (ssize_t)size;
+    }
+
+    void readBlock_(size_t idx, Block& block) const
+    {
+        const IndexEntry& e = index_[idx];
+        std::string stored;
+        if (e.size < sstable_detail::BLOCK_HEADER_SIZE || !read_(e.offset, e.size, stored))
+        {
+            IZENELIB_THROW("SSTableReader read block on "+file_);
+        }
+
+        uint32_t rawSize = sstable_detail::getFixed<uint32_t>(stored.data() + 1);
+        if (stored[0] == 0)
+        {
+            block.data.assign(stored, sstable_detail::BLOCK_HEADER_SIZE, std::string::npos);
+        }
+        else
+        {
+            block.data.resize(rawSize);
+            if (!compressor_ || !compressor_->decompress(
+                    (const unsigned char*)stored.data() + sstable_detail::BLOCK_HEADER_SIZE,
+                    stored.size() - sstable_detail::BLOCK_HEADER_SIZE,
+                    (unsigned char*)&block.data[0], rawSize))
+            {
+                IZENELIB_THROW("SSTableReader decompress block on "+file_);
+            }
+        }
+
+        if (block.data.size() < sizeof(uint32_t))
+        {
+            IZENELIB_THROW("SSTableReader corrupted block on "+file_);
+        }
+        block.restartNum = sstable_detail::getFixed<uint32_t>(block.data.data() + block.data.size() - sizeof(uint32_t));
+        block.restartOffset = block.data.size() - (block.restartNum + 1) * sizeof(uint32_t);
+    }
+
+private:
+    std::string file_;
+    int fd_;
+    uint64_t count_;
+    std::vector<IndexEntry> index_;
+    std::string bloom_;
+    uint64_t bloomBits_;
+    uint32_t bloomProbes_;
+    boost::scoped_ptr<Compressor> compressor_;
+};
+
+NS_IZENELIB_AM_END
+#endif
@@ -0,0 +1,214 @@
+#ifndef _IZENELIB_AM_SUCCINCT_CBITV_CBITV_HPP
+#define _IZENELIB_AM_SUCCINCT_CBITV_CBITV_HPP
+
+#include <am/succinct/constants.hpp>
+#include <am/succinct/utils.hpp>
+#include <am/succinct/mapped_vector.hpp>
+
+#include <boost/shared_array.hpp>
+#include <vector>
+#include <iostream>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+
+NS_IZENELIB_AM_BEGIN
+
+namespace succinct
+{
+namespace cbitv
+{
+
+/**
+ * A rank/select bit vector that answers rank with one cache line.
+ *
+ * The bits are stored in cache aligned blocks of 64 bytes, each holding a
+ * header word and 7 words of bits. The header packs the rank of the block in
+ * the low 47 bits, then the ones in the first 2 and in the first 4 words of
+ * the block, so rank1() reads one block and counts at most 3 words.
+ *
+ * select1() and select0() start from the block of every kSelectSample-th one
+ * (or zero), search the blocks up to the next sample by their ranks, and finish
+ * in the word with PDEP when built for BMI2, or broadword select otherwise.
+ *
+ * It has the interface of dense::DBitV, so it can be the bitmap of the wavelet
+ * trees and the FM-index.
+ */
+class CBitV
+{
+public:
+    static const size_t kWordPerBlock = 7;
+    static const size_t kBitPerBlock = kWordPerBlock * kBlockSize;
+    static const size_t kSelectSample = 1024;
+
+    CBitV(bool support_select);
+    ~CBitV();
+
+    void build(const std::vector<uint64_t> &bv, size_t len);
+    void clear();
+
+    inline bool access(size_t pos) const
+    {
+        __assert(pos < len_);
+
+        const Block &block = blocks_[pos / kBitPerBlock];
+        size_t offset = pos % kBitPerBlock;
+
+        return block.bits_[offset / kBlockSize] >> (offset % kBlockSize) & 1ULL;
+    }
+
+    inline bool access(size_t pos, size_t &r) const
+    {
+        __assert(pos < len_);
+
+        size_t rank = rank1(pos);
+        if (access(pos))
+        {
+            r = rank;
+            return true;
+        }
+        else
+        {
+            r = pos - rank;
+            return false;
+        }
+    }
+
+    inline size_t rank0(size_t pos) const
+    {
+        return pos - rank1(pos);
+    }
+
+    inline size_t rank1(size_t pos) const
+    {
+        __assert(pos <= len_);
+
+        const Block &block = blocks_[pos / kBitPerBlock];
+        size_t offset = pos % kBitPerBlock;
+        size_t word = offset / kBlockSize;
+
+        size_t start;
+        size_t rank = blockRank_(block, word, start);
+        for (; start < word; ++start)
+        {
+            rank += SuccinctUtils::popcount(block.bits_[start]);
+        }
+
+        return rank + SuccinctUtils::popcount(block.bits_[word] & ((1ULL << (offset % kBlockSize)) - 1));
+    }
+
+    inline size_t rank(size_t pos, bool bit) const
+    {
+        return bit ? rank1(pos) : rank0(pos);
+    }
+
+    /// prefetches the block of @p pos, ahead of a rank at @p pos
+    inline void prefetch(size_t pos) const
+    {
+        __builtin_prefetch(blocks_.get() + pos / kBitPerBlock);
+    }
+
+    size_t select0(size_t ind) const;
+    size_t select1(size_t ind) const;
+    size_t select(size_t ind, bool bit) const;
+
+    void save(std::ostream &os) const;
+    void load(std::istream &is);
+
+    /// writes the aligned layout, which map() views in place
+    void saveAligned(AlignedWriter &writer) const;
+    void map(MappedReader &reader);
+
+    inline size_t length() const
+    {
+        return len_;
+    }
+
+    inline size_t one_count() const
+    {
+        return one_count_;
+    }
+
+    inline size_t zero_count() const
+    {
+        return len_ - one_count_;
+    }
+
+    size_t allocSize() const;
+
+private:
+    struct Block
+    {
+        /// rank (47 bits) | ones in words [0, 2) (8 bits) | ones in words [0, 4) (9 bits)
+        uint64_t header_;
+        uint64_t bits_[kWordPerBlock];
+    };
+
+    static const size_t kRankBits = 47;
+    static const uint64_t kRankMask = (1ULL << kRankBits) - 1;
+
+    static inline uint64_t rankOf_(const Block &block)
+    {
+        return block.header_ & kRankMask;
+    }
+
+    static inline size_t count2Of_(const Block &block)
+    {
+        return block.header_ >> kRankBits & 0xff;
+    }
+
+    static inline size_t count4Of_(const Block &block)
+    {
+        return block.header_ >> (kRankBits + 8);
+    }
+
+    /// ones before the nearest counted word not after @p word, which is set to @p start
+    static inline size_t blockRank_(const Block &block, size_t word, size_t &start)
+    {
+        if (word < 2)
+        {
+            start = 0;
+            return rankOf_(block);
+        }
+        if (word < 4)
+        {
+            start = 2;
+            return rankOf_(block) + count2Of_(block);
+        }
+        start = 4;
+        return rankOf_(block) + count4Of_(block);
+    }
+
+    static inline size_t selectWord_(uint64_t word, size_t r)
+    {
+#ifdef __BMI2__
+        return __builtin_ctzll(_pdep_u64(1ULL << r, word));
+#else
+        return SuccinctUtils::selectBlock(word, r);
+#endif
+    }
+
+    inline size_t blockNum_() const
+    {
+        return len_ / kBitPerBlock + 1;
+    }
+
+    bool support_select_;
+    size_t len_;
+    size_t one_count_;
+
+    boost::shared_array<Block> blocks_;
+
+    /// the block of every kSelectSample-th one and zero, ended by the last block
+    MappedVector<size_t> select_one_inds_;
+    MappedVector<size_t> select_zero_inds_;
+};
+
+}
+}
+
+NS_IZENELIB_AM_END
+
+#endif
@@ -2,6 +2,7 @@
 #define _IZENELIB_AM_SUCCINCT_DBITV_DBITV_HPP
 
 #include <am/succinct/constants.hpp>
+#include <am/succinct/mapped_vector.hpp>
 
 #include <boost/shared_array.hpp>
 #include <vector>
@@ -31,6 +32,12 @@ public:
     size_t rank1(size_t pos) const;
     size_t rank(size_t pos, bool bit) const;
 
+    /// prefetches the super block of @p pos, ahead of a rank at @p pos
+    inline void prefetch(size_t pos) const
+    {
+        __builtin_prefetch(super_blocks_.get() + pos / kSuperBlockSize);
+    }
+
     size_t select0(size_t ind) const;
     size_t select1(size_t ind) const;
     size_t select(size_t ind, bool bit) const;
@@ -38,6 +45,10 @@ public:
     void save(std::ostream &os) const;
     void load(std::istream &is);
 
+    /// writes the aligned layout, which map() views in place
+    void saveAligned(AlignedWriter &writer) const;
+    void map(MappedReader &reader);
+
     inline size_t length() const
     {
         return len_;
@@ -73,8 +84,8 @@ private:
 
     boost::shared_array<SuperBlock> super_blocks_;
 
-    std::vector<size_t> select_one_inds_;
-    std::vector<size_t> select_zero_inds_;
+    MappedVector<size_t> select_one_inds_;
+    MappedVector<size_t> select_zero_inds_;
 };
 
 }
@@ -14,6 +14,9 @@ namespace fm_index
 static const uint8_t DOC_DELIM = 003;
 static const size_t DEFAULT_TOP_K = 1024;
 
+/// rank queries a wavelet tree runs in lockstep, see WaveletTreeHuffman::rankBatch()
+static const size_t RANK_BATCH_SIZE = 64;
+
 }
 }
 
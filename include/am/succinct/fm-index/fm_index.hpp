@@ -4,7 +4,11 @@
 #include "wavelet_tree_huffman.hpp"
 #include "wavelet_matrix.hpp"
 #include "custom_int.hpp"
+#include "parallel_bwt_builder.hpp"
+#include "topk_doc_index.hpp"
 #include <am/succinct/rsdic/RSDic.hpp>
+#include <am/succinct/dbitv/dbitv.hpp>
+#include <am/succinct/cbitv/cbitv.hpp>
 #include <am/succinct/sdarray/SDArray.hpp>
 #include <am/succinct/sais/sais.hxx>
 
@@ -19,16 +23,21 @@ namespace succinct
 namespace fm_index
 {
 
-template <class CharT>
+/**
+ * @p BwtBitmapT and @p DocArrayBitmapT are the bitmaps of the BWT wavelet tree and
+ * of the doc array wavelet matrix, any of rsdic::RSDic, dense::DBitV and cbitv::CBitV.
+ * The saved index depends on them.
+ */
+template <class CharT, class BwtBitmapT = rsdic::RSDic, class DocArrayBitmapT = dense::DBitV>
 class FMIndex
 {
 public:
     typedef CharT char_type;
-    typedef FMIndex<CharT> self_type;
+    typedef FMIndex<CharT, BwtBitmapT, DocArrayBitmapT> self_type;
     typedef std::pair<size_t, size_t> MatchRangeT;
     typedef std::vector<MatchRangeT> MatchRangeListT;
-    typedef WaveletMatrix<uint32_t, dense::DBitV> docarray_type;
-    typedef WaveletTreeHuffman<char_type, rsdic::RSDic> bwt_type;
+    typedef WaveletMatrix<uint32_t, DocArrayBitmapT> docarray_type;
+    typedef WaveletTreeHuffman<char_type, BwtBitmapT> bwt_type;
 
     FMIndex();
     ~FMIndex();
@@ -39,10 +48,50 @@ public:
     void swapOrigText(std::vector<char_type> &orig_text);
 
     void build();
+
+    /**
+     * builds with the suffixes sorted in blocks of @p block_len chars on @p thread_num
+     * threads, then merged from runs in @p work_dir, see ParallelBWTBuilder.
+     * There is no suffix array of the whole text, so making the BWT takes about half of
+     * the memory of build(); the order of suffixes equal up to their DOC_DELIM differs.
+     * The text is kept until the doc array is read back from @p work_dir.
+     * @return false if a run or the doc array could not be written or read, the
+     * documents added are kept for another build
+     */
+    bool buildParallel(size_t thread_num = 0, size_t block_len = 0, const std::string &work_dir = "");
+
+    /**
+     * makes build() build a TopKDocIndex too, keeping the @p max_k most frequent docs
+     * of sampled suffix ranges, see getTopKDocIdListByFreq(). It takes an LCP array
+     * of the text during build(); 0 @p max_k builds none, and buildParallel() none.
+     */
+    void setTopKDocIndex(size_t max_k, size_t sample_len = 0);
     void reconstructText(const std::vector<uint32_t> &del_docid_list, std::vector<char_type> &orig_text) const;
 
     size_t backwardSearch(const char_type *pattern, size_t len, MatchRangeT &match_range) const;
     size_t longestSuffixMatch(const char_type *patter, size_t len, MatchRangeListT &match_ranges) const;
+
+    /**
+     * runs backwardSearch() on each of @p pattern_list, setting the matched length
+     * and the match range of each pattern.
+     *
+     * The searches advance in lockstep, a step of each taking its rank queries
+     * together through bwt_type::rankBatch(), so the cache misses of many patterns
+     * overlap. It pays when there are tens or hundreds of patterns.
+     */
+    void backwardSearch(
+            const std::vector<std::vector<char_type> > &pattern_list,
+            std::vector<size_t> &match_len_list,
+            MatchRangeListT &match_ranges) const;
+
+    /**
+     * runs longestSuffixMatch() on each of @p pattern_list in lockstep, as the batched
+     * backwardSearch() does.
+     */
+    void longestSuffixMatch(
+            const std::vector<std::vector<char_type> > &pattern_list,
+            std::vector<size_t> &max_match_list,
+            std::vector<MatchRangeListT> &match_ranges_list) const;
     size_t length() const;
     //size_t allocSize() const;
 
@@ -52,6 +101,23 @@ public:
     void save(std::ostream &ostr) const;
     void load(std::istream &istr);
 
+    /**
+     * writes the index in the aligned layout, which map() opens without reading it:
+     * the bitmaps and the doc delimiters are used in place in the mapped file, so
+     * opening takes about as long as walking the tree shape, and the processes
+     * mapping the same file share its pages. The layout differs from save().
+     */
+    void saveAligned(std::ostream &ostr) const;
+    void saveAligned(AlignedWriter &writer) const;
+
+    /**
+     * opens the index saved by saveAligned(std::ostream &) in @p path, returns false,
+     * leaving the index unchanged, if it can not be mapped: a file of another format
+     * or truncated.
+     */
+    bool map(const std::string &path);
+    void map(MappedReader &reader);
+
     void saveOriginalText(std::ostream &ostr) const;
     void loadOriginalText(std::istream &istr);
 
@@ -67,6 +133,24 @@ public:
             std::vector<std::pair<double, uint32_t> > &res_list,
             std::vector<size_t> &doclen_list) const;
 
+    /**
+     * gets the @p max_docs docs with the most occurrences in @p match_range, and
+     * their numbers of occurrences, most first.
+     *
+     * With the TopKDocIndex of setTopKDocIndex() and @p max_docs no more than its
+     * max_k, it takes about O(max_k + sample_len) queries on the doc array for any
+     * match range; otherwise it counts the doc of every occurrence.
+     */
+    void getTopKDocIdListByFreq(
+            const MatchRangeT &match_range,
+            size_t max_docs,
+            std::vector<std::pair<size_t, uint32_t> > &res_list,
+            std::vector<size_t> &doclen_list) const;
+
+    /// saves the TopKDocIndex apart, after save() or saveAligned(); load() and map() drop it
+    void saveTopKDocIndex(std::ostream &ostr) const;
+    void loadTopKDocIndex(std::istream &istr);
+
     void getDocLenList(const std::vector<uint32_t>& docid_list, std::vector<size_t>& doclen_list) const;
 
     sdarray::SDArray& getDocDelim()
@@ -86,22 +170,47 @@ private:
     boost::shared_ptr<docarray_type> doc_array_;
     boost::shared_ptr<bwt_type> bwt_tree_;
 
+    size_t topk_max_k_;
+    size_t topk_sample_len_;
+    boost::shared_ptr<TopKDocIndex> topk_index_;
+
+    void buildDocDelim_();
+    void cancelBuild_();
+    void buildLcp_(const std::vector<int40_t> &sa, std::vector<uint32_t> &lcp) const;
+
+    /// the state of a longestSuffixMatch() run by the batched one
+    struct SuffixMatch
+    {
+        const std::vector<char_type> *pattern;
+        size_t i, j;                ///< matching pattern[j, i)
+        size_t sp, ep;
+        MatchRangeT match_range;
+        MatchRangeListT prune_bounds;
+        size_t max_match;
+        MatchRangeListT *match_ranges;
+    };
+
+    bool startSuffixMatch_(SuffixMatch &state) const;
+    void endSuffixMatch_(SuffixMatch &state) const;
+    bool stepSuffixMatch_(SuffixMatch &state, size_t sp_rank, size_t ep_rank) const;
+
     std::vector<char_type> temp_text_;
 };
 
-template <class CharT>
-FMIndex<CharT>::FMIndex()
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::FMIndex()
     : length_(), alphabet_num_()
+    , topk_max_k_(), topk_sample_len_()
 {
 }
 
-template <class CharT>
-FMIndex<CharT>::~FMIndex()
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::~FMIndex()
 {
 }
 
-template <class CharT>
-void FMIndex<CharT>::clear()
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::clear()
 {
     length_ = 0;
     alphabet_num_ = 0;
@@ -109,30 +218,31 @@ void FMIndex<CharT>::clear()
 
     bwt_tree_.reset();
     doc_array_.reset();
+    topk_index_.reset();
     std::vector<char_type>().swap(temp_text_);
 }
 
-template <class CharT>
-void FMIndex<CharT>::addDoc(const char_type *text, size_t len)
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::addDoc(const char_type *text, size_t len)
 {
     temp_text_.insert(temp_text_.end(), text, text + len);
     temp_text_.push_back(DOC_DELIM);
 }
 
-template <class CharT>
-void FMIndex<CharT>::swapOrigText(std::vector<char_type> &orig_text)
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::swapOrigText(std::vector<char_type> &orig_text)
 {
     temp_text_.swap(orig_text);
 }
 
-template <class CharT>
-size_t FMIndex<CharT>::docCount() const
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+size_t FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::docCount() const
 {
     return doc_delim_.size();
 }
 
-template <class CharT>
-void FMIndex<CharT>::build()
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::build()
 {
     if (temp_text_.empty())
     {
@@ -151,18 +261,11 @@ void FMIndex<CharT>::build()
         return;
     }
 
-    size_t pos = 0;
-    while (temp_text_[pos] != DOC_DELIM) ++pos;
-    doc_delim_.add(pos + 1);
-    for (size_t i = pos + 1; i < length_; ++i)
-    {
-        if (temp_text_[i] == DOC_DELIM)
-        {
-            doc_delim_.add(i - pos);
-            pos = i;
-        }
-    }
-    doc_delim_.build();
+    buildDocDelim_();
+
+    std::vector<uint32_t> lcp;
+    if (topk_max_k_ > 0)
+        buildLcp_(sa, lcp);
 
     std::vector<char_type> bwt(length_);
     uint32_t *da = (uint32_t *)&sa[0];
@@ -187,6 +290,13 @@ void FMIndex<CharT>::build()
 
     std::vector<char_type>().swap(bwt);
 
+    if (!lcp.empty())
+    {
+        topk_index_.reset(new TopKDocIndex(topk_max_k_, topk_sample_len_));
+        topk_index_->build(&lcp[0], da, length_);
+        std::vector<uint32_t>().swap(lcp);
+    }
+
     doc_array_.reset(new docarray_type(docCount(), false));
     doc_array_->build(da, length_);
 
@@ -195,8 +305,116 @@ void FMIndex<CharT>::build()
     --length_;
 }
 
-template <class CharT>
-void FMIndex<CharT>::reconstructText(const std::vector<uint32_t> &del_docid_list, std::vector<char_type> &orig_text) const
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+bool FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::buildParallel(size_t thread_num, size_t block_len, const std::string &work_dir)
+{
+    if (temp_text_.empty())
+    {
+        std::cout << "empty text list!" << std::endl;
+        clear();
+        return true;
+    }
+    temp_text_.push_back('\0');
+    length_ = temp_text_.size();
+    alphabet_num_ = WaveletTree<char_type>::getAlphabetNum(&temp_text_[0], length_);
+
+    buildDocDelim_();
+
+    ParallelBWTBuilder<char_type> builder(temp_text_, doc_delim_, alphabet_num_, thread_num, block_len, work_dir);
+    std::vector<char_type> bwt;
+    std::vector<uint32_t> da;
+    if (!builder.build(bwt))
+    {
+        cancelBuild_();
+        return false;
+    }
+
+    bwt_tree_.reset(new bwt_type(alphabet_num_, false));
+    bwt_tree_->build(&bwt[0], length_);
+
+    std::vector<char_type>().swap(bwt);
+
+    if (!builder.loadDocArray(da))
+    {
+        cancelBuild_();
+        return false;
+    }
+
+    std::vector<char_type>().swap(temp_text_);
+
+    doc_array_.reset(new docarray_type(docCount(), false));
+    doc_array_->build(&da[0], length_);
+
+    --length_;
+    return true;
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::cancelBuild_()
+{
+    // drops the '\0' appended by the build, the documents stay in temp_text_
+    temp_text_.pop_back();
+    length_ = 0;
+    alphabet_num_ = 0;
+    doc_delim_.clear();
+    bwt_tree_.reset();
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::setTopKDocIndex(size_t max_k, size_t sample_len)
+{
+    topk_max_k_ = max_k;
+    topk_sample_len_ = sample_len;
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::buildLcp_(const std::vector<int40_t> &sa, std::vector<uint32_t> &lcp) const
+{
+    std::vector<int40_t> rank(length_);
+    for (size_t i = 0; i < length_; ++i)
+    {
+        rank[sa[i]] = i;
+    }
+
+    // Kasai et al., the longest common prefixes capped to 32 bits
+    lcp.resize(length_);
+    size_t h = 0;
+    for (size_t i = 0; i < length_; ++i)
+    {
+        size_t r = rank[i];
+        if (r == 0)
+        {
+            h = 0;
+            continue;
+        }
+
+        size_t j = sa[r - 1];
+        while (i + h < length_ && j + h < length_ && temp_text_[i + h] == temp_text_[j + h]) ++h;
+        lcp[r] = std::min(h, (size_t)std::numeric_limits<uint32_t>::max());
+
+        if (h > 0) --h;
+    }
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::buildDocDelim_()
+{
+    size_t pos = 0;
+    while (temp_text_[pos] != DOC_DELIM) ++pos;
+    doc_delim_.add(pos + 1);
+    for (size_t i = pos + 1; i < length_; ++i)
+    {
+        if (temp_text_[i] == DOC_DELIM)
+        {
+            doc_delim_.add(i - pos);
+            pos = i;
+        }
+    }
+    doc_delim_.build();
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::reconstructText(const std::vector<uint32_t> &del_docid_list, std::vector<char_type> &orig_text) const
 {
     if (del_docid_list.empty() || del_docid_list[0] > doc_delim_.size()) return;
 
@@ -231,8 +449,8 @@ void FMIndex<CharT>::reconstructText(const std::vector<uint32_t> &del_docid_list
     }
 }
 
-template <class CharT>
-size_t FMIndex<CharT>::backwardSearch(const char_type *pattern, size_t len, MatchRangeT &match_range) const
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+size_t FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::backwardSearch(const char_type *pattern, size_t len, MatchRangeT &match_range) const
 {
     if (len == 0 || !bwt_tree_) return 0;
 
@@ -264,8 +482,8 @@ size_t FMIndex<CharT>::backwardSearch(const char_type *pattern, size_t len, Matc
     return orig_len - len;
 }
 
-template <class CharT>
-size_t FMIndex<CharT>::longestSuffixMatch(const char_type *pattern, size_t len, MatchRangeListT &match_ranges) const
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+size_t FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::longestSuffixMatch(const char_type *pattern, size_t len, MatchRangeListT &match_ranges) const
 {
     if (len == 0 || !bwt_tree_) return 0;
 
@@ -326,28 +544,229 @@ PRUNED:
 
     return max_match;
 }
-template <class CharT>
-size_t FMIndex<CharT>::length() const
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::backwardSearch(
+        const std::vector<std::vector<char_type> > &pattern_list,
+        std::vector<size_t> &match_len_list,
+        MatchRangeListT &match_ranges) const
+{
+    match_len_list.assign(pattern_list.size(), 0);
+    match_ranges.assign(pattern_list.size(), MatchRangeT());
+    if (!bwt_tree_) return;
+
+    // two rank queries per pattern and step
+    const size_t batch_size = RANK_BATCH_SIZE / 2;
+    std::vector<size_t> active;
+    char_type chars[RANK_BATCH_SIZE];
+    size_t positions[RANK_BATCH_SIZE];
+
+    for (size_t begin = 0; begin < pattern_list.size(); begin += batch_size)
+    {
+        size_t end = std::min(begin + batch_size, pattern_list.size());
+        active.clear();
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            const std::vector<char_type> &pattern = pattern_list[i];
+            if (pattern.empty()) continue;
+
+            char_type c = pattern.back();
+            size_t sp = bwt_tree_->beginOcc(c);
+            size_t ep = bwt_tree_->endOcc(c);
+            if (sp == ep) continue;
+
+            match_ranges[i] = MatchRangeT(sp, ep);
+            match_len_list[i] = 1;
+            if (pattern.size() > 1) active.push_back(i);
+        }
+
+        while (!active.empty())
+        {
+            for (size_t k = 0; k < active.size(); ++k)
+            {
+                const std::vector<char_type> &pattern = pattern_list[active[k]];
+                chars[2 * k] = chars[2 * k + 1] = pattern[pattern.size() - match_len_list[active[k]] - 1];
+                positions[2 * k] = match_ranges[active[k]].first;
+                positions[2 * k + 1] = match_ranges[active[k]].second;
+            }
+
+            bwt_tree_->rankBatch(chars, positions, 2 * active.size());
+
+            size_t next = 0;
+            for (size_t k = 0; k < active.size(); ++k)
+            {
+                size_t i = active[k];
+                size_t occ = bwt_tree_->beginOcc(chars[2 * k]);
+                size_t sp = occ + positions[2 * k];
+                size_t ep = occ + positions[2 * k + 1];
+                if (sp == ep) continue;
+
+                match_ranges[i] = MatchRangeT(sp, ep);
+                if (++match_len_list[i] < pattern_list[i].size())
+                    active[next++] = i;
+            }
+            active.resize(next);
+        }
+    }
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::longestSuffixMatch(
+        const std::vector<std::vector<char_type> > &pattern_list,
+        std::vector<size_t> &max_match_list,
+        std::vector<MatchRangeListT> &match_ranges_list) const
+{
+    max_match_list.assign(pattern_list.size(), 0);
+    match_ranges_list.assign(pattern_list.size(), MatchRangeListT());
+    if (!bwt_tree_) return;
+
+    const size_t batch_size = RANK_BATCH_SIZE / 2;
+    std::vector<SuffixMatch> states(batch_size);
+    std::vector<SuffixMatch *> active;
+    char_type chars[RANK_BATCH_SIZE];
+    size_t positions[RANK_BATCH_SIZE];
+
+    for (size_t begin = 0; begin < pattern_list.size(); begin += batch_size)
+    {
+        size_t end = std::min(begin + batch_size, pattern_list.size());
+        active.clear();
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            SuffixMatch &state = states[i - begin];
+            state.pattern = &pattern_list[i];
+            state.i = pattern_list[i].size();
+            state.prune_bounds.assign(pattern_list[i].size(), MatchRangeT());
+            state.max_match = 0;
+            state.match_ranges = &match_ranges_list[i];
+
+            if (startSuffixMatch_(state)) active.push_back(&state);
+        }
+
+        while (!active.empty())
+        {
+            for (size_t k = 0; k < active.size(); ++k)
+            {
+                chars[2 * k] = chars[2 * k + 1] = (*active[k]->pattern)[active[k]->j - 1];
+                positions[2 * k] = active[k]->sp;
+                positions[2 * k + 1] = active[k]->ep;
+            }
+
+            bwt_tree_->rankBatch(chars, positions, 2 * active.size());
+
+            size_t next = 0;
+            for (size_t k = 0; k < active.size(); ++k)
+            {
+                if (stepSuffixMatch_(*active[k], positions[2 * k], positions[2 * k + 1]))
+                    active[next++] = active[k];
+            }
+            active.resize(next);
+        }
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            max_match_list[i] = states[i - begin].max_match;
+        }
+    }
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+bool FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::startSuffixMatch_(SuffixMatch &state) const
+{
+    // the next suffix end to search from, as the loop of longestSuffixMatch()
+    while (state.i > state.max_match)
+    {
+        char_type c = (*state.pattern)[state.i - 1];
+        size_t sp = bwt_tree_->beginOcc(c);
+        size_t ep = bwt_tree_->endOcc(c);
+
+        MatchRangeT &bound = state.prune_bounds[state.i - 1];
+        if (ep - sp <= bound.second - bound.first)
+        {
+            --state.i;
+            continue;
+        }
+
+        state.match_range = bound = MatchRangeT(sp, ep);
+        state.sp = sp;
+        state.ep = ep;
+        state.j = state.i - 1;
+        if (state.j > 0) return true;
+
+        endSuffixMatch_(state);
+    }
+
+    return false;
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::endSuffixMatch_(SuffixMatch &state) const
+{
+    size_t match = state.i - state.j;
+    if (state.max_match < match)
+    {
+        state.max_match = match;
+        state.match_ranges->clear();
+        state.match_ranges->push_back(state.match_range);
+    }
+    else if (state.max_match == match)
+    {
+        state.match_ranges->push_back(state.match_range);
+    }
+    --state.i;
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+bool FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::stepSuffixMatch_(SuffixMatch &state, size_t sp_rank, size_t ep_rank) const
+{
+    size_t occ = bwt_tree_->beginOcc((*state.pattern)[state.j - 1]);
+    size_t sp = occ + sp_rank;
+    size_t ep = occ + ep_rank;
+
+    if (sp == ep)
+    {
+        endSuffixMatch_(state);
+        return startSuffixMatch_(state);
+    }
+
+    MatchRangeT &bound = state.prune_bounds[state.j - 1];
+    if (ep - sp <= bound.second - bound.first)
+    {
+        --state.i;
+        return startSuffixMatch_(state);
+    }
+
+    state.match_range = bound = MatchRangeT(sp, ep);
+    state.sp = sp;
+    state.ep = ep;
+    if (--state.j > 0) return true;
+
+    endSuffixMatch_(state);
+    return startSuffixMatch_(state);
+}
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+size_t FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::length() const
 {
     return length_;
 }
 
 //template <class CharT>
-//size_t FMIndex<CharT>::allocSize() const
+//size_t FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::allocSize() const
 //{
 //    return sizeof(FMIndex)
 //        + doc_delim_.allocSize() - sizeof(sdarray::SDArray)
 //        + bwt_tree_->allocSize() + doc_array_->allocSize();
 //}
 
-template <class CharT>
-size_t FMIndex<CharT>::bufferLength() const
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+size_t FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::bufferLength() const
 {
     return temp_text_.size();
 }
 
-template <class CharT>
-void FMIndex<CharT>::save(std::ostream &ostr) const
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::save(std::ostream &ostr) const
 {
     ostr.write((const char *)&length_,       sizeof(length_));
     ostr.write((const char *)&alphabet_num_, sizeof(alphabet_num_));
@@ -368,9 +787,11 @@ void FMIndex<CharT>::save(std::ostream &ostr) const
         doc_array_->save(ostr);
 }
 
-template <class CharT>
-void FMIndex<CharT>::load(std::istream &istr)
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::load(std::istream &istr)
 {
+    topk_index_.reset();
+
     istr.read((char *)&length_,       sizeof(length_));
     istr.read((char *)&alphabet_num_, sizeof(alphabet_num_));
 
@@ -388,16 +809,98 @@ void FMIndex<CharT>::load(std::istream &istr)
     }
 }
 
-template <class CharT>
-void FMIndex<CharT>::saveOriginalText(std::ostream &ostr) const
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::saveAligned(std::ostream &ostr) const
+{
+    AlignedWriter writer(ostr);
+    writer.writeHeader();
+    saveAligned(writer);
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::saveAligned(AlignedWriter &writer) const
+{
+    writer.write(length_);
+    writer.write(alphabet_num_);
+
+    if (bwt_tree_)
+    {
+        assert(length_ > 0 && alphabet_num_ > 0);
+        bwt_tree_->saveAligned(writer);
+    }
+
+    doc_delim_.saveAligned(writer);
+    assert((doc_delim_.size() == 0 && !doc_array_) ||
+            (doc_delim_.size() > 0 && doc_array_));
+
+    if (doc_array_)
+        doc_array_->saveAligned(writer);
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+bool FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::map(const std::string &path)
+{
+    MappedRegionPtr region(new MappedRegion);
+    if (!region->open(path))
+        return false;
+
+    MappedReader reader(region);
+    if (!reader.readHeader())
+        return false;
+
+    self_type mapped;
+    try
+    {
+        mapped.map(reader);
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+
+    length_ = mapped.length_;
+    alphabet_num_ = mapped.alphabet_num_;
+    doc_delim_.swap(mapped.doc_delim_);
+    doc_array_.swap(mapped.doc_array_);
+    bwt_tree_.swap(mapped.bwt_tree_);
+    topk_index_.reset();
+    return true;
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::map(MappedReader &reader)
+{
+    bwt_tree_.reset();
+    doc_array_.reset();
+    topk_index_.reset();
+
+    reader.read(length_);
+    reader.read(alphabet_num_);
+
+    if (length_ > 0 && alphabet_num_ > 0)
+    {
+        bwt_tree_.reset(new bwt_type(alphabet_num_, false));
+        bwt_tree_->map(reader);
+    }
+    doc_delim_.map(reader);
+
+    if (docCount() > 0)
+    {
+        doc_array_.reset(new docarray_type(docCount(), false));
+        doc_array_->map(reader);
+    }
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::saveOriginalText(std::ostream &ostr) const
 {
     size_t text_len = temp_text_.size();
     ostr.write((const char *)&text_len,      sizeof(text_len));
     ostr.write((const char *)&temp_text_[0], sizeof(temp_text_[0]) * text_len);
 }
 
-template <class CharT>
-void FMIndex<CharT>::loadOriginalText(std::istream &istr)
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::loadOriginalText(std::istream &istr)
 {
     size_t text_len = 0;
     istr.read((char *)&text_len,      sizeof(text_len));
@@ -405,8 +908,8 @@ void FMIndex<CharT>::loadOriginalText(std::istream &istr)
     istr.read((char *)&temp_text_[0], sizeof(temp_text_[0]) * text_len);
 }
 
-template <class CharT>
-void FMIndex<CharT>::getMatchedDocIdList(
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::getMatchedDocIdList(
     const MatchRangeT &match_range,
     size_t max_docs,
     std::vector<uint32_t> &docid_list,
@@ -432,8 +935,8 @@ void FMIndex<CharT>::getMatchedDocIdList(
     }
 }
 
-template <class CharT>
-void FMIndex<CharT>::getMatchedDocIdList(
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::getMatchedDocIdList(
     const MatchRangeListT &match_ranges,
     size_t max_docs, std::vector<uint32_t> &docid_list,
     std::vector<size_t> &doclen_list) const
@@ -465,8 +968,8 @@ void FMIndex<CharT>::getMatchedDocIdList(
     }
 }
 
-template <class CharT>
-void FMIndex<CharT>::getTopKDocIdList(
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::getTopKDocIdList(
     const MatchRangeListT &raw_range_list,
     const std::vector<double> &score_list,
     size_t thres,
@@ -502,8 +1005,52 @@ void FMIndex<CharT>::getTopKDocIdList(
     }
 }
 
-template <class CharT>
-void FMIndex<CharT>::getDocLenList(const std::vector<uint32_t>& docid_list, std::vector<size_t>& doclen_list) const
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::getTopKDocIdListByFreq(
+    const MatchRangeT &match_range,
+    size_t max_docs,
+    std::vector<std::pair<size_t, uint32_t> > &res_list,
+    std::vector<size_t> &doclen_list) const
+{
+    if (!doc_array_ || docCount() == 0)
+        return;
+
+    if (topk_index_)
+        topk_index_->topK(*doc_array_, match_range.first, match_range.second, max_docs, res_list);
+    else
+        TopKDocIndex::countTopK(*doc_array_, match_range.first, match_range.second, max_docs, res_list);
+
+    doclen_list.resize(res_list.size());
+    for (size_t i = 0; i < res_list.size(); ++i)
+    {
+        doclen_list[i] = doc_delim_.getVal(res_list[i].second++) - 1;
+    }
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::saveTopKDocIndex(std::ostream &ostr) const
+{
+    uint32_t flag = topk_index_ ? 1U : 0U;
+    ostr.write((const char *)&flag, sizeof(flag));
+    if (topk_index_)
+        topk_index_->save(ostr);
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::loadTopKDocIndex(std::istream &istr)
+{
+    uint32_t flag = 0;
+    istr.read((char *)&flag, sizeof(flag));
+    topk_index_.reset();
+    if (flag)
+    {
+        topk_index_.reset(new TopKDocIndex(0));
+        topk_index_->load(istr);
+    }
+}
+
+template <class CharT, class BwtBitmapT, class DocArrayBitmapT>
+void FMIndex<CharT, BwtBitmapT, DocArrayBitmapT>::getDocLenList(const std::vector<uint32_t>& docid_list, std::vector<size_t>& doclen_list) const
 {
     doclen_list.resize(docid_list.size());
     for (size_t i = 0; i < docid_list.size(); ++i)
@@ -0,0 +1,507 @@
+#ifndef _FM_INDEX_PARALLEL_BWT_BUILDER_HPP
+#define _FM_INDEX_PARALLEL_BWT_BUILDER_HPP
+
+#include "const.hpp"
+#include <am/succinct/sdarray/SDArray.hpp>
+#include <am/succinct/sais/sais.hxx>
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+
+NS_IZENELIB_AM_BEGIN
+
+namespace succinct
+{
+namespace fm_index
+{
+
+/**
+ * Builds the BWT and the doc array of a document collection without the
+ * suffix array of the whole text in memory.
+ *
+ * The text is cut into blocks of whole documents. Each block is suffix sorted
+ * by SA-IS on its own thread, with the delimiter of its j-th document mapped
+ * to a unique symbol, so the suffixes are ordered by their text up to the end
+ * of their document, then by document. The sorted block is written as a run
+ * of 32 bits offsets. The runs are then cut by splitter suffixes into one
+ * range per thread, and each thread merges its ranges comparing the text up to
+ * the document delimiter, writing its rows of the BWT in memory and of the doc
+ * array to a file.
+ *
+ * The order only differs from sorting the whole text in the order of suffixes
+ * equal up to their delimiter, so the ranges of a pattern without DOC_DELIM
+ * cover the same documents. The first char of a document is preceded by its
+ * own delimiter, as if each document was a cyclic string.
+ *
+ * Peak memory is the text and the blocks being sorted (8 bytes per char of a
+ * block, block_len is chosen for about one byte per char in all), then the
+ * text and the BWT during merging.
+ */
+template <class CharT>
+class ParallelBWTBuilder
+{
+public:
+    typedef CharT char_type;
+
+    /**
+     * @param text the documents, each ended by DOC_DELIM, then '\0'
+     * @param thread_num threads to use, 0 for the hardware concurrency
+     * @param block_len chars per sorted block, 0 to pick one from the text length
+     * @param work_dir where the runs are written, the system temp dir if empty
+     */
+    ParallelBWTBuilder(
+            const std::vector<char_type> &text,
+            const sdarray::SDArray &doc_delim,
+            size_t alphabet_num,
+            size_t thread_num,
+            size_t block_len,
+            const std::string &work_dir);
+
+    ~ParallelBWTBuilder();
+
+    /**
+     * sorts the blocks and merges them into @p bwt, the doc array is kept in
+     * the work dir for loadDocArray().
+     * @return false if a block could not be sorted or a run not be written
+     */
+    bool build(std::vector<char_type> &bwt);
+
+    /// @return false if the doc array could not be read back
+    bool loadDocArray(std::vector<uint32_t> &da) const;
+
+private:
+    struct Run
+    {
+        size_t base;     ///< text position of the block
+        size_t len;      ///< chars in the block, and entries in the run
+        size_t doc_num;
+        int fd;
+    };
+
+    /// compares the suffixes at two text positions up to the end of their documents
+    struct SuffixLess
+    {
+        const char_type *text;
+
+        explicit SuffixLess(const char_type *t) : text(t) {}
+
+        bool operator()(size_t p, size_t q) const
+        {
+            const char_type *a = text + p;
+            const char_type *b = text + q;
+            for (;; ++a, ++b)
+            {
+                if (*a != *b) return *a < *b;
+                if (*a == DOC_DELIM) return p < q;
+            }
+        }
+    };
+
+    /// heap order for the merge, the smallest suffix on top
+    struct CursorGreater
+    {
+        SuffixLess less;
+
+        explicit CursorGreater(const char_type *t) : less(t) {}
+
+        bool operator()(const std::pair<size_t, size_t> &a, const std::pair<size_t, size_t> &b) const
+        {
+            return less(b.first, a.first);
+        }
+    };
+
+    static const size_t MERGE_BUFFER_SIZE = 2048;
+    static const size_t SPLITTER_SAMPLES = 64;
+
+    void cutBlocks_(size_t block_len);
+    void sortBlocks_(size_t first, bool &ok);
+    bool sortBlock_(Run &run);
+
+    bool readRun_(const Run &run, size_t from, size_t end, std::vector<uint32_t> &buffer) const;
+    size_t readEntry_(const Run &run, size_t i, bool &ok) const;
+    size_t lowerBound_(const Run &run, size_t pos, bool &ok) const;
+    bool pickSplitters_(std::vector<std::vector<size_t> > &cuts) const;
+    void mergeRanges_(
+            const std::vector<size_t> &begin,
+            const std::vector<size_t> &end,
+            size_t row,
+            char_type *bwt,
+            bool &ok) const;
+
+    const std::vector<char_type> &text_;
+    size_t length_;
+    const sdarray::SDArray &doc_delim_;
+    size_t alphabet_num_;
+    size_t thread_num_;
+    boost::filesystem::path work_dir_;
+    int da_fd_;
+
+    std::vector<Run> runs_;
+};
+
+template <class CharT>
+const size_t ParallelBWTBuilder<CharT>::MERGE_BUFFER_SIZE;
+
+template <class CharT>
+const size_t ParallelBWTBuilder<CharT>::SPLITTER_SAMPLES;
+
+template <class CharT>
+ParallelBWTBuilder<CharT>::ParallelBWTBuilder(
+        const std::vector<char_type> &text,
+        const sdarray::SDArray &doc_delim,
+        size_t alphabet_num,
+        size_t thread_num,
+        size_t block_len,
+        const std::string &work_dir)
+    : text_(text)
+    , length_(text.size())
+    , doc_delim_(doc_delim)
+    , alphabet_num_(alphabet_num)
+    , thread_num_(thread_num ? thread_num : std::max(1U, boost::thread::hardware_concurrency()))
+    , da_fd_(-1)
+{
+    boost::filesystem::path dir = work_dir.empty()
+        ? boost::filesystem::temp_directory_path() : boost::filesystem::path(work_dir);
+    work_dir_ = dir / boost::filesystem::unique_path("fm_index_build_%%%%-%%%%-%%%%");
+    boost::filesystem::create_directories(work_dir_);
+
+    if (block_len == 0)
+    {
+        // about one byte per char for the blocks being sorted at the same time
+        block_len = length_ / (8 * thread_num_);
+        block_len = std::max(block_len, (size_t)1 << 16);
+    }
+    block_len = std::min(block_len, (size_t)std::numeric_limits<int32_t>::max() / 2);
+    cutBlocks_(block_len);
+}
+
+template <class CharT>
+ParallelBWTBuilder<CharT>::~ParallelBWTBuilder()
+{
+    for (size_t i = 0; i < runs_.size(); ++i)
+    {
+        if (runs_[i].fd >= 0) ::close(runs_[i].fd);
+    }
+    if (da_fd_ >= 0) ::close(da_fd_);
+
+    boost::system::error_code ec;
+    boost::filesystem::remove_all(work_dir_, ec);
+}
+
+template <class CharT>
+void ParallelBWTBuilder<CharT>::cutBlocks_(size_t block_len)
+{
+    // the '\0' at the end is not in any block, it is row 0
+    size_t text_len = length_ - 1;
+    size_t pos = 0;
+    while (pos < text_len)
+    {
+        Run run;
+        run.base = pos;
+        run.doc_num = 0;
+        run.fd = -1;
+
+        size_t end = std::min(pos + block_len, text_len);
+        for (size_t i = pos; i < end; ++i)
+        {
+            if (text_[i] == DOC_DELIM) ++run.doc_num;
+        }
+        // a block ends after a delimiter, so it may be longer than block_len
+        while (text_[end - 1] != DOC_DELIM)
+        {
+            if (text_[end++] == DOC_DELIM) ++run.doc_num;
+        }
+        run.len = end - pos;
+        runs_.push_back(run);
+        pos = end;
+    }
+}
+
+template <class CharT>
+bool ParallelBWTBuilder<CharT>::sortBlock_(Run &run)
+{
+    // the delimiter of the j-th document becomes DOC_DELIM + j, larger chars are moved up
+    std::vector<int32_t> block(run.len);
+    const char_type *text = &text_[run.base];
+    int32_t shift = run.doc_num - 1;
+    int32_t doc = 0;
+    for (size_t i = 0; i < run.len; ++i)
+    {
+        if (text[i] < DOC_DELIM)
+            block[i] = text[i];
+        else if (text[i] == DOC_DELIM)
+            block[i] = DOC_DELIM + doc++;
+        else
+            block[i] = text[i] + shift;
+    }
+
+    std::vector<int32_t> sa(run.len);
+    if (saisxx(block.begin(), sa.begin(), (int32_t)run.len, (int32_t)(alphabet_num_ + shift)) < 0)
+        return false;
+    std::vector<int32_t>().swap(block);
+
+    std::string path = (work_dir_ / ("run." + boost::lexical_cast<std::string>(run.base))).string();
+    run.fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (run.fd < 0) return false;
+
+    size_t bytes = run.len * sizeof(int32_t);
+    const char *p = (const char *)&sa[0];
+    for (size_t done = 0; done < bytes;)
+    {
+        ssize_t n = ::pwrite(run.fd, p + done, bytes - done, done);
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+template <class CharT>
+void ParallelBWTBuilder<CharT>::sortBlocks_(size_t first, bool &ok)
+{
+    for (size_t i = first; i < runs_.size() && ok; i += thread_num_)
+    {
+        if (!sortBlock_(runs_[i]))
+        {
+            std::cerr << "fail to sort the block at " << runs_[i].base << std::endl;
+            ok = false;
+        }
+    }
+}
+
+/// reads the entries [from, min(end, from + MERGE_BUFFER_SIZE)) of @p run
+template <class CharT>
+bool ParallelBWTBuilder<CharT>::readRun_(const Run &run, size_t from, size_t end, std::vector<uint32_t> &buffer) const
+{
+    size_t bytes = std::min(MERGE_BUFFER_SIZE, end - from) * sizeof(uint32_t);
+    return ::pread(run.fd, &buffer[0], bytes, from * sizeof(uint32_t)) == (ssize_t)bytes;
+}
+
+/// sets @p ok to false on a failed read, the entry is then the start of the run
+template <class CharT>
+size_t ParallelBWTBuilder<CharT>::readEntry_(const Run &run, size_t i, bool &ok) const
+{
+    uint32_t entry = 0;
+    if (::pread(run.fd, &entry, sizeof(entry), i * sizeof(entry)) != sizeof(entry))
+    {
+        std::cerr << "fail to read the run at " << run.base << std::endl;
+        ok = false;
+    }
+    return run.base + entry;
+}
+
+template <class CharT>
+size_t ParallelBWTBuilder<CharT>::lowerBound_(const Run &run, size_t pos, bool &ok) const
+{
+    SuffixLess less(&text_[0]);
+    size_t low = 0, high = run.len;
+    while (low < high && ok)
+    {
+        size_t mid = (low + high) / 2;
+        if (less(readEntry_(run, mid, ok), pos))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+template <class CharT>
+bool ParallelBWTBuilder<CharT>::pickSplitters_(std::vector<std::vector<size_t> > &cuts) const
+{
+    bool ok = true;
+    std::vector<size_t> samples;
+    size_t total = length_ - 1;
+    size_t step = std::max((size_t)1, total / (SPLITTER_SAMPLES * thread_num_));
+    for (size_t r = 0; r < runs_.size(); ++r)
+    {
+        for (size_t i = step / 2; i < runs_[r].len; i += step)
+            samples.push_back(readEntry_(runs_[r], i, ok));
+    }
+    if (!ok) return false;
+    std::sort(samples.begin(), samples.end(), SuffixLess(&text_[0]));
+
+    cuts.assign(thread_num_ + 1, std::vector<size_t>(runs_.size()));
+    for (size_t r = 0; r < runs_.size(); ++r)
+        cuts[thread_num_][r] = runs_[r].len;
+
+    for (size_t t = 1; t < thread_num_; ++t)
+    {
+        if (samples.empty())
+        {
+            cuts[t] = cuts[thread_num_];
+            continue;
+        }
+        size_t splitter = samples[t * samples.size() / thread_num_];
+        for (size_t r = 0; r < runs_.size(); ++r)
+            cuts[t][r] = lowerBound_(runs_[r], splitter, ok);
+    }
+    return ok;
+}
+
+template <class CharT>
+void ParallelBWTBuilder<CharT>::mergeRanges_(
+        const std::vector<size_t> &begin,
+        const std::vector<size_t> &end,
+        size_t row,
+        char_type *bwt,
+        bool &ok) const
+{
+    const char_type *text = &text_[0];
+    size_t run_num = runs_.size();
+
+    // entries [buffered, buffered + MERGE_BUFFER_SIZE) of each run are in its buffer
+    std::vector<std::vector<uint32_t> > buffers(run_num);
+    std::vector<size_t> next(begin), buffered(begin);
+
+    // (text position, run) of the current entry of each run
+    std::vector<std::pair<size_t, size_t> > heap;
+    CursorGreater greater(text);
+
+    for (size_t r = 0; r < run_num; ++r)
+    {
+        if (begin[r] == end[r]) continue;
+        buffers[r].resize(MERGE_BUFFER_SIZE);
+        if (!readRun_(runs_[r], begin[r], end[r], buffers[r]))
+            ok = false;
+        heap.push_back(std::make_pair(runs_[r].base + buffers[r][0], r));
+    }
+    std::make_heap(heap.begin(), heap.end(), greater);
+
+    std::vector<uint32_t> da_buffer;
+    da_buffer.reserve(MERGE_BUFFER_SIZE);
+    size_t da_row = row;
+
+    while (!heap.empty() && ok)
+    {
+        std::pop_heap(heap.begin(), heap.end(), greater);
+        size_t pos = heap.back().first;
+        size_t r = heap.back().second;
+
+        bwt[row++] = (pos == 0 || text[pos - 1] == DOC_DELIM) ? (char_type)DOC_DELIM : text[pos - 1];
+        da_buffer.push_back(pos == 0 ? 0 : doc_delim_.find(pos));
+        if (da_buffer.size() == MERGE_BUFFER_SIZE)
+        {
+            size_t bytes = da_buffer.size() * sizeof(uint32_t);
+            if (::pwrite(da_fd_, &da_buffer[0], bytes, da_row * sizeof(uint32_t)) != (ssize_t)bytes)
+                ok = false;
+            da_row += da_buffer.size();
+            da_buffer.clear();
+        }
+
+        if (++next[r] == end[r])
+        {
+            heap.pop_back();
+            continue;
+        }
+        if (next[r] == buffered[r] + MERGE_BUFFER_SIZE)
+        {
+            buffered[r] = next[r];
+            if (!readRun_(runs_[r], next[r], end[r], buffers[r]))
+                ok = false;
+        }
+        heap.back().first = runs_[r].base + buffers[r][next[r] - buffered[r]];
+        std::push_heap(heap.begin(), heap.end(), greater);
+    }
+
+    if (!da_buffer.empty())
+    {
+        size_t bytes = da_buffer.size() * sizeof(uint32_t);
+        if (::pwrite(da_fd_, &da_buffer[0], bytes, da_row * sizeof(uint32_t)) != (ssize_t)bytes)
+            ok = false;
+    }
+}
+
+template <class CharT>
+bool ParallelBWTBuilder<CharT>::build(std::vector<char_type> &bwt)
+{
+    boost::scoped_array<bool> ok(new bool[thread_num_]);
+    std::fill(ok.get(), ok.get() + thread_num_, true);
+    {
+        boost::thread_group threads;
+        for (size_t t = 0; t < thread_num_; ++t)
+        {
+            threads.create_thread(boost::bind(&ParallelBWTBuilder::sortBlocks_, this, t, boost::ref(ok[t])));
+        }
+        threads.join_all();
+    }
+    if (std::find(ok.get(), ok.get() + thread_num_, false) != ok.get() + thread_num_)
+        return false;
+
+    std::string da_path = (work_dir_ / "doc_array").string();
+    da_fd_ = ::open(da_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (da_fd_ < 0) return false;
+
+    // row 0 is the suffix "\0", as in FMIndex::build()
+    bwt.resize(length_);
+    bwt[0] = '\0';
+    uint32_t da0 = doc_delim_.find(length_ - 1);
+    if (::pwrite(da_fd_, &da0, sizeof(da0), 0) != sizeof(da0))
+        return false;
+
+    std::vector<std::vector<size_t> > cuts;
+    if (!pickSplitters_(cuts)) return false;
+
+    {
+        boost::thread_group threads;
+        size_t row = 1;
+        for (size_t t = 0; t < thread_num_; ++t)
+        {
+            threads.create_thread(boost::bind(&ParallelBWTBuilder::mergeRanges_, this,
+                        boost::cref(cuts[t]), boost::cref(cuts[t + 1]), row, &bwt[0], boost::ref(ok[t])));
+            for (size_t r = 0; r < runs_.size(); ++r)
+                row += cuts[t + 1][r] - cuts[t][r];
+        }
+        threads.join_all();
+    }
+
+    for (size_t r = 0; r < runs_.size(); ++r)
+    {
+        ::close(runs_[r].fd);
+        runs_[r].fd = -1;
+    }
+    boost::system::error_code ec;
+    for (size_t r = 0; r < runs_.size(); ++r)
+        boost::filesystem::remove(work_dir_ / ("run." + boost::lexical_cast<std::string>(runs_[r].base)), ec);
+
+    return std::find(ok.get(), ok.get() + thread_num_, false) == ok.get() + thread_num_;
+}
+
+template <class CharT>
+bool ParallelBWTBuilder<CharT>::loadDocArray(std::vector<uint32_t> &da) const
+{
+    da.resize(length_);
+    size_t bytes = da.size() * sizeof(uint32_t);
+    char *p = (char *)&da[0];
+    for (size_t done = 0; done < bytes;)
+    {
+        ssize_t n = ::pread(da_fd_, p + done, bytes - done, done);
+        if (n <= 0)
+        {
+            std::cerr << "fail to read the doc array" << std::endl;
+            std::vector<uint32_t>().swap(da);
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
+
+}
+}
+
+NS_IZENELIB_AM_END
+
+#endif
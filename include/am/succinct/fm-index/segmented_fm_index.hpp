@@ -0,0 +1,506 @@
+#ifndef _FM_INDEX_SEGMENTED_FM_INDEX_HPP
+#define _FM_INDEX_SEGMENTED_FM_INDEX_HPP
+
+#include "fm_index.hpp"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/dynamic_bitset.hpp>
+
+#include <vector>
+#include <algorithm>
+
+
+NS_IZENELIB_AM_BEGIN
+
+namespace succinct
+{
+namespace fm_index
+{
+
+/**
+ * An FM-index that takes new and removed documents without a rebuild.
+ *
+ * New documents are buffered and built into a small FMIndex segment by flush(),
+ * queries run on each segment and merge the results, and removed documents are
+ * marked in a bitmap and filtered out. A background thread, or mergeAll(), merges
+ * adjacent segments of the same size level into one, LSM style: a segment is at
+ * level l when it holds at least flush_len * merge_factor^l chars, and
+ * merge_factor adjacent segments of the lowest full level are rebuilt together,
+ * the removed documents left empty so the doc ids of a segment stay contiguous.
+ *
+ * Each segment keeps its text to be rebuilt. Doc ids start from 1, in the order
+ * of addDoc(), and are visible to queries after the next flush().
+ */
+template <class CharT>
+class SegmentedFMIndex
+{
+public:
+    typedef CharT char_type;
+    typedef FMIndex<CharT> fm_index_type;
+    typedef typename fm_index_type::MatchRangeT MatchRangeT;
+    typedef typename fm_index_type::MatchRangeListT MatchRangeListT;
+
+    /**
+     * @param flush_len chars after which addDoc() flushes the new documents
+     * @param merge_factor segments of a level merged at once
+     */
+    explicit SegmentedFMIndex(size_t flush_len = 1 << 20, size_t merge_factor = 4);
+    ~SegmentedFMIndex();
+
+    /// @return the doc id of the document
+    uint32_t addDoc(const char_type *text, size_t len);
+    void removeDoc(uint32_t docid);
+
+    /// builds the documents added since the last flush into a segment
+    void flush();
+
+    void startMergeThread();
+    void stopMergeThread();
+
+    /// merges all segments into one, at the caller's thread
+    void mergeAll();
+
+    size_t docCount() const;
+    size_t segmentCount() const;
+
+    /**
+     * gets the documents containing @p pattern, as FMIndex::getMatchedDocIdList()
+     * does for its match range.
+     */
+    void getMatchedDocIdList(
+            const char_type *pattern,
+            size_t len,
+            size_t max_docs,
+            std::vector<uint32_t> &docid_list,
+            std::vector<size_t> &doclen_list) const;
+
+    /**
+     * gets the @p max_docs best documents by the scores of the patterns they
+     * contain, as FMIndex::getTopKDocIdList() does for the match ranges.
+     */
+    void getTopKDocIdList(
+            const std::vector<std::vector<char_type> > &pattern_list,
+            const std::vector<double> &score_list,
+            size_t thres,
+            size_t max_docs,
+            std::vector<std::pair<double, uint32_t> > &res_list,
+            std::vector<size_t> &doclen_list) const;
+
+private:
+    struct Segment
+    {
+        boost::shared_ptr<fm_index_type> fm_index;
+        std::vector<char_type> text;   ///< the documents, each ended by DOC_DELIM
+        uint32_t base_docid;           ///< doc ids in the segment are base_docid + 1, ...
+        size_t doc_count;
+    };
+
+    typedef boost::shared_ptr<const Segment> SegmentPtr;
+    typedef std::vector<SegmentPtr> SegmentList;
+    typedef boost::shared_ptr<const SegmentList> SegmentListPtr;
+
+    /// (score, doc id) and doc length
+    typedef std::pair<std::pair<double, uint32_t>, size_t> HitT;
+
+    static bool hitGreater_(const HitT &a, const HitT &b)
+    {
+        if (a.first.first != b.first.first) return a.first.first > b.first.first;
+        return a.first.second < b.first.second;
+    }
+
+    SegmentListPtr snapshot_() const;
+    bool isRemoved_(uint32_t docid) const;
+
+    SegmentPtr buildSegment_(std::vector<char_type> &text, uint32_t base_docid, size_t doc_count) const;
+    size_t level_(const Segment &segment) const;
+    bool pickMerge_(const SegmentList &list, size_t &first, size_t &count) const;
+    void mergeSegments_(const SegmentList &list, size_t first, size_t count);
+    void mergeLoop_();
+
+    size_t flush_len_;
+    size_t merge_factor_;
+
+    /// the segment list is replaced, never changed, so a query works on a snapshot
+    mutable boost::mutex segments_mutex_;
+    SegmentListPtr segments_;
+
+    /// protects the new documents
+    boost::mutex buffer_mutex_;
+    std::vector<char_type> buffer_text_;
+    size_t buffer_doc_count_;
+    uint32_t next_docid_;
+
+    /// one flush at a time, so the segments are in doc id order
+    boost::mutex flush_mutex_;
+
+    /// one merge at a time
+    boost::mutex merge_mutex_;
+
+    mutable boost::shared_mutex removed_mutex_;
+    boost::dynamic_bitset<> removed_;
+
+    boost::mutex merge_wait_mutex_;
+    boost::condition_variable merge_cond_;
+    bool stop_merge_;
+    boost::scoped_ptr<boost::thread> merge_thread_;
+};
+
+template <class CharT>
+SegmentedFMIndex<CharT>::SegmentedFMIndex(size_t flush_len, size_t merge_factor)
+    : flush_len_(std::max(flush_len, (size_t)1))
+    , merge_factor_(std::max(merge_factor, (size_t)2))
+    , segments_(new SegmentList)
+    , buffer_doc_count_(0)
+    , next_docid_(0)
+    , removed_(1)
+    , stop_merge_(false)
+{
+}
+
+template <class CharT>
+SegmentedFMIndex<CharT>::~SegmentedFMIndex()
+{
+    stopMergeThread();
+}
+
+template <class CharT>
+uint32_t SegmentedFMIndex<CharT>::addDoc(const char_type *text, size_t len)
+{
+    uint32_t docid;
+    bool full;
+    {
+        boost::mutex::scoped_lock lock(buffer_mutex_);
+        buffer_text_.insert(buffer_text_.end(), text, text + len);
+        buffer_text_.push_back(DOC_DELIM);
+        ++buffer_doc_count_;
+        docid = ++next_docid_;
+        full = buffer_text_.size() >= flush_len_;
+    }
+    {
+        boost::unique_lock<boost::shared_mutex> lock(removed_mutex_);
+        if (removed_.size() <= docid)
+            removed_.resize(std::max((size_t)docid + 1, removed_.size() * 2));
+    }
+
+    if (full) flush();
+    return docid;
+}
+
+template <class CharT>
+void SegmentedFMIndex<CharT>::removeDoc(uint32_t docid)
+{
+    boost::unique_lock<boost::shared_mutex> lock(removed_mutex_);
+    if (docid < removed_.size())
+        removed_.set(docid);
+}
+
+template <class CharT>
+bool SegmentedFMIndex<CharT>::isRemoved_(uint32_t docid) const
+{
+    return docid < removed_.size() && removed_.test(docid);
+}
+
+template <class CharT>
+typename SegmentedFMIndex<CharT>::SegmentListPtr SegmentedFMIndex<CharT>::snapshot_() const
+{
+    boost::mutex::scoped_lock lock(segments_mutex_);
+    return segments_;
+}
+
+template <class CharT>
+size_t SegmentedFMIndex<CharT>::docCount() const
+{
+    SegmentListPtr list = snapshot_();
+    return list->empty() ? 0 : list->back()->base_docid + list->back()->doc_count;
+}
+
+template <class CharT>
+size_t SegmentedFMIndex<CharT>::segmentCount() const
+{
+    return snapshot_()->size();
+}
+
+template <class CharT>
+typename SegmentedFMIndex<CharT>::SegmentPtr SegmentedFMIndex<CharT>::buildSegment_(
+        std::vector<char_type> &text,
+        uint32_t base_docid,
+        size_t doc_count) const
+{
+    boost::shared_ptr<Segment> segment(new Segment);
+    segment->base_docid = base_docid;
+    segment->doc_count = doc_count;
+    segment->fm_index.reset(new fm_index_type);
+
+    // FMIndex::build() consumes its text, the segment keeps a copy for merging
+    std::vector<char_type> fm_text(text);
+    // the doc array of FMIndex needs two documents, the empty one matches no pattern
+    if (doc_count == 1) fm_text.push_back(DOC_DELIM);
+    segment->fm_index->swapOrigText(fm_text);
+    segment->fm_index->build();
+    segment->text.swap(text);
+    return segment;
+}
+
+template <class CharT>
+void SegmentedFMIndex<CharT>::flush()
+{
+    boost::mutex::scoped_lock flush_lock(flush_mutex_);
+
+    std::vector<char_type> text;
+    size_t doc_count;
+    uint32_t base_docid;
+    {
+        boost::mutex::scoped_lock lock(buffer_mutex_);
+        if (buffer_doc_count_ == 0) return;
+        text.swap(buffer_text_);
+        doc_count = buffer_doc_count_;
+        base_docid = next_docid_ - doc_count;
+        buffer_doc_count_ = 0;
+    }
+
+    SegmentPtr segment = buildSegment_(text, base_docid, doc_count);
+    {
+        boost::mutex::scoped_lock lock(segments_mutex_);
+        boost::shared_ptr<SegmentList> list(new SegmentList(*segments_));
+        list->push_back(segment);
+        segments_ = list;
+    }
+
+    boost::mutex::scoped_lock lock(merge_wait_mutex_);
+    merge_cond_.notify_one();
+}
+
+template <class CharT>
+size_t SegmentedFMIndex<CharT>::level_(const Segment &segment) const
+{
+    size_t level = 0;
+    for (size_t len = flush_len_ * merge_factor_; segment.text.size() >= len; len *= merge_factor_)
+        ++level;
+    return level;
+}
+
+template <class CharT>
+bool SegmentedFMIndex<CharT>::pickMerge_(const SegmentList &list, size_t &first, size_t &count) const
+{
+    // the lowest level with merge_factor adjacent segments
+    size_t best_level = (size_t)-1;
+    size_t run_begin = 0;
+    for (size_t i = 1; i <= list.size(); ++i)
+    {
+        if (i < list.size() && level_(*list[i]) == level_(*list[run_begin]))
+            continue;
+
+        size_t level = level_(*list[run_begin]);
+        if (i - run_begin >= merge_factor_ && level < best_level)
+        {
+            best_level = level;
+            first = run_begin;
+            count = merge_factor_;
+        }
+        run_begin = i;
+    }
+    return best_level != (size_t)-1;
+}
+
+template <class CharT>
+void SegmentedFMIndex<CharT>::mergeSegments_(const SegmentList &list, size_t first, size_t count)
+{
+    const Segment &front = *list[first];
+    std::vector<char_type> text;
+    size_t doc_count = 0;
+    {
+        boost::shared_lock<boost::shared_mutex> lock(removed_mutex_);
+        for (size_t i = first; i < first + count; ++i)
+        {
+            const Segment &segment = *list[i];
+            typename std::vector<char_type>::const_iterator begin = segment.text.begin();
+            for (size_t d = 1; d <= segment.doc_count; ++d)
+            {
+                typename std::vector<char_type>::const_iterator end = std::find(begin, segment.text.end(), (char_type)DOC_DELIM);
+                if (!isRemoved_(segment.base_docid + d))
+                    text.insert(text.end(), begin, end);
+                text.push_back(DOC_DELIM);
+                begin = end + 1;
+            }
+            doc_count += segment.doc_count;
+        }
+    }
+
+    SegmentPtr merged = buildSegment_(text, front.base_docid, doc_count);
+
+    boost::mutex::scoped_lock lock(segments_mutex_);
+    // segments may have been flushed since the snapshot, the merged ones stay in place
+    typename SegmentList::const_iterator it = std::find(segments_->begin(), segments_->end(), list[first]);
+    assert(it != segments_->end());
+    boost::shared_ptr<SegmentList> merged_list(new SegmentList(segments_->begin(), it));
+    merged_list->push_back(merged);
+    merged_list->insert(merged_list->end(), it + count, segments_->end());
+    segments_ = merged_list;
+}
+
+template <class CharT>
+void SegmentedFMIndex<CharT>::mergeAll()
+{
+    flush();
+
+    boost::mutex::scoped_lock lock(merge_mutex_);
+    SegmentListPtr list = snapshot_();
+    if (list->size() > 1)
+        mergeSegments_(*list, 0, list->size());
+}
+
+template <class CharT>
+void SegmentedFMIndex<CharT>::mergeLoop_()
+{
+    while (true)
+    {
+        size_t first = 0, count = 0;
+        SegmentListPtr list;
+        {
+            boost::mutex::scoped_lock lock(merge_wait_mutex_);
+            while (!stop_merge_ && !pickMerge_(*(list = snapshot_()), first, count))
+                merge_cond_.wait(lock);
+            if (stop_merge_) return;
+        }
+
+        boost::mutex::scoped_lock lock(merge_mutex_);
+        // mergeAll() may have run in between
+        if (pickMerge_(*(list = snapshot_()), first, count))
+            mergeSegments_(*list, first, count);
+    }
+}
+
+template <class CharT>
+void SegmentedFMIndex<CharT>::startMergeThread()
+{
+    if (merge_thread_) return;
+    stop_merge_ = false;
+    merge_thread_.reset(new boost::thread(&SegmentedFMIndex::mergeLoop_, this));
+}
+
+template <class CharT>
+void SegmentedFMIndex<CharT>::stopMergeThread()
+{
+    if (!merge_thread_) return;
+    {
+        boost::mutex::scoped_lock lock(merge_wait_mutex_);
+        stop_merge_ = true;
+        merge_cond_.notify_one();
+    }
+    merge_thread_->join();
+    merge_thread_.reset();
+}
+
+template <class CharT>
+void SegmentedFMIndex<CharT>::getMatchedDocIdList(
+        const char_type *pattern,
+        size_t len,
+        size_t max_docs,
+        std::vector<uint32_t> &docid_list,
+        std::vector<size_t> &doclen_list) const
+{
+    SegmentListPtr list = snapshot_();
+    boost::shared_lock<boost::shared_mutex> lock(removed_mutex_);
+
+    for (size_t i = 0; i < list->size() && docid_list.size() < max_docs; ++i)
+    {
+        const Segment &segment = *(*list)[i];
+        MatchRangeT range;
+        if (segment.fm_index->backwardSearch(pattern, len, range) != len)
+            continue;
+
+        // ask for more when removed documents take the place of live ones
+        size_t limit = max_docs - docid_list.size();
+        for (size_t want = limit;; want *= 2)
+        {
+            std::vector<uint32_t> docids;
+            std::vector<size_t> doclens;
+            segment.fm_index->getMatchedDocIdList(range, want, docids, doclens);
+
+            size_t found = 0;
+            for (size_t j = 0; j < docids.size() && found < limit; ++j)
+            {
+                uint32_t docid = segment.base_docid + docids[j];
+                if (isRemoved_(docid)) continue;
+                docid_list.push_back(docid);
+                doclen_list.push_back(doclens[j]);
+                ++found;
+            }
+            if (found == limit || docids.size() < want) break;
+
+            docid_list.resize(docid_list.size() - found);
+            doclen_list.resize(doclen_list.size() - found);
+        }
+    }
+}
+
+template <class CharT>
+void SegmentedFMIndex<CharT>::getTopKDocIdList(
+        const std::vector<std::vector<char_type> > &pattern_list,
+        const std::vector<double> &score_list,
+        size_t thres,
+        size_t max_docs,
+        std::vector<std::pair<double, uint32_t> > &res_list,
+        std::vector<size_t> &doclen_list) const
+{
+    SegmentListPtr list = snapshot_();
+
+    std::vector<HitT> hits;
+    {
+        boost::shared_lock<boost::shared_mutex> lock(removed_mutex_);
+        for (size_t i = 0; i < list->size(); ++i)
+        {
+            const Segment &segment = *(*list)[i];
+            MatchRangeListT ranges;
+            std::vector<double> scores;
+            for (size_t p = 0; p < pattern_list.size(); ++p)
+            {
+                MatchRangeT range;
+                const std::vector<char_type> &pattern = pattern_list[p];
+                if (pattern.empty() || segment.fm_index->backwardSearch(&pattern[0], pattern.size(), range) != pattern.size())
+                    continue;
+                ranges.push_back(range);
+                scores.push_back(score_list[p]);
+            }
+            if (ranges.empty()) continue;
+
+            // ask for more when removed documents take the place of live ones
+            for (size_t want = max_docs;; want *= 2)
+            {
+                std::vector<std::pair<double, uint32_t> > res;
+                std::vector<size_t> doclens;
+                segment.fm_index->getTopKDocIdList(ranges, scores, thres, want, res, doclens);
+
+                size_t found = 0;
+                for (size_t j = 0; j < res.size(); ++j)
+                {
+                    uint32_t docid = segment.base_docid + res[j].second;
+                    if (isRemoved_(docid)) continue;
+                    hits.push_back(std::make_pair(std::make_pair(res[j].first, docid), doclens[j]));
+                    ++found;
+                }
+                if (found >= max_docs || res.size() < want) break;
+
+                hits.resize(hits.size() - found);
+            }
+        }
+    }
+
+    size_t k = std::min(max_docs, hits.size());
+    std::partial_sort(hits.begin(), hits.begin() + k, hits.end(), hitGreater_);
+    for (size_t i = 0; i < k; ++i)
+    {
+        res_list.push_back(hits[i].first);
+        doclen_list.push_back(hits[i].second);
+    }
+}
+
+}
+}
+
+NS_IZENELIB_AM_END
+
+#endif
@@ -0,0 +1,416 @@
+#ifndef _FM_INDEX_TOPK_DOC_INDEX_HPP
+#define _FM_INDEX_TOPK_DOC_INDEX_HPP
+
+#include "const.hpp"
+#include <am/succinct/utils.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+
+NS_IZENELIB_AM_BEGIN
+
+namespace succinct
+{
+namespace fm_index
+{
+
+/**
+ * Precomputed top-k document retrieval over the doc array of an FM-index, after
+ * Hon, Shah and Vitter.
+ *
+ * Every sample_len-th leaf of the suffix tree is sampled, and the lowest common
+ * ancestor of each two neighbouring samples is marked, which is fewer than 2n /
+ * sample_len nodes. A marked node stores the max_k docs with the most
+ * occurrences in its suffix array range, and their numbers of occurrences.
+ *
+ * The range of a pattern contains the largest marked node below it but for fewer
+ * than 2 * sample_len positions at its ends. A doc in the top k of the pattern
+ * (k <= max_k) is either in the list of that node or occurs at those positions,
+ * so topK() counts only these candidates: it takes O(max_k + sample_len) rank and
+ * access queries on the doc array, however many times the pattern occurs.
+ *
+ * build() counts the marked nodes bottom up: a node sums the doc counts of its
+ * marked children and the docs at the positions not covered by a child. A node
+ * so costs its number of children's docs rather than its size, and the build is
+ * O(n + n / sample_len * d) for d docs, where counting every node over its range
+ * would be O(n^2 / sample_len) on repetitive text, as nested nodes cover most of
+ * the text again and again.
+ */
+class TopKDocIndex
+{
+public:
+    /// the occurrences of a doc, and the doc as in the doc array
+    typedef std::pair<size_t, uint32_t> DocFreqT;
+
+    TopKDocIndex(size_t max_k, size_t sample_len = 0)
+        : max_k_(max_k)
+        , sample_len_(sample_len ? sample_len : max_k * 16)
+    {
+    }
+
+    /**
+     * @p lcp is the LCP array of the suffix array, lcp[i] being the longest common
+     * prefix of the suffixes at i - 1 and i, and @p da the doc array, both of
+     * @p len values.
+     */
+    void build(const uint32_t *lcp, const uint32_t *da, size_t len);
+
+    void clear()
+    {
+        std::vector<size_t>().swap(node_begin_);
+        std::vector<size_t>().swap(node_end_);
+        std::vector<size_t>().swap(list_begin_);
+        std::vector<uint32_t>().swap(docs_);
+        std::vector<uint32_t>().swap(freqs_);
+    }
+
+    /**
+     * gets the @p k docs with the most occurrences in [@p sp, @p ep) of @p doc_array,
+     * most first and the smaller doc first on ties. If @p k is over max_k, or the
+     * range contains no marked node, it counts every doc of the range.
+     */
+    template <class DocArrayT>
+    void topK(const DocArrayT &doc_array, size_t sp, size_t ep, size_t k, std::vector<DocFreqT> &results) const;
+
+    /// gets the top @p k docs as topK() does, counting every doc of the range
+    template <class DocArrayT>
+    static void countTopK(const DocArrayT &doc_array, size_t sp, size_t ep, size_t k, std::vector<DocFreqT> &results);
+
+    inline size_t maxK() const
+    {
+        return max_k_;
+    }
+
+    inline size_t sampleLen() const
+    {
+        return sample_len_;
+    }
+
+    inline size_t nodeCount() const
+    {
+        return node_begin_.size();
+    }
+
+    size_t allocSize() const
+    {
+        return sizeof(TopKDocIndex)
+            + sizeof(size_t) * (node_begin_.size() + node_end_.size() + list_begin_.size())
+            + sizeof(uint32_t) * (docs_.size() + freqs_.size());
+    }
+
+    void save(std::ostream &ostr) const
+    {
+        ostr.write((const char *)&max_k_, sizeof(max_k_));
+        ostr.write((const char *)&sample_len_, sizeof(sample_len_));
+
+        SuccinctUtils::saveVec(ostr, node_begin_);
+        SuccinctUtils::saveVec(ostr, node_end_);
+        SuccinctUtils::saveVec(ostr, list_begin_);
+        SuccinctUtils::saveVec(ostr, docs_);
+        SuccinctUtils::saveVec(ostr, freqs_);
+    }
+
+    void load(std::istream &istr)
+    {
+        istr.read((char *)&max_k_, sizeof(max_k_));
+        istr.read((char *)&sample_len_, sizeof(sample_len_));
+
+        SuccinctUtils::loadVec(istr, node_begin_);
+        SuccinctUtils::loadVec(istr, node_end_);
+        SuccinctUtils::loadVec(istr, list_begin_);
+        SuccinctUtils::loadVec(istr, docs_);
+        SuccinctUtils::loadVec(istr, freqs_);
+    }
+
+private:
+    /// the nodes are ordered by their begins, and the larger first on a tie
+    static bool nodeLess_(const std::pair<size_t, size_t> &lhs, const std::pair<size_t, size_t> &rhs)
+    {
+        return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second > rhs.second);
+    }
+
+    static bool freqGreater_(const DocFreqT &lhs, const DocFreqT &rhs)
+    {
+        return lhs.first > rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+    }
+
+    static bool docLess_(const DocFreqT &lhs, const DocFreqT &rhs)
+    {
+        return lhs.second < rhs.second;
+    }
+
+    template <class DocArrayT>
+    static void appendDocs_(const DocArrayT &doc_array, size_t begin, size_t end, std::vector<uint32_t> &docs)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            docs.push_back(doc_array.access(i));
+        }
+    }
+
+    /// sums the occurrences of each doc in @p doc_freqs, through @p counts all 0
+    static void sumDocs_(std::vector<DocFreqT> &doc_freqs, std::vector<size_t> &counts);
+
+    /// counts @p docs by their runs after sorting them
+    static void countDocs_(std::vector<uint32_t> &docs, std::vector<DocFreqT> &doc_freqs);
+
+    static void selectTopK_(std::vector<DocFreqT> &doc_freqs, size_t k);
+
+    size_t max_k_;
+    size_t sample_len_;
+
+    std::vector<size_t> node_begin_;
+    std::vector<size_t> node_end_;
+
+    /// the top docs of node i are [list_begin_[i], list_begin_[i + 1]) of docs_ and freqs_
+    std::vector<size_t> list_begin_;
+    std::vector<uint32_t> docs_;
+    std::vector<uint32_t> freqs_;
+};
+
+inline void TopKDocIndex::build(const uint32_t *lcp, const uint32_t *da, size_t len)
+{
+    clear();
+    if (len == 0) return;
+
+    // the minimum LCP between each two neighbouring samples, in a sparse table
+    size_t sample_num = (len - 1) / sample_len_ + 1;
+    std::vector<std::vector<uint32_t> > gap_min(1, std::vector<uint32_t>(sample_num - 1));
+    for (size_t i = 0; i + 1 < sample_num; ++i)
+    {
+        gap_min[0][i] = *std::min_element(lcp + i * sample_len_ + 1, lcp + (i + 1) * sample_len_ + 1);
+    }
+    for (size_t width = 1; width * 2 <= gap_min[0].size(); width *= 2)
+    {
+        const std::vector<uint32_t> &prev = gap_min.back();
+        std::vector<uint32_t> next(prev.size() - width);
+        for (size_t i = 0; i < next.size(); ++i)
+        {
+            next[i] = std::min(prev[i], prev[i + width]);
+        }
+        gap_min.push_back(next);
+    }
+
+    // the LCP intervals bottom up; [begin, end) of value v is the LCA of two
+    // neighbouring samples iff the minimum between some two of its samples is v
+    std::vector<std::pair<size_t, size_t> > nodes;
+    std::vector<std::pair<uint32_t, size_t> > stack(1, std::make_pair(0U, 0UL));
+
+    for (size_t i = 1; i <= len; ++i)
+    {
+        uint32_t value = i < len ? lcp[i] : 0;
+        size_t begin = i - 1;
+
+        while (stack.size() > 1 && value < stack.back().first)
+        {
+            uint32_t node_value = stack.back().first;
+            begin = stack.back().second;
+            stack.pop_back();
+
+            size_t first = (begin + sample_len_ - 1) / sample_len_;
+            size_t last = (i - 1) / sample_len_;
+            if (first < last)
+            {
+                size_t level = SuccinctUtils::log2(last - first) - 1;
+                if (std::min(gap_min[level][first], gap_min[level][last - (1ULL << level)]) == node_value)
+                {
+                    nodes.push_back(std::make_pair(begin, i));
+                }
+            }
+        }
+
+        if (value > stack.back().first)
+        {
+            stack.push_back(std::make_pair(value, begin));
+        }
+    }
+    if (sample_num > 1)
+    {
+        nodes.push_back(std::make_pair(0UL, len));
+    }
+
+    std::vector<std::vector<uint32_t> >().swap(gap_min);
+    std::sort(nodes.begin(), nodes.end(), nodeLess_);
+
+    node_begin_.resize(nodes.size());
+    node_end_.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        node_begin_[i] = nodes[i].first;
+        node_end_[i] = nodes[i].second;
+    }
+
+    // the nodes nest, and come in preorder; each is counted when the next one
+    // is past its end, from the doc counts of its children and the positions
+    // between them, and its counts are then passed to its parent
+    uint32_t doc_num = *std::max_element(da, da + len) + 1;
+    std::vector<size_t> doc_counts(doc_num);
+    std::vector<std::vector<DocFreqT> > lists(nodes.size());
+    std::vector<std::vector<DocFreqT> > doc_freqs(nodes.size());
+    std::vector<size_t> covered(nodes.size());
+    std::vector<size_t> open;
+
+    for (size_t i = 0; i <= nodes.size(); ++i)
+    {
+        size_t begin = i < nodes.size() ? nodes[i].first : len;
+        while (!open.empty() && (i == nodes.size() || node_end_[open.back()] <= begin))
+        {
+            size_t node = open.back();
+            open.pop_back();
+
+            std::vector<DocFreqT> &counts = doc_freqs[node];
+            for (size_t j = covered[node]; j < node_end_[node]; ++j)
+            {
+                counts.push_back(DocFreqT(1, da[j]));
+            }
+            sumDocs_(counts, doc_counts);
+
+            lists[node] = counts;
+            selectTopK_(lists[node], max_k_);
+
+            if (!open.empty())
+            {
+                size_t parent = open.back();
+                for (size_t j = covered[parent]; j < node_begin_[node]; ++j)
+                {
+                    doc_freqs[parent].push_back(DocFreqT(1, da[j]));
+                }
+                covered[parent] = node_end_[node];
+                doc_freqs[parent].insert(doc_freqs[parent].end(), counts.begin(), counts.end());
+            }
+            std::vector<DocFreqT>().swap(counts);
+        }
+
+        if (i < nodes.size())
+        {
+            open.push_back(i);
+            covered[i] = begin;
+        }
+    }
+
+    list_begin_.resize(nodes.size() + 1);
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        list_begin_[i] = docs_.size();
+        for (size_t j = 0; j < lists[i].size(); ++j)
+        {
+            docs_.push_back(lists[i][j].second);
+            freqs_.push_back(lists[i][j].first);
+        }
+    }
+    list_begin_.back() = docs_.size();
+}
+
+template <class DocArrayT>
+void TopKDocIndex::topK(const DocArrayT &doc_array, size_t sp, size_t ep, size_t k, std::vector<DocFreqT> &results) const
+{
+    results.clear();
+    if (k == 0 || sp >= ep) return;
+
+    // the largest marked node in the range: the ones beginning with it and
+    // larger come first
+    size_t node = std::lower_bound(node_begin_.begin(), node_begin_.end(), sp) - node_begin_.begin();
+    for (; node < node_begin_.size() && node_begin_[node] == sp && node_end_[node] > ep; ++node);
+
+    if (k > max_k_ || node == node_begin_.size() || node_end_[node] > ep)
+    {
+        countTopK(doc_array, sp, ep, k, results);
+        return;
+    }
+
+    size_t begin = node_begin_[node];
+    size_t end = node_end_[node];
+
+    std::vector<uint32_t> docs;
+    appendDocs_(doc_array, sp, begin, docs);
+    appendDocs_(doc_array, end, ep, docs);
+    std::vector<DocFreqT> fringe;
+    countDocs_(docs, fringe);
+
+    for (size_t i = list_begin_[node]; i < list_begin_[node + 1]; ++i)
+    {
+        results.push_back(DocFreqT(freqs_[i], docs_[i]));
+    }
+    std::sort(results.begin(), results.end(), docLess_);
+
+    // the docs at the ends add to their occurrences in the node, which are
+    // counted on the doc array for the ones not listed
+    size_t listed = results.size();
+    for (size_t i = 0; i < fringe.size(); ++i)
+    {
+        std::vector<DocFreqT>::iterator it = std::lower_bound(results.begin(), results.begin() + listed, fringe[i], docLess_);
+        if (it != results.begin() + listed && it->second == fringe[i].second)
+        {
+            it->first += fringe[i].first;
+        }
+        else
+        {
+            uint32_t doc = fringe[i].second;
+            results.push_back(DocFreqT(fringe[i].first + doc_array.rank(doc, end) - doc_array.rank(doc, begin), doc));
+        }
+    }
+
+    selectTopK_(results, k);
+}
+
+template <class DocArrayT>
+void TopKDocIndex::countTopK(const DocArrayT &doc_array, size_t sp, size_t ep, size_t k, std::vector<DocFreqT> &results)
+{
+    std::vector<uint32_t> docs;
+    appendDocs_(doc_array, sp, ep, docs);
+    countDocs_(docs, results);
+    selectTopK_(results, k);
+}
+
+inline void TopKDocIndex::sumDocs_(std::vector<DocFreqT> &doc_freqs, std::vector<size_t> &counts)
+{
+    size_t last = 0;
+    for (size_t i = 0; i < doc_freqs.size(); ++i)
+    {
+        if (counts[doc_freqs[i].second] == 0) doc_freqs[last++].second = doc_freqs[i].second;
+        counts[doc_freqs[i].second] += doc_freqs[i].first;
+    }
+    doc_freqs.resize(last);
+
+    for (size_t i = 0; i < doc_freqs.size(); ++i)
+    {
+        doc_freqs[i].first = counts[doc_freqs[i].second];
+        counts[doc_freqs[i].second] = 0;
+    }
+}
+
+inline void TopKDocIndex::countDocs_(std::vector<uint32_t> &docs, std::vector<DocFreqT> &doc_freqs)
+{
+    std::sort(docs.begin(), docs.end());
+
+    doc_freqs.clear();
+    for (size_t i = 0; i < docs.size(); ++i)
+    {
+        if (i == 0 || docs[i] != docs[i - 1])
+            doc_freqs.push_back(DocFreqT(1, docs[i]));
+        else
+            ++doc_freqs.back().first;
+    }
+}
+
+inline void TopKDocIndex::selectTopK_(std::vector<DocFreqT> &doc_freqs, size_t k)
+{
+    if (doc_freqs.size() > k)
+    {
+        std::partial_sort(doc_freqs.begin(), doc_freqs.begin() + k, doc_freqs.end(), freqGreater_);
+        doc_freqs.resize(k);
+    }
+    else
+    {
+        std::sort(doc_freqs.begin(), doc_freqs.end(), freqGreater_);
+    }
+}
+
+}
+}
+
+NS_IZENELIB_AM_END
+
+#endif
@@ -86,6 +86,9 @@ public:
     void save(std::ostream &ostr) const;
     void load(std::istream &istr);
 
+    void saveAligned(AlignedWriter &writer) const;
+    void map(MappedReader &reader);
+
 private:
     void doIntersect_(
             const std::vector<std::pair<size_t, size_t> > &patterns,
@@ -1505,6 +1508,49 @@ void WaveletMatrix<CharT, BitmapT>::load(std::istream &istr)
     }
 }
 
+template <class CharT, class BitmapT>
+void WaveletMatrix<CharT, BitmapT>::saveAligned(AlignedWriter &writer) const
+{
+    WaveletTree<CharT>::saveAligned(writer);
+    occ_.saveAligned(writer);
+
+    writer.writeArray(&zero_counts_[0], zero_counts_.size());
+
+    for (size_t i = 0; i < nodes_.size(); ++i)
+    {
+        nodes_[i]->saveAligned(writer);
+    }
+}
+
+template <class CharT, class BitmapT>
+void WaveletMatrix<CharT, BitmapT>::map(MappedReader &reader)
+{
+    WaveletTree<CharT>::map(reader);
+    occ_.map(reader);
+
+    for (size_t i = 0; i < nodes_.size(); ++i)
+    {
+        if (nodes_[i]) delete nodes_[i];
+    }
+
+    size_t size = 0;
+    const size_t *zero_counts = reader.readArray<size_t>(size);
+    zero_counts_.assign(zero_counts, zero_counts + size);
+
+    nodes_.resize(this->alphabet_bit_num_);
+    for (size_t i = 0; i < nodes_.size(); ++i)
+    {
+        nodes_[i] = new node_type(this->support_select_);
+        nodes_[i]->map(reader);
+    }
+    for (size_t i = 1; i < nodes_.size(); ++i)
+    {
+        nodes_[i]->parent_ = nodes_[i - 1];
+        nodes_[i - 1]->left_ = nodes_[i];
+        nodes_[i - 1]->right_ = nodes_[i];
+    }
+}
+
 }
 }
 
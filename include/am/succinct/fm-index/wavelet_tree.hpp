@@ -3,6 +3,7 @@
 
 #include "const.hpp"
 #include <am/succinct/utils.hpp>
+#include <am/succinct/mapped_vector.hpp>
 
 
 NS_IZENELIB_AM_BEGIN
@@ -92,6 +93,20 @@ public:
         alphabet_bit_num_ = SuccinctUtils::log2(alphabet_num_ - 1);
     }
 
+    /// writes the aligned layout, whose bitmaps map() views in place
+    virtual void saveAligned(AlignedWriter &writer) const
+    {
+        writer.write(alphabet_num_);
+        writer.write(support_select_);
+    }
+
+    virtual void map(MappedReader &reader)
+    {
+        reader.read(alphabet_num_);
+        reader.read(support_select_);
+        alphabet_bit_num_ = SuccinctUtils::log2(alphabet_num_ - 1);
+    }
+
     static uint64_t getAlphabetNum(const char_type *char_seq, size_t len)
     {
         uint64_t num = 0;
@@ -34,6 +34,15 @@ public:
     size_t rank(char_type c, size_t pos) const;
     size_t select(char_type c, size_t rank) const;
 
+    /**
+     * sets @p positions[i] to rank(@p chars[i], @p positions[i]) for each i < @p num.
+     *
+     * The queries walk down the tree together, RANK_BATCH_SIZE of them at a time:
+     * the bitmaps of a level are prefetched for all of them before any rank is
+     * taken, so their cache misses overlap instead of following one another.
+     */
+    void rankBatch(const char_type *chars, size_t *positions, size_t num) const;
+
     void intersect(
             const std::vector<std::pair<size_t, size_t> > &patterns,
             size_t thres,
@@ -51,6 +60,9 @@ public:
     void save(std::ostream &ostr) const;
     void load(std::istream &istr);
 
+    void saveAligned(AlignedWriter &writer) const;
+    void map(MappedReader &reader);
+
 private:
     void makeCodeMap_(uint64_t code, size_t level, node_type *node);
 
@@ -69,6 +81,9 @@ private:
     void saveTree_(std::ostream &ostr, const node_type *node) const;
     void loadTree_(std::istream &istr, node_type *node);
 
+    void saveTreeAligned_(AlignedWriter &writer, const node_type *node) const;
+    void mapTree_(MappedReader &reader, node_type *node);
+
 private:
     std::vector<size_t> occ_;
     std::vector<uint64_t> code_map_;
@@ -314,6 +329,72 @@ size_t WaveletTreeHuffman<CharT, BitmapT>::rank(char_type c, size_t pos) const
     return 0;
 }
 
+template <class CharT, class BitmapT>
+void WaveletTreeHuffman<CharT, BitmapT>::rankBatch(const char_type *chars, size_t *positions, size_t num) const
+{
+    const node_type *walks[RANK_BATCH_SIZE];
+    uint64_t codes[RANK_BATCH_SIZE];
+
+    for (size_t begin = 0; begin < num; begin += RANK_BATCH_SIZE)
+    {
+        size_t batch_num = std::min(num - begin, RANK_BATCH_SIZE);
+        const char_type *batch_chars = chars + begin;
+        size_t *batch_positions = positions + begin;
+        size_t active = 0;
+
+        for (size_t i = 0; i < batch_num; ++i)
+        {
+            char_type c = batch_chars[i];
+            walks[i] = NULL;
+
+            if (c >= leaves_.size() || !leaves_[c])
+            {
+                batch_positions[i] = 0;
+                continue;
+            }
+
+            batch_positions[i] = std::min(batch_positions[i], length());
+            if (batch_positions[i] == 0) continue;
+
+            walks[i] = root_;
+            codes[i] = code_map_[c];
+            ++active;
+        }
+
+        for (size_t level = 0; active > 0; ++level)
+        {
+            for (size_t i = 0; i < batch_num; ++i)
+            {
+                if (walks[i]) walks[i]->prefetch(batch_positions[i]);
+            }
+
+            for (size_t i = 0; i < batch_num; ++i)
+            {
+                const node_type *walk = walks[i];
+                if (!walk) continue;
+
+                if (codes[i] & 1ULL << level)
+                {
+                    batch_positions[i] = walk->rank1(batch_positions[i]);
+                    walk = walk->right_;
+                }
+                else
+                {
+                    batch_positions[i] = walk->rank0(batch_positions[i]);
+                    walk = walk->left_;
+                }
+
+                if (!walk || batch_positions[i] == 0)
+                {
+                    walk = NULL;
+                    --active;
+                }
+                walks[i] = walk;
+            }
+        }
+    }
+}
+
 template <class CharT, class BitmapT>
 size_t WaveletTreeHuffman<CharT, BitmapT>::select(char_type c, size_t rank) const
 {
@@ -552,6 +633,87 @@ void WaveletTreeHuffman<CharT, BitmapT>::loadTree_(std::istream &istr, node_type
     }
 }
 
+template <class CharT, class BitmapT>
+void WaveletTreeHuffman<CharT, BitmapT>::saveAligned(AlignedWriter &writer) const
+{
+    WaveletTree<CharT>::saveAligned(writer);
+
+    writer.writeArray(&occ_[0], occ_.size());
+    writer.writeArray(&code_map_[0], code_map_.size());
+
+    uint32_t flag = root_ ? 1U : 0U;
+    writer.write(flag);
+    if (root_) saveTreeAligned_(writer, root_);
+}
+
+template <class CharT, class BitmapT>
+void WaveletTreeHuffman<CharT, BitmapT>::saveTreeAligned_(AlignedWriter &writer, const node_type *node) const
+{
+    node->saveAligned(writer);
+
+    uint32_t flag = (node->left_ ? 1U : 0U) | (node->right_ ? 2U : 0U);
+    writer.write(flag);
+
+    if (node->left_) saveTreeAligned_(writer, node->left_);
+    if (node->right_) saveTreeAligned_(writer, node->right_);
+}
+
+template <class CharT, class BitmapT>
+void WaveletTreeHuffman<CharT, BitmapT>::map(MappedReader &reader)
+{
+    WaveletTree<CharT>::map(reader);
+
+    if (root_) deleteTree_(root_);
+    root_ = NULL;
+
+    // the tables are small, and copied
+    size_t size = 0;
+    const size_t *occ = reader.readArray<size_t>(size);
+    occ_.assign(occ, occ + size);
+    const uint64_t *code_map = reader.readArray<uint64_t>(size);
+    code_map_.assign(code_map, code_map + size);
+
+    uint32_t flag = 0;
+    reader.read(flag);
+    if (flag)
+    {
+        root_ = new node_type(this->support_select_);
+        leaves_.resize(this->alphabet_num_);
+        mapTree_(reader, root_);
+    }
+}
+
+template <class CharT, class BitmapT>
+void WaveletTreeHuffman<CharT, BitmapT>::mapTree_(MappedReader &reader, node_type *node)
+{
+    node->map(reader);
+
+    uint32_t flag = 0;
+    reader.read(flag);
+
+    if (flag & 1U)
+    {
+        node->left_ = new node_type(this->support_select_);
+        node->left_->parent_ = node;
+        mapTree_(reader, node->left_);
+    }
+    else
+    {
+        leaves_[node->c0_] = node;
+    }
+
+    if (flag & 2U)
+    {
+        node->right_ = new node_type(this->support_select_);
+        node->right_->parent_ = node;
+        mapTree_(reader, node->right_);
+    }
+    else
+    {
+        leaves_[node->c1_] = node;
+    }
+}
+
 }
 }
 
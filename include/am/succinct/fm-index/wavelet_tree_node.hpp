@@ -3,6 +3,7 @@
 
 #include <am/succinct/rsdic/RSDic.hpp>
 #include <am/succinct/dbitv/dbitv.hpp>
+#include <am/succinct/cbitv/cbitv.hpp>
 
 
 NS_IZENELIB_AM_BEGIN
@@ -119,6 +120,7 @@ public:
     inline size_t rank0(size_t pos) const { return bitmap_.rank0(pos); }
     inline size_t rank1(size_t pos) const { return bitmap_.rank1(pos); }
     inline size_t rank(size_t pos, bool bit) const { return bitmap_.rank(pos, bit); }
+    inline void prefetch(size_t pos) const { bitmap_.prefetch(pos); }
 
     inline size_t select0(size_t ind) const { return bitmap_.select0(ind); }
     inline size_t select1(size_t ind) const { return bitmap_.select1(ind); }
@@ -149,6 +151,22 @@ public:
         bitmap_.load(istr);
     }
 
+    void saveAligned(AlignedWriter &writer) const
+    {
+        writer.write(c0_);
+        writer.write(c1_);
+
+        bitmap_.saveAligned(writer);
+    }
+
+    void map(MappedReader &reader)
+    {
+        reader.read(c0_);
+        reader.read(c1_);
+
+        bitmap_.map(reader);
+    }
+
     bool operator<(const self_type &rhs) const
     {
         return freq_ < rhs.freq_;
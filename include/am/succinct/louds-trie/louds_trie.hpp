@@ -0,0 +1,311 @@
+#ifndef _IZENELIB_AM_SUCCINCT_LOUDS_TRIE_LOUDS_TRIE_HPP
+#define _IZENELIB_AM_SUCCINCT_LOUDS_TRIE_LOUDS_TRIE_HPP
+
+#include <am/succinct/constants.hpp>
+#include <am/succinct/utils.hpp>
+#include <am/succinct/cbitv/cbitv.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include <iostream>
+
+
+NS_IZENELIB_AM_BEGIN
+
+namespace succinct
+{
+namespace louds
+{
+
+/**
+ * An in-memory trie of a static set of keys, in the level order unary degree
+ * sequence: the nodes are numbered in breadth first order from the root 0,
+ * each node writes a 1 per child then a 0, after a leading "10" for the root.
+ * So the children of node i are the nodes from select0(i) - i, and their
+ * number is the ones between the i-th and the (i+1)-th zero.
+ *
+ * The label of each node (of the edge into it) is kept by node number, and
+ * the children of a node are sorted by their labels.
+ *
+ * intersect() walks the trie together with an automaton, which has
+ *
+ *     typedef ... State;
+ *     State start() const;
+ *     bool next(const State& state, CharT c, State& next) const; // false if dead
+ *     bool isFinal(const State& state) const;
+ *
+ * and does not descend below a node once the automaton is dead, so only the
+ * prefixes the automaton could still accept are visited.
+ */
+template <class CharT, class BitVectorT = cbitv::CBitV>
+class LoudsTrie
+{
+public:
+    typedef CharT char_type;
+
+    LoudsTrie()
+        : louds_(true), terminal_(false), key_num_()
+    {
+    }
+
+    /**
+     * builds from @p keys, sorted and unique; a key has length() and operator[].
+     */
+    template <class StringT>
+    void build(const std::vector<StringT> &keys);
+
+    /// the keys of the trie appended to @p keys, in sorted order
+    template <class StringT>
+    void keys(std::vector<StringT> &keys) const;
+
+    /// @return true if @p key is in the trie
+    template <class StringT>
+    bool contains(const StringT &key) const;
+
+    /**
+     * appends the keys accepted by @p automaton to @p results in sorted
+     * order, at most @p limit of them.
+     */
+    template <class AutomatonT, class StringT>
+    void intersect(const AutomatonT &automaton, std::vector<StringT> &results, size_t limit = (size_t)-1) const;
+
+    void clear()
+    {
+        louds_.clear();
+        terminal_.clear();
+        std::vector<CharT>().swap(labels_);
+        key_num_ = 0;
+    }
+
+    void swap(LoudsTrie &other)
+    {
+        std::swap(louds_, other.louds_);
+        std::swap(terminal_, other.terminal_);
+        labels_.swap(other.labels_);
+        std::swap(key_num_, other.key_num_);
+    }
+
+    /// the number of keys
+    size_t size() const
+    {
+        return key_num_;
+    }
+
+    size_t nodeCount() const
+    {
+        return labels_.size();
+    }
+
+    void save(std::ostream &os) const
+    {
+        os.write((const char *)&key_num_, sizeof(key_num_));
+        louds_.save(os);
+        terminal_.save(os);
+        SuccinctUtils::saveVec(os, labels_);
+    }
+
+    void load(std::istream &is)
+    {
+        clear();
+        is.read((char *)&key_num_, sizeof(key_num_));
+        louds_.load(is);
+        terminal_.load(is);
+        SuccinctUtils::loadVec(is, labels_);
+    }
+
+    size_t allocSize() const
+    {
+        return sizeof(LoudsTrie) - sizeof(louds_) - sizeof(terminal_)
+            + louds_.allocSize() + terminal_.allocSize()
+            + sizeof(CharT) * labels_.size();
+    }
+
+private:
+    /// the keys sharing the prefix of a node
+    struct KeyRange_
+    {
+        size_t begin;
+        size_t end;
+        size_t depth;
+    };
+
+    /// the first child of @p node, and one past its last child
+    inline void children_(size_t node, size_t &first, size_t &last) const
+    {
+        size_t start = louds_.select0(node);
+        first = start - node;
+        last = louds_.select0(node + 1) - node - 1;
+    }
+
+    inline bool isTerminal_(size_t node) const
+    {
+        return terminal_.access(node);
+    }
+
+    template <class AutomatonT, class StringT>
+    void intersect_(const AutomatonT &automaton, size_t node,
+            const typename AutomatonT::State &state, std::vector<CharT> &path,
+            std::vector<StringT> &results, size_t limit) const;
+
+    template <class StringT>
+    void keys_(size_t node, std::vector<CharT> &path, std::vector<StringT> &keys) const;
+
+    template <class StringT>
+    static StringT toString_(const std::vector<CharT> &path)
+    {
+        return path.empty() ? StringT() : StringT(&path[0], path.size());
+    }
+
+    static void setBit_(std::vector<uint64_t> &bits, size_t pos)
+    {
+        if (pos / 64 >= bits.size()) bits.resize(pos / 64 + 1);
+        bits[pos / 64] |= 1ULL << (pos % 64);
+    }
+
+    BitVectorT louds_;
+    BitVectorT terminal_;
+    std::vector<CharT> labels_;
+    size_t key_num_;
+};
+
+template <class CharT, class BitVectorT>
+template <class StringT>
+void LoudsTrie<CharT, BitVectorT>::build(const std::vector<StringT> &keys)
+{
+    clear();
+
+    std::vector<uint64_t> louds_bits, terminal_bits;
+    size_t louds_len = 0;
+    setBit_(louds_bits, louds_len++);
+    ++louds_len;
+
+    // the nodes in breadth first order
+    std::deque<KeyRange_> queue;
+    KeyRange_ root = { 0, keys.size(), 0 };
+    queue.push_back(root);
+    labels_.push_back(CharT());
+
+    for (size_t node = 0; !queue.empty(); ++node)
+    {
+        KeyRange_ range = queue.front();
+        queue.pop_front();
+
+        size_t i = range.begin;
+        if (i < range.end && (size_t)keys[i].length() == range.depth)
+        {
+            setBit_(terminal_bits, node);
+            ++i;
+        }
+
+        while (i < range.end)
+        {
+            CharT c = keys[i][range.depth];
+            size_t j = i + 1;
+            while (j < range.end && keys[j][range.depth] == c) ++j;
+
+            KeyRange_ child = { i, j, range.depth + 1 };
+            queue.push_back(child);
+            labels_.push_back(c);
+            setBit_(louds_bits, louds_len++);
+            i = j;
+        }
+        ++louds_len;
+    }
+
+    louds_bits.resize((louds_len + 63) / 64);
+    terminal_bits.resize((labels_.size() + 63) / 64);
+    louds_.build(louds_bits, louds_len);
+    terminal_.build(terminal_bits, labels_.size());
+    key_num_ = keys.size();
+}
+
+template <class CharT, class BitVectorT>
+template <class StringT>
+void LoudsTrie<CharT, BitVectorT>::keys(std::vector<StringT> &keys) const
+{
+    if (key_num_ == 0) return;
+
+    std::vector<CharT> path;
+    keys.reserve(keys.size() + key_num_);
+    keys_(0, path, keys);
+}
+
+template <class CharT, class BitVectorT>
+template <class StringT>
+void LoudsTrie<CharT, BitVectorT>::keys_(size_t node, std::vector<CharT> &path, std::vector<StringT> &keys) const
+{
+    if (isTerminal_(node)) keys.push_back(toString_<StringT>(path));
+
+    size_t first, last;
+    children_(node, first, last);
+    for (size_t child = first; child < last; ++child)
+    {
+        path.push_back(labels_[child]);
+        keys_(child, path, keys);
+        path.pop_back();
+    }
+}
+
+template <class CharT, class BitVectorT>
+template <class StringT>
+bool LoudsTrie<CharT, BitVectorT>::contains(const StringT &key) const
+{
+    if (key_num_ == 0) return false;
+
+    size_t node = 0;
+    for (size_t i = 0; i < (size_t)key.length(); ++i)
+    {
+        size_t first, last;
+        children_(node, first, last);
+
+        const CharT *it = std::lower_bound(&labels_[0] + first, &labels_[0] + last, (CharT)key[i]);
+        if (it == &labels_[0] + last || *it != (CharT)key[i]) return false;
+        node = it - &labels_[0];
+    }
+    return isTerminal_(node);
+}
+
+template <class CharT, class BitVectorT>
+template <class AutomatonT, class StringT>
+void LoudsTrie<CharT, BitVectorT>::intersect(const AutomatonT &automaton, std::vector<StringT> &results, size_t limit) const
+{
+    if (key_num_ == 0 || limit == 0) return;
+
+    std::vector<CharT> path;
+    intersect_(automaton, 0, automaton.start(), path, results, results.size() + limit);
+}
+
+template <class CharT, class BitVectorT>
+template <class AutomatonT, class StringT>
+void LoudsTrie<CharT, BitVectorT>::intersect_(const AutomatonT &automaton, size_t node,
+        const typename AutomatonT::State &state, std::vector<CharT> &path,
+        std::vector<StringT> &results, size_t limit) const
+{
+    if (isTerminal_(node) && automaton.isFinal(state))
+    {
+        results.push_back(toString_<StringT>(path));
+        if (results.size() >= limit) return;
+    }
+
+    size_t first, last;
+    children_(node, first, last);
+
+    typename AutomatonT::State next;
+    for (size_t child = first; child < last; ++child)
+    {
+        if (!automaton.next(state, labels_[child], next)) continue;
+
+        path.push_back(labels_[child]);
+        intersect_(automaton, child, next, path, results, limit);
+        path.pop_back();
+        if (results.size() >= limit) return;
+    }
+}
+
+}
+}
+
+NS_IZENELIB_AM_END
+
+#endif
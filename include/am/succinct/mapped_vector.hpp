@@ -0,0 +1,408 @@
+#ifndef _IZENELIB_AM_SUCCINCT_MAPPED_VECTOR_HPP
+#define _IZENELIB_AM_SUCCINCT_MAPPED_VECTOR_HPP
+
+#include <types.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+NS_IZENELIB_AM_BEGIN
+
+namespace succinct
+{
+
+/**
+ * The arrays of the aligned layout start at multiples of kMappedAlignment bytes
+ * from the beginning of the layout, so the cache aligned blocks of the bit
+ * vectors stay aligned when the layout is mapped at the beginning of a file.
+ */
+static const size_t kMappedAlignment = 64;
+
+/**
+ * The head of a file of the aligned layout, written by AlignedWriter::writeHeader(),
+ * so that mapping the file of another format, e.g. of save(), fails at once.
+ * The layout is in the byte order of the host, the magic of another one differs.
+ */
+static const uint32_t kMappedMagic = 0x4c41494dU; // "MIAL"
+static const uint32_t kMappedVersion = 1;
+
+/**
+ * A file mapped read only. The structures viewing it hold it by MappedRegionPtr,
+ * so it is unmapped with the last of them.
+ */
+class MappedRegion : boost::noncopyable
+{
+public:
+    MappedRegion() : data_(), size_() {}
+
+    ~MappedRegion()
+    {
+        close();
+    }
+
+    bool open(const std::string &path)
+    {
+        close();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void *data = ::mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) return false;
+
+        data_ = static_cast<const char *>(data);
+        size_ = st.st_size;
+        return true;
+    }
+
+    void close()
+    {
+        if (data_) ::munmap(const_cast<char *>(data_), size_);
+        data_ = NULL;
+        size_ = 0;
+    }
+
+    const char *data() const
+    {
+        return data_;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+private:
+    const char *data_;
+    size_t size_;
+};
+
+typedef boost::shared_ptr<MappedRegion> MappedRegionPtr;
+
+/**
+ * Writes the aligned layout: values as they are, arrays as their size then
+ * their elements from the next multiple of kMappedAlignment.
+ */
+class AlignedWriter
+{
+public:
+    explicit AlignedWriter(std::ostream &os)
+        : os_(os), offset_()
+    {
+    }
+
+    /// writes the magic and the version, at the beginning of a file
+    void writeHeader()
+    {
+        write(kMappedMagic);
+        write(kMappedVersion);
+    }
+
+    template <class T>
+    void write(const T &value)
+    {
+        os_.write((const char *)&value, sizeof(value));
+        offset_ += sizeof(value);
+    }
+
+    template <class T>
+    void writeArray(const T *data, size_t size)
+    {
+        write(size);
+
+        static const char padding[kMappedAlignment] = {};
+        size_t padding_size = (kMappedAlignment - offset_ % kMappedAlignment) % kMappedAlignment;
+        os_.write(padding, padding_size);
+        offset_ += padding_size;
+
+        os_.write((const char *)data, sizeof(T) * size);
+        offset_ += sizeof(T) * size;
+    }
+
+    size_t offset() const
+    {
+        return offset_;
+    }
+
+private:
+    std::ostream &os_;
+    size_t offset_;
+};
+
+/**
+ * Reads the layout of AlignedWriter from a mapped region: values are copied,
+ * arrays are returned in place. Reading past the end of the region, as of a
+ * truncated file, throws std::out_of_range.
+ */
+class MappedReader
+{
+public:
+    explicit MappedReader(const MappedRegionPtr &region)
+        : region_(region), offset_()
+    {
+    }
+
+    /// @return false unless the magic and the version of writeHeader() follow
+    bool readHeader()
+    {
+        if (region_->size() - offset_ < 2 * sizeof(uint32_t))
+            return false;
+
+        uint32_t magic, version;
+        read(magic);
+        read(version);
+        return magic == kMappedMagic && version == kMappedVersion;
+    }
+
+    template <class T>
+    void read(T &value)
+    {
+        check_(sizeof(value));
+        memcpy(&value, region_->data() + offset_, sizeof(value));
+        offset_ += sizeof(value);
+    }
+
+    template <class T>
+    const T *readArray(size_t &size)
+    {
+        size_t array_size;
+        read(array_size);
+        size_t padding_size = (kMappedAlignment - offset_ % kMappedAlignment) % kMappedAlignment;
+        check_(padding_size);
+        offset_ += padding_size;
+
+        if (array_size > (region_->size() - offset_) / sizeof(T))
+            throw std::out_of_range("MappedReader: array past the end of the region");
+        const T *data = reinterpret_cast<const T *>(region_->data() + offset_);
+        offset_ += sizeof(T) * array_size;
+        size = array_size;
+        return data;
+    }
+
+    const MappedRegionPtr &region() const
+    {
+        return region_;
+    }
+
+    size_t offset() const
+    {
+        return offset_;
+    }
+
+private:
+    void check_(size_t size) const
+    {
+        if (size > region_->size() - offset_)
+            throw std::out_of_range("MappedReader: read past the end of the region");
+    }
+
+    MappedRegionPtr region_;
+    size_t offset_;
+};
+
+/// the deleter of a boost::shared_array viewing a mapped region, which keeps the region
+struct MappedRegionHolder
+{
+    MappedRegionPtr region;
+
+    explicit MappedRegionHolder(const MappedRegionPtr &r) : region(r) {}
+
+    void operator()(const void *) const {}
+};
+
+/**
+ * A vector which either owns its elements, or views an array of a mapped
+ * region after map().
+ *
+ * The const accessors read either the same way; changing a mapped vector
+ * copies it into an owned one first.
+ */
+template <class T>
+class MappedVector
+{
+public:
+    typedef T value_type;
+
+    MappedVector()
+        : data_(), size_()
+    {
+    }
+
+    MappedVector(const MappedVector &other)
+        : vec_(other.vec_), region_(other.region_)
+        , data_(other.data_), size_(other.size_)
+    {
+        if (!region_) sync_();
+    }
+
+    MappedVector &operator=(const MappedVector &other)
+    {
+        MappedVector(other).swap(*this);
+        return *this;
+    }
+
+    inline size_t size() const
+    {
+        return size_;
+    }
+
+    inline bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    inline bool mapped() const
+    {
+        return region_.get() != NULL;
+    }
+
+    inline const T *data() const
+    {
+        return data_;
+    }
+
+    inline const T &operator[](size_t i) const
+    {
+        return data_[i];
+    }
+
+    inline T &operator[](size_t i)
+    {
+        own_();
+        return vec_[i];
+    }
+
+    inline const T &back() const
+    {
+        return data_[size_ - 1];
+    }
+
+    inline T &back()
+    {
+        own_();
+        return vec_.back();
+    }
+
+    size_t capacity() const
+    {
+        return region_ ? size_ : vec_.capacity();
+    }
+
+    void push_back(const T &value)
+    {
+        own_();
+        vec_.push_back(value);
+        sync_();
+    }
+
+    void resize(size_t size, const T &value = T())
+    {
+        own_();
+        vec_.resize(size, value);
+        sync_();
+    }
+
+    /// frees the elements, as swapping with an empty std::vector does
+    void clear()
+    {
+        region_.reset();
+        std::vector<T>().swap(vec_);
+        sync_();
+    }
+
+    /// drops the spare capacity of an owned vector
+    void shrink()
+    {
+        if (!region_ && vec_.capacity() > vec_.size())
+        {
+            std::vector<T>(vec_).swap(vec_);
+            sync_();
+        }
+    }
+
+    void swap(MappedVector &other)
+    {
+        vec_.swap(other.vec_);
+        region_.swap(other.region_);
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+    }
+
+    /// the format of SuccinctUtils::saveVec()
+    void save(std::ostream &os) const
+    {
+        os.write((const char *)&size_, sizeof(size_));
+        os.write((const char *)data_, sizeof(T) * size_);
+    }
+
+    void load(std::istream &is)
+    {
+        size_t size = 0;
+        is.read((char *)&size, sizeof(size));
+        clear();
+        vec_.resize(size);
+        is.read((char *)&vec_[0], sizeof(T) * size);
+        sync_();
+    }
+
+    void saveAligned(AlignedWriter &writer) const
+    {
+        writer.writeArray(data_, size_);
+    }
+
+    void map(MappedReader &reader)
+    {
+        size_t size = 0;
+        const T *data = reader.readArray<T>(size);
+        std::vector<T>().swap(vec_);
+        data_ = data;
+        size_ = size;
+        region_ = reader.region();
+    }
+
+private:
+    void own_()
+    {
+        if (!region_) return;
+
+        vec_.assign(data_, data_ + size_);
+        region_.reset();
+        sync_();
+    }
+
+    void sync_()
+    {
+        data_ = vec_.empty() ? NULL : &vec_[0];
+        size_ = vec_.size();
+    }
+
+    std::vector<T> vec_;
+    MappedRegionPtr region_;
+    const T *data_;
+    size_t size_;
+};
+
+}
+
+NS_IZENELIB_AM_END
+
+#endif
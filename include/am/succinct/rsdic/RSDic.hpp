@@ -21,6 +21,7 @@
 #define RSDIC_RSDIC_HPP_
 
 #include <am/succinct/constants.hpp>
+#include <am/succinct/mapped_vector.hpp>
 
 #include <boost/shared_array.hpp>
 #include <vector>
@@ -50,12 +51,23 @@ public:
     size_t rank1(size_t pos) const;
     size_t rank(size_t pos, bool bit) const;
 
+    /// prefetches the rank block of @p pos, ahead of a rank at @p pos
+    inline void prefetch(size_t pos) const
+    {
+        __builtin_prefetch(rank_blocks_.get() + pos / kLargeBlockSize);
+    }
+
     size_t select0(size_t ind) const;
     size_t select1(size_t ind) const;
     size_t select(size_t ind, bool bit) const;
 
     void save(std::ostream& os) const;
     void load(std::istream& is);
+
+    /// writes the aligned layout, which map() views in place
+    void saveAligned(AlignedWriter& writer) const;
+    void map(MappedReader& reader);
+
     size_t allocSize() const;
 
     bool support_select() const
@@ -94,11 +106,11 @@ private:
     size_t num_;
     size_t one_num_;
 
-    std::vector<uint64_t> bits_;
+    MappedVector<uint64_t> bits_;
     boost::shared_array<RankBlock> rank_blocks_;
 
-    std::vector<size_t> select_one_inds_;
-    std::vector<size_t> select_zero_inds_;
+    MappedVector<size_t> select_one_inds_;
+    MappedVector<size_t> select_zero_inds_;
 };
 
 }
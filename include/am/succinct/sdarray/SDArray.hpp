@@ -21,6 +21,7 @@
 #define SDARRAY_SDARRAY_HPP__
 
 #include <types.h>
+#include <am/succinct/mapped_vector.hpp>
 
 #include <vector>
 #include <iostream>
@@ -83,6 +84,11 @@ public:
 
     void save(std::ostream& os) const;
     void load(std::istream& is);
+
+    /// writes the aligned layout, which map() views in place
+    void saveAligned(AlignedWriter& writer) const;
+    void map(MappedReader& reader);
+
     void swap(SDArray& other)
     {
         std::swap(size_, other.size_);
@@ -106,8 +112,8 @@ private:
     size_t size_;
     size_t sum_;
 
-    std::vector<size_t> Ltable_;
-    std::vector<size_t> B_;
+    MappedVector<size_t> Ltable_;
+    MappedVector<size_t> B_;
     std::vector<size_t> vals_;
 };
 
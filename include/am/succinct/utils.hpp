@@ -41,6 +41,11 @@ public:
     static void SetSlice(std::vector<uint64_t>& bits,
                          size_t pos, size_t len, uint64_t val);
 
+    static uint64_t GetSlice(const uint64_t* bits,
+                             size_t pos, size_t len);
+    static void SetSlice(uint64_t* bits,
+                         size_t pos, size_t len, uint64_t val);
+
     static size_t selectBlock(uint64_t blk, size_t r);
 
     static uint64_t bitReverse(uint64_t v, size_t bit_num);
@@ -20,6 +20,8 @@
 #ifndef WAT_ARRAY_BIT_ARRAY_HPP_
 #define WAT_ARRAY_BIT_ARRAY_HPP_
 
+#include <am/succinct/mapped_vector.hpp>
+
 #include <stdint.h>
 #include <vector>
 #include <iostream>
@@ -28,6 +30,12 @@
 namespace wat_array
 {
 
+using izenelib::am::succinct::AlignedWriter;
+using izenelib::am::succinct::MappedReader;
+using izenelib::am::succinct::MappedRegion;
+using izenelib::am::succinct::MappedRegionPtr;
+using izenelib::am::succinct::MappedVector;
+
 enum
 {
     NOTFOUND = 0xFFFFFFFFFFFFFFFFLLU
@@ -68,13 +76,19 @@ public:
     void Save(std::ostream& os) const;
     void Load(std::istream& is);
 
+    /*
+     * Save with the rank tables in the aligned layout, which Map() views in place
+     */
+    void SaveAligned(AlignedWriter& writer) const;
+    void Map(MappedReader& reader);
+
 private:
     uint64_t RankOne(uint64_t pos) const;
     uint64_t SelectOutBlock(uint64_t bit, uint64_t& rank) const;
 
 private:
-    std::vector<uint64_t> bit_blocks_;
-    std::vector<uint64_t> rank_tables_;
+    MappedVector<uint64_t> bit_blocks_;
+    MappedVector<uint64_t> rank_tables_;
     uint64_t length_;
     uint64_t one_num_;
 };
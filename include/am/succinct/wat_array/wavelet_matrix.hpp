@@ -220,6 +220,23 @@ public:
      */
     void Load(std::istream& is);
 
+    /**
+     * Save the current status in the aligned layout, which Map() opens in place
+     * @param os The output stream where the data is saved
+     */
+    void SaveAligned(std::ostream& os) const;
+    void SaveAligned(AlignedWriter& writer) const;
+
+    /**
+     * Open the status saved by SaveAligned() in a file, viewing the bit arrays
+     * in the file mapped read only instead of reading them
+     * @param path The file where the status is saved
+     * @return false if the file can not be mapped, of another format or
+     * truncated, leaving the status unchanged
+     */
+    bool Map(const std::string& path);
+    void Map(MappedReader& reader);
+
 protected:
     uint64_t GetAlphabetNum(const std::vector<uint64_t>& array) const;
     uint64_t Log2(uint64_t x) const;
@@ -9,6 +9,7 @@
  * izenelib::am::raw::Buffer
  */
 #include <am/concept/DataType.h>
+#include <am/concept/WriteBatch.h>
 #include <am/raw/Buffer.h>
 #include <am/tc/String.h>
 #include <am/range/IterNextRange.h>
@@ -19,6 +20,8 @@
 
 #include <boost/optional.hpp>
 
+#include <vector>
+
 namespace izenelib {
 namespace am {
 namespace tc {
@@ -237,6 +240,63 @@ public:
         return false;
     }
 
+    /**
+     * @brief Get values of all @p keys.
+     *
+     * @return number of keys found, found[i] tells whether values[i] is set.
+     */
+    std::size_t multiGet(const std::vector<Buffer>& keys,
+                         std::vector<Buffer>& values,
+                         std::vector<bool>& found) const
+    {
+        values.resize(keys.size());
+        found.assign(keys.size(), false);
+        if (!checkHandle_(hdb_) || !isOpened())
+            return 0;
+
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            if (get(keys[i], values[i]))
+            {
+                found[i] = true;
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief Apply all operations in order, BATCH_INSERT keeps existing
+     * records as insert() does.
+     *
+     * @return true if every operation succeeded
+     */
+    bool writeBatch(const WriteBatch<Buffer, Buffer>& batch)
+    {
+        if (!checkHandle_(hdb_) || !isOpened())
+            return false;
+
+        bool ret = true;
+        for (WriteBatch<Buffer, Buffer>::const_iterator it = batch.begin();
+                it != batch.end(); ++it)
+        {
+            switch (it->type)
+            {
+            case BATCH_INSERT:
+                ret = insert(it->key, it->value) && ret;
+                break;
+            case BATCH_UPDATE:
+                ret = update(it->key, it->value) && ret;
+                break;
+            case BATCH_DEL:
+                ret = del(it->key) && ret;
+                break;
+            }
+        }
+        return ret;
+    }
+
     bool exist(const Buffer& key) const
     {
         return checkHandle_(hdb_) && isOpened() &&
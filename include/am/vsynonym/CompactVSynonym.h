@@ -0,0 +1,127 @@
+/**
+ * \file CompactVSynonym.h
+ * \brief the read only, mapped version of the VSynonymContainer
+ */
+
+#ifndef _COMPACT_VSYNONYM_H
+#define	_COMPACT_VSYNONYM_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <am/vsynonym/VSynonym.h>
+#include <am/succinct/marisa/trie.h>
+
+#include <types.h>
+
+NS_IZENELIB_AM_BEGIN
+
+/**
+ * \brief the synonym dictionary of a VSynonymContainer, mapped from a file
+ *
+ * The keys are in a marisa trie, each key id pointing to its synonym entry
+ * list in the format of VSynonym, so a dictionary is built once offline from
+ * a loaded VSynonymContainer, and the file is mapped as it is by load(),
+ * without parsing, and shared by the processes mapping it.
+ *
+ * Besides the exact search, the keys being prefixes of a string are found
+ * in one walk of the trie, so expandQuery() takes the longest synonym at
+ * each token by a common prefix search, instead of one search per length.
+ *
+ * It is read only, and the searches may be called from several threads.
+ */
+class CompactVSynonymContainer {
+public:
+    CompactVSynonymContainer();
+
+    ~CompactVSynonymContainer();
+
+    /**
+     * Write the synonyms of the container into a file to load.
+     * \param container the container with the synonym dictionary loaded
+     * \param path the path of the file to write
+     * \return 0 if occur error and 1 if works fine
+     */
+    static int build(VSynonymContainer& container, const char* path);
+
+    /**
+     * Map the file written by build(), unmapping the one mapped before.
+     * \param path the path of the file
+     * \return 0 if occur error and 1 if works fine
+     */
+    int load(const char* path);
+
+    /**
+     * Unmap the file
+     */
+    void close();
+
+    /**
+     * Get the synonyms with specific key, if found nothing, data in the
+     * VSynonym is set NULL.
+     * \param key specific key to find the synonyms
+     * \param synonym VSynonym object to store the data
+     * \return true if the key exists
+     */
+    bool get_synonyms(const std::string& key, VSynonym& synonym) const;
+
+    /**
+     * Find the longest key being a prefix of the string.
+     * \param str the string
+     * \param len the length of the string
+     * \param synonym VSynonym object to store the data of the key
+     * \return the length of the key, 0 if no key is a prefix
+     */
+    size_t longestMatch(const char* str, size_t len, VSynonym& synonym) const;
+
+    /**
+     * Find all the keys being prefixes of the string.
+     * \param str the string
+     * \param len the length of the string
+     * \param matches the length and the synonyms of each key, from the shortest
+     */
+    void commonPrefixSearch(const char* str, size_t len,
+            std::vector<std::pair<size_t, VSynonym> >& matches) const;
+
+    /**
+     * Expand the query with the longest synonyms starting at its tokens, in
+     * the units of VSynonymContainer::expandQuery()
+     */
+    VExpandedQuery* expandQuery(const std::string& query) const;
+
+    /**
+     * Get the number of the keys
+     */
+    size_t keyCount() const;
+
+    /**
+     * Get the size of the mapped file
+     */
+    size_t size() const;
+
+private:
+    CompactVSynonymContainer(const CompactVSynonymContainer&);
+    CompactVSynonymContainer& operator=(const CompactVSynonymContainer&);
+
+    inline void setSynonym(size_t keyId, VSynonym& synonym) const;
+
+private:
+    /** the keys */
+    marisa::Trie trie_;
+
+    /** the mapped file */
+    uint8_t* data_;
+
+    size_t dataSize_;
+
+    /** the offset of the entry list by key id, with the more long bit */
+    const uint32_t* entries_;
+
+    /** the entry lists, as in VSynonymContainer */
+    uint8_t* value_;
+};
+
+NS_IZENELIB_AM_END
+
+#endif	/* _COMPACT_VSYNONYM_H */
@@ -255,6 +255,17 @@ public:
 
     VTrie* getData();
 
+    /**
+     * Get the synonym entry lists, the data of the VTrie nodes being their
+     * offsets in it
+     */
+    uint8_t* getValue();
+
+    /**
+     * Get the used length of getValue()
+     */
+    size_t getValueLength();
+
     /**
      * load the data from the file
      * \param pathDic the path of the synonym dictionary file
@@ -0,0 +1,323 @@
+/**
+ * @file	FrontCodedNameStore.h
+ * @brief	A frozen ID->String store, the strings front coded in their byte
+ *          order and looked up by an ID ordered permutation.
+ */
+
+#ifndef _FRONT_CODED_NAME_STORE_H_
+#define _FRONT_CODED_NAME_STORE_H_
+
+#include <types.h>
+#include <am/succinct/mapped_vector.hpp>
+
+#include "NameIDTraits.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+NS_IZENELIB_IR_BEGIN
+
+namespace idmanager {
+
+/**
+ * The strings are sorted by their bytes and cut into blocks of BlockSize
+ * strings. The first string of a block is kept whole, the others as the
+ * length of the prefix shared with the previous one and the rest, so a
+ * string is decoded from the beginning of its block.
+ *
+ * The IDs are kept sorted, each with the rank of its string, and looked up
+ * by binary search. The arrays are written in the aligned layout, so a
+ * store saved by save() is used in place after map().
+ */
+template <typename  NameString,
+          typename  NameID>
+class FrontCodedNameStore
+{
+    typedef izenelib::am::succinct::AlignedWriter AlignedWriter;
+    typedef izenelib::am::succinct::MappedReader MappedReader;
+    typedef izenelib::am::succinct::MappedRegion MappedRegion;
+    typedef izenelib::am::succinct::MappedRegionPtr MappedRegionPtr;
+
+    /// a string as its bytes, with its id
+    typedef std::pair<std::string, NameID> ByteName;
+
+public:
+    enum { BlockSize = 16 };
+
+    FrontCodedNameStore()
+        : count_(0)
+    {
+    }
+
+    size_t size() const
+    {
+        return count_;
+    }
+
+    /**
+     * @brief This function returns the String for a given ID.
+     * @return false if the ID is not in the store
+     */
+    bool get(const NameID& nameID, NameString& nameString) const
+    {
+        const NameID* begin = ids_.data();
+        const NameID* it = std::lower_bound(begin, begin + count_, nameID);
+        if (it == begin + count_ || *it != nameID) return false;
+
+        std::string bytes;
+        decode_(ranks_[it - begin], bytes);
+        NameStringBytes<NameString>::assign(nameString, bytes.data(), bytes.size());
+        return true;
+    }
+
+    /**
+     * @brief builds the store from the pairs of @p base and @p names, the
+     * pairs of @p names replacing those of @p base with the same IDs.
+     */
+    void build(const FrontCodedNameStore& base,
+            const std::vector<std::pair<NameID, NameString> >& names)
+    {
+        std::vector<ByteName> added(names.size());
+        std::vector<NameID> addedIds(names.size());
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            const NameString& nameString = names[i].second;
+            added[i].first.assign(NameStringBytes<NameString>::data(nameString),
+                    NameStringBytes<NameString>::size(nameString));
+            added[i].second = addedIds[i] = names[i].first;
+        }
+        std::sort(added.begin(), added.end());
+        std::sort(addedIds.begin(), addedIds.end());
+
+        // the ids of base in the order of their strings
+        std::vector<NameID> rankIds(base.count_);
+        for (size_t i = 0; i < base.count_; ++i)
+            rankIds[base.ranks_[i]] = base.ids_[i];
+
+        FrontCodedNameStore store;
+        std::vector<std::pair<NameID, uint32_t> > idRanks;
+        idRanks.reserve(base.count_ + added.size());
+
+        std::string last, bytes;
+        const char* p = NULL;
+        size_t next = 0;
+        for (size_t rank = 0; rank < base.count_; ++rank)
+        {
+            if (rank % BlockSize == 0)
+                p = base.bytes_.data() + base.blocks_[rank / BlockSize];
+            decodeNext_(p, rank % BlockSize == 0, bytes);
+            if (std::binary_search(addedIds.begin(), addedIds.end(), rankIds[rank]))
+                continue;
+
+            for (; next < added.size() && added[next].first < bytes; ++next)
+                store.append_(added[next].first, added[next].second, last, idRanks);
+            store.append_(bytes, rankIds[rank], last, idRanks);
+        }
+        for (; next < added.size(); ++next)
+            store.append_(added[next].first, added[next].second, last, idRanks);
+
+        std::sort(idRanks.begin(), idRanks.end());
+        store.ids_.resize(idRanks.size());
+        store.ranks_.resize(idRanks.size());
+        for (size_t i = 0; i < idRanks.size(); ++i)
+        {
+            store.ids_[i] = idRanks[i].first;
+            store.ranks_[i] = idRanks[i].second;
+        }
+        store.blocks_.shrink();
+        store.bytes_.shrink();
+
+        swap(store);
+    }
+
+    void swap(FrontCodedNameStore& other)
+    {
+        std::swap(count_, other.count_);
+        ids_.swap(other.ids_);
+        ranks_.swap(other.ranks_);
+        blocks_.swap(other.blocks_);
+        bytes_.swap(other.bytes_);
+    }
+
+    size_t allocSize() const
+    {
+        return sizeof(FrontCodedNameStore)
+            + sizeof(NameID) * ids_.size()
+            + sizeof(uint32_t) * ranks_.size()
+            + sizeof(uint64_t) * blocks_.size()
+            + bytes_.size();
+    }
+
+    void saveAligned(AlignedWriter& writer) const
+    {
+        writer.write(count_);
+        ids_.saveAligned(writer);
+        ranks_.saveAligned(writer);
+        blocks_.saveAligned(writer);
+        bytes_.saveAligned(writer);
+    }
+
+    /**
+     * throws std::out_of_range, leaving the store unchanged, if the layout is
+     * truncated or its arrays do not agree with its count
+     */
+    void map(MappedReader& reader)
+    {
+        FrontCodedNameStore store;
+        reader.read(store.count_);
+        store.ids_.map(reader);
+        store.ranks_.map(reader);
+        store.blocks_.map(reader);
+        store.bytes_.map(reader);
+
+        if (!store.checkMapped_())
+            throw std::out_of_range("FrontCodedNameStore: arrays do not agree with the count");
+        swap(store);
+    }
+
+    bool save(const std::string& path) const
+    {
+        std::ofstream ofs(path.c_str(), std::ios_base::binary);
+        if (!ofs) return false;
+
+        AlignedWriter writer(ofs);
+        writer.writeHeader();
+        saveAligned(writer);
+        return ofs.good();
+    }
+
+    /**
+     * @return false if @p path could not be mapped, or map(MappedReader&)
+     * throws on it, leaving the store unchanged
+     */
+    bool map(const std::string& path)
+    {
+        MappedRegionPtr region(new MappedRegion);
+        if (!region->open(path)) return false;
+
+        MappedReader reader(region);
+        if (!reader.readHeader()) return false;
+
+        FrontCodedNameStore store;
+        try
+        {
+            store.map(reader);
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+        swap(store);
+        return true;
+    }
+
+private:
+    static void writeVarint_(izenelib::am::succinct::MappedVector<char>& bytes, size_t value)
+    {
+        for (; value >= 0x80; value >>= 7)
+            bytes.push_back((char)(value | 0x80));
+        bytes.push_back((char)value);
+    }
+
+    static size_t readVarint_(const char*& p)
+    {
+        size_t value = 0;
+        for (size_t shift = 0; ; shift += 7)
+        {
+            unsigned char c = *p++;
+            value |= (size_t)(c & 0x7f) << shift;
+            if (c < 0x80) return value;
+        }
+    }
+
+    /**
+     * decodes the string at @p p into @p bytes, which holds the previous
+     * string unless @p p is the start of a block, and moves @p p past it
+     */
+    static void decodeNext_(const char*& p, bool blockStart, std::string& bytes)
+    {
+        size_t prefix = blockStart ? 0 : readVarint_(p);
+        size_t suffix = readVarint_(p);
+        bytes.resize(prefix);
+        bytes.append(p, suffix);
+        p += suffix;
+    }
+
+    /**
+     * checks that there are an id and a rank for each string, the ranks
+     * under the count, and a block for each BlockSize strings, the blocks
+     * increasing and in bytes_
+     */
+    bool checkMapped_() const
+    {
+        if (ids_.size() != count_ || ranks_.size() != count_
+                || blocks_.size() != (count_ + BlockSize - 1) / BlockSize)
+            return false;
+
+        for (size_t i = 0; i < count_; ++i)
+        {
+            if (ranks_[i] >= count_) return false;
+        }
+        for (size_t i = 0; i < blocks_.size(); ++i)
+        {
+            if (blocks_[i] >= bytes_.size() || (i > 0 && blocks_[i] <= blocks_[i - 1]))
+                return false;
+        }
+        return true;
+    }
+
+    /// decodes the string of @p rank into @p bytes, from the start of its block
+    void decode_(size_t rank, std::string& bytes) const
+    {
+        const char* p = bytes_.data() + blocks_[rank / BlockSize];
+        decodeNext_(p, true, bytes);
+        for (size_t i = rank % BlockSize; i > 0; --i)
+            decodeNext_(p, false, bytes);
+    }
+
+    void append_(const std::string& bytes, NameID nameID, std::string& last,
+            std::vector<std::pair<NameID, uint32_t> >& idRanks)
+    {
+        if (count_ % BlockSize == 0)
+        {
+            blocks_.push_back(bytes_.size());
+            writeVarint_(bytes_, bytes.size());
+            for (size_t i = 0; i < bytes.size(); ++i)
+                bytes_.push_back(bytes[i]);
+        }
+        else
+        {
+            size_t prefix = 0;
+            size_t maxPrefix = std::min(last.size(), bytes.size());
+            while (prefix < maxPrefix && last[prefix] == bytes[prefix])
+                ++prefix;
+
+            writeVarint_(bytes_, prefix);
+            writeVarint_(bytes_, bytes.size() - prefix);
+            for (size_t i = prefix; i < bytes.size(); ++i)
+                bytes_.push_back(bytes[i]);
+        }
+
+        idRanks.push_back(std::make_pair(nameID, (uint32_t)count_));
+        last = bytes;
+        ++count_;
+    }
+
+private:
+    size_t count_;
+
+    izenelib::am::succinct::MappedVector<NameID> ids_; ///< sorted
+    izenelib::am::succinct::MappedVector<uint32_t> ranks_; ///< the rank of the string of each id
+    izenelib::am::succinct::MappedVector<uint64_t> blocks_; ///< the offset of each block in bytes_
+    izenelib::am::succinct::MappedVector<char> bytes_;
+};
+
+}
+// end - namespace idmanager
+
+NS_IZENELIB_IR_END
+
+#endif // _FRONT_CODED_NAME_STORE_H_
@@ -24,6 +24,9 @@
 
 #include <types.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "IDManagerTypes.h"
 #include "IDFactoryException.h"
 #include "IDFactoryErrorString.h"
@@ -32,6 +35,27 @@ NS_IZENELIB_IR_BEGIN
 
 namespace idmanager {
 
+/**
+ * Gets the ids of the distinct strings at @p positions of @p nameStrings, and
+ * sets found[pos] to whether each one is already converted. The generators
+ * without a batch interface convert them one at a time.
+ */
+template <typename IDGenerator, typename NameString, typename NameID>
+inline void getNameIDs(
+        IDGenerator& idGenerator,
+        const std::vector<NameString>& nameStrings,
+        const std::vector<size_t>& positions,
+        std::vector<NameID>& nameIDs,
+        std::vector<char>& found,
+        bool insert)
+{
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        size_t pos = positions[i];
+        found[pos] = idGenerator.get(nameStrings[pos], nameIDs[pos], insert);
+    }
+}
+
 /**
  * IDFactory will call its components, String2ID and ID2String instances for task.
  */
@@ -64,6 +88,20 @@ public:
      */
     inline bool getNameIDByNameString(const NameString& nameString, NameID& nameID, bool insert = true);
 
+    /**
+     * @brief This function returns the IDs of a list of strings, like all the terms of a
+     * document, and stores the <ID,string> pairs of the new ones.
+     * The repeated strings are converted once, and ConcurrentIDGenerator
+     * converts all the strings missing in its front under one lock.
+     * @param nameStrings the name strings
+     * @param nameIDs the NameIDs, in the order of nameStrings
+     * @param insert whether insert the strings to IDManager;
+     * @return true if all the strings are already in the dictionary
+     * @return false otherwise
+     */
+    inline bool getNameIDsByNameStrings(const std::vector<NameString>& nameStrings,
+            std::vector<NameID>& nameIDs, bool insert = true);
+
     /**
      * @brief This function returns an ID given a string and stores <ID,string> pair into sdb.
      * set the ID to the new value so that it can satisfy the incremental ID semantic.
@@ -108,6 +146,25 @@ public:
         idStorage_.display();
     }
 
+protected:
+    /// orders the positions of the name strings by the strings, then by the positions
+    struct NamePositionLess
+    {
+        explicit NamePositionLess(const std::vector<NameString>& nameStrings)
+            : nameStrings_(nameStrings)
+        {
+        }
+
+        bool operator()(size_t i, size_t j) const
+        {
+            if (nameStrings_[i] < nameStrings_[j]) return true;
+            if (nameStrings_[j] < nameStrings_[i]) return false;
+            return i < j;
+        }
+
+        const std::vector<NameString>& nameStrings_;
+    };
+
 protected:
     string storageName_;
 
@@ -149,6 +206,57 @@ inline bool IDFactory<NameString, NameID, IDGenerator, IDStorage>::getNameIDByNa
     return false;
 } // end - getNameIDByNameString()
 
+template <typename NameString, typename NameID,
+          typename IDGenerator, typename IDStorage>
+inline bool IDFactory<NameString, NameID, IDGenerator, IDStorage>::getNameIDsByNameStrings(
+        const std::vector<NameString>& nameStrings,
+        std::vector<NameID>& nameIDs,
+        bool insert)
+{
+    const size_t nameNum = nameStrings.size();
+    nameIDs.resize(nameNum);
+
+    // the first position of each distinct string, whose id the repeated ones share
+    std::vector<size_t> order(nameNum);
+    for (size_t i = 0; i < nameNum; ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), NamePositionLess(nameStrings));
+
+    std::vector<size_t> firstPos(nameNum);
+    std::vector<size_t> positions;
+    for (size_t i = 0; i < nameNum; ++i)
+    {
+        if (i == 0 || nameStrings[order[i - 1]] < nameStrings[order[i]])
+            positions.push_back(order[i]);
+        firstPos[order[i]] = positions.back();
+    }
+
+    // the new ids are assigned in the order of the strings
+    std::sort(positions.begin(), positions.end());
+
+    std::vector<char> found(nameNum, 0);
+    getNameIDs(idGenerator_, nameStrings, positions, nameIDs, found, insert);
+
+    bool isAllFound = true;
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        size_t pos = positions[i];
+        if (found[pos])
+            continue;
+
+        isAllFound = false;
+        if (insert)
+            idStorage_.put(nameIDs[pos], nameStrings[pos]);
+    }
+
+    for (size_t i = 0; i < nameNum; ++i)
+    {
+        if (firstPos[i] != i)
+            nameIDs[i] = nameIDs[firstPos[i]];
+    }
+    return isAllFound;
+} // end - getNameIDsByNameStrings()
+
 template <typename NameString, typename NameID,
           typename IDGenerator, typename IDStorage>
 inline void IDFactory<NameString, NameID, IDGenerator, IDStorage>::updateNameIDByNameString(
@@ -3,6 +3,7 @@
  * @brief	Contain two types of IDGenerator, HashID and UniqueID.
  *          HashID use hash to genreate ID,
  *          UniqueID generate ID using a sequential number.
+ *          ConcurrentIDGenerator keeps the converted IDs of another one in memory.
  * @author Wei Cao
  * @date 2009-08-07
  */
@@ -12,8 +13,11 @@
 #include <boost/archive/xml_oarchive.hpp>
 #include <boost/archive/xml_iarchive.hpp>
 #include <boost/archive/archive_exception.hpp>
+#include <boost/thread/mutex.hpp>
 #include <types.h>
 
+#include <vector>
+
 #include <util/hashFunction.h>
 #include <util/DynamicBloomFilter.h>
 #include <util/ThreadModel.h>
@@ -592,6 +596,351 @@ inline void UniqueIDGenerator<NameString, NameID,
     mutex_.unlock();
 } // end - update()
 
+/**
+ * An in-memory front of another IDGenerator, which could be shared by the
+ * indexing threads.
+ *
+ * The names converted once are kept in lock-striped open addressing tables,
+ * found by their 64-bit fingerprints, so the bytes are compared only when
+ * the fingerprints are equal. Only the names missing in the front are passed
+ * to BaseGenerator, one at a time, and stay in the front afterwards; the
+ * names of a batch take the lock of BaseGenerator once for all the missing
+ * ones.
+ *
+ * As a name seen before is found in the front, get() returns true for it
+ * even if BaseGenerator is HashIDGenerator, and IDFactory does not put it to
+ * IDStorage again.
+ */
+template <
+          typename  NameString,
+          typename  NameID,
+          typename  BaseGenerator = UniqueIDGenerator<NameString, NameID>,
+          size_t    StripeBits    = 6>
+class ConcurrentIDGenerator
+{
+    struct Slot
+    {
+        uint64_t fingerprint; ///< 0 for an empty slot
+        size_t offset; ///< of the name bytes in the arena
+        size_t length;
+        NameID id;
+    };
+
+    /// one lock, open addressing table and arena, on its own cache lines
+    struct Stripe
+    {
+        Stripe() : count(0) {}
+
+        izenelib::util::ReadWriteLock mutex;
+        std::vector<Slot> slots;
+        std::vector<char> arena;
+        size_t count;
+        char padding[64];
+    };
+
+    enum { StripeNum = 1 << StripeBits, MinSlotNum = 1024 };
+
+public:
+    /**
+     * @brief Constructor.
+     *
+     * @param path       passed to BaseGenerator.
+     */
+    ConcurrentIDGenerator(const string& path)
+        : baseGenerator_(path)
+    {
+    }
+
+    /**
+     * @brief This function returns a name id given a name string, from the
+     * front if it is converted before, otherwise from BaseGenerator.
+     * @param nameString the name string
+     * @param nameID the NameID
+     * @param insert whether insert nameString if it does not exist
+     * @return true if nameString is in the front or BaseGenerator
+     * @return false otherwise
+     */
+    inline bool get(const NameString& nameString, NameID& nameID, bool insert = true);
+
+    /**
+     * @brief This function returns the name ids of the distinct name strings
+     * at @p positions, the ones missing in the front from BaseGenerator,
+     * under one lock.
+     * @param nameStrings the name strings
+     * @param positions the positions of the distinct name strings to convert
+     * @param nameIDs the NameIDs, in the order of nameStrings
+     * @param found found[pos] is set to whether nameStrings[pos] is in the
+     * front or BaseGenerator
+     * @param insert whether insert the name strings if they do not exist
+     */
+    inline void get(const std::vector<NameString>& nameStrings,
+            const std::vector<size_t>& positions,
+            std::vector<NameID>& nameIDs,
+            std::vector<char>& found,
+            bool insert = true);
+
+    /**
+     * @brief This function updates the id of a name string in BaseGenerator
+     * and the front.
+     * @param nameString the name string
+     * @param updatedID the updated NameID
+     */
+    inline void update(const NameString& nameString, NameID& updatedID);
+
+    NameID maxConvID() const
+    {
+        boost::mutex::scoped_lock lock(baseMutex_);
+        return baseGenerator_.maxConvID();
+    }
+
+    /**
+     * @brief The number of names in the front.
+     */
+    size_t size() const
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < StripeNum; ++i)
+        {
+            stripes_[i].mutex.lock_shared();
+            count += stripes_[i].count;
+            stripes_[i].mutex.unlock_shared();
+        }
+        return count;
+    }
+
+    void flush()
+    {
+        boost::mutex::scoped_lock lock(baseMutex_);
+        baseGenerator_.flush();
+    }
+
+    void close()
+    {
+        boost::mutex::scoped_lock lock(baseMutex_);
+        baseGenerator_.close();
+
+        for (size_t i = 0; i < StripeNum; ++i)
+        {
+            Stripe& stripe = stripes_[i];
+            stripe.mutex.lock();
+            std::vector<Slot>().swap(stripe.slots);
+            std::vector<char>().swap(stripe.arena);
+            stripe.count = 0;
+            stripe.mutex.unlock();
+        }
+    }
+
+    void display()
+    {
+        boost::mutex::scoped_lock lock(baseMutex_);
+        baseGenerator_.display();
+    }
+
+protected:
+    static uint64_t fingerprint_(const char* data, size_t size)
+    {
+        uint64_t fingerprint = izenelib::util::MurmurHash64A(data, size, 0);
+        return fingerprint ? fingerprint : 1;
+    }
+
+    static Stripe& stripe_(Stripe* stripes, uint64_t fingerprint)
+    {
+        return stripes[fingerprint >> (64 - StripeBits)];
+    }
+
+    /// the slot of the name, or the empty slot to put it
+    static Slot& findSlot_(Stripe& stripe, uint64_t fingerprint, const char* data, size_t size)
+    {
+        size_t mask = stripe.slots.size() - 1;
+        for (size_t pos = fingerprint & mask; ; pos = (pos + 1) & mask)
+        {
+            Slot& slot = stripe.slots[pos];
+            if (slot.fingerprint == 0) return slot;
+            if (slot.fingerprint == fingerprint && slot.length == size
+                    && memcmp(&stripe.arena[0] + slot.offset, data, size) == 0)
+                return slot;
+        }
+    }
+
+    static bool find_(Stripe& stripe, uint64_t fingerprint, const char* data, size_t size, NameID& nameID)
+    {
+        if (stripe.count == 0) return false;
+
+        const Slot& slot = findSlot_(stripe, fingerprint, data, size);
+        if (slot.fingerprint == 0) return false;
+
+        nameID = slot.id;
+        return true;
+    }
+
+    static void insert_(Stripe& stripe, uint64_t fingerprint, const char* data, size_t size, NameID nameID)
+    {
+        // keep the load factor under 1/2
+        if ((stripe.count + 1) * 2 > stripe.slots.size())
+            rehash_(stripe, std::max((size_t)MinSlotNum, stripe.slots.size() * 2));
+
+        Slot& slot = findSlot_(stripe, fingerprint, data, size);
+        if (slot.fingerprint == 0)
+        {
+            slot.fingerprint = fingerprint;
+            slot.offset = stripe.arena.size();
+            slot.length = size;
+            stripe.arena.insert(stripe.arena.end(), data, data + size);
+            ++stripe.count;
+        }
+        slot.id = nameID;
+    }
+
+    static void rehash_(Stripe& stripe, size_t slotNum)
+    {
+        std::vector<Slot> slots(slotNum, Slot());
+        size_t mask = slotNum - 1;
+        for (size_t i = 0; i < stripe.slots.size(); ++i)
+        {
+            const Slot& slot = stripe.slots[i];
+            if (slot.fingerprint == 0) continue;
+
+            size_t pos = slot.fingerprint & mask;
+            while (slots[pos].fingerprint != 0)
+                pos = (pos + 1) & mask;
+            slots[pos] = slot;
+        }
+        stripe.slots.swap(slots);
+    }
+
+protected:
+    mutable Stripe stripes_[StripeNum];
+
+    mutable boost::mutex baseMutex_; ///< serializes the calls to baseGenerator_
+
+    BaseGenerator baseGenerator_;
+}; // end - template ConcurrentIDGenerator
+
+template <typename NameString, typename NameID,
+    typename BaseGenerator, size_t StripeBits>
+inline bool ConcurrentIDGenerator<NameString, NameID,
+    BaseGenerator, StripeBits>::get(
+        const NameString& nameString,
+        NameID& nameID,
+        bool insert)
+{
+    const char* data = NameStringBytes<NameString>::data(nameString);
+    size_t size = NameStringBytes<NameString>::size(nameString);
+    uint64_t fingerprint = fingerprint_(data, size);
+    Stripe& stripe = stripe_(stripes_, fingerprint);
+
+    stripe.mutex.lock_shared();
+    bool found = find_(stripe, fingerprint, data, size, nameID);
+    stripe.mutex.unlock_shared();
+    if (found) return true;
+
+    boost::mutex::scoped_lock lock(baseMutex_);
+
+    // converted by another thread while waiting for baseMutex_
+    stripe.mutex.lock_shared();
+    found = find_(stripe, fingerprint, data, size, nameID);
+    stripe.mutex.unlock_shared();
+    if (found) return true;
+
+    found = baseGenerator_.get(nameString, nameID, insert);
+    if (found || insert)
+    {
+        stripe.mutex.lock();
+        insert_(stripe, fingerprint, data, size, nameID);
+        stripe.mutex.unlock();
+    }
+    return found;
+} // end - get()
+
+template <typename NameString, typename NameID,
+    typename BaseGenerator, size_t StripeBits>
+inline void ConcurrentIDGenerator<NameString, NameID,
+    BaseGenerator, StripeBits>::get(
+        const std::vector<NameString>& nameStrings,
+        const std::vector<size_t>& positions,
+        std::vector<NameID>& nameIDs,
+        std::vector<char>& found,
+        bool insert)
+{
+    std::vector<uint64_t> fingerprints(positions.size());
+    std::vector<size_t> misses;
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        size_t pos = positions[i];
+        const char* data = NameStringBytes<NameString>::data(nameStrings[pos]);
+        size_t size = NameStringBytes<NameString>::size(nameStrings[pos]);
+        fingerprints[i] = fingerprint_(data, size);
+        Stripe& stripe = stripe_(stripes_, fingerprints[i]);
+
+        stripe.mutex.lock_shared();
+        found[pos] = find_(stripe, fingerprints[i], data, size, nameIDs[pos]);
+        stripe.mutex.unlock_shared();
+        if (!found[pos]) misses.push_back(i);
+    }
+    if (misses.empty()) return;
+
+    boost::mutex::scoped_lock lock(baseMutex_);
+
+    for (size_t i = 0; i < misses.size(); ++i)
+    {
+        size_t pos = positions[misses[i]];
+        uint64_t fingerprint = fingerprints[misses[i]];
+        const char* data = NameStringBytes<NameString>::data(nameStrings[pos]);
+        size_t size = NameStringBytes<NameString>::size(nameStrings[pos]);
+        Stripe& stripe = stripe_(stripes_, fingerprint);
+
+        // converted by another thread while waiting for baseMutex_
+        stripe.mutex.lock_shared();
+        found[pos] = find_(stripe, fingerprint, data, size, nameIDs[pos]);
+        stripe.mutex.unlock_shared();
+        if (found[pos]) continue;
+
+        found[pos] = baseGenerator_.get(nameStrings[pos], nameIDs[pos], insert);
+        if (found[pos] || insert)
+        {
+            stripe.mutex.lock();
+            insert_(stripe, fingerprint, data, size, nameIDs[pos]);
+            stripe.mutex.unlock();
+        }
+    }
+} // end - get()
+
+template <typename NameString, typename NameID,
+    typename BaseGenerator, size_t StripeBits>
+inline void ConcurrentIDGenerator<NameString, NameID,
+    BaseGenerator, StripeBits>::update(
+        const NameString& nameString,
+        NameID& updatedID)
+{
+    const char* data = NameStringBytes<NameString>::data(nameString);
+    size_t size = NameStringBytes<NameString>::size(nameString);
+    uint64_t fingerprint = fingerprint_(data, size);
+    Stripe& stripe = stripe_(stripes_, fingerprint);
+
+    boost::mutex::scoped_lock lock(baseMutex_);
+    baseGenerator_.update(nameString, updatedID);
+
+    stripe.mutex.lock();
+    insert_(stripe, fingerprint, data, size, updatedID);
+    stripe.mutex.unlock();
+} // end - update()
+
+/**
+ * The batch of IDFactory::getNameIDsByNameStrings() on ConcurrentIDGenerator.
+ */
+template <typename NameString, typename NameID,
+    typename BaseGenerator, size_t StripeBits>
+inline void getNameIDs(
+        ConcurrentIDGenerator<NameString, NameID, BaseGenerator, StripeBits>& idGenerator,
+        const std::vector<NameString>& nameStrings,
+        const std::vector<size_t>& positions,
+        std::vector<NameID>& nameIDs,
+        std::vector<char>& found,
+        bool insert)
+{
+    idGenerator.get(nameStrings, positions, nameIDs, found, insert);
+}
+
 }
 // end - namespace idmanager
 
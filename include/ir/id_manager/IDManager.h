@@ -190,6 +190,42 @@ public:
         return wildcardQueryManager_.findRegExp(wildcardPattern, termList, maximumResultNumber);
     }
 
+    /**
+     * @brief a member function to offer the terms similar to a term, for typo tolerant search.
+     *
+     * @param term              a term, which may be misspelled;
+     * @param maxDistance       the largest edit distance of the terms from the term, at most 3;
+     * @param termIdList        a list of term IDs, the closer terms first.
+     * @return true  :          Some terms are within maxDistance of the term in the dictionary.
+     * @return false :          No term is, or the WildcardQueryHandler does not support fuzzy search.
+     */
+    bool getTermIdListByFuzzyTerm(
+            const TermType& term,
+            int maxDistance,
+            std::vector<IDType>& termIdList,
+            int maximumResultNumber = 5)
+    {
+        return wildcardQueryManager_.findFuzzy(term, maxDistance, termIdList, maximumResultNumber);
+    }
+
+    /**
+     * @brief a member function to offer the terms similar to a term, for typo tolerant search.
+     *
+     * @param term              a term, which may be misspelled;
+     * @param maxDistance       the largest edit distance of the terms from the term, at most 3;
+     * @param termList          a list of terms, the closer terms first.
+     * @return true  :          Some terms are within maxDistance of the term in the dictionary.
+     * @return false :          No term is, or the WildcardQueryHandler does not support fuzzy search.
+     */
+    bool getTermListByFuzzyTerm(
+            const TermType& term,
+            int maxDistance,
+            std::vector<TermType>& termList,
+            int maximumResultNumber = 5)
+    {
+        return wildcardQueryManager_.findFuzzy(term, maxDistance, termList, maximumResultNumber);
+    }
+
 
     /**
      * @brief a member function to get term string by its ID.
@@ -395,6 +431,21 @@ typedef _IDManager<izenelib::util::UString, izenelib::util::UString, uint64_t,
                    UniqueIDGenerator<izenelib::util::UString, uint64_t>,
                    HDBIDStorage<izenelib::util::UString, uint64_t> > IDManagerRelease64;
 
+/**
+ * This version of IDManager is IDManagerDebug32 for several indexing threads, the
+ * term ids converted are kept in memory, and the TermID->Term pairs are written to
+ * disk in the background.
+ */
+typedef _IDManager<izenelib::util::UString, izenelib::util::UString, uint32_t,
+                   izenelib::util::ReadWriteLock,
+                   EmptyWildcardQueryHandler<izenelib::util::UString, uint32_t>,
+                   ConcurrentIDGenerator<izenelib::util::UString, uint32_t,
+                                         HashIDGenerator<izenelib::util::UString, uint32_t> >,
+                   AsyncIDStorage<izenelib::util::UString, uint32_t,
+                                  HDBIDStorage<izenelib::util::UString, uint32_t> >,
+                   UniqueIDGenerator<izenelib::util::UString, uint32_t, izenelib::util::ReadWriteLock>,
+                   HDBIDStorage<izenelib::util::UString, uint32_t, izenelib::util::ReadWriteLock> > IDManagerConcurrent32;
+
 /**
  * This version of IDManager is provided for I-classifier, which requires TermID to be
  * uique for different terms, besides it doesn't need generate doc id.
@@ -9,12 +9,24 @@
 #define _ID_STORAGE_H_
 
 #include <string>
+#include <cstdio>
 
 #include <types.h>
 
 #include <sdb/SequentialDB.h>
 #include <am/tokyo_cabinet/tc_btree.h>
 #include <am/tokyo_cabinet/tc_hash.h>
+
+#include <util/ThreadModel.h>
+
+#include "FrontCodedNameStore.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
 NS_IZENELIB_IR_BEGIN
 
 namespace idmanager {
@@ -57,6 +69,12 @@ public:
      */
     bool get(const NameID& nameID, NameString& nameString);
 
+    /**
+     * @brief This function appends all the <ID, String> pairs in storage.
+     * @param names the pairs, in no particular order
+     */
+    void getAllPairs(std::vector<std::pair<NameID, NameString> >& names);
+
     void flush()
     {
         nameFinder_.flush();
@@ -109,6 +127,20 @@ bool SDBIDStorage<NameString, NameID, LockType>::get( const NameID& nameID,
     return nameFinder_.getValue(nameID, nameString);
 } // end - get()
 
+template <typename NameString, typename NameID, typename LockType>
+void SDBIDStorage<NameString, NameID, LockType>::getAllPairs(
+    std::vector<std::pair<NameID, NameString> >& names)
+{
+    typename NameFinder::SDBCursor locn = nameFinder_.get_first_locn();
+    NameID nameID;
+    NameString nameString;
+    while (nameFinder_.get(locn, nameID, nameString))
+    {
+        names.push_back(std::make_pair(nameID, nameString));
+        nameFinder_.seq(locn);
+    }
+} // end - getAllPairs()
+
 
 
 /**
@@ -149,6 +181,12 @@ public:
      */
     bool get(const NameID& nameID, NameString& nameString);
 
+    /**
+     * @brief This function appends all the <ID, String> pairs in storage.
+     * @param names the pairs, in no particular order
+     */
+    void getAllPairs(std::vector<std::pair<NameID, NameString> >& names);
+
     void flush()
     {
         nameFinder_->flush();
@@ -216,6 +254,20 @@ bool HDBIDStorage<NameString, NameID, LockType>::get( const NameID& nameID,
     return nameFinder_->getValue(nameID, nameString);
 } // end - get()
 
+template <typename NameString, typename NameID, typename LockType>
+void HDBIDStorage<NameString, NameID, LockType>::getAllPairs(
+    std::vector<std::pair<NameID, NameString> >& names)
+{
+    typename NameFinder::HDBCursor locn = nameFinder_->get_first_locn();
+    NameID nameID;
+    NameString nameString;
+    while (nameFinder_->get(locn, nameID, nameString))
+    {
+        names.push_back(std::make_pair(nameID, nameString));
+        nameFinder_->seq(locn);
+    }
+} // end - getAllPairs()
+
 
 
 /**
@@ -257,6 +309,12 @@ class TCIDStorage
     */
     bool get(const NameID& nameID, NameString& nameString);
 
+    /**
+     * @brief This function appends all the <ID, String> pairs in storage.
+     * @param names the pairs, in no particular order
+     */
+    void getAllPairs(std::vector<std::pair<NameID, NameString> >& names);
+
     void flush()
     {
         nameFinder_.release();
@@ -308,6 +366,20 @@ bool TCIDStorage<NameString, NameID, LockType>::get( const NameID& nameID, NameS
     return nameFinder_.get(nameID, nameString);
 } // end - get()
 
+template <typename NameString, typename NameID, typename LockType>
+void TCIDStorage<NameString, NameID, LockType>::getAllPairs(
+    std::vector<std::pair<NameID, NameString> >& names)
+{
+    typename NameFinder::SDBCursor locn = nameFinder_.get_first_locn();
+    NameID nameID;
+    NameString nameString;
+    while (nameFinder_.get(locn, nameID, nameString))
+    {
+        names.push_back(std::make_pair(nameID, nameString));
+        nameFinder_.seq(locn);
+    }
+} // end - getAllPairs()
+
 
 
 /**
@@ -338,6 +410,10 @@ public:
         return false;
     }
 
+    void getAllPairs(std::vector<std::pair<NameID, NameString> >& names)
+    {
+    }
+
     void flush(){}
 
     void close(){}
@@ -345,6 +421,445 @@ public:
     void display(){}
 }; // end - template EmptyIDStorage
 
+/**
+ * Keep the <ID, String> pairs in memory, and spill them to another IDStorage
+ * in a background thread, so put() does not wait for the disk.
+ *
+ * A pair is returned by get() either from memory before it is spilled, or
+ * from BaseStorage after. put() waits only when MaxPendingNum pairs are not
+ * spilled yet.
+ */
+template <typename  NameString,
+          typename  NameID,
+          typename  BaseStorage     = HDBIDStorage<NameString, NameID>,
+          size_t    SpillBatchNum   = 65536,
+          size_t    MaxPendingNum   = 1048576>
+class AsyncIDStorage
+{
+    typedef boost::unordered_map<NameID, NameString> PendingMap;
+
+public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param sdbName       passed to BaseStorage.
+     */
+    AsyncIDStorage(const std::string& sdbName);
+
+    virtual ~AsyncIDStorage();
+
+    /**
+     * @brief This function keeps a <ID, String> pair to be spilled.
+     * @param nameID the Name ID
+     * @param nameString the name string
+     */
+    void put(const NameID& nameID, const NameString& nameString);
+
+    /**
+     * @brief This function returns the String for a given ID.
+     * @param nameID the Name ID
+     * @param nameString the name string
+     * @return true if the name string is successfully returned
+     * @return false if name id is not available
+     */
+    bool get(const NameID& nameID, NameString& nameString);
+
+    /**
+     * @brief spills all the pairs put before, and appends the pairs of BaseStorage.
+     */
+    void getAllPairs(std::vector<std::pair<NameID, NameString> >& names)
+    {
+        spill_();
+
+        boost::mutex::scoped_lock lock(baseMutex_);
+        baseStorage_.getAllPairs(names);
+    }
+
+    /**
+     * @brief spills all the pairs put before, and flushes BaseStorage.
+     */
+    void flush()
+    {
+        spill_();
+
+        boost::mutex::scoped_lock lock(baseMutex_);
+        baseStorage_.flush();
+    }
+
+    void close()
+    {
+        stop_();
+        spill_();
+
+        boost::mutex::scoped_lock lock(baseMutex_);
+        baseStorage_.close();
+    }
+
+    void display()
+    {
+        boost::mutex::scoped_lock lock(baseMutex_);
+        baseStorage_.display();
+    }
+
+protected:
+    void spillLoop_();
+
+    /// moves the pending pairs to BaseStorage, returns false if none
+    bool spill_();
+
+    void stop_()
+    {
+        {
+            boost::mutex::scoped_lock lock(pendingMutex_);
+            stopped_ = true;
+        }
+        pendingCond_.notify_all();
+
+        if (spillThread_.joinable())
+            spillThread_.join();
+    }
+
+protected:
+
+    BaseStorage baseStorage_;
+
+    PendingMap pending_; ///< the pairs put since the last spill
+    PendingMap spilling_; ///< the pairs being written to baseStorage_
+    bool stopped_;
+
+    boost::mutex pendingMutex_; ///< guards pending_, spilling_ and stopped_
+    boost::condition_variable pendingCond_;
+    boost::condition_variable spilledCond_;
+
+    boost::mutex spillMutex_; ///< one spill at a time
+    boost::mutex baseMutex_; ///< serializes the calls to baseStorage_
+
+    boost::thread spillThread_;
+}; // end - template AsyncIDStorage
+
+template <typename NameString, typename NameID, typename BaseStorage,
+    size_t SpillBatchNum, size_t MaxPendingNum>
+AsyncIDStorage<NameString, NameID, BaseStorage, SpillBatchNum, MaxPendingNum>::AsyncIDStorage(
+        const std::string& sdbName)
+:
+    baseStorage_(sdbName),
+    stopped_(false)
+{
+    spillThread_ = boost::thread(&AsyncIDStorage::spillLoop_, this);
+} // end - AsyncIDStorage()
+
+template <typename NameString, typename NameID, typename BaseStorage,
+    size_t SpillBatchNum, size_t MaxPendingNum>
+AsyncIDStorage<NameString, NameID, BaseStorage, SpillBatchNum, MaxPendingNum>::~AsyncIDStorage()
+{
+    stop_();
+    spill_();
+} // end - ~AsyncIDStorage()
+
+template <typename NameString, typename NameID, typename BaseStorage,
+    size_t SpillBatchNum, size_t MaxPendingNum>
+void AsyncIDStorage<NameString, NameID, BaseStorage, SpillBatchNum, MaxPendingNum>::put(
+        const NameID& nameID, const NameString& nameString)
+{
+    boost::mutex::scoped_lock lock(pendingMutex_);
+    while (pending_.size() >= MaxPendingNum && !stopped_)
+        spilledCond_.wait(lock);
+
+    pending_[nameID] = nameString;
+    if (pending_.size() == SpillBatchNum)
+        pendingCond_.notify_one();
+} // end - put()
+
+template <typename NameString, typename NameID, typename BaseStorage,
+    size_t SpillBatchNum, size_t MaxPendingNum>
+bool AsyncIDStorage<NameString, NameID, BaseStorage, SpillBatchNum, MaxPendingNum>::get(
+        const NameID& nameID, NameString& nameString)
+{
+    {
+        boost::mutex::scoped_lock lock(pendingMutex_);
+        typename PendingMap::const_iterator it = pending_.find(nameID);
+        if (it != pending_.end() || (it = spilling_.find(nameID)) != spilling_.end())
+        {
+            nameString = it->second;
+            return true;
+        }
+    }
+
+    // spilling_ is cleared only after it is in baseStorage_
+    boost::mutex::scoped_lock lock(baseMutex_);
+    return baseStorage_.get(nameID, nameString);
+} // end - get()
+
+template <typename NameString, typename NameID, typename BaseStorage,
+    size_t SpillBatchNum, size_t MaxPendingNum>
+void AsyncIDStorage<NameString, NameID, BaseStorage, SpillBatchNum, MaxPendingNum>::spillLoop_()
+{
+    while (true)
+    {
+        {
+            boost::mutex::scoped_lock lock(pendingMutex_);
+            if (stopped_) break;
+
+            // spill a batch when it is full, or what is pending every second
+            if (pending_.size() < SpillBatchNum)
+                pendingCond_.timed_wait(lock, boost::posix_time::seconds(1));
+
+            if (stopped_) break;
+        }
+        spill_();
+    }
+} // end - spillLoop_()
+
+template <typename NameString, typename NameID, typename BaseStorage,
+    size_t SpillBatchNum, size_t MaxPendingNum>
+bool AsyncIDStorage<NameString, NameID, BaseStorage, SpillBatchNum, MaxPendingNum>::spill_()
+{
+    boost::mutex::scoped_lock spillLock(spillMutex_);
+    {
+        boost::mutex::scoped_lock lock(pendingMutex_);
+        if (pending_.empty()) return false;
+        spilling_.swap(pending_);
+    }
+    spilledCond_.notify_all();
+
+    // only this thread changes spilling_, so it is read without pendingMutex_
+    {
+        boost::mutex::scoped_lock lock(baseMutex_);
+        for (typename PendingMap::const_iterator it = spilling_.begin();
+                it != spilling_.end(); ++it)
+        {
+            baseStorage_.put(it->first, it->second);
+        }
+    }
+
+    {
+        boost::mutex::scoped_lock lock(pendingMutex_);
+        PendingMap().swap(spilling_);
+    }
+    return true;
+} // end - spill_()
+
+
+
+/**
+ * Keep the <ID, String> pairs of a stable vocabulary frozen in a mapped
+ * FrontCodedNameStore, so get() does not go to the disk.
+ *
+ * The pairs put after the last freeze() are kept in a small overlay, and
+ * merged into a new store at flush(). They are also put to BaseStorage. The
+ * first freeze() without a frozen store, e.g. of an existing index, builds
+ * it from all the pairs of BaseStorage.
+ *
+ * A freeze rewrites the whole store, so flush() puts it off while the
+ * overlay is less than 1/FLUSH_RATIO of the store; the pairs put meanwhile
+ * are read from the overlay, and are in BaseStorage.
+ */
+template <typename  NameString,
+          typename  NameID,
+          typename  BaseStorage     = HDBIDStorage<NameString, NameID> >
+class FrozenIDStorage
+{
+    typedef FrontCodedNameStore<NameString, NameID> NameStore;
+    typedef boost::shared_ptr<const NameStore> NameStorePtr;
+    typedef boost::unordered_map<NameID, NameString> OverlayMap;
+
+public:
+
+    /**
+     * @brief Constructor.
+     *
+     * @param sdbName       passed to BaseStorage, and the prefix of the frozen store.
+     */
+    FrozenIDStorage(const std::string& sdbName);
+
+    virtual ~FrozenIDStorage()
+    {
+    }
+
+    /**
+     * @brief This function puts a <ID, String> pair into the overlay and BaseStorage.
+     * @param nameID the Name ID
+     * @param nameString the name string
+     */
+    void put(const NameID& nameID, const NameString& nameString);
+
+    /**
+     * @brief This function returns the String for a given ID.
+     * @param nameID the Name ID
+     * @param nameString the name string
+     * @return true if the name string is successfully returned
+     * @return false if name id is not available
+     */
+    bool get(const NameID& nameID, NameString& nameString);
+
+    /**
+     * @brief merges the overlay into a new frozen store and maps it.
+     * @return false if the store could not be written
+     */
+    bool freeze();
+
+    /// flush() freezes when the overlay is 1/FLUSH_RATIO of the store
+    enum { FLUSH_RATIO = 8 };
+
+    /**
+     * @brief The number of pairs in the frozen store and in the overlay.
+     */
+    std::pair<size_t, size_t> size()
+    {
+        izenelib::util::ScopedReadLock<izenelib::util::ReadWriteLock> lock(mutex_);
+        return std::make_pair(store_->size(), overlay_.size());
+    }
+
+    void flush()
+    {
+        bool putOff;
+        {
+            izenelib::util::ScopedReadLock<izenelib::util::ReadWriteLock> lock(mutex_);
+            putOff = !seedBase_ && overlay_.size() * FLUSH_RATIO < store_->size();
+        }
+        if (!putOff) freeze();
+
+        boost::mutex::scoped_lock lock(baseMutex_);
+        baseStorage_.flush();
+    }
+
+    void close()
+    {
+        freeze();
+
+        boost::mutex::scoped_lock lock(baseMutex_);
+        baseStorage_.close();
+    }
+
+    void display()
+    {
+        boost::mutex::scoped_lock lock(baseMutex_);
+        baseStorage_.display();
+    }
+
+protected:
+
+    BaseStorage baseStorage_;
+
+    std::string storePath_;
+
+    NameStorePtr store_; ///< replaced, not changed, at freeze()
+    OverlayMap overlay_;
+    bool seedBase_; ///< whether the next freeze() takes the pairs of baseStorage_
+
+    izenelib::util::ReadWriteLock mutex_; ///< guards store_ and overlay_
+
+    boost::mutex freezeMutex_; ///< one freeze at a time
+    boost::mutex baseMutex_; ///< serializes the calls to baseStorage_
+}; // end - template FrozenIDStorage
+
+template <typename NameString, typename NameID, typename BaseStorage>
+FrozenIDStorage<NameString, NameID, BaseStorage>::FrozenIDStorage(
+        const std::string& sdbName)
+:
+    baseStorage_(sdbName),
+    storePath_(sdbName + "_id.frozen"),
+    seedBase_(false)
+{
+    NameStore* store = new NameStore;
+    seedBase_ = !store->map(storePath_);
+    store_.reset(store);
+} // end - FrozenIDStorage()
+
+template <typename NameString, typename NameID, typename BaseStorage>
+void FrozenIDStorage<NameString, NameID, BaseStorage>::put(
+        const NameID& nameID, const NameString& nameString)
+{
+    {
+        izenelib::util::ScopedWriteLock<izenelib::util::ReadWriteLock> lock(mutex_);
+        overlay_[nameID] = nameString;
+    }
+
+    boost::mutex::scoped_lock lock(baseMutex_);
+    baseStorage_.put(nameID, nameString);
+} // end - put()
+
+template <typename NameString, typename NameID, typename BaseStorage>
+bool FrozenIDStorage<NameString, NameID, BaseStorage>::get(
+        const NameID& nameID, NameString& nameString)
+{
+    {
+        izenelib::util::ScopedReadLock<izenelib::util::ReadWriteLock> lock(mutex_);
+        typename OverlayMap::const_iterator it = overlay_.find(nameID);
+        if (it != overlay_.end())
+        {
+            nameString = it->second;
+            return true;
+        }
+
+        if (store_->get(nameID, nameString))
+            return true;
+    }
+
+    boost::mutex::scoped_lock lock(baseMutex_);
+    return baseStorage_.get(nameID, nameString);
+} // end - get()
+
+template <typename NameString, typename NameID, typename BaseStorage>
+bool FrozenIDStorage<NameString, NameID, BaseStorage>::freeze()
+{
+    boost::mutex::scoped_lock freezeLock(freezeMutex_);
+
+    std::vector<std::pair<NameID, NameString> > names;
+    NameStorePtr store;
+    bool seed;
+    {
+        izenelib::util::ScopedReadLock<izenelib::util::ReadWriteLock> lock(mutex_);
+        seed = seedBase_;
+        if (overlay_.empty() && !seed) return true;
+
+        names.assign(overlay_.begin(), overlay_.end());
+        store = store_;
+    }
+
+    if (seed)
+    {
+        // the overlay replaces the pairs of baseStorage_ with the same ids
+        std::vector<std::pair<NameID, NameString> > baseNames;
+        {
+            boost::mutex::scoped_lock lock(baseMutex_);
+            baseStorage_.getAllPairs(baseNames);
+        }
+        OverlayMap seeded(baseNames.begin(), baseNames.end());
+        std::vector<std::pair<NameID, NameString> >().swap(baseNames);
+        for (size_t i = 0; i < names.size(); ++i)
+            seeded[names[i].first] = names[i].second;
+        names.assign(seeded.begin(), seeded.end());
+    }
+
+    // the current store stays mapped while the new one replaces its file
+    NameStore* newStore = new NameStore;
+    NameStorePtr newStorePtr(newStore);
+    newStore->build(*store, names);
+
+    std::string tmpPath = storePath_ + ".tmp";
+    if (!newStore->save(tmpPath) || std::rename(tmpPath.c_str(), storePath_.c_str()) != 0)
+        return false;
+
+    newStore->map(storePath_);
+
+    izenelib::util::ScopedWriteLock<izenelib::util::ReadWriteLock> lock(mutex_);
+    store_ = newStorePtr;
+    seedBase_ = false;
+
+    // the pairs put again while building stay in the overlay
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        typename OverlayMap::iterator it = overlay_.find(names[i].first);
+        if (it != overlay_.end() && it->second == names[i].second)
+            overlay_.erase(it);
+    }
+    return true;
+} // end - freeze()
+
+
+
 }
 // end - namespace idmanager
 
@@ -3,6 +3,7 @@
  * @brief	Select suitable parameters for each type of NameID, including:
  *              1. hash functions.
  *              2. minimum and maximum values.
+ *          and the bytes of each type of NameString.
  * @author	Wei Cao
  * @date 2009-08-12
  */
@@ -13,6 +14,7 @@
 #include <limits.h>
 #include <types.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <util/hashFunction.h>
 
@@ -122,6 +124,50 @@ public:
   }
 };
 
+/**
+ * The bytes of a name string, which ConcurrentIDGenerator fingerprints and
+ * FrozenIDStorage front codes.
+ */
+template <typename NameString>
+struct NameStringBytes
+{
+    static const char* data(const NameString& nameString)
+    {
+        return (const char*)nameString.c_str();
+    }
+
+    static size_t size(const NameString& nameString)
+    {
+        return nameString.length() * sizeof(typename NameString::value_type);
+    }
+
+    /// @p data should be aligned for NameString::value_type
+    static void assign(NameString& nameString, const char* data, size_t size)
+    {
+        typedef typename NameString::value_type CharT;
+        nameString = NameString((const CharT*)data, size / sizeof(CharT));
+    }
+};
+
+template <>
+struct NameStringBytes<uint128_t>
+{
+    static const char* data(const uint128_t& nameString)
+    {
+        return (const char*)&nameString;
+    }
+
+    static size_t size(const uint128_t&)
+    {
+        return sizeof(uint128_t);
+    }
+
+    static void assign(uint128_t& nameString, const char* data, size_t size)
+    {
+        memcpy(&nameString, data, sizeof(uint128_t));
+    }
+};
+
 }
 // end - namespace idmanager
 
@@ -101,21 +101,8 @@ public:
             const std::vector<NameString>& termStringList,
             std::vector<NameID>& termIdList)
     {
-        bool ret;
-        bool isAllIDFound = true;
-        size_t sizeOfTermStringList = termStringList.size();
-
-        // clear termIDList
         termIdList.clear();
-        termIdList.resize(sizeOfTermStringList);
-
-        for (size_t i = 0; i < sizeOfTermStringList; i++) {
-            ret = getTermIdByTermString(termStringList[i], termIdList[i]);
-            if (ret == false)
-                isAllIDFound = false;
-        } // end - for
-
-        return isAllIDFound;
+        return idFactory_.getNameIDsByNameStrings(termStringList, termIdList);
     }
     /**
      * @brief a memeber function to offer a list of term string by term id list. If one or more ids are not matched in the dictionary, 0 will be contained for each unmatched termIdList.
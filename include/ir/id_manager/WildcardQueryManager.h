@@ -17,6 +17,14 @@
 
 #include "NameIDTraits.h"
 #include <am/mt_trie/mt_trie.hpp>
+#include <am/succinct/louds-trie/louds_trie.hpp>
+#include <util/string/automata/WildcardAutomaton.h>
+#include <util/string/automata/LevenshteinBitAutomaton.h>
+#include <util/ThreadModel.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
 
 NS_IZENELIB_IR_BEGIN
 
@@ -26,6 +34,7 @@ namespace idmanager {
   * There are two kinds of wildcard query handlers selectable:
   * - Empty : if selected, nothing will RegexpManager do.
   * - Disk version: based on SDBTrie, data is swapped between memory and disk.
+  * - Automaton version: based on an in-memory LoudsTrie, also for fuzzy queries.
   */
 template<typename NameString, typename NameID>
 class BasicWildcardQueryHandler
@@ -46,6 +55,8 @@ public:
 
 	bool findRegExp(const NameString& exp, std::vector<NameString> & results, int maximumResultNumber){ return false;}
 
+	bool findFuzzy(const NameString& term, int maxDistance, std::vector<NameString> & results, int maximumResultNumber){ return false;}
+
 	int num_items(){return 0;}
 
 	void display(){}
@@ -102,6 +113,174 @@ private:
     MtTrie<NameString> trie_;
 };
 
+/**
+ *@brief based on an in-memory LoudsTrie of the terms, which is walked
+ * together with the automaton of a query and pruned where it dies.
+ *
+ * The inserted terms are buffered, and added to the trie by optimize() or
+ * flush(), which also saves the trie to <name>.louds.
+ */
+template<typename NameString, typename NameID>
+class AutomatonWildcardQueryHandler : public BasicWildcardQueryHandler<NameString, NameID>
+{
+    typedef typename NameString::value_type CharType;
+    typedef izenelib::am::succinct::louds::LoudsTrie<CharType> TrieType;
+
+    /// the order of the trie, by the values of the chars
+    struct TermLess
+    {
+        bool operator()(const NameString& a, const NameString& b) const
+        {
+            return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+        }
+    };
+
+public:
+	AutomatonWildcardQueryHandler(const std::string& name)
+	:   path_(name + ".louds") {}
+
+	void open()
+	{
+	    std::ifstream ifs(path_.c_str(), std::ios_base::binary);
+	    if (!ifs) return;
+
+	    TrieType trie;
+	    trie.load(ifs);
+	    if (!ifs) return;
+
+	    izenelib::util::ScopedWriteLock<izenelib::util::ReadWriteLock> lock(mutex_);
+	    trie_.swap(trie);
+	}
+
+	void optimize(){ rebuild_(); }
+
+	void flush()
+	{
+	    rebuild_();
+
+	    boost::mutex::scoped_lock rebuildLock(rebuildMutex_);
+	    std::string tmpPath = path_ + ".tmp";
+	    std::ofstream ofs(tmpPath.c_str(), std::ios_base::binary);
+	    {
+	        izenelib::util::ScopedReadLock<izenelib::util::ReadWriteLock> lock(mutex_);
+	        trie_.save(ofs);
+	    }
+	    ofs.close();
+	    if (ofs) std::rename(tmpPath.c_str(), path_.c_str());
+	}
+
+	void close(){ flush(); }
+
+	void executeTask(int threadNum) { rebuild_(); }
+
+	void insert(const NameString& str)
+	{
+	    boost::mutex::scoped_lock lock(pendingMutex_);
+	    pending_.push_back(str);
+	}
+
+	bool findRegExp(const NameString& exp, std::vector<NameString> & results, int maximumResultNumber)
+	{
+	    izenelib::util::WildcardAutomaton<CharType> automaton;
+	    if (maximumResultNumber <= 0 || !automaton.compile(exp)) return false;
+
+	    size_t oldSize = results.size();
+	    izenelib::util::ScopedReadLock<izenelib::util::ReadWriteLock> lock(mutex_);
+	    trie_.intersect(automaton, results, maximumResultNumber);
+	    return results.size() > oldSize;
+	}
+
+	/**
+	 * finds the terms within edit distance @p maxDistance of @p term, the
+	 * closer ones first, and the terms of the same distance in their order.
+	 * @p maxDistance is at most LevenshteinBitAutomaton::kMaxDistance, a
+	 * larger one is taken as it.
+	 */
+	bool findFuzzy(const NameString& term, int maxDistance, std::vector<NameString> & results, int maximumResultNumber)
+	{
+	    if (maximumResultNumber <= 0 || maxDistance < 0) return false;
+	    maxDistance = std::min(maxDistance,
+	            (int)izenelib::util::LevenshteinBitAutomaton<CharType>::kMaxDistance);
+
+	    // the terms within each distance contain those within the smaller ones
+	    std::vector<NameString> closer, within, added;
+	    izenelib::util::LevenshteinBitAutomaton<CharType> automaton;
+	    size_t oldSize = results.size();
+	    izenelib::util::ScopedReadLock<izenelib::util::ReadWriteLock> lock(mutex_);
+	    for (int d = 0; d <= maxDistance && results.size() - oldSize < (size_t)maximumResultNumber; ++d)
+	    {
+	        // only a term too long fails, at distance 0
+	        if (!automaton.compile(term, d)) return false;
+
+	        within.clear();
+	        trie_.intersect(automaton, within);
+
+	        added.clear();
+	        std::set_difference(within.begin(), within.end(), closer.begin(), closer.end(),
+	                std::back_inserter(added), TermLess());
+	        size_t num = std::min(added.size(), maximumResultNumber - (results.size() - oldSize));
+	        results.insert(results.end(), added.begin(), added.begin() + num);
+	        closer.swap(within);
+	    }
+	    return results.size() > oldSize;
+	}
+
+	int num_items()
+	{
+	    izenelib::util::ScopedReadLock<izenelib::util::ReadWriteLock> lock(mutex_);
+	    return trie_.size();
+	}
+
+	void display()
+	{
+	    std::cout << "This is a AutomatonWildcardQueryHandler instance" << std::endl;
+	    izenelib::util::ScopedReadLock<izenelib::util::ReadWriteLock> lock(mutex_);
+	    std::cout << trie_.size() << " terms, " << trie_.nodeCount() << " nodes, "
+	              << trie_.allocSize() << " bytes" << std::endl;
+	}
+
+private:
+	/// builds a new trie of the terms and the pending ones, the old one serving queries meanwhile
+	void rebuild_()
+	{
+	    boost::mutex::scoped_lock rebuildLock(rebuildMutex_);
+
+	    std::vector<NameString> pending;
+	    {
+	        boost::mutex::scoped_lock lock(pendingMutex_);
+	        pending.swap(pending_);
+	    }
+	    if (pending.empty()) return;
+	    std::sort(pending.begin(), pending.end(), TermLess());
+
+	    // only the rebuild changes the trie, so it is read without the lock
+	    std::vector<NameString> terms;
+	    trie_.keys(terms);
+	    std::vector<NameString> merged;
+	    merged.reserve(terms.size() + pending.size());
+	    std::merge(terms.begin(), terms.end(), pending.begin(), pending.end(),
+	            std::back_inserter(merged), TermLess());
+	    merged.erase(std::unique(merged.begin(), merged.end()), merged.end());
+
+	    TrieType trie;
+	    trie.build(merged);
+
+	    izenelib::util::ScopedWriteLock<izenelib::util::ReadWriteLock> lock(mutex_);
+	    trie_.swap(trie);
+	}
+
+private:
+    std::string path_;
+
+    TrieType trie_;
+    izenelib::util::ReadWriteLock mutex_; ///< guards trie_ against the rebuild
+
+    std::vector<NameString> pending_;
+    boost::mutex pendingMutex_;
+
+    boost::mutex rebuildMutex_;
+};
+
 
 /**
  * @brief Manager to handler regexp searches.
@@ -150,6 +329,23 @@ public:
         return true;
     }
 
+	bool findFuzzy(const NameString& term, int maxDistance, std::vector<NameString> & results, int maximumResultNumber)
+	{
+	    return handler_.findFuzzy(term, maxDistance, results, maximumResultNumber);
+    }
+
+	bool findFuzzy(const NameString& term, int maxDistance, std::vector<NameID> & results, int maximumResultNumber)
+	{
+	    std::vector<NameString> rlist;
+	    if(handler_.findFuzzy(term, maxDistance, rlist, maximumResultNumber) == false)
+            return false;
+
+        for(size_t i =0; i< rlist.size(); i++) {
+            results.push_back( NameIDTraits<NameID>::hash(rlist[i]) );
+        }
+        return true;
+    }
+
     void startThread(const int threadNumber = 1)
     {
         if( !worker_ ) {
@@ -29,7 +29,8 @@ enum CompressionType
 {
     BYTEALIGN,  /// byte-aligned compression, vint + d-gap compression
     BLOCK, /// block based compression
-    CHUNK /// chunk based compression
+    CHUNK, /// chunk based compression
+    SIMD_BLOCK /// block based compression, full chunks are bit packed for SIMD decoding
 };
 
 class BarrelInfo
@@ -12,6 +12,7 @@
 
 #include <ir/index_manager/index/Compressor.h>
 #include <ir/index_manager/index/CompressParameters.h>
+#include <ir/index_manager/index/SIMDChunkPacker.h>
 #include <ir/index_manager/store/IndexOutput.h>
 #include <ir/index_manager/store/IndexInput.h>
 #include <ir/index_manager/utility/Bitset.h>
@@ -43,6 +44,12 @@ public:
 
     void set_pos_buffer(uint32_t* pos_buffer);
 
+    // Whether the full chunks were coded by SIMDChunkPacker, see ChunkEncoder::set_simd().
+    void set_simd(bool simd)
+    {
+        simd_ = simd;
+    }
+
     void updatePositionOffset();
 
     uint32_t doc_id(int doc_id_idx) const
@@ -193,6 +200,8 @@ private:
 
     bool doc_deleted_; // True if there are docIDs that are deleted
 
+    bool simd_; // True if the full chunks are coded by SIMDChunkPacker
+
     // Decompressors for various portions of the chunk.
     DocIDCompressor doc_id_decompressor_;
     TermFreqCompressor frequency_decompressor_;
@@ -240,6 +249,11 @@ public:
         chunk_pos_properties_[chunk_idx] = true;
     }
 
+    void set_simd(bool simd)
+    {
+        chunk_decoder_.set_simd(simd);
+    }
+
     // Returns true if the current chunk has been decoded (the docIDs were decoded).
     bool curr_chunk_decoded() const
     {
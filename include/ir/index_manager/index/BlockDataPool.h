@@ -12,6 +12,7 @@
 
 #include <ir/index_manager/index/Compressor.h>
 #include <ir/index_manager/index/CompressParameters.h>
+#include <ir/index_manager/index/SIMDChunkPacker.h>
 
 #include <ir/index_manager/utility/MemCache.h>
 #include <ir/index_manager/utility/Utilities.h>
@@ -28,12 +29,13 @@ namespace indexmanager{
  * ChunkEncoder
  *
  * Assumes that all docIDs are in sorted
+ * In SIMD mode, the docIDs and frequencies of full chunks are coded by SIMDChunkPacker.
  ***************************************************************************************************************/
 class ChunkEncoder
 {
 public:
     ChunkEncoder()
-        :num_docs_(0), size_(0), first_doc_id_(0), last_doc_id_(0), last_doc_id_of_last_chunk_(0)
+        :num_docs_(0), size_(0), first_doc_id_(0), last_doc_id_(0), last_doc_id_of_last_chunk_(0), simd_(false)
     {
         curr_position_buffer_size_ = INIT_POS_CHUNK_SIZE;
         compressed_positions_ = new uint32_t[curr_position_buffer_size_];
@@ -52,8 +54,16 @@ public:
         last_doc_id_ = doc_ids[num_docs - 1];
         pre_process_chunk(doc_ids, num_docs);
         doc_ids[0] -= last_doc_id_of_last_chunk_;
-        compressed_doc_ids_len_ = doc_id_compressor_.compress(doc_ids, compressed_doc_ids_, num_docs_);		
-        compressed_frequencies_len_ = frequency_compressor_.compress(frequencies, compressed_frequencies_, num_docs_);
+        if (simd_ && num_docs_ == kChunkSize)
+        {
+            compressed_doc_ids_len_ = SIMDChunkPacker::pack(doc_ids, compressed_doc_ids_);
+            compressed_frequencies_len_ = SIMDChunkPacker::pack(frequencies, compressed_frequencies_, 1);
+        }
+        else
+        {
+            compressed_doc_ids_len_ = doc_id_compressor_.compress(doc_ids, compressed_doc_ids_, num_docs_);
+            compressed_frequencies_len_ = frequency_compressor_.compress(frequencies, compressed_frequencies_, num_docs_);
+        }
         last_doc_id_of_last_chunk_ = last_doc_id_;
 
         if (positions != NULL)
@@ -92,6 +102,11 @@ public:
         last_doc_id_of_last_chunk_ = 0;
     }
 
+    void set_simd(bool simd)
+    {
+        simd_ = simd;
+    }
+
     uint32_t first_doc_id() const
     {
         return first_doc_id_;
@@ -175,6 +190,8 @@ private:
     uint32_t* compressed_positions_;  // Array of compressed positions.
     int compressed_positions_len_;                                                               // Actual compressed length of positions in number of words.
     int curr_position_buffer_size_;
+
+    bool simd_;  // Whether full chunks are coded by SIMDChunkPacker.
 };
 
 /**************************************************************************************************************
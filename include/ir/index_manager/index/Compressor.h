@@ -10,6 +10,7 @@
 #define POSTING_COMPRESSOR_H
 
 #include <util/compression/int/compressor.h>
+#include <util/compression/int/int_codec_registry.h>
 
 using namespace izenelib::util::compression;
 
@@ -146,6 +147,41 @@ private:
     PrimaryCompressor* coder_;
 };
 
+/**
+ * codes each block of a list with the codec chosen from its values, the
+ * codec tags are stored in the encoded data.
+ * The output of compress() must hold AutoIntCodec::maxEncodedWords() words,
+ * and the output of decompress() IntBlockCodec::DECODE_PADDING more values
+ * than the list, which is more than the fixed coders above need, so the
+ * posting typedefs below keep their coders.
+ */
+class AutoCompressorType
+{
+public:
+    AutoCompressorType(uint32_t blockSize = 1024)
+    {
+        coder_ = new AutoIntCodec(blockSize);
+    }
+
+    ~AutoCompressorType()
+    {
+        delete coder_;
+    }
+
+    int compress(uint32_t* input, uint32_t* output, int num_input_elements) const
+    {
+        return coder_->encode(input, num_input_elements, output);
+    }
+
+    int decompress(uint32_t* input, uint32_t* output, int num_input_elements) const
+    {
+        return coder_->decode(input, output);
+    }
+
+private:
+    AutoIntCodec* coder_;
+};
+
 //typedef CombinedCompressorType<PForDelta_Compressor, S16_Compressor, 128, 96> DocIDCompressor;
 typedef CompressorType<PForDeltaMix_Compressor> DocIDCompressor;
 typedef CompressorType<S16_Compressor> TermFreqCompressor;
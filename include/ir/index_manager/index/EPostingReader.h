@@ -13,6 +13,7 @@
 #include <ir/index_manager/index/ListingCache.h>
 #include <ir/index_manager/index/TermInfo.h>
 #include <ir/index_manager/index/InputDescriptor.h>
+#include <ir/index_manager/index/BarrelInfo.h>
 
 #include <boost/scoped_ptr.hpp>
 
@@ -34,7 +35,8 @@ public:
     BlockPostingReader(
         InputDescriptor* pInputDescriptor,
         const TermInfo& termInfo,
-        IndexLevel type = WORDLEVEL);
+        IndexLevel type = WORDLEVEL,
+        CompressionType compressType = BLOCK);
 
     ~BlockPostingReader();
 
@@ -12,6 +12,7 @@
 #include <ir/index_manager/index/TermInfo.h>
 #include <ir/index_manager/index/PostingWriter.h>
 #include <ir/index_manager/index/BlockDataPool.h>
+#include <ir/index_manager/index/BarrelInfo.h>
 #include <ir/index_manager/index/FixedBlockSkipListWriter.h>
 #include <ir/index_manager/utility/IndexManagerConfig.h>
 
@@ -25,13 +26,15 @@ namespace indexmanager{
 * @BlockPostingWriter
 * Block based posting builder:
 *      [skip data][block][block]
+* for BLOCK and SIMD_BLOCK compression
 ********************************************************************/
 class BlockPostingWriter:public PostingWriter
 {
 public:
     BlockPostingWriter(
         boost::shared_ptr<MemCache> pMemCache,
-        IndexLevel indexLevel);
+        IndexLevel indexLevel,
+        CompressionType compressType = BLOCK);
 
     ~BlockPostingWriter();
     /**
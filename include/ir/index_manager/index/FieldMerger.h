@@ -308,6 +308,7 @@ inline void FieldMerger::mergeTerms(FieldMergeInfo** ppMergeInfos,int32_t numInf
                 pPostingMerger_->mergeWith((RTDiskPostingReader*)pPosting, pDocFilter_);
                 break;
             case BLOCK:
+            case SIMD_BLOCK:
                 pPostingMerger_->mergeWith((BlockPostingReader*)pPosting, pDocFilter_);
                 break;
             case CHUNK:
@@ -14,28 +14,15 @@
 #include <ir/index_manager/index/Indexer.h>
 #include <ir/index_manager/index/BarrelInfo.h>
 
-#include <util/concurrent_queue.h>
+#include <util/task_pool.h>
+
+#include <boost/atomic.hpp>
 
 
 NS_IZENELIB_IR_BEGIN
 
 namespace indexmanager{
 
-enum MergeOPType
-{
-    ADD_BARREL,
-    OPTIMIZE_ALL,
-    EXIT_MERGE
-};
-
-struct MergeOP
-{
-    MergeOPType opType;
-    BarrelInfo* pBarrelInfo;
-
-    MergeOP(MergeOPType type = ADD_BARREL) : opType(type), pBarrelInfo(NULL) {}
-};
-
 class IndexMerger;
 
 class IndexMergeManager
@@ -51,7 +38,7 @@ public:
      * Destructor.
      * If @c isAsync_ is true, it clears current appending
      * merge requests, and block the calling thread
-     * until the merge thread finishes its current task.
+     * until the merge pool finishes its current task.
      */
     ~IndexMergeManager();
 public:
@@ -81,8 +68,7 @@ public:
     void resumeMerge();
 
     /**
-     * Block the calling thread until the merge thread finishes its all tasks,
-     * and create a new thread for future merge request.
+     * Block the calling thread until the merge pool finishes its all tasks.
      * Notes: this function only works when @c isAsync_ is true.
      */
     void waitForMergeFinish();
@@ -98,35 +84,40 @@ public:
     boost::condition_variable& getPauseMergeCond() { return pauseMergeCond_; }
 
 private:
-    void mergeIndex();
-
     /**
-     * Block the calling thread until the merge thread finishes its all tasks,
-     * and delete the merge thread.
-     * Notes: this function assumes @c isAsync_ is true.
+     * The merge task of an added barrel.
+     * @param generation the value of @p mergeGeneration_ when it was added,
+     *        the task is cleared if it has changed since.
      */
-    void joinMergeThread();
+    void addToMergeTask(BarrelInfo* pBarrelInfo, unsigned int generation);
 
     /**
-     * Implementation to merge all barrels into one.
+     * The merge task of all barrels.
      */
-    void optimizeIndexImpl();
+    void optimizeIndexTask(unsigned int generation);
 
     /**
-     * Create the merge thread and run it.
+     * Implementation to merge all barrels into one.
      */
-    void run();
+    void optimizeIndexImpl();
 
 private:
     Indexer* pIndexer_;
 
     BarrelsInfo* pBarrelsInfo_;
 
-    izenelib::util::concurrent_queue<MergeOP> tasks_;
-
     IndexMerger* pAddMerger_; ///< the merger called when new barrel is added
 
-    boost::thread* pMergeThread_;
+    /**
+     * the pool of one thread running the merge tasks in their order,
+     * it's NULL if @c isAsync_ is false.
+     */
+    izenelib::util::task_pool* pMergePool_;
+
+    /**
+     * increased to clear the merge tasks submitted to @p pMergePool_.
+     */
+    boost::atomic<unsigned int> mergeGeneration_;
 
     bool isPauseMerge_; ///< whether merge should be paused
 
@@ -141,7 +132,7 @@ private:
     const bool isAsync_;
 
     /**
-     * mutex used for manage @p pMergeThread_.
+     * mutex used for manage @p pMergePool_.
      * It's used to avoid concurrent execution of @c waitForMergeFinish()
      * and @c ~IndexMergeManager().
      */
@@ -37,7 +37,11 @@ public:
     virtual ~PostingMerger();
 
 public:
-    void setCompressionType(CompressionType compressType) { compressType_ = compressType;}
+    void setCompressionType(CompressionType compressType)
+    {
+        compressType_ = compressType;
+        chunk_.set_simd(compressType_ == SIMD_BLOCK);
+    }
 
     void setOutputDescriptor(OutputDescriptor* pOutputDescriptor);
 
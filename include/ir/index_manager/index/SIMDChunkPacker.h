@@ -0,0 +1,198 @@
+/**
+* @file        SIMDChunkPacker.h
+* @version     SF1 v5.0
+* @brief Bit packing of full chunks for SIMD_BLOCK postings
+*/
+
+#ifndef SIMD_CHUNK_PACKER_H
+#define SIMD_CHUNK_PACKER_H
+
+#include <ir/index_manager/utility/system.h>
+#include <ir/index_manager/index/CompressParameters.h>
+
+#include <emmintrin.h>
+#include <stdint.h>
+
+NS_IZENELIB_IR_BEGIN
+
+namespace indexmanager{
+
+/**************************************************************************************************************
+ * SIMDChunkPacker
+ *
+ * A chunk of 128 integers is stored as [bits][4 * bits words]. Value i is in lane i % 4 of row i / 4, and
+ * the rows are packed with the bits of each lane consecutive, so one 128 bits load serves four values and
+ * the d-gaps of a row are turned back into doc ids by a prefix sum on the register, fused in the unpacking.
+ * Loads and stores are unaligned, chunks sit at any word offset within a block.
+ ***************************************************************************************************************/
+namespace detail
+{
+
+template<uint32_t B>
+void simd_pack128(const uint32_t* in, uint32_t* out, uint32_t bias)
+{
+    if (B == 0) return;
+
+    const __m128i vbias = _mm_set1_epi32(bias);
+    const __m128i* pin = reinterpret_cast<const __m128i*>(in);
+    __m128i* pout = reinterpret_cast<__m128i*>(out);
+    __m128i acc = _mm_setzero_si128();
+    uint32_t shift = 0;
+    for (uint32_t r = 0; r < 32; ++r)
+    {
+        __m128i v = _mm_sub_epi32(_mm_loadu_si128(pin + r), vbias);
+        acc = _mm_or_si128(acc, _mm_sll_epi32(v, _mm_cvtsi32_si128(shift)));
+        shift += B;
+        if (shift >= 32)
+        {
+            _mm_storeu_si128(pout++, acc);
+            shift -= 32;
+            acc = shift ? _mm_srl_epi32(v, _mm_cvtsi32_si128(B - shift)) : _mm_setzero_si128();
+        }
+    }
+}
+
+/// PrefixSum: out is the running sum from offset, otherwise the values plus offset
+template<uint32_t B, bool PrefixSum>
+void simd_unpack128(const uint32_t* in, uint32_t* out, uint32_t offset)
+{
+    __m128i* pout = reinterpret_cast<__m128i*>(out);
+    __m128i prev = _mm_set1_epi32(offset);
+    if (B == 0)
+    {
+        for (uint32_t r = 0; r < 32; ++r)
+            _mm_storeu_si128(pout + r, prev);
+        return;
+    }
+
+    const __m128i mask = _mm_set1_epi32(B == 32 ? 0xFFFFFFFFU : (1U << B) - 1);
+    const __m128i* pin = reinterpret_cast<const __m128i*>(in);
+    __m128i w = _mm_loadu_si128(pin);
+    uint32_t shift = 0;
+    for (uint32_t r = 0; r < 32; ++r)
+    {
+        __m128i v = _mm_srl_epi32(w, _mm_cvtsi32_si128(shift));
+        if (shift + B > 32)
+        {
+            w = _mm_loadu_si128(++pin);
+            v = _mm_or_si128(v, _mm_sll_epi32(w, _mm_cvtsi32_si128(32 - shift)));
+        }
+        else if (shift + B == 32 && r < 31)
+        {
+            w = _mm_loadu_si128(++pin);
+        }
+        shift = (shift + B) & 31;
+        v = _mm_and_si128(v, mask);
+
+        if (PrefixSum)
+        {
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi32(v, _mm_shuffle_epi32(prev, 0xff));
+            prev = v;
+        }
+        else
+        {
+            v = _mm_add_epi32(v, prev);
+        }
+        _mm_storeu_si128(pout + r, v);
+    }
+}
+
+template<uint32_t B>
+void simd_unpack128_add(const uint32_t* in, uint32_t* out, uint32_t offset)
+{
+    simd_unpack128<B, false>(in, out, offset);
+}
+
+template<uint32_t B>
+void simd_unpack128_sum(const uint32_t* in, uint32_t* out, uint32_t offset)
+{
+    simd_unpack128<B, true>(in, out, offset);
+}
+
+typedef void (*simd_pack_function)(const uint32_t*, uint32_t*, uint32_t);
+
+#define SIMD_CHUNK_PACKER_TABLE(F) { \
+    F<0>, F<1>, F<2>, F<3>, F<4>, F<5>, F<6>, F<7>, F<8>, F<9>, F<10>, \
+    F<11>, F<12>, F<13>, F<14>, F<15>, F<16>, F<17>, F<18>, F<19>, F<20>, \
+    F<21>, F<22>, F<23>, F<24>, F<25>, F<26>, F<27>, F<28>, F<29>, F<30>, \
+    F<31>, F<32> }
+
+/// the bit width dispatch tables, a template to be defined in the header
+template<bool Dummy>
+struct SIMDChunkTables
+{
+    static const simd_pack_function pack[33];
+    static const simd_pack_function unpack[33];
+    static const simd_pack_function unpackPrefixSum[33];
+};
+
+template<bool Dummy>
+const simd_pack_function SIMDChunkTables<Dummy>::pack[33] = SIMD_CHUNK_PACKER_TABLE(simd_pack128);
+
+template<bool Dummy>
+const simd_pack_function SIMDChunkTables<Dummy>::unpack[33] = SIMD_CHUNK_PACKER_TABLE(simd_unpack128_add);
+
+template<bool Dummy>
+const simd_pack_function SIMDChunkTables<Dummy>::unpackPrefixSum[33] = SIMD_CHUNK_PACKER_TABLE(simd_unpack128_sum);
+
+#undef SIMD_CHUNK_PACKER_TABLE
+
+}
+
+class SIMDChunkPacker
+{
+public:
+    static const int kChunkSize = CHUNK_SIZE;
+
+    /// words taken by a chunk whose values need bits bits
+    static int packed_size(uint32_t bits)
+    {
+        return 1 + 4 * bits;
+    }
+
+    /**
+     * pack the kChunkSize values of @p in minus @p bias
+     * @return the number of words written
+     */
+    static int pack(const uint32_t* in, uint32_t* out, uint32_t bias = 0)
+    {
+        uint32_t acc = 0;
+        for (int i = 0; i < kChunkSize; ++i)
+            acc |= in[i] - bias;
+        uint32_t bits = acc ? 32 - __builtin_clz(acc) : 0;
+
+        out[0] = bits;
+        detail::SIMDChunkTables<true>::pack[bits](in, out + 1, bias);
+        return packed_size(bits);
+    }
+
+    /**
+     * unpack kChunkSize values plus @p bias
+     * @return the number of words read
+     */
+    static int unpack(const uint32_t* in, uint32_t* out, uint32_t bias = 0)
+    {
+        uint32_t bits = in[0];
+        detail::SIMDChunkTables<true>::unpack[bits](in + 1, out, bias);
+        return packed_size(bits);
+    }
+
+    /**
+     * unpack kChunkSize d-gaps into the running sums from @p base
+     * @return the number of words read
+     */
+    static int unpackPrefixSum(const uint32_t* in, uint32_t* out, uint32_t base)
+    {
+        uint32_t bits = in[0];
+        detail::SIMDChunkTables<true>::unpackPrefixSum[bits](in + 1, out, base);
+        return packed_size(bits);
+    }
+};
+
+}
+
+NS_IZENELIB_IR_END
+
+#endif
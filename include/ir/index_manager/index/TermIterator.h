@@ -143,7 +143,7 @@ protected:
 class BlockTermIterator : public TermIterator
 {
 public:
-    BlockTermIterator(Directory* pDirectory,const char* barrelname,FieldInfo* pFieldInfo, IndexLevel indexLevel);
+    BlockTermIterator(Directory* pDirectory,const char* barrelname,FieldInfo* pFieldInfo, IndexLevel indexLevel, CompressionType compressType = BLOCK);
 
     ~BlockTermIterator();
 
@@ -179,6 +179,8 @@ private:
     InputDescriptor* pInputDescriptor_;
 
     int32_t nCurPos_;
+
+    CompressionType compressType_;
 };
 
 
@@ -292,6 +292,10 @@ public:
 
     TermReader* clone() ;
 
+private:
+    /// BLOCK or SIMD_BLOCK, as the barrel was written
+    CompressionType compressType() const;
+
 protected:
     friend class BlockTermIterator;
     friend class CollectionIndexer;
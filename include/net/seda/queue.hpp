@@ -23,11 +23,11 @@
 #include <vector>
 #include <assert.h>
 #include <cerrno>
-#include <vector>
 #include <iostream>
 #include <cstdio>
-#include "util/kthread/mutex.h"
-#include "util/kthread/condition.h"
+#include <boost/atomic.hpp>
+#include <boost/thread/thread.hpp>
+#include "util/mpmc_queue.h"
 
 namespace izenelib
 {
@@ -37,44 +37,52 @@ class EVENT_TYPE
 >
 struct QNode
 {
-    uint32_t _ref;
-    const EVENT_TYPE* _ptr;
+    EVENT_TYPE _event;
     uint64_t _eid;
 
-    QNode(uint32_t ref=0, const EVENT_TYPE* ptr=NULL, uint64_t eid=0)
-        :_ref(ref),_ptr(ptr),_eid(eid)
+    QNode(const EVENT_TYPE& event=EVENT_TYPE(), uint64_t eid=0)
+        :_event(event),_eid(eid)
     {}
 };
 
+/**
+ * The events between the stages, in a lock free mpmc_queue. An event is
+ * popped as many times as the stages referring to the queue by add_ref().
+ */
 template<
 class EVENT_TYPE
 >
 class EventQueue
 {
     typedef struct QNode<EVENT_TYPE> node_t;
-    std::vector<node_t > _q;
-    volatile uint32_t _head_idx;
-    volatile uint32_t _tail_idx;
-    uint32_t _ref;
-    Mutex _mut;
-    Mutex _push_mtx;
-    Mutex _pop_mtx;
-    Condition _cond;
-    bool _stop;
-    Mutex _mut4stop;
+    util::mpmc_queue<node_t> _q;
+    boost::atomic<uint32_t> _ref;
+    boost::atomic<bool> _stop;
+
+    enum { SPIN_COUNT = 64, YIELD_COUNT = 64, POP_TIMEOUT_MS = 1000 };
+
+    /// spin, then yield, then sleep a millisecond a round
+    static bool backoff(uint32_t round, uint32_t timeout_ms)
+    {
+        if (round < SPIN_COUNT)
+            return true;
+        if (round < SPIN_COUNT + YIELD_COUNT)
+        {
+            boost::this_thread::yield();
+            return true;
+        }
+        if (round - SPIN_COUNT - YIELD_COUNT >= timeout_ms)
+            return false;
+        boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        return true;
+    }
 
 public:
     typedef EVENT_TYPE event_t;
 
     EventQueue(uint32_t max_len=1000)
-        :_stop(false)
+        :_q(max_len),_ref(0),_stop(false)
     {
-        _q.reserve(max_len);
-        for ( uint32_t i=0; i<max_len; ++i)
-            _q.push_back(QNode<EVENT_TYPE>());
-        _head_idx = _tail_idx = 0;
-        _cond.set_mutex(&_mut);
-        _ref = 0;
     }
 
     ~EventQueue()
@@ -89,69 +97,49 @@ public:
 
     void push(const EVENT_TYPE& event, uint64_t eid)
     {
-        ScopedLock scp(&_push_mtx);
-        ScopedLock scp_mut(&_mut);
-
-        uint32_t newidx = (_tail_idx+1)%_q.size();
-        while(newidx == _head_idx) _cond.wait();
-
-        node_t node(_ref, new EVENT_TYPE(event), eid);
-        _q[_tail_idx] = node;
-        _tail_idx++;
-        _tail_idx %= _q.size();
-        _cond.notify();
+        uint32_t ref = _ref.load();
+        node_t node(event, eid);
+        for ( uint32_t i=0; i<ref || i==0; ++i)
+        {
+            for ( uint32_t round=0; !_q.try_push(node); ++round)
+                backoff(round, (uint32_t)-1);
+        }
     }
 
     bool full()
     {
-        ScopedLock scp_mut(&_mut);
-        return ((_tail_idx+1)%_q.size() == _head_idx);
+        return _q.size() >= _q.capacity();
     }
 
     bool empty()
     {
-        ScopedLock scp_mut(&_mut);
-        return _head_idx == _tail_idx;
+        return _q.empty();
     }
 
     void reset_stop(bool f=false)
     {
-        ScopedLock scp_mut(&_mut4stop);
         _stop = f;
     }
 
     bool stoped()
     {
-        ScopedLock scp_mut(&_mut4stop);
         return _stop;
     }
 
-    EVENT_TYPE top()
-    {
-        return *(EVENT_TYPE*)_q[_head_idx]._ptr;
-    }
-
+    /**
+     * @return false if stopped, or no event came for a second
+     */
     bool pop(EVENT_TYPE& event, uint64_t& eid)
     {
-        ScopedLock scp(&_pop_mtx);
-        ScopedLock scp_mut(&_mut);
-        while(_head_idx == _tail_idx && !stoped())
-            _cond.wait(1);
-        if (stoped())return false;
-
-        event = *(EVENT_TYPE*)_q[_head_idx]._ptr;
-        eid  = _q[_head_idx]._eid;
-        if (_q[_head_idx]._ref > 1)
+        node_t node;
+        for ( uint32_t round=0; !_q.try_pop(node); ++round)
         {
-            _q[_head_idx]._ref--;
-            _cond.notify();
-            return true;
+            if (stoped() || !backoff(round, POP_TIMEOUT_MS))
+                return false;
         }
-        delete (EVENT_TYPE*)_q[_head_idx]._ptr;
-        _head_idx++;
-        _head_idx %= _q.size();
 
-        _cond.notify();
+        event = node._event;
+        eid = node._eid;
         return true;
     }
 }
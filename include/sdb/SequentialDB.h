@@ -13,8 +13,11 @@
 #include <am/sdb_hash/sdb_fixedhash.h>
 #include <am/tokyo_cabinet/tc_hash.h>
 
+#include <am/concept/WriteBatch.h>
 #include <util/ThreadModel.h>
 
+#include <algorithm>
+
 /*#ifdef EXTERNAL_TOKYO_CABINET
  #include <am/tokyo_cabinet/tc_hash.h>
  #endif*/
@@ -221,6 +224,25 @@ public:
             return false;
         }
     }
+    /**
+     *  \brief read all keys while holding the read lock once.
+     *
+     *  Keys are looked up in ascending order, so that btree containers
+     *  traverse neighbouring pages consecutively and hash containers hit the
+     *  same buckets while they are still cached.
+     *
+     *  @return the number of keys found, found[i] tells whether values[i] is set.
+     */
+    size_t multiGet(const vector<KeyType>& keys, vector<ValueType>& values,
+                    vector<bool>& found);
+
+    /**
+     *  \brief apply all operations of the batch while holding the write lock once.
+     *
+     *  @return true if every operation succeeded
+     */
+    bool writeBatch(const WriteBatch<KeyType, ValueType>& batch);
+
     /**
      *  	\brief It deletes an item from SequentialDB.
      */
@@ -576,6 +598,24 @@ public:
 
 
 private:
+    /// orders positions of a key vector by the keys they refer to.
+    struct KeyIndexLess_
+    {
+        const vector<KeyType>& keys_;
+        const izenelib::am::CompareFunctor<KeyType>& comp_;
+
+        KeyIndexLess_(const vector<KeyType>& keys,
+                      const izenelib::am::CompareFunctor<KeyType>& comp)
+            : keys_(keys), comp_(comp)
+        {
+        }
+
+        bool operator()(size_t a, size_t b) const
+        {
+            return comp_(keys_[a], keys_[b]) < 0;
+        }
+    };
+
     std::string sdbname_;
     ContainerType container_;
     LockType lock_; // for multithread access.
@@ -606,6 +646,60 @@ ValueType, LockType, ContainerType, Alloc>::insertValue(
     return ret;
 }
 
+template<typename KeyType, typename ValueType, typename LockType,
+typename ContainerType, typename Alloc> size_t SequentialDB< KeyType,
+ValueType, LockType, ContainerType, Alloc>::multiGet(
+    const vector<KeyType>& keys, vector<ValueType>& values,
+    vector<bool>& found)
+{
+    values.resize(keys.size());
+    found.assign(keys.size(), false);
+
+    vector<size_t> order(keys.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), KeyIndexLess_(keys, comp_));
+
+    size_t count = 0;
+    ScopedReadLockType lock(lock_);
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        size_t pos = order[i];
+        if (container_.get(keys[pos], values[pos]))
+        {
+            found[pos] = true;
+            ++count;
+        }
+    }
+    return count;
+}
+
+template<typename KeyType, typename ValueType, typename LockType,
+typename ContainerType, typename Alloc> bool SequentialDB< KeyType,
+ValueType, LockType, ContainerType, Alloc>::writeBatch(
+    const WriteBatch<KeyType, ValueType>& batch)
+{
+    bool ret = true;
+    ScopedWriteLockType lock(lock_);
+    typedef typename WriteBatch<KeyType, ValueType>::const_iterator iterator;
+    for (iterator it = batch.begin(); it != batch.end(); ++it)
+    {
+        switch (it->type)
+        {
+        case BATCH_INSERT:
+            ret = container_.insert(DataType<KeyType, ValueType>(it->key, it->value)) && ret;
+            break;
+        case BATCH_UPDATE:
+            ret = container_.update(DataType<KeyType, ValueType>(it->key, it->value)) && ret;
+            break;
+        case BATCH_DEL:
+            ret = container_.del(it->key) && ret;
+            break;
+        }
+    }
+    return ret;
+}
+
 template<typename KeyType, typename ValueType, typename LockType,
 typename ContainerType, typename Alloc> bool SequentialDB< KeyType,
 ValueType, LockType, ContainerType, Alloc>::del(const KeyType& key)
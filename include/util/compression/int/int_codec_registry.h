@@ -0,0 +1,343 @@
+/**
+ * @file	int_codec_registry.h
+ * @brief	One block interface over the integer codecs of the tree, and a
+ *          list codec choosing the codec of each block from its statistics
+ * @details
+ * ==============
+ * The tree has three families of integer codecs with their own calling
+ * conventions: util/compression/int (compress() on writable buffers),
+ * int/fastpfor (IntegerCODEC::encodeArray) and simd-compression
+ * (SIMDCompression::IntegerCODEC, 16 bytes aligned buffers). IntBlockCodec
+ * hides these differences, and IntCodecRegistry owns one instance of each
+ * codec under a fixed IntCodecTag.
+ *
+ * AutoIntCodec splits a list into blocks, lets IntCodecSelector pick a codec
+ * per block and stores the tag in the block header, so the choice is made
+ * from the data at encode time and the decoder needs no configuration.
+ *
+ * The tags are persisted, never renumber them.
+ *
+ * Like the codecs they wrap, none of these classes is thread safe, use one
+ * instance per thread.
+ */
+#ifndef IZENE_UTIL_COMPRESSION_INT_CODEC_REGISTRY_H
+#define IZENE_UTIL_COMPRESSION_INT_CODEC_REGISTRY_H
+
+#include <util/compression/int/vbyte_compressor.h>
+#include <util/compression/int/s16_compressor.h>
+#include <util/compression/int/pfordelta_mix_compressor.h>
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace izenelib{namespace util{namespace compression{
+
+enum IntCodecTag
+{
+    INT_CODEC_COPY = 0,
+    INT_CODEC_VBYTE,
+    INT_CODEC_S16,
+    INT_CODEC_PFORDELTA_MIX,
+    INT_CODEC_FASTPFOR,
+    INT_CODEC_SIMDFASTPFOR,
+    INT_CODEC_SIMPLE8B,
+    INT_CODEC_SIMD_BP128,
+    INT_CODEC_NUM
+};
+
+class IntBlockCodec
+{
+public:
+    /// extra room the decoders may write after the last value
+    static const uint32_t DECODE_PADDING = 256;
+
+    IntBlockCodec(const char* name, uint32_t maxValue, bool aligned)
+        : name_(name), maxValue_(maxValue), aligned_(aligned)
+    {}
+
+    virtual ~IntBlockCodec() {}
+
+    const char* name() const { return name_; }
+
+    /// the largest value the codec can encode
+    uint32_t maxValue() const { return maxValue_; }
+
+    /// whether the encoded words must start at a 16 bytes boundary
+    bool aligned() const { return aligned_; }
+
+    static uint32_t maxEncodedWords(uint32_t size)
+    {
+        return 2 * size + 1024;
+    }
+
+    /**
+     * encode size values into out, which must hold maxEncodedWords(size)
+     * words
+     * @return the number of words written
+     */
+    virtual uint32_t encode(const uint32_t* in, uint32_t size, uint32_t* out) = 0;
+
+    /**
+     * decode size values from the words encoded by encode(), out must have
+     * DECODE_PADDING more values of room
+     */
+    virtual void decode(const uint32_t* in, uint32_t words, uint32_t* out, uint32_t size) = 0;
+
+protected:
+    /// a zero padded copy of in, 16 bytes aligned
+    uint32_t* scratchCopy(const uint32_t* in, uint32_t size, uint32_t i = 0)
+    {
+        uint32_t* scratch = scratch_(size + DECODE_PADDING, i);
+        memcpy(scratch, in, size * sizeof(uint32_t));
+        memset(scratch + size, 0, DECODE_PADDING * sizeof(uint32_t));
+        return scratch;
+    }
+
+    uint32_t* scratch_(size_t size, uint32_t i = 0)
+    {
+        std::vector<uint32_t>& buffer = buffers_[i];
+        if (buffer.size() < size + 4)
+            buffer.resize(size + 4);
+        uint32_t* p = &buffer[0];
+        while (reinterpret_cast<uintptr_t>(p) & 15)
+            ++p;
+        return p;
+    }
+
+private:
+    const char* name_;
+    uint32_t maxValue_;
+    bool aligned_;
+    std::vector<uint32_t> buffers_[2];
+};
+
+/**
+ * codecs of util/compression/int, compress() and decompress() return the
+ * number of words written and read
+ */
+template<typename CompressorT>
+class IzeneIntBlockCodec : public IntBlockCodec
+{
+public:
+    IzeneIntBlockCodec(const char* name, uint32_t maxValue)
+        : IntBlockCodec(name, maxValue, false)
+    {}
+
+    uint32_t encode(const uint32_t* in, uint32_t size, uint32_t* out)
+    {
+        return coder_.compress(scratchCopy(in, size), out, size);
+    }
+
+    void decode(const uint32_t* in, uint32_t words, uint32_t* out, uint32_t size)
+    {
+        coder_.decompress(const_cast<uint32_t*>(in), out, size);
+    }
+
+private:
+    CompressorT coder_;
+};
+
+/**
+ * codecs of int/fastpfor and simd-compression, the aligned ones decode
+ * through scratch buffers when in or out is not 16 bytes aligned
+ */
+template<typename CodecT>
+class LemireIntBlockCodec : public IntBlockCodec
+{
+public:
+    LemireIntBlockCodec(const char* name, bool aligned)
+        : IntBlockCodec(name, 0xFFFFFFFF, aligned)
+    {}
+
+    uint32_t encode(const uint32_t* in, uint32_t size, uint32_t* out)
+    {
+        size_t nvalue = maxEncodedWords(size);
+        codec_.encodeArray(scratchCopy(in, size), size, out, nvalue);
+        return nvalue;
+    }
+
+    void decode(const uint32_t* in, uint32_t words, uint32_t* out, uint32_t size)
+    {
+        size_t nvalue = size + DECODE_PADDING;
+        if (!aligned())
+        {
+            codec_.decodeArray(in, words, out, nvalue);
+            return;
+        }
+
+        if (reinterpret_cast<uintptr_t>(in) & 15)
+            in = scratchCopy(in, words, 1);
+
+        if (reinterpret_cast<uintptr_t>(out) & 15)
+        {
+            uint32_t* scratch = scratch_(nvalue);
+            codec_.decodeArray(in, words, scratch, nvalue);
+            memcpy(out, scratch, size * sizeof(uint32_t));
+        }
+        else
+        {
+            codec_.decodeArray(in, words, out, nvalue);
+        }
+    }
+
+private:
+    CodecT codec_;
+};
+
+class IntCodecRegistry
+{
+public:
+    IntCodecRegistry();
+    ~IntCodecRegistry();
+
+    IntBlockCodec* get(uint32_t tag) const
+    {
+        return codecs_[tag];
+    }
+
+    /// INT_CODEC_NUM when no codec has the name
+    uint32_t tagOf(const std::string& name) const;
+
+private:
+    IntCodecRegistry(const IntCodecRegistry&);
+    IntCodecRegistry& operator=(const IntCodecRegistry&);
+
+    std::vector<IntBlockCodec*> codecs_;
+};
+
+/// bit widths of the values of a block, and of each of its 128 values groups
+struct IntBlockStats
+{
+    static const uint32_t GROUP_SIZE = 128;
+
+    uint32_t size;
+    uint32_t maxBits;
+    uint32_t histogram[33];
+    /// histograms of the whole groups, the tail is only in histogram
+    std::vector<uint32_t> groupHistograms;
+
+    void compute(const uint32_t* in, uint32_t size);
+
+    uint32_t groupNum() const
+    {
+        return size / GROUP_SIZE;
+    }
+
+    const uint32_t* groupHistogram(uint32_t group) const
+    {
+        return &groupHistograms[group * 33];
+    }
+};
+
+/**
+ * picks the codec of a block: the smallest one, except that a faster
+ * decoder wins when its size is within speedBias of the smallest.
+ *
+ * ESTIMATE derives the sizes from IntBlockStats, and from a simulation of
+ * the word packing for the Simple codecs, EXHAUSTIVE encodes the block with
+ * every codec.
+ */
+class IntCodecSelector
+{
+public:
+    enum Mode
+    {
+        ESTIMATE,
+        EXHAUSTIVE
+    };
+
+    IntCodecSelector(IntCodecRegistry& registry, Mode mode = ESTIMATE, double speedBias = 0.05);
+
+    uint32_t select(const uint32_t* in, uint32_t size);
+
+    /**
+     * estimated size in bits, -1 when the codec can not encode the block
+     * @param stats computed from the stats.size values of in
+     */
+    uint64_t estimateBits(uint32_t tag, const uint32_t* in, const IntBlockStats& stats) const;
+
+private:
+    IntCodecRegistry& registry_;
+    Mode mode_;
+    double speedBias_;
+    IntBlockStats stats_;
+    std::vector<uint32_t> buffer_;
+};
+
+/**
+ * A list of integers as blocks, each coded by its own codec:
+ *
+ *   [size][block size]
+ *   for each block: [tag << 24 | padding << 22 | words][padding][encoded words]
+ *
+ * The encoded words of codecs needing alignment are padded to 16 bytes.
+ * Decoding from a buffer with another alignment than the encoding one
+ * works, but copies these blocks, so keep the buffers 16 bytes aligned,
+ * as std::vector storage is.
+ */
+class AutoIntCodec
+{
+public:
+    static const uint32_t HEADER_WORDS = 2;
+    static const uint32_t MAX_BLOCK_WORDS = (1 << 22) - 1;
+
+    AutoIntCodec(uint32_t blockSize = 1024,
+                 IntCodecSelector::Mode mode = IntCodecSelector::ESTIMATE,
+                 double speedBias = 0.05);
+
+    /// code every block with tag instead of selecting, INT_CODEC_NUM to select again
+    void setFixedCodec(uint32_t tag)
+    {
+        fixedCodec_ = tag;
+    }
+
+    uint32_t blockSize() const
+    {
+        return blockSize_;
+    }
+
+    static uint32_t maxEncodedWords(uint32_t size)
+    {
+        return HEADER_WORDS + 2 * size + (size / 128 + 1) * 1024;
+    }
+
+    /// out must hold maxEncodedWords(size) words, returns the words written
+    uint32_t encode(const uint32_t* in, uint32_t size, uint32_t* out);
+
+    void encode(const std::vector<uint32_t>& in, std::vector<uint32_t>& out);
+
+    static uint32_t decodedSize(const uint32_t* in)
+    {
+        return in[0];
+    }
+
+    /**
+     * out must hold decodedSize(in) + IntBlockCodec::DECODE_PADDING values
+     * @return the number of words read
+     */
+    uint32_t decode(const uint32_t* in, uint32_t* out);
+
+    /// how many blocks each codec has encoded
+    const std::vector<uint64_t>& codecUsage() const
+    {
+        return codecUsage_;
+    }
+
+    const IntCodecRegistry& registry() const
+    {
+        return registry_;
+    }
+
+private:
+    uint32_t blockSize_;
+    uint32_t fixedCodec_;
+    IntCodecRegistry registry_;
+    IntCodecSelector selector_;
+    std::vector<uint64_t> codecUsage_;
+};
+
+}}}
+
+#endif
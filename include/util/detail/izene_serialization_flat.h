@@ -0,0 +1,813 @@
+#ifndef IZENE_SERIALIZATION_FLAT_H_
+#define IZENE_SERIALIZATION_FLAT_H_
+/**
+ * @file izene_serialization_flat.h
+ * @brief Flat, offset addressed binary layout.
+ *
+ * A flat image can be read in place: every field of a record is reached
+ * through an offset table, strings and vectors of arithmetic types are
+ * exposed as (pointer, length) views, maps as sorted key/value arrays that
+ * can be binary searched, so a reader only touches the fields it asks for.
+ *
+ * Encoding knows the exact image size up front (flat_size()), so it can
+ * write into a caller provided buffer without any allocation (flat_write()).
+ * flat_check() tells whether an untrusted image is consistent with its size,
+ * izene_deserialization_flat checks before reading.
+ *
+ * Record layout, all integers unaligned in the native byte order, so the
+ * images are not portable between hosts of different byte orders:
+ * @code
+ * uint32 size        // whole record, including this header
+ * uint16 version     // FlatVersion<T>::value of the writer
+ * uint16 nfields
+ * uint32 offsets[nfields]   // from the start of the record
+ * field images...
+ * @endcode
+ * Field images:
+ * - arithmetic: raw bytes
+ * - std::string: uint32 length, bytes
+ * - std::vector<arithmetic>: uint32 count, raw elements
+ * - other std::vector: uint32 count, uint32 offsets[count], element images
+ * - std::map<K, V>: uint32 count, uint32 offset of values, keys as
+ *   std::vector<K>, values as std::vector<V>
+ * - record: nested record
+ *
+ * Fields of a record are the members visited by its
+ * <tt>serialize(Archive&, const unsigned int)</tt> member, in order. A
+ * reader only decodes the fields present in the image: fields appended in a
+ * newer version keep their default value when reading an older image, and
+ * unknown trailing fields are skipped. Declare a type with
+ * MAKE_FLAT_SERIALIZATION(T), optionally MAKE_FLAT_VERSION(T, v).
+ */
+
+#include "izene_type_traits.h"
+
+#include <boost/serialization/nvp.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+NS_IZENELIB_UTIL_BEGIN
+
+template <typename T>
+struct FlatVersion
+{
+    enum { value = 0 };
+};
+
+namespace flat
+{
+
+enum { RECORD_HEADER_SIZE = sizeof(uint32_t) + 2 * sizeof(uint16_t) };
+
+template <typename T>
+inline T load(const char* p)
+{
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+template <typename T>
+inline char* store(char* p, T v)
+{
+    std::memcpy(p, &v, sizeof(T));
+    return p + sizeof(T);
+}
+
+template <typename T, typename Enable = void>
+struct Codec;
+
+/// the element itself, the key or the value of a map entry, as encoded by Codec<std::vector<T> >
+struct Identity
+{
+    template <typename T>
+    const T& operator()(const T& v) const { return v; }
+};
+
+struct SelectFirst
+{
+    template <typename P>
+    const typename P::first_type& operator()(const P& p) const { return p.first; }
+};
+
+struct SelectSecond
+{
+    template <typename P>
+    const typename P::second_type& operator()(const P& p) const { return p.second; }
+};
+
+/// In place view of a string image.
+class StringView
+{
+public:
+    StringView() : data_(0), size_(0) {}
+    StringView(const char* data, std::size_t size) : data_(data), size_(size) {}
+
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    std::string str() const { return std::string(data_, size_); }
+
+    int compare(const char* s, std::size_t n) const
+    {
+        int r = std::memcmp(data_, s, std::min(size_, n));
+        if (r) return r;
+        return size_ < n ? -1 : (size_ > n ? 1 : 0);
+    }
+
+    bool operator==(const std::string& s) const
+    {
+        return compare(s.data(), s.size()) == 0;
+    }
+
+private:
+    const char* data_;
+    std::size_t size_;
+};
+
+/// In place view of a vector image, elements are viewed on access.
+template <typename T>
+class VectorView
+{
+public:
+    typedef typename Codec<T>::view_type value_type;
+
+    VectorView() : base_(0), size_(0) {}
+    explicit VectorView(const char* base)
+        : base_(base), size_(load<uint32_t>(base))
+    {
+    }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    value_type operator[](std::size_t i) const
+    {
+        return Codec<std::vector<T> >::element(base_, i);
+    }
+
+    /// index of the first element not less than @p key, the vector must be sorted.
+    template <typename K>
+    std::size_t lower_bound(const K& key) const
+    {
+        std::size_t lo = 0, hi = size_;
+        while (lo < hi)
+        {
+            std::size_t mid = lo + (hi - lo) / 2;
+            if (Codec<T>::less((*this)[mid], key))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+private:
+    const char* base_;
+    std::size_t size_;
+};
+
+/// In place view of a map image.
+template <typename K, typename V>
+class MapView
+{
+public:
+    MapView() {}
+    explicit MapView(const char* base)
+        : keys_(base + 2 * sizeof(uint32_t))
+        , values_(base + load<uint32_t>(base + sizeof(uint32_t)))
+    {
+    }
+
+    std::size_t size() const { return keys_.size(); }
+    bool empty() const { return keys_.empty(); }
+    typename Codec<K>::view_type key(std::size_t i) const { return keys_[i]; }
+    typename Codec<V>::view_type value(std::size_t i) const { return values_[i]; }
+
+    /// binary search, returns size() if @p key is absent.
+    template <typename Key>
+    std::size_t find(const Key& key) const
+    {
+        std::size_t i = keys_.lower_bound(key);
+        if (i < keys_.size() && !Codec<K>::less(key, keys_[i]))
+            return i;
+        return keys_.size();
+    }
+
+private:
+    VectorView<K> keys_;
+    VectorView<V> values_;
+};
+
+template <typename T>
+class RecordView;
+
+/// arithmetic types
+template <typename T>
+struct Codec<T, typename boost::enable_if_c<boost::is_arithmetic<T>::value>::type>
+{
+    typedef T view_type;
+    enum { fixed_size = sizeof(T) };
+
+    static std::size_t size(const T&) { return sizeof(T); }
+    static char* write(const T& v, char* p) { return store(p, v); }
+    static void read(const char* p, T& v) { v = load<T>(p); }
+    static view_type view(const char* p) { return load<T>(p); }
+    static bool check(const char*, std::size_t size) { return size >= sizeof(T); }
+
+    static bool less(T a, T b) { return a < b; }
+};
+
+template <>
+struct Codec<std::string>
+{
+    typedef StringView view_type;
+    enum { fixed_size = 0 };
+
+    static std::size_t size(const std::string& v)
+    {
+        return sizeof(uint32_t) + v.size();
+    }
+    static char* write(const std::string& v, char* p)
+    {
+        p = store<uint32_t>(p, v.size());
+        std::memcpy(p, v.data(), v.size());
+        return p + v.size();
+    }
+    static void read(const char* p, std::string& v)
+    {
+        v.assign(p + sizeof(uint32_t), load<uint32_t>(p));
+    }
+    static view_type view(const char* p)
+    {
+        return StringView(p + sizeof(uint32_t), load<uint32_t>(p));
+    }
+    static bool check(const char* p, std::size_t size)
+    {
+        return size >= sizeof(uint32_t) && load<uint32_t>(p) <= size - sizeof(uint32_t);
+    }
+
+    static bool less(const StringView& a, const std::string& b)
+    {
+        return a.compare(b.data(), b.size()) < 0;
+    }
+    static bool less(const std::string& a, const StringView& b)
+    {
+        return b.compare(a.data(), a.size()) > 0;
+    }
+};
+
+template <typename T>
+struct Codec<std::vector<T> >
+{
+    typedef VectorView<T> view_type;
+    enum { fixed_size = 0 };
+
+    static std::size_t size(const std::vector<T>& v)
+    {
+        return size(v.begin(), v.end(), v.size(), Identity());
+    }
+
+    static char* write(const std::vector<T>& v, char* p)
+    {
+        return write(v.begin(), v.end(), v.size(), Identity(), p);
+    }
+
+    /// size of the image of the vector of get(*it) for it in [first, last)
+    template <typename Iterator, typename Get>
+    static std::size_t size(Iterator first, Iterator last, std::size_t count, Get get)
+    {
+        if (Codec<T>::fixed_size != 0)
+            return sizeof(uint32_t) + count * Codec<T>::fixed_size;
+
+        std::size_t s = sizeof(uint32_t) * (1 + count);
+        for (; first != last; ++first)
+            s += Codec<T>::size(get(*first));
+        return s;
+    }
+
+    /// writes the image of the vector of get(*it) for it in [first, last)
+    template <typename Iterator, typename Get>
+    static char* write(Iterator first, Iterator last, std::size_t count, Get get, char* p)
+    {
+        char* base = p;
+        p = store<uint32_t>(p, count);
+        if (Codec<T>::fixed_size != 0)
+        {
+            for (; first != last; ++first)
+                p = Codec<T>::write(get(*first), p);
+            return p;
+        }
+
+        char* offsets = p;
+        p += sizeof(uint32_t) * count;
+        for (; first != last; ++first)
+        {
+            offsets = store<uint32_t>(offsets, p - base);
+            p = Codec<T>::write(get(*first), p);
+        }
+        return p;
+    }
+
+    static void read(const char* p, std::vector<T>& v)
+    {
+        v.resize(load<uint32_t>(p));
+        for (std::size_t i = 0; i < v.size(); ++i)
+            Codec<T>::read(locate(p, i), v[i]);
+    }
+
+    static view_type view(const char* p)
+    {
+        return view_type(p);
+    }
+
+    static typename Codec<T>::view_type element(const char* p, std::size_t i)
+    {
+        return Codec<T>::view(locate(p, i));
+    }
+
+    static bool check(const char* p, std::size_t size)
+    {
+        if (size < sizeof(uint32_t))
+            return false;
+
+        std::size_t count = load<uint32_t>(p);
+        if (Codec<T>::fixed_size != 0)
+            return count <= (size - sizeof(uint32_t)) / Codec<T>::fixed_size;
+
+        if (count > size / sizeof(uint32_t) - 1)
+            return false;
+        std::size_t begin = sizeof(uint32_t) * (1 + count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::size_t offset = load<uint32_t>(p + sizeof(uint32_t) * (1 + i));
+            if (offset < begin || offset > size || !Codec<T>::check(p + offset, size - offset))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    static const char* locate(const char* p, std::size_t i)
+    {
+        if (Codec<T>::fixed_size != 0)
+            return p + sizeof(uint32_t) + i * Codec<T>::fixed_size;
+        return p + load<uint32_t>(p + sizeof(uint32_t) * (1 + i));
+    }
+};
+
+template <typename K, typename V>
+struct Codec<std::map<K, V> >
+{
+    typedef MapView<K, V> view_type;
+    enum { fixed_size = 0 };
+
+    static std::size_t size(const std::map<K, V>& m)
+    {
+        std::size_t s = 2 * sizeof(uint32_t);
+        s += Codec<std::vector<K> >::size(m.begin(), m.end(), m.size(), SelectFirst());
+        s += Codec<std::vector<V> >::size(m.begin(), m.end(), m.size(), SelectSecond());
+        return s;
+    }
+
+    static char* write(const std::map<K, V>& m, char* p)
+    {
+        char* base = p;
+        p = store<uint32_t>(p, m.size());
+        char* valuesOffset = p;
+        p = Codec<std::vector<K> >::write(m.begin(), m.end(), m.size(), SelectFirst(),
+                                          p + sizeof(uint32_t));
+        store<uint32_t>(valuesOffset, p - base);
+        return Codec<std::vector<V> >::write(m.begin(), m.end(), m.size(), SelectSecond(), p);
+    }
+
+    static void read(const char* p, std::map<K, V>& m)
+    {
+        std::vector<K> k;
+        std::vector<V> v;
+        Codec<std::vector<K> >::read(p + 2 * sizeof(uint32_t), k);
+        Codec<std::vector<V> >::read(p + load<uint32_t>(p + sizeof(uint32_t)), v);
+        m.clear();
+        for (std::size_t i = 0; i < k.size(); ++i)
+            m.insert(m.end(), std::make_pair(k[i], v[i]));
+    }
+
+    static view_type view(const char* p)
+    {
+        return view_type(p);
+    }
+
+    static bool check(const char* p, std::size_t size)
+    {
+        const std::size_t keysOffset = 2 * sizeof(uint32_t);
+        if (size < keysOffset)
+            return false;
+
+        uint32_t count = load<uint32_t>(p);
+        std::size_t valuesOffset = load<uint32_t>(p + sizeof(uint32_t));
+        return valuesOffset >= keysOffset && valuesOffset <= size
+            && Codec<std::vector<K> >::check(p + keysOffset, size - keysOffset)
+            && Codec<std::vector<V> >::check(p + valuesOffset, size - valuesOffset)
+            && load<uint32_t>(p + keysOffset) == count
+            && load<uint32_t>(p + valuesOffset) == count;
+    }
+};
+
+/// archive computing the image size of the fields of a record
+class SizeArchive
+{
+public:
+    SizeArchive() : nfields_(0), size_(0) {}
+
+    template <typename F>
+    SizeArchive& operator&(const F& f)
+    {
+        ++nfields_;
+        size_ += Codec<F>::size(f);
+        return *this;
+    }
+
+    template <typename F>
+    SizeArchive& operator&(const boost::serialization::nvp<F>& f)
+    {
+        return *this & f.const_value();
+    }
+
+    std::size_t nfields() const { return nfields_; }
+    std::size_t size() const { return size_; }
+
+private:
+    std::size_t nfields_;
+    std::size_t size_;
+};
+
+/// archive writing fields and filling the offset table of a record
+class WriteArchive
+{
+public:
+    WriteArchive(char* base, std::size_t nfields)
+        : base_(base)
+        , offsets_(base + RECORD_HEADER_SIZE)
+        , cursor_(offsets_ + nfields * sizeof(uint32_t))
+    {
+    }
+
+    template <typename F>
+    WriteArchive& operator&(const F& f)
+    {
+        offsets_ = store<uint32_t>(offsets_, cursor_ - base_);
+        cursor_ = Codec<F>::write(f, cursor_);
+        return *this;
+    }
+
+    template <typename F>
+    WriteArchive& operator&(const boost::serialization::nvp<F>& f)
+    {
+        return *this & f.const_value();
+    }
+
+    char* end() const { return cursor_; }
+
+private:
+    char* base_;
+    char* offsets_;
+    char* cursor_;
+};
+
+/// archive decoding the fields present in a record image
+class ReadArchive
+{
+public:
+    explicit ReadArchive(const char* base)
+        : base_(base)
+        , nfields_(load<uint16_t>(base + sizeof(uint32_t) + sizeof(uint16_t)))
+        , field_(0)
+    {
+    }
+
+    template <typename F>
+    ReadArchive& operator&(F& f)
+    {
+        if (field_ < nfields_)
+        {
+            const char* p = base_ + RECORD_HEADER_SIZE + field_ * sizeof(uint32_t);
+            Codec<F>::read(base_ + load<uint32_t>(p), f);
+        }
+        ++field_;
+        return *this;
+    }
+
+    template <typename F>
+    ReadArchive& operator&(const boost::serialization::nvp<F>& f)
+    {
+        return *this & f.value();
+    }
+
+    unsigned int version() const
+    {
+        return load<uint16_t>(base_ + sizeof(uint32_t));
+    }
+
+private:
+    const char* base_;
+    std::size_t nfields_;
+    std::size_t field_;
+};
+
+/// archive checking the fields present in a record image against its size
+class CheckArchive
+{
+public:
+    CheckArchive(const char* base, std::size_t size)
+        : base_(base)
+        , size_(size)
+        , nfields_(load<uint16_t>(base + sizeof(uint32_t) + sizeof(uint16_t)))
+        , field_(0)
+        , valid_(true)
+    {
+    }
+
+    template <typename F>
+    CheckArchive& operator&(const F&)
+    {
+        if (valid_ && field_ < nfields_)
+        {
+            std::size_t begin = RECORD_HEADER_SIZE + nfields_ * sizeof(uint32_t);
+            std::size_t offset = load<uint32_t>(base_ + RECORD_HEADER_SIZE + field_ * sizeof(uint32_t));
+            valid_ = offset >= begin && offset <= size_
+                && Codec<F>::check(base_ + offset, size_ - offset);
+        }
+        ++field_;
+        return *this;
+    }
+
+    template <typename F>
+    CheckArchive& operator&(const boost::serialization::nvp<F>& f)
+    {
+        return *this & f.const_value();
+    }
+
+    unsigned int version() const
+    {
+        return load<uint16_t>(base_ + sizeof(uint32_t));
+    }
+
+    bool valid() const { return valid_; }
+
+private:
+    const char* base_;
+    std::size_t size_;
+    std::size_t nfields_;
+    std::size_t field_;
+    bool valid_;
+};
+
+/// records, i.e. types declared with MAKE_FLAT_SERIALIZATION
+template <typename T>
+struct Codec<T, typename boost::enable_if_c<IsFlatSerial<T>::yes
+                                            && !boost::is_arithmetic<T>::value>::type>
+{
+    typedef RecordView<T> view_type;
+    enum { fixed_size = 0 };
+
+    static std::size_t size(const T& v)
+    {
+        SizeArchive ar;
+        const_cast<T&>(v).serialize(ar, FlatVersion<T>::value);
+        return RECORD_HEADER_SIZE + ar.nfields() * sizeof(uint32_t) + ar.size();
+    }
+
+    static char* write(const T& v, char* p)
+    {
+        SizeArchive sizer;
+        const_cast<T&>(v).serialize(sizer, FlatVersion<T>::value);
+
+        WriteArchive ar(p, sizer.nfields());
+        const_cast<T&>(v).serialize(ar, FlatVersion<T>::value);
+
+        store<uint32_t>(p, ar.end() - p);
+        store<uint16_t>(p + sizeof(uint32_t), FlatVersion<T>::value);
+        store<uint16_t>(p + sizeof(uint32_t) + sizeof(uint16_t), sizer.nfields());
+        return ar.end();
+    }
+
+    static void read(const char* p, T& v)
+    {
+        ReadArchive ar(p);
+        v.serialize(ar, ar.version());
+    }
+
+    static bool check(const char* p, std::size_t size)
+    {
+        if (size < RECORD_HEADER_SIZE)
+            return false;
+
+        std::size_t record = load<uint32_t>(p);
+        std::size_t nfields = load<uint16_t>(p + sizeof(uint32_t) + sizeof(uint16_t));
+        if (record > size || record < RECORD_HEADER_SIZE + nfields * sizeof(uint32_t))
+            return false;
+
+        // only the types of the fields are visited
+        T v;
+        CheckArchive ar(p, record);
+        v.serialize(ar, ar.version());
+        return ar.valid();
+    }
+
+    static view_type view(const char* p)
+    {
+        return view_type(p);
+    }
+};
+
+/**
+ * @brief In place view of a record image.
+ *
+ * @code
+ * RecordView<Doc> doc(ptr);
+ * StringView title = doc.field<std::string>(1);
+ * @endcode
+ * @p F must be the declared type of field @p i, absent fields are returned as
+ * a default constructed view.
+ */
+template <typename T>
+class RecordView
+{
+public:
+    RecordView() : base_(0) {}
+    explicit RecordView(const char* base) : base_(base) {}
+
+    std::size_t size() const
+    {
+        return load<uint32_t>(base_);
+    }
+
+    unsigned int version() const
+    {
+        return load<uint16_t>(base_ + sizeof(uint32_t));
+    }
+
+    std::size_t nfields() const
+    {
+        return load<uint16_t>(base_ + sizeof(uint32_t) + sizeof(uint16_t));
+    }
+
+    bool has(std::size_t i) const
+    {
+        return base_ && i < nfields();
+    }
+
+    template <typename F>
+    typename Codec<F>::view_type field(std::size_t i) const
+    {
+        if (!has(i))
+            return typename Codec<F>::view_type();
+
+        const char* p = base_ + RECORD_HEADER_SIZE + i * sizeof(uint32_t);
+        return Codec<F>::view(base_ + load<uint32_t>(p));
+    }
+
+    void get(T& v) const
+    {
+        Codec<T>::read(base_, v);
+    }
+
+private:
+    const char* base_;
+};
+
+} // namespace flat
+
+/**
+ * @brief exact size of the flat image of @p dat.
+ */
+template <typename T>
+inline std::size_t flat_size(const T& dat)
+{
+    return flat::Codec<T>::size(dat);
+}
+
+/**
+ * @brief write the flat image of @p dat into @p buf without allocating.
+ *
+ * @return bytes written, or 0 if @p capacity is smaller than flat_size(dat)
+ */
+template <typename T>
+inline std::size_t flat_write(const T& dat, char* buf, std::size_t capacity)
+{
+    std::size_t size = flat_size(dat);
+    if (size > capacity)
+        return 0;
+    flat::Codec<T>::write(dat, buf);
+    return size;
+}
+
+/**
+ * @brief whether @p buf holds a flat image of a @p T within @p size bytes,
+ * which flat_read() and flat_view() can access without going past them.
+ */
+template <typename T>
+inline bool flat_check(const char* buf, std::size_t size)
+{
+    return flat::Codec<T>::check(buf, size);
+}
+
+template <typename T>
+inline void flat_read(const char* buf, T& dat)
+{
+    flat::Codec<T>::read(buf, dat);
+}
+
+template <typename T>
+inline typename flat::Codec<T>::view_type flat_view(const char* buf)
+{
+    return flat::Codec<T>::view(buf);
+}
+
+/**
+ * @brief izene_serialization backend for the flat layout.
+ *
+ * Images up to INLINE_SIZE bytes are encoded into a buffer inside the
+ * object, larger ones into a single exactly sized allocation.
+ */
+template <typename T>
+class izene_serialization_flat
+{
+    enum { INLINE_SIZE = 256 };
+
+    char inline_[INLINE_SIZE];
+    char* ptr_;
+    size_t size_;
+
+public:
+    izene_serialization_flat(const T& dat)
+        : ptr_(inline_), size_(flat_size(dat))
+    {
+        if (size_ > INLINE_SIZE)
+            ptr_ = static_cast<char*>(std::malloc(size_));
+        flat::Codec<T>::write(dat, ptr_);
+    }
+
+    ~izene_serialization_flat()
+    {
+        if (ptr_ != inline_)
+            std::free(ptr_);
+    }
+
+    void write_image(char* &ptr, size_t& size)
+    {
+        ptr = ptr_;
+        size = size_;
+    }
+
+private:
+    izene_serialization_flat(const izene_serialization_flat&);
+    izene_serialization_flat& operator=(const izene_serialization_flat&);
+};
+
+/**
+ * @brief izene_deserialization backend for the flat layout, throws
+ * std::runtime_error on an image inconsistent with its size.
+ */
+template <typename T>
+class izene_deserialization_flat
+{
+    const char* ptr_;
+    size_t size_;
+
+public:
+    izene_deserialization_flat(const char* ptr, const size_t size)
+        : ptr_(ptr), size_(size)
+    {
+    }
+
+    void read_image(T& dat)
+    {
+        if (!flat_check<T>(ptr_, size_))
+            throw std::runtime_error("izene_deserialization_flat: corrupt image");
+        flat::Codec<T>::read(ptr_, dat);
+    }
+};
+
+NS_IZENELIB_UTIL_END
+
+#define MAKE_FLAT_VERSION(T, v) \
+namespace izenelib \
+{ \
+namespace util \
+{ \
+    template <>struct FlatVersion< T > \
+    { \
+        enum { value = v }; \
+    }; \
+} \
+}
+
+#endif /*IZENE_SERIALIZATION_FLAT_H_*/
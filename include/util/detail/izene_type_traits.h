@@ -225,6 +225,20 @@ struct IsFebirdSerial<std::map<T1, T2> >
     };
 };
 
+/**
+ * @brief types using the flat, offset addressed layout of
+ * izene_serialization_flat.h, see MAKE_FLAT_SERIALIZATION.
+ */
+template <typename T>
+struct IsFlatSerial
+{
+    enum
+    {
+        yes = 0,
+        no = !yes
+    };
+};
+
 NS_IZENELIB_UTIL_END
 
 #define MAKE_FEBIRD_SERIALIZATION(...) \
@@ -251,6 +265,18 @@ namespace util \
 } \
 }
 
+#define MAKE_FLAT_SERIALIZATION(...) \
+namespace izenelib \
+{ \
+namespace util \
+{ \
+    template <>struct IsFlatSerial< __VA_ARGS__ > \
+    { \
+        enum { yes = 1, no = !yes }; \
+    }; \
+} \
+}
+
 MAKE_MEMCPY_SERIALIZATION(std::string)
 MAKE_FEBIRD_SERIALIZATION(std::vector<std::string>)
 
@@ -18,10 +18,11 @@
 #include "detail/izene_serialization_memcpy.h"
 #include "detail/izene_serialization_febird.h"
 #include "detail/izene_serialization_boost.h"
+#include "detail/izene_serialization_flat.h"
 
 NS_IZENELIB_UTIL_BEGIN
 
-template<typename T, bool isMemcpy = false, bool isFeBird = false>
+template<typename T, bool isMemcpy = false, bool isFeBird = false, bool isFlat = false>
 struct izene_serial_type
 {
     typedef izene_serialization_boost<T> stype;
@@ -49,6 +50,19 @@ struct izene_serial_type<T, false, true>
     typedef izene_deserialization_febird<T> dtype;
 };
 
+template<typename T, bool isMemcpy, bool isFeBird>
+struct izene_serial_type<T, isMemcpy, isFeBird, true>
+    : izene_serial_type<T, isMemcpy, isFeBird>
+{
+};
+
+template<typename T, bool isFeBird>
+struct izene_serial_type<T, false, isFeBird, true>
+{
+    typedef izene_serialization_flat<T> stype;
+    typedef izene_deserialization_flat<T> dtype;
+};
+
 
 /**
  *
@@ -58,8 +72,8 @@ struct izene_serial_type<T, false, true>
  *
  */
 template <typename T> class izene_serialization {
-    typedef typename izene_serial_type< T, IsMemcpySerial<T>::yes, IsFebirdSerial<T>::yes>::stype
-            stype;
+    typedef typename izene_serial_type< T, IsMemcpySerial<T>::yes, IsFebirdSerial<T>::yes,
+            IsFlatSerial<T>::yes>::stype stype;
     stype impl;
 public:
     izene_serialization(const T& dat) :
@@ -80,8 +94,8 @@ public:
  *
  **/
 template <typename T> class izene_deserialization {
-    typedef typename izene_serial_type<T, IsMemcpySerial<T>::yes, IsFebirdSerial<T>::yes>::dtype
-            dtype;
+    typedef typename izene_serial_type<T, IsMemcpySerial<T>::yes, IsFebirdSerial<T>::yes,
+            IsFlatSerial<T>::yes>::dtype dtype;
     dtype impl;
 public:
     izene_deserialization(const char* ptr, const size_t size) :
@@ -0,0 +1,179 @@
+#ifndef UTIL_MPMC_QUEUE_H
+#define UTIL_MPMC_QUEUE_H
+/**
+ * @file util/mpmc_queue.h
+ * @brief A bounded lock free queue of many producers and many consumers.
+ *
+ * The ring buffer of Dmitry Vyukov: each cell has a sequence number telling
+ * whether it is free for the push of a round, or full for its pop, a push or
+ * a pop claims its cell by a compare and swap of the enqueue or dequeue
+ * position, and publishes it by storing the next sequence number. So a push
+ * and a pop are a compare and swap and two stores on an uncontended queue,
+ * and the producers and the consumers only meet on the cells.
+ *
+ * The capacity is rounded up to a power of 2. try_push() and try_pop() fail
+ * at once on a full or an empty queue, push() and pop() spin, then yield,
+ * until they succeed, so they suit the queues which are seldom full or empty
+ * for long; use concurrent_queue to block on a condition instead.
+ */
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <cstddef>
+
+namespace izenelib {
+namespace util {
+
+template<typename T>
+class mpmc_queue : private boost::noncopyable
+{
+public:
+    explicit mpmc_queue(std::size_t capacity = 1024)
+        : buffer_(NULL)
+        , mask_(0)
+        , enqueue_pos_(0)
+        , dequeue_pos_(0)
+    {
+        std::size_t size = 2;
+        while (size < capacity)
+            size <<= 1;
+        buffer_ = new cell[size];
+        mask_ = size - 1;
+        for (std::size_t i = 0; i < size; ++i)
+            buffer_[i].sequence.store(i, boost::memory_order_relaxed);
+    }
+
+    ~mpmc_queue()
+    {
+        delete[] buffer_;
+    }
+
+    /**
+     * @brief appends t, unless the queue is full
+     * @return false if full
+     */
+    bool try_push(const T& t)
+    {
+        cell* c;
+        std::size_t pos = enqueue_pos_.load(boost::memory_order_relaxed);
+        while (true)
+        {
+            c = &buffer_[pos & mask_];
+            std::size_t seq = c->sequence.load(boost::memory_order_acquire);
+            std::ptrdiff_t diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)pos;
+            if (diff == 0)
+            {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = enqueue_pos_.load(boost::memory_order_relaxed);
+        }
+        c->data = t;
+        c->sequence.store(pos + 1, boost::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief gets the first element, unless the queue is empty
+     * @param[out] t
+     * @return false if empty
+     */
+    bool try_pop(T& t)
+    {
+        cell* c;
+        std::size_t pos = dequeue_pos_.load(boost::memory_order_relaxed);
+        while (true)
+        {
+            c = &buffer_[pos & mask_];
+            std::size_t seq = c->sequence.load(boost::memory_order_acquire);
+            std::ptrdiff_t diff = (std::ptrdiff_t)seq - (std::ptrdiff_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, boost::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false;
+            else
+                pos = dequeue_pos_.load(boost::memory_order_relaxed);
+        }
+        t = c->data;
+        c->data = T();
+        c->sequence.store(pos + mask_ + 1, boost::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief appends t, waits while the queue is full
+     */
+    void push(const T& t)
+    {
+        for (unsigned int spin = 0; !try_push(t); ++spin)
+            backoff(spin);
+    }
+
+    /**
+     * @brief gets the first element, waits while the queue is empty
+     * @param[out] t
+     */
+    void pop(T& t)
+    {
+        for (unsigned int spin = 0; !try_pop(t); ++spin)
+            backoff(spin);
+    }
+
+    /**
+     * @return the number of elements, exact only when no thread pushes or pops
+     */
+    std::size_t size() const
+    {
+        std::size_t dequeued = dequeue_pos_.load(boost::memory_order_acquire);
+        std::size_t enqueued = enqueue_pos_.load(boost::memory_order_acquire);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    std::size_t capacity() const
+    {
+        return mask_ + 1;
+    }
+
+private:
+    enum { CACHE_LINE_SIZE = 64, SPIN_COUNT = 64 };
+
+    static void backoff(unsigned int spin)
+    {
+        if (spin >= SPIN_COUNT)
+            boost::this_thread::yield();
+    }
+
+    struct cell
+    {
+        boost::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    typedef char cache_line_pad[CACHE_LINE_SIZE];
+
+    cache_line_pad pad0_;
+    cell* buffer_;
+    std::size_t mask_;
+    cache_line_pad pad1_;
+    boost::atomic<std::size_t> enqueue_pos_;
+    cache_line_pad pad2_;
+    boost::atomic<std::size_t> dequeue_pos_;
+    cache_line_pad pad3_;
+};
+
+}} // namespace izenelib::util
+
+#endif // UTIL_MPMC_QUEUE_H
@@ -0,0 +1,152 @@
+#ifndef IZENELIB_UTIL_STRING_MYERS_EDIT_DISTANCE_H
+#define IZENELIB_UTIL_STRING_MYERS_EDIT_DISTANCE_H
+
+#include <types.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace izenelib
+{
+namespace util
+{
+
+/**
+ * The edit distance of a pattern to texts, computed bit parallel (Myers, and
+ * Hyyro for the patterns over a word): a column of the dynamic programming
+ * matrix is kept as its vertical deltas, one bit per row for +1 and one for
+ * -1, so a text char updates 64 rows with a few word operations.
+ *
+ * The pattern is compiled once and may be matched against many texts, but
+ * one instance should not be used by several threads, as distance() works in
+ * a buffer of the instance.
+ */
+template <class CharT>
+class MyersEditDistance
+{
+public:
+    MyersEditDistance()
+        : length_(), block_num_()
+    {
+    }
+
+    template <class StringT>
+    explicit MyersEditDistance(const StringT &pattern)
+    {
+        compile(pattern);
+    }
+
+    template <class StringT>
+    void compile(const StringT &pattern)
+    {
+        length_ = pattern.length();
+        block_num_ = (length_ + 63) / 64;
+        chars_.clear();
+        peq_.clear();
+
+        for (size_t i = 0; i < length_; ++i)
+        {
+            CharT c = pattern[i];
+            typename std::vector<std::pair<CharT, uint32_t> >::iterator it
+                = std::lower_bound(chars_.begin(), chars_.end(), std::make_pair(c, (uint32_t)0));
+            if (it == chars_.end() || it->first != c)
+            {
+                uint32_t index = peq_.size() / block_num_;
+                it = chars_.insert(it, std::make_pair(c, index));
+                peq_.resize(peq_.size() + block_num_);
+            }
+            peq_[it->second * block_num_ + i / 64] |= 1ULL << (i % 64);
+        }
+        pv_.resize(block_num_);
+        mv_.resize(block_num_);
+    }
+
+    size_t length() const
+    {
+        return length_;
+    }
+
+    /**
+     * @return the edit distance of @p text of @p len chars to the pattern, or
+     * @p max_distance + 1 once it is sure to be over @p max_distance
+     */
+    size_t distance(const CharT *text, size_t len, size_t max_distance = (size_t)-1)
+    {
+        // no distance is over the lengths, so the bound does not overflow
+        max_distance = std::min(max_distance, length_ + len);
+        if (len > length_ + max_distance || length_ > len + max_distance)
+            return max_distance + 1;
+        if (length_ == 0) return len;
+
+        std::fill(pv_.begin(), pv_.end(), ~0ULL);
+        std::fill(mv_.begin(), mv_.end(), 0ULL);
+        size_t last_bit = (length_ - 1) % 64;
+        size_t score = length_;
+
+        for (size_t j = 0; j < len; ++j)
+        {
+            const uint64_t *eq = eq_(text[j]);
+
+            // the top row of the matrix goes up by one for each text char
+            int hin = 1;
+            for (size_t b = 0; b < block_num_; ++b)
+            {
+                uint64_t e = eq ? eq[b] : 0;
+                uint64_t pv = pv_[b], mv = mv_[b];
+
+                uint64_t xv = e | mv;
+                if (hin < 0) e |= 1;
+                uint64_t xh = (((e & pv) + pv) ^ pv) | e;
+                uint64_t ph = mv | ~(xh | pv);
+                uint64_t mh = pv & xh;
+
+                size_t bit = b + 1 == block_num_ ? last_bit : 63;
+                int hout = (int)((ph >> bit) & 1) - (int)((mh >> bit) & 1);
+
+                ph <<= 1;
+                mh <<= 1;
+                if (hin < 0) mh |= 1;
+                else if (hin > 0) ph |= 1;
+                pv_[b] = mh | ~(xv | ph);
+                mv_[b] = ph & xv;
+                hin = hout;
+            }
+            score += hin;
+
+            // the bottom row goes down by at most one for each char left
+            if (score > max_distance + (len - j - 1))
+                return max_distance + 1;
+        }
+        return std::min(score, max_distance + 1);
+    }
+
+    template <class StringT>
+    size_t distance(const StringT &text, size_t max_distance = (size_t)-1)
+    {
+        if (text.length() == 0) return length_ > max_distance ? max_distance + 1 : length_;
+        return distance(&text[0], text.length(), max_distance);
+    }
+
+private:
+    /// the match bits of @p c by block, NULL if c is not in the pattern
+    inline const uint64_t *eq_(CharT c) const
+    {
+        typename std::vector<std::pair<CharT, uint32_t> >::const_iterator it
+            = std::lower_bound(chars_.begin(), chars_.end(), std::make_pair(c, (uint32_t)0));
+        if (it == chars_.end() || it->first != c) return NULL;
+        return &peq_[it->second * block_num_];
+    }
+
+    size_t length_;
+    size_t block_num_;
+    std::vector<std::pair<CharT, uint32_t> > chars_; ///< sorted, with the index of their bits in peq_
+    std::vector<uint64_t> peq_;
+    std::vector<uint64_t> pv_;
+    std::vector<uint64_t> mv_;
+};
+
+}
+}
+
+#endif // IZENELIB_UTIL_STRING_MYERS_EDIT_DISTANCE_H
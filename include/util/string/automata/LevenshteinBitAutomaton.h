@@ -0,0 +1,135 @@
+#ifndef IZENELIB_UTIL_STRING_LEVENSHTEIN_BIT_AUTOMATON_H
+#define IZENELIB_UTIL_STRING_LEVENSHTEIN_BIT_AUTOMATON_H
+
+#include <types.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace izenelib
+{
+namespace util
+{
+
+/**
+ * The automaton of the strings within edit distance k of a pattern, which
+ * needs no determinizing as LevenshteinAutomata does.
+ *
+ * It is simulated bit parallel (Wu-Manber): bit j of row d of a state is set
+ * when the first j chars of the pattern are within distance d of the chars
+ * read, so a state is k + 1 words, a pattern holds at most 63 chars and k is
+ * at most kMaxDistance.
+ *
+ * The interface is the one LoudsTrie::intersect() walks with.
+ */
+template <class CharT>
+class LevenshteinBitAutomaton
+{
+public:
+    static const size_t kMaxLength = 63;
+    static const size_t kMaxDistance = 3;
+
+    struct State
+    {
+        uint64_t rows[kMaxDistance + 1];
+    };
+
+    LevenshteinBitAutomaton()
+        : length_(), distance_()
+    {
+    }
+
+    /**
+     * @return false if @p pattern is longer than kMaxLength or @p distance
+     * over kMaxDistance
+     */
+    template <class StringT>
+    bool compile(const StringT &pattern, size_t distance);
+
+    inline State start() const
+    {
+        State state;
+        uint64_t valid = (2ULL << length_) - 1;
+        for (size_t d = 0; d <= distance_; ++d)
+            state.rows[d] = ((2ULL << d) - 1) & valid;
+        return state;
+    }
+
+    inline bool next(const State &state, CharT c, State &next) const
+    {
+        uint64_t mask = match_(c);
+        uint64_t valid = (2ULL << length_) - 1;
+
+        // next may be state
+        uint64_t last = state.rows[0];
+        next.rows[0] = (last << 1) & mask;
+        for (size_t d = 1; d <= distance_; ++d)
+        {
+            // a match, an inserted char, a substituted char and a deleted one
+            uint64_t row = state.rows[d];
+            next.rows[d] = (((row << 1) & mask) | last | (last << 1)
+                    | (next.rows[d - 1] << 1)) & valid;
+            last = row;
+        }
+        return next.rows[distance_] != 0;
+    }
+
+    inline bool isFinal(const State &state) const
+    {
+        return (state.rows[distance_] >> length_) & 1;
+    }
+
+    /// the distance of the chars read to the pattern, or distance() + 1 if over it
+    inline size_t distanceOf(const State &state) const
+    {
+        size_t d = 0;
+        while (d <= distance_ && !((state.rows[d] >> length_) & 1)) ++d;
+        return d;
+    }
+
+    size_t distance() const
+    {
+        return distance_;
+    }
+
+private:
+    /// the bits j + 1 where the j-th char of the pattern is c
+    inline uint64_t match_(CharT c) const
+    {
+        typename std::vector<std::pair<CharT, uint64_t> >::const_iterator it
+            = std::lower_bound(char_masks_.begin(), char_masks_.end(), std::make_pair(c, (uint64_t)0));
+        return it != char_masks_.end() && it->first == c ? it->second : 0;
+    }
+
+    size_t length_;
+    size_t distance_;
+    std::vector<std::pair<CharT, uint64_t> > char_masks_; ///< sorted by char
+};
+
+template <class CharT>
+template <class StringT>
+bool LevenshteinBitAutomaton<CharT>::compile(const StringT &pattern, size_t distance)
+{
+    length_ = pattern.length();
+    distance_ = distance;
+    char_masks_.clear();
+    if (length_ > kMaxLength || distance_ > kMaxDistance) return false;
+
+    for (size_t i = 0; i < length_; ++i)
+    {
+        CharT c = pattern[i];
+        typename std::vector<std::pair<CharT, uint64_t> >::iterator it
+            = std::lower_bound(char_masks_.begin(), char_masks_.end(), std::make_pair(c, (uint64_t)0));
+        if (it != char_masks_.end() && it->first == c)
+            it->second |= 2ULL << i;
+        else
+            char_masks_.insert(it, std::make_pair(c, 2ULL << i));
+    }
+    return true;
+}
+
+}
+}
+
+#endif // IZENELIB_UTIL_STRING_LEVENSHTEIN_BIT_AUTOMATON_H
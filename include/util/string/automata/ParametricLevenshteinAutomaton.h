@@ -0,0 +1,347 @@
+#ifndef IZENELIB_UTIL_STRING_PARAMETRIC_LEVENSHTEIN_AUTOMATON_H
+#define IZENELIB_UTIL_STRING_PARAMETRIC_LEVENSHTEIN_AUTOMATON_H
+
+#include <types.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+namespace izenelib
+{
+namespace util
+{
+
+/**
+ * The tables of the parametric Levenshtein automata (Schulz and Mihov), which
+ * are the same for all the patterns within a distance, so they are built once
+ * and a pattern only needs its chars.
+ *
+ * A state is a set of positions i#e, the first i chars of the pattern read
+ * within e edits, kept relative to the least i (the offset of the state) and
+ * without those subsumed by others. With transpositions, a position i#e_t
+ * waits for the char i, having read the char i + 1 in its place.
+ *
+ * Reading a char moves a state by its characteristic vector, whose bit j is
+ * set when the char j from the offset is the char read. It spans the window
+ * of 2 * distance + 1 chars; near the end of the pattern fewer chars are left,
+ * so there is a table for each number of chars left, up to the window.
+ */
+class ParametricLevenshteinTables
+{
+public:
+    static const size_t kMaxDistance = 2;
+
+    /// the tables of @p distance, which is at most kMaxDistance
+    static const ParametricLevenshteinTables &get(size_t distance, bool transposition)
+    {
+        assert(distance <= kMaxDistance);
+
+        static const ParametricLevenshteinTables tables[kMaxDistance + 1][2] =
+        {
+            { ParametricLevenshteinTables(0, false), ParametricLevenshteinTables(0, true) },
+            { ParametricLevenshteinTables(1, false), ParametricLevenshteinTables(1, true) },
+            { ParametricLevenshteinTables(2, false), ParametricLevenshteinTables(2, true) }
+        };
+        return tables[distance][transposition];
+    }
+
+    /// the dead state, the start state is 1
+    static const uint32_t kDeadState = 0;
+
+    size_t distance() const
+    {
+        return distance_;
+    }
+
+    size_t window() const
+    {
+        return window_;
+    }
+
+    size_t stateNum() const
+    {
+        return least_edits_.size();
+    }
+
+    /**
+     * @return the state after @p state on the vector @p bits, with @p left
+     * chars of the pattern from the offset, and the move of the offset in @p shift
+     */
+    inline uint32_t next(uint32_t state, size_t left, uint32_t bits, uint32_t &shift) const
+    {
+        if (left > window_) left = window_;
+        uint32_t trans = transitions_[left][(state << left) + bits];
+        shift = trans & 0xff;
+        return trans >> 8;
+    }
+
+    /// @return the edits of the pattern in @p state, with @p left chars from the offset
+    inline size_t edits(uint32_t state, size_t left) const
+    {
+        int edits = (int)left + least_edits_[state];
+        return edits > (int)distance_ ? distance_ + 1 : edits;
+    }
+
+private:
+    struct Position
+    {
+        int i;
+        int e;
+        bool t;
+
+        Position(int i, int e, bool t)
+            : i(i), e(e), t(t)
+        {
+        }
+
+        bool operator<(const Position &other) const
+        {
+            if (i != other.i) return i < other.i;
+            if (e != other.e) return e < other.e;
+            return t < other.t;
+        }
+
+        bool operator==(const Position &other) const
+        {
+            return i == other.i && e == other.e && t == other.t;
+        }
+
+        bool subsumes(const Position &other) const
+        {
+            return !t && !other.t && e < other.e && std::abs(i - other.i) <= other.e - e;
+        }
+    };
+
+    typedef std::vector<Position> PositionSet;
+
+    ParametricLevenshteinTables(size_t distance, bool transposition)
+        : distance_(distance), transposition_(transposition), window_(2 * distance + 1)
+    {
+        build_();
+    }
+
+    void build_()
+    {
+        std::map<PositionSet, uint32_t> ids;
+        std::vector<PositionSet> states(2);
+        ids[states[0]] = kDeadState;
+        states[1].push_back(Position(0, 0, false));
+        ids[states[1]] = 1;
+
+        transitions_.resize(window_ + 1);
+        for (uint32_t state = 0; state < states.size(); ++state)
+        {
+            for (size_t left = 0; left <= window_; ++left)
+            {
+                for (uint32_t bits = 0; bits < (1U << left); ++bits)
+                {
+                    PositionSet next;
+                    int shift = step_(states[state], left, bits, next);
+
+                    std::map<PositionSet, uint32_t>::iterator it = ids.find(next);
+                    if (it == ids.end())
+                    {
+                        it = ids.insert(std::make_pair(next, (uint32_t)states.size())).first;
+                        states.push_back(next);
+                    }
+                    transitions_[left].push_back((it->second << 8) | shift);
+                }
+            }
+        }
+
+        // the edits are left + e - i of the best position
+        least_edits_.resize(states.size());
+        for (size_t state = 0; state < states.size(); ++state)
+        {
+            int least = distance_ + 1;
+            for (size_t j = 0; j < states[state].size(); ++j)
+            {
+                const Position &pos = states[state][j];
+                if (!pos.t) least = std::min(least, pos.e - pos.i);
+            }
+            least_edits_[state] = least;
+        }
+    }
+
+    /// @return the shift of the offset of @p next
+    int step_(const PositionSet &state, size_t left, uint32_t bits, PositionSet &next) const
+    {
+        int k = distance_;
+        int l = left;
+        PositionSet positions;
+        for (size_t j = 0; j < state.size(); ++j)
+        {
+            const Position &pos = state[j];
+            int i = pos.i, e = pos.e;
+            // the window holds the chars any position reads
+            assert(i < l || l < (int)window_);
+            if (pos.t)
+            {
+                if (i < l && bit_(bits, i)) positions.push_back(Position(i + 2, e, false));
+                continue;
+            }
+
+            if (i < l && bit_(bits, i))
+            {
+                positions.push_back(Position(i + 1, e, false));
+                continue;
+            }
+            if (e == k) continue;
+
+            // an inserted char, a substituted one, deleted ones and a transposition
+            positions.push_back(Position(i, e + 1, false));
+            if (i < l) positions.push_back(Position(i + 1, e + 1, false));
+            for (int d = 1; d <= k - e && i + d < l; ++d)
+            {
+                if (bit_(bits, i + d)) positions.push_back(Position(i + d + 1, e + d, false));
+            }
+            if (transposition_ && i + 1 < l && bit_(bits, i + 1))
+                positions.push_back(Position(i, e + 1, true));
+        }
+
+        std::sort(positions.begin(), positions.end());
+        positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+        for (size_t j = 0; j < positions.size(); ++j)
+        {
+            bool subsumed = false;
+            for (size_t m = 0; m < positions.size() && !subsumed; ++m)
+                subsumed = positions[m].subsumes(positions[j]);
+            if (!subsumed) next.push_back(positions[j]);
+        }
+        if (next.empty()) return 0;
+
+        int shift = next[0].i;
+        for (size_t j = 0; j < next.size(); ++j)
+            next[j].i -= shift;
+        return shift;
+    }
+
+    inline bool bit_(uint32_t bits, int i) const
+    {
+        assert((size_t)i < window_);
+        return (bits >> i) & 1;
+    }
+
+    size_t distance_;
+    bool transposition_;
+    size_t window_;
+
+    /// for each number of chars left, the next state << 8 | the shift, by state and vector
+    std::vector<std::vector<uint32_t> > transitions_;
+    /// the least e - i of the positions of each state, over the distance if none
+    std::vector<int> least_edits_;
+};
+
+/**
+ * The automaton of the strings within edit distance k of a pattern, k being
+ * 1 or 2 (or 0), optionally counting the transposition of two adjacent chars
+ * as one edit.
+ *
+ * Building it only keeps the chars of the pattern, as the transitions are
+ * looked up in the shared ParametricLevenshteinTables, so unlike
+ * LevenshteinAutomata it takes O(|pattern|), and the chars can be of any
+ * width, so UString terms are read by their UCS2 chars.
+ *
+ * The interface is the one LoudsTrie::intersect() walks with.
+ */
+template <class CharT>
+class ParametricLevenshteinAutomaton
+{
+public:
+    static const size_t kMaxDistance = ParametricLevenshteinTables::kMaxDistance;
+
+    struct State
+    {
+        uint32_t id;
+        uint32_t offset;
+    };
+
+    ParametricLevenshteinAutomaton()
+        : tables_(&ParametricLevenshteinTables::get(0, false))
+    {
+    }
+
+    /**
+     * @return false if @p distance is over kMaxDistance
+     */
+    template <class StringT>
+    bool compile(const StringT &pattern, size_t distance, bool transposition = true)
+    {
+        if (distance > kMaxDistance) return false;
+
+        tables_ = &ParametricLevenshteinTables::get(distance, transposition);
+        pattern_.resize(pattern.length());
+        for (size_t i = 0; i < pattern_.size(); ++i)
+            pattern_[i] = pattern[i];
+        return true;
+    }
+
+    inline State start() const
+    {
+        State state = { 1, 0 };
+        return state;
+    }
+
+    inline bool next(const State &state, CharT c, State &next) const
+    {
+        size_t left = pattern_.size() - state.offset;
+        size_t window = std::min(left, tables_->window());
+        const CharT *p = pattern_.empty() ? NULL : &pattern_[0] + state.offset;
+
+        uint32_t bits = 0;
+        for (size_t j = 0; j < window; ++j)
+            bits |= (uint32_t)(p[j] == c) << j;
+
+        uint32_t shift;
+        uint32_t id = tables_->next(state.id, left, bits, shift);
+        next.offset = state.offset + shift;
+        next.id = id;
+        return id != ParametricLevenshteinTables::kDeadState;
+    }
+
+    inline bool isFinal(const State &state) const
+    {
+        return tables_->edits(state.id, pattern_.size() - state.offset) <= tables_->distance();
+    }
+
+    /// the distance of the chars read to the pattern, or distance() + 1 if over it
+    inline size_t distanceOf(const State &state) const
+    {
+        return tables_->edits(state.id, pattern_.size() - state.offset);
+    }
+
+    /// @return the distance of @p str to the pattern, or distance() + 1 if over it
+    template <class StringT>
+    size_t distance(const StringT &str) const
+    {
+        State state = start();
+        for (size_t i = 0; i < (size_t)str.length(); ++i)
+        {
+            if (!next(state, str[i], state)) return tables_->distance() + 1;
+        }
+        return distanceOf(state);
+    }
+
+    template <class StringT>
+    bool match(const StringT &str) const
+    {
+        return distance(str) <= tables_->distance();
+    }
+
+    size_t distance() const
+    {
+        return tables_->distance();
+    }
+
+private:
+    const ParametricLevenshteinTables *tables_;
+    std::vector<CharT> pattern_;
+};
+
+}
+}
+
+#endif // IZENELIB_UTIL_STRING_PARAMETRIC_LEVENSHTEIN_AUTOMATON_H
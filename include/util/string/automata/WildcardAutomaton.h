@@ -0,0 +1,191 @@
+#ifndef IZENELIB_UTIL_STRING_WILDCARD_AUTOMATON_H
+#define IZENELIB_UTIL_STRING_WILDCARD_AUTOMATON_H
+
+#include <types.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace izenelib
+{
+namespace util
+{
+
+/**
+ * The automaton of a wildcard pattern, with
+ *  - '*' for any sequence of chars,
+ *  - '?' for any one char,
+ *  - "[abc]", "[a-z]" or "[^a-z]" for one char in, or not in, a set,
+ *  - '\' to escape the next char.
+ *
+ * It is simulated bit parallel (shift-and): bit j of a state is set when the
+ * first j tokens of the pattern match the chars read, so a state is one
+ * word, and a pattern holds at most 63 tokens.
+ *
+ * The interface is the one LoudsTrie::intersect() walks with.
+ */
+template <class CharT>
+class WildcardAutomaton
+{
+public:
+    typedef uint64_t State;
+
+    static const size_t kMaxTokenNum = 63;
+
+    WildcardAutomaton()
+        : token_num_(), star_mask_(), any_mask_()
+    {
+    }
+
+    /**
+     * @return false if @p pattern is malformed or has more than kMaxTokenNum tokens
+     */
+    template <class StringT>
+    bool compile(const StringT &pattern);
+
+    inline State start() const
+    {
+        return closure_(1);
+    }
+
+    inline bool next(State state, CharT c, State &next) const
+    {
+        next = closure_(((state & match_(c)) << 1) | (state & (star_mask_ << 1)));
+        return next != 0;
+    }
+
+    inline bool isFinal(State state) const
+    {
+        return (state >> token_num_) & 1;
+    }
+
+    size_t tokenNum() const
+    {
+        return token_num_;
+    }
+
+private:
+    /// a char class, matching the tokens of mask
+    struct CharClass
+    {
+        std::vector<std::pair<CharT, CharT> > ranges;
+        bool negated;
+        uint64_t mask;
+
+        bool contains(CharT c) const
+        {
+            bool in = false;
+            for (size_t i = 0; i < ranges.size() && !in; ++i)
+                in = ranges[i].first <= c && c <= ranges[i].second;
+            return in != negated;
+        }
+    };
+
+    /// the tokens whose next char may be c
+    inline uint64_t match_(CharT c) const
+    {
+        uint64_t mask = any_mask_;
+
+        typename std::vector<std::pair<CharT, uint64_t> >::const_iterator it
+            = std::lower_bound(char_masks_.begin(), char_masks_.end(), std::make_pair(c, (uint64_t)0));
+        if (it != char_masks_.end() && it->first == c) mask |= it->second;
+
+        for (size_t i = 0; i < classes_.size(); ++i)
+        {
+            if (classes_[i].contains(c)) mask |= classes_[i].mask;
+        }
+        return mask;
+    }
+
+    /**
+     * passes the '*' tokens, which match nothing this way, and any char by
+     * staying after them; consecutive ones are merged, so one step suffices
+     */
+    inline State closure_(State state) const
+    {
+        return state | ((state & star_mask_) << 1);
+    }
+
+    size_t token_num_;
+    uint64_t star_mask_; ///< the '*' tokens
+    uint64_t any_mask_; ///< the tokens before a '?'
+    std::vector<std::pair<CharT, uint64_t> > char_masks_; ///< sorted by char
+    std::vector<CharClass> classes_;
+};
+
+template <class CharT>
+template <class StringT>
+bool WildcardAutomaton<CharT>::compile(const StringT &pattern)
+{
+    token_num_ = 0;
+    star_mask_ = any_mask_ = 0;
+    char_masks_.clear();
+    classes_.clear();
+
+    size_t len = pattern.length();
+    for (size_t i = 0; i < len; ++i)
+    {
+        CharT c = pattern[i];
+        if (c == '*' && token_num_ > 0 && ((star_mask_ >> (token_num_ - 1)) & 1))
+            continue;
+
+        if (token_num_ >= kMaxTokenNum) return false;
+        uint64_t bit = 1ULL << token_num_;
+        ++token_num_;
+
+        if (c == '*')
+        {
+            star_mask_ |= bit;
+        }
+        else if (c == '?')
+        {
+            any_mask_ |= bit;
+        }
+        else if (c == '[')
+        {
+            CharClass char_class;
+            char_class.mask = bit;
+            char_class.negated = i + 1 < len && pattern[i + 1] == '^';
+
+            // a ']' first in the class is one of its chars
+            size_t begin = char_class.negated ? i + 2 : i + 1;
+            size_t j = begin;
+            for (; j < len && (pattern[j] != ']' || j == begin); ++j)
+            {
+                CharT low = pattern[j];
+                if (low == '\\' && j + 1 < len) low = pattern[++j];
+
+                CharT high = low;
+                if (j + 2 < len && pattern[j + 1] == '-' && pattern[j + 2] != ']')
+                {
+                    j += 2;
+                    high = pattern[j];
+                    if (high == '\\' && j + 1 < len) high = pattern[++j];
+                }
+                char_class.ranges.push_back(std::make_pair(low, high));
+            }
+            if (j >= len) return false;
+
+            classes_.push_back(char_class);
+            i = j;
+        }
+        else
+        {
+            if (c == '\\' && i + 1 < len) c = pattern[++i];
+
+            typename std::vector<std::pair<CharT, uint64_t> >::iterator it
+                = std::lower_bound(char_masks_.begin(), char_masks_.end(), std::make_pair(c, (uint64_t)0));
+            if (it != char_masks_.end() && it->first == c)
+                it->second |= bit;
+            else
+                char_masks_.insert(it, std::make_pair(c, bit));
+        }
+    }
+    return true;
+}
+
+}
+}
+
+#endif // IZENELIB_UTIL_STRING_WILDCARD_AUTOMATON_H
@@ -0,0 +1,308 @@
+#ifndef UTIL_TASK_POOL_H
+#define UTIL_TASK_POOL_H
+/**
+ * @file util/task_pool.h
+ * @brief A pool of threads running tasks by work stealing.
+ *
+ * Each worker has its own deque, the deque of "Dynamic Circular
+ * Work-Stealing Deque" (Chase and Lev): the tasks submitted by a task are
+ * pushed to and taken from the bottom of the deque of its worker, without
+ * contention, and an idle worker steals the oldest task from the top of the
+ * deque of another one. The tasks submitted by the other threads go to an
+ * mpmc_queue, taken by any worker in their order, so a pool of one thread
+ * runs them in order. The idle workers sleep until a task is submitted.
+ *
+ * usage:
+ * @code
+ * task_pool pool(4);
+ * task_future<int> f = pool.submit(boost::bind(count, begin, end));
+ * pool.post(boost::bind(&Index::flush, &index));
+ * int n = f.get(); // rethrows the exception of count(), if any
+ * pool.wait();     // all the tasks submitted are run
+ * @endcode
+ *
+ * A task waiting for the future of another one runs the pending tasks of
+ * the pool meanwhile, so the tasks may wait for the tasks they submit.
+ */
+
+#include <boost/atomic.hpp>
+#include <boost/exception_ptr.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+#include <boost/utility/result_of.hpp>
+
+#include <util/mpmc_queue.h>
+
+#include <vector>
+
+namespace izenelib {
+namespace util {
+
+class task_pool;
+
+namespace detail {
+
+class task_state_base : private boost::noncopyable
+{
+public:
+    explicit task_state_base(task_pool* pool) : pool_(pool), ready_(false) {}
+
+    bool is_ready() const
+    {
+        return ready_.load(boost::memory_order_acquire);
+    }
+
+    void wait();
+
+    void set_exception(const boost::exception_ptr& e)
+    {
+        error_ = e;
+        set_ready();
+    }
+
+protected:
+    void set_ready()
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        ready_.store(true, boost::memory_order_release);
+        cond_.notify_all();
+    }
+
+    void rethrow() const
+    {
+        if (error_)
+            boost::rethrow_exception(error_);
+    }
+
+private:
+    task_pool* pool_;
+    boost::atomic<bool> ready_;
+    boost::exception_ptr error_;
+    boost::mutex mutex_;
+    boost::condition_variable cond_;
+};
+
+template<typename R>
+class task_state : public task_state_base
+{
+public:
+    typedef const R& get_type;
+
+    explicit task_state(task_pool* pool) : task_state_base(pool) {}
+
+    template<typename F>
+    void run(F& f)
+    {
+        value_ = f();
+        set_ready();
+    }
+
+    const R& get()
+    {
+        wait();
+        rethrow();
+        return *value_;
+    }
+
+private:
+    boost::optional<R> value_;
+};
+
+template<>
+class task_state<void> : public task_state_base
+{
+public:
+    typedef void get_type;
+
+    explicit task_state(task_pool* pool) : task_state_base(pool) {}
+
+    template<typename F>
+    void run(F& f)
+    {
+        f();
+        set_ready();
+    }
+
+    void get()
+    {
+        wait();
+        rethrow();
+    }
+};
+
+template<typename R, typename F>
+struct task_runner
+{
+    task_runner(const boost::shared_ptr<task_state<R> >& s, const F& func)
+        : state(s), f(func)
+    {
+    }
+
+    void operator()()
+    {
+        try
+        {
+            state->run(f);
+        }
+        catch (...)
+        {
+            state->set_exception(boost::current_exception());
+        }
+    }
+
+    boost::shared_ptr<task_state<R> > state;
+    F f;
+};
+
+} // namespace detail
+
+/**
+ * @brief the result of a task submitted to a task_pool, copies share it
+ */
+template<typename R>
+class task_future
+{
+public:
+    task_future() {}
+
+    explicit task_future(const boost::shared_ptr<detail::task_state<R> >& state)
+        : state_(state)
+    {
+    }
+
+    bool valid() const
+    {
+        return state_.get() != NULL;
+    }
+
+    bool is_ready() const
+    {
+        return state_->is_ready();
+    }
+
+    /**
+     * @brief waits until the task is run, in a worker running other tasks
+     */
+    void wait() const
+    {
+        state_->wait();
+    }
+
+    /**
+     * @brief waits for the result of the task, rethrows its exception
+     */
+    typename detail::task_state<R>::get_type get() const
+    {
+        return state_->get();
+    }
+
+private:
+    boost::shared_ptr<detail::task_state<R> > state_;
+};
+
+class task_pool : private boost::noncopyable
+{
+public:
+    typedef boost::function<void()> task_type;
+
+    /**
+     * @param thread_num the number of the workers, the number of cores if 0
+     * @param queue_capacity the capacity of the queue of the tasks submitted
+     * by the other threads, those submitting to a full queue wait
+     */
+    explicit task_pool(std::size_t thread_num = 0, std::size_t queue_capacity = 4096);
+
+    /**
+     * @brief runs the tasks submitted, then stops the workers
+     */
+    ~task_pool();
+
+    /**
+     * @brief submits f, a function or a function object of no argument
+     * @return the future of its result
+     */
+    template<typename F>
+    task_future<typename boost::result_of<F()>::type> submit(const F& f)
+    {
+        typedef typename boost::result_of<F()>::type result_type;
+        boost::shared_ptr<detail::task_state<result_type> > state(
+            new detail::task_state<result_type>(this));
+        push(new task_type(detail::task_runner<result_type, F>(state, f)));
+        return task_future<result_type>(state);
+    }
+
+    /**
+     * @brief submits task, without a future, its exception is ignored
+     */
+    void post(const task_type& task)
+    {
+        push(new task_type(task));
+    }
+
+    /**
+     * @brief waits until all the tasks submitted are run, not to be called
+     * by a task, which would wait for itself; wait for its futures instead
+     */
+    void wait();
+
+    /**
+     * @brief runs one pending task in the calling thread
+     * @return false if no task was pending
+     */
+    bool run_one();
+
+    /**
+     * @return whether the calling thread is a worker of the pool
+     */
+    bool in_worker() const
+    {
+        return current_worker_.get() != NULL;
+    }
+
+    std::size_t thread_num() const
+    {
+        return workers_.size();
+    }
+
+    /**
+     * @return the number of the tasks submitted and not run yet
+     */
+    std::size_t pending() const
+    {
+        return pending_.load(boost::memory_order_acquire);
+    }
+
+private:
+    struct worker;
+
+    static void no_cleanup(worker*) {}
+
+    void push(task_type* task);
+    task_type* next_task(worker* self);
+    bool has_task() const;
+    void run(task_type* task);
+    void worker_loop(worker* self);
+
+private:
+    std::vector<worker*> workers_;
+    boost::thread_group threads_;
+    boost::thread_specific_ptr<worker> current_worker_;
+    mpmc_queue<task_type*> queue_;
+
+    boost::atomic<std::size_t> pending_;
+    boost::atomic<int> sleeping_;
+    boost::atomic<bool> stop_;
+    boost::mutex mutex_;
+    boost::condition_variable work_cond_;
+    boost::condition_variable done_cond_;
+};
+
+}} // namespace izenelib::util
+
+#endif // UTIL_TASK_POOL_H
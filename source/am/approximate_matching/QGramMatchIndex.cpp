@@ -0,0 +1,451 @@
+#include <am/approximate_matching/QGramMatchIndex.h>
+#include <util/string/MyersEditDistance.h>
+
+#include <boost/bind.hpp>
+#include <boost/threadpool.hpp>
+
+#include <algorithm>
+
+using namespace std;
+using namespace izenelib::util;
+
+namespace izenelib
+{
+namespace am
+{
+
+namespace
+{
+
+void WriteVarint(vector<uint8_t>& bytes, uint32_t value)
+{
+    for (; value >= 0x80; value >>= 7)
+        bytes.push_back((uint8_t)(value | 0x80));
+    bytes.push_back((uint8_t)value);
+}
+
+inline uint32_t ReadVarint(const uint8_t*& p)
+{
+    uint32_t value = *p++;
+    if (value < 0x80) return value;
+
+    value &= 0x7f;
+    for (uint32_t shift = 7; ; shift += 7)
+    {
+        uint32_t c = *p++;
+        value |= (c & 0x7f) << shift;
+        if (c < 0x80) return value;
+    }
+}
+
+template <class T>
+void WriteVector(ostream& ofs, const vector<T>& vec)
+{
+    size_t size = vec.size();
+    ofs.write((const char*)&size, sizeof(size));
+    if (size) ofs.write((const char*)&vec[0], sizeof(T) * size);
+}
+
+template <class T>
+void ReadVector(istream& ifs, vector<T>& vec)
+{
+    size_t size = 0;
+    ifs.read((char*)&size, sizeof(size));
+    vec.resize(size);
+    if (size) ifs.read((char*)&vec[0], sizeof(T) * size);
+}
+
+/// a list being counted
+struct GramList
+{
+    const uint8_t* bytes;
+    uint32_t size;
+
+    bool operator<(const GramList& other) const
+    {
+        return size < other.size;
+    }
+};
+
+}
+
+/// the buffers of a thread
+struct QGramMatchIndex::Scratch
+{
+    vector<uint32_t> counts; ///< by id, zero between the queries
+    vector<uint32_t> touched;
+    vector<uint64_t> grams;
+    vector<GramList> lists;
+    vector<uint32_t> candidates;
+    MyersEditDistance<CharT> verifier;
+};
+
+struct QGramMatchIndex::Pool
+{
+    explicit Pool(size_t threadNum)
+        : pool(threadNum)
+    {
+    }
+
+    boost::threadpool::pool pool;
+};
+
+const uint32_t QGramMatchIndex::MaxQ;
+
+QGramMatchIndex::QGramMatchIndex(uint32_t q)
+    : q_(std::max(1U, std::min(q, MaxQ)))
+    , build_(false)
+{
+}
+
+QGramMatchIndex::~QGramMatchIndex()
+{
+}
+
+uint32_t QGramMatchIndex::Add(const UString& text)
+{
+    texts_.push_back(text);
+    build_ = false;
+    return texts_.size() - 1;
+}
+
+void QGramMatchIndex::Add(const vector<UString>& textVec)
+{
+    for (size_t i = 0; i < textVec.size(); i++)
+        Add(textVec[i]);
+}
+
+void QGramMatchIndex::GramLists::clear()
+{
+    grams.clear();
+    sizes.clear();
+    offsets.clear();
+    bytes.clear();
+}
+
+void QGramMatchIndex::Grams(const UString& text, uint32_t q, vector<uint64_t>& grams)
+{
+    grams.clear();
+    size_t length = text.length();
+    if (length < q) return;
+
+    uint64_t gram = 0;
+    uint64_t mask = q == 4 ? ~0ULL : (1ULL << (16 * q)) - 1;
+    for (size_t i = 0; i < length; i++)
+    {
+        gram = ((gram << 16) | (uint16_t)text[i]) & mask;
+        if (i + 1 >= q) grams.push_back(gram);
+    }
+    sort(grams.begin(), grams.end());
+    grams.erase(unique(grams.begin(), grams.end()), grams.end());
+}
+
+void QGramMatchIndex::BuildLists(uint32_t q, GramLists& lists) const
+{
+    vector<pair<uint64_t, uint32_t> > postings;
+    vector<uint64_t> grams;
+    for (size_t id = 0; id < texts_.size(); id++)
+    {
+        Grams(texts_[id], q, grams);
+        for (size_t i = 0; i < grams.size(); i++)
+            postings.push_back(make_pair(grams[i], (uint32_t)id));
+    }
+    sort(postings.begin(), postings.end());
+
+    lists.clear();
+    for (size_t i = 0; i < postings.size(); )
+    {
+        uint64_t gram = postings[i].first;
+        lists.grams.push_back(gram);
+        lists.offsets.push_back(lists.bytes.size());
+
+        uint32_t last = 0;
+        size_t begin = i;
+        for (; i < postings.size() && postings[i].first == gram; i++)
+        {
+            WriteVarint(lists.bytes, postings[i].second - last);
+            last = postings[i].second;
+        }
+        lists.sizes.push_back(i - begin);
+    }
+    lists.offsets.push_back(lists.bytes.size());
+}
+
+void QGramMatchIndex::BuildIndex()
+{
+    BuildLists(q_, qgramLists_);
+    if (q_ > 1)
+        BuildLists(1, charLists_);
+    else
+        charLists_.clear();
+
+    size_t maxLength = 0;
+    for (size_t id = 0; id < texts_.size(); id++)
+        maxLength = std::max(maxLength, (size_t)texts_[id].length());
+
+    // the ids by length, stable so they stay sorted within a length
+    lengthOffsets_.assign(maxLength + 2, 0);
+    for (size_t id = 0; id < texts_.size(); id++)
+        lengthOffsets_[texts_[id].length() + 1]++;
+    for (size_t len = 1; len < lengthOffsets_.size(); len++)
+        lengthOffsets_[len] += lengthOffsets_[len - 1];
+    lengthIds_.resize(texts_.size());
+    vector<uint32_t> next(lengthOffsets_.begin(), lengthOffsets_.end() - 1);
+    for (size_t id = 0; id < texts_.size(); id++)
+        lengthIds_[next[texts_[id].length()]++] = id;
+
+    build_ = true;
+}
+
+bool QGramMatchIndex::Hasbuild() const
+{
+    return build_;
+}
+
+void QGramMatchIndex::FindList(const GramLists& lists, uint64_t gram, const uint8_t*& list, uint32_t& size)
+{
+    vector<uint64_t>::const_iterator it = lower_bound(lists.grams.begin(), lists.grams.end(), gram);
+    if (it == lists.grams.end() || *it != gram)
+    {
+        list = NULL;
+        size = 0;
+        return;
+    }
+    size_t index = it - lists.grams.begin();
+    list = &lists.bytes[0] + lists.offsets[index];
+    size = lists.sizes[index];
+}
+
+QGramMatchIndex::Scratch& QGramMatchIndex::GetScratch() const
+{
+    Scratch* scratch = scratch_.get();
+    if (!scratch)
+    {
+        scratch = new Scratch;
+        scratch_.reset(scratch);
+    }
+    if (scratch->counts.size() < texts_.size())
+        scratch->counts.resize(texts_.size());
+    return *scratch;
+}
+
+void QGramMatchIndex::CountLists(const GramLists& lists, size_t threshold, Scratch& scratch) const
+{
+    scratch.lists.resize(scratch.grams.size());
+    for (size_t i = 0; i < scratch.grams.size(); i++)
+        FindList(lists, scratch.grams[i], scratch.lists[i].bytes, scratch.lists[i].size);
+    sort(scratch.lists.begin(), scratch.lists.end());
+
+    // a text reaching the threshold is in one of the shortest lists but threshold - 1
+    size_t prefix = scratch.lists.size() - threshold + 1;
+    vector<uint32_t>& counts = scratch.counts;
+    vector<uint32_t>& touched = scratch.touched;
+    touched.clear();
+    for (size_t i = 0; i < scratch.lists.size(); i++)
+    {
+        const uint8_t* p = scratch.lists[i].bytes;
+        uint32_t id = 0;
+        for (uint32_t j = 0; j < scratch.lists[i].size; j++)
+        {
+            id += ReadVarint(p);
+            if (counts[id])
+            {
+                counts[id]++;
+            }
+            else if (i < prefix)
+            {
+                counts[id] = 1;
+                touched.push_back(id);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < touched.size(); i++)
+    {
+        uint32_t id = touched[i];
+        if (counts[id] >= threshold)
+            scratch.candidates.push_back(id);
+        counts[id] = 0;
+    }
+}
+
+void QGramMatchIndex::MatchIds(const UString& query, int maxError, vector<uint32_t>& ids) const
+{
+    if (!build_ || maxError < 0) return;
+
+    Scratch& scratch = GetScratch();
+    size_t k = maxError;
+    size_t length = query.length();
+    size_t minLength = length > k ? length - k : 0;
+    size_t maxLength = std::min(length + k, lengthOffsets_.size() - 2);
+    scratch.candidates.clear();
+
+    // an edit breaks at most q grams, and at most one char
+    Grams(query, q_, scratch.grams);
+    const GramLists* lists = &qgramLists_;
+    int threshold = (int)scratch.grams.size() - (int)(k * q_);
+    if (threshold <= 0 && q_ > 1)
+    {
+        Grams(query, 1, scratch.grams);
+        lists = &charLists_;
+        threshold = (int)scratch.grams.size() - (int)k;
+    }
+
+    if (threshold > 0)
+    {
+        CountLists(*lists, threshold, scratch);
+
+        size_t count = 0;
+        for (size_t i = 0; i < scratch.candidates.size(); i++)
+        {
+            size_t textLength = texts_[scratch.candidates[i]].length();
+            if (minLength <= textLength && textLength <= maxLength)
+                scratch.candidates[count++] = scratch.candidates[i];
+        }
+        scratch.candidates.resize(count);
+    }
+    else if (minLength <= maxLength)
+    {
+        // no count to filter by, the texts of the close lengths
+        scratch.candidates.assign(lengthIds_.begin() + lengthOffsets_[minLength],
+                lengthIds_.begin() + lengthOffsets_[maxLength + 1]);
+    }
+    sort(scratch.candidates.begin(), scratch.candidates.end());
+    Verify(query, k, scratch.candidates, scratch, ids);
+}
+
+void QGramMatchIndex::Verify(const UString& query, size_t maxError, const vector<uint32_t>& candidates,
+        Scratch& scratch, vector<uint32_t>& ids) const
+{
+    if (candidates.empty()) return;
+
+    scratch.verifier.compile(query);
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        if (scratch.verifier.distance(texts_[candidates[i]], maxError) <= maxError)
+            ids.push_back(candidates[i]);
+    }
+}
+
+void QGramMatchIndex::Match(const UString& query, int maxError, vector<UString>& ret) const
+{
+    vector<uint32_t> ids;
+    MatchIds(query, maxError, ids);
+    for (size_t i = 0; i < ids.size(); i++)
+        ret.push_back(texts_[ids[i]]);
+}
+
+void QGramMatchIndex::SetThreadNum(size_t threadNum)
+{
+    pool_.reset();
+    if (threadNum > 0) pool_.reset(new Pool(threadNum));
+}
+
+void QGramMatchIndex::MatchRange(const vector<UString>* queries, int maxError,
+        vector<vector<UString> >* ret, size_t begin, size_t end) const
+{
+    for (size_t i = begin; i < end; i++)
+        Match((*queries)[i], maxError, (*ret)[i]);
+}
+
+void QGramMatchIndex::BatchMatch(const vector<UString>& queries, int maxError,
+        vector<vector<UString> >& ret) const
+{
+    ret.resize(queries.size());
+    if (!pool_)
+    {
+        MatchRange(&queries, maxError, &ret, 0, queries.size());
+        return;
+    }
+
+    // small tasks, so the threads finish together
+    const size_t TaskSize = 16;
+    for (size_t begin = 0; begin < queries.size(); begin += TaskSize)
+    {
+        size_t end = std::min(begin + TaskSize, queries.size());
+        pool_->pool.schedule(boost::bind(&QGramMatchIndex::MatchRange, this, &queries, maxError, &ret, begin, end));
+    }
+    pool_->pool.wait();
+}
+
+const QGramMatchIndex::UString& QGramMatchIndex::GetText(uint32_t id) const
+{
+    return texts_[id];
+}
+
+size_t QGramMatchIndex::TextSize() const
+{
+    return texts_.size();
+}
+
+void QGramMatchIndex::Save(ostream& ofs) const
+{
+    ofs.write((const char*)&q_, sizeof(q_));
+    size_t size = texts_.size();
+    ofs.write((const char*)&size, sizeof(size));
+    for (size_t i = 0; i < texts_.size(); i++)
+    {
+        size_t len = texts_[i].length();
+        ofs.write((const char*)&len, sizeof(len));
+        if (len) ofs.write((const char*)&texts_[i][0], sizeof(CharT) * len);
+    }
+
+    const GramLists* lists[] = {&qgramLists_, &charLists_};
+    for (size_t i = 0; i < 2; i++)
+    {
+        WriteVector(ofs, lists[i]->grams);
+        WriteVector(ofs, lists[i]->sizes);
+        WriteVector(ofs, lists[i]->offsets);
+        WriteVector(ofs, lists[i]->bytes);
+    }
+    WriteVector(ofs, lengthIds_);
+    WriteVector(ofs, lengthOffsets_);
+}
+
+void QGramMatchIndex::Load(istream& ifs)
+{
+    Clear();
+    ifs.read((char*)&q_, sizeof(q_));
+    size_t size = 0;
+    ifs.read((char*)&size, sizeof(size));
+    texts_.resize(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        size_t len = 0;
+        ifs.read((char*)&len, sizeof(len));
+        texts_[i].resize(len);
+        if (len) ifs.read((char*)&texts_[i][0], sizeof(CharT) * len);
+    }
+
+    GramLists* lists[] = {&qgramLists_, &charLists_};
+    for (size_t i = 0; i < 2; i++)
+    {
+        ReadVector(ifs, lists[i]->grams);
+        ReadVector(ifs, lists[i]->sizes);
+        ReadVector(ifs, lists[i]->offsets);
+        ReadVector(ifs, lists[i]->bytes);
+    }
+    ReadVector(ifs, lengthIds_);
+    ReadVector(ifs, lengthOffsets_);
+    build_ = true;
+}
+
+void QGramMatchIndex::Clear()
+{
+    texts_.clear();
+    qgramLists_.clear();
+    charLists_.clear();
+    lengthIds_.clear();
+    lengthOffsets_.clear();
+    build_ = false;
+}
+
+void QGramMatchIndex::Show() const
+{
+    cout << "texts " << texts_.size() << endl;
+    cout << "grams " << qgramLists_.grams.size() << endl;
+    cout << "list bytes " << qgramLists_.bytes.size() + charLists_.bytes.size() << endl;
+}
+
+}
+}
@@ -1,5 +1,10 @@
 #include <am/bitmap/RoaringBitmap.h>
 #include <am/bitmap/RoaringChunk.h>
+#include <am/bitmap/RoaringBitmapView.h>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
 
 NS_IZENELIB_AM_BEGIN
 
@@ -61,7 +66,7 @@ void RoaringBitmap::extendArray(uint32_t k)
         newCapacity = std::min(newCapacity, 65536U);
 
         array_type newContainer(new chunk_type[newCapacity]);
-        std::copy(&array_[0], &array_[capacity_], &newContainer[0]);
+        if (capacity_) std::copy(&array_[0], &array_[capacity_], &newContainer[0]);
 
         while (flag_.test_and_set());
         array_.swap(newContainer);
@@ -101,18 +106,130 @@ void RoaringBitmap::add(uint32_t x)
     uint32_t hb = x >> 16;
     uint32_t lb = x & 0xffff;
 
-    if (array_[size_].getKey() == hb)
+    if (size_ && array_[size_ - 1].getKey() == hb)
     {
-        array_[size_].add(lb);
+        array_[size_ - 1].add(lb);
     }
     else
     {
-        if (size_) array_[size_].trim();
+        if (size_) array_[size_ - 1].trim();
 
         extendArray(1);
         array_[size_++].init(hb, lb);
-        ++cardinality_;
     }
+    ++cardinality_;
+}
+
+void RoaringBitmap::addMany(const uint32_t* begin, const uint32_t* end)
+{
+    while (begin != end)
+    {
+        uint32_t hb = *begin >> 16;
+        const uint32_t* group_end = hb == 0xffff ? end
+            : std::lower_bound(begin, end, (hb + 1) << 16);
+
+        if (size_ && array_[size_ - 1].getKey() == hb)
+        {
+            for (const uint32_t* it = begin; it != group_end; ++it)
+                array_[size_ - 1].add(*it & 0xffff);
+        }
+        else
+        {
+            if (size_) array_[size_ - 1].trim();
+
+            // the whole chunk is built at once instead of growing one by one
+            extendArray(1);
+            array_[size_++].init(hb, begin, group_end);
+        }
+
+        cardinality_ += group_end - begin;
+        begin = group_end;
+    }
+}
+
+bool RoaringBitmap::runOptimize()
+{
+    bool changed = false;
+    for (uint32_t i = 0; i < size_; ++i)
+    {
+        changed |= array_[i].runOptimize();
+    }
+    return changed;
+}
+
+void RoaringBitmap::toArray(std::vector<uint32_t>& values) const
+{
+    array_type tmp_array = getArray();
+    uint32_t tmp_size = size_;
+
+    values.reserve(values.size() + cardinality_);
+    for (uint32_t i = 0; i < tmp_size; ++i)
+    {
+        tmp_array[i].toArray(values);
+    }
+}
+
+size_t RoaringBitmap::serializedSizeInBytes() const
+{
+    size_t size = ROARING_SERIAL_PREFIX + size_ * sizeof(RoaringSerialHeader);
+    for (uint32_t i = 0; i < size_; ++i)
+    {
+        size = (size + 7) & ~size_t(7);
+        size += array_[i].serializedSizeInBytes();
+    }
+    return size;
+}
+
+size_t RoaringBitmap::serialize(char* buf) const
+{
+    array_type tmp_array = getArray();
+    uint32_t tmp_size = size_;
+    uint64_t cardinality = cardinality_;
+
+    memcpy(buf, &ROARING_SERIAL_COOKIE, 4);
+    memcpy(buf + 4, &tmp_size, 4);
+    memcpy(buf + 8, &cardinality, 8);
+
+    RoaringSerialHeader* headers = reinterpret_cast<RoaringSerialHeader*>(buf + ROARING_SERIAL_PREFIX);
+    size_t pos = ROARING_SERIAL_PREFIX + tmp_size * sizeof(RoaringSerialHeader);
+
+    for (uint32_t i = 0; i < tmp_size; ++i)
+    {
+        size_t aligned = (pos + 7) & ~size_t(7);
+        memset(buf + pos, 0, aligned - pos);
+        pos = aligned;
+
+        RoaringSerialHeader& header = headers[i];
+        header.key = tmp_array[i].getKey();
+        header.type = tmp_array[i].getType();
+        header.cardinality = tmp_array[i].getCardinality();
+        header.offset = pos;
+        header.size = tmp_array[i].serialize(buf + pos);
+        pos += header.size;
+    }
+
+    return pos;
+}
+
+bool RoaringBitmap::deserialize(const char* buf, size_t size)
+{
+    RoaringBitmapView view;
+    if (!view.init(buf, size)) return false;
+
+    RoaringBitmap answer(updatable_);
+    answer.extendArray(view.getChunkNum());
+    for (uint32_t i = 0; i < view.getChunkNum(); ++i)
+    {
+        const RoaringSerialHeader& header = view.getHeader(i);
+        if (!answer.array_[i].deserialize(header.key, header.type, header.cardinality,
+                view.getPayload(i), header.size))
+            return false;
+    }
+    answer.size_ = view.getChunkNum();
+    answer.cardinality_ = view.getCardinality();
+
+    swap(answer);
+    return true;
 }
 
 bool RoaringBitmap::contains(uint32_t x) const
@@ -130,19 +247,17 @@ bool RoaringBitmap::contains(uint32_t x) const
 
     uint32_t begin = 0;
     uint32_t end = tmp_size - 1;
-    uint32_t key = -1;
 
-    while (begin < end && key != x)
+    while (begin < end)
     {
         uint32_t middle = (begin + end) / 2;
-        key = tmp_array[middle].getKey();
+        uint32_t key = tmp_array[middle].getKey();
 
-        asm("cmpl %3, %2\n\tcmovg %4, %0\n\tcmovle %5, %1"
-                : "+r" (begin), "+r" (end)
-                : "r" (x), "g" (key), "g" (middle + 1), "g" (middle));
+        if (key < hb) begin = middle + 1;
+        else end = middle;
     }
 
-    return key == x && tmp_array[end].contains(x & 0xffff);
+    return tmp_array[end].getKey() == hb && tmp_array[end].contains(lb);
 }
 
 RoaringBitmap RoaringBitmap::operator&(const RoaringBitmap& b) const
@@ -373,6 +488,158 @@ RoaringBitmap RoaringBitmap::operator-(const RoaringBitmap& b) const
     return answer;
 }
 
+namespace
+{
+
+bool lessCardinality(const RoaringBitmap* a, const RoaringBitmap* b)
+{
+    return a->getCardinality() < b->getCardinality();
+}
+
+bool lessChunkCardinality(const RoaringChunk* a, const RoaringChunk* b)
+{
+    return a->getCardinality() < b->getCardinality();
+}
+
+}
+
+RoaringBitmap RoaringBitmap::fastOr(const std::vector<const RoaringBitmap*>& bitmaps)
+{
+    RoaringBitmap answer(false);
+
+    uint32_t num = bitmaps.size();
+    std::vector<array_type> arrays(num);
+    std::vector<uint32_t> sizes(num), positions(num, 0);
+
+    // (next chunk key, bitmap index), smallest key on top
+    typedef std::pair<uint32_t, uint32_t> entry_type;
+    std::priority_queue<entry_type, std::vector<entry_type>, std::greater<entry_type> > heap;
+
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        sizes[i] = bitmaps[i]->size_;
+        arrays[i] = bitmaps[i]->getArray();
+        if (sizes[i]) heap.push(entry_type(arrays[i][0].getKey(), i));
+    }
+
+    std::vector<uint64_t> words(BITMAP_SIZE);
+    std::vector<uint32_t> group;
+
+    while (!heap.empty())
+    {
+        uint32_t key = heap.top().first;
+
+        group.clear();
+        while (!heap.empty() && heap.top().first == key)
+        {
+            group.push_back(heap.top().second);
+            heap.pop();
+        }
+
+        if (group.size() == 1)
+        {
+            answer.appendCopy(arrays[group[0]], positions[group[0]]);
+        }
+        else if (group.size() == 2)
+        {
+            answer.append(arrays[group[0]][positions[group[0]]] | arrays[group[1]][positions[group[1]]]);
+        }
+        else
+        {
+            // the cardinality is only counted once, after all chunks are ored
+            int full = -1;
+            memset(&words[0], 0, MAX_CHUNK_CAPACITY / 8);
+            for (uint32_t i = 0; i < group.size(); ++i)
+            {
+                const chunk_type& chunk = arrays[group[i]][positions[group[i]]];
+                if (chunk.getCardinality() == MAX_CHUNK_CAPACITY)
+                {
+                    full = group[i];
+                    break;
+                }
+                chunk.lazyOr(&words[0]);
+            }
+
+            if (full >= 0)
+            {
+                answer.appendCopy(arrays[full], positions[full]);
+            }
+            else
+            {
+                chunk_type chunk;
+                chunk.initBitmap(key, &words[0]);
+                answer.append(chunk);
+            }
+        }
+
+        for (uint32_t i = 0; i < group.size(); ++i)
+        {
+            uint32_t k = group[i];
+            if (++positions[k] < sizes[k])
+                heap.push(entry_type(arrays[k][positions[k]].getKey(), k));
+        }
+    }
+
+    return answer;
+}
+
+RoaringBitmap RoaringBitmap::fastAnd(const std::vector<const RoaringBitmap*>& bitmaps)
+{
+    RoaringBitmap answer(false);
+    if (bitmaps.empty()) return answer;
+
+    std::vector<const RoaringBitmap*> sorted(bitmaps);
+    std::sort(sorted.begin(), sorted.end(), lessCardinality);
+    if (sorted[0]->getCardinality() == 0) return answer;
+    if (sorted.size() == 1) return *sorted[0];
+
+    uint32_t num = sorted.size();
+    std::vector<array_type> arrays(num);
+    std::vector<uint32_t> sizes(num), positions(num, 0);
+
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        sizes[i] = sorted[i]->size_;
+        arrays[i] = sorted[i]->getArray();
+    }
+
+    std::vector<const chunk_type*> group(num);
+
+    // only the keys of the smallest bitmap can be in the answer
+    for (uint32_t pos = 0; pos < sizes[0]; ++pos)
+    {
+        uint32_t key = arrays[0][pos].getKey();
+        group[0] = &arrays[0][pos];
+
+        bool found = true;
+        for (uint32_t i = 1; i < num; ++i)
+        {
+            uint32_t& p = positions[i];
+            while (p < sizes[i] && arrays[i][p].getKey() < key) ++p;
+            if (p == sizes[i])
+                return answer;
+            if (arrays[i][p].getKey() != key)
+            {
+                found = false;
+                break;
+            }
+            group[i] = &arrays[i][p];
+        }
+        if (!found) continue;
+
+        std::sort(group.begin(), group.end(), lessChunkCardinality);
+
+        chunk_type chunk = *group[0] & *group[1];
+        for (uint32_t i = 2; i < num && chunk.getCardinality(); ++i)
+        {
+            chunk = chunk & *group[i];
+        }
+        answer.append(chunk);
+    }
+
+    return answer;
+}
+
 void RoaringBitmap::swap(RoaringBitmap& b)
 {
     std::swap(capacity_, b.capacity_);
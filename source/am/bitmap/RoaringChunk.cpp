@@ -1,9 +1,215 @@
 #include <am/bitmap/RoaringChunk.h>
 
 #include <immintrin.h>
+#include <algorithm>
 
 NS_IZENELIB_AM_BEGIN
 
+namespace
+{
+
+/// unsigned 16 bits less-than, SSE2 only has the signed one
+inline __m128i cmplt_epu16(__m128i a, __m128i b)
+{
+    const __m128i bias = _mm_set1_epi16((short)0x8000);
+    return _mm_cmplt_epi16(_mm_xor_si128(a, bias), _mm_xor_si128(b, bias));
+}
+
+inline uint32_t popcount64(uint64_t x)
+{
+    return __builtin_popcountll(x);
+}
+
+/// intersection of two sorted uint16 arrays, returns the size of out
+uint32_t intersect_uint16(const uint16_t* a, uint32_t a_size, const uint16_t* b, uint32_t b_size, uint16_t* out)
+{
+    if (a_size > b_size)
+    {
+        std::swap(a, b);
+        std::swap(a_size, b_size);
+    }
+
+    uint32_t pos = 0;
+
+    // galloping when the sizes are skewed
+    if (a_size * 64 < b_size)
+    {
+        const uint16_t* b_pos = b;
+        const uint16_t* b_end = b + b_size;
+        for (uint32_t i = 0; i < a_size && b_pos != b_end; ++i)
+        {
+            b_pos = std::lower_bound(b_pos, b_end, a[i]);
+            if (b_pos != b_end && *b_pos == a[i])
+                out[pos++] = a[i];
+        }
+        return pos;
+    }
+
+    uint32_t a_pos = 0, b_pos = 0;
+
+#ifdef __SSE4_2__
+    const int mode = _SIDD_UWORD_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK;
+    const uint32_t a_stop = a_size & ~7U, b_stop = b_size & ~7U;
+
+    while (a_pos < a_stop && b_pos < b_stop)
+    {
+        __m128i a_v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + a_pos));
+        __m128i b_v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + b_pos));
+        uint32_t mask = _mm_extract_epi32(_mm_cmpestrm(b_v, 8, a_v, 8, mode), 0);
+
+        while (mask)
+        {
+            out[pos++] = a[a_pos + __builtin_ctz(mask)];
+            mask &= mask - 1;
+        }
+
+        uint16_t a_max = a[a_pos + 7], b_max = b[b_pos + 7];
+        if (a_max <= b_max) a_pos += 8;
+        if (b_max <= a_max) b_pos += 8;
+    }
+#endif
+
+    while (a_pos < a_size && b_pos < b_size)
+    {
+        if (a[a_pos] < b[b_pos]) ++a_pos;
+        else if (a[a_pos] > b[b_pos]) ++b_pos;
+        else
+        {
+            out[pos++] = a[a_pos];
+            ++a_pos;
+            ++b_pos;
+        }
+    }
+
+    return pos;
+}
+
+struct AndOp
+{
+    static uint64_t op(uint64_t a, uint64_t b) { return a & b; }
+#ifdef __AVX2__
+    static __m256i op(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+#endif
+};
+
+struct OrOp
+{
+    static uint64_t op(uint64_t a, uint64_t b) { return a | b; }
+#ifdef __AVX2__
+    static __m256i op(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+#endif
+};
+
+struct XorOp
+{
+    static uint64_t op(uint64_t a, uint64_t b) { return a ^ b; }
+#ifdef __AVX2__
+    static __m256i op(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+#endif
+};
+
+struct AndNotOp
+{
+    static uint64_t op(uint64_t a, uint64_t b) { return a & ~b; }
+#ifdef __AVX2__
+    static __m256i op(__m256i a, __m256i b) { return _mm256_andnot_si256(b, a); }
+#endif
+};
+
+#ifdef __AVX2__
+/// per 64 bits lane popcount by nibble lookup (Mula)
+inline __m256i popcount256(__m256i v)
+{
+    const __m256i lookup = _mm256_setr_epi8(
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low_mask));
+    __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask));
+    return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+}
+#endif
+
+/// out = a op b over a whole bitmap container, returns the cardinality of out
+template <typename Op>
+uint32_t bitmap_op(const uint64_t* a, const uint64_t* b, uint64_t* out)
+{
+#ifdef __AVX2__
+    __m256i count = _mm256_setzero_si256();
+    for (uint32_t i = 0; i < BITMAP_SIZE; i += 4)
+    {
+        __m256i v = Op::op(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                           _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+        count = _mm256_add_epi64(count, popcount256(v));
+    }
+    return _mm256_extract_epi64(count, 0) + _mm256_extract_epi64(count, 1)
+        + _mm256_extract_epi64(count, 2) + _mm256_extract_epi64(count, 3);
+#else
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < BITMAP_SIZE; ++i)
+    {
+        out[i] = Op::op(a[i], b[i]);
+        size += popcount64(out[i]);
+    }
+    return size;
+#endif
+}
+
+uint32_t bitmap_cardinality(const uint64_t* a)
+{
+#ifdef __AVX2__
+    __m256i count = _mm256_setzero_si256();
+    for (uint32_t i = 0; i < BITMAP_SIZE; i += 4)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        count = _mm256_add_epi64(count, popcount256(v));
+    }
+    return _mm256_extract_epi64(count, 0) + _mm256_extract_epi64(count, 1)
+        + _mm256_extract_epi64(count, 2) + _mm256_extract_epi64(count, 3);
+#else
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < BITMAP_SIZE; i += 4)
+    {
+        size += popcount64(a[i]) + popcount64(a[i + 1])
+            + popcount64(a[i + 2]) + popcount64(a[i + 3]);
+    }
+    return size;
+#endif
+}
+
+/// sets the bits in [begin, end]
+void bitmap_set_range(uint64_t* data, uint32_t begin, uint32_t end)
+{
+    uint32_t first = begin / 64, last = end / 64;
+    uint64_t first_mask = ~0ULL << (begin % 64);
+    uint64_t last_mask = ~0ULL >> (63 - end % 64);
+
+    if (first == last)
+    {
+        data[first] |= first_mask & last_mask;
+        return;
+    }
+
+    data[first] |= first_mask;
+    for (uint32_t i = first + 1; i < last; ++i)
+        data[i] = ~0ULL;
+    data[last] |= last_mask;
+}
+
+/// runs are stored as (start, length - 1) pairs of uint16
+inline uint32_t run_start(const uint16_t* runs, uint32_t i)
+{
+    return runs[2 * i];
+}
+
+inline uint32_t run_end(const uint16_t* runs, uint32_t i)
+{
+    return runs[2 * i] + runs[2 * i + 1];
+}
+
+}
+
 RoaringChunk::RoaringChunk(uint32_t key)
     : key_(key)
     , updatable_(false)
@@ -127,6 +333,17 @@ void RoaringChunk::trim()
             flag_.clear();
         }
     }
+    else if (chunk_[0] == RUN)
+    {
+        if (chunk_[1] == MAX_CHUNK_CAPACITY)
+        {
+            full_ = true;
+
+            while (flag_.test_and_set());
+            chunk_.reset();
+            flag_.clear();
+        }
+    }
     else
     {
         if (chunk_[1] < MAX_ARRAY_SIZE)
@@ -187,6 +404,16 @@ void RoaringChunk::add(uint32_t x)
         chunk_.swap(new_chunk);
         flag_.clear();
     }
+    else if (chunk_[0] == RUN)
+    {
+        data_type new_chunk = expandRun(chunk_);
+
+        while (flag_.test_and_set());
+        chunk_.swap(new_chunk);
+        flag_.clear();
+
+        add(x);
+    }
     else if (chunk_[0] == ARRAY)
     {
         if (chunk_[1] < chunk_[2])
@@ -269,7 +496,7 @@ bool RoaringChunk::contains(uint32_t x) const
     {
         const uint16_t* data = reinterpret_cast<const uint16_t*>(&tmp_chunk[4]);
 
-        if (data[tmp_chunk[1]] < x) return false;
+        if (!tmp_chunk[1] || data[tmp_chunk[1] - 1] < x) return false;
 
         __m128i pivot = _mm_set1_epi16((uint16_t)x);
         const uint16_t* tmp = data;
@@ -277,9 +504,9 @@ bool RoaringChunk::contains(uint32_t x) const
         for (;; tmp += INIT_ARRAY_SIZE)
         {
             int res = _mm_movemask_epi8(_mm_packs_epi16(
-                        _mm_cmplt_epi16(_mm_load_si128(
+                        cmplt_epu16(_mm_load_si128(
                                 reinterpret_cast<const __m128i*>(tmp)), pivot),
-                        _mm_cmplt_epi16(_mm_load_si128(
+                        cmplt_epu16(_mm_load_si128(
                                 reinterpret_cast<const __m128i*>(tmp) + 1), pivot)));
 
             if (res != 0xffff)
@@ -290,6 +517,21 @@ bool RoaringChunk::contains(uint32_t x) const
 
         return false;
     }
+    else if (tmp_chunk[0] == RUN)
+    {
+        const uint16_t* runs = reinterpret_cast<const uint16_t*>(&tmp_chunk[4]);
+
+        // the last run starting at or before x
+        uint32_t begin = 0, end = tmp_chunk[2];
+        while (begin < end)
+        {
+            uint32_t middle = (begin + end) / 2;
+            if (run_start(runs, middle) <= x) begin = middle + 1;
+            else end = middle;
+        }
+
+        return begin > 0 && x <= run_end(runs, begin - 1);
+    }
     else
     {
         const uint64_t* data = reinterpret_cast<const uint64_t*>(&tmp_chunk[4]);
@@ -333,6 +575,7 @@ RoaringChunk RoaringChunk::operator~() const
     self_type answer(key_);
 
     data_type chunk = getChunk();
+    if (chunk && chunk[0] == RUN) chunk = expandRun(chunk);
 
     if (!chunk) answer.full_ = !full_;
     else if (chunk[0] == ARRAY) answer.not_Array(chunk);
@@ -348,6 +591,15 @@ RoaringChunk RoaringChunk::operator&(const self_type& b) const
     data_type a_chunk = getChunk();
     data_type b_chunk = b.getChunk();
 
+    if (a_chunk && b_chunk && a_chunk[0] == RUN && b_chunk[0] == RUN)
+    {
+        answer.and_RunRun(a_chunk, b_chunk);
+        return answer;
+    }
+
+    if (a_chunk && a_chunk[0] == RUN) a_chunk = expandRun(a_chunk);
+    if (b_chunk && b_chunk[0] == RUN) b_chunk = expandRun(b_chunk);
+
     uint32_t type = (!a_chunk ? 2 + full_ : a_chunk[0]) * 4
         + (!b_chunk ? 2 + b.full_ : b_chunk[0]);
 
@@ -374,6 +626,15 @@ RoaringChunk RoaringChunk::operator|(const self_type& b) const
     data_type a_chunk = getChunk();
     data_type b_chunk = b.getChunk();
 
+    if (a_chunk && b_chunk && a_chunk[0] == RUN && b_chunk[0] == RUN)
+    {
+        answer.or_RunRun(a_chunk, b_chunk);
+        return answer;
+    }
+
+    if (a_chunk && a_chunk[0] == RUN) a_chunk = expandRun(a_chunk);
+    if (b_chunk && b_chunk[0] == RUN) b_chunk = expandRun(b_chunk);
+
     uint32_t type = (!a_chunk ? 2 + full_ : a_chunk[0]) * 4
         + (!b_chunk ? 2 + b.full_ : b_chunk[0]);
 
@@ -401,6 +662,9 @@ RoaringChunk RoaringChunk::operator^(const self_type& b) const
     data_type a_chunk = getChunk();
     data_type b_chunk = b.getChunk();
 
+    if (a_chunk && a_chunk[0] == RUN) a_chunk = expandRun(a_chunk);
+    if (b_chunk && b_chunk[0] == RUN) b_chunk = expandRun(b_chunk);
+
     uint32_t type = (!a_chunk ? 2 + full_ : a_chunk[0]) * 4
         + (!b_chunk ? 2 + b.full_ : b_chunk[0]);
 
@@ -432,6 +696,9 @@ RoaringChunk RoaringChunk::operator-(const self_type& b) const
     data_type a_chunk = getChunk();
     data_type b_chunk = b.getChunk();
 
+    if (a_chunk && a_chunk[0] == RUN) a_chunk = expandRun(a_chunk);
+    if (b_chunk && b_chunk[0] == RUN) b_chunk = expandRun(b_chunk);
+
     uint32_t type = (!a_chunk ? 2 + full_ : a_chunk[0]) * 4
         + (!b_chunk ? 2 + b.full_ : b_chunk[0]);
 
@@ -512,14 +779,7 @@ void RoaringChunk::and_BitmapBitmap(const data_type& a, const data_type& b)
     const uint64_t* a_data = reinterpret_cast<const uint64_t*>(&a[4]);
     const uint64_t* b_data = reinterpret_cast<const uint64_t*>(&b[4]);
 
-    uint32_t size = 0;
-    for (uint32_t i = 0; i < BITMAP_SIZE; ++i)
-    {
-        data[i] = a_data[i] & b_data[i];
-        size += _mm_popcnt_u64(data[i]);
-    }
-
-    chunk_[1] = size;
+    chunk_[1] = bitmap_op<AndOp>(a_data, b_data, data);
     trim();
 }
 
@@ -551,80 +811,11 @@ void RoaringChunk::and_ArrayArray(const data_type& a, const data_type& b)
 
     resetChunk(ARRAY, std::min(a_size, b_size));
 
-    uint32_t pos = 0, a_pos = 0, b_pos = 0;
-
     uint16_t* data = reinterpret_cast<uint16_t*>(&chunk_[4]);
     const uint16_t* a_data = reinterpret_cast<const uint16_t*>(&a[4]);
     const uint16_t* b_data = reinterpret_cast<const uint16_t*>(&b[4]);
 
-    if (a_pos < a_size && b_pos < b_size)
-    {
-        uint16_t a_tail = a_data[a_size - 1], b_tail = b_data[b_size - 1];
-        uint16_t a_current = a_data[0], b_current = b_data[0];
-
-        while (true)
-        {
-            if (a_current < b_current)
-            {
-                if (a_tail < b_current) break;
-
-                const uint16_t* tmp = a_data + (a_pos & -INIT_ARRAY_SIZE);
-                __m128i pivot = _mm_set1_epi16(b_current);
-
-                for (;; tmp += INIT_ARRAY_SIZE)
-                {
-                    int res = _mm_movemask_epi8(_mm_packs_epi16(
-                                _mm_cmplt_epi16(_mm_load_si128(
-                                        reinterpret_cast<const __m128i*>(tmp)), pivot),
-                                _mm_cmplt_epi16(_mm_load_si128(
-                                        reinterpret_cast<const __m128i*>(tmp) + 1), pivot)));
-
-                    if (res != 0xffff)
-                    {
-                        a_pos = tmp - a_data + __builtin_ctz(~res);
-                        a_current = a_data[a_pos];
-                        break;
-                    }
-                }
-            }
-
-            if (a_current > b_current)
-            {
-                if (a_current > b_tail) break;
-
-                const uint16_t* tmp = b_data + (b_pos & -INIT_ARRAY_SIZE);
-                __m128i pivot = _mm_set1_epi16(a_current);
-
-                for (;; tmp += INIT_ARRAY_SIZE)
-                {
-                    int res = _mm_movemask_epi8(_mm_packs_epi16(
-                                _mm_cmplt_epi16(_mm_load_si128(
-                                        reinterpret_cast<const __m128i*>(tmp)), pivot),
-                                _mm_cmplt_epi16(_mm_load_si128(
-                                        reinterpret_cast<const __m128i*>(tmp) + 1), pivot)));
-
-                    if (res != 0xffff)
-                    {
-                        b_pos = tmp - b_data + __builtin_ctz(~res);
-                        b_current = b_data[b_pos];
-                        break;
-                    }
-                }
-            }
-
-            if (a_current == b_current)
-            {
-                data[pos++] = a_current;
-
-                if (++a_pos == a_size || ++b_pos == b_size) break;
-
-                a_current = a_data[a_pos];
-                b_current = b_data[b_pos];
-            }
-        }
-    }
-
-    chunk_[1] = pos;
+    chunk_[1] = intersect_uint16(a_data, a_size, b_data, b_size, data);
     trim();
 }
 
@@ -636,14 +827,7 @@ void RoaringChunk::or_BitmapBitmap(const data_type& a, const data_type& b)
     const uint64_t* a_data = reinterpret_cast<const uint64_t*>(&a[4]);
     const uint64_t* b_data = reinterpret_cast<const uint64_t*>(&b[4]);
 
-    uint32_t size = 0;
-    for (uint32_t i = 0; i < BITMAP_SIZE; ++i)
-    {
-        data[i] = a_data[i] | b_data[i];
-        size += _mm_popcnt_u64(data[i]);
-    }
-
-    chunk_[1] = size;
+    chunk_[1] = bitmap_op<OrOp>(a_data, b_data, data);
     trim();
 }
 
@@ -661,13 +845,7 @@ void RoaringChunk::or_BitmapArray(const data_type& a, const data_type& b)
         data[val / 64] |= 1ULL << val;
     }
 
-    size = 0;
-    for (uint32_t i = 0; i < BITMAP_SIZE; ++i)
-    {
-        size += _mm_popcnt_u64(data[i]);
-    }
-
-    chunk_[1] = size;
+    chunk_[1] = bitmap_cardinality(data);
     trim();
 }
 
@@ -699,6 +877,7 @@ void RoaringChunk::or_ArrayArray(const data_type& a, const data_type& b)
                     {
                         memcpy(&data[pos], &a_data[a_pos], (a_size - a_pos) * 2);
                         pos += a_size - a_pos;
+                        a_pos = a_size;
                         break;
                     }
 
@@ -708,9 +887,9 @@ void RoaringChunk::or_ArrayArray(const data_type& a, const data_type& b)
                     for (;; tmp += INIT_ARRAY_SIZE)
                     {
                         int res = _mm_movemask_epi8(_mm_packs_epi16(
-                                    _mm_cmplt_epi16(_mm_load_si128(
+                                    cmplt_epu16(_mm_load_si128(
                                             reinterpret_cast<const __m128i*>(tmp)), pivot),
-                                    _mm_cmplt_epi16(_mm_load_si128(
+                                    cmplt_epu16(_mm_load_si128(
                                             reinterpret_cast<const __m128i*>(tmp) + 1), pivot)));
 
                         if (res != 0xffff)
@@ -731,6 +910,7 @@ void RoaringChunk::or_ArrayArray(const data_type& a, const data_type& b)
                     {
                         memcpy(&data[pos], &b_data[b_pos], (b_size - b_pos) * 2);
                         pos += b_size - b_pos;
+                        b_pos = b_size;
                         break;
                     }
 
@@ -740,9 +920,9 @@ void RoaringChunk::or_ArrayArray(const data_type& a, const data_type& b)
                     for (;; tmp += INIT_ARRAY_SIZE)
                     {
                         int res = _mm_movemask_epi8(_mm_packs_epi16(
-                                    _mm_cmplt_epi16(_mm_load_si128(
+                                    cmplt_epu16(_mm_load_si128(
                                             reinterpret_cast<const __m128i*>(tmp)), pivot),
-                                    _mm_cmplt_epi16(_mm_load_si128(
+                                    cmplt_epu16(_mm_load_si128(
                                             reinterpret_cast<const __m128i*>(tmp) + 1), pivot)));
 
                         if (res != 0xffff)
@@ -761,7 +941,9 @@ void RoaringChunk::or_ArrayArray(const data_type& a, const data_type& b)
                 {
                     data[pos++] = a_current;
 
-                    if (++a_pos == a_size || ++b_pos == b_size) break;
+                    ++a_pos;
+                    ++b_pos;
+                    if (a_pos == a_size || b_pos == b_size) break;
 
                     a_current = a_data[a_pos];
                     b_current = b_data[b_pos];
@@ -802,13 +984,7 @@ void RoaringChunk::or_ArrayArray(const data_type& a, const data_type& b)
             data[val / 64] |= 1ULL << val;
         }
 
-        size = 0;
-        for (uint32_t i = 0; i < BITMAP_SIZE; ++i)
-        {
-            size += _mm_popcnt_u64(data[i]);
-        }
-
-        chunk_[1] = size;
+        chunk_[1] = bitmap_cardinality(data);
     }
 
     trim();
@@ -822,14 +998,7 @@ void RoaringChunk::xor_BitmapBitmap(const data_type& a, const data_type& b)
     const uint64_t* a_data = reinterpret_cast<const uint64_t*>(&a[4]);
     const uint64_t* b_data = reinterpret_cast<const uint64_t*>(&b[4]);
 
-    uint32_t size = 0;
-    for (uint32_t i = 0; i < BITMAP_SIZE; ++i)
-    {
-        data[i] = a_data[i] & b_data[i];
-        size += _mm_popcnt_u64(data[i]);
-    }
-
-    chunk_[1] = size;
+    chunk_[1] = bitmap_op<XorOp>(a_data, b_data, data);
     trim();
 }
 
@@ -847,13 +1016,7 @@ void RoaringChunk::xor_BitmapArray(const data_type& a, const data_type& b)
         data[val / 64] ^= 1ULL << val;
     }
 
-    size = 0;
-    for (uint32_t i = 0; i < BITMAP_SIZE; ++i)
-    {
-        size += _mm_popcnt_u64(data[i]);
-    }
-
-    chunk_[1] = size;
+    chunk_[1] = bitmap_cardinality(data);
     trim();
 }
 
@@ -885,6 +1048,7 @@ void RoaringChunk::xor_ArrayArray(const data_type& a, const data_type& b)
                     {
                         memcpy(&data[pos], &a_data[a_pos], (a_size - a_pos) * 2);
                         pos += a_size - a_pos;
+                        a_pos = a_size;
                         break;
                     }
 
@@ -894,9 +1058,9 @@ void RoaringChunk::xor_ArrayArray(const data_type& a, const data_type& b)
                     for (;; tmp += INIT_ARRAY_SIZE)
                     {
                         int res = _mm_movemask_epi8(_mm_packs_epi16(
-                                    _mm_cmplt_epi16(_mm_load_si128(
+                                    cmplt_epu16(_mm_load_si128(
                                             reinterpret_cast<const __m128i*>(tmp)), pivot),
-                                    _mm_cmplt_epi16(_mm_load_si128(
+                                    cmplt_epu16(_mm_load_si128(
                                             reinterpret_cast<const __m128i*>(tmp) + 1), pivot)));
 
                         if (res != 0xffff)
@@ -917,6 +1081,7 @@ void RoaringChunk::xor_ArrayArray(const data_type& a, const data_type& b)
                     {
                         memcpy(&data[pos], &b_data[b_pos], (b_size - b_pos) * 2);
                         pos += b_size - b_pos;
+                        b_pos = b_size;
                         break;
                     }
 
@@ -926,9 +1091,9 @@ void RoaringChunk::xor_ArrayArray(const data_type& a, const data_type& b)
                     for (;; tmp += INIT_ARRAY_SIZE)
                     {
                         int res = _mm_movemask_epi8(_mm_packs_epi16(
-                                    _mm_cmplt_epi16(_mm_load_si128(
+                                    cmplt_epu16(_mm_load_si128(
                                             reinterpret_cast<const __m128i*>(tmp)), pivot),
-                                    _mm_cmplt_epi16(_mm_load_si128(
+                                    cmplt_epu16(_mm_load_si128(
                                             reinterpret_cast<const __m128i*>(tmp) + 1), pivot)));
 
                         if (res != 0xffff)
@@ -945,7 +1110,9 @@ void RoaringChunk::xor_ArrayArray(const data_type& a, const data_type& b)
 
                 if (a_current == b_current)
                 {
-                    if (++a_pos == a_size || ++b_pos == b_size) break;
+                    ++a_pos;
+                    ++b_pos;
+                    if (a_pos == a_size || b_pos == b_size) break;
 
                     a_current = a_data[a_pos];
                     b_current = b_data[b_pos];
@@ -986,13 +1153,7 @@ void RoaringChunk::xor_ArrayArray(const data_type& a, const data_type& b)
             data[val / 64] ^= 1ULL << val;
         }
 
-        size = 0;
-        for (uint32_t i = 0; i < BITMAP_SIZE; ++i)
-        {
-            size += _mm_popcnt_u64(data[i]);
-        }
-
-        chunk_[1] = size;
+        chunk_[1] = bitmap_cardinality(data);
     }
 
     trim();
@@ -1006,14 +1167,7 @@ void RoaringChunk::andNot_BitmapBitmap(const data_type& a, const data_type& b)
     const uint64_t* a_data = reinterpret_cast<const uint64_t*>(&a[4]);
     const uint64_t* b_data = reinterpret_cast<const uint64_t*>(&b[4]);
 
-    uint32_t size = 0;
-    for (uint32_t i = 0; i < BITMAP_SIZE; ++i)
-    {
-        data[i] = a_data[i] & ~b_data[i];
-        size += _mm_popcnt_u64(data[i]);
-    }
-
-    chunk_[1] = size;
+    chunk_[1] = bitmap_op<AndNotOp>(a_data, b_data, data);
     trim();
 }
 
@@ -1031,13 +1185,7 @@ void RoaringChunk::andNot_BitmapArray(const data_type& a, const data_type& b)
         data[val / 64] &= ~(1ULL << val);
     }
 
-    size = 0;
-    for (uint32_t i = 0; i < BITMAP_SIZE; ++i)
-    {
-        size += _mm_popcnt_u64(data[i]);
-    }
-
-    chunk_[1] = size;
+    chunk_[1] = bitmap_cardinality(data);
     trim();
 }
 
@@ -1088,6 +1236,7 @@ void RoaringChunk::andNot_ArrayArray(const data_type& a, const data_type& b)
                 {
                     memcpy(&data[pos], &a_data[a_pos], (a_size - a_pos) * 2);
                     pos += a_size - a_pos;
+                    a_pos = a_size;
                     break;
                 }
 
@@ -1097,9 +1246,9 @@ void RoaringChunk::andNot_ArrayArray(const data_type& a, const data_type& b)
                 for (;; tmp += INIT_ARRAY_SIZE)
                 {
                     int res = _mm_movemask_epi8(_mm_packs_epi16(
-                                _mm_cmplt_epi16(_mm_load_si128(
+                                cmplt_epu16(_mm_load_si128(
                                         reinterpret_cast<const __m128i*>(tmp)), pivot),
-                                _mm_cmplt_epi16(_mm_load_si128(
+                                cmplt_epu16(_mm_load_si128(
                                         reinterpret_cast<const __m128i*>(tmp) + 1), pivot)));
 
                     if (res != 0xffff)
@@ -1116,7 +1265,11 @@ void RoaringChunk::andNot_ArrayArray(const data_type& a, const data_type& b)
 
             if (a_current > b_current)
             {
-                if (a_current > b_tail) break;
+                if (a_current > b_tail)
+                {
+                    b_pos = b_size;
+                    break;
+                }
 
                 const uint16_t* tmp = b_data + (b_pos & -INIT_ARRAY_SIZE);
                 __m128i pivot = _mm_set1_epi16(a_current);
@@ -1124,9 +1277,9 @@ void RoaringChunk::andNot_ArrayArray(const data_type& a, const data_type& b)
                 for (;; tmp += INIT_ARRAY_SIZE)
                 {
                     int res = _mm_movemask_epi8(_mm_packs_epi16(
-                                _mm_cmplt_epi16(_mm_load_si128(
+                                cmplt_epu16(_mm_load_si128(
                                         reinterpret_cast<const __m128i*>(tmp)), pivot),
-                                _mm_cmplt_epi16(_mm_load_si128(
+                                cmplt_epu16(_mm_load_si128(
                                         reinterpret_cast<const __m128i*>(tmp) + 1), pivot)));
 
                     if (res != 0xffff)
@@ -1140,7 +1293,9 @@ void RoaringChunk::andNot_ArrayArray(const data_type& a, const data_type& b)
 
             if (a_current == b_current)
             {
-                if (++a_pos == a_size || ++b_pos == b_size) break;
+                ++a_pos;
+                ++b_pos;
+                if (a_pos == a_size || b_pos == b_size) break;
 
                 a_current = a_data[a_pos];
                 b_current = b_data[b_pos];
@@ -1158,4 +1313,448 @@ void RoaringChunk::andNot_ArrayArray(const data_type& a, const data_type& b)
     trim();
 }
 
+void RoaringChunk::init(uint32_t key, const uint32_t* begin, const uint32_t* end)
+{
+    key_ = key;
+    updatable_ = true;
+    full_ = false;
+
+    uint32_t size = end - begin;
+
+    if (size == MAX_CHUNK_CAPACITY)
+    {
+        resetChunk(FULL, 0);
+    }
+    else if (size >= MAX_ARRAY_SIZE)
+    {
+        resetChunk(BITMAP, 0);
+
+        uint64_t* data = reinterpret_cast<uint64_t*>(&chunk_[4]);
+        for (const uint32_t* it = begin; it != end; ++it)
+        {
+            uint32_t val = *it & 0xffff;
+            data[val / 64] |= 1ULL << (val % 64);
+        }
+        chunk_[1] = size;
+    }
+    else
+    {
+        resetChunk(ARRAY, std::max(size, INIT_ARRAY_SIZE));
+
+        uint16_t* data = reinterpret_cast<uint16_t*>(&chunk_[4]);
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            data[i] = uint16_t(begin[i]);
+        }
+        chunk_[1] = size;
+    }
+}
+
+RoaringChunk::data_type RoaringChunk::expandRun(const data_type& a)
+{
+    uint32_t size = a[1], run_num = a[2];
+    const uint16_t* runs = reinterpret_cast<const uint16_t*>(&a[4]);
+
+    RoaringChunk tmp;
+
+    if (size >= MAX_ARRAY_SIZE)
+    {
+        tmp.resetChunk(BITMAP, 0);
+
+        uint64_t* data = reinterpret_cast<uint64_t*>(&tmp.chunk_[4]);
+        for (uint32_t i = 0; i < run_num; ++i)
+        {
+            bitmap_set_range(data, run_start(runs, i), run_end(runs, i));
+        }
+    }
+    else
+    {
+        tmp.resetChunk(ARRAY, size);
+
+        uint16_t* data = reinterpret_cast<uint16_t*>(&tmp.chunk_[4]);
+        for (uint32_t i = 0, pos = 0; i < run_num; ++i)
+        {
+            for (uint32_t val = run_start(runs, i); val <= run_end(runs, i); ++val)
+            {
+                data[pos++] = val;
+            }
+        }
+    }
+    tmp.chunk_[1] = size;
+
+    return tmp.chunk_;
+}
+
+bool RoaringChunk::runOptimize()
+{
+    data_type chunk = getChunk();
+    if (!chunk || chunk[0] == RUN) return false;
+
+    uint32_t run_num = 0;
+    uint32_t current_size = 0;
+
+    if (chunk[0] == ARRAY)
+    {
+        const uint16_t* data = reinterpret_cast<const uint16_t*>(&chunk[4]);
+        uint32_t size = chunk[1];
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            if (i == 0 || data[i] != data[i - 1] + 1) ++run_num;
+        }
+        current_size = size * 2;
+    }
+    else
+    {
+        // a run starts at every set bit whose predecessor is clear
+        const uint64_t* data = reinterpret_cast<const uint64_t*>(&chunk[4]);
+        uint64_t carry = 0;
+        for (uint32_t i = 0; i < BITMAP_SIZE; ++i)
+        {
+            run_num += popcount64(data[i] & ~((data[i] << 1) | carry));
+            carry = data[i] >> 63;
+        }
+        current_size = MAX_CHUNK_CAPACITY / 8;
+    }
+
+    if (run_num * 4 >= current_size) return false;
+
+    data_type new_chunk(cachealign_alloc<uint32_t>(run_num + 4, 16), cachealign_deleter());
+    new_chunk[0] = RUN;
+    new_chunk[1] = chunk[1];
+    new_chunk[2] = run_num;
+    new_chunk[3] = run_num + 4;
+
+    uint16_t* runs = reinterpret_cast<uint16_t*>(&new_chunk[4]);
+    uint32_t pos = 0;
+
+    if (chunk[0] == ARRAY)
+    {
+        const uint16_t* data = reinterpret_cast<const uint16_t*>(&chunk[4]);
+        uint32_t size = chunk[1];
+        for (uint32_t i = 0; i < size; ++i)
+        {
+            if (i == 0 || data[i] != data[i - 1] + 1)
+            {
+                runs[2 * pos] = data[i];
+                runs[2 * pos++ + 1] = 0;
+            }
+            else
+            {
+                ++runs[2 * pos - 1];
+            }
+        }
+    }
+    else
+    {
+        const uint64_t* data = reinterpret_cast<const uint64_t*>(&chunk[4]);
+        uint32_t i = 0;
+        uint64_t word = data[0];
+
+        while (true)
+        {
+            while (word == 0 && i < BITMAP_SIZE - 1) word = data[++i];
+            if (word == 0) break;
+
+            uint32_t start = i * 64 + __builtin_ctzll(word);
+            // fill the trailing zeros, then look for the first clear bit
+            word |= word - 1;
+            while (word == ~0ULL && i < BITMAP_SIZE - 1) word = data[++i];
+
+            uint32_t stop = word == ~0ULL ? MAX_CHUNK_CAPACITY : i * 64 + __builtin_ctzll(~word);
+            runs[2 * pos] = start;
+            runs[2 * pos++ + 1] = stop - start - 1;
+
+            if (stop == MAX_CHUNK_CAPACITY) break;
+            // clear the trailing ones
+            word &= word + 1;
+        }
+    }
+
+    while (flag_.test_and_set());
+    chunk_.swap(new_chunk);
+    flag_.clear();
+
+    return true;
+}
+
+void RoaringChunk::toArray(std::vector<uint32_t>& values) const
+{
+    data_type chunk = getChunk();
+    uint32_t high = key_ << 16;
+
+    if (!chunk)
+    {
+        if (full_)
+        {
+            for (uint32_t i = 0; i < MAX_CHUNK_CAPACITY; ++i)
+                values.push_back(high | i);
+        }
+    }
+    else if (chunk[0] == ARRAY)
+    {
+        const uint16_t* data = reinterpret_cast<const uint16_t*>(&chunk[4]);
+        for (uint32_t i = 0; i < chunk[1]; ++i)
+            values.push_back(high | data[i]);
+    }
+    else if (chunk[0] == RUN)
+    {
+        const uint16_t* runs = reinterpret_cast<const uint16_t*>(&chunk[4]);
+        for (uint32_t i = 0; i < chunk[2]; ++i)
+        {
+            for (uint32_t val = run_start(runs, i); val <= run_end(runs, i); ++val)
+                values.push_back(high | val);
+        }
+    }
+    else
+    {
+        const uint64_t* data = reinterpret_cast<const uint64_t*>(&chunk[4]);
+        for (uint32_t i = 0; i < BITMAP_SIZE; ++i)
+        {
+            uint64_t block = data[i];
+            while (block)
+            {
+                values.push_back(high | (i * 64 + __builtin_ctzll(block)));
+                block &= block - 1;
+            }
+        }
+    }
+}
+
+uint32_t RoaringChunk::getType() const
+{
+    data_type chunk = getChunk();
+    return chunk ? chunk[0] : full_ ? FULL : EMPTY;
+}
+
+uint32_t RoaringChunk::serializedSizeInBytes() const
+{
+    data_type chunk = getChunk();
+
+    if (!chunk) return 0;
+    if (chunk[0] == ARRAY) return chunk[1] * 2;
+    if (chunk[0] == RUN) return chunk[2] * 4;
+    return MAX_CHUNK_CAPACITY / 8;
+}
+
+uint32_t RoaringChunk::serialize(char* buf) const
+{
+    data_type chunk = getChunk();
+
+    if (!chunk) return 0;
+
+    uint32_t size = chunk[0] == ARRAY ? chunk[1] * 2
+        : chunk[0] == RUN ? chunk[2] * 4
+        : MAX_CHUNK_CAPACITY / 8;
+    memcpy(buf, &chunk[4], size);
+
+    return size;
+}
+
+bool RoaringChunk::validRuns(const uint16_t* runs, uint32_t num, uint32_t cardinality)
+{
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        if (i > 0 && run_start(runs, i) <= run_end(runs, i - 1)) return false;
+        if (run_end(runs, i) >= MAX_CHUNK_CAPACITY) return false;
+        sum += run_end(runs, i) - run_start(runs, i) + 1;
+    }
+    return sum == cardinality;
+}
+
+bool RoaringChunk::deserialize(uint32_t key, uint32_t type, uint32_t cardinality, const char* buf, uint32_t size)
+{
+    if (type == RUN && !validRuns(reinterpret_cast<const uint16_t*>(buf), size / 4, cardinality))
+        return false;
+
+    key_ = key;
+    updatable_ = false;
+    full_ = false;
+
+    // the header and the runs are checked by RoaringBitmapView::init(), the
+    // copies are sized by the chunk anyway
+    switch (type)
+    {
+    case ARRAY:
+        resetChunk(ARRAY, cardinality);
+        memcpy(&chunk_[4], buf, std::min(size, cardinality * 2));
+        chunk_[1] = cardinality;
+        break;
+
+    case BITMAP:
+        resetChunk(BITMAP, 0);
+        memcpy(&chunk_[4], buf, std::min(size, MAX_CHUNK_CAPACITY / 8));
+        chunk_[1] = cardinality;
+        break;
+
+    case RUN:
+        chunk_.reset(cachealign_alloc<uint32_t>(size / 4 + 4, 16), cachealign_deleter());
+        chunk_[0] = RUN;
+        chunk_[1] = cardinality;
+        chunk_[2] = size / 4;
+        chunk_[3] = size / 4 + 4;
+        memcpy(&chunk_[4], buf, size);
+        break;
+
+    default:
+        resetChunk((Type)type, 0);
+        break;
+    }
+
+    return true;
+}
+
+void RoaringChunk::and_RunRun(const data_type& a, const data_type& b)
+{
+    uint32_t a_num = a[2], b_num = b[2];
+    const uint16_t* a_runs = reinterpret_cast<const uint16_t*>(&a[4]);
+    const uint16_t* b_runs = reinterpret_cast<const uint16_t*>(&b[4]);
+
+    data_type new_chunk(cachealign_alloc<uint32_t>(a_num + b_num + 4, 16), cachealign_deleter());
+    uint16_t* runs = reinterpret_cast<uint16_t*>(&new_chunk[4]);
+
+    uint32_t pos = 0, size = 0, a_pos = 0, b_pos = 0;
+    while (a_pos < a_num && b_pos < b_num)
+    {
+        uint32_t start = std::max(run_start(a_runs, a_pos), run_start(b_runs, b_pos));
+        uint32_t end = std::min(run_end(a_runs, a_pos), run_end(b_runs, b_pos));
+
+        if (start <= end)
+        {
+            runs[2 * pos] = start;
+            runs[2 * pos++ + 1] = end - start;
+            size += end - start + 1;
+        }
+
+        if (run_end(a_runs, a_pos) < run_end(b_runs, b_pos)) ++a_pos;
+        else ++b_pos;
+    }
+
+    new_chunk[0] = RUN;
+    new_chunk[1] = size;
+    new_chunk[2] = pos;
+    new_chunk[3] = a_num + b_num + 4;
+    chunk_.swap(new_chunk);
+    trim();
+}
+
+void RoaringChunk::or_RunRun(const data_type& a, const data_type& b)
+{
+    uint32_t a_num = a[2], b_num = b[2];
+    const uint16_t* a_runs = reinterpret_cast<const uint16_t*>(&a[4]);
+    const uint16_t* b_runs = reinterpret_cast<const uint16_t*>(&b[4]);
+
+    data_type new_chunk(cachealign_alloc<uint32_t>(a_num + b_num + 4, 16), cachealign_deleter());
+    uint16_t* runs = reinterpret_cast<uint16_t*>(&new_chunk[4]);
+
+    uint32_t pos = 0, size = 0, a_pos = 0, b_pos = 0;
+    uint32_t start = 0, end = 0;
+    bool open = false;
+
+    while (a_pos < a_num || b_pos < b_num)
+    {
+        uint32_t next_start, next_end;
+        if (b_pos == b_num || (a_pos < a_num && run_start(a_runs, a_pos) < run_start(b_runs, b_pos)))
+        {
+            next_start = run_start(a_runs, a_pos);
+            next_end = run_end(a_runs, a_pos++);
+        }
+        else
+        {
+            next_start = run_start(b_runs, b_pos);
+            next_end = run_end(b_runs, b_pos++);
+        }
+
+        // merge overlapping or adjacent runs
+        if (open && next_start <= end + 1)
+        {
+            end = std::max(end, next_end);
+            continue;
+        }
+
+        if (open)
+        {
+            runs[2 * pos] = start;
+            runs[2 * pos++ + 1] = end - start;
+            size += end - start + 1;
+        }
+        start = next_start;
+        end = next_end;
+        open = true;
+    }
+
+    if (open)
+    {
+        runs[2 * pos] = start;
+        runs[2 * pos++ + 1] = end - start;
+        size += end - start + 1;
+    }
+
+    new_chunk[0] = RUN;
+    new_chunk[1] = size;
+    new_chunk[2] = pos;
+    new_chunk[3] = a_num + b_num + 4;
+    chunk_.swap(new_chunk);
+    trim();
+}
+
+void RoaringChunk::lazyOr(uint64_t* words) const
+{
+    data_type chunk = getChunk();
+
+    if (!chunk)
+    {
+        if (full_) memset(words, 0xff, MAX_CHUNK_CAPACITY / 8);
+    }
+    else if (chunk[0] == ARRAY)
+    {
+        const uint16_t* data = reinterpret_cast<const uint16_t*>(&chunk[4]);
+        for (uint32_t i = 0; i < chunk[1]; ++i)
+        {
+            uint16_t val = data[i];
+            words[val / 64] |= 1ULL << (val % 64);
+        }
+    }
+    else if (chunk[0] == RUN)
+    {
+        const uint16_t* runs = reinterpret_cast<const uint16_t*>(&chunk[4]);
+        for (uint32_t i = 0; i < chunk[2]; ++i)
+        {
+            bitmap_set_range(words, run_start(runs, i), run_end(runs, i));
+        }
+    }
+    else
+    {
+        const uint64_t* data = reinterpret_cast<const uint64_t*>(&chunk[4]);
+        for (uint32_t i = 0; i < BITMAP_SIZE; ++i)
+        {
+            words[i] |= data[i];
+        }
+    }
+}
+
+void RoaringChunk::initBitmap(uint32_t key, const uint64_t* words)
+{
+    key_ = key;
+    updatable_ = true;
+    full_ = false;
+
+    uint32_t size = bitmap_cardinality(words);
+    if (size == 0)
+    {
+        resetChunk(EMPTY, 0);
+    }
+    else if (size == MAX_CHUNK_CAPACITY)
+    {
+        resetChunk(FULL, 0);
+    }
+    else
+    {
+        resetChunk(BITMAP, 0);
+        memcpy(&chunk_[4], words, MAX_CHUNK_CAPACITY / 8);
+        chunk_[1] = size;
+    }
+    trim();
+}
+
 NS_IZENELIB_AM_END
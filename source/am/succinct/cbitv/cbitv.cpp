@@ -0,0 +1,299 @@
+#include <am/succinct/cbitv/cbitv.hpp>
+#include <util/mem_utils.h>
+
+NS_IZENELIB_AM_BEGIN
+
+namespace succinct
+{
+namespace cbitv
+{
+
+const size_t CBitV::kWordPerBlock;
+const size_t CBitV::kBitPerBlock;
+const size_t CBitV::kSelectSample;
+const size_t CBitV::kRankBits;
+const uint64_t CBitV::kRankMask;
+
+CBitV::CBitV(bool support_select)
+    : support_select_(support_select)
+    , len_(), one_count_()
+{
+}
+
+CBitV::~CBitV()
+{
+}
+
+void CBitV::build(const std::vector<uint64_t> &bv, size_t len)
+{
+    __assert(len <= kRankMask);
+
+    clear();
+    len_ = len;
+
+    size_t size = blockNum_();
+    blocks_.reset(cachealign_alloc<Block>(size), cachealign_deleter());
+    memset(blocks_.get(), 0, size * sizeof(blocks_[0]));
+
+    size_t word_num = (len + kBlockSize - 1) / kBlockSize;
+    for (size_t i = 0; i < word_num; ++i)
+    {
+        blocks_[i / kWordPerBlock].bits_[i % kWordPerBlock] = bv[i];
+    }
+    if (len % kBlockSize)
+    {
+        blocks_[len / kBitPerBlock].bits_[len % kBitPerBlock / kBlockSize] &= (1ULL << len % kBlockSize) - 1;
+    }
+
+    size_t next_one = 0;
+    size_t next_zero = 0;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        Block &block = blocks_[i];
+
+        size_t count2 = SuccinctUtils::popcount(block.bits_[0]) + SuccinctUtils::popcount(block.bits_[1]);
+        size_t count4 = count2 + SuccinctUtils::popcount(block.bits_[2]) + SuccinctUtils::popcount(block.bits_[3]);
+        size_t count = count4;
+        for (size_t j = 4; j < kWordPerBlock; ++j)
+        {
+            count += SuccinctUtils::popcount(block.bits_[j]);
+        }
+
+        block.header_ = one_count_ | (uint64_t)count2 << kRankBits | (uint64_t)count4 << (kRankBits + 8);
+
+        if (support_select_)
+        {
+            size_t zero_count = std::min(kBitPerBlock, len_ - i * kBitPerBlock) - count;
+            for (; next_one < one_count_ + count; next_one += kSelectSample)
+            {
+                select_one_inds_.push_back(i);
+            }
+            for (; next_zero < i * kBitPerBlock - one_count_ + zero_count; next_zero += kSelectSample)
+            {
+                select_zero_inds_.push_back(i);
+            }
+        }
+
+        one_count_ += count;
+    }
+
+    if (support_select_)
+    {
+        select_one_inds_.push_back(size - 1);
+        select_zero_inds_.push_back(size - 1);
+    }
+}
+
+void CBitV::clear()
+{
+    len_ = 0;
+    one_count_ = 0;
+
+    blocks_.reset();
+
+    select_one_inds_.clear();
+    select_zero_inds_.clear();
+}
+
+size_t CBitV::select0(size_t ind) const
+{
+    __assert(support_select_ && ind < len_ - one_count_);
+
+    size_t low = select_zero_inds_[ind / kSelectSample];
+    size_t high = select_zero_inds_[ind / kSelectSample + 1];
+
+    // the last block with no more than ind zeros before it, first guessed
+    // as if the zeros were spread evenly between the samples
+    if (low + kSelectLinearFallback < high)
+    {
+        size_t mid = low + (high - low) * (ind % kSelectSample) / kSelectSample;
+        if (mid * kBitPerBlock - rankOf_(blocks_[mid]) <= ind)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+    while (low + kSelectLinearFallback < high)
+    {
+        size_t mid = low + (high - low + 1) / 2;
+        if (mid * kBitPerBlock - rankOf_(blocks_[mid]) <= ind)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+    for (; low < high && (low + 1) * kBitPerBlock - rankOf_(blocks_[low + 1]) <= ind; ++low);
+
+    const Block &block = blocks_[low];
+    ind -= low * kBitPerBlock - rankOf_(block);
+
+    size_t word = 0;
+    if (ind >= 4 * kBlockSize - count4Of_(block))
+    {
+        word = 4;
+        ind -= 4 * kBlockSize - count4Of_(block);
+    }
+    else if (ind >= 2 * kBlockSize - count2Of_(block))
+    {
+        word = 2;
+        ind -= 2 * kBlockSize - count2Of_(block);
+    }
+
+    for (size_t count; ind >= (count = kBlockSize - SuccinctUtils::popcount(block.bits_[word])); ++word)
+    {
+        ind -= count;
+    }
+
+    return low * kBitPerBlock + word * kBlockSize + selectWord_(~block.bits_[word], ind);
+}
+
+size_t CBitV::select1(size_t ind) const
+{
+    __assert(support_select_ && ind < one_count_);
+
+    size_t low = select_one_inds_[ind / kSelectSample];
+    size_t high = select_one_inds_[ind / kSelectSample + 1];
+
+    // the last block with no more than ind ones before it, first guessed
+    // as if the ones were spread evenly between the samples
+    if (low + kSelectLinearFallback < high)
+    {
+        size_t mid = low + (high - low) * (ind % kSelectSample) / kSelectSample;
+        if (rankOf_(blocks_[mid]) <= ind)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+    while (low + kSelectLinearFallback < high)
+    {
+        size_t mid = low + (high - low + 1) / 2;
+        if (rankOf_(blocks_[mid]) <= ind)
+            low = mid;
+        else
+            high = mid - 1;
+    }
+    for (; low < high && rankOf_(blocks_[low + 1]) <= ind; ++low);
+
+    const Block &block = blocks_[low];
+    ind -= rankOf_(block);
+
+    size_t word = 0;
+    if (ind >= count4Of_(block))
+    {
+        word = 4;
+        ind -= count4Of_(block);
+    }
+    else if (ind >= count2Of_(block))
+    {
+        word = 2;
+        ind -= count2Of_(block);
+    }
+
+    for (size_t count; ind >= (count = SuccinctUtils::popcount(block.bits_[word])); ++word)
+    {
+        ind -= count;
+    }
+
+    return low * kBitPerBlock + word * kBlockSize + selectWord_(block.bits_[word], ind);
+}
+
+size_t CBitV::select(size_t ind, bool bit) const
+{
+    return bit ? select1(ind) : select0(ind);
+}
+
+void CBitV::save(std::ostream &os) const
+{
+    os.write((const char *)&support_select_, sizeof(support_select_));
+    os.write((const char *)&len_, sizeof(len_));
+    os.write((const char *)&one_count_, sizeof(one_count_));
+
+    if (blocks_)
+    {
+        os.write((const char *)&blocks_[0], blockNum_() * sizeof(blocks_[0]));
+    }
+    else
+    {
+        Block empty = Block();
+        os.write((const char *)&empty, sizeof(empty));
+    }
+
+    if (support_select_)
+    {
+        select_one_inds_.save(os);
+        select_zero_inds_.save(os);
+    }
+}
+
+void CBitV::load(std::istream &is)
+{
+    clear();
+
+    is.read((char *)&support_select_, sizeof(support_select_));
+    is.read((char *)&len_, sizeof(len_));
+    is.read((char *)&one_count_, sizeof(one_count_));
+
+    size_t size = blockNum_();
+    blocks_.reset(cachealign_alloc<Block>(size), cachealign_deleter());
+    is.read((char *)&blocks_[0], size * sizeof(blocks_[0]));
+
+    if (support_select_)
+    {
+        select_one_inds_.load(is);
+        select_zero_inds_.load(is);
+    }
+}
+
+void CBitV::saveAligned(AlignedWriter &writer) const
+{
+    writer.write(support_select_);
+    writer.write(len_);
+    writer.write(one_count_);
+
+    if (blocks_)
+    {
+        writer.writeArray(blocks_.get(), blockNum_());
+    }
+    else
+    {
+        Block empty = Block();
+        writer.writeArray(&empty, 1);
+    }
+
+    if (support_select_)
+    {
+        select_one_inds_.saveAligned(writer);
+        select_zero_inds_.saveAligned(writer);
+    }
+}
+
+void CBitV::map(MappedReader &reader)
+{
+    clear();
+
+    reader.read(support_select_);
+    reader.read(len_);
+    reader.read(one_count_);
+
+    size_t size = 0;
+    const Block *blocks = reader.readArray<Block>(size);
+    blocks_.reset(const_cast<Block *>(blocks), MappedRegionHolder(reader.region()));
+
+    if (support_select_)
+    {
+        select_one_inds_.map(reader);
+        select_zero_inds_.map(reader);
+    }
+}
+
+size_t CBitV::allocSize() const
+{
+    return sizeof(CBitV)
+        + sizeof(blocks_[0]) * (blocks_ ? blockNum_() : 0)
+        + sizeof(select_one_inds_[0]) * select_one_inds_.size()
+        + sizeof(select_zero_inds_[0]) * select_zero_inds_.size();
+}
+
+}
+}
+
+NS_IZENELIB_AM_END
@@ -63,14 +63,8 @@ void DBitV::build(const std::vector<uint64_t> &bv, size_t len)
         select_one_inds_.push_back(len_ / kSuperBlockSize + 1);
         select_zero_inds_.push_back(len_ / kSuperBlockSize + 1);
 
-        if (select_one_inds_.capacity() > select_one_inds_.size())
-        {
-            std::vector<size_t>(select_one_inds_).swap(select_one_inds_);
-        }
-        if (select_zero_inds_.capacity() > select_zero_inds_.size())
-        {
-            std::vector<size_t>(select_zero_inds_).swap(select_zero_inds_);
-        }
+        select_one_inds_.shrink();
+        select_zero_inds_.shrink();
     }
 }
 
@@ -107,8 +101,8 @@ void DBitV::clear()
 
     if (support_select_)
     {
-        std::vector<size_t>().swap(select_one_inds_);
-        std::vector<size_t>().swap(select_zero_inds_);
+        select_one_inds_.clear();
+        select_zero_inds_.clear();
     }
 }
 
@@ -253,8 +247,8 @@ void DBitV::save(std::ostream &os) const
 
     if (support_select_)
     {
-        SuccinctUtils::saveVec(os, select_one_inds_);
-        SuccinctUtils::saveVec(os, select_zero_inds_);
+        select_one_inds_.save(os);
+        select_zero_inds_.save(os);
     }
 }
 
@@ -271,8 +265,42 @@ void DBitV::load(std::istream &is)
 
     if (support_select_)
     {
-        SuccinctUtils::loadVec(is, select_one_inds_);
-        SuccinctUtils::loadVec(is, select_zero_inds_);
+        select_one_inds_.load(is);
+        select_zero_inds_.load(is);
+    }
+}
+
+void DBitV::saveAligned(AlignedWriter &writer) const
+{
+    writer.write(support_select_);
+    writer.write(len_);
+    writer.write(one_count_);
+
+    writer.writeArray(super_blocks_.get(), len_ / kSuperBlockSize + 1);
+
+    if (support_select_)
+    {
+        select_one_inds_.saveAligned(writer);
+        select_zero_inds_.saveAligned(writer);
+    }
+}
+
+void DBitV::map(MappedReader &reader)
+{
+    clear();
+
+    reader.read(support_select_);
+    reader.read(len_);
+    reader.read(one_count_);
+
+    size_t size = 0;
+    const SuperBlock *super_blocks = reader.readArray<SuperBlock>(size);
+    super_blocks_.reset(const_cast<SuperBlock *>(super_blocks), MappedRegionHolder(reader.region()));
+
+    if (support_select_)
+    {
+        select_one_inds_.map(reader);
+        select_zero_inds_.map(reader);
     }
 }
 
@@ -76,24 +76,15 @@ void RSDic::build(const std::vector<uint64_t>& bv, size_t len)
         buildBlock_(bv[index] & ((1ULL << offset) - 1), offset, rank_blocks_[rb_index].subrank_[rb_offset], global_offset);
     }
 
-    if (bits_.capacity() > bits_.size())
-    {
-        std::vector<uint64_t>(bits_).swap(bits_);
-    }
+    bits_.shrink();
 
     if (support_select_)
     {
         select_one_inds_.push_back(num_ / kLargeBlockSize + 1);
         select_zero_inds_.push_back(num_ / kLargeBlockSize + 1);
 
-        if (select_one_inds_.capacity() > select_one_inds_.size())
-        {
-            std::vector<size_t>(select_one_inds_).swap(select_one_inds_);
-        }
-        if (select_zero_inds_.capacity() > select_zero_inds_.size())
-        {
-            std::vector<size_t>(select_zero_inds_).swap(select_zero_inds_);
-        }
+        select_one_inds_.shrink();
+        select_zero_inds_.shrink();
     }
 }
 
@@ -124,8 +115,11 @@ void RSDic::buildBlock_(uint64_t block, size_t offset, uint8_t& rank_sb, size_t&
     {
         bits_.push_back(0);
     }
-    SuccinctUtils::SetSlice(bits_, global_offset, len, code);
-    global_offset += len;
+    if (len > 0)
+    {
+        SuccinctUtils::SetSlice(&bits_[0], global_offset, len, code);
+        global_offset += len;
+    }
 }
 
 void RSDic::clear()
@@ -133,13 +127,13 @@ void RSDic::clear()
     num_ = 0;
     one_num_ = 0;
 
-    std::vector<uint64_t>().swap(bits_);
+    bits_.clear();
     rank_blocks_.reset();
 
     if (support_select_)
     {
-        std::vector<size_t>().swap(select_one_inds_);
-        std::vector<size_t>().swap(select_zero_inds_);
+        select_one_inds_.clear();
+        select_zero_inds_.clear();
     }
 }
 
@@ -158,7 +152,7 @@ bool RSDic::access(size_t pos) const
     }
     size_t rank_sb = rb.subrank_[sblock];
 
-    return EnumCoder::GetBit(SuccinctUtils::GetSlice(bits_, pointer, EnumCoder::Len(rank_sb)), rank_sb, pos % kBlockSize);
+    return EnumCoder::GetBit(SuccinctUtils::GetSlice(bits_.data(), pointer, EnumCoder::Len(rank_sb)), rank_sb, pos % kBlockSize);
 }
 
 bool RSDic::access(size_t pos, size_t& rank) const
@@ -180,7 +174,7 @@ bool RSDic::access(size_t pos, size_t& rank) const
     }
     rank_sb = rb.subrank_[sblock];
 
-    bool bit = EnumCoder::GetBit(SuccinctUtils::GetSlice(bits_, pointer, EnumCoder::Len(rank_sb)), rank_sb, pos % kBlockSize, rank_sb);
+    bool bit = EnumCoder::GetBit(SuccinctUtils::GetSlice(bits_.data(), pointer, EnumCoder::Len(rank_sb)), rank_sb, pos % kBlockSize, rank_sb);
     rank = bit ? rank + rank_sb : pos - rank - rank_sb;
     return bit;
 }
@@ -209,7 +203,7 @@ size_t RSDic::rank1(size_t pos) const
     }
     rank_sb = rb.subrank_[sblock];
 
-    return rank + EnumCoder::Rank(SuccinctUtils::GetSlice(bits_, pointer, EnumCoder::Len(rank_sb)), rank_sb, pos % kBlockSize);
+    return rank + EnumCoder::Rank(SuccinctUtils::GetSlice(bits_.data(), pointer, EnumCoder::Len(rank_sb)), rank_sb, pos % kBlockSize);
 }
 
 size_t RSDic::rank(size_t pos, bool bit) const
@@ -250,7 +244,7 @@ size_t RSDic::select0(size_t ind) const
         pointer += EnumCoder::Len(rank_sb);
     }
 
-    return low * kLargeBlockSize + sblock * kBlockSize + EnumCoder::Select(SuccinctUtils::GetSlice(bits_, pointer, EnumCoder::Len(rank_sb)), rank_sb, ind, false);
+    return low * kLargeBlockSize + sblock * kBlockSize + EnumCoder::Select(SuccinctUtils::GetSlice(bits_.data(), pointer, EnumCoder::Len(rank_sb)), rank_sb, ind, false);
 }
 
 size_t RSDic::select1(size_t ind) const
@@ -286,7 +280,7 @@ size_t RSDic::select1(size_t ind) const
         pointer += EnumCoder::Len(rank_sb);
     }
 
-    return low * kLargeBlockSize + sblock * kBlockSize + EnumCoder::Select(SuccinctUtils::GetSlice(bits_, pointer, EnumCoder::Len(rank_sb)), rank_sb, ind, true);
+    return low * kLargeBlockSize + sblock * kBlockSize + EnumCoder::Select(SuccinctUtils::GetSlice(bits_.data(), pointer, EnumCoder::Len(rank_sb)), rank_sb, ind, true);
 }
 
 size_t RSDic::select(size_t ind, bool bit) const
@@ -300,15 +294,15 @@ void RSDic::save(std::ostream& os) const
     os.write((const char*)&num_, sizeof(num_));
     os.write((const char*)&one_num_, sizeof(one_num_));
 
-    SuccinctUtils::saveVec(os, bits_);
+    bits_.save(os);
 
     size_t size = num_ / kLargeBlockSize + 1;
     os.write((const char *)&rank_blocks_[0], size * sizeof(rank_blocks_[0]));
 
     if (support_select_)
     {
-        SuccinctUtils::saveVec(os, select_one_inds_);
-        SuccinctUtils::saveVec(os, select_zero_inds_);
+        select_one_inds_.save(os);
+        select_zero_inds_.save(os);
     }
 }
 
@@ -318,7 +312,7 @@ void RSDic::load(std::istream& is)
     is.read((char*)&num_, sizeof(num_));
     is.read((char*)&one_num_, sizeof(one_num_));
 
-    SuccinctUtils::loadVec(is, bits_);
+    bits_.load(is);
 
     size_t size = num_ / kLargeBlockSize + 1;
     rank_blocks_.reset(cachealign_alloc<RankBlock>(size), cachealign_deleter());
@@ -327,8 +321,45 @@ void RSDic::load(std::istream& is)
 
     if (support_select_)
     {
-        SuccinctUtils::loadVec(is, select_one_inds_);
-        SuccinctUtils::loadVec(is, select_zero_inds_);
+        select_one_inds_.load(is);
+        select_zero_inds_.load(is);
+    }
+}
+
+void RSDic::saveAligned(AlignedWriter& writer) const
+{
+    writer.write(support_select_);
+    writer.write(num_);
+    writer.write(one_num_);
+
+    bits_.saveAligned(writer);
+    writer.writeArray(rank_blocks_.get(), num_ / kLargeBlockSize + 1);
+
+    if (support_select_)
+    {
+        select_one_inds_.saveAligned(writer);
+        select_zero_inds_.saveAligned(writer);
+    }
+}
+
+void RSDic::map(MappedReader& reader)
+{
+    clear();
+
+    reader.read(support_select_);
+    reader.read(num_);
+    reader.read(one_num_);
+
+    bits_.map(reader);
+
+    size_t size = 0;
+    const RankBlock* rank_blocks = reader.readArray<RankBlock>(size);
+    rank_blocks_.reset(const_cast<RankBlock*>(rank_blocks), MappedRegionHolder(reader.region()));
+
+    if (support_select_)
+    {
+        select_one_inds_.map(reader);
+        select_zero_inds_.map(reader);
     }
 }
 
@@ -107,8 +107,8 @@ void SDArray::build()
 
 void SDArray::clear()
 {
-    std::vector<size_t>().swap(Ltable_);
-    std::vector<size_t>().swap(B_);
+    Ltable_.clear();
+    B_.clear();
     size_ = 0;
     sum_  = 0;
 }
@@ -214,11 +214,9 @@ void SDArray::save(std::ostream& os) const
     os.write((const char *)&size_, sizeof(size_));
     os.write((const char *)&sum_, sizeof(sum_));
 
-    os.write((const char *)&Ltable_[0],  sizeof(Ltable_[0]) * Ltable_.size());
+    os.write((const char *)Ltable_.data(),  sizeof(Ltable_[0]) * Ltable_.size());
 
-    size_t Bsize = B_.size();
-    os.write((const char *)&Bsize, sizeof(Bsize));
-    os.write((const char *)&B_[0],  sizeof(B_[0]) * B_.size());
+    B_.save(os);
 }
 
 void SDArray::load(std::istream& is)
@@ -238,6 +236,26 @@ void SDArray::load(std::istream& is)
     is.read((char *)&B_[0], sizeof(B_[0]) * B_.size());
 }
 
+void SDArray::saveAligned(AlignedWriter& writer) const
+{
+    writer.write(size_);
+    writer.write(sum_);
+
+    Ltable_.saveAligned(writer);
+    B_.saveAligned(writer);
+}
+
+void SDArray::map(MappedReader& reader)
+{
+    clear();
+
+    reader.read(size_);
+    reader.read(sum_);
+
+    Ltable_.map(reader);
+    B_.map(reader);
+}
+
 void SDArray::packHighs_(size_t begPos, size_t width)
 {
     size_t pos;
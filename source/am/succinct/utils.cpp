@@ -101,6 +101,20 @@ const uint8_t SuccinctUtils::kBitReverseTable_[256] =
 
 uint64_t SuccinctUtils::GetSlice(const std::vector<uint64_t>& bits,
                          size_t pos, size_t len)
+{
+    if (len == 0) return 0;
+    return GetSlice(&bits[0], pos, len);
+}
+
+void SuccinctUtils::SetSlice(std::vector<uint64_t>& bits,
+                     size_t pos, size_t len, uint64_t val)
+{
+    if (len == 0) return;
+    SetSlice(&bits[0], pos, len, val);
+}
+
+uint64_t SuccinctUtils::GetSlice(const uint64_t* bits,
+                         size_t pos, size_t len)
 {
     if (len == 0) return 0;
     size_t block = pos / kBlockSize;
@@ -114,7 +128,7 @@ uint64_t SuccinctUtils::GetSlice(const std::vector<uint64_t>& bits,
     return ret & ((1ULL << len) - 1);
 }
 
-void SuccinctUtils::SetSlice(std::vector<uint64_t>& bits,
+void SuccinctUtils::SetSlice(uint64_t* bits,
                      size_t pos, size_t len, uint64_t val)
 {
     if (len == 0) return;
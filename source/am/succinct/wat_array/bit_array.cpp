@@ -57,8 +57,8 @@ void BitArray::Init(uint64_t length)
 
 void BitArray::Clear()
 {
-    std::vector<uint64_t>().swap(bit_blocks_);
-    std::vector<uint64_t>().swap(rank_tables_);
+    bit_blocks_.clear();
+    rank_tables_.clear();
     length_ = 0;
     one_num_ = 0;
 }
@@ -234,7 +234,7 @@ void BitArray::PrintForDebug(std::ostream& os) const
 void BitArray::Save(std::ostream& os) const
 {
     os.write((const char*)(&length_), sizeof(length_));
-    os.write((const char*)(&bit_blocks_[0]), sizeof(bit_blocks_[0]) * bit_blocks_.size());
+    os.write((const char*)(bit_blocks_.data()), sizeof(bit_blocks_[0]) * bit_blocks_.size());
 }
 
 void BitArray::Load(std::istream& is)
@@ -246,4 +246,21 @@ void BitArray::Load(std::istream& is)
     Build();
 }
 
+void BitArray::SaveAligned(AlignedWriter& writer) const
+{
+    writer.write(length_);
+    writer.write(one_num_);
+    bit_blocks_.saveAligned(writer);
+    rank_tables_.saveAligned(writer);
+}
+
+void BitArray::Map(MappedReader& reader)
+{
+    Clear();
+    reader.read(length_);
+    reader.read(one_num_);
+    bit_blocks_.map(reader);
+    rank_tables_.map(reader);
+}
+
 }
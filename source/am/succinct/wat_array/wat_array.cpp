@@ -532,4 +532,65 @@ void WatArray::Load(istream& is)
     occs_.Build();
 }
 
+void WatArray::SaveAligned(ostream& os) const
+{
+    AlignedWriter writer(os);
+    writer.writeHeader();
+    SaveAligned(writer);
+}
+
+void WatArray::SaveAligned(AlignedWriter& writer) const
+{
+    writer.write(alphabet_num_);
+    writer.write(length_);
+    for (size_t i = 0; i < bit_arrays_.size(); ++i)
+    {
+        bit_arrays_[i].SaveAligned(writer);
+    }
+    occs_.SaveAligned(writer);
+}
+
+bool WatArray::Map(const string& path)
+{
+    MappedRegionPtr region(new MappedRegion);
+    if (!region->open(path))
+    {
+        return false;
+    }
+
+    MappedReader reader(region);
+    if (!reader.readHeader())
+    {
+        return false;
+    }
+
+    // mapped aside, so that a truncated file leaves the status unchanged
+    WatArray mapped;
+    try
+    {
+        mapped.Map(reader);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+    *this = mapped;
+    return true;
+}
+
+void WatArray::Map(MappedReader& reader)
+{
+    Clear();
+    reader.read(alphabet_num_);
+    alphabet_bit_num_ = Log2(alphabet_num_);
+    reader.read(length_);
+
+    bit_arrays_.resize(alphabet_bit_num_);
+    for (size_t i = 0; i < bit_arrays_.size(); ++i)
+    {
+        bit_arrays_[i].Map(reader);
+    }
+    occs_.Map(reader);
+}
+
 }
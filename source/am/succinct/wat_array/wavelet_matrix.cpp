@@ -502,4 +502,86 @@ void WaveletMatrix::Load(istream& is)
     SetBitReverseTable();
 }
 
+void WaveletMatrix::SaveAligned(ostream& os) const
+{
+    AlignedWriter writer(os);
+    writer.writeHeader();
+    SaveAligned(writer);
+}
+
+void WaveletMatrix::SaveAligned(AlignedWriter& writer) const
+{
+    writer.write(alphabet_num_);
+    writer.write(length_);
+    for (size_t i = 0; i < bit_arrays_.size(); ++i)
+    {
+        bit_arrays_[i].SaveAligned(writer);
+    }
+    for (size_t i = 0; i < bit_arrays_.size(); ++i)
+    {
+        writer.writeArray(&node_begin_pos_[i][0], node_begin_pos_[i].size());
+    }
+}
+
+bool WaveletMatrix::Map(const string& path)
+{
+    MappedRegionPtr region(new MappedRegion);
+    if (!region->open(path))
+    {
+        return false;
+    }
+
+    MappedReader reader(region);
+    if (!reader.readHeader())
+    {
+        return false;
+    }
+
+    // mapped aside, so that a truncated file leaves the status unchanged
+    WaveletMatrix mapped;
+    try
+    {
+        mapped.Map(reader);
+    }
+    catch (const std::exception&)
+    {
+        return false;
+    }
+    *this = mapped;
+    return true;
+}
+
+void WaveletMatrix::Map(MappedReader& reader)
+{
+    Clear();
+    reader.read(alphabet_num_);
+    alphabet_bit_num_ = Log2(alphabet_num_);
+    reader.read(length_);
+
+    bit_arrays_.resize(alphabet_bit_num_);
+    for (size_t i = 0; i < bit_arrays_.size(); ++i)
+    {
+        bit_arrays_[i].Map(reader);
+    }
+
+    // the node positions are small, and copied
+    node_begin_pos_.resize(bit_arrays_.size());
+    for (size_t i = 0; i < bit_arrays_.size(); ++i)
+    {
+        size_t size = 0;
+        const uint64_t* begin_pos = reader.readArray<uint64_t>(size);
+        if (size <= (1ULL << i))
+        {
+            throw std::out_of_range("WaveletMatrix: bad node positions");
+        }
+        node_begin_pos_[i].assign(begin_pos, begin_pos + size);
+    }
+    zero_counts_.resize(bit_arrays_.size());
+    for (size_t i = 0; i < bit_arrays_.size(); ++i)
+    {
+        zero_counts_[i] = node_begin_pos_[i][1 << i];
+    }
+    SetBitReverseTable();
+}
+
 }
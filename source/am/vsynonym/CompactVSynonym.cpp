@@ -0,0 +1,336 @@
+#include <am/vsynonym/CompactVSynonym.h>
+#include <am/succinct/marisa/iostream.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+#include <types.h>
+
+NS_IZENELIB_AM_BEGIN
+
+namespace {
+
+/** "VSYN" */
+const uint32_t COMPACT_VSYN_MAGIC = 0x4e595356;
+
+const uint32_t MORE_LONG_BIT = 0x80000000;
+
+/**
+ * the file starts with the header, then the entries of the keys and the
+ * entry lists, and the trie at the next 8 bytes
+ */
+struct CompactVSynHeader {
+    uint32_t magic;
+    uint32_t keyCount;
+    uint64_t valueLength;
+    uint64_t trieLength;
+};
+
+inline size_t trieOffset(size_t keyCount, size_t valueLength)
+{
+    size_t offset = sizeof(CompactVSynHeader) + keyCount * sizeof(uint32_t) + valueLength;
+    return (offset + 7) & ~(size_t)7;
+}
+
+}
+
+
+CompactVSynonymContainer::CompactVSynonymContainer()
+    : data_(NULL), dataSize_(0), entries_(NULL), value_(NULL)
+{
+}
+
+
+CompactVSynonymContainer::~CompactVSynonymContainer()
+{
+    close();
+}
+
+
+int CompactVSynonymContainer::build(VSynonymContainer& container, const char* path)
+{
+    // every word of the entry lists is a key, and the lists of the keys
+    // replaced by longer ones are left in the value
+    uint8_t* value = container.getValue();
+    size_t valueLength = container.getValueLength();
+    vector<string> keys;
+    for(size_t off = 1; off < valueLength; ){
+        VSynonym syn(value + off, false);
+        vtnum_t size = syn.size();
+        if(size == 0)
+            break;
+        for(vtnum_t i=0; i<syn.getOverlapCount(); ++i){
+            for(vtnum_t j=0; j<syn.getSynonymCount(i); ++j){
+                keys.push_back(syn.getWord(i, j));
+            }
+        }
+        off += size;
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    marisa::Trie trie;
+    try{
+        marisa::Keyset keyset;
+        for(size_t i=0; i<keys.size(); ++i){
+            keyset.push_back(keys[i].data(), keys[i].size());
+        }
+        // one trie with the largest cache, trading some space for the lookup time
+        trie.build(keyset, MARISA_MIN_NUM_TRIES | MARISA_HUGE_CACHE);
+    }catch(const marisa::Exception& e){
+        cerr << "Can't build the synonym trie: " << e.what() << endl;
+        return 0;
+    }
+
+    // copy the lists in use, by key id
+    vector<uint32_t> entries(keys.size());
+    vector<uint8_t> compactValue;
+    map<int, uint32_t> offsets;
+    VTrie* vtrie = container.getData();
+    marisa::Agent agent;
+    for(size_t i=0; i<keys.size(); ++i){
+        VTrieNode node;
+        if(!vtrie->search(keys[i].c_str(), &node) || node.data <= 0){
+            cerr << "Can't find the synonym key " << keys[i] << endl;
+            return 0;
+        }
+        map<int, uint32_t>::iterator it = offsets.find(node.data);
+        if(it == offsets.end()){
+            VSynonym syn(value + node.data, false);
+            it = offsets.insert(make_pair(node.data, (uint32_t)compactValue.size())).first;
+            compactValue.insert(compactValue.end(), value + node.data,
+                    value + node.data + syn.size());
+        }
+
+        agent.set_query(keys[i].data(), keys[i].size());
+        trie.lookup(agent);
+        uint32_t entry = it->second;
+        // the keys with the prefix follow it in the sorted keys
+        if(i + 1 < keys.size() && keys[i + 1].compare(0, keys[i].size(), keys[i]) == 0)
+            entry |= MORE_LONG_BIT;
+        entries[agent.key().id()] = entry;
+    }
+    if(compactValue.size() >= MORE_LONG_BIT){
+        cerr << "Too many synonyms to build into " << path << endl;
+        return 0;
+    }
+
+    std::ofstream fout(path, std::ios::binary);
+    if(fout.fail()){
+        cerr << "Can't open " << path << " file." << endl;
+        return 0;
+    }
+    CompactVSynHeader header;
+    header.magic = COMPACT_VSYN_MAGIC;
+    header.keyCount = keys.size();
+    header.valueLength = compactValue.size();
+    header.trieLength = trie.io_size();
+    fout.write((const char*)&header, sizeof(header));
+    if(!entries.empty())
+        fout.write((const char*)&entries[0], entries.size() * sizeof(uint32_t));
+    if(!compactValue.empty())
+        fout.write((const char*)&compactValue[0], compactValue.size());
+    size_t end = sizeof(header) + entries.size() * sizeof(uint32_t) + compactValue.size();
+    static const char padding[8] = {0};
+    fout.write(padding, trieOffset(keys.size(), compactValue.size()) - end);
+    try{
+        marisa::write(fout, trie);
+    }catch(const marisa::Exception& e){
+        cerr << "Can't write the synonym trie: " << e.what() << endl;
+        return 0;
+    }
+    fout.close();
+    return fout.fail() ? 0 : 1;
+}
+
+
+int CompactVSynonymContainer::load(const char* path)
+{
+    close();
+
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0){
+        cerr << "Can't open " << path << " file." << endl;
+        return 0;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CompactVSynHeader)){
+        cerr << "Invalid synonym file " << path << endl;
+        ::close(fd);
+        return 0;
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(data == MAP_FAILED){
+        cerr << "Can't map " << path << " file." << endl;
+        return 0;
+    }
+    data_ = (uint8_t*)data;
+    dataSize_ = st.st_size;
+
+    const CompactVSynHeader* header = (const CompactVSynHeader*)data_;
+    size_t offset = trieOffset(header->keyCount, header->valueLength);
+    if(header->magic != COMPACT_VSYN_MAGIC || offset + header->trieLength != dataSize_){
+        cerr << "Invalid synonym file " << path << endl;
+        close();
+        return 0;
+    }
+    try{
+        trie_.map(data_ + offset, header->trieLength);
+    }catch(const marisa::Exception& e){
+        cerr << "Invalid synonym trie in " << path << ": " << e.what() << endl;
+        close();
+        return 0;
+    }
+    if(trie_.num_keys() != header->keyCount){
+        cerr << "Invalid synonym file " << path << endl;
+        close();
+        return 0;
+    }
+
+    entries_ = (const uint32_t*)(data_ + sizeof(CompactVSynHeader));
+    value_ = data_ + sizeof(CompactVSynHeader) + header->keyCount * sizeof(uint32_t);
+    return 1;
+}
+
+
+void CompactVSynonymContainer::close()
+{
+    trie_.clear();
+    if(data_){
+        munmap(data_, dataSize_);
+    }
+    data_ = NULL;
+    dataSize_ = 0;
+    entries_ = NULL;
+    value_ = NULL;
+}
+
+
+void CompactVSynonymContainer::setSynonym(size_t keyId, VSynonym& synonym) const
+{
+    uint32_t entry = entries_[keyId];
+    synonym.setData(value_ + (entry & ~MORE_LONG_BIT));
+    synonym.setMoreLong(entry & MORE_LONG_BIT);
+}
+
+
+bool CompactVSynonymContainer::get_synonyms(const string& key, VSynonym& synonym) const
+{
+    if(data_){
+        marisa::Agent agent;
+        agent.set_query(key.data(), key.size());
+        if(trie_.lookup(agent)){
+            setSynonym(agent.key().id(), synonym);
+            return true;
+        }
+    }
+    synonym.setData(0);
+    synonym.setMoreLong(false);
+    return false;
+}
+
+
+size_t CompactVSynonymContainer::longestMatch(const char* str, size_t len, VSynonym& synonym) const
+{
+    size_t matchLen = 0;
+    synonym.setData(0);
+    synonym.setMoreLong(false);
+    if(!data_)
+        return 0;
+
+    marisa::Agent agent;
+    agent.set_query(str, len);
+    while(trie_.common_prefix_search(agent)){
+        matchLen = agent.key().length();
+        setSynonym(agent.key().id(), synonym);
+    }
+    return matchLen;
+}
+
+
+void CompactVSynonymContainer::commonPrefixSearch(const char* str, size_t len,
+        vector<pair<size_t, VSynonym> >& matches) const
+{
+    if(!data_)
+        return;
+
+    marisa::Agent agent;
+    agent.set_query(str, len);
+    while(trie_.common_prefix_search(agent)){
+        VSynonym synonym;
+        setSynonym(agent.key().id(), synonym);
+        matches.push_back(make_pair(agent.key().length(), synonym));
+    }
+}
+
+
+VExpandedQuery* CompactVSynonymContainer::expandQuery(const string& query) const
+{
+    VExpandedQuery *ret = new VExpandedQuery();
+    string lower = toLower(query);
+    vector<size_t>* tokens1 = findTokens(lower, true);
+    vector<size_t>& tokens = *tokens1;
+    size_t size = tokens.size();
+
+    // the ith token ends at tokens[i], inclusive, from the end of the last one
+    size_t start = 1;
+    size_t lastEndIndex = 0; //exclude
+    vector<pair<size_t, VSynonym> > matches;
+    while(start < size && data_){
+        size_t subStartIndex = start == 1 ? 0 : tokens[start-1] + 1;
+        matches.clear();
+        commonPrefixSearch(lower.data() + subStartIndex, lower.size() - subStartIndex, matches);
+
+        // the longest key ending at a token
+        size_t end = 0;
+        for(size_t i = matches.size(); i > 0; --i){
+            size_t last = subStartIndex + matches[i-1].first - 1;
+            vector<size_t>::iterator it = std::lower_bound(
+                    tokens.begin() + start, tokens.end(), last);
+            if(it != tokens.end() && *it == last){
+                end = it - tokens.begin();
+                if(lastEndIndex < subStartIndex){
+                    ret->addUnit(new VSynRetUnit(
+                        new string(query.substr(lastEndIndex, subStartIndex-lastEndIndex))));
+                }
+                lastEndIndex = last + 1;
+                ret->addUnit(new VSynRetUnit(new VSynonym(matches[i-1].second)));
+                break;
+            }
+        }
+
+        if(end == 0)
+            ++start;
+        else
+            start = end + 1;
+    }
+
+    if(lastEndIndex < query.length()){
+        ret->addUnit(new VSynRetUnit(
+                    new string(query.substr(lastEndIndex, query.length()-lastEndIndex))));
+    }
+
+    delete tokens1;
+    return ret;
+}
+
+
+size_t CompactVSynonymContainer::keyCount() const
+{
+    return data_ ? trie_.num_keys() : 0;
+}
+
+
+size_t CompactVSynonymContainer::size() const
+{
+    return dataSize_;
+}
+
+NS_IZENELIB_AM_END
@@ -216,7 +216,7 @@ ostream& operator << ( ostream& sout, VExpandedQuery& query )
     vector<VSynRetUnit*> *data = query.data_;
     int size = data->size();
     for(int i=0; i<size; ++i){
-        cout<<*((*data)[i]);
+        sout<<*((*data)[i]);
         if(i != size - 1)
             sout<<" | ";
     }
@@ -383,6 +383,18 @@ VTrie* VSynonymContainer::getData()
 }
 
 
+uint8_t* VSynonymContainer::getValue()
+{
+    return value_;
+}
+
+
+size_t VSynonymContainer::getValueLength()
+{
+    return endValPtr_ - value_;
+}
+
+
 int VSynonymContainer::loadSynonym(const char* pathDic)
 {
     if( synonymDelim_ == wordDelim_){
@@ -323,6 +323,8 @@ void BarrelsInfo::read(Directory* pDirectory, const char* name)
                         pBarrelInfo->compressType = BLOCK;
                     else if(pItem->getValue().compare("chunk") == 0)
                         pBarrelInfo->compressType = CHUNK;
+                    else if(pItem->getValue().compare("simdblock") == 0)
+                        pBarrelInfo->compressType = SIMD_BLOCK;
                 }
                 
                 barrelInfos.push_back(pBarrelInfo);
@@ -445,6 +447,9 @@ void BarrelsInfo::write(Directory* pDirectory)
         case CHUNK:
             str = "chunk";
             break;
+        case SIMD_BLOCK:
+            str = "simdblock";
+            break;
         default:
             assert(false);
          }
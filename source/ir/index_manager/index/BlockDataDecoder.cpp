@@ -12,7 +12,7 @@ namespace indexmanager
  **************************************************************************************************************************************************************/
 ChunkDecoder::ChunkDecoder() :
         num_docs_(0), curr_document_offset_(0), prev_document_offset_(0), curr_position_offset_(0), prev_decoded_doc_id_(0), num_positions_(0),
-        curr_buffer_position_(NULL), decoded_(false), pos_decoded_(false), doc_deleted_(false)
+        curr_buffer_position_(NULL), decoded_(false), pos_decoded_(false), doc_deleted_(false), simd_(false)
 {
 }
 
@@ -40,8 +40,18 @@ void ChunkDecoder::set_pos_buffer(uint32_t* pos_buffer)
 
 void ChunkDecoder::decodeDocIds()
 {
-    int num_words_consumed = doc_id_decompressor_.decompress(const_cast<uint32_t*> (curr_buffer_position_), doc_ids_, num_docs_);
-    post_process_chunk(doc_ids_, num_docs_);
+    int num_words_consumed;
+    if (simd_ && num_docs_ == CHUNK_SIZE)
+    {
+        // the prefix sum of the d-gaps is done while unpacking
+        num_words_consumed = SIMDChunkPacker::unpackPrefixSum(curr_buffer_position_, doc_ids_, prev_decoded_doc_id_);
+        prev_decoded_doc_id_ = doc_ids_[num_docs_ - 1];
+    }
+    else
+    {
+        num_words_consumed = doc_id_decompressor_.decompress(const_cast<uint32_t*> (curr_buffer_position_), doc_ids_, num_docs_);
+        post_process_chunk(doc_ids_, num_docs_);
+    }
     curr_buffer_position_ += num_words_consumed;
     decoded_ = true;
 #ifdef DEBUG
@@ -54,7 +64,10 @@ void ChunkDecoder::decodeDocIds()
 
 void ChunkDecoder::decodeFrequencies(bool computePos)
 {
-    curr_buffer_position_ += frequency_decompressor_.decompress(const_cast<uint32_t*> (curr_buffer_position_), frequencies_, num_docs_);
+    if (simd_ && num_docs_ == CHUNK_SIZE)
+        curr_buffer_position_ += SIMDChunkPacker::unpack(curr_buffer_position_, frequencies_, 1);
+    else
+        curr_buffer_position_ += frequency_decompressor_.decompress(const_cast<uint32_t*> (curr_buffer_position_), frequencies_, num_docs_);
 
     if (computePos)
     {
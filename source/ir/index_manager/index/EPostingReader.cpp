@@ -22,13 +22,15 @@ namespace indexmanager{
 BlockPostingReader::BlockPostingReader(
         InputDescriptor* pInputDescriptor,
         const TermInfo& termInfo,
-        IndexLevel type)
+        IndexLevel type,
+        CompressionType compressType)
     : inputDescriptorPtr_(pInputDescriptor)
     , pListingCache_(0)
     , pDocFilter_(0)
     , urgentBuffer_(0)
     , compressedPos_(0)
 {
+    blockDecoder_.set_simd(compressType == SIMD_BLOCK);
     reset(termInfo);
     if (type == WORDLEVEL)
     {
@@ -11,7 +11,8 @@ namespace indexmanager{
 
 BlockPostingWriter::BlockPostingWriter(
     boost::shared_ptr<MemCache> pCache,
-    IndexLevel indexLevel
+    IndexLevel indexLevel,
+    CompressionType compressType
 )
     :pMemCache_(pCache)
     ,current_nocomp_block_pointer_(0)
@@ -31,6 +32,7 @@ BlockPostingWriter::BlockPostingWriter(
     pSkipListWriter_ = new FixedBlockSkipListWriter(pCache);
     curr_position_buffer_size_ = INIT_POS_CHUNK_SIZE;
     positions_ = (uint32_t*)malloc(curr_position_buffer_size_*sizeof(uint32_t));
+    chunk_.set_simd(compressType == SIMD_BLOCK);
 }
 
 BlockPostingWriter::~BlockPostingWriter()
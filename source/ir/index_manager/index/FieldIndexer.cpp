@@ -414,7 +414,8 @@ fileoffset_t FieldIndexer::write(OutputDescriptor* pWriterDesc)
             pPosting = new RTPostingWriter(pMemCache_, skipInterval_, maxSkipLevel_, indexLevel_);
             break;
         case BLOCK:
-            pPosting = new BlockPostingWriter(pMemCache_, indexLevel_);
+        case SIMD_BLOCK:
+            pPosting = new BlockPostingWriter(pMemCache_, indexLevel_, pIndexer_->getIndexCompressType());
             break;
         case CHUNK:
             pPosting = new ChunkPostingWriter(pMemCache_, skipInterval_, maxSkipLevel_, indexLevel_);
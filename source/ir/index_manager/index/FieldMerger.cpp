@@ -192,6 +192,7 @@ bool FieldMerger::initQueue()
                 pTermReader = new RTDiskTermReader(pDirectory_,pEntry->pBarrelInfo_,pEntry->pFieldInfo_, indexLevel_);
                 break;
             case BLOCK:
+            case SIMD_BLOCK:
                 pTermReader = new BlockTermReader(pDirectory_,pEntry->pBarrelInfo_,pEntry->pFieldInfo_, indexLevel_);
                 break;
             case CHUNK:
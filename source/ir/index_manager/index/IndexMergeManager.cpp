@@ -1,4 +1,5 @@
 #include <boost/thread.hpp>
+#include <boost/bind.hpp>
 #include <cassert>
 
 #include <ir/index_manager/index/IndexMergeManager.h>
@@ -16,7 +17,8 @@ IndexMergeManager::IndexMergeManager(Indexer* pIndexer)
     :pIndexer_(pIndexer)
     ,pBarrelsInfo_(NULL)
     ,pAddMerger_(NULL)
-    ,pMergeThread_(NULL)
+    ,pMergePool_(NULL)
+    ,mergeGeneration_(0)
     ,isPauseMerge_(false)
     ,isAsync_(pIndexer->getIndexManagerConfig()->mergeStrategy_.isAsync_)
 {
@@ -29,7 +31,7 @@ IndexMergeManager::IndexMergeManager(Indexer* pIndexer)
         pAddMerger_ = new IndexMerger(pIndexer_, new BTPolicy);
 
     if(isAsync_)
-        run();
+        pMergePool_ = new izenelib::util::task_pool(1);
 }
 
 IndexMergeManager::~IndexMergeManager()
@@ -40,44 +42,25 @@ IndexMergeManager::~IndexMergeManager()
     if(isAsync_)
     {
         boost::lock_guard<boost::mutex> lock(mergeThreadMutex_);
-        tasks_.clear();
-        joinMergeThread();
+        ++mergeGeneration_;
+
+        DVLOG(2) << "IndexMergeManager::~IndexMergeManager() => delete pMergePool_...";
+        delete pMergePool_;
+        pMergePool_ = NULL;
+        DVLOG(2) << "IndexMergeManager::~IndexMergeManager() <= delete pMergePool_";
     }
 
     if(pAddMerger_)
         delete pAddMerger_;
 }
 
-void IndexMergeManager::run()
-{
-    assert(isAsync_ && "to create the merge thread, IndexManagerConfig._mergestrategy.isAsync_ should be configured to true");
-    assert(! pMergeThread_ && "the merge thread should not be running before");
-    pMergeThread_ = new boost::thread(boost::bind(&IndexMergeManager::mergeIndex, this));
-}
-
-void IndexMergeManager::joinMergeThread()
-{
-    assert(isAsync_);
-
-    MergeOP op(EXIT_MERGE);
-    tasks_.push(op);
-
-    DVLOG(2) << "IndexMergeManager::joinMergeThreadImpl() => pMergeThread_->join()...";
-    pMergeThread_->join();
-    DVLOG(2) << "IndexMergeManager::joinMergeThreadImpl() <= pMergeThread_->join()";
-
-    delete pMergeThread_;
-    pMergeThread_ = NULL;
-}
-
 void IndexMergeManager::waitForMergeFinish()
 {
     DVLOG(2) << "=> IndexMergeManager::waitForMergeFinish()";
     if(isAsync_)
     {
         boost::lock_guard<boost::mutex> lock(mergeThreadMutex_);
-        joinMergeThread();
-        run();
+        pMergePool_->wait();
     }
     DVLOG(2) << "<= IndexMergeManager::waitForMergeFinish()";
 }
@@ -86,9 +69,8 @@ void IndexMergeManager::addToMerge(BarrelInfo* pBarrelInfo)
 {
     if(isAsync_)
     {
-        MergeOP op(ADD_BARREL);
-        op.pBarrelInfo = pBarrelInfo;
-        tasks_.push(op);
+        pMergePool_->post(boost::bind(&IndexMergeManager::addToMergeTask,
+                                      this, pBarrelInfo, mergeGeneration_.load()));
     }
     else
     {
@@ -102,9 +84,10 @@ void IndexMergeManager::optimizeIndex()
     if(isAsync_)
     {
         boost::lock_guard<boost::mutex> lock(mergeThreadMutex_);
-        tasks_.clear();
-        MergeOP op(OPTIMIZE_ALL);
-        tasks_.push(op);
+        // clear the merge tasks not run yet
+        unsigned int generation = ++mergeGeneration_;
+        pMergePool_->post(boost::bind(&IndexMergeManager::optimizeIndexTask,
+                                      this, generation));
     }
     else
     {
@@ -121,39 +104,32 @@ void IndexMergeManager::optimizeIndexImpl()
     pIndexer_->getIndexReader();
 }
 
-void IndexMergeManager::mergeIndex()
+void IndexMergeManager::addToMergeTask(BarrelInfo* pBarrelInfo, unsigned int generation)
 {
-    while(true)
+    DVLOG(2) << "IndexMergeManager::addToMergeTask(), generation: " << generation;
+    if(generation != mergeGeneration_.load())
+        return;
+
+    assert(pBarrelInfo);
+
+    if(pAddMerger_)
+        pAddMerger_->addToMerge(pBarrelInfo);
+}
+
+void IndexMergeManager::optimizeIndexTask(unsigned int generation)
+{
+    DVLOG(2) << "IndexMergeManager::optimizeIndexTask(), generation: " << generation;
+    if(generation != mergeGeneration_.load())
+        return;
+
+    // to clear the status of add merger, renew it
+    if(pAddMerger_)
     {
-        MergeOP op;
-        tasks_.pop(op);
-        DVLOG(2) << "IndexMergeManager::mergeIndex(), opType: " << op.opType;
-        switch(op.opType)
-        {
-        case ADD_BARREL:
-            {
-            assert(op.pBarrelInfo);
-
-            if(pAddMerger_)
-                pAddMerger_->addToMerge(op.pBarrelInfo);
-            }
-            break;
-        case OPTIMIZE_ALL:
-	    {
-            // to clear the status of add merger, renew it
-            if(pAddMerger_)
-            {
-                delete pAddMerger_;
-                pAddMerger_ = new IndexMerger(pIndexer_, new BTPolicy);
-            }
-
-            optimizeIndexImpl();
-            }
-            break;
-        case EXIT_MERGE:
-            return;
-        }
+        delete pAddMerger_;
+        pAddMerger_ = new IndexMerger(pIndexer_, new BTPolicy);
     }
+
+    optimizeIndexImpl();
 }
 
 void IndexMergeManager::pauseMerge()
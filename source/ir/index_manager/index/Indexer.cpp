@@ -164,7 +164,7 @@ void Indexer::setIndexMode(const std::string& mode)
     {
         realTime_ = false;
         std::vector<std::string> indexingParams = izenelib::ir::indexmanager::split(mode,":");
-        ///  default:block	or default:chunk
+        ///  default:block, default:chunk or default:simdblock
         if(indexingParams.size() == 2)
         {
             if(!strcasecmp(indexingParams[1].c_str(),"block"))
@@ -174,6 +174,8 @@ void Indexer::setIndexMode(const std::string& mode)
                 indexingType_ = CHUNK;
                 skipInterval_ = CHUNK_SIZE;
             }
+            else if(!strcasecmp(indexingParams[1].c_str(),"simdblock"))
+                indexingType_ = SIMD_BLOCK;
             else
                 indexingType_ = BYTEALIGN;
         }
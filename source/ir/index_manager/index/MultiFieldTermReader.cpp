@@ -29,6 +29,7 @@ MultiFieldTermReader::MultiFieldTermReader(Directory* pDirectory,BarrelInfo* pBa
                 pTermReader.reset(new RTDiskTermReader(pDirectory,pBarrelInfo,pInfo, indexLevel));
                 break;
             case BLOCK:
+            case SIMD_BLOCK:
                 pTermReader.reset(new BlockTermReader(pDirectory,pBarrelInfo,pInfo, indexLevel));
                 break;
             case CHUNK:
@@ -138,6 +138,7 @@ void PostingMerger::init()
     curr_position_buffer_size_ = INIT_POS_CHUNK_SIZE << 1;
     positions_ = new uint32_t[curr_position_buffer_size_];
     pFixedSkipListWriter_ = new FixedBlockSkipListWriter(pMemCache_);
+    chunk_.set_simd(compressType_ == SIMD_BLOCK);
 
     if (indexLevel_ == WORDLEVEL)
         pPosDataPool_ = new ChunkDataPool(pMemCache_) ;
@@ -757,7 +758,7 @@ void PostingMerger::mergeWith(ChunkPostingReader* pPosting, Bitset* pFilter)
 
 void PostingMerger::optimize(RTDiskPostingReader* pOnDiskPosting, Bitset* pFilter)
 {
-    if (compressType_ == BLOCK) optimize_to_Block(pOnDiskPosting, pFilter);
+    if (compressType_ == BLOCK || compressType_ == SIMD_BLOCK) optimize_to_Block(pOnDiskPosting, pFilter);
     else optimize_to_Chunk(pOnDiskPosting, pFilter);
 }
 
@@ -949,6 +950,7 @@ fileoffset_t PostingMerger::endMerge()
     case BYTEALIGN:
         return endMerge_ByteAlign();
     case BLOCK:
+    case SIMD_BLOCK:
         return endMerge_Block();
     case CHUNK:
         return endMerge_Chunk();
@@ -71,6 +71,7 @@ void SingleIndexBarrelReader::open(const char* name)
                         pTermReader = new RTDiskTermReader(pDirectory,pBarrelInfo_,pFieldInfo, pIndexReader_->getIndexLevel());
                         break;
                     case BLOCK:
+                    case SIMD_BLOCK:
                         pTermReader = new BlockTermReader(pDirectory,pBarrelInfo_,pFieldInfo, pIndexReader_->getIndexLevel());
                         break;
                     case CHUNK:
@@ -297,7 +297,8 @@ BlockTermIterator::BlockTermIterator(
     Directory* pDirectory,
     const char* barrelname,
     FieldInfo* pFieldInfo,
-    IndexLevel indexLevel)
+    IndexLevel indexLevel,
+    CompressionType compressType)
     :pDirectory_(pDirectory)
     ,pFieldInfo_(pFieldInfo)
     ,pCurTerm_(NULL)
@@ -305,6 +306,7 @@ BlockTermIterator::BlockTermIterator(
     ,pCurTermPosting_(NULL)
     ,pInputDescriptor_(NULL)
     ,nCurPos_(-1)
+    ,compressType_(compressType)
 {
     indexLevel_ = indexLevel;
     barrelName_ = barrelname;
@@ -358,7 +360,7 @@ PostingReader* BlockTermIterator::termPosting()
         pInputDescriptor_->setDPostingInput(pDirectory_->openInput(barrelName_ + ".dfp"));
         if(indexLevel_ == WORDLEVEL)
             pInputDescriptor_->setPPostingInput(pDirectory_->openInput(barrelName_ + ".pop"));
-        pCurTermPosting_ = new BlockPostingReader(pInputDescriptor_,*pCurTermInfo_);
+        pCurTermPosting_ = new BlockPostingReader(pInputDescriptor_,*pCurTermInfo_, WORDLEVEL, compressType_);
     }
     else
     {
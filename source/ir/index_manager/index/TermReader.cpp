@@ -773,12 +773,17 @@ TermReader* BlockTermReader::clone()
     return pTermReader;
 }
 
+CompressionType BlockTermReader::compressType() const
+{
+    return pBarrelInfo_ ? pBarrelInfo_->compressType : BLOCK;
+}
+
 TermDocFreqs* BlockTermReader::termDocFreqs()
 {
     if (pCurTermInfo_ == NULL || pTermReaderImpl_.get() == NULL )
         return NULL;
     BlockPostingReader* pPosting =
-        new BlockPostingReader(pTermReaderImpl_->pInputDescriptor_->clone(DOCLEVEL),*pCurTermInfo_, DOCLEVEL);
+        new BlockPostingReader(pTermReaderImpl_->pInputDescriptor_->clone(DOCLEVEL),*pCurTermInfo_, DOCLEVEL, compressType());
     if(getDocFilter())
         pPosting->setFilter(getDocFilter());
     TermDocFreqs* pTermDoc =
@@ -792,7 +797,7 @@ TermPositions* BlockTermReader::termPositions()
         return NULL;
 
     BlockPostingReader* pPosting =
-        new BlockPostingReader(pTermReaderImpl_->pInputDescriptor_->clone(),*pCurTermInfo_);
+        new BlockPostingReader(pTermReaderImpl_->pInputDescriptor_->clone(),*pCurTermInfo_, WORDLEVEL, compressType());
     if(getDocFilter())
         pPosting->setFilter(getDocFilter());
 
@@ -809,7 +814,7 @@ TermIterator* BlockTermReader::termIterator(const char* field)
 
     TermIterator* pIterator = static_cast<TermIterator*>(new BlockTermIterator(pTermReaderImpl_->pDirectory_,
                                                              pTermReaderImpl_->barrelName_.c_str(),
-                                                             getFieldInfo(), indexLevel_));
+                                                             getFieldInfo(), indexLevel_, compressType()));
     pIterator->setSkipInterval(skipInterval_);
     pIterator->setMaxSkipLevel(maxSkipLevel_);
     return pIterator;
@@ -0,0 +1,371 @@
+#include <util/compression/int/int_codec_registry.h>
+#include <util/compression/int/fastpfor/fastpfor.h>
+#include <util/compression/int/fastpfor/simdfastpfor.h>
+#include <util/compression/int/fastpfor/simple8b.h>
+#include <util/compression/int/fastpfor/variablebyte.h>
+#include <util/compression/int/fastpfor/compositecodec.h>
+#include <util/compression/simd-compression/simdbinarypacking.h>
+#include <util/compression/simd-compression/compositecodec.h>
+#include <util/compression/simd-compression/variablebyte.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace izenelib{namespace util{namespace compression{
+
+namespace
+{
+
+typedef CompositeCodec<FastPFor, VariableByte> FastPForCodec;
+typedef CompositeCodec<SIMDFastPFor, VariableByte> SIMDFastPForCodec;
+typedef SIMDCompression::CompositeCodec<
+    SIMDCompression::SIMDBinaryPacking<SIMDCompression::SIMDBlockPacker<SIMDCompression::NoDelta, true> >,
+    SIMDCompression::VariableByte<false> > SIMDBP128Codec;
+
+/// decoding speed, the lower the faster, indexed by IntCodecTag
+const uint32_t DECODE_RANK[INT_CODEC_NUM] = {2, 7, 6, 5, 3, 1, 4, 0};
+
+const uint64_t INVALID_BITS = static_cast<uint64_t>(-1);
+
+inline uint32_t bitWidth(uint32_t v)
+{
+    return v ? 32 - __builtin_clz(v) : 0;
+}
+
+uint64_t vbyteBits(const uint32_t* histogram)
+{
+    uint64_t bits = 0;
+    for (uint32_t b = 0; b <= 32; ++b)
+        bits += static_cast<uint64_t>(histogram[b]) * 8 * std::max(1U, (b + 6) / 7);
+    return bits;
+}
+
+/// a Simple word packing count values of width bits each
+struct SimpleMode
+{
+    uint32_t count;
+    uint32_t width;
+};
+
+/**
+ * words written by the greedy packing of the Simple family, which takes the
+ * mode packing the most values, or the remaining ones at the end
+ */
+uint64_t simpleWords(const uint32_t* in, uint32_t size, const SimpleMode* modes, uint32_t modeNum)
+{
+    uint32_t maxCount[33];
+    std::vector<bool> isCount(modes[0].count + 1, false);
+    for (uint32_t b = 0; b <= 32; ++b)
+    {
+        maxCount[b] = 0;
+        for (uint32_t i = 0; i < modeNum; ++i)
+        {
+            if (modes[i].width >= b)
+                maxCount[b] = std::max(maxCount[b], modes[i].count);
+        }
+    }
+    for (uint32_t i = 0; i < modeNum; ++i)
+        isCount[modes[i].count] = true;
+
+    uint64_t words = 0;
+    for (uint32_t pos = 0; pos < size; ++words)
+    {
+        uint32_t width = 0, packed = 1;
+        for (uint32_t k = 1; pos + k <= size; ++k)
+        {
+            width = std::max(width, bitWidth(in[pos + k - 1]));
+            if (maxCount[width] < k) break;
+            if (isCount[k] || pos + k == size) packed = k;
+        }
+        pos += packed;
+    }
+    return words;
+}
+
+/// patched frame of reference, the exceptions above b cost their high bits and exceptionBits
+uint64_t pforBits(const uint32_t* histogram, uint32_t size, uint32_t headerBits, uint32_t exceptionBits)
+{
+    uint32_t maxBits = 32;
+    while (maxBits > 0 && !histogram[maxBits]) --maxBits;
+
+    uint64_t best = static_cast<uint64_t>(size) * maxBits;
+    uint32_t exceptions = 0;
+    for (uint32_t b = maxBits; b-- > 0;)
+    {
+        exceptions += histogram[b + 1];
+        uint64_t bits = static_cast<uint64_t>(size) * b
+            + static_cast<uint64_t>(exceptions) * (maxBits - b + exceptionBits);
+        best = std::min(best, bits);
+    }
+    return best + headerBits;
+}
+
+/// histogram of the values after the whole groups
+void tailHistogram(const IntBlockStats& stats, uint32_t* histogram)
+{
+    std::copy(stats.histogram, stats.histogram + 33, histogram);
+    for (uint32_t g = 0; g < stats.groupNum(); ++g)
+    {
+        const uint32_t* group = stats.groupHistogram(g);
+        for (uint32_t b = 0; b <= 32; ++b)
+            histogram[b] -= group[b];
+    }
+}
+
+}
+
+const uint32_t IntBlockCodec::DECODE_PADDING;
+const uint32_t IntBlockStats::GROUP_SIZE;
+const uint32_t AutoIntCodec::HEADER_WORDS;
+const uint32_t AutoIntCodec::MAX_BLOCK_WORDS;
+
+IntCodecRegistry::IntCodecRegistry()
+    : codecs_(INT_CODEC_NUM)
+{
+    codecs_[INT_CODEC_COPY] = new LemireIntBlockCodec<JustCopy>("copy", false);
+    codecs_[INT_CODEC_VBYTE] = new IzeneIntBlockCodec<vbyte_compressor>("vbyte", (1U << 28) - 1);
+    codecs_[INT_CODEC_S16] = new IzeneIntBlockCodec<s16_compressor>("s16", (1U << 28) - 1);
+    codecs_[INT_CODEC_PFORDELTA_MIX] = new IzeneIntBlockCodec<pfordelta_mix_compressor>("pfordelta_mix", (1U << 28) - 1);
+    codecs_[INT_CODEC_FASTPFOR] = new LemireIntBlockCodec<FastPForCodec>("fastpfor", false);
+    codecs_[INT_CODEC_SIMDFASTPFOR] = new LemireIntBlockCodec<SIMDFastPForCodec>("simdfastpfor", true);
+    codecs_[INT_CODEC_SIMPLE8B] = new LemireIntBlockCodec<Simple8b<true> >("simple8b", false);
+    codecs_[INT_CODEC_SIMD_BP128] = new LemireIntBlockCodec<SIMDBP128Codec>("simdbp128", true);
+}
+
+IntCodecRegistry::~IntCodecRegistry()
+{
+    for (size_t i = 0; i < codecs_.size(); ++i)
+        delete codecs_[i];
+}
+
+uint32_t IntCodecRegistry::tagOf(const std::string& name) const
+{
+    for (uint32_t i = 0; i < codecs_.size(); ++i)
+    {
+        if (name == codecs_[i]->name())
+            return i;
+    }
+    return INT_CODEC_NUM;
+}
+
+void IntBlockStats::compute(const uint32_t* in, uint32_t n)
+{
+    size = n;
+    std::fill(histogram, histogram + 33, 0);
+    groupHistograms.assign(groupNum() * 33, 0);
+
+    uint32_t i = 0;
+    for (uint32_t g = 0; g < groupNum(); ++g)
+    {
+        uint32_t* group = &groupHistograms[g * 33];
+        for (uint32_t end = i + GROUP_SIZE; i < end; ++i)
+            ++group[bitWidth(in[i])];
+        for (uint32_t b = 0; b <= 32; ++b)
+            histogram[b] += group[b];
+    }
+    for (; i < n; ++i)
+        ++histogram[bitWidth(in[i])];
+
+    maxBits = 32;
+    while (maxBits > 0 && !histogram[maxBits]) --maxBits;
+}
+
+IntCodecSelector::IntCodecSelector(IntCodecRegistry& registry, Mode mode, double speedBias)
+    : registry_(registry)
+    , mode_(mode)
+    , speedBias_(speedBias)
+{
+}
+
+uint64_t IntCodecSelector::estimateBits(uint32_t tag, const uint32_t* in, const IntBlockStats& stats) const
+{
+    // S16 also has modes of mixed widths, the uniform ones are simulated
+    static const SimpleMode S16_MODES[] = {
+        {28, 1}, {14, 2}, {9, 3}, {7, 4}, {5, 5}, {4, 7}, {3, 9}, {2, 14}, {1, 28}
+    };
+    static const SimpleMode SIMPLE8B_MODES[] = {
+        {240, 0}, {120, 0}, {60, 1}, {30, 2}, {20, 3}, {15, 4}, {12, 5}, {10, 6},
+        {8, 7}, {7, 8}, {6, 10}, {5, 12}, {4, 15}, {3, 20}, {2, 30}, {1, 60}
+    };
+
+    if (stats.maxBits > bitWidth(registry_.get(tag)->maxValue()))
+        return INVALID_BITS;
+
+    uint32_t tail[33];
+    uint64_t bits = 0;
+
+    switch (tag)
+    {
+    case INT_CODEC_COPY:
+        return 32ULL * stats.size;
+
+    case INT_CODEC_VBYTE:
+        return vbyteBits(stats.histogram);
+
+    case INT_CODEC_S16:
+        return simpleWords(in, stats.size, S16_MODES, 9) * 32 * 19 / 20;
+
+    case INT_CODEC_SIMPLE8B:
+        return simpleWords(in, stats.size, SIMPLE8B_MODES, 16) * 64 + 32;
+
+    case INT_CODEC_PFORDELTA_MIX:
+        // short groups are stored as VINT, exceptions as VINT with a position
+        for (uint32_t g = 0; g < stats.groupNum(); ++g)
+            bits += pforBits(stats.groupHistogram(g), IntBlockStats::GROUP_SIZE, 32, 24);
+        tailHistogram(stats, tail);
+        if (stats.size % IntBlockStats::GROUP_SIZE >= (uint32_t)pfordelta_mix_compressor::PFORDELTAMIX_THRESHOLD)
+            bits += pforBits(tail, stats.size % IntBlockStats::GROUP_SIZE, 32, 24);
+        else
+            bits += vbyteBits(tail) + 16;
+        return bits;
+
+    case INT_CODEC_FASTPFOR:
+    case INT_CODEC_SIMDFASTPFOR:
+        for (uint32_t g = 0; g < stats.groupNum(); ++g)
+            bits += pforBits(stats.groupHistogram(g), IntBlockStats::GROUP_SIZE, 16, 8);
+        tailHistogram(stats, tail);
+        bits += vbyteBits(tail) + 4 * 32;
+        return tag == INT_CODEC_SIMDFASTPFOR ? bits + 4 * 32 : bits;
+
+    case INT_CODEC_SIMD_BP128:
+        for (uint32_t g = 0; g < stats.groupNum(); ++g)
+        {
+            const uint32_t* group = stats.groupHistogram(g);
+            uint32_t b = 32;
+            while (b > 0 && !group[b]) --b;
+            bits += IntBlockStats::GROUP_SIZE * b;
+        }
+        tailHistogram(stats, tail);
+        bits += vbyteBits(tail) + (stats.groupNum() + 15) / 16 * 4 * 32 + 4 * 32;
+        return bits;
+
+    default:
+        return INVALID_BITS;
+    }
+}
+
+uint32_t IntCodecSelector::select(const uint32_t* in, uint32_t size)
+{
+    uint32_t maxValue = 0;
+    uint64_t sizes[INT_CODEC_NUM];
+
+    if (mode_ == EXHAUSTIVE)
+    {
+        maxValue = *std::max_element(in, in + size);
+        buffer_.resize(IntBlockCodec::maxEncodedWords(size) + 4);
+    }
+    else
+    {
+        stats_.compute(in, size);
+    }
+
+    uint64_t best = INVALID_BITS;
+    for (uint32_t tag = 0; tag < INT_CODEC_NUM; ++tag)
+    {
+        if (mode_ == EXHAUSTIVE)
+        {
+            IntBlockCodec* codec = registry_.get(tag);
+            if (maxValue > codec->maxValue())
+            {
+                sizes[tag] = INVALID_BITS;
+                continue;
+            }
+            uint32_t* out = &buffer_[0];
+            while (reinterpret_cast<uintptr_t>(out) & 15) ++out;
+            sizes[tag] = 32ULL * codec->encode(in, size, out);
+        }
+        else
+        {
+            sizes[tag] = estimateBits(tag, in, stats_);
+        }
+        best = std::min(best, sizes[tag]);
+    }
+
+    uint32_t selected = INT_CODEC_COPY;
+    for (uint32_t tag = 0; tag < INT_CODEC_NUM; ++tag)
+    {
+        if (sizes[tag] != INVALID_BITS && sizes[tag] <= best * (1 + speedBias_)
+                && (sizes[selected] > best * (1 + speedBias_) || DECODE_RANK[tag] < DECODE_RANK[selected]))
+            selected = tag;
+    }
+    return selected;
+}
+
+AutoIntCodec::AutoIntCodec(uint32_t blockSize, IntCodecSelector::Mode mode, double speedBias)
+    : blockSize_(blockSize)
+    , fixedCodec_(INT_CODEC_NUM)
+    , selector_(registry_, mode, speedBias)
+    , codecUsage_(INT_CODEC_NUM, 0)
+{
+    if (blockSize_ == 0 || blockSize_ % 4)
+        throw std::invalid_argument("AutoIntCodec: the block size must be a positive multiple of 4");
+}
+
+uint32_t AutoIntCodec::encode(const uint32_t* in, uint32_t size, uint32_t* out)
+{
+    uint32_t pos = 0;
+    out[pos++] = size;
+    out[pos++] = blockSize_;
+
+    for (uint32_t begin = 0; begin < size; begin += blockSize_)
+    {
+        uint32_t n = std::min(blockSize_, size - begin);
+        uint32_t tag = fixedCodec_ < INT_CODEC_NUM ? fixedCodec_ : selector_.select(in + begin, n);
+        IntBlockCodec* codec = registry_.get(tag);
+        if (*std::max_element(in + begin, in + begin + n) > codec->maxValue())
+        {
+            tag = INT_CODEC_COPY;
+            codec = registry_.get(tag);
+        }
+
+        uint32_t header = pos++;
+        uint32_t padding = 0;
+        while (codec->aligned() && (reinterpret_cast<uintptr_t>(out + pos) & 15))
+        {
+            out[pos++] = 0;
+            ++padding;
+        }
+
+        uint32_t words = codec->encode(in + begin, n, out + pos);
+        if (words > MAX_BLOCK_WORDS)
+            throw std::length_error("AutoIntCodec: block too large, use a smaller block size");
+
+        out[header] = tag << 24 | padding << 22 | words;
+        pos += words;
+        ++codecUsage_[tag];
+    }
+
+    return pos;
+}
+
+void AutoIntCodec::encode(const std::vector<uint32_t>& in, std::vector<uint32_t>& out)
+{
+    out.resize(maxEncodedWords(in.size()));
+    out.resize(encode(in.empty() ? NULL : &in[0], in.size(), &out[0]));
+}
+
+uint32_t AutoIntCodec::decode(const uint32_t* in, uint32_t* out)
+{
+    uint32_t size = in[0];
+    uint32_t blockSize = in[1];
+    uint32_t pos = HEADER_WORDS;
+
+    for (uint32_t begin = 0; begin < size; begin += blockSize)
+    {
+        uint32_t n = std::min(blockSize, size - begin);
+        uint32_t header = in[pos++];
+        uint32_t tag = header >> 24;
+        uint32_t words = header & MAX_BLOCK_WORDS;
+        pos += (header >> 22) & 3;
+
+        if (tag >= INT_CODEC_NUM)
+            throw std::runtime_error("AutoIntCodec: unknown codec tag");
+
+        registry_.get(tag)->decode(in + pos, words, out + begin, n);
+        pos += words;
+    }
+
+    return pos;
+}
+
+}}}
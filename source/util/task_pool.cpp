@@ -0,0 +1,332 @@
+#include <util/task_pool.h>
+
+#include <boost/bind.hpp>
+
+namespace izenelib {
+namespace util {
+
+namespace {
+
+/**
+ * The deque of Chase and Lev, with the orders of "Correct and Efficient
+ * Work-Stealing for Weak Memory Models" (Le et al.). Only its owner pushes
+ * and takes at the bottom, the others steal at the top; the arrays replaced
+ * when it grows are kept until it is destroyed, as a thief may still read
+ * them.
+ */
+class work_stealing_deque : private boost::noncopyable
+{
+public:
+    typedef task_pool::task_type* value_type;
+
+    explicit work_stealing_deque(std::size_t capacity = 256)
+        : top_(0), bottom_(0), array_(new circular_array(capacity))
+    {
+        arrays_.push_back(array_.load(boost::memory_order_relaxed));
+    }
+
+    ~work_stealing_deque()
+    {
+        for (std::size_t i = 0; i < arrays_.size(); ++i)
+            delete arrays_[i];
+    }
+
+    void push(value_type v)
+    {
+        long b = bottom_.load(boost::memory_order_relaxed);
+        long t = top_.load(boost::memory_order_acquire);
+        circular_array* a = array_.load(boost::memory_order_relaxed);
+        if (b - t > (long)a->size() - 1)
+        {
+            a = a->grow(b, t);
+            arrays_.push_back(a);
+            array_.store(a, boost::memory_order_release);
+        }
+        a->put(b, v);
+        bottom_.store(b + 1, boost::memory_order_release);
+    }
+
+    value_type take()
+    {
+        long b = bottom_.load(boost::memory_order_relaxed) - 1;
+        circular_array* a = array_.load(boost::memory_order_relaxed);
+        bottom_.store(b, boost::memory_order_seq_cst);
+        long t = top_.load(boost::memory_order_seq_cst);
+        if (t > b)
+        {
+            bottom_.store(b + 1, boost::memory_order_relaxed);
+            return NULL;
+        }
+        value_type v = a->get(b);
+        if (t == b)
+        {
+            // the last one, raced with the thieves
+            if (!top_.compare_exchange_strong(t, t + 1, boost::memory_order_seq_cst))
+                v = NULL;
+            bottom_.store(b + 1, boost::memory_order_relaxed);
+        }
+        return v;
+    }
+
+    value_type steal()
+    {
+        long t = top_.load(boost::memory_order_seq_cst);
+        long b = bottom_.load(boost::memory_order_seq_cst);
+        if (t >= b)
+            return NULL;
+        circular_array* a = array_.load(boost::memory_order_acquire);
+        value_type v = a->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, boost::memory_order_seq_cst))
+            return NULL;
+        return v;
+    }
+
+    bool empty() const
+    {
+        long t = top_.load(boost::memory_order_seq_cst);
+        long b = bottom_.load(boost::memory_order_seq_cst);
+        return t >= b;
+    }
+
+private:
+    class circular_array : private boost::noncopyable
+    {
+    public:
+        explicit circular_array(std::size_t size)
+            : mask_(size - 1), buffer_(new boost::atomic<value_type>[size])
+        {
+        }
+
+        ~circular_array()
+        {
+            delete[] buffer_;
+        }
+
+        std::size_t size() const
+        {
+            return mask_ + 1;
+        }
+
+        value_type get(long i) const
+        {
+            return buffer_[i & mask_].load(boost::memory_order_relaxed);
+        }
+
+        void put(long i, value_type v)
+        {
+            buffer_[i & mask_].store(v, boost::memory_order_relaxed);
+        }
+
+        circular_array* grow(long b, long t) const
+        {
+            circular_array* a = new circular_array(size() * 2);
+            for (long i = t; i < b; ++i)
+                a->put(i, get(i));
+            return a;
+        }
+
+    private:
+        std::size_t mask_;
+        boost::atomic<value_type>* buffer_;
+    };
+
+    boost::atomic<long> top_;
+    char pad_[64];
+    boost::atomic<long> bottom_;
+    boost::atomic<circular_array*> array_;
+    std::vector<circular_array*> arrays_; ///< only changed by the owner
+};
+
+}
+
+struct task_pool::worker
+{
+    explicit worker(std::size_t i) : index(i), victim(i) {}
+
+    std::size_t index;
+    std::size_t victim; ///< the next worker to steal from
+    work_stealing_deque deque;
+};
+
+namespace detail {
+
+void task_state_base::wait()
+{
+    if (is_ready())
+        return;
+
+    // a worker runs the other tasks, the one waited may be among them
+    while (pool_->in_worker() && !is_ready())
+    {
+        if (pool_->run_one())
+            continue;
+
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        if (!is_ready())
+            cond_.timed_wait(lock, boost::posix_time::milliseconds(1));
+    }
+
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    while (!is_ready())
+        cond_.wait(lock);
+}
+
+} // namespace detail
+
+task_pool::task_pool(std::size_t thread_num, std::size_t queue_capacity)
+    : current_worker_(&task_pool::no_cleanup)
+    , queue_(queue_capacity)
+    , pending_(0)
+    , sleeping_(0)
+    , stop_(false)
+{
+    if (thread_num == 0)
+        thread_num = boost::thread::hardware_concurrency();
+    if (thread_num == 0)
+        thread_num = 1;
+
+    for (std::size_t i = 0; i < thread_num; ++i)
+        workers_.push_back(new worker(i));
+    for (std::size_t i = 0; i < thread_num; ++i)
+        threads_.create_thread(boost::bind(&task_pool::worker_loop, this, workers_[i]));
+}
+
+task_pool::~task_pool()
+{
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        stop_.store(true);
+        work_cond_.notify_all();
+    }
+    threads_.join_all();
+
+    for (std::size_t i = 0; i < workers_.size(); ++i)
+        delete workers_[i];
+}
+
+void task_pool::push(task_type* task)
+{
+    pending_.fetch_add(1, boost::memory_order_relaxed);
+
+    worker* self = current_worker_.get();
+    if (self)
+        self->deque.push(task);
+    else
+        queue_.push(task);
+
+    // either a worker going to sleep sees the task, or it is seen sleeping
+    boost::atomic_thread_fence(boost::memory_order_seq_cst);
+    if (sleeping_.load(boost::memory_order_relaxed) > 0)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        work_cond_.notify_one();
+    }
+}
+
+task_pool::task_type* task_pool::next_task(worker* self)
+{
+    task_type* task = NULL;
+    if (self && (task = self->deque.take()))
+        return task;
+
+    if (queue_.try_pop(task))
+        return task;
+
+    // steal from the others, beginning after the last one stolen from
+    std::size_t n = workers_.size();
+    std::size_t start = self ? self->victim : 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        worker* victim = workers_[(start + i) % n];
+        if (victim == self)
+            continue;
+        if ((task = victim->deque.steal()))
+        {
+            if (self)
+                self->victim = victim->index;
+            return task;
+        }
+    }
+    return NULL;
+}
+
+bool task_pool::has_task() const
+{
+    if (!queue_.empty())
+        return true;
+    for (std::size_t i = 0; i < workers_.size(); ++i)
+    {
+        if (!workers_[i]->deque.empty())
+            return true;
+    }
+    return false;
+}
+
+void task_pool::run(task_type* task)
+{
+    try
+    {
+        (*task)();
+    }
+    catch (...)
+    {
+        // the tasks posted without a future
+    }
+    delete task;
+
+    if (pending_.fetch_sub(1, boost::memory_order_acq_rel) == 1)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        done_cond_.notify_all();
+    }
+}
+
+bool task_pool::run_one()
+{
+    task_type* task = next_task(current_worker_.get());
+    if (!task)
+        return false;
+
+    run(task);
+    return true;
+}
+
+void task_pool::wait()
+{
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    while (pending_.load(boost::memory_order_acquire) > 0)
+        done_cond_.wait(lock);
+}
+
+void task_pool::worker_loop(worker* self)
+{
+    current_worker_.reset(self);
+
+    while (true)
+    {
+        task_type* task = next_task(self);
+        if (task)
+        {
+            run(task);
+            continue;
+        }
+
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        sleeping_.fetch_add(1, boost::memory_order_relaxed);
+        boost::atomic_thread_fence(boost::memory_order_seq_cst);
+        if (!has_task())
+        {
+            if (stop_.load())
+            {
+                sleeping_.fetch_sub(1, boost::memory_order_relaxed);
+                break;
+            }
+            work_cond_.wait(lock);
+        }
+        sleeping_.fetch_sub(1, boost::memory_order_relaxed);
+    }
+
+    current_worker_.release();
+}
+
+}} // namespace izenelib::util
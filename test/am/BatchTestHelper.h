@@ -0,0 +1,61 @@
+/**
+ * @file BatchTestHelper.h
+ * @brief Checks multiGet() and writeBatch() of an access method of <int, int>.
+ */
+#ifndef INCLUDED_AM_BATCH_TEST_HELPER_H
+#define INCLUDED_AM_BATCH_TEST_HELPER_H
+
+#include <boost/test/unit_test.hpp>
+
+#include <am/concept/WriteBatch.h>
+
+#include <vector>
+
+/**
+ * inserts the keys [1, size] one by one, then the keys (size, 2 * size] with
+ * the delete of key size in one writeBatch(), and gets them all, with a
+ * missing key, by multiGet(). The value of key i is i * 100.
+ */
+template <typename TableType>
+void checkBatch(TableType& table, int size = 10000)
+{
+    for (int i = 1; i <= size; ++i)
+        BOOST_CHECK(table.insert(i, i*100));
+
+    izenelib::am::WriteBatch<int, int> batch;
+    for (int i = size + 1; i <= 2 * size; ++i)
+        batch.insert(i, i*100);
+    batch.del(size);
+    BOOST_CHECK(table.writeBatch(batch));
+
+    std::vector<int> keys;
+    for (int i = 2 * size; i >= 1; --i)
+        keys.push_back(i);
+    keys.push_back(3 * size);
+
+    std::vector<int> values;
+    std::vector<bool> found;
+    std::size_t count = table.multiGet(keys, values, found);
+
+    BOOST_CHECK_EQUAL(count, keys.size() - 2);
+    BOOST_REQUIRE_EQUAL(values.size(), keys.size());
+    BOOST_REQUIRE_EQUAL(found.size(), keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        if (keys[i] == size || keys[i] == 3 * size)
+        {
+            BOOST_CHECK(!found[i]);
+            continue;
+        }
+        BOOST_CHECK(found[i]);
+        BOOST_CHECK_EQUAL(values[i], keys[i]*100);
+    }
+
+    // the single gets agree
+    int value = 0;
+    BOOST_CHECK(!table.get(size, value));
+    BOOST_CHECK(table.get(2 * size, value));
+    BOOST_CHECK_EQUAL(value, 2 * size * 100);
+}
+
+#endif // INCLUDED_AM_BATCH_TEST_HELPER_H
@@ -0,0 +1,180 @@
+#include <boost/test/unit_test.hpp>
+
+#include <am/approximate_matching/QGramMatchIndex.h>
+#include <util/string/MyersEditDistance.h>
+
+#include <sstream>
+#include <cstdlib>
+
+using namespace std;
+using namespace izenelib::am;
+using namespace izenelib::util;
+
+namespace
+{
+
+size_t naiveDistance(const UString& a, const UString& b)
+{
+    vector<size_t> row(b.length() + 1);
+    for (size_t j = 0; j <= b.length(); ++j) row[j] = j;
+    for (size_t i = 1; i <= a.length(); ++i)
+    {
+        size_t diag = row[0];
+        row[0] = i;
+        for (size_t j = 1; j <= b.length(); ++j)
+        {
+            size_t up = row[j];
+            row[j] = min(min(row[j] + 1, row[j - 1] + 1), diag + (a[i - 1] != b[j - 1]));
+            diag = up;
+        }
+    }
+    return row[b.length()];
+}
+
+UString randomText(size_t min_len, size_t max_len, size_t alphabet)
+{
+    UString text;
+    size_t len = min_len + rand() % (max_len - min_len + 1);
+    for (size_t i = 0; i < len; ++i)
+        text.push_back(0x4e00 + rand() % alphabet);
+    return text;
+}
+
+/// @p text with @p edits random edits
+UString randomEdits(const UString& text, size_t edits, size_t alphabet)
+{
+    UString ret(text);
+    for (size_t i = 0; i < edits; ++i)
+    {
+        size_t pos = ret.length() ? rand() % ret.length() : 0;
+        int op = ret.length() ? rand() % 3 : 1;
+        if (op == 0) ret.erase(pos, 1);
+        else if (op == 1) ret.insert(pos, 1, 0x4e00 + rand() % alphabet);
+        else ret[pos] = 0x4e00 + rand() % alphabet;
+    }
+    return ret;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(t_qgram_match_index)
+
+BOOST_AUTO_TEST_CASE(myers_distance)
+{
+    srand(61);
+    for (size_t i = 0; i < 2000; ++i)
+    {
+        // over a word now and then
+        size_t max_len = i % 4 ? 20 : 200;
+        UString pattern = randomText(0, max_len, 4);
+        UString text = i % 2 ? randomEdits(pattern, rand() % 6, 4) : randomText(0, max_len, 4);
+
+        MyersEditDistance<UString::value_type> myers(pattern);
+        size_t expected = naiveDistance(pattern, text);
+        BOOST_REQUIRE_EQUAL(myers.distance(text), expected);
+
+        size_t max_distance = rand() % 6;
+        BOOST_REQUIRE_EQUAL(myers.distance(text, max_distance), min(expected, max_distance + 1));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(match)
+{
+    srand(67);
+    vector<UString> texts;
+    for (size_t i = 0; i < 3000; ++i)
+    {
+        // some texts close to others
+        if (i % 3 == 0 && !texts.empty())
+            texts.push_back(randomEdits(texts[rand() % texts.size()], 1 + rand() % 3, 30));
+        else
+            texts.push_back(randomText(1, i % 10 ? 12 : 80, 30));
+    }
+
+    // q of 1, or short queries matched by their chars
+    QGramMatchIndex index(2), index1(1), index3(3);
+    index.Add(texts);
+    index.BuildIndex();
+    BOOST_CHECK(index.Hasbuild());
+    index1.Add(texts);
+    index1.BuildIndex();
+    index3.Add(texts);
+    index3.BuildIndex();
+
+    vector<UString> queries;
+    for (size_t i = 0; i < 300; ++i)
+        queries.push_back(randomEdits(texts[rand() % texts.size()], rand() % 4, 30));
+
+    for (int k = 0; k <= 4; ++k)
+    {
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            vector<UString> expected;
+            for (size_t j = 0; j < texts.size(); ++j)
+            {
+                if (naiveDistance(queries[i], texts[j]) <= (size_t)k) expected.push_back(texts[j]);
+            }
+
+            vector<UString> results, results1, results3;
+            index.Match(queries[i], k, results);
+            BOOST_REQUIRE(results == expected);
+            index1.Match(queries[i], k, results1);
+            BOOST_REQUIRE(results1 == expected);
+            index3.Match(queries[i], k, results3);
+            BOOST_REQUIRE(results3 == expected);
+        }
+    }
+
+    // the threads match as Match() does
+    vector<vector<UString> > batch;
+    index.SetThreadNum(4);
+    index.BatchMatch(queries, 2, batch);
+    BOOST_REQUIRE_EQUAL(batch.size(), queries.size());
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        vector<UString> results;
+        index.Match(queries[i], 2, results);
+        BOOST_CHECK(batch[i] == results);
+    }
+
+    stringstream ss;
+    index.Save(ss);
+    QGramMatchIndex loaded;
+    loaded.Load(ss);
+    BOOST_CHECK_EQUAL(loaded.TextSize(), texts.size());
+    for (size_t i = 0; i < 50; ++i)
+    {
+        vector<UString> results, loadedResults;
+        index.Match(queries[i], 2, results);
+        loaded.Match(queries[i], 2, loadedResults);
+        BOOST_CHECK(results == loadedResults);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(match_q3)
+{
+    QGramMatchIndex index(3);
+    index.Add(UString("iphone 5s case", UString::UTF_8));
+    index.Add(UString("iphone 6 case", UString::UTF_8));
+    index.Add(UString("galaxy s5 case", UString::UTF_8));
+    index.Add(UString("ipad", UString::UTF_8));
+    index.BuildIndex();
+
+    vector<UString> results;
+    index.Match(UString("iphone 5 case", UString::UTF_8), 1, results);
+    BOOST_REQUIRE_EQUAL(results.size(), 2U);
+    BOOST_CHECK(results[0] == UString("iphone 5s case", UString::UTF_8));
+    BOOST_CHECK(results[1] == UString("iphone 6 case", UString::UTF_8));
+
+    results.clear();
+    index.Match(UString("ipod", UString::UTF_8), 1, results);
+    BOOST_REQUIRE_EQUAL(results.size(), 1U);
+
+    // not built yet
+    index.Add(UString("ipod", UString::UTF_8));
+    results.clear();
+    index.Match(UString("ipod", UString::UTF_8), 0, results);
+    BOOST_CHECK(results.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,203 @@
+#include <boost/test/unit_test.hpp>
+
+#include <am/art/art_map.hpp>
+#include <am/range/AmIterator.h>
+
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace izenelib::am;
+
+namespace
+{
+
+/// keys sharing long prefixes, with zero bytes, and prefixes of each other
+string randomKey()
+{
+    static const char* prefixes[] = {"", "a", "ab", "http://www.example.com/item/",
+                                     "http://www.example.com/item/12", "ab\0\0cd", "sku-0000000000000000-"};
+    static const size_t lengths[] = {0, 1, 2, 28, 30, 6, 21};
+    size_t p = rand() % 7;
+    string key(prefixes[p], lengths[p]);
+    size_t len = rand() % 5;
+    for (size_t i = 0; i < len; ++i)
+        key.push_back((char)(rand() % 4 == 0 ? rand() % 256 : '0' + rand() % 4));
+    return key;
+}
+
+template <class MapT, class KeyType, class ValueType>
+void checkEqual(MapT& art, const map<KeyType, ValueType>& expected)
+{
+    BOOST_REQUIRE_EQUAL(art.size(), expected.size());
+
+    typedef AMIterator<MapT> IteratorType;
+    typename map<KeyType, ValueType>::const_iterator it = expected.begin();
+    for (IteratorType iter(art), end; iter != end; ++iter, ++it)
+    {
+        BOOST_REQUIRE(it != expected.end());
+        BOOST_REQUIRE(iter->first == it->first);
+        BOOST_REQUIRE_EQUAL(iter->second, it->second);
+    }
+    BOOST_REQUIRE(it == expected.end());
+
+    typedef AMReverseIterator<MapT> ReverseIteratorType;
+    typename map<KeyType, ValueType>::const_reverse_iterator rit = expected.rbegin();
+    for (ReverseIteratorType iter(art), end; iter != end; ++iter, ++rit)
+    {
+        BOOST_REQUIRE(rit != expected.rend());
+        BOOST_REQUIRE(iter->first == rit->first);
+    }
+    BOOST_REQUIRE(rit == expected.rend());
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(t_art_map)
+
+BOOST_AUTO_TEST_CASE(insert_find)
+{
+    art_map<string, int> art;
+    BOOST_CHECK(art.empty());
+    BOOST_CHECK(art.insert("abc", 1));
+    BOOST_CHECK(art.insert("ab", 2));
+    BOOST_CHECK(art.insert("abcd", 3));
+    BOOST_CHECK(art.insert("", 4));
+    BOOST_CHECK(!art.insert("abc", 5));
+    BOOST_CHECK_EQUAL(art.num_items(), 4);
+
+    int value = 0;
+    BOOST_CHECK(art.get("abc", value));
+    BOOST_CHECK_EQUAL(value, 1);
+    BOOST_CHECK(art.get("", value));
+    BOOST_CHECK_EQUAL(value, 4);
+    BOOST_CHECK(!art.get("a", value));
+    BOOST_CHECK(!art.get("abcde", value));
+
+    BOOST_CHECK(art.update("abc", 6));
+    BOOST_REQUIRE(art.find("abc"));
+    BOOST_CHECK_EQUAL(*art.find("abc"), 6);
+    BOOST_CHECK(art.update(DataType<string, int>("x", 7)));
+    BOOST_CHECK_EQUAL(art.size(), 5U);
+
+    BOOST_CHECK(art.del("ab"));
+    BOOST_CHECK(!art.del("ab"));
+    BOOST_CHECK(!art.del("abcde"));
+    BOOST_CHECK(!art.find("ab"));
+    BOOST_CHECK(art.find("abcd"));
+
+    typedef AMIterator<art_map<string, int> > IteratorType;
+    IteratorType iter(art, "abcc");
+    BOOST_REQUIRE(iter != IteratorType());
+    BOOST_CHECK_EQUAL(iter->first, "abcd");
+    ++iter;
+    BOOST_CHECK_EQUAL(iter->first, "x");
+    ++iter;
+    BOOST_CHECK(iter == IteratorType());
+
+    art.clear();
+    BOOST_CHECK(art.empty());
+    BOOST_CHECK(IteratorType(art) == IteratorType());
+}
+
+BOOST_AUTO_TEST_CASE(random_strings)
+{
+    srand(13);
+    art_map<string, int> art;
+    map<string, int> expected;
+    for (int round = 0; round < 3; ++round)
+    {
+        for (int i = 0; i < 20000; ++i)
+        {
+            string key = randomKey();
+            int op = rand() % 4;
+            if (op == 0)
+            {
+                BOOST_REQUIRE_EQUAL(art.del(key), expected.erase(key) > 0);
+            }
+            else if (op == 1)
+            {
+                art.update(key, i);
+                expected[key] = i;
+            }
+            else
+            {
+                BOOST_REQUIRE_EQUAL(art.insert(key, i), expected.insert(make_pair(key, i)).second);
+            }
+        }
+        checkEqual(art, expected);
+
+        for (int i = 0; i < 2000; ++i)
+        {
+            string key = randomKey();
+            int value;
+            map<string, int>::const_iterator it = expected.find(key);
+            BOOST_REQUIRE_EQUAL(art.get(key, value), it != expected.end());
+            if (it != expected.end())
+            {
+                BOOST_REQUIRE_EQUAL(value, it->second);
+            }
+
+            // the lower bound
+            art_map<string, int>::cursor_type cursor = art.begin(key);
+            map<string, int>::const_iterator lower = expected.lower_bound(key);
+            string found;
+            BOOST_REQUIRE_EQUAL(art.fetch(cursor, found, value), lower != expected.end());
+            if (lower != expected.end())
+            {
+                BOOST_REQUIRE(found == lower->first);
+                if (lower != expected.begin())
+                {
+                    BOOST_REQUIRE(art.iterPrev(cursor));
+                    BOOST_REQUIRE(art.fetch(cursor, found, value));
+                    --lower;
+                    BOOST_REQUIRE(found == lower->first);
+                }
+            }
+        }
+    }
+
+    // removed to the last, through all the node sizes
+    while (!expected.empty())
+    {
+        BOOST_REQUIRE(art.del(expected.begin()->first));
+        expected.erase(expected.begin());
+        if (expected.size() % 1000 == 0)
+            checkEqual(art, expected);
+    }
+    BOOST_CHECK(art.empty());
+}
+
+BOOST_AUTO_TEST_CASE(integer_keys)
+{
+    srand(17);
+    art_map<int, int> art;
+    map<int, int> expected;
+    for (int i = 0; i < 50000; ++i)
+    {
+        int key = (rand() % 2 ? -1 : 1) * (rand() % (i % 3 ? 1000 : 100000000));
+        BOOST_REQUIRE_EQUAL(art.insert(key, i), expected.insert(make_pair(key, i)).second);
+        if (i % 5 == 0)
+        {
+            int removed = rand() % 1000;
+            BOOST_REQUIRE_EQUAL(art.del(removed), expected.erase(removed) > 0);
+        }
+    }
+    checkEqual(art, expected);
+
+    art_map<uint64_t, uint64_t> art64;
+    map<uint64_t, uint64_t> expected64;
+    for (uint64_t i = 0; i < 300; ++i)
+    {
+        uint64_t key = i * 0x0101010101010101ULL;
+        art64.update(key, i);
+        expected64[key] = i;
+        art64.update(~i, i);
+        expected64[~i] = i;
+    }
+    checkEqual(art64, expected64);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
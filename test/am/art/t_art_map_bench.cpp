@@ -0,0 +1,136 @@
+/// @file   t_art_map_bench.cpp
+/// @brief  ns/op of insert and get of the in memory ordered maps.
+///
+/// usage: manual_t_art_map_bench [key number]
+///
+/// art_map, stx_btree, stl_map and concurrent::SkipList are filled with the
+/// same keys, in a random order, then looked up at the same random keys, for
+/// keys like URLs, like SKUs, and of uint64_t. The keys default to 2^20;
+/// concurrent::SkipList, some microseconds an operation, is only run up to
+/// 2^17 keys.
+#include <am/art/art_map.hpp>
+#include <am/3rdparty/stx_btree.h>
+#include <am/3rdparty/stl_map.h>
+#include <am/concurrent/skiplist.hpp>
+#include <util/ClockTimer.h>
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+
+using namespace izenelib::am;
+
+static const size_t MAX_SKIP_LIST_KEY_NUM = 1U << 17;
+
+/// the AccessMethod interface of concurrent::SkipList
+template <class KeyType, class ValueType>
+class skip_list_am
+{
+public:
+    skip_list_am(const KeyType& min, const KeyType& max) : list_(min, max) {}
+
+    bool insert(const KeyType& key, const ValueType& value)
+    {
+        return list_.add(key, value);
+    }
+
+    bool get(const KeyType& key, ValueType&)
+    {
+        return list_.contains(key);
+    }
+
+private:
+    concurrent::SkipList<KeyType, ValueType> list_;
+};
+
+template <class MapT, class KeyType>
+static void bench(const char* name, MapT& map, const std::vector<KeyType>& keys,
+        const std::vector<KeyType>& queries)
+{
+    izenelib::util::ClockTimer timer;
+    for (size_t i = 0; i < keys.size(); ++i)
+        map.insert(keys[i], (uint32_t)i);
+    double insert_ns = timer.elapsed() * 1e9 / keys.size();
+
+    // counts the keys found, so the lookups are not optimized away
+    size_t found = 0;
+    uint32_t value;
+    timer.restart();
+    for (size_t i = 0; i < queries.size(); ++i)
+        found += map.get(queries[i], value);
+    double get_ns = timer.elapsed() * 1e9 / queries.size();
+
+    std::cout << std::setw(12) << name
+              << std::setw(10) << insert_ns
+              << std::setw(10) << get_ns
+              << "  (" << found << ")" << std::endl;
+}
+
+template <class KeyType>
+static void benchAll(const char* title, std::vector<KeyType>& keys,
+        const KeyType& min, const KeyType& max)
+{
+    std::random_shuffle(keys.begin(), keys.end());
+    std::vector<KeyType> queries(keys.size());
+    for (size_t i = 0; i < queries.size(); ++i)
+        queries[i] = keys[rand() % keys.size()];
+
+    std::cout << title << std::endl;
+    std::cout << std::setw(12) << "" << std::setw(10) << "insert" << std::setw(10) << "get" << std::endl;
+    {
+        art_map<KeyType, uint32_t> map;
+        bench("art_map", map, keys, queries);
+    }
+    {
+        stx_btree<KeyType, uint32_t> map;
+        bench("stx_btree", map, keys, queries);
+    }
+    {
+        stl_map<KeyType, uint32_t> map;
+        bench("stl_map", map, keys, queries);
+    }
+    if (keys.size() <= MAX_SKIP_LIST_KEY_NUM)
+    {
+        skip_list_am<KeyType, uint32_t> map(min, max);
+        bench("skip_list", map, keys, queries);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t KEY_NUM = argc > 1 ? strtoull(argv[1], NULL, 10) : 1U << 20;
+
+    std::cout << std::fixed << std::setprecision(1);
+    srand(0);
+
+    std::vector<std::string> urls(KEY_NUM);
+    const char* hosts[] = {"http://www.taobao.com/item/", "http://detail.tmall.com/item.htm?id=",
+                           "http://www.amazon.cn/dp/", "http://item.jd.com/"};
+    for (size_t i = 0; i < KEY_NUM; ++i)
+    {
+        std::ostringstream oss;
+        oss << hosts[rand() % 4] << rand() % 100000000 << "/" << i;
+        urls[i] = oss.str();
+    }
+    benchAll("url keys", urls, std::string(), std::string(256, '\xff'));
+
+    std::vector<std::string> skus(KEY_NUM);
+    for (size_t i = 0; i < KEY_NUM; ++i)
+    {
+        std::ostringstream oss;
+        oss << "SKU" << std::setw(9) << std::setfill('0') << rand() % 1000000000 << "-" << i % 97;
+        skus[i] = oss.str();
+    }
+    benchAll("sku keys", skus, std::string(), std::string(256, '\xff'));
+
+    std::vector<uint64_t> ints(KEY_NUM);
+    for (size_t i = 0; i < KEY_NUM; ++i)
+        ints[i] = (uint64_t)rand() << 31 ^ rand();
+    benchAll("uint64_t keys", ints, (uint64_t)0, (uint64_t)-1);
+
+    return 0;
+}
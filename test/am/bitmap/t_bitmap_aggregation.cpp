@@ -0,0 +1,233 @@
+#include <am/bitmap/RoaringBitmap.h>
+#include <am/bitmap/ewah.h>
+#include <util/ClockTimer.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+using namespace izenelib::am;
+
+namespace
+{
+
+/// the doc ids of one property value, a mix of dense ranges and sparse ids
+std::vector<uint32_t> postingValues(uint32_t num, uint32_t maxValue, bool clustered)
+{
+    std::vector<uint32_t> values;
+    if (clustered)
+    {
+        while (values.size() < num)
+        {
+            uint32_t begin = rand() % maxValue;
+            for (uint32_t v = begin; v < begin + rand() % 2000 && v < maxValue; ++v)
+                values.push_back(v);
+        }
+    }
+    else
+    {
+        for (uint32_t i = 0; i < num; ++i)
+            values.push_back(rand() % maxValue);
+    }
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    return values;
+}
+
+struct Postings
+{
+    std::vector<std::vector<uint32_t> > values;
+    std::vector<RoaringBitmap> roarings;
+    std::vector<EWAHBoolArray<uint64_t> > ewahs;
+
+    Postings(uint32_t num, uint32_t maxValue, uint32_t sparseness = 50)
+        : values(num), roarings(num), ewahs(num)
+    {
+        for (uint32_t i = 0; i < num; ++i)
+        {
+            values[i] = postingValues(rand() % (maxValue / sparseness) + 1, maxValue, i % 3 == 0);
+            roarings[i].addMany(&values[i][0], &values[i][0] + values[i].size());
+            for (size_t j = 0; j < values[i].size(); ++j)
+                ewahs[i].set(values[i][j]);
+        }
+    }
+
+    std::vector<uint32_t> unionValues() const
+    {
+        std::vector<uint32_t> result;
+        for (size_t i = 0; i < values.size(); ++i)
+            result.insert(result.end(), values[i].begin(), values[i].end());
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+    std::vector<const RoaringBitmap*> roaringPointers(size_t num) const
+    {
+        std::vector<const RoaringBitmap*> pointers;
+        for (size_t i = 0; i < num; ++i)
+            pointers.push_back(&roarings[i]);
+        return pointers;
+    }
+
+    std::vector<const EWAHBoolArray<uint64_t>*> ewahPointers() const
+    {
+        std::vector<const EWAHBoolArray<uint64_t>*> pointers;
+        for (size_t i = 0; i < ewahs.size(); ++i)
+            pointers.push_back(&ewahs[i]);
+        return pointers;
+    }
+};
+
+std::vector<uint32_t> toArray(const RoaringBitmap& bitmap)
+{
+    std::vector<uint32_t> values;
+    bitmap.toArray(values);
+    return values;
+}
+
+std::vector<uint32_t> toArray(const EWAHBoolArray<uint64_t>& bitmap)
+{
+    std::vector<size_t> bits = bitmap.toArray();
+    return std::vector<uint32_t>(bits.begin(), bits.end());
+}
+
+RoaringBitmap pairwiseOr(const std::vector<const RoaringBitmap*>& bitmaps)
+{
+    RoaringBitmap result(false);
+    for (size_t i = 0; i < bitmaps.size(); ++i)
+    {
+        RoaringBitmap tmp = result | *bitmaps[i];
+        result.swap(tmp);
+    }
+    return result;
+}
+
+void pairwiseOr(std::vector<EWAHBoolArray<uint64_t> >& bitmaps, EWAHBoolArray<uint64_t>& result)
+{
+    result.reset();
+    for (size_t i = 0; i < bitmaps.size(); ++i)
+    {
+        EWAHBoolArray<uint64_t> tmp;
+        result.logicalor(bitmaps[i], tmp);
+        result.swap(tmp);
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(bitmap_aggregation_test)
+
+BOOST_AUTO_TEST_CASE(roaringFastOr)
+{
+    srand(23);
+    Postings postings(200, 1 << 20);
+    std::vector<uint32_t> expected = postings.unionValues();
+
+    RoaringBitmap result = RoaringBitmap::fastOr(postings.roaringPointers(200));
+    BOOST_CHECK_EQUAL(result.getCardinality(), expected.size());
+    BOOST_CHECK(toArray(result) == expected);
+
+    for (size_t i = 0; i < postings.roarings.size(); i += 3)
+        postings.roarings[i].runOptimize();
+    result = RoaringBitmap::fastOr(postings.roaringPointers(200));
+    BOOST_CHECK(toArray(result) == expected);
+
+    BOOST_CHECK(toArray(RoaringBitmap::fastOr(postings.roaringPointers(1))) == postings.values[0]);
+    BOOST_CHECK_EQUAL(RoaringBitmap::fastOr(postings.roaringPointers(0)).getCardinality(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(roaringFastAnd)
+{
+    srand(29);
+    std::vector<std::vector<uint32_t> > values;
+    std::vector<RoaringBitmap> bitmaps(5);
+    std::vector<const RoaringBitmap*> pointers;
+    for (uint32_t i = 0; i < bitmaps.size(); ++i)
+    {
+        values.push_back(postingValues(100000 * (i + 1), 1 << 20, i % 2 == 0));
+        bitmaps[i].addMany(&values[i][0], &values[i][0] + values[i].size());
+        if (i == 2) bitmaps[i].runOptimize();
+        pointers.push_back(&bitmaps[i]);
+    }
+
+    std::vector<uint32_t> expected = values[0];
+    for (uint32_t i = 1; i < values.size(); ++i)
+    {
+        std::vector<uint32_t> tmp;
+        std::set_intersection(expected.begin(), expected.end(),
+                values[i].begin(), values[i].end(), std::back_inserter(tmp));
+        expected.swap(tmp);
+    }
+
+    RoaringBitmap result = RoaringBitmap::fastAnd(pointers);
+    BOOST_CHECK_EQUAL(result.getCardinality(), expected.size());
+    BOOST_CHECK(toArray(result) == expected);
+
+    pointers.resize(1);
+    BOOST_CHECK(toArray(RoaringBitmap::fastAnd(pointers)) == values[0]);
+}
+
+BOOST_AUTO_TEST_CASE(ewahHorizontalOr)
+{
+    srand(31);
+    Postings postings(100, 1 << 18);
+    std::vector<uint32_t> expected = postings.unionValues();
+
+    EWAHBoolArray<uint64_t> result;
+    horizontalOr(postings.ewahPointers(), result);
+    BOOST_CHECK(toArray(result) == expected);
+    BOOST_CHECK_EQUAL(result.numberOfOnes(), expected.size());
+
+    EWAHBoolArray<uint64_t> pairwise;
+    pairwiseOr(postings.ewahs, pairwise);
+    BOOST_CHECK_EQUAL(result.sizeInBits(), pairwise.sizeInBits());
+    BOOST_CHECK(result == pairwise);
+
+    // a small window and a single input
+    horizontalOr(postings.ewahPointers(), result, 3);
+    BOOST_CHECK(toArray(result) == expected);
+    std::vector<const EWAHBoolArray<uint64_t>*> one(1, &postings.ewahs[0]);
+    horizontalOr(one, result);
+    BOOST_CHECK(toArray(result) == postings.values[0]);
+}
+
+BOOST_AUTO_TEST_CASE(benchWideOr)
+{
+    srand(37);
+    const uint32_t num = 500;
+
+    // short posting lists like the values of a filter property, then long ones
+    const uint32_t sparseness[] = {1000, 50};
+    for (uint32_t k = 0; k < 2; ++k)
+    {
+        Postings postings(num, 1 << 22, sparseness[k]);
+        std::vector<const RoaringBitmap*> pointers = postings.roaringPointers(num);
+        std::cout << "or of " << num << " bitmaps of at most "
+            << (1 << 22) / sparseness[k] << " values" << std::endl;
+
+        izenelib::util::ClockTimer timer;
+        size_t card = pairwiseOr(pointers).getCardinality();
+        std::cout << "  RoaringBitmap pairwise: " << timer.elapsed() << " s" << std::endl;
+
+        timer.restart();
+        BOOST_CHECK_EQUAL(RoaringBitmap::fastOr(pointers).getCardinality(), card);
+        std::cout << "  RoaringBitmap::fastOr: " << timer.elapsed() << " s" << std::endl;
+
+        EWAHBoolArray<uint64_t> pairwise, horizontal;
+        timer.restart();
+        pairwiseOr(postings.ewahs, pairwise);
+        std::cout << "  EWAHBoolArray pairwise: " << timer.elapsed() << " s" << std::endl;
+
+        timer.restart();
+        horizontalOr(postings.ewahPointers(), horizontal);
+        std::cout << "  horizontalOr: " << timer.elapsed() << " s" << std::endl;
+        BOOST_CHECK_EQUAL(horizontal.numberOfOnes(), card);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,312 @@
+#include <am/bitmap/RoaringBitmap.h>
+#include <am/bitmap/RoaringChunk.h>
+#include <am/bitmap/RoaringBitmapView.h>
+#include <util/ClockTimer.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+using namespace izenelib::am;
+
+namespace
+{
+
+/// sorted distinct values, mostly long ranges like category filters
+std::vector<uint32_t> clusteredValues(uint32_t rangeNum, uint32_t maxValue)
+{
+    std::vector<uint32_t> values;
+    for (uint32_t i = 0; i < rangeNum; ++i)
+    {
+        uint32_t begin = rand() % maxValue;
+        uint32_t length = rand() % 5000 + 1;
+        for (uint32_t v = begin; v < begin + length && v < maxValue; ++v)
+            values.push_back(v);
+    }
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    return values;
+}
+
+std::vector<uint32_t> randomValues(uint32_t num, uint32_t maxValue)
+{
+    std::vector<uint32_t> values;
+    for (uint32_t i = 0; i < num; ++i)
+        values.push_back(rand() % maxValue);
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    return values;
+}
+
+void build(const std::vector<uint32_t>& values, RoaringBitmap& bitmap, bool bulk)
+{
+    if (bulk)
+    {
+        if (!values.empty()) bitmap.addMany(&values[0], &values[0] + values.size());
+    }
+    else
+    {
+        for (size_t i = 0; i < values.size(); ++i)
+            bitmap.add(values[i]);
+    }
+}
+
+/// the runs of @p header are corrupt while the header itself is valid
+void checkBadRuns(RoaringBitmapView& view, char* buf, size_t size, const RoaringSerialHeader& header)
+{
+    BOOST_CHECK(!view.init(buf, size));
+
+    RoaringChunk chunk;
+    BOOST_CHECK(!chunk.deserialize(header.key, header.type, header.cardinality,
+                buf + header.offset, header.size));
+}
+
+std::vector<uint32_t> toArray(const RoaringBitmap& bitmap)
+{
+    std::vector<uint32_t> values;
+    bitmap.toArray(values);
+    return values;
+}
+
+void checkLogical(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, bool optimize)
+{
+    RoaringBitmap ra, rb;
+    build(a, ra, true);
+    build(b, rb, false);
+    if (optimize)
+    {
+        ra.runOptimize();
+        rb.runOptimize();
+    }
+
+    std::vector<uint32_t> expected;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    BOOST_CHECK(toArray(ra & rb) == expected);
+    BOOST_CHECK_EQUAL((ra & rb).getCardinality(), expected.size());
+
+    expected.clear();
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    BOOST_CHECK(toArray(ra | rb) == expected);
+
+    expected.clear();
+    std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    BOOST_CHECK(toArray(ra ^ rb) == expected);
+
+    expected.clear();
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+    BOOST_CHECK(toArray(ra - rb) == expected);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(bitmap_roaring_test)
+
+BOOST_AUTO_TEST_CASE(addMany)
+{
+    srand(7);
+    std::vector<uint32_t> values = randomValues(200000, 1 << 22);
+    values.push_back((1 << 22) + 3);
+
+    RoaringBitmap single, bulk;
+    build(values, single, false);
+    build(values, bulk, true);
+
+    BOOST_CHECK_EQUAL(single.getCardinality(), values.size());
+    BOOST_CHECK_EQUAL(bulk.getCardinality(), values.size());
+    BOOST_CHECK(toArray(single) == values);
+    BOOST_CHECK(toArray(bulk) == values);
+
+    for (size_t i = 0; i < values.size(); i += 97)
+    {
+        BOOST_CHECK(bulk.contains(values[i]));
+        BOOST_CHECK_EQUAL(bulk.contains(values[i] + 1),
+                std::binary_search(values.begin(), values.end(), values[i] + 1));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(runOptimize)
+{
+    srand(11);
+    std::vector<uint32_t> values = clusteredValues(300, 1 << 24);
+
+    RoaringBitmap bitmap;
+    build(values, bitmap, true);
+    size_t before = bitmap.serializedSizeInBytes();
+
+    BOOST_CHECK(bitmap.runOptimize());
+    size_t after = bitmap.serializedSizeInBytes();
+    std::cout << "clustered bitmap of " << values.size() << " values: "
+        << before << " bytes -> " << after << " bytes after runOptimize" << std::endl;
+    BOOST_CHECK_LT(after, before);
+    BOOST_CHECK(toArray(bitmap) == values);
+
+    for (size_t i = 0; i < values.size(); i += 31)
+    {
+        BOOST_CHECK(bitmap.contains(values[i]));
+    }
+    BOOST_CHECK(!bitmap.contains((1 << 24) + 1));
+}
+
+BOOST_AUTO_TEST_CASE(logicalOps)
+{
+    srand(13);
+    // array x array, bitmap x bitmap, array x bitmap
+    checkLogical(randomValues(3000, 1 << 20), randomValues(3000, 1 << 20), false);
+    checkLogical(randomValues(200000, 1 << 20), randomValues(150000, 1 << 20), false);
+    checkLogical(randomValues(200000, 1 << 20), randomValues(5000, 1 << 20), false);
+    checkLogical(randomValues(100, 1 << 20), randomValues(100000, 1 << 20), false);
+
+    // run containers on one or both sides
+    checkLogical(clusteredValues(100, 1 << 20), clusteredValues(100, 1 << 20), true);
+    checkLogical(clusteredValues(100, 1 << 20), randomValues(100000, 1 << 20), true);
+    checkLogical(randomValues(2000, 1 << 20), clusteredValues(50, 1 << 20), true);
+}
+
+BOOST_AUTO_TEST_CASE(serialization)
+{
+    srand(17);
+    std::vector<uint32_t> values = clusteredValues(100, 1 << 22);
+    std::vector<uint32_t> sparse = randomValues(50000, 1 << 22);
+    values.insert(values.end(), sparse.begin(), sparse.end());
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+
+    RoaringBitmap bitmap;
+    build(values, bitmap, true);
+    bitmap.runOptimize();
+
+    std::vector<uint64_t> storage(bitmap.serializedSizeInBytes() / 8 + 1);
+    char* buf = reinterpret_cast<char*>(&storage[0]);
+    size_t size = bitmap.serialize(buf);
+    BOOST_CHECK_EQUAL(size, bitmap.serializedSizeInBytes());
+
+    RoaringBitmapView view;
+    BOOST_REQUIRE(view.init(buf, size));
+    BOOST_CHECK_EQUAL(view.getCardinality(), values.size());
+    for (uint32_t x = 0; x < (1 << 22); x += 7)
+    {
+        BOOST_CHECK_EQUAL(view.contains(x), std::binary_search(values.begin(), values.end(), x));
+    }
+    std::vector<uint32_t> viewed;
+    view.toArray(viewed);
+    BOOST_CHECK(viewed == values);
+
+    RoaringBitmap copy;
+    BOOST_REQUIRE(copy.deserialize(buf, size));
+    BOOST_CHECK(toArray(copy) == values);
+    BOOST_CHECK(!copy.deserialize(buf, 8));
+
+    // the headers inconsistent with their payloads are rejected
+    std::vector<uint64_t> corrupt(storage);
+    char* bad = reinterpret_cast<char*>(&corrupt[0]);
+    RoaringSerialHeader* headers = reinterpret_cast<RoaringSerialHeader*>(bad + ROARING_SERIAL_PREFIX);
+    uint32_t chunkNum = view.getChunkNum();
+    BOOST_REQUIRE(chunkNum > 1);
+    uint32_t badRunNum = 0;
+    for (uint32_t i = 0; i < chunkNum; ++i)
+    {
+        RoaringSerialHeader saved = headers[i];
+        if (saved.type == RoaringChunk::ARRAY)
+        {
+            headers[i].cardinality = saved.cardinality + 1;
+            BOOST_CHECK(!view.init(bad, size));
+            headers[i].size = 2 * headers[i].cardinality;
+            BOOST_CHECK(!view.init(bad, size));
+        }
+        else if (saved.type == RoaringChunk::BITMAP)
+        {
+            headers[i].size = saved.size * 2;
+            BOOST_CHECK(!view.init(bad, size));
+        }
+        else if (saved.type == RoaringChunk::RUN)
+        {
+            headers[i].size = saved.size + 2;
+            BOOST_CHECK(!view.init(bad, size));
+            headers[i] = saved;
+
+            // the runs are checked against the header
+            uint16_t* runs = reinterpret_cast<uint16_t*>(bad + saved.offset);
+            uint32_t last = saved.size / 4 - 1;
+            std::vector<uint16_t> savedRuns(runs, runs + 2 * (last + 1));
+
+            headers[i].cardinality = saved.cardinality - 1;
+            checkBadRuns(view, bad, size, headers[i]);
+            headers[i] = saved;
+
+            if (runs[2 * last + 1] > 0)
+            {
+                // the last run ends past the chunk
+                runs[2 * last] = MAX_CHUNK_CAPACITY - runs[2 * last + 1];
+                checkBadRuns(view, bad, size, saved);
+                ++badRunNum;
+            }
+            std::copy(savedRuns.begin(), savedRuns.end(), runs);
+
+            if (last > 0)
+            {
+                std::swap(runs[0], runs[2]);
+                std::swap(runs[1], runs[3]);
+                checkBadRuns(view, bad, size, saved);
+                std::copy(savedRuns.begin(), savedRuns.end(), runs);
+
+                // the second run starts inside the first one
+                runs[2] = runs[0] + runs[1];
+                checkBadRuns(view, bad, size, saved);
+                std::copy(savedRuns.begin(), savedRuns.end(), runs);
+                ++badRunNum;
+            }
+        }
+        headers[i] = saved;
+        headers[i].type = RoaringChunk::TYPE_END;
+        BOOST_CHECK(!copy.deserialize(bad, size));
+        headers[i] = saved;
+    }
+    BOOST_CHECK(badRunNum > 1);
+    std::swap(headers[0].key, headers[1].key);
+    BOOST_CHECK(!view.init(bad, size));
+    std::swap(headers[0].key, headers[1].key);
+    std::reverse(bad, bad + 4);
+    BOOST_CHECK(!view.init(bad, size));
+    std::reverse(bad, bad + 4);
+    BOOST_CHECK(view.init(bad, size));
+}
+
+BOOST_AUTO_TEST_CASE(benchIntersection)
+{
+    srand(19);
+    std::vector<uint32_t> a = randomValues(2000000, 1 << 26);
+    std::vector<uint32_t> b = randomValues(2000000, 1 << 26);
+    RoaringBitmap ra, rb;
+    build(a, ra, true);
+    build(b, rb, true);
+
+    izenelib::util::ClockTimer timer;
+    size_t card = 0;
+    for (int i = 0; i < 10; ++i)
+        card += (ra & rb).getCardinality();
+    std::cout << "array x array intersection: " << timer.elapsed() / 10 << " s, " << card / 10 << std::endl;
+
+    std::vector<uint32_t> c = clusteredValues(2000, 1 << 26);
+    std::vector<uint32_t> d = clusteredValues(2000, 1 << 26);
+    RoaringBitmap rc, rd;
+    build(c, rc, true);
+    build(d, rd, true);
+
+    timer.restart();
+    for (int i = 0; i < 10; ++i)
+        card += (rc & rd).getCardinality();
+    std::cout << "clustered intersection: " << timer.elapsed() / 10 << " s" << std::endl;
+
+    rc.runOptimize();
+    rd.runOptimize();
+    timer.restart();
+    for (int i = 0; i < 10; ++i)
+        card += (rc & rd).getCardinality();
+    std::cout << "clustered intersection with runs: " << timer.elapsed() / 10 << " s" << std::endl;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,260 @@
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+#include <am/concurrent/art.hpp>
+#include <am/mt_trie/concurrent_mt_trie.hpp>
+#include <util/ustring/UString.h>
+
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+using izenelib::am::concurrent::ART;
+using izenelib::am::ConcurrentMtTrie;
+using izenelib::util::UString;
+
+namespace
+{
+
+typedef ART<uint32_t> TrieType;
+
+/// keys sharing long prefixes, with zero bytes, and prefixes of each other
+string randomKey()
+{
+    static const char* prefixes[] = {"", "a", "ab", "abcdefghijklmnop", "abcdefghijklmnopq",
+                                     "abcdefghijkl\0mn", "zzzzzzzzzzzzzzzzzzzzzzzz"};
+    static const size_t lengths[] = {0, 1, 2, 16, 17, 15, 24};
+    size_t p = rand() % 7;
+    string key(prefixes[p], lengths[p]);
+    size_t len = rand() % 6;
+    for (size_t i = 0; i < len; ++i)
+        key.push_back((char)(rand() % 3 == 0 ? rand() % 256 : 'a' + rand() % 4));
+    return key;
+}
+
+struct Collector
+{
+    Collector() : max((size_t)-1) {}
+
+    bool operator()(const char* key, size_t len, uint32_t value)
+    {
+        keys.push_back(make_pair(string(key, len), value));
+        return keys.size() < max;
+    }
+
+    size_t max;
+    vector<pair<string, uint32_t> > keys;
+};
+
+struct Increase
+{
+    void operator()(uint32_t& value) const { ++value; }
+};
+
+void increaseKeys(TrieType* trie, size_t keyNum, size_t rounds)
+{
+    for (size_t r = 0; r < rounds; ++r)
+    {
+        for (size_t i = 0; i < keyNum; ++i)
+        {
+            char key[24];
+            int len = snprintf(key, sizeof(key), "key%lu", (unsigned long)((i * 7919 + r) % keyNum));
+            trie->update(key, len, 1, Increase());
+        }
+    }
+}
+
+/// counts the scans seeing the keys out of order, or a value out of range
+void scanKeys(TrieType* trie, const boost::atomic<bool>* stop, size_t* errors)
+{
+    while (!stop->load())
+    {
+        Collector collector;
+        trie->scanPrefix("key1", 4, collector);
+        for (size_t i = 0; i < collector.keys.size(); ++i)
+        {
+            if (collector.keys[i].first.compare(0, 4, "key1") != 0
+                    || collector.keys[i].second == 0
+                    || (i > 0 && !(collector.keys[i - 1].first < collector.keys[i].first)))
+                ++*errors;
+        }
+    }
+}
+
+void insertTerms(ConcurrentMtTrie<string>* trie, size_t thread, size_t termNum)
+{
+    for (size_t i = 0; i < termNum; ++i)
+    {
+        char term[24];
+        snprintf(term, sizeof(term), "t%lu", (unsigned long)((i + thread) % termNum));
+        trie->insert(term);
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(t_concurrent_art_suite)
+
+BOOST_AUTO_TEST_CASE(insert_find)
+{
+    TrieType trie;
+    BOOST_CHECK(trie.empty());
+    BOOST_CHECK(trie.insert("abc", 1));
+    BOOST_CHECK(trie.insert("ab", 2));
+    BOOST_CHECK(trie.insert("abcd", 3));
+    BOOST_CHECK(trie.insert("", 4));
+    BOOST_CHECK(!trie.insert("abc", 5));
+    BOOST_CHECK_EQUAL(trie.size(), 4U);
+
+    uint32_t value = 0;
+    BOOST_CHECK(trie.get("abc", value));
+    BOOST_CHECK_EQUAL(value, 1U);
+    BOOST_CHECK(trie.get("", value));
+    BOOST_CHECK_EQUAL(value, 4U);
+    BOOST_CHECK(!trie.get("a", value));
+    BOOST_CHECK(!trie.get("abcde", value));
+
+    BOOST_CHECK(!trie.set("abc", 6));
+    BOOST_CHECK(trie.get("abc", value));
+    BOOST_CHECK_EQUAL(value, 6U);
+
+    Collector collector;
+    trie.scanPrefix("ab", collector);
+    BOOST_REQUIRE_EQUAL(collector.keys.size(), 3U);
+    BOOST_CHECK_EQUAL(collector.keys[0].first, "ab");
+    BOOST_CHECK_EQUAL(collector.keys[1].first, "abc");
+    BOOST_CHECK_EQUAL(collector.keys[2].second, 3U);
+}
+
+BOOST_AUTO_TEST_CASE(random_keys)
+{
+    srand(11);
+    TrieType trie;
+    map<string, uint32_t> expected;
+    for (uint32_t i = 0; i < 50000; ++i)
+    {
+        string key = randomKey();
+        bool inserted = expected.insert(make_pair(key, i)).second;
+        BOOST_REQUIRE_EQUAL(trie.insert(key, i), inserted);
+    }
+    BOOST_CHECK_EQUAL(trie.size(), expected.size());
+
+    for (map<string, uint32_t>::const_iterator it = expected.begin(); it != expected.end(); ++it)
+    {
+        uint32_t value = 0;
+        BOOST_REQUIRE(trie.get(it->first, value));
+        BOOST_REQUIRE_EQUAL(value, it->second);
+    }
+    for (size_t i = 0; i < 10000; ++i)
+    {
+        string key = randomKey();
+        uint32_t value = 0;
+        BOOST_REQUIRE_EQUAL(trie.get(key, value), expected.count(key) > 0);
+    }
+
+    // the scans are in the order of the map
+    Collector all;
+    trie.scan(all);
+    vector<pair<string, uint32_t> > sorted(expected.begin(), expected.end());
+    BOOST_CHECK(all.keys == sorted);
+
+    for (size_t i = 0; i < 200; ++i)
+    {
+        string key = randomKey();
+        string prefix = key.substr(0, rand() % (key.size() + 1));
+        Collector collector;
+        trie.scanPrefix(prefix, collector);
+
+        vector<pair<string, uint32_t> > prefixed;
+        for (map<string, uint32_t>::const_iterator it = expected.lower_bound(prefix);
+                it != expected.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it)
+            prefixed.push_back(*it);
+        BOOST_REQUIRE(collector.keys == prefixed);
+    }
+
+    Collector first;
+    first.max = 3;
+    trie.scan(first);
+    BOOST_CHECK_EQUAL(first.keys.size(), 3U);
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_update)
+{
+    const size_t threadNum = 4;
+    const size_t keyNum = 5000;
+    const size_t rounds = 10;
+
+    TrieType trie;
+    boost::atomic<bool> stop(false);
+    size_t errors = 0;
+    boost::thread scanner(boost::bind(scanKeys, &trie, &stop, &errors));
+
+    boost::thread_group writers;
+    for (size_t i = 0; i < threadNum; ++i)
+        writers.create_thread(boost::bind(increaseKeys, &trie, keyNum, rounds));
+    writers.join_all();
+    stop.store(true);
+    scanner.join();
+
+    BOOST_CHECK_EQUAL(errors, 0U);
+    BOOST_CHECK_EQUAL(trie.size(), keyNum);
+    for (size_t i = 0; i < keyNum; ++i)
+    {
+        char key[24];
+        int len = snprintf(key, sizeof(key), "key%lu", (unsigned long)i);
+        uint32_t value = 0;
+        BOOST_REQUIRE(trie.get(key, len, value));
+        BOOST_REQUIRE_EQUAL(value, threadNum * rounds);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(concurrent_mt_trie)
+{
+    ConcurrentMtTrie<string> trie;
+    boost::thread_group writers;
+    for (size_t i = 0; i < 4; ++i)
+        writers.create_thread(boost::bind(insertTerms, &trie, i, 1000));
+    writers.join_all();
+    BOOST_CHECK_EQUAL(trie.size(), 1000U);
+    BOOST_CHECK_EQUAL(trie.count("t10"), 4U);
+
+    trie.insert("t10");
+    trie.insert("t10");
+    trie.insert("t12");
+    trie.insert("earth");
+    trie.insert("hearth");
+
+    vector<string> keys;
+    BOOST_CHECK(trie.findRegExp("t1?", keys, 3));
+    BOOST_REQUIRE_EQUAL(keys.size(), 3U);
+    BOOST_CHECK_EQUAL(keys[0], "t10");
+    BOOST_CHECK_EQUAL(keys[1], "t12");
+    BOOST_CHECK_EQUAL(keys[2], "t11");
+
+    keys.clear();
+    BOOST_CHECK(trie.findRegExp("*ear?h", keys, 10));
+    BOOST_REQUIRE_EQUAL(keys.size(), 2U);
+    BOOST_CHECK_EQUAL(keys[0], "earth");
+    BOOST_CHECK_EQUAL(keys[1], "hearth");
+
+    keys.clear();
+    BOOST_CHECK(trie.findPrefix("t99", keys, 20));
+    BOOST_CHECK_EQUAL(keys.size(), 11U);
+    keys.clear();
+    BOOST_CHECK(!trie.findPrefix("x", keys, 20));
+
+    ConcurrentMtTrie<UString> utrie;
+    utrie.insert(UString("中国", UString::UTF_8));
+    utrie.insert(UString("中国人", UString::UTF_8));
+    utrie.insert(UString("中国人", UString::UTF_8));
+    vector<UString> ukeys;
+    BOOST_CHECK(utrie.findRegExp(UString("中*", UString::UTF_8), ukeys, 10));
+    BOOST_REQUIRE_EQUAL(ukeys.size(), 2U);
+    BOOST_CHECK(ukeys[0] == UString("中国人", UString::UTF_8));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
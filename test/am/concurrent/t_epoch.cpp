@@ -0,0 +1,240 @@
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/bind.hpp>
+
+#include <am/concurrent/epoch.hpp>
+#include <am/concurrent/skiplist.hpp>
+#include <am/concurrent/LFVector.h>
+
+#include <limits.h>
+#include <vector>
+
+using namespace izenelib::am::concurrent;
+
+namespace
+{
+
+/// counts its instances, and checks it is read alive
+class Counted
+{
+public:
+    enum { ALIVE = 0x600dcafe, DEAD = 0xdeadbeef };
+
+    Counted(int v = 0) : value_(v), magic_(ALIVE)
+    {
+        ++live;
+    }
+
+    Counted(const Counted& other) : value_(other.value_), magic_(ALIVE)
+    {
+        ++live;
+    }
+
+    Counted& operator=(const Counted& other)
+    {
+        value_ = other.value_;
+        return *this;
+    }
+
+    ~Counted()
+    {
+        magic_ = DEAD;
+        --live;
+    }
+
+    bool alive() const
+    {
+        return magic_ == ALIVE;
+    }
+
+    int value() const
+    {
+        return value_;
+    }
+
+    static boost::atomic<int> live;
+
+private:
+    int value_;
+    volatile unsigned magic_;
+};
+
+boost::atomic<int> Counted::live(0);
+
+void deleteCounted(void* p)
+{
+    delete static_cast<Counted*>(p);
+}
+
+/// stays in an epoch until told to leave
+void holdEpoch(boost::barrier* entered, boost::barrier* leave)
+{
+    EpochGuard epoch;
+    entered->wait();
+    leave->wait();
+}
+
+typedef SkipList<int, Counted, 8> ListType;
+
+/// adds, removes and reads random keys, counting the dead values read
+void updateList(ListType* list, unsigned seed, int ops, boost::atomic<int>* errors)
+{
+    for (int i = 0; i < ops; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        int key = (seed >> 8) % 512;
+        switch ((seed >> 4) % 4)
+        {
+        case 0:
+            list->add(key, Counted(key));
+            break;
+        case 1:
+            list->remove(key);
+            break;
+        case 2:
+        {
+            ListType::iterator it = list->get(key);
+            if (it != list->end() && (!it->second.alive() || it->second.value() != key))
+                ++*errors;
+            break;
+        }
+        default:
+        {
+            // walks some nodes, being removed by the other threads
+            ListType::iterator it = list->lower_bound(key);
+            ListType::iterator end = list->end();
+            for (int n = 0; n < 16 && it != end; ++n, ++it)
+            {
+                if (!it->second.alive())
+                    ++*errors;
+            }
+        }
+        }
+    }
+    EpochManager::instance().collect();
+}
+
+typedef LFVector<Counted> VectorType;
+
+void pushPop(VectorType* vector, int ops, boost::atomic<int>* errors)
+{
+    for (int i = 0; i < ops; ++i)
+    {
+        vector->push_back(Counted(i));
+        if (i % 3 == 0)
+            vector->pop_back();
+        size_t size = vector->size();
+        if (size > 0 && !vector->at(size - 1).alive())
+            ++*errors;
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(t_concurrent_epoch_suite)
+
+BOOST_AUTO_TEST_CASE(retire_after_readers)
+{
+    EpochManager& manager = EpochManager::instance();
+    manager.collect();
+    manager.collect();
+    manager.collect();
+    int live = Counted::live;
+
+    boost::barrier entered(2), leave(2);
+    boost::thread reader(boost::bind(holdEpoch, &entered, &leave));
+    entered.wait();
+
+    // the reader may still read them, whatever the number of collections
+    for (int i = 0; i < 1000; ++i)
+        manager.retire(new Counted(i), &deleteCounted);
+    for (int i = 0; i < 10; ++i)
+        manager.collect();
+    BOOST_CHECK_EQUAL(Counted::live.load(), live + 1000);
+
+    leave.wait();
+    reader.join();
+    manager.collect();
+    manager.collect();
+    manager.collect();
+    BOOST_CHECK_EQUAL(Counted::live.load(), live);
+
+    // nested in the same thread
+    {
+        EpochGuard outer;
+        {
+            EpochGuard inner;
+            manager.retire(new Counted(0), &deleteCounted);
+        }
+        manager.collect();
+        manager.collect();
+        manager.collect();
+    }
+    manager.collect();
+    manager.collect();
+    manager.collect();
+    BOOST_CHECK_EQUAL(Counted::live.load(), live);
+}
+
+BOOST_AUTO_TEST_CASE(skiplist_stress)
+{
+    const int threadNum = 4;
+    const int ops = 50000;
+    boost::atomic<int> errors(0);
+    {
+        ListType list(INT_MIN, INT_MAX);
+        boost::thread_group threads;
+        for (int i = 0; i < threadNum; ++i)
+            threads.create_thread(boost::bind(updateList, &list, i + 1, ops, &errors));
+        threads.join_all();
+
+        // the removed nodes are deleted, the values of the others are alive
+        EpochManager::instance().collect();
+        EpochManager::instance().collect();
+        EpochManager::instance().collect();
+        BOOST_CHECK_EQUAL(EpochManager::instance().pending(), 0U);
+
+        int previous = INT_MIN;
+        size_t count = 0;
+        for (ListType::iterator it = ++list.begin(), end = list.end(); it != end; ++it, ++count)
+        {
+            BOOST_REQUIRE(previous < it->first);
+            previous = it->first;
+        }
+        BOOST_CHECK_EQUAL(Counted::live.load(), (int)count + 2);
+    }
+    EpochManager::instance().collect();
+    EpochManager::instance().collect();
+    EpochManager::instance().collect();
+    BOOST_CHECK_EQUAL(errors.load(), 0);
+    BOOST_CHECK_EQUAL(Counted::live.load(), 0);
+    BOOST_CHECK_EQUAL(EpochManager::instance().pending(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(lfvector_stress)
+{
+    const int threadNum = 4;
+    const int ops = 30000;
+    boost::atomic<int> errors(0);
+    {
+        VectorType vector;
+        boost::thread_group threads;
+        for (int i = 0; i < threadNum; ++i)
+            threads.create_thread(boost::bind(pushPop, &vector, ops, &errors));
+        threads.join_all();
+
+        BOOST_CHECK_EQUAL(vector.size(), (size_t)threadNum * (ops - (ops + 2) / 3));
+        for (size_t i = 0; i < vector.size(); ++i)
+            BOOST_REQUIRE(vector.at(i).alive());
+        BOOST_CHECK_THROW(vector.at(vector.size()), std::out_of_range);
+    }
+    EpochManager::instance().collect();
+    EpochManager::instance().collect();
+    EpochManager::instance().collect();
+    BOOST_CHECK_EQUAL(errors.load(), 0);
+    BOOST_CHECK_EQUAL(Counted::live.load(), 0);
+    BOOST_CHECK_EQUAL(EpochManager::instance().pending(), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -38,6 +38,7 @@
 #include <am/external_sort/sort_runner.hpp>
 #include <am/external_sort/sort_merger.hpp>
 #include <am/external_sort/izene_sort.hpp>
+#include <algorithm>
 #include <sys/time.h>
 #include <signal.h>
 
@@ -213,7 +214,7 @@ void check_merger(const uint64_t SIZE, uint32_t bs=100000000)
 
 
 template<class KEY_TYPE, class LEN_TYPE>
-void check_izene_sort(uint32_t SIZE = 200000, uint32_t bs =1000000)
+void check_izene_sort(uint32_t SIZE = 200000, uint32_t bs =1000000, uint32_t thread_num = 1)
 {
   boost::filesystem::remove("./tt");
   boost::filesystem::remove("./tt.out");
@@ -222,6 +223,7 @@ void check_izene_sort(uint32_t SIZE = 200000, uint32_t bs =1000000)
   struct timezone tz;
   
   IzeneSort<KEY_TYPE, LEN_TYPE, true> sorter("./tt", bs);
+  sorter.set_thread_num(thread_num);
 
   cout<<"\n-----------------------------\n";
   std::vector<char> str;
@@ -257,6 +259,51 @@ void check_izene_sort(uint32_t SIZE = 200000, uint32_t bs =1000000)
   }
 }
 
+/**
+   random keys with duplicates, the parallel output must be ordered like
+   the one of SortRunner::KEY_PTR and hold the same records as the input.
+ */
+template<class KEY_TYPE, class LEN_TYPE>
+void check_parallel_izene_sort(uint32_t SIZE, uint32_t bs, uint32_t thread_num)
+{
+  boost::filesystem::remove("./tt");
+  boost::filesystem::remove("./tt.out");
+
+  IzeneSort<KEY_TYPE, LEN_TYPE, true> sorter("./tt", bs);
+  sorter.set_thread_num(thread_num);
+
+  std::vector<std::string> input;
+  for (uint32_t i=0; i<SIZE; ++i)
+  {
+    std::vector<char> str = randstr<KEY_TYPE>((KEY_TYPE)(rand()%(SIZE/4+1)-(int)(SIZE/8)));
+    sorter.add_data(str.size(), str.data());
+    input.push_back(std::string(str.begin(), str.end()));
+  }
+  sorter.sort();
+
+  typedef SortRecordCompare<KEY_TYPE, LEN_TYPE, true> cmp_t;
+  std::vector<std::string> output;
+  std::string last;
+  char* data;
+  LEN_TYPE len;
+  CHECK(sorter.begin());
+  CHECK(sorter.item_num() == SIZE);
+  while (sorter.next_data(len, &data))
+  {
+    std::string rec((char*)&len, sizeof(LEN_TYPE));
+    rec.append(data, len);
+    free(data);
+    if (!last.empty())
+      CHECK(cmp_t::compare(last.data(), rec.data()) <= 0);
+    last = rec;
+    output.push_back(rec.substr(sizeof(LEN_TYPE)));
+  }
+
+  std::sort(input.begin(), input.end());
+  std::sort(output.begin(), output.end());
+  CHECK(input == output);
+}
+
 BOOST_AUTO_TEST_CASE(izenesort_runner_test)
 {
     check_runner<uint32_t, uint8_t>(1000, 1000000);
@@ -276,6 +323,15 @@ BOOST_AUTO_TEST_CASE(izenesort_test)
   check_izene_sort<uint32_t, uint8_t>(2, 1000);
 }
 
+BOOST_AUTO_TEST_CASE(izenesort_parallel_test)
+{
+  check_izene_sort<uint64_t, uint16_t>(1000, 100000, 4);
+  check_izene_sort<uint32_t, uint8_t>(100000, 1000000, 4);
+  check_parallel_izene_sort<uint32_t, uint8_t>(100000, 1000000, 3);
+  check_parallel_izene_sort<int32_t, uint16_t>(50000, 500000, 8);
+  check_parallel_izene_sort<uint64_t, uint8_t>(20000, 200000, 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 
@@ -0,0 +1,79 @@
+/// @file   t_izene_sort_bench.cpp
+/// @brief  Throughput of IzeneSort with 1 to 32 sorting threads.
+///
+/// usage: manual_t_izenesort_bench [record number] [buffer size] [max threads]
+///
+/// The same input is sorted by the serial SortRunner/SortMerger and by the
+/// parallel runner/merger with 1, 2, 4, ... threads, the throughput is the
+/// input size divided by the time of run generation plus merging.
+#include <am/external_sort/izene_sort.hpp>
+#include <boost/filesystem.hpp>
+#include <util/ClockTimer.h>
+
+#include <iostream>
+#include <stdlib.h>
+
+using namespace izenelib::am;
+
+typedef IzeneSort<uint64_t, uint8_t, true> sorter_t;
+
+static const char* INPUT = "./izene_sort_bench.in";
+static const char* WORK = "./izene_sort_bench";
+
+double sort_mb_per_second(uint32_t bs, uint32_t thread_num, bool parallel)
+{
+  boost::filesystem::remove(WORK);
+  boost::filesystem::copy_file(INPUT, WORK);
+  const double mb = boost::filesystem::file_size(WORK)/1024./1024.;
+
+  izenelib::util::ClockTimer timer;
+  if (parallel)
+  {
+    //driven directly, IzeneSort keeps the serial path for a single thread
+    sorter_t::prun_t runner(WORK, bs, thread_num);
+    runner.run();
+    sorter_t::pmerge_t merger(WORK, runner.run_num(), bs);
+    merger.set_params(runner.max_record_len(), runner.min_run_buf_size_for_merger());
+    merger.run();
+  }
+  else
+  {
+    sorter_t sorter(WORK, bs);
+    sorter.sort();
+  }
+  double seconds = timer.elapsed();
+  boost::filesystem::remove(WORK);
+  return mb/seconds;
+}
+
+int main(int argc, char** argv)
+{
+  const uint32_t SIZE = argc > 1? atoi(argv[1]): 10000000;
+  const uint32_t BS = argc > 2? atoi(argv[2]): 100000000;
+  const uint32_t MAX_THREADS = argc > 3? atoi(argv[3]): 32;
+
+  boost::filesystem::remove(INPUT);
+  {
+    sorter_t sorter(INPUT, BS);
+    char buf[64];
+    for (uint32_t i=0; i<SIZE; ++i)
+    {
+      uint32_t len = sizeof(uint64_t)+rand()%(sizeof(buf)-sizeof(uint64_t));
+      for (uint32_t j=0; j<len; ++j)
+        buf[j] = 'a'+rand()%26;
+      uint64_t key = ((uint64_t)rand()<<32)|rand();
+      memcpy(buf, &key, sizeof(key));
+      sorter.add_data(len, buf);
+    }
+    sorter.flush();
+  }
+
+  std::cout<<"records: "<<SIZE<<", input: "
+           <<boost::filesystem::file_size(INPUT)/1024./1024.<<" MB, buffer: "<<BS<<std::endl;
+  std::cout<<"serial\t"<<sort_mb_per_second(BS, 1, false)<<" MB/s"<<std::endl;
+  for (uint32_t t=1; t<=MAX_THREADS; t*=2)
+    std::cout<<t<<" threads\t"<<sort_mb_per_second(BS, t, true)<<" MB/s"<<std::endl;
+
+  boost::filesystem::remove(INPUT);
+  return 0;
+}
@@ -15,6 +15,8 @@
 #include <am/range/AmIterator.h>
 #include <sdb/SDBCursorIterator.h>
 
+#include "../BatchTestHelper.h"
+
 #define DIR_PREFIX "./tmp/am_level_Db_"
 
 using namespace izenelib::am::leveldb;
@@ -125,5 +127,18 @@ BOOST_AUTO_TEST_CASE(Simple_test)
     destroy_data();
 }
 
+BOOST_AUTO_TEST_CASE(Batch_test)
+{
+    bfs::path db_dir(DIR_PREFIX);
+    boost::filesystem::remove_all(db_dir);
+    bfs::create_directories(db_dir);
+    std::string db_dir_str = db_dir.string();
+
+    typedef Table<int,int> LevelDBType;
+    LevelDBType table(db_dir_str+"/LevelDB_batch");
+    BOOST_CHECK(table.open());
+    checkBatch(table);
+}
+
 BOOST_AUTO_TEST_SUITE_END() // leveldb_Db_test
 
@@ -13,6 +13,9 @@
 
 #include <am/lmdb/Mdb.h>
 #include <am/range/AmIterator.h>
+#include <util/ClockTimer.h>
+
+#include "../BatchTestHelper.h"
 
 #define DIR_PREFIX "./tmp/am_lmdb_Db_"
 
@@ -72,5 +75,129 @@ BOOST_AUTO_TEST_CASE(Simple_test)
 
 }
 
+BOOST_AUTO_TEST_CASE(Batch_test)
+{
+    bfs::path db_dir(DIR_PREFIX);
+    boost::filesystem::remove_all(db_dir);
+    bfs::create_directories(db_dir);
+    std::string db_dir_str = db_dir.string();
+
+    typedef Mdb<int,int> MDBType;
+    MDBType table(db_dir_str+"/lmdb_batch");
+    checkBatch(table);
+}
+
+BOOST_AUTO_TEST_CASE(Batch_failure_test)
+{
+    bfs::path db_dir(DIR_PREFIX);
+    boost::filesystem::remove_all(db_dir);
+    bfs::create_directories(db_dir);
+    std::string db_dir_str = db_dir.string();
+
+    // a map of 1MB cannot hold the batch, the values of the DUPSORT
+    // database are at most 511 bytes
+    typedef Mdb<int, std::string> MDBType;
+    MDBType table(db_dir_str+"/lmdb_batch_full", 1);
+    const std::string payload(400, 'x');
+
+    WriteBatch<int, std::string> batch;
+    batch.del(0);
+    for (int i = 1; i <= 5000; ++i)
+        batch.insert(i, payload);
+    BOOST_CHECK(!table.writeBatch(batch));
+
+    // nothing of the batch is applied, and the table is still usable
+    std::string value;
+    BOOST_CHECK(!table.get(1, value));
+
+    // deleting a missing key does not fail the batch
+    WriteBatch<int, std::string> small;
+    small.del(0);
+    small.insert(1, payload);
+    BOOST_CHECK(table.writeBatch(small));
+    BOOST_CHECK(table.get(1, value));
+    BOOST_CHECK_EQUAL(value, payload);
+}
+
+namespace {
+struct PrefixScanner
+{
+    std::vector<std::string>* keys;
+    explicit PrefixScanner(std::vector<std::string>* k) : keys(k) {}
+    bool operator()(const MdbView<std::string>& key, const MdbView<std::string>& value)
+    {
+        keys->push_back(key.get());
+        return true;
+    }
+};
+}
+
+BOOST_AUTO_TEST_CASE(ZeroCopy_test)
+{
+    bfs::path db_dir(DIR_PREFIX);
+    boost::filesystem::remove_all(db_dir);
+    bfs::create_directories(db_dir);
+    std::string db_dir_str = db_dir.string();
+
+    typedef Mdb<int, std::string> MDBType;
+    MDBType table(db_dir_str+"/lmdb_view");
+    const int size = 10000;
+    const std::string payload(200, 'x');
+
+    WriteBatch<int, std::string> batch;
+    for (int i = 1; i <= size; ++i)
+        batch.insert(i, payload);
+    BOOST_CHECK(table.writeBatch(batch));
+
+    izenelib::util::ClockTimer timer;
+    std::size_t copied = 0;
+    std::string value;
+    for (int i = 1; i <= size; ++i)
+    {
+        BOOST_CHECK(table.get(i, value));
+        copied += value.size();
+    }
+    double copyTime = timer.elapsed();
+
+    timer.restart();
+    std::size_t viewed = 0;
+    {
+        MDBType::read_txn_type txn(table.rawTable());
+        MDBType::value_view_type view;
+        for (int i = 1; i <= size; ++i)
+        {
+            BOOST_CHECK(table.get(txn, i, view));
+            viewed += view.size();
+        }
+        BOOST_CHECK(!table.get(txn, size + 1, view));
+        BOOST_CHECK(table.get(txn, 1, view));
+        BOOST_CHECK_EQUAL(view.get(), payload);
+    }
+    double viewTime = timer.elapsed();
+    BOOST_CHECK(viewed >= copied);
+
+    typedef Mdb<std::string, std::string> StrMDBType;
+    StrMDBType strTable(db_dir_str+"/lmdb_view_str");
+    char key[16];
+    for (int i = 0; i < 100; ++i)
+    {
+        sprintf(key, "key%04d", i);
+        BOOST_CHECK(strTable.insert(key, payload));
+    }
+    {
+        // readers are recycled from the pool
+        StrMDBType::read_txn_type txn(strTable.rawTable());
+        std::vector<std::string> keys;
+        std::size_t count = strTable.scan(txn, "key0010", "key0019", PrefixScanner(&keys));
+        BOOST_CHECK_EQUAL(count, 10U);
+        BOOST_REQUIRE_EQUAL(keys.size(), 10U);
+        BOOST_CHECK_EQUAL(keys.front(), "key0010");
+        BOOST_CHECK_EQUAL(keys.back(), "key0019");
+    }
+
+    cout << "per key get: copy " << copyTime * 1e6 / size << "us, view "
+         << viewTime * 1e6 / size << "us" << endl;
+}
+
 BOOST_AUTO_TEST_SUITE_END() // lmdb_Db_test
 
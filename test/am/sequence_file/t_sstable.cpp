@@ -0,0 +1,150 @@
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+
+#include <am/sequence_file/SSTable.hpp>
+
+#include <map>
+#include <string>
+#include <stdio.h>
+
+using namespace izenelib::am;
+namespace bfs = boost::filesystem;
+
+namespace {
+
+const char* TABLE_FILE = "./tmp/am_sstable";
+
+std::string makeKey(uint32_t i)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "term%08u", i);
+    return buf;
+}
+
+struct ScanCollector
+{
+    std::vector<std::string>* keys;
+    size_t limit;
+
+    bool operator()(const std::string& key, const std::string&)
+    {
+        keys->push_back(key);
+        return keys->size() < limit;
+    }
+};
+
+void checkTable(const SSTableOptions& options, uint32_t num)
+{
+    bfs::create_directories("./tmp");
+    bfs::remove(TABLE_FILE);
+
+    //even keys only, odd ones are used for misses
+    std::map<std::string, std::string> expected;
+    {
+        SSTableWriter writer(TABLE_FILE, options);
+        writer.open();
+        for (uint32_t i = 0; i < num; ++i)
+        {
+            std::string key = makeKey(2 * i);
+            std::string value(i % 50, 'a' + i % 26);
+            BOOST_CHECK(writer.add(key, value));
+            expected[key] = value;
+        }
+        BOOST_CHECK(!writer.add(makeKey(0), "out of order"));
+        writer.close();
+    }
+
+    SSTableReader reader(TABLE_FILE);
+    reader.open();
+    BOOST_CHECK_EQUAL(reader.getItemCount(), num);
+
+    std::string value;
+    for (uint32_t i = 0; i < num; ++i)
+    {
+        BOOST_CHECK(reader.get(makeKey(2 * i), value));
+        BOOST_CHECK_EQUAL(value, expected[makeKey(2 * i)]);
+        BOOST_CHECK(!reader.get(makeKey(2 * i + 1), value));
+    }
+
+    SSTableReader::Iterator it(&reader);
+    std::map<std::string, std::string>::const_iterator eit = expected.begin();
+    for (it.seekToFirst(); it.valid(); it.next(), ++eit)
+    {
+        BOOST_REQUIRE(eit != expected.end());
+        BOOST_CHECK_EQUAL(it.key(), eit->first);
+        BOOST_CHECK_EQUAL(it.value(), eit->second);
+    }
+    BOOST_CHECK(eit == expected.end());
+
+    it.seek(makeKey(101));
+    BOOST_REQUIRE(it.valid());
+    BOOST_CHECK_EQUAL(it.key(), makeKey(102));
+    it.seek(makeKey(2 * num));
+    BOOST_CHECK(!it.valid());
+
+    std::vector<std::string> keys;
+    ScanCollector collector = {&keys, 1000};
+    reader.scan(makeKey(10), makeKey(21), collector);
+    BOOST_REQUIRE_EQUAL(keys.size(), 6U);
+    BOOST_CHECK_EQUAL(keys.front(), makeKey(10));
+    BOOST_CHECK_EQUAL(keys.back(), makeKey(20));
+
+    //misses rejected by the bloom filter without reading a block
+    if (options.bloomBitsPerKey > 0)
+    {
+        uint32_t falsePositive = 0;
+        for (uint32_t i = 0; i < num; ++i)
+            if (reader.mayContain(makeKey(2 * i + 1))) ++falsePositive;
+        BOOST_CHECK_LT(falsePositive, num / 20 + 1);
+    }
+
+    reader.close();
+    bfs::remove(TABLE_FILE);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(t_sstable)
+
+BOOST_AUTO_TEST_CASE(Plain_test)
+{
+    SSTableOptions options;
+    checkTable(options, 20000);
+
+    options.bloomBitsPerKey = 0;
+    options.restartInterval = 1;
+    options.blockSize = 64;
+    checkTable(options, 3000);
+}
+
+BOOST_AUTO_TEST_CASE(Compressed_test)
+{
+    SSTableOptions options;
+    options.compression = SSTABLE_LZ4;
+    checkTable(options, 20000);
+
+    options.compression = SSTABLE_SNAPPY;
+    options.blockSize = 16384;
+    checkTable(options, 20000);
+}
+
+BOOST_AUTO_TEST_CASE(Empty_test)
+{
+    bfs::create_directories("./tmp");
+    {
+        SSTableWriter writer(TABLE_FILE);
+        writer.open();
+        writer.close();
+    }
+    SSTableReader reader(TABLE_FILE);
+    reader.open();
+    std::string value;
+    BOOST_CHECK_EQUAL(reader.getItemCount(), 0U);
+    BOOST_CHECK(!reader.get("any", value));
+    SSTableReader::Iterator it(&reader);
+    it.seekToFirst();
+    BOOST_CHECK(!it.valid());
+    bfs::remove(TABLE_FILE);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,155 @@
+#include <boost/test/unit_test.hpp>
+
+#include <am/succinct/cbitv/cbitv.hpp>
+#include <am/succinct/fm-index/fm_index.hpp>
+
+#include <sstream>
+#include <cstdlib>
+
+using namespace std;
+using namespace izenelib::am::succinct;
+
+namespace
+{
+
+/// bits set with probability 1 / @p sparsity
+void randomBits(size_t len, size_t sparsity, vector<uint64_t> &bits, vector<bool> &naive)
+{
+    bits.assign((len + 63) / 64, 0);
+    naive.assign(len, false);
+    for (size_t i = 0; i < len; ++i)
+    {
+        if (rand() % sparsity == 0)
+        {
+            bits[i / 64] |= 1ULL << (i % 64);
+            naive[i] = true;
+        }
+    }
+}
+
+void checkBitV(const cbitv::CBitV &bv, const vector<bool> &naive)
+{
+    BOOST_REQUIRE_EQUAL(bv.length(), naive.size());
+
+    size_t rank1 = 0;
+    size_t rank0 = 0;
+    for (size_t i = 0; i < naive.size(); ++i)
+    {
+        BOOST_REQUIRE_EQUAL(bv.rank1(i), rank1);
+
+        size_t rank;
+        BOOST_REQUIRE_EQUAL(bv.access(i, rank), naive[i]);
+        if (naive[i])
+        {
+            BOOST_REQUIRE_EQUAL(rank, rank1);
+            BOOST_REQUIRE_EQUAL(bv.select1(rank1++), i);
+        }
+        else
+        {
+            BOOST_REQUIRE_EQUAL(rank, rank0);
+            BOOST_REQUIRE_EQUAL(bv.select0(rank0++), i);
+        }
+    }
+    BOOST_CHECK_EQUAL(bv.rank1(naive.size()), rank1);
+    BOOST_CHECK_EQUAL(bv.one_count(), rank1);
+    BOOST_CHECK_EQUAL(bv.zero_count(), rank0);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( t_cbitv_suite )
+
+BOOST_AUTO_TEST_CASE(rank_select)
+{
+    srand(3);
+    size_t lens[] = {0, 1, 63, 64, 447, 448, 449, 896, 100000, 262144};
+    size_t sparsities[] = {1, 2, 7, 300};
+
+    for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); ++i)
+    {
+        for (size_t j = 0; j < sizeof(sparsities) / sizeof(sparsities[0]); ++j)
+        {
+            vector<uint64_t> bits;
+            vector<bool> naive;
+            randomBits(lens[i], sparsities[j], bits, naive);
+
+            cbitv::CBitV bv(true);
+            bv.build(bits, lens[i]);
+            checkBitV(bv, naive);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(all_zeros)
+{
+    vector<uint64_t> bits(2000, 0);
+    vector<bool> naive(2000 * 64 - 5, false);
+
+    cbitv::CBitV bv(true);
+    bv.build(bits, naive.size());
+    checkBitV(bv, naive);
+}
+
+BOOST_AUTO_TEST_CASE(save_load)
+{
+    srand(5);
+    vector<uint64_t> bits;
+    vector<bool> naive;
+    randomBits(50000, 3, bits, naive);
+
+    cbitv::CBitV bv(true);
+    bv.build(bits, naive.size());
+
+    stringstream ss;
+    bv.save(ss);
+
+    cbitv::CBitV loaded(false);
+    loaded.load(ss);
+    checkBitV(loaded, naive);
+    BOOST_CHECK_EQUAL(loaded.allocSize(), bv.allocSize());
+}
+
+BOOST_AUTO_TEST_CASE(fm_index_bitmaps)
+{
+    srand(7);
+    fm_index::FMIndex<uint16_t> fmi;
+    fm_index::FMIndex<uint16_t, cbitv::CBitV, cbitv::CBitV> cfmi;
+
+    for (size_t i = 0; i < 2000; ++i)
+    {
+        vector<uint16_t> doc(1 + rand() % 40);
+        for (size_t j = 0; j < doc.size(); ++j)
+            doc[j] = 'a' + rand() % 6;
+        fmi.addDoc(&doc[0], doc.size());
+        cfmi.addDoc(&doc[0], doc.size());
+    }
+    fmi.build();
+
+    stringstream ss;
+    cfmi.build();
+    cfmi.save(ss);
+    fm_index::FMIndex<uint16_t, cbitv::CBitV, cbitv::CBitV> loaded;
+    loaded.load(ss);
+
+    for (size_t i = 0; i < 300; ++i)
+    {
+        vector<uint16_t> pattern(1 + rand() % 4);
+        for (size_t j = 0; j < pattern.size(); ++j)
+            pattern[j] = 'a' + rand() % 6;
+
+        fm_index::FMIndex<uint16_t>::MatchRangeT range, crange;
+        BOOST_REQUIRE_EQUAL(fmi.backwardSearch(&pattern[0], pattern.size(), range),
+                loaded.backwardSearch(&pattern[0], pattern.size(), crange));
+        BOOST_CHECK(range == crange);
+        if (range.first >= range.second) continue;
+
+        vector<uint32_t> docids, cdocids;
+        vector<size_t> doclens, cdoclens;
+        fmi.getMatchedDocIdList(range, 100, docids, doclens);
+        loaded.getMatchedDocIdList(crange, 100, cdocids, cdoclens);
+        BOOST_CHECK(docids == cdocids);
+        BOOST_CHECK(doclens == cdoclens);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
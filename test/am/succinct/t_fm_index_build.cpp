@@ -0,0 +1,126 @@
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include <csignal>
+
+#include <sys/resource.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <am/succinct/fm-index/fm_index.hpp>
+
+using namespace std;
+using namespace izenelib::am::succinct::fm_index;
+
+namespace
+{
+
+typedef FMIndex<uint16_t> FMIndexType;
+
+void addDocs(FMIndexType& fmi, size_t doc_num, size_t max_len, uint16_t alphabet)
+{
+    srand(17);
+    vector<uint16_t> doc;
+    for (size_t i = 0; i < doc_num; ++i)
+    {
+        doc.resize(rand() % max_len);
+        for (size_t j = 0; j < doc.size(); ++j)
+            doc[j] = 'a' + rand() % alphabet;
+        // repeated documents give suffixes equal up to their delimiter
+        if (i % 10 == 0 && i > 0)
+            doc.assign(3, 'a');
+        fmi.addDoc(doc.empty() ? NULL : &doc[0], doc.size());
+    }
+}
+
+void checkSameResults(const FMIndexType& expected, const FMIndexType& actual, uint16_t alphabet)
+{
+    BOOST_CHECK_EQUAL(expected.length(), actual.length());
+    BOOST_CHECK_EQUAL(expected.docCount(), actual.docCount());
+
+    vector<uint16_t> pattern;
+    for (size_t i = 0; i < 500; ++i)
+    {
+        pattern.resize(1 + rand() % 6);
+        for (size_t j = 0; j < pattern.size(); ++j)
+            pattern[j] = 'a' + rand() % alphabet;
+
+        FMIndexType::MatchRangeT expected_range, actual_range;
+        size_t expected_match = expected.backwardSearch(&pattern[0], pattern.size(), expected_range);
+        size_t actual_match = actual.backwardSearch(&pattern[0], pattern.size(), actual_range);
+        BOOST_CHECK_EQUAL(expected_match, actual_match);
+        if (expected_match == 0 || expected_match != actual_match) continue;
+
+        BOOST_CHECK_EQUAL(expected_range.second - expected_range.first,
+                          actual_range.second - actual_range.first);
+
+        vector<uint32_t> expected_docs, actual_docs;
+        vector<size_t> expected_lens, actual_lens;
+        expected.getMatchedDocIdList(expected_range, expected.docCount(), expected_docs, expected_lens);
+        actual.getMatchedDocIdList(actual_range, actual.docCount(), actual_docs, actual_lens);
+        sort(expected_docs.begin(), expected_docs.end());
+        sort(actual_docs.begin(), actual_docs.end());
+        BOOST_CHECK(expected_docs == actual_docs);
+
+        FMIndexType::MatchRangeListT expected_ranges, actual_ranges;
+        BOOST_CHECK_EQUAL(expected.longestSuffixMatch(&pattern[0], pattern.size(), expected_ranges),
+                          actual.longestSuffixMatch(&pattern[0], pattern.size(), actual_ranges));
+        BOOST_CHECK_EQUAL(expected_ranges.size(), actual_ranges.size());
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( t_fm_index_build )
+
+BOOST_AUTO_TEST_CASE(parallel_build)
+{
+    const uint16_t alphabet = 4;
+    FMIndexType expected;
+    addDocs(expected, 3000, 40, alphabet);
+    expected.build();
+
+    // one block, then many blocks on several threads
+    const size_t thread_nums[] = {1, 3, 4};
+    const size_t block_lens[] = {1 << 20, 1000, 37};
+    for (size_t i = 0; i < 3; ++i)
+    {
+        FMIndexType actual;
+        addDocs(actual, 3000, 40, alphabet);
+        BOOST_CHECK(actual.buildParallel(thread_nums[i], block_lens[i]));
+        checkSameResults(expected, actual, alphabet);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_build_failure)
+{
+    const uint16_t alphabet = 4;
+    FMIndexType expected;
+    addDocs(expected, 3000, 40, alphabet);
+    expected.build();
+
+    FMIndexType actual;
+    addDocs(actual, 3000, 40, alphabet);
+    size_t text_len = actual.bufferLength();
+
+    // the runs cannot be written past a small file size limit
+    struct rlimit saved;
+    BOOST_REQUIRE(getrlimit(RLIMIT_FSIZE, &saved) == 0);
+    struct rlimit limit = saved;
+    limit.rlim_cur = 1024;
+    void (*handler)(int) = signal(SIGXFSZ, SIG_IGN);
+    BOOST_REQUIRE(setrlimit(RLIMIT_FSIZE, &limit) == 0);
+    bool built = actual.buildParallel(2, 1000);
+    setrlimit(RLIMIT_FSIZE, &saved);
+    signal(SIGXFSZ, handler);
+
+    // the documents are kept for another build
+    BOOST_CHECK(!built);
+    BOOST_CHECK_EQUAL(actual.length(), 0U);
+    BOOST_CHECK_EQUAL(actual.bufferLength(), text_len);
+    BOOST_CHECK(actual.buildParallel(2, 1000));
+    checkSameResults(expected, actual, alphabet);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
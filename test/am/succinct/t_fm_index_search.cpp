@@ -0,0 +1,118 @@
+#include <boost/test/unit_test.hpp>
+
+#include <am/succinct/fm-index/fm_index.hpp>
+
+#include <cstdlib>
+
+using namespace std;
+using namespace izenelib::am::succinct;
+using namespace izenelib::am::succinct::fm_index;
+
+namespace
+{
+
+template <class FMIndexT>
+void buildIndex(FMIndexT &fmi, size_t doc_num)
+{
+    for (size_t i = 0; i < doc_num; ++i)
+    {
+        vector<uint16_t> doc(1 + rand() % 50);
+        for (size_t j = 0; j < doc.size(); ++j)
+            doc[j] = 'a' + rand() % 8;
+        fmi.addDoc(&doc[0], doc.size());
+    }
+    fmi.build();
+}
+
+/// patterns with chars out of the text now and then, and an empty one
+void randomPatterns(size_t num, size_t max_len, vector<vector<uint16_t> > &pattern_list)
+{
+    pattern_list.resize(num);
+    for (size_t i = 0; i < num; ++i)
+    {
+        pattern_list[i].resize(i == 7 ? 0 : 1 + rand() % max_len);
+        for (size_t j = 0; j < pattern_list[i].size(); ++j)
+            pattern_list[i][j] = rand() % 50 ? 'a' + rand() % 8 : 'z';
+    }
+}
+
+template <class FMIndexT>
+void checkBatchSearch(const FMIndexT &fmi)
+{
+    vector<vector<uint16_t> > pattern_list;
+    randomPatterns(500, 12, pattern_list);
+
+    vector<size_t> match_len_list;
+    typename FMIndexT::MatchRangeListT match_ranges;
+    fmi.backwardSearch(pattern_list, match_len_list, match_ranges);
+    BOOST_REQUIRE_EQUAL(match_len_list.size(), pattern_list.size());
+    BOOST_REQUIRE_EQUAL(match_ranges.size(), pattern_list.size());
+
+    for (size_t i = 0; i < pattern_list.size(); ++i)
+    {
+        typename FMIndexT::MatchRangeT range;
+        size_t match_len = pattern_list[i].empty() ? 0
+            : fmi.backwardSearch(&pattern_list[i][0], pattern_list[i].size(), range);
+        BOOST_CHECK_EQUAL(match_len_list[i], match_len);
+        if (match_len > 0)
+            BOOST_CHECK(match_ranges[i] == range);
+    }
+}
+
+template <class FMIndexT>
+void checkBatchSuffixMatch(const FMIndexT &fmi)
+{
+    vector<vector<uint16_t> > pattern_list;
+    randomPatterns(300, 30, pattern_list);
+
+    vector<size_t> max_match_list;
+    vector<typename FMIndexT::MatchRangeListT> match_ranges_list;
+    fmi.longestSuffixMatch(pattern_list, max_match_list, match_ranges_list);
+    BOOST_REQUIRE_EQUAL(max_match_list.size(), pattern_list.size());
+
+    for (size_t i = 0; i < pattern_list.size(); ++i)
+    {
+        typename FMIndexT::MatchRangeListT match_ranges;
+        size_t max_match = pattern_list[i].empty() ? 0
+            : fmi.longestSuffixMatch(&pattern_list[i][0], pattern_list[i].size(), match_ranges);
+        BOOST_CHECK_EQUAL(max_match_list[i], max_match);
+        BOOST_CHECK(match_ranges_list[i] == match_ranges);
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( t_fm_index_search )
+
+BOOST_AUTO_TEST_CASE(batch_backward_search)
+{
+    srand(19);
+    FMIndex<uint16_t> fmi;
+    buildIndex(fmi, 3000);
+    checkBatchSearch(fmi);
+
+    FMIndex<uint16_t, cbitv::CBitV, cbitv::CBitV> cfmi;
+    buildIndex(cfmi, 3000);
+    checkBatchSearch(cfmi);
+
+    FMIndex<uint16_t> empty;
+    vector<vector<uint16_t> > pattern_list(3, vector<uint16_t>(2, 'a'));
+    vector<size_t> match_len_list;
+    FMIndex<uint16_t>::MatchRangeListT match_ranges;
+    empty.backwardSearch(pattern_list, match_len_list, match_ranges);
+    BOOST_CHECK(match_len_list == vector<size_t>(3, 0));
+}
+
+BOOST_AUTO_TEST_CASE(batch_longest_suffix_match)
+{
+    srand(23);
+    FMIndex<uint16_t> fmi;
+    buildIndex(fmi, 3000);
+    checkBatchSuffixMatch(fmi);
+
+    FMIndex<uint16_t, dense::DBitV, dense::DBitV> dfmi;
+    buildIndex(dfmi, 3000);
+    checkBatchSuffixMatch(dfmi);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
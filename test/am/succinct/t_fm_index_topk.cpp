@@ -0,0 +1,155 @@
+#include <boost/test/unit_test.hpp>
+
+#include <am/succinct/fm-index/fm_index.hpp>
+
+#include <sstream>
+#include <cstdlib>
+
+using namespace std;
+using namespace izenelib::am::succinct;
+using namespace izenelib::am::succinct::fm_index;
+
+namespace
+{
+
+typedef vector<pair<size_t, uint32_t> > DocFreqListT;
+
+void randomDocs(size_t doc_num, size_t alphabet, vector<vector<uint16_t> > &docs)
+{
+    docs.resize(doc_num);
+    for (size_t i = 0; i < doc_num; ++i)
+    {
+        // a few long docs, so the top docs differ from the order of the ids
+        docs[i].resize(1 + rand() % (i % 17 ? 40 : 400));
+        for (size_t j = 0; j < docs[i].size(); ++j)
+            docs[i][j] = 'a' + rand() % alphabet;
+    }
+}
+
+/// the top docs by occurrences of @p pattern counted in @p docs, ids from 1
+void naiveTopK(const vector<vector<uint16_t> > &docs, const vector<uint16_t> &pattern, size_t k, DocFreqListT &results)
+{
+    results.clear();
+    for (size_t i = 0; i < docs.size(); ++i)
+    {
+        size_t freq = 0;
+        for (size_t j = 0; j + pattern.size() <= docs[i].size(); ++j)
+        {
+            if (equal(pattern.begin(), pattern.end(), docs[i].begin() + j)) ++freq;
+        }
+        if (freq) results.push_back(make_pair(freq, (uint32_t)i + 1));
+    }
+
+    // most first, the smaller id first on ties
+    for (size_t i = 0; i < results.size(); ++i)
+        results[i].second = ~results[i].second;
+    sort(results.rbegin(), results.rend());
+    for (size_t i = 0; i < results.size(); ++i)
+        results[i].second = ~results[i].second;
+
+    if (results.size() > k) results.resize(k);
+}
+
+template <class FMIndexT>
+void checkTopK(const FMIndexT &fmi, const vector<vector<uint16_t> > &docs, size_t max_len, size_t k)
+{
+    for (size_t i = 0; i < 300; ++i)
+    {
+        vector<uint16_t> pattern(1 + rand() % max_len);
+        for (size_t j = 0; j < pattern.size(); ++j)
+            pattern[j] = 'a' + rand() % 4;
+
+        DocFreqListT expected;
+        naiveTopK(docs, pattern, k, expected);
+
+        typename FMIndexT::MatchRangeT range;
+        DocFreqListT results;
+        vector<size_t> doclen_list;
+        if (fmi.backwardSearch(&pattern[0], pattern.size(), range) == pattern.size())
+        {
+            fmi.getTopKDocIdListByFreq(range, k, results, doclen_list);
+        }
+
+        BOOST_REQUIRE(results == expected);
+        for (size_t j = 0; j < results.size(); ++j)
+        {
+            BOOST_CHECK_EQUAL(doclen_list[j], docs[results[j].second - 1].size());
+        }
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( t_fm_index_topk )
+
+BOOST_AUTO_TEST_CASE(topk_doc_index)
+{
+    srand(37);
+    vector<vector<uint16_t> > docs;
+    randomDocs(2000, 4, docs);
+
+    FMIndex<uint16_t> fmi;
+    fmi.setTopKDocIndex(16, 32);
+    for (size_t i = 0; i < docs.size(); ++i)
+        fmi.addDoc(&docs[i][0], docs[i].size());
+    fmi.build();
+
+    checkTopK(fmi, docs, 6, 10);
+    checkTopK(fmi, docs, 6, 16);
+    checkTopK(fmi, docs, 3, 1);
+
+    // over max_k, counted on every occurrence
+    checkTopK(fmi, docs, 4, 40);
+
+    stringstream ss;
+    fmi.save(ss);
+    fmi.saveTopKDocIndex(ss);
+
+    FMIndex<uint16_t> loaded;
+    loaded.load(ss);
+    loaded.loadTopKDocIndex(ss);
+    checkTopK(loaded, docs, 6, 10);
+}
+
+BOOST_AUTO_TEST_CASE(topk_repetitive_docs)
+{
+    srand(43);
+    vector<uint16_t> base(7);
+    for (size_t i = 0; i < base.size(); ++i)
+        base[i] = 'a' + rand() % 4;
+
+    // the marked nodes nest deeply, each over most of the text
+    vector<vector<uint16_t> > docs(300);
+    for (size_t i = 0; i < docs.size(); ++i)
+    {
+        docs[i].resize(1 + rand() % 300);
+        for (size_t j = 0; j < docs[i].size(); ++j)
+            docs[i][j] = base[j % base.size()];
+        docs[i][rand() % docs[i].size()] = 'a' + rand() % 4;
+    }
+
+    FMIndex<uint16_t> fmi;
+    fmi.setTopKDocIndex(16, 32);
+    for (size_t i = 0; i < docs.size(); ++i)
+        fmi.addDoc(&docs[i][0], docs[i].size());
+    fmi.build();
+
+    checkTopK(fmi, docs, 14, 10);
+    checkTopK(fmi, docs, 8, 16);
+}
+
+BOOST_AUTO_TEST_CASE(topk_without_index)
+{
+    srand(41);
+    vector<vector<uint16_t> > docs;
+    randomDocs(500, 4, docs);
+
+    FMIndex<uint16_t, cbitv::CBitV, cbitv::CBitV> fmi;
+    for (size_t i = 0; i < docs.size(); ++i)
+        fmi.addDoc(&docs[i][0], docs[i].size());
+    fmi.build();
+
+    checkTopK(fmi, docs, 5, 10);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
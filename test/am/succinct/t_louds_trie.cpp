@@ -0,0 +1,225 @@
+#include <boost/test/unit_test.hpp>
+
+#include <am/succinct/louds-trie/louds_trie.hpp>
+#include <util/string/automata/WildcardAutomaton.h>
+#include <util/string/automata/LevenshteinBitAutomaton.h>
+
+#include <sstream>
+#include <cstdlib>
+
+using namespace std;
+using namespace izenelib::am::succinct::louds;
+using namespace izenelib::util;
+
+namespace
+{
+
+void randomKeys(size_t key_num, size_t max_len, size_t alphabet, vector<string> &keys)
+{
+    for (size_t i = 0; i < key_num; ++i)
+    {
+        string key(rand() % (max_len + 1), 'a');
+        for (size_t j = 0; j < key.size(); ++j)
+            key[j] = 'a' + rand() % alphabet;
+        keys.push_back(key);
+    }
+    sort(keys.begin(), keys.end());
+    keys.erase(unique(keys.begin(), keys.end()), keys.end());
+}
+
+/// matches the patterns of '*', '?' and single char classes, with no escapes
+bool naiveWildcard(const char *p, const char *s)
+{
+    if (*p == '\0') return *s == '\0';
+    if (*p == '*') return naiveWildcard(p + 1, s) || (*s && naiveWildcard(p, s + 1));
+    if (*s == '\0') return false;
+    if (*p == '?') return naiveWildcard(p + 1, s + 1);
+    if (*p == '[')
+    {
+        bool negated = p[1] == '^';
+        const char *q = negated ? p + 2 : p + 1;
+        bool in = false;
+        for (; *q != ']'; ++q)
+        {
+            if (q[1] == '-' && q[2] != ']')
+            {
+                in = in || (q[0] <= *s && *s <= q[2]);
+                q += 2;
+            }
+            else
+                in = in || *q == *s;
+        }
+        return in != negated && naiveWildcard(q + 1, s + 1);
+    }
+    return *p == *s && naiveWildcard(p + 1, s + 1);
+}
+
+size_t naiveDistance(const string &a, const string &b)
+{
+    vector<size_t> row(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); ++j) row[j] = j;
+    for (size_t i = 1; i <= a.size(); ++i)
+    {
+        size_t diag = row[0];
+        row[0] = i;
+        for (size_t j = 1; j <= b.size(); ++j)
+        {
+            size_t up = row[j];
+            row[j] = min(min(row[j] + 1, row[j - 1] + 1), diag + (a[i - 1] != b[j - 1]));
+            diag = up;
+        }
+    }
+    return row[b.size()];
+}
+
+string randomPattern(const char *tokens[], size_t token_num, size_t len)
+{
+    string pattern;
+    for (size_t i = 0; i < len; ++i)
+        pattern += tokens[rand() % token_num];
+    return pattern;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( t_louds_trie )
+
+BOOST_AUTO_TEST_CASE(build_and_lookup)
+{
+    srand(43);
+    vector<string> keys;
+    randomKeys(3000, 8, 5, keys);
+
+    LoudsTrie<char> trie;
+    trie.build(keys);
+    BOOST_CHECK_EQUAL(trie.size(), keys.size());
+
+    vector<string> all;
+    trie.keys(all);
+    BOOST_CHECK(all == keys);
+
+    for (size_t i = 0; i < 3000; ++i)
+    {
+        string key(rand() % 10, 'a');
+        for (size_t j = 0; j < key.size(); ++j)
+            key[j] = 'a' + rand() % 6;
+        BOOST_CHECK_EQUAL(trie.contains(key), binary_search(keys.begin(), keys.end(), key));
+    }
+
+    stringstream ss;
+    trie.save(ss);
+    LoudsTrie<char> loaded;
+    loaded.load(ss);
+    all.clear();
+    loaded.keys(all);
+    BOOST_CHECK(all == keys);
+
+    LoudsTrie<char> empty;
+    empty.build(vector<string>());
+    BOOST_CHECK(!empty.contains(string()));
+}
+
+BOOST_AUTO_TEST_CASE(wildcard_intersect)
+{
+    srand(47);
+    vector<string> keys;
+    randomKeys(5000, 8, 4, keys);
+
+    LoudsTrie<char> trie;
+    trie.build(keys);
+
+    const char *tokens[] = { "a", "b", "c", "d", "?", "*", "**", "[ab]", "[^a]", "[b-d]" };
+    for (size_t i = 0; i < 500; ++i)
+    {
+        string pattern = randomPattern(tokens, sizeof(tokens) / sizeof(tokens[0]), rand() % 6);
+
+        vector<string> expected;
+        for (size_t j = 0; j < keys.size(); ++j)
+        {
+            if (naiveWildcard(pattern.c_str(), keys[j].c_str())) expected.push_back(keys[j]);
+        }
+
+        WildcardAutomaton<char> automaton;
+        BOOST_REQUIRE(automaton.compile(pattern));
+        vector<string> results;
+        trie.intersect(automaton, results);
+        BOOST_REQUIRE_MESSAGE(results == expected, pattern);
+
+        results.clear();
+        trie.intersect(automaton, results, 3);
+        expected.resize(min(expected.size(), (size_t)3));
+        BOOST_CHECK(results == expected);
+    }
+
+    WildcardAutomaton<char> automaton;
+    BOOST_CHECK(automaton.compile(string("a\\*b")));
+    BOOST_CHECK(!automaton.compile(string("a[bc")));
+}
+
+BOOST_AUTO_TEST_CASE(fuzzy_intersect)
+{
+    srand(53);
+    vector<string> keys;
+    randomKeys(5000, 8, 4, keys);
+
+    LoudsTrie<char> trie;
+    trie.build(keys);
+
+    for (size_t i = 0; i < 300; ++i)
+    {
+        string term(rand() % 9, 'a');
+        for (size_t j = 0; j < term.size(); ++j)
+            term[j] = 'a' + rand() % 5;
+        size_t distance = rand() % 4;
+
+        vector<string> expected;
+        for (size_t j = 0; j < keys.size(); ++j)
+        {
+            if (naiveDistance(term, keys[j]) <= distance) expected.push_back(keys[j]);
+        }
+
+        LevenshteinBitAutomaton<char> automaton;
+        BOOST_REQUIRE(automaton.compile(term, distance));
+        vector<string> results;
+        trie.intersect(automaton, results);
+        BOOST_REQUIRE(results == expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(wide_chars)
+{
+    vector<vector<uint16_t> > words(3);
+    const uint16_t w0[] = { 0x4e2d, 0x6587 };
+    const uint16_t w1[] = { 0x4e2d, 0x56fd, 0x4eba };
+    const uint16_t w2[] = { 0x65e5, 0x672c };
+    words[0].assign(w0, w0 + 2);
+    words[1].assign(w1, w1 + 3);
+    words[2].assign(w2, w2 + 2);
+
+    // the keys need only length() and operator[]
+    vector<basic_string<uint16_t> > keys;
+    for (size_t i = 0; i < words.size(); ++i)
+        keys.push_back(basic_string<uint16_t>(&words[i][0], words[i].size()));
+    sort(keys.begin(), keys.end());
+
+    LoudsTrie<uint16_t> trie;
+    trie.build(keys);
+
+    const uint16_t p[] = { 0x4e2d, '*' };
+    WildcardAutomaton<uint16_t> automaton;
+    BOOST_REQUIRE(automaton.compile(basic_string<uint16_t>(p, 2)));
+    vector<basic_string<uint16_t> > results;
+    trie.intersect(automaton, results);
+    BOOST_REQUIRE_EQUAL(results.size(), 2U);
+    BOOST_CHECK(results[0] == keys[0]);
+    BOOST_CHECK(results[1] == keys[1]);
+
+    LevenshteinBitAutomaton<uint16_t> fuzzy;
+    BOOST_REQUIRE(fuzzy.compile(keys[0], 1));
+    results.clear();
+    trie.intersect(fuzzy, results);
+    BOOST_REQUIRE_EQUAL(results.size(), 1U);
+    BOOST_CHECK(results[0] == keys[0]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,242 @@
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+
+#include <am/succinct/fm-index/fm_index.hpp>
+#include <am/succinct/wat_array/wat_array.hpp>
+#include <am/succinct/wat_array/wavelet_matrix.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+using namespace std;
+using namespace izenelib::am::succinct;
+using namespace izenelib::am::succinct::fm_index;
+
+namespace
+{
+
+const char *kMappedFile = "t_mapped_load.aligned";
+
+template <class FMIndexT>
+void checkMappedFMIndex(size_t doc_num)
+{
+    FMIndexT fmi;
+    for (size_t i = 0; i < doc_num; ++i)
+    {
+        vector<uint16_t> doc(1 + rand() % 50);
+        for (size_t j = 0; j < doc.size(); ++j)
+            doc[j] = 'a' + rand() % 8;
+        fmi.addDoc(&doc[0], doc.size());
+    }
+    fmi.build();
+
+    {
+        ofstream ofs(kMappedFile, ios::binary);
+        fmi.saveAligned(ofs);
+    }
+
+    FMIndexT mapped;
+    BOOST_REQUIRE(mapped.map(kMappedFile));
+    boost::filesystem::remove(kMappedFile);
+
+    BOOST_CHECK_EQUAL(mapped.length(), fmi.length());
+    BOOST_CHECK_EQUAL(mapped.docCount(), fmi.docCount());
+
+    for (size_t i = 0; i < 300; ++i)
+    {
+        vector<uint16_t> pattern(1 + rand() % 8);
+        for (size_t j = 0; j < pattern.size(); ++j)
+            pattern[j] = 'a' + rand() % 8;
+
+        typename FMIndexT::MatchRangeT range, mapped_range;
+        size_t match_len = fmi.backwardSearch(&pattern[0], pattern.size(), range);
+        BOOST_CHECK_EQUAL(mapped.backwardSearch(&pattern[0], pattern.size(), mapped_range), match_len);
+        if (match_len == 0) continue;
+        BOOST_CHECK(mapped_range == range);
+
+        vector<uint32_t> docid_list, mapped_docid_list;
+        vector<size_t> doclen_list, mapped_doclen_list;
+        fmi.getMatchedDocIdList(range, 100, docid_list, doclen_list);
+        mapped.getMatchedDocIdList(mapped_range, 100, mapped_docid_list, mapped_doclen_list);
+        BOOST_CHECK(mapped_docid_list == docid_list);
+        BOOST_CHECK(mapped_doclen_list == doclen_list);
+    }
+}
+
+void writeFile(const string &bytes)
+{
+    ofstream ofs(kMappedFile, ios::binary);
+    ofs.write(bytes.data(), bytes.size());
+}
+
+template <class WatT>
+void checkMappedWat(const vector<uint64_t> &array)
+{
+    WatT wat;
+    wat.Init(array);
+
+    {
+        ofstream ofs(kMappedFile, ios::binary);
+        wat.SaveAligned(ofs);
+    }
+
+    WatT mapped;
+    BOOST_REQUIRE(mapped.Map(kMappedFile));
+    boost::filesystem::remove(kMappedFile);
+
+    BOOST_REQUIRE_EQUAL(mapped.length(), array.size());
+    BOOST_CHECK_EQUAL(mapped.alphabet_num(), wat.alphabet_num());
+
+    for (size_t i = 0; i < array.size(); ++i)
+    {
+        BOOST_REQUIRE_EQUAL(mapped.Lookup(i), array[i]);
+    }
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        uint64_t c = rand() % wat.alphabet_num();
+        uint64_t pos = rand() % (array.size() + 1);
+        BOOST_CHECK_EQUAL(mapped.Rank(c, pos), wat.Rank(c, pos));
+        BOOST_CHECK_EQUAL(mapped.RankLessThan(c, pos), wat.RankLessThan(c, pos));
+        BOOST_CHECK_EQUAL(mapped.Freq(c), wat.Freq(c));
+        if (wat.Freq(c) > 0)
+        {
+            uint64_t rank = 1 + rand() % wat.Freq(c);
+            BOOST_CHECK_EQUAL(mapped.Select(c, rank), wat.Select(c, rank));
+        }
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( t_mapped_load )
+
+BOOST_AUTO_TEST_CASE(mapped_vector)
+{
+    vector<uint64_t> values;
+    MappedVector<uint64_t> vec;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        values.push_back(rand());
+        vec.push_back(values.back());
+    }
+
+    {
+        ofstream ofs(kMappedFile, ios::binary);
+        AlignedWriter writer(ofs);
+        writer.write('x');
+        vec.saveAligned(writer);
+    }
+
+    MappedRegionPtr region(new MappedRegion);
+    BOOST_REQUIRE(region->open(kMappedFile));
+    boost::filesystem::remove(kMappedFile);
+
+    MappedReader reader(region);
+    char c = 0;
+    reader.read(c);
+    BOOST_CHECK_EQUAL(c, 'x');
+
+    MappedVector<uint64_t> mapped;
+    mapped.map(reader);
+    BOOST_CHECK_THROW(reader.read(c), std::out_of_range);
+    BOOST_CHECK(mapped.mapped());
+    BOOST_CHECK_EQUAL((size_t)mapped.data() % kMappedAlignment, 0U);
+    BOOST_REQUIRE_EQUAL(mapped.size(), values.size());
+    BOOST_CHECK(equal(values.begin(), values.end(), mapped.data()));
+
+    // the region stays mapped while a copy views it
+    region.reset();
+    MappedVector<uint64_t> copy(mapped);
+    mapped.clear();
+    BOOST_CHECK(copy.mapped());
+    BOOST_CHECK(equal(values.begin(), values.end(), copy.data()));
+
+    // changing copies it out of the region first
+    copy[0] = 7;
+    values[0] = 7;
+    BOOST_CHECK(!copy.mapped());
+    BOOST_CHECK(equal(values.begin(), values.end(), copy.data()));
+}
+
+BOOST_AUTO_TEST_CASE(mapped_fm_index)
+{
+    srand(29);
+    checkMappedFMIndex<FMIndex<uint16_t> >(3000);
+    checkMappedFMIndex<FMIndex<uint16_t, dense::DBitV, dense::DBitV> >(3000);
+    checkMappedFMIndex<FMIndex<uint16_t, cbitv::CBitV, cbitv::CBitV> >(3000);
+
+    FMIndex<uint16_t> empty, mapped;
+    {
+        ofstream ofs(kMappedFile, ios::binary);
+        empty.saveAligned(ofs);
+    }
+    BOOST_REQUIRE(mapped.map(kMappedFile));
+    boost::filesystem::remove(kMappedFile);
+    BOOST_CHECK_EQUAL(mapped.length(), 0U);
+    BOOST_CHECK_EQUAL(mapped.docCount(), 0U);
+
+    BOOST_CHECK(!mapped.map("t_mapped_load.missing"));
+}
+
+BOOST_AUTO_TEST_CASE(mapped_bad_files)
+{
+    srand(37);
+    FMIndex<uint16_t> fmi;
+    for (size_t i = 0; i < 100; ++i)
+    {
+        vector<uint16_t> doc(1 + rand() % 50);
+        for (size_t j = 0; j < doc.size(); ++j)
+            doc[j] = 'a' + rand() % 8;
+        fmi.addDoc(&doc[0], doc.size());
+    }
+    fmi.build();
+
+    ostringstream saved, aligned;
+    fmi.save(saved);
+    fmi.saveAligned(aligned);
+    string bytes = aligned.str();
+
+    FMIndex<uint16_t> mapped;
+    writeFile(bytes);
+    BOOST_REQUIRE(mapped.map(kMappedFile));
+
+    // the other formats and the truncated files leave the index unchanged
+    writeFile(saved.str());
+    BOOST_CHECK(!mapped.map(kMappedFile));
+    size_t lengths[] = { 4, 8, 24, bytes.size() / 2, bytes.size() - 1 };
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i)
+    {
+        writeFile(bytes.substr(0, lengths[i]));
+        BOOST_CHECK(!mapped.map(kMappedFile));
+    }
+    BOOST_CHECK_EQUAL(mapped.length(), fmi.length());
+    BOOST_CHECK_EQUAL(mapped.docCount(), fmi.docCount());
+
+    vector<uint64_t> array(1000);
+    for (size_t i = 0; i < array.size(); ++i)
+        array[i] = rand() % 100;
+    wavelet_matrix::WaveletMatrix wm, mapped_wm;
+    wm.Init(array);
+    ostringstream wm_aligned;
+    wm.SaveAligned(wm_aligned);
+    bytes = wm_aligned.str();
+    writeFile(bytes.substr(0, bytes.size() - 1));
+    BOOST_CHECK(!mapped_wm.Map(kMappedFile));
+    BOOST_CHECK_EQUAL(mapped_wm.length(), 0U);
+
+    boost::filesystem::remove(kMappedFile);
+}
+
+BOOST_AUTO_TEST_CASE(mapped_wat_array)
+{
+    srand(31);
+    vector<uint64_t> array(20000);
+    for (size_t i = 0; i < array.size(); ++i)
+        array[i] = rand() % 300;
+
+    checkMappedWat<wat_array::WatArray>(array);
+    checkMappedWat<wavelet_matrix::WaveletMatrix>(array);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,280 @@
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <map>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+
+#include <am/succinct/fm-index/segmented_fm_index.hpp>
+#include <am/succinct/fm-index/fm_index.hpp>
+
+using namespace std;
+using namespace izenelib::am::succinct::fm_index;
+
+namespace
+{
+
+typedef SegmentedFMIndex<uint16_t> SegmentedFMIndexType;
+typedef vector<uint16_t> TextT;
+
+const uint16_t ALPHABET = 4;
+
+TextT randomText(size_t max_len)
+{
+    TextT text(rand() % max_len);
+    for (size_t i = 0; i < text.size(); ++i)
+        text[i] = 'a' + rand() % ALPHABET;
+    return text;
+}
+
+/// docs[i] is the doc of id i + 1
+void addDocs(SegmentedFMIndexType& index, vector<TextT>& docs, size_t num)
+{
+    for (size_t i = 0; i < num; ++i)
+    {
+        docs.push_back(randomText(30));
+        uint32_t docid = index.addDoc(docs.back().empty() ? NULL : &docs.back()[0], docs.back().size());
+        BOOST_CHECK_EQUAL(docid, docs.size());
+    }
+}
+
+void checkMatches(const SegmentedFMIndexType& index, const vector<TextT>& docs, const vector<bool>& removed)
+{
+    for (size_t i = 0; i < 200; ++i)
+    {
+        TextT pattern = randomText(5);
+        if (pattern.empty()) continue;
+
+        vector<uint32_t> expected;
+        for (size_t d = 0; d < docs.size(); ++d)
+        {
+            if (!removed[d + 1] && search(docs[d].begin(), docs[d].end(), pattern.begin(), pattern.end()) != docs[d].end())
+                expected.push_back(d + 1);
+        }
+
+        vector<uint32_t> docids;
+        vector<size_t> doclens;
+        index.getMatchedDocIdList(&pattern[0], pattern.size(), docs.size(), docids, doclens);
+        BOOST_REQUIRE_EQUAL(docids.size(), doclens.size());
+        for (size_t j = 0; j < docids.size(); ++j)
+            BOOST_CHECK_EQUAL(doclens[j], docs[docids[j] - 1].size());
+
+        sort(docids.begin(), docids.end());
+        BOOST_CHECK_EQUAL(docids.size(), expected.size());
+        BOOST_CHECK(docids == expected);
+
+        if (expected.size() > 3)
+        {
+            docids.clear();
+            doclens.clear();
+            index.getMatchedDocIdList(&pattern[0], pattern.size(), 3, docids, doclens);
+            BOOST_CHECK_EQUAL(docids.size(), 3U);
+        }
+    }
+}
+
+
+/**
+ * compares the top k of @p index with those of an FMIndex of all the docs,
+ * the removed ones dropped. The first pattern, a single symbol, is in every
+ * segment, so each segment requires the same pattern as the FMIndex.
+ */
+void checkTopK(const SegmentedFMIndexType& index, const vector<TextT>& docs, const vector<bool>& removed, size_t k)
+{
+    FMIndex<uint16_t> fmi;
+    for (size_t d = 0; d < docs.size(); ++d)
+        fmi.addDoc(docs[d].empty() ? NULL : &docs[d][0], docs[d].size());
+    fmi.build();
+
+    for (size_t i = 0; i < 50; ++i)
+    {
+        vector<TextT> patterns;
+        vector<double> scores;
+        patterns.push_back(TextT(1, 'a' + rand() % ALPHABET));
+        scores.push_back(1.0);
+        for (size_t p = 0; p < 2; ++p)
+        {
+            TextT pattern = randomText(4);
+            if (pattern.empty()) continue;
+            patterns.push_back(pattern);
+            scores.push_back(0.5 / (p + 1));
+        }
+
+        FMIndex<uint16_t>::MatchRangeListT ranges;
+        vector<double> range_scores;
+        for (size_t p = 0; p < patterns.size(); ++p)
+        {
+            FMIndex<uint16_t>::MatchRangeT range;
+            if (fmi.backwardSearch(&patterns[p][0], patterns[p].size(), range) != patterns[p].size())
+                continue;
+            ranges.push_back(range);
+            range_scores.push_back(scores[p]);
+        }
+
+        // the scores of all the live docs matched
+        vector<pair<double, uint32_t> > all;
+        vector<size_t> all_lens;
+        fmi.getTopKDocIdList(ranges, range_scores, 1, docs.size(), all, all_lens);
+        map<uint32_t, double> doc_scores;
+        vector<double> expected;
+        for (size_t j = 0; j < all.size(); ++j)
+        {
+            if (removed[all[j].second]) continue;
+            doc_scores[all[j].second] = all[j].first;
+            expected.push_back(all[j].first);
+        }
+        sort(expected.begin(), expected.end(), greater<double>());
+        expected.resize(min(k, expected.size()));
+
+        vector<pair<double, uint32_t> > res;
+        vector<size_t> doclens;
+        index.getTopKDocIdList(patterns, scores, 1, k, res, doclens);
+        BOOST_REQUIRE_EQUAL(res.size(), expected.size());
+        BOOST_REQUIRE_EQUAL(doclens.size(), res.size());
+        for (size_t j = 0; j < res.size(); ++j)
+        {
+            BOOST_CHECK_EQUAL(res[j].first, expected[j]);
+            BOOST_REQUIRE(doc_scores.count(res[j].second));
+            BOOST_CHECK_EQUAL(res[j].first, doc_scores[res[j].second]);
+            BOOST_CHECK_EQUAL(doclens[j], docs[res[j].second - 1].size());
+        }
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( t_segmented_fm_index )
+
+BOOST_AUTO_TEST_CASE(segments_and_removal)
+{
+    srand(11);
+    SegmentedFMIndexType index(500, 3);
+    vector<TextT> docs;
+
+    addDocs(index, docs, 400);
+    index.flush();
+    BOOST_CHECK(index.segmentCount() > 1);
+    BOOST_CHECK_EQUAL(index.docCount(), docs.size());
+
+    vector<bool> removed(docs.size() + 1);
+    checkMatches(index, docs, removed);
+
+    for (size_t d = 1; d <= docs.size(); d += 3)
+    {
+        index.removeDoc(d);
+        removed[d] = true;
+    }
+    checkMatches(index, docs, removed);
+
+    index.mergeAll();
+    BOOST_CHECK_EQUAL(index.segmentCount(), 1U);
+    BOOST_CHECK_EQUAL(index.docCount(), docs.size());
+    checkMatches(index, docs, removed);
+
+    // new documents after the merge
+    addDocs(index, docs, 50);
+    index.flush();
+    removed.resize(docs.size() + 1);
+    checkMatches(index, docs, removed);
+}
+
+BOOST_AUTO_TEST_CASE(top_k)
+{
+    srand(13);
+    SegmentedFMIndexType index(3000, 4);
+    vector<TextT> docs;
+    addDocs(index, docs, 300);
+    index.flush();
+    index.mergeAll();
+    BOOST_CHECK_EQUAL(index.segmentCount(), 1U);
+
+    vector<bool> removed(docs.size() + 1);
+    checkTopK(index, docs, removed, 20);
+
+    // most of the best docs of the segment are removed
+    for (size_t d = 1; d <= docs.size(); ++d)
+    {
+        if (d % 3 == 0) continue;
+        index.removeDoc(d);
+        removed[d] = true;
+    }
+    checkTopK(index, docs, removed, 20);
+    checkTopK(index, docs, removed, 1);
+
+    // more segments
+    addDocs(index, docs, 200);
+    index.flush();
+    removed.resize(docs.size() + 1);
+    for (size_t d = 301; d <= docs.size(); d += 2)
+    {
+        index.removeDoc(d);
+        removed[d] = true;
+    }
+    BOOST_CHECK(index.segmentCount() > 1);
+    checkTopK(index, docs, removed, 20);
+    checkTopK(index, docs, removed, docs.size());
+}
+
+BOOST_AUTO_TEST_CASE(small_segments)
+{
+    srand(19);
+    SegmentedFMIndexType index(200, 2);
+    vector<TextT> docs;
+
+    // a segment of a single document, and one of empty documents only
+    addDocs(index, docs, 1);
+    index.flush();
+    for (size_t i = 0; i < 2; ++i)
+    {
+        docs.push_back(TextT());
+        BOOST_CHECK_EQUAL(index.addDoc(NULL, 0), docs.size());
+    }
+    index.flush();
+    BOOST_CHECK_EQUAL(index.segmentCount(), 2U);
+    addDocs(index, docs, 50);
+    index.flush();
+
+    vector<bool> removed(docs.size() + 1);
+    checkMatches(index, docs, removed);
+    checkTopK(index, docs, removed, 10);
+
+    // all the documents are removed before the merge
+    for (size_t d = 1; d <= docs.size(); ++d)
+    {
+        index.removeDoc(d);
+        removed[d] = true;
+    }
+    index.mergeAll();
+    BOOST_CHECK_EQUAL(index.segmentCount(), 1U);
+    BOOST_CHECK_EQUAL(index.docCount(), docs.size());
+    checkMatches(index, docs, removed);
+    checkTopK(index, docs, removed, 10);
+}
+
+BOOST_AUTO_TEST_CASE(background_merge)
+{
+    srand(17);
+    SegmentedFMIndexType index(200, 2);
+    index.startMergeThread();
+
+    vector<TextT> docs;
+    for (size_t round = 0; round < 8; ++round)
+    {
+        addDocs(index, docs, 60);
+        index.flush();
+    }
+
+    // the flushed segments are merged down to a few levels
+    for (size_t i = 0; i < 200 && index.segmentCount() > 4; ++i)
+        boost::this_thread::sleep(boost::posix_time::milliseconds(20));
+    BOOST_CHECK(index.segmentCount() <= 4);
+
+    vector<bool> removed(docs.size() + 1);
+    checkMatches(index, docs, removed);
+    index.stopMergeThread();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,95 @@
+/// @file   t_rank_select_bench.cpp
+/// @brief  ns/op of rank and select of the succinct bit vectors.
+///
+/// usage: manual_t_rank_select_bench [bit number] [query number]
+///
+/// rsdic::RSDic, dense::DBitV and cbitv::CBitV are built on the same random
+/// bits of 50%, 10% and 1% ones, then queried at the same random positions.
+/// The bits default to 2^30, far beyond the caches, so the numbers are mostly
+/// the cache misses of a lookup.
+#include <am/succinct/rsdic/RSDic.hpp>
+#include <am/succinct/dbitv/dbitv.hpp>
+#include <am/succinct/cbitv/cbitv.hpp>
+#include <util/ClockTimer.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <stdlib.h>
+
+using namespace izenelib::am::succinct;
+
+static uint64_t rand64()
+{
+    return (uint64_t)rand() << 62 ^ (uint64_t)rand() << 31 ^ rand();
+}
+
+template <class BitmapT>
+static void bench(const char* name, const std::vector<uint64_t>& bits, size_t len, size_t query_num)
+{
+    BitmapT bv(true);
+    bv.build(bits, len);
+
+    std::vector<size_t> positions(query_num);
+    std::vector<size_t> ones(query_num);
+    std::vector<size_t> zeros(query_num);
+    for (size_t i = 0; i < query_num; ++i)
+    {
+        positions[i] = rand64() % len;
+        ones[i] = rand64() % bv.one_count();
+        zeros[i] = rand64() % bv.zero_count();
+    }
+
+    // sums the results, so the queries are not optimized away
+    size_t sum = 0;
+
+    izenelib::util::ClockTimer timer;
+    for (size_t i = 0; i < query_num; ++i)
+        sum += bv.rank1(positions[i]);
+    double rank_ns = timer.elapsed() * 1e9 / query_num;
+
+    timer.restart();
+    for (size_t i = 0; i < query_num; ++i)
+        sum += bv.select1(ones[i]);
+    double select1_ns = timer.elapsed() * 1e9 / query_num;
+
+    timer.restart();
+    for (size_t i = 0; i < query_num; ++i)
+        sum += bv.select0(zeros[i]);
+    double select0_ns = timer.elapsed() * 1e9 / query_num;
+
+    std::cout << std::setw(8) << name
+              << std::setw(10) << rank_ns
+              << std::setw(10) << select1_ns
+              << std::setw(10) << select0_ns
+              << std::setw(10) << (double)bv.allocSize() * 8 / len
+              << "  (" << sum % 10 << ")" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t LEN = argc > 1 ? strtoull(argv[1], NULL, 10) : 1ULL << 30;
+    const size_t QUERY_NUM = argc > 2 ? strtoull(argv[2], NULL, 10) : 10000000;
+    const size_t DENSITIES[] = {50, 10, 1};
+
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t d = 0; d < sizeof(DENSITIES) / sizeof(DENSITIES[0]); ++d)
+    {
+        srand(d);
+        std::vector<uint64_t> bits((LEN + 63) / 64);
+        for (size_t i = 0; i < LEN; ++i)
+        {
+            if ((size_t)rand() % 100 < DENSITIES[d])
+                bits[i / 64] |= 1ULL << (i % 64);
+        }
+
+        std::cout << LEN << " bits, " << DENSITIES[d] << "% ones, " << QUERY_NUM << " queries" << std::endl;
+        std::cout << std::setw(8) << "" << std::setw(10) << "rank" << std::setw(10) << "select1"
+                  << std::setw(10) << "select0" << std::setw(10) << "bits/bit" << std::endl;
+
+        bench<rsdic::RSDic>("RSDic", bits, LEN, QUERY_NUM);
+        bench<dense::DBitV>("DBitV", bits, LEN, QUERY_NUM);
+        bench<cbitv::CBitV>("CBitV", bits, LEN, QUERY_NUM);
+    }
+    return 0;
+}
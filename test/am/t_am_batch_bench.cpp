@@ -0,0 +1,106 @@
+/// @file   t_am_batch_bench.cpp
+/// @brief  us/key of single insert and get against writeBatch and multiGet.
+///
+/// usage: manual_t_am_batch_bench [key number] [db dir]
+///
+/// Each access method of <int, int> gets the keys [1, n] by single inserts
+/// and (n, 2n] by one writeBatch(), then the 2n keys, in a random order, are
+/// looked up by single gets and by one multiGet(). The keys default to 10^5,
+/// the databases are created under ./tmp/am_batch_bench.
+#include <am/leveldb/Table.h>
+#include <am/lmdb/Mdb.h>
+#include <am/tc/Hash.h>
+#include <am/concept/WriteBatch.h>
+#include <sdb/SequentialDB.h>
+#include <util/ClockTimer.h>
+
+#include <boost/filesystem.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+
+using namespace izenelib::am;
+using izenelib::sdb::SequentialDB;
+
+template <class TableType>
+static void bench(const char* name, TableType& table, int keyNum)
+{
+    izenelib::util::ClockTimer timer;
+    for (int i = 1; i <= keyNum; ++i)
+        table.insert(i, i);
+    double insert_us = timer.elapsed() * 1e6 / keyNum;
+
+    WriteBatch<int, int> batch;
+    batch.reserve(keyNum);
+    for (int i = keyNum + 1; i <= 2 * keyNum; ++i)
+        batch.insert(i, i);
+    timer.restart();
+    table.writeBatch(batch);
+    double batch_us = timer.elapsed() * 1e6 / keyNum;
+
+    std::vector<int> keys;
+    for (int i = 1; i <= 2 * keyNum; ++i)
+        keys.push_back(i);
+    std::random_shuffle(keys.begin(), keys.end());
+
+    // counts the keys found, so that the gets are checked against each other
+    size_t found = 0;
+    int value;
+    timer.restart();
+    for (size_t i = 0; i < keys.size(); ++i)
+        found += table.get(keys[i], value);
+    double get_us = timer.elapsed() * 1e6 / keys.size();
+
+    std::vector<int> values;
+    std::vector<bool> multiFound;
+    timer.restart();
+    size_t multiCount = table.multiGet(keys, values, multiFound);
+    double multi_get_us = timer.elapsed() * 1e6 / keys.size();
+
+    std::cout << std::setw(14) << name
+              << std::setw(10) << insert_us
+              << std::setw(12) << batch_us
+              << std::setw(10) << get_us
+              << std::setw(10) << multi_get_us
+              << "  (" << found << ", " << multiCount << ")" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const int KEY_NUM = argc > 1 ? atoi(argv[1]) : 100000;
+    const std::string DIR = argc > 2 ? argv[2] : "./tmp/am_batch_bench";
+
+    boost::filesystem::remove_all(DIR);
+    boost::filesystem::create_directories(DIR);
+    std::cout << std::fixed << std::setprecision(2);
+    srand(0);
+
+    std::cout << std::setw(14) << "" << std::setw(10) << "insert" << std::setw(12) << "writeBatch"
+              << std::setw(10) << "get" << std::setw(10) << "multiGet" << std::endl;
+    {
+        izenelib::am::leveldb::Table<int, int> table(DIR + "/leveldb");
+        table.open();
+        bench("leveldb", table, KEY_NUM);
+    }
+    {
+        lmdb::Mdb<int, int> table(DIR + "/lmdb");
+        bench("lmdb", table, KEY_NUM);
+    }
+    {
+        tc::Hash<int, int> table(DIR + "/tc_hash");
+        table.open();
+        bench("tc_hash", table, KEY_NUM);
+    }
+    {
+        SequentialDB<int, int> table(DIR + "/sdb");
+        table.open();
+        bench("SequentialDB", table, KEY_NUM);
+    }
+
+    boost::filesystem::remove_all(DIR);
+    return 0;
+}
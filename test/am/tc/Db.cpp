@@ -13,8 +13,11 @@
 #include <cstdio>
 
 #include <am/tc/BTree.h>
+#include <am/tc/Hash.h>
 #include <am/range/AmIterator.h>
 
+#include "../BatchTestHelper.h"
+
 #define DIR_PREFIX "./tmp/am_tc_Db_"
 
 using namespace izenelib::am::tc;
@@ -129,4 +132,17 @@ BOOST_AUTO_TEST_CASE(BTreeIterator)
 
 }
 
+BOOST_AUTO_TEST_CASE(Batch_test)
+{
+    bfs::path db_dir(DIR_PREFIX);
+    boost::filesystem::remove_all(db_dir);
+    bfs::create_directories(db_dir);
+    std::string db_dir_str = db_dir.string();
+
+    typedef Hash<int,int> HashType;
+    HashType table(db_dir_str+"/Hash_batch");
+    BOOST_CHECK(table.open());
+    checkBatch(table);
+}
+
 BOOST_AUTO_TEST_SUITE_END() // tc_Db_test
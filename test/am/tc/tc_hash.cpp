@@ -14,6 +14,8 @@
 
 #include <sdb/SequentialDB.h>
 
+#include "../BatchTestHelper.h"
+
 #define DIR_PREFIX "./tmp/am_tc_Db_"
 
 using namespace izenelib::am;
@@ -140,4 +142,17 @@ BOOST_AUTO_TEST_CASE(tc_hash)
     sleep(1);
 }
 
+BOOST_AUTO_TEST_CASE(sdb_batch)
+{
+    bfs::path db_dir(DIR_PREFIX);
+    boost::filesystem::remove_all(db_dir);
+    bfs::create_directories(db_dir);
+    std::string db_dir_str = db_dir.string();
+
+    typedef SequentialDB<int, int> SDBType;
+    SDBType table(db_dir_str+"/sdb_batch");
+    BOOST_CHECK(table.open());
+    checkBatch(table);
+}
+
 BOOST_AUTO_TEST_SUITE_END() // tc_Db_test
@@ -0,0 +1,158 @@
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+
+#include <am/vsynonym/CompactVSynonym.h>
+
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+
+using namespace std;
+using namespace izenelib::am;
+
+namespace
+{
+
+const char* DIC_PATH = "t_compact_vsynonym.txt";
+const char* COMPACT_PATH = "t_compact_vsynonym.dat";
+
+string toString(VSynonym& synonym)
+{
+    ostringstream oss;
+    oss << synonym;
+    return oss.str();
+}
+
+string toString(VExpandedQuery* query)
+{
+    ostringstream oss;
+    oss << *query;
+    delete query;
+    return oss.str();
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(t_compact_vsynonym)
+
+BOOST_AUTO_TEST_CASE(search)
+{
+    {
+        ofstream ofs(DIC_PATH);
+        ofs << "new york,ny,big apple\n";
+        ofs << "new,fresh\n";
+        ofs << "ny,nyc\n";
+        ofs << "apple,pomme\n";
+        ofs << "iphone,apple phone\n";
+        ofs << "\n";
+        ofs << "single\n";
+    }
+    VSynonymContainer container;
+    BOOST_REQUIRE(container.loadSynonym(DIC_PATH));
+    BOOST_REQUIRE(CompactVSynonymContainer::build(container, COMPACT_PATH));
+
+    CompactVSynonymContainer compact;
+    BOOST_REQUIRE(compact.load(COMPACT_PATH));
+    BOOST_CHECK_EQUAL(compact.keyCount(), 10U);
+
+    const char* keys[] = {"new york", "ny", "big apple", "new", "fresh", "nyc",
+                          "apple", "pomme", "iphone", "apple phone", "york", "single", "n", ""};
+    for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i)
+    {
+        VSynonym expected, synonym;
+        bool found = container.searchNgetSynonym(keys[i], &expected);
+        BOOST_CHECK_EQUAL(compact.get_synonyms(keys[i], synonym), found);
+        BOOST_CHECK_EQUAL(toString(synonym), toString(expected));
+        if (found)
+        {
+            BOOST_CHECK_EQUAL(synonym.hasMoreLong(), expected.hasMoreLong());
+        }
+    }
+
+    VSynonym synonym;
+    BOOST_CHECK(compact.get_synonyms("ny", synonym));
+    BOOST_CHECK_EQUAL(toString(synonym), "new york,ny,big apple,ny,nyc");
+    BOOST_CHECK(synonym.hasMoreLong());
+
+    string str("new york city");
+    BOOST_CHECK_EQUAL(compact.longestMatch(str.data(), str.size(), synonym), 8U);
+    BOOST_CHECK_EQUAL(toString(synonym), "new york,ny,big apple");
+    BOOST_CHECK_EQUAL(compact.longestMatch("york", 4, synonym), 0U);
+
+    vector<pair<size_t, VSynonym> > matches;
+    compact.commonPrefixSearch(str.data(), str.size(), matches);
+    BOOST_REQUIRE_EQUAL(matches.size(), 2U);
+    BOOST_CHECK_EQUAL(matches[0].first, 3U);
+    BOOST_CHECK_EQUAL(toString(matches[0].second), "new,fresh");
+    BOOST_CHECK_EQUAL(matches[1].first, 8U);
+
+    // "new" is not taken in "newton", as it does not end at a token
+    BOOST_CHECK_EQUAL(toString(compact.expandQuery("I love New York and newton apples, apple")),
+            "I love  | new york,ny,big apple |  and newton apples,  | apple,pomme");
+    BOOST_CHECK_EQUAL(toString(compact.expandQuery("")), "");
+
+    compact.close();
+    BOOST_CHECK_EQUAL(compact.keyCount(), 0U);
+    BOOST_CHECK(!compact.get_synonyms("ny", synonym));
+
+    boost::filesystem::remove(DIC_PATH);
+    boost::filesystem::remove(COMPACT_PATH);
+}
+
+BOOST_AUTO_TEST_CASE(random_dictionary)
+{
+    srand(5);
+    {
+        ofstream ofs(DIC_PATH);
+        for (size_t i = 0; i < 2000; ++i)
+        {
+            size_t n = 2 + rand() % 3;
+            for (size_t j = 0; j < n; ++j)
+            {
+                size_t len = 1 + rand() % 6;
+                for (size_t k = 0; k < len; ++k)
+                    ofs << (char)('a' + rand() % 4);
+                ofs << (j + 1 < n ? "," : "\n");
+            }
+        }
+    }
+    VSynonymContainer container;
+    BOOST_REQUIRE(container.loadSynonym(DIC_PATH));
+    BOOST_REQUIRE(CompactVSynonymContainer::build(container, COMPACT_PATH));
+    CompactVSynonymContainer compact;
+    BOOST_REQUIRE(compact.load(COMPACT_PATH));
+
+    for (size_t i = 0; i < 5000; ++i)
+    {
+        string key;
+        size_t len = 1 + rand() % 7;
+        for (size_t k = 0; k < len; ++k)
+            key.push_back('a' + rand() % 4);
+
+        VSynonym expected, synonym;
+        bool found = container.searchNgetSynonym(key.c_str(), &expected);
+        BOOST_REQUIRE_EQUAL(compact.get_synonyms(key, synonym), found);
+        BOOST_REQUIRE_EQUAL(toString(synonym), toString(expected));
+        if (found)
+        {
+            BOOST_REQUIRE_EQUAL(synonym.hasMoreLong(), expected.hasMoreLong());
+        }
+    }
+
+    boost::filesystem::remove(DIC_PATH);
+    boost::filesystem::remove(COMPACT_PATH);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_file)
+{
+    {
+        ofstream ofs(COMPACT_PATH);
+        ofs << "not a synonym dictionary";
+    }
+    CompactVSynonymContainer compact;
+    BOOST_CHECK(!compact.load(COMPACT_PATH));
+    BOOST_CHECK(!compact.load("t_compact_vsynonym.none"));
+    boost::filesystem::remove(COMPACT_PATH);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,163 @@
+/**
+ * @file    t_ConcurrentIDFactory.cpp
+ * @brief   A Test unit of ConcurrentIDGenerator and AsyncIDStorage
+ * @details
+ *  - Several threads get the ids of overlapping term lists at once, each string
+ *    should get one id, and different strings different ids.
+ *  - The strings are returned by their ids both before and after they are spilled.
+ *  - The repeated strings of a list get the id of their first occurrence.
+ */
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <ir/id_manager/IDGenerator.h>
+#include <ir/id_manager/IDStorage.h>
+#include <ir/id_manager/IDFactory.h>
+
+#include <set>
+
+using namespace std;
+using namespace izenelib::ir::idmanager;
+
+namespace
+{
+
+typedef IDFactory<string, uint32_t,
+                  ConcurrentIDGenerator<string, uint32_t, UniqueIDGenerator<string, uint32_t>, 2>,
+                  AsyncIDStorage<string, uint32_t, HDBIDStorage<string, uint32_t>, 1000> >
+    ConcurrentIDFactory;
+
+const size_t kTermNum = 20000;
+const size_t kThreadNum = 4;
+
+/// each thread resolves documents of terms from a different part of the vocabulary
+void resolveTerms(ConcurrentIDFactory* idFactory, size_t threadId, vector<uint32_t>* termIds)
+{
+    termIds->assign(kTermNum, 0);
+    for (size_t begin = 0; begin < kTermNum; begin += 100)
+    {
+        vector<string> doc;
+        for (size_t i = 0; i < 100; ++i)
+            doc.push_back("term" + boost::lexical_cast<string>((begin + i + threadId * 5000) % kTermNum));
+
+        vector<uint32_t> docIds;
+        idFactory->getNameIDsByNameStrings(doc, docIds);
+        for (size_t i = 0; i < 100; ++i)
+            (*termIds)[(begin + i + threadId * 5000) % kTermNum] = docIds[i];
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( t_ConcurrentIDFactory )
+
+BOOST_AUTO_TEST_CASE( concurrent_term_ids )
+{
+    boost::filesystem::remove_all("idm_concurrent");
+    boost::filesystem::create_directory("idm_concurrent");
+
+    vector<vector<uint32_t> > termIds(kThreadNum);
+    {
+        ConcurrentIDFactory idFactory("idm_concurrent/tid");
+
+        boost::thread_group threads;
+        for (size_t i = 0; i < kThreadNum; ++i)
+            threads.create_thread(boost::bind(&resolveTerms, &idFactory, i, &termIds[i]));
+        threads.join_all();
+
+        set<uint32_t> idSet;
+        for (size_t i = 0; i < kTermNum; ++i)
+        {
+            for (size_t j = 1; j < kThreadNum; ++j)
+                BOOST_REQUIRE_EQUAL(termIds[j][i], termIds[0][i]);
+            idSet.insert(termIds[0][i]);
+        }
+        BOOST_CHECK_EQUAL(idSet.size(), kTermNum);
+        BOOST_CHECK_EQUAL(idFactory.getMaxNameID(), kTermNum);
+
+        // found in the front now
+        uint32_t termId = 0;
+        BOOST_CHECK(idFactory.getNameIDByNameString("term7", termId));
+        BOOST_CHECK_EQUAL(termId, termIds[0][7]);
+        BOOST_CHECK(!idFactory.getNameIDByNameString("missing", termId, false));
+
+        // some pending, some spilled
+        string termString;
+        for (size_t i = 0; i < kTermNum; i += 97)
+        {
+            BOOST_REQUIRE(idFactory.getNameStringByNameID(termIds[0][i], termString));
+            BOOST_CHECK_EQUAL(termString, "term" + boost::lexical_cast<string>(i));
+        }
+
+        idFactory.flush();
+        for (size_t i = 0; i < kTermNum; i += 89)
+        {
+            BOOST_REQUIRE(idFactory.getNameStringByNameID(termIds[0][i], termString));
+            BOOST_CHECK_EQUAL(termString, "term" + boost::lexical_cast<string>(i));
+        }
+    }
+
+    // reopened, the ids come from the generator and storage on disk
+    {
+        ConcurrentIDFactory idFactory("idm_concurrent/tid");
+
+        uint32_t termId = 0;
+        BOOST_CHECK(idFactory.getNameIDByNameString("term123", termId, false));
+        BOOST_CHECK_EQUAL(termId, termIds[0][123]);
+
+        string termString;
+        BOOST_CHECK(idFactory.getNameStringByNameID(termIds[0][4567], termString));
+        BOOST_CHECK_EQUAL(termString, "term4567");
+    }
+
+    boost::filesystem::remove_all("idm_concurrent");
+}
+
+BOOST_AUTO_TEST_CASE( repeated_terms )
+{
+    boost::filesystem::remove_all("idm_concurrent");
+    boost::filesystem::create_directory("idm_concurrent");
+    {
+        ConcurrentIDFactory idFactory("idm_concurrent/tid");
+
+        const char* terms[] = {"b", "a", "b", "c", "a", "b"};
+        vector<string> doc(terms, terms + 6);
+        vector<uint32_t> docIds;
+        BOOST_CHECK(!idFactory.getNameIDsByNameStrings(doc, docIds));
+        BOOST_REQUIRE_EQUAL(docIds.size(), doc.size());
+        BOOST_CHECK_EQUAL(idFactory.getMaxNameID(), 3U);
+
+        // assigned in the order of the first occurrences
+        BOOST_CHECK_EQUAL(docIds[0], 1U);
+        BOOST_CHECK_EQUAL(docIds[1], 2U);
+        BOOST_CHECK_EQUAL(docIds[3], 3U);
+        BOOST_CHECK_EQUAL(docIds[2], docIds[0]);
+        BOOST_CHECK_EQUAL(docIds[4], docIds[1]);
+        BOOST_CHECK_EQUAL(docIds[5], docIds[0]);
+
+        string termString;
+        for (size_t i = 0; i < doc.size(); ++i)
+        {
+            BOOST_REQUIRE(idFactory.getNameStringByNameID(docIds[i], termString));
+            BOOST_CHECK_EQUAL(termString, doc[i]);
+        }
+
+        // all found, one missing without insert
+        vector<uint32_t> foundIds;
+        BOOST_CHECK(idFactory.getNameIDsByNameStrings(doc, foundIds));
+        BOOST_CHECK(foundIds == docIds);
+
+        doc.push_back("d");
+        BOOST_CHECK(!idFactory.getNameIDsByNameStrings(doc, foundIds, false));
+        BOOST_CHECK_EQUAL(idFactory.getMaxNameID(), 3U);
+
+        vector<string> empty;
+        BOOST_CHECK(idFactory.getNameIDsByNameStrings(empty, foundIds));
+        BOOST_CHECK(foundIds.empty());
+    }
+    boost::filesystem::remove_all("idm_concurrent");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,242 @@
+/**
+ * @file    t_FrozenIDStorage.cpp
+ * @brief   A Test unit of FrozenIDStorage
+ * @details
+ *  - The strings are returned by their ids from the overlay, and from the
+ *    frozen store after flush().
+ *  - The pairs put again after a freeze replace the frozen ones.
+ *  - The frozen store is mapped again when the storage is reopened.
+ *  - The first freeze of an existing vocabulary takes the pairs of the base
+ *    storage, and flush() puts off freezing a small overlay.
+ *  - A store file whose arrays do not agree with its count is not mapped.
+ */
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <ir/id_manager/IDStorage.h>
+
+#include <fstream>
+#include <map>
+#include <vector>
+#include <cstdlib>
+
+using namespace std;
+using namespace izenelib::ir::idmanager;
+
+namespace
+{
+
+typedef FrozenIDStorage<string, uint32_t, EmptyIDStorage<string, uint32_t> > NameStorage;
+
+/// a base storage in memory, kept by name across instances as on disk
+class MapIDStorage
+{
+public:
+    typedef map<uint32_t, string> Pairs;
+
+    MapIDStorage(const string& sdbName) : pairs_(files()[sdbName]) {}
+
+    void put(const uint32_t& nameID, const string& nameString)
+    {
+        pairs_[nameID] = nameString;
+    }
+
+    bool get(const uint32_t& nameID, string& nameString)
+    {
+        Pairs::const_iterator it = pairs_.find(nameID);
+        if (it == pairs_.end()) return false;
+        nameString = it->second;
+        return true;
+    }
+
+    void getAllPairs(vector<pair<uint32_t, string> >& names)
+    {
+        names.insert(names.end(), pairs_.begin(), pairs_.end());
+    }
+
+    void flush() {}
+    void close() {}
+    void display() {}
+
+    static map<string, Pairs>& files()
+    {
+        static map<string, Pairs> files;
+        return files;
+    }
+
+private:
+    Pairs& pairs_;
+};
+
+typedef FrozenIDStorage<string, uint32_t, MapIDStorage> SeededStorage;
+
+/// names sharing prefixes, at sparse ids
+template <typename StorageT>
+void putNames(StorageT& storage, size_t num, map<uint32_t, string>& names)
+{
+    for (size_t i = 0; i < num; ++i)
+    {
+        uint32_t id = 1 + rand() % (num * 4);
+        string name = "http://www.example.com/item/" + boost::lexical_cast<string>(rand() % 100000);
+        storage.put(id, name);
+        names[id] = name;
+    }
+}
+
+template <typename StorageT>
+void checkNames(StorageT& storage, const map<uint32_t, string>& names)
+{
+    string name;
+    for (map<uint32_t, string>::const_iterator it = names.begin(); it != names.end(); ++it)
+    {
+        BOOST_REQUIRE(storage.get(it->first, name));
+        BOOST_CHECK_EQUAL(name, it->second);
+    }
+    BOOST_CHECK(!storage.get(0, name));
+}
+
+typedef FrontCodedNameStore<string, uint32_t> NameStore;
+
+/// writes the layout of NameStore::save() with the given arrays
+void writeStore(const string& path, size_t count, const vector<uint32_t>& ids,
+        const vector<uint32_t>& ranks, const vector<uint64_t>& blocks, const string& bytes)
+{
+    ofstream ofs(path.c_str(), ios_base::binary);
+    izenelib::am::succinct::AlignedWriter writer(ofs);
+    writer.writeHeader();
+    writer.write(count);
+    writer.writeArray(&ids[0], ids.size());
+    writer.writeArray(&ranks[0], ranks.size());
+    writer.writeArray(&blocks[0], blocks.size());
+    writer.writeArray(bytes.data(), bytes.size());
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( t_FrozenIDStorage )
+
+BOOST_AUTO_TEST_CASE( frozen_names )
+{
+    srand(17);
+    boost::filesystem::remove_all("idm_frozen");
+    boost::filesystem::create_directory("idm_frozen");
+
+    map<uint32_t, string> names;
+    {
+        NameStorage storage("idm_frozen/did");
+        BOOST_CHECK(storage.size() == make_pair(size_t(0), size_t(0)));
+
+        putNames(storage, 5000, names);
+        checkNames(storage, names);
+        BOOST_CHECK_EQUAL(storage.size().second, names.size());
+
+        storage.flush();
+        BOOST_CHECK(storage.size() == make_pair(names.size(), size_t(0)));
+        checkNames(storage, names);
+
+        // replaces some frozen ones
+        putNames(storage, 1000, names);
+        checkNames(storage, names);
+
+        storage.flush();
+        BOOST_CHECK(storage.size() == make_pair(names.size(), size_t(0)));
+        checkNames(storage, names);
+    }
+
+    {
+        NameStorage storage("idm_frozen/did");
+        BOOST_CHECK(storage.size() == make_pair(names.size(), size_t(0)));
+        checkNames(storage, names);
+    }
+
+    boost::filesystem::remove_all("idm_frozen");
+}
+
+BOOST_AUTO_TEST_CASE( seeded_names )
+{
+    srand(19);
+    boost::filesystem::remove_all("idm_seeded");
+    boost::filesystem::create_directory("idm_seeded");
+
+    // the vocabulary of an index without a frozen store
+    map<uint32_t, string> names;
+    {
+        MapIDStorage base("idm_seeded/did");
+        putNames(base, 5000, names);
+    }
+
+    {
+        SeededStorage storage("idm_seeded/did");
+        BOOST_CHECK(storage.size() == make_pair(size_t(0), size_t(0)));
+        checkNames(storage, names);
+
+        storage.flush();
+        BOOST_CHECK(storage.size() == make_pair(names.size(), size_t(0)));
+        checkNames(storage, names);
+
+        // a small overlay is frozen by freeze() or close(), not flush()
+        putNames(storage, 10, names);
+        size_t overlaySize = storage.size().second;
+        storage.flush();
+        BOOST_CHECK_EQUAL(storage.size().second, overlaySize);
+        checkNames(storage, names);
+
+        BOOST_CHECK(storage.freeze());
+        BOOST_CHECK(storage.size() == make_pair(names.size(), size_t(0)));
+        checkNames(storage, names);
+    }
+
+    {
+        SeededStorage storage("idm_seeded/did");
+        BOOST_CHECK(storage.size() == make_pair(names.size(), size_t(0)));
+        checkNames(storage, names);
+    }
+
+    MapIDStorage::files().clear();
+    boost::filesystem::remove_all("idm_seeded");
+}
+
+BOOST_AUTO_TEST_CASE( corrupt_store )
+{
+    boost::filesystem::remove_all("idm_corrupt");
+    boost::filesystem::create_directory("idm_corrupt");
+
+    // "apple", "banana" and "cherry" at ids 3, 1 and 2, in one block
+    const uint32_t idArray[] = {1, 2, 3};
+    const uint32_t rankArray[] = {1, 2, 0};
+    const char byteArray[] = "\x05" "apple" "\x00\x06" "banana" "\x00\x06" "cherry";
+    vector<uint32_t> ids(idArray, idArray + 3);
+    vector<uint32_t> ranks(rankArray, rankArray + 3);
+    vector<uint64_t> blocks(1, 0);
+    string bytes(byteArray, sizeof(byteArray) - 1);
+
+    NameStore store;
+    writeStore("idm_corrupt/valid", 3, ids, ranks, blocks, bytes);
+    BOOST_REQUIRE(store.map("idm_corrupt/valid"));
+
+    writeStore("idm_corrupt/count", 4, ids, ranks, blocks, bytes);
+    BOOST_CHECK(!store.map("idm_corrupt/count"));
+
+    vector<uint32_t> badRanks(ranks);
+    badRanks[2] = 3;
+    writeStore("idm_corrupt/rank", 3, ids, badRanks, blocks, bytes);
+    BOOST_CHECK(!store.map("idm_corrupt/rank"));
+
+    writeStore("idm_corrupt/blocks", 3, ids, ranks, vector<uint64_t>(2, 0), bytes);
+    BOOST_CHECK(!store.map("idm_corrupt/blocks"));
+
+    writeStore("idm_corrupt/offset", 3, ids, ranks, vector<uint64_t>(1, bytes.size()), bytes);
+    BOOST_CHECK(!store.map("idm_corrupt/offset"));
+
+    // still the valid one
+    BOOST_CHECK_EQUAL(store.size(), 3U);
+    string name;
+    BOOST_CHECK(store.get(1, name) && name == "banana");
+    BOOST_CHECK(store.get(3, name) && name == "apple");
+    BOOST_CHECK(!store.get(4, name));
+
+    boost::filesystem::remove_all("idm_corrupt");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
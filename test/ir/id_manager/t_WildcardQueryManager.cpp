@@ -3,8 +3,129 @@
 
 using namespace boost::unit_test;
 
+namespace
+{
+
+void makeString(const char* str, std::string& out)
+{
+    out = str;
+}
+
+void makeString(const char* str, UString& out)
+{
+    out.assign(str, UString::UTF_8);
+}
+
+template <class StringT, size_t N>
+std::vector<StringT> makeStrings(const char* (&strs)[N])
+{
+    std::vector<StringT> out(N);
+    for (size_t i = 0; i < N; ++i)
+        makeString(strs[i], out[i]);
+    return out;
+}
+
+template <class StringT>
+StringT makeString(const char* str)
+{
+    StringT out;
+    makeString(str, out);
+    return out;
+}
+
+/**
+ * inserts terms into an automaton WildcardQueryManager in two parts, the
+ * second one only added by the wildcard thread, then checks the queries
+ * again on the trie reloaded from <name>.louds.
+ */
+template <class StringT>
+void checkAutomatonHandler(const std::string& name)
+{
+    typedef WildcardQueryManager<StringT, uint32_t,
+            AutomatonWildcardQueryHandler<StringT, uint32_t>,
+            izenelib::util::NullLock> ManagerType;
+
+    const char* first[] = {"apple", "ample", "maple", "bottle", "cattle"};
+    const char* second[] = {"apply", "apples", "angle", "battle", "bottles"};
+    const char* app[] = {"apple", "apples", "apply"};
+    // the terms within distance 1, 2 and 3 of "aple", each in their order
+    const char* aple[] = {"ample", "apple", "maple", "angle", "apples", "apply", "battle", "cattle"};
+
+    std::vector<StringT> results;
+    {
+        ManagerType manager(name);
+        std::vector<StringT> terms = makeStrings<StringT>(first);
+        for (size_t i = 0; i < terms.size(); ++i)
+            manager.insert(terms[i]);
+        manager.flush();
+
+        // the pending terms are not found before the rebuild
+        terms = makeStrings<StringT>(second);
+        for (size_t i = 0; i < terms.size(); ++i)
+            manager.insert(terms[i]);
+        BOOST_CHECK(manager.findRegExp(makeString<StringT>("app*"), results, 100));
+        BOOST_CHECK(results == std::vector<StringT>(1, makeString<StringT>("apple")));
+        results.clear();
+        BOOST_CHECK(!manager.findRegExp(makeString<StringT>("bottles"), results, 100));
+
+        manager.startThread();
+        manager.joinThread();
+        BOOST_CHECK(manager.findRegExp(makeString<StringT>("bottles"), results, 100));
+        BOOST_CHECK_EQUAL(results.size(), 1U);
+    }
+
+    // reloaded from <name>.louds
+    ManagerType manager(name);
+    results.clear();
+    BOOST_CHECK(manager.findRegExp(makeString<StringT>("app*"), results, 100));
+    BOOST_CHECK(results == makeStrings<StringT>(app));
+
+    // the limit keeps the first terms in the trie order
+    results.clear();
+    BOOST_CHECK(manager.findRegExp(makeString<StringT>("app*"), results, 2));
+    std::vector<StringT> expected = makeStrings<StringT>(app);
+    BOOST_CHECK(results == std::vector<StringT>(expected.begin(), expected.begin() + 2));
+
+    std::vector<uint32_t> ids;
+    BOOST_CHECK(manager.findRegExp(makeString<StringT>("b?ttle"), ids, 100));
+    BOOST_CHECK_EQUAL(ids.size(), 2U);
+
+    expected = makeStrings<StringT>(aple);
+    results.clear();
+    BOOST_CHECK(manager.findFuzzy(makeString<StringT>("aple"), 2, results, 100));
+    BOOST_CHECK(results == std::vector<StringT>(expected.begin(), expected.begin() + 6));
+
+    // the limit cuts inside a distance
+    results.clear();
+    BOOST_CHECK(manager.findFuzzy(makeString<StringT>("aple"), 2, results, 4));
+    BOOST_CHECK(results == std::vector<StringT>(expected.begin(), expected.begin() + 4));
+
+    // a distance over the automaton's is taken as its largest
+    results.clear();
+    BOOST_CHECK(manager.findFuzzy(makeString<StringT>("aple"), 10, results, 100));
+    BOOST_CHECK(results == expected);
+
+    results.clear();
+    BOOST_CHECK(!manager.findFuzzy(makeString<StringT>("aple"), 0, results, 100));
+    BOOST_CHECK(!manager.findFuzzy(makeString<StringT>(std::string(70, 'a').c_str()), 1, results, 100));
+    BOOST_CHECK(results.empty());
+}
+
+}
+
 BOOST_FIXTURE_TEST_SUITE( t_Regexp, IDManagerFixture )
 
+BOOST_AUTO_TEST_CASE( AutomatonHandler )
+{
+    clean("automaton_string");
+    checkAutomatonHandler<std::string>("automaton_string");
+    clean("automaton_string");
+
+    clean("automaton_ustring");
+    checkAutomatonHandler<UString>("automaton_ustring");
+    clean("automaton_ustring");
+}
+
 typedef _IDManager< UString, uint128_t, uint32_t, izenelib::util::NullLock,
                     EmptyWildcardQueryHandler<UString, uint32_t>,
                     HashIDGenerator<UString, uint32_t>,
@@ -21,6 +142,14 @@ typedef _IDManager< UString, uint128_t, uint32_t, izenelib::util::NullLock,
                     SDBIDStorage<uint128_t, uint32_t> >
 IDManagerDiskRegexpHandler;
 
+typedef _IDManager< UString, uint128_t, uint32_t, izenelib::util::NullLock,
+                    AutomatonWildcardQueryHandler<UString, uint32_t>,
+                    HashIDGenerator<UString, uint32_t>,
+                    SDBIDStorage<UString, uint32_t>,
+                    UniqueIDGenerator<uint128_t, uint32_t>,
+                    SDBIDStorage<uint128_t, uint32_t> >
+IDManagerAutomatonRegexpHandler;
+
 BOOST_AUTO_TEST_CASE( EmptyRegexpHandler )
 {
     IDManagerEmptyRegexpHandler idManager("regexp1");
@@ -75,6 +204,37 @@ BOOST_AUTO_TEST_CASE( EmptyRegexpHandler )
 
     clean("regexp1");
 }
+
+BOOST_AUTO_TEST_CASE( AutomatonRegexpHandler )
+{
+    const UString& term = termUStringList1_[0];
+    std::vector<UString> termList;
+    {
+        IDManagerAutomatonRegexpHandler idManager("regexp3");
+        idManager.addWildcardCandidateList(termUStringList1_);
+        idManager.startWildcardProcess();
+        idManager.joinWildcardProcess();
+
+        BOOST_CHECK(idManager.getTermListByFuzzyTerm(term, 0, termList, 100));
+        BOOST_CHECK(termList == std::vector<UString>(1, term));
+        idManager.close();
+    }
+
+    // the trie is reloaded from regexp3_regexp.louds
+    IDManagerAutomatonRegexpHandler idManager("regexp3");
+    termList.clear();
+    BOOST_CHECK(idManager.getTermListByFuzzyTerm(term, 1, termList, 100));
+    BOOST_REQUIRE(!termList.empty());
+    BOOST_CHECK(termList[0] == term);
+
+    termIdList1_.clear();
+    BOOST_CHECK(idManager.getTermIdListByFuzzyTerm(term, 0, termIdList1_, 100));
+    BOOST_REQUIRE_EQUAL(termIdList1_.size(), 1U);
+    BOOST_CHECK_EQUAL(termIdList1_[0], NameIDTraits<uint32_t>::hash(term));
+
+    idManager.close();
+    clean("regexp3");
+}
 /*
 BOOST_AUTO_TEST_CASE( DiskRegexpHandler )
 {
@@ -36,21 +36,21 @@ struct IndexerTestConfig
 
     IndexLevel indexLevel_;
 
-    std::string indexMode_; ///< "default" (for offline), "realtime", "default:block", "default:chunk"
+    std::string indexMode_; ///< "default" (for offline), "realtime", "default:block", "default:simdblock", "default:chunk"
 
     bool isMerge_; ///< true for merge index in stand-alone thread, false for not to merge at all
 
     /**
      * skip interval.
      * for chunk type, it is fixed to CHUNK_SIZE (128) docs,
-     * for block type, it is fixed to BLOCK_SIZE (8192) bytes.
+     * for block and simdblock type, it is fixed to BLOCK_SIZE (8192) bytes.
      */
     int skipInterval_; ///<
 
     /**
      * max skip level.
      * for vint and chunk type, 0 for no skip data generated, positive value for the number of skip levels,
-     * for block type, it always uses one level skip list.
+     * for block and simdblock type, it always uses one level skip list.
      */
     int maxSkipLevel_; ///< max skip level
 
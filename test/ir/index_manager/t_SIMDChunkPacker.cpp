@@ -0,0 +1,115 @@
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <cstdlib>
+
+#include <ir/index_manager/index/SIMDChunkPacker.h>
+#include <ir/index_manager/index/BlockDataPool.h>
+#include <ir/index_manager/index/BlockDataDecoder.h>
+
+using namespace std;
+using namespace izenelib::ir::indexmanager;
+
+namespace
+{
+
+/**
+ * encode @p docs and @p freqs as chunks of CHUNK_SIZE, then decode them with the same mode.
+ */
+void checkChunks(const vector<uint32_t>& docs, const vector<uint32_t>& freqs, bool simd)
+{
+    ChunkEncoder encoder;
+    encoder.set_simd(simd);
+    ChunkDecoder decoder;
+    decoder.set_simd(simd);
+
+    // the scalar coders need padded buffers
+    vector<uint32_t> docBuffer(UncompressedOutBufferUpperbound(CHUNK_SIZE));
+    vector<uint32_t> freqBuffer(UncompressedOutBufferUpperbound(CHUNK_SIZE));
+    vector<uint32_t> decodedDocs(UncompressedOutBufferUpperbound(CHUNK_SIZE));
+    vector<uint32_t> decodedFreqs(UncompressedOutBufferUpperbound(CHUNK_SIZE));
+    decoder.set_doc_freq_buffer(&decodedDocs[0], &decodedFreqs[0]);
+    decoder.set_prev_decoded_doc_id(0);
+
+    for (size_t start = 0; start < docs.size(); start += CHUNK_SIZE)
+    {
+        int num = min((size_t)CHUNK_SIZE, docs.size() - start);
+        copy(docs.begin() + start, docs.begin() + start + num, docBuffer.begin());
+        copy(freqs.begin() + start, freqs.begin() + start + num, freqBuffer.begin());
+        encoder.encode(&docBuffer[0], &freqBuffer[0], NULL, num);
+
+        // one word of offset, chunks are not aligned within a block
+        vector<uint32_t> chunk(1);
+        chunk.insert(chunk.end(), encoder.compressed_doc_ids(),
+                     encoder.compressed_doc_ids() + encoder.compressed_doc_ids_len());
+        chunk.insert(chunk.end(), encoder.compressed_frequencies(),
+                     encoder.compressed_frequencies() + encoder.compressed_frequencies_len());
+        BOOST_CHECK_EQUAL(chunk.size() - 1, (size_t)encoder.size());
+
+        decoder.reset(&chunk[1], num);
+        decoder.decodeDocIds();
+        decoder.decodeFrequencies();
+        for (int i = 0; i < num; ++i)
+        {
+            BOOST_CHECK_EQUAL(decoder.doc_id(i), docs[start + i]);
+            BOOST_CHECK_EQUAL(decoder.frequencies(i), freqs[start + i]);
+        }
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE( t_SIMDChunkPacker )
+
+BOOST_AUTO_TEST_CASE(pack)
+{
+    vector<uint32_t> values(SIMDChunkPacker::kChunkSize);
+    vector<uint32_t> packed(SIMDChunkPacker::packed_size(32) + 1);
+    vector<uint32_t> unpacked(SIMDChunkPacker::kChunkSize + 1);
+
+    for (uint32_t bits = 0; bits <= 32; ++bits)
+    {
+        for (int i = 0; i < SIMDChunkPacker::kChunkSize; ++i)
+        {
+            uint32_t v = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+            values[i] = bits == 32 ? v : v & ((1U << bits) - 1);
+        }
+        if (bits) values[rand() % SIMDChunkPacker::kChunkSize] |= 1U << (bits - 1);
+
+        int words = SIMDChunkPacker::pack(&values[0], &packed[1]);
+        BOOST_CHECK_EQUAL(words, SIMDChunkPacker::packed_size(bits));
+        BOOST_CHECK_EQUAL(SIMDChunkPacker::unpack(&packed[1], &unpacked[1]), words);
+        BOOST_CHECK(equal(values.begin(), values.end(), unpacked.begin() + 1));
+
+        if (bits == 32) continue;
+        // the prefix sum from a base
+        uint32_t sum = 1000;
+        SIMDChunkPacker::unpackPrefixSum(&packed[1], &unpacked[1], sum);
+        for (int i = 0; i < SIMDChunkPacker::kChunkSize; ++i)
+        {
+            sum += values[i];
+            BOOST_CHECK_EQUAL(unpacked[i + 1], sum);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(chunks)
+{
+    // two full chunks coded by SIMDChunkPacker, and a tail by the scalar coders
+    const int gaps[] = {1, 7, 5000};
+    for (size_t g = 0; g < sizeof(gaps) / sizeof(gaps[0]); ++g)
+    {
+        vector<uint32_t> docs, freqs;
+        uint32_t doc = 0;
+        for (int i = 0; i < 2 * CHUNK_SIZE + 50; ++i)
+        {
+            doc += 1 + rand() % gaps[g];
+            docs.push_back(doc);
+            freqs.push_back(1 + rand() % (i % 3 ? 3 : 300));
+        }
+        checkChunks(docs, freqs, true);
+        checkChunks(docs, freqs, false);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
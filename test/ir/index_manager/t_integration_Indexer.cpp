@@ -40,192 +40,210 @@ const IndexerTestConfig INDEXER_TEST_CONFIGS[] = {
     {6,  1, 1, DOCLEVEL, "default:chunk", true},
     {7,  1, 1, DOCLEVEL, "default:chunk", true, 128, 3},
     {8,  1, 1, DOCLEVEL, "default:block", true},
-
-    {9,  1, 1, WORDLEVEL, "default", true},
-    {10, 1, 1, WORDLEVEL, "default", true, 8, 3},
-    {11, 1, 1, WORDLEVEL, "default", true, 128, 3},
-    {12, 1, 1, WORDLEVEL, "realtime", true},
-    {13, 1, 1, WORDLEVEL, "realtime", true, 8, 3},
-    {14, 1, 1, WORDLEVEL, "realtime", true, 128, 3},
-    {15, 1, 1, WORDLEVEL, "default:chunk", true},
-    {16, 1, 1, WORDLEVEL, "default:chunk", true, 128, 3},
-    {17, 1, 1, WORDLEVEL, "default:block", true},
+    {9,  1, 1, DOCLEVEL, "default:simdblock", true},
+
+    {10, 1, 1, WORDLEVEL, "default", true},
+    {11, 1, 1, WORDLEVEL, "default", true, 8, 3},
+    {12, 1, 1, WORDLEVEL, "default", true, 128, 3},
+    {13, 1, 1, WORDLEVEL, "realtime", true},
+    {14, 1, 1, WORDLEVEL, "realtime", true, 8, 3},
+    {15, 1, 1, WORDLEVEL, "realtime", true, 128, 3},
+    {16, 1, 1, WORDLEVEL, "default:chunk", true},
+    {17, 1, 1, WORDLEVEL, "default:chunk", true, 128, 3},
+    {18, 1, 1, WORDLEVEL, "default:block", true},
+    {19, 1, 1, WORDLEVEL, "default:simdblock", true},
 
     // 5
-    {18, 5, 3, DOCLEVEL, "default", true},
-    {19, 5, 3, DOCLEVEL, "default", true, 8, 3},
-    {20, 5, 3, DOCLEVEL, "default", true, 128, 3},
-    {21, 5, 3, DOCLEVEL, "realtime", true},
-    {22, 5, 3, DOCLEVEL, "realtime", true, 8, 3},
-    {23, 5, 3, DOCLEVEL, "realtime", true, 128, 3},
-    {24, 5, 3, DOCLEVEL, "default:chunk", true},
-    {25, 5, 3, DOCLEVEL, "default:chunk", true, 128, 3},
-    {26, 5, 3, DOCLEVEL, "default:block", true},
-
-    {27, 5, 3, WORDLEVEL, "default", true},
-    {28, 5, 3, WORDLEVEL, "default", true, 8, 3},
-    {29, 5, 3, WORDLEVEL, "default", true, 128, 3},
-    {30, 5, 3, WORDLEVEL, "realtime", true},
-    {31, 5, 3, WORDLEVEL, "realtime", true, 8, 3},
-    {32, 5, 3, WORDLEVEL, "realtime", true, 128, 3},
-    {33, 5, 3, WORDLEVEL, "default:chunk", true},
-    {34, 5, 3, WORDLEVEL, "default:chunk", true, 128, 3},
-    {35, 5, 3, WORDLEVEL, "default:block", true},
+    {20, 5, 3, DOCLEVEL, "default", true},
+    {21, 5, 3, DOCLEVEL, "default", true, 8, 3},
+    {22, 5, 3, DOCLEVEL, "default", true, 128, 3},
+    {23, 5, 3, DOCLEVEL, "realtime", true},
+    {24, 5, 3, DOCLEVEL, "realtime", true, 8, 3},
+    {25, 5, 3, DOCLEVEL, "realtime", true, 128, 3},
+    {26, 5, 3, DOCLEVEL, "default:chunk", true},
+    {27, 5, 3, DOCLEVEL, "default:chunk", true, 128, 3},
+    {28, 5, 3, DOCLEVEL, "default:block", true},
+    {29, 5, 3, DOCLEVEL, "default:simdblock", true},
+
+    {30, 5, 3, WORDLEVEL, "default", true},
+    {31, 5, 3, WORDLEVEL, "default", true, 8, 3},
+    {32, 5, 3, WORDLEVEL, "default", true, 128, 3},
+    {33, 5, 3, WORDLEVEL, "realtime", true},
+    {34, 5, 3, WORDLEVEL, "realtime", true, 8, 3},
+    {35, 5, 3, WORDLEVEL, "realtime", true, 128, 3},
+    {36, 5, 3, WORDLEVEL, "default:chunk", true},
+    {37, 5, 3, WORDLEVEL, "default:chunk", true, 128, 3},
+    {38, 5, 3, WORDLEVEL, "default:block", true},
+    {39, 5, 3, WORDLEVEL, "default:simdblock", true},
 
     // 10
-    {36, 10, 10, DOCLEVEL, "default", true},
-    {37, 10, 10, DOCLEVEL, "default", true, 8, 3},
-    {38, 10, 10, DOCLEVEL, "default", true, 128, 3},
-    {39, 10, 10, DOCLEVEL, "realtime", true},
-    {40, 10, 10, DOCLEVEL, "realtime", true, 8, 3},
-    {41, 10, 10, DOCLEVEL, "realtime", true, 128, 3},
-    {42, 10, 10, DOCLEVEL, "default:chunk", true},
-    {43, 10, 10, DOCLEVEL, "default:chunk", true, 128, 3},
-    {44, 10, 10, DOCLEVEL, "default:block", true},
-
-    {45, 10, 10, WORDLEVEL, "default", true},
-    {46, 10, 10, WORDLEVEL, "default", true, 8, 3},
-    {47, 10, 10, WORDLEVEL, "default", true, 128, 3},
-    {48, 10, 10, WORDLEVEL, "realtime", true},
-    {49, 10, 10, WORDLEVEL, "realtime", true, 8, 3},
-    {50, 10, 10, WORDLEVEL, "realtime", true, 128, 3},
-    {51, 10, 10, WORDLEVEL, "default:chunk", true},
-    {52, 10, 10, WORDLEVEL, "default:chunk", true, 128, 3},
-    {53, 10, 10, WORDLEVEL, "default:block", true},
+    {40, 10, 10, DOCLEVEL, "default", true},
+    {41, 10, 10, DOCLEVEL, "default", true, 8, 3},
+    {42, 10, 10, DOCLEVEL, "default", true, 128, 3},
+    {43, 10, 10, DOCLEVEL, "realtime", true},
+    {44, 10, 10, DOCLEVEL, "realtime", true, 8, 3},
+    {45, 10, 10, DOCLEVEL, "realtime", true, 128, 3},
+    {46, 10, 10, DOCLEVEL, "default:chunk", true},
+    {47, 10, 10, DOCLEVEL, "default:chunk", true, 128, 3},
+    {48, 10, 10, DOCLEVEL, "default:block", true},
+    {49, 10, 10, DOCLEVEL, "default:simdblock", true},
+
+    {50, 10, 10, WORDLEVEL, "default", true},
+    {51, 10, 10, WORDLEVEL, "default", true, 8, 3},
+    {52, 10, 10, WORDLEVEL, "default", true, 128, 3},
+    {53, 10, 10, WORDLEVEL, "realtime", true},
+    {54, 10, 10, WORDLEVEL, "realtime", true, 8, 3},
+    {55, 10, 10, WORDLEVEL, "realtime", true, 128, 3},
+    {56, 10, 10, WORDLEVEL, "default:chunk", true},
+    {57, 10, 10, WORDLEVEL, "default:chunk", true, 128, 3},
+    {58, 10, 10, WORDLEVEL, "default:block", true},
+    {59, 10, 10, WORDLEVEL, "default:simdblock", true},
 
     // 100
-    {54, 100, 10, DOCLEVEL, "default", true},
-    {55, 100, 10, DOCLEVEL, "default", true, 8, 3},
-    {56, 100, 10, DOCLEVEL, "default", true, 128, 3},
-    {57, 100, 10, DOCLEVEL, "realtime", true},
-    {58, 100, 10, DOCLEVEL, "realtime", true, 8, 3},
-    {59, 100, 10, DOCLEVEL, "realtime", true, 128, 3},
-    {60, 100, 10, DOCLEVEL, "default:chunk", true},
-    {61, 100, 10, DOCLEVEL, "default:chunk", true, 128, 3},
-    {62, 100, 10, DOCLEVEL, "default:block", true},
-
-    {63, 100, 10, WORDLEVEL, "default", true},
-    {64, 100, 10, WORDLEVEL, "default", true, 8, 3},
-    {65, 100, 10, WORDLEVEL, "default", true, 128, 3},
-    {66, 100, 10, WORDLEVEL, "realtime", true},
-    {67, 100, 10, WORDLEVEL, "realtime", true, 8, 3},
-    {68, 100, 10, WORDLEVEL, "realtime", true, 128, 3},
-    {69, 100, 10, WORDLEVEL, "default:chunk", true},
-    {70, 100, 10, WORDLEVEL, "default:chunk", true, 128, 3},
-    {71, 100, 10, WORDLEVEL, "default:block", true},
+    {60, 100, 10, DOCLEVEL, "default", true},
+    {61, 100, 10, DOCLEVEL, "default", true, 8, 3},
+    {62, 100, 10, DOCLEVEL, "default", true, 128, 3},
+    {63, 100, 10, DOCLEVEL, "realtime", true},
+    {64, 100, 10, DOCLEVEL, "realtime", true, 8, 3},
+    {65, 100, 10, DOCLEVEL, "realtime", true, 128, 3},
+    {66, 100, 10, DOCLEVEL, "default:chunk", true},
+    {67, 100, 10, DOCLEVEL, "default:chunk", true, 128, 3},
+    {68, 100, 10, DOCLEVEL, "default:block", true},
+    {69, 100, 10, DOCLEVEL, "default:simdblock", true},
+
+    {70, 100, 10, WORDLEVEL, "default", true},
+    {71, 100, 10, WORDLEVEL, "default", true, 8, 3},
+    {72, 100, 10, WORDLEVEL, "default", true, 128, 3},
+    {73, 100, 10, WORDLEVEL, "realtime", true},
+    {74, 100, 10, WORDLEVEL, "realtime", true, 8, 3},
+    {75, 100, 10, WORDLEVEL, "realtime", true, 128, 3},
+    {76, 100, 10, WORDLEVEL, "default:chunk", true},
+    {77, 100, 10, WORDLEVEL, "default:chunk", true, 128, 3},
+    {78, 100, 10, WORDLEVEL, "default:block", true},
+    {79, 100, 10, WORDLEVEL, "default:simdblock", true},
 
     // 1K
-    {72, 1000, 10, DOCLEVEL, "default", true},
-    {73, 1000, 10, DOCLEVEL, "default", true, 8, 3},
-    {74, 1000, 10, DOCLEVEL, "default", true, 128, 3},
-    {75, 1000, 10, DOCLEVEL, "realtime", true},
-    {76, 1000, 10, DOCLEVEL, "realtime", true, 8, 3},
-    {77, 1000, 10, DOCLEVEL, "realtime", true, 128, 3},
-    {78, 1000, 10, DOCLEVEL, "default:chunk", true},
-    {79, 1000, 10, DOCLEVEL, "default:chunk", true, 128, 3},
-    {80, 1000, 10, DOCLEVEL, "default:block", true},
-
-    {81, 1000, 10, WORDLEVEL, "default", true},
-    {82, 1000, 10, WORDLEVEL, "default", true, 8, 3},
-    {83, 1000, 10, WORDLEVEL, "default", true, 128, 3},
-    {84, 1000, 10, WORDLEVEL, "realtime", true},
-    {85, 1000, 10, WORDLEVEL, "realtime", true, 8, 3},
-    {86, 1000, 10, WORDLEVEL, "realtime", true, 128, 3},
-    {87, 1000, 10, WORDLEVEL, "default:chunk", true},
-    {88, 1000, 10, WORDLEVEL, "default:chunk", true, 128, 3},
-    {89, 1000, 10, WORDLEVEL, "default:block", true},
+    {80, 1000, 10, DOCLEVEL, "default", true},
+    {81, 1000, 10, DOCLEVEL, "default", true, 8, 3},
+    {82, 1000, 10, DOCLEVEL, "default", true, 128, 3},
+    {83, 1000, 10, DOCLEVEL, "realtime", true},
+    {84, 1000, 10, DOCLEVEL, "realtime", true, 8, 3},
+    {85, 1000, 10, DOCLEVEL, "realtime", true, 128, 3},
+    {86, 1000, 10, DOCLEVEL, "default:chunk", true},
+    {87, 1000, 10, DOCLEVEL, "default:chunk", true, 128, 3},
+    {88, 1000, 10, DOCLEVEL, "default:block", true},
+    {89, 1000, 10, DOCLEVEL, "default:simdblock", true},
+
+    {90, 1000, 10, WORDLEVEL, "default", true},
+    {91, 1000, 10, WORDLEVEL, "default", true, 8, 3},
+    {92, 1000, 10, WORDLEVEL, "default", true, 128, 3},
+    {93, 1000, 10, WORDLEVEL, "realtime", true},
+    {94, 1000, 10, WORDLEVEL, "realtime", true, 8, 3},
+    {95, 1000, 10, WORDLEVEL, "realtime", true, 128, 3},
+    {96, 1000, 10, WORDLEVEL, "default:chunk", true},
+    {97, 1000, 10, WORDLEVEL, "default:chunk", true, 128, 3},
+    {98, 1000, 10, WORDLEVEL, "default:block", true},
+    {99, 1000, 10, WORDLEVEL, "default:simdblock", true},
 
     // 10K
-    {90, 10000, 10, DOCLEVEL, "default", true},
-    {91, 10000, 10, DOCLEVEL, "default", true, 8, 3},
-    {92, 10000, 10, DOCLEVEL, "default", true, 128, 3},
-    {93, 10000, 10, DOCLEVEL, "realtime", true},
-    {94, 10000, 10, DOCLEVEL, "realtime", true, 8, 3},
-    {95, 10000, 10, DOCLEVEL, "realtime", true, 128, 3},
-    {96, 10000, 10, DOCLEVEL, "default:chunk", true},
-    {97, 10000, 10, DOCLEVEL, "default:chunk", true, 128, 3},
-    {98, 10000, 10, DOCLEVEL, "default:block", true},
-
-    {99,  10000, 10, WORDLEVEL, "default", true},
-    {100, 10000, 10, WORDLEVEL, "default", true, 8, 3},
-    {101, 10000, 10, WORDLEVEL, "default", true, 128, 3},
-    {102, 10000, 10, WORDLEVEL, "realtime", true},
-    {103, 10000, 10, WORDLEVEL, "realtime", true, 8, 3},
-    {104, 10000, 10, WORDLEVEL, "realtime", true, 128, 3},
-    {105, 10000, 10, WORDLEVEL, "default:chunk", true},
-    {106, 10000, 10, WORDLEVEL, "default:chunk", true, 128, 3},
-    {107, 10000, 10, WORDLEVEL, "default:block", true},
+    {100, 10000, 10, DOCLEVEL, "default", true},
+    {101, 10000, 10, DOCLEVEL, "default", true, 8, 3},
+    {102, 10000, 10, DOCLEVEL, "default", true, 128, 3},
+    {103, 10000, 10, DOCLEVEL, "realtime", true},
+    {104, 10000, 10, DOCLEVEL, "realtime", true, 8, 3},
+    {105, 10000, 10, DOCLEVEL, "realtime", true, 128, 3},
+    {106, 10000, 10, DOCLEVEL, "default:chunk", true},
+    {107, 10000, 10, DOCLEVEL, "default:chunk", true, 128, 3},
+    {108, 10000, 10, DOCLEVEL, "default:block", true},
+    {109, 10000, 10, DOCLEVEL, "default:simdblock", true},
+
+    {110, 10000, 10, WORDLEVEL, "default", true},
+    {111, 10000, 10, WORDLEVEL, "default", true, 8, 3},
+    {112, 10000, 10, WORDLEVEL, "default", true, 128, 3},
+    {113, 10000, 10, WORDLEVEL, "realtime", true},
+    {114, 10000, 10, WORDLEVEL, "realtime", true, 8, 3},
+    {115, 10000, 10, WORDLEVEL, "realtime", true, 128, 3},
+    {116, 10000, 10, WORDLEVEL, "default:chunk", true},
+    {117, 10000, 10, WORDLEVEL, "default:chunk", true, 128, 3},
+    {118, 10000, 10, WORDLEVEL, "default:block", true},
+    {119, 10000, 10, WORDLEVEL, "default:simdblock", true},
 
     // 100K
-    {108, 100000, 10, DOCLEVEL, "default", true},
-    {109, 100000, 10, DOCLEVEL, "default", true, 8, 3},
-    {110, 100000, 10, DOCLEVEL, "default", true, 128, 3},
-    {111, 100000, 10, DOCLEVEL, "realtime", true},
-    {112, 100000, 10, DOCLEVEL, "realtime", true, 8, 3},
-    {113, 100000, 10, DOCLEVEL, "realtime", true, 128, 3},
-    {114, 100000, 10, DOCLEVEL, "default:chunk", true},
-    {115, 100000, 10, DOCLEVEL, "default:chunk", true, 128, 3},
-    {116, 100000, 10, DOCLEVEL, "default:block", true},
-
-    {117, 100000, 10, WORDLEVEL, "default", true},
-    {118, 100000, 10, WORDLEVEL, "default", true, 8, 3},
-    {119, 100000, 10, WORDLEVEL, "default", true, 128, 3},
-    {120, 100000, 10, WORDLEVEL, "realtime", true},
-    {121, 100000, 10, WORDLEVEL, "realtime", true, 8, 3},
-    {122, 100000, 10, WORDLEVEL, "realtime", true, 128, 3},
-    {123, 100000, 10, WORDLEVEL, "default:chunk", true},
-    {124, 100000, 10, WORDLEVEL, "default:chunk", true, 128, 3},
-    {125, 100000, 10, WORDLEVEL, "default:block", true},
+    {120, 100000, 10, DOCLEVEL, "default", true},
+    {121, 100000, 10, DOCLEVEL, "default", true, 8, 3},
+    {122, 100000, 10, DOCLEVEL, "default", true, 128, 3},
+    {123, 100000, 10, DOCLEVEL, "realtime", true},
+    {124, 100000, 10, DOCLEVEL, "realtime", true, 8, 3},
+    {125, 100000, 10, DOCLEVEL, "realtime", true, 128, 3},
+    {126, 100000, 10, DOCLEVEL, "default:chunk", true},
+    {127, 100000, 10, DOCLEVEL, "default:chunk", true, 128, 3},
+    {128, 100000, 10, DOCLEVEL, "default:block", true},
+    {129, 100000, 10, DOCLEVEL, "default:simdblock", true},
+
+    {130, 100000, 10, WORDLEVEL, "default", true},
+    {131, 100000, 10, WORDLEVEL, "default", true, 8, 3},
+    {132, 100000, 10, WORDLEVEL, "default", true, 128, 3},
+    {133, 100000, 10, WORDLEVEL, "realtime", true},
+    {134, 100000, 10, WORDLEVEL, "realtime", true, 8, 3},
+    {135, 100000, 10, WORDLEVEL, "realtime", true, 128, 3},
+    {136, 100000, 10, WORDLEVEL, "default:chunk", true},
+    {137, 100000, 10, WORDLEVEL, "default:chunk", true, 128, 3},
+    {138, 100000, 10, WORDLEVEL, "default:block", true},
+    {139, 100000, 10, WORDLEVEL, "default:simdblock", true},
 
     // 1M
-    {126, 1000000, 10, DOCLEVEL, "default", true},
-    {127, 1000000, 10, DOCLEVEL, "default", true, 8, 3},
-    {128, 1000000, 10, DOCLEVEL, "default", true, 128, 3},
-    {129, 1000000, 10, DOCLEVEL, "realtime", true},
-    {130, 1000000, 10, DOCLEVEL, "realtime", true, 8, 3},
-    {131, 1000000, 10, DOCLEVEL, "realtime", true, 128, 3},
-    {132, 1000000, 10, DOCLEVEL, "default:chunk", true},
-    {133, 1000000, 10, DOCLEVEL, "default:chunk", true, 128, 3},
-    {134, 1000000, 10, DOCLEVEL, "default:block", true},
-
-    {135, 1000000, 10, WORDLEVEL, "default", true},
-    {136, 1000000, 10, WORDLEVEL, "default", true, 8, 3},
-    {137, 1000000, 10, WORDLEVEL, "default", true, 128, 3},
-    {138, 1000000, 10, WORDLEVEL, "realtime", true},
-    {139, 1000000, 10, WORDLEVEL, "realtime", true, 8, 3},
-    {140, 1000000, 10, WORDLEVEL, "realtime", true, 128, 3},
-    {141, 1000000, 10, WORDLEVEL, "default:chunk", true},
-    {142, 1000000, 10, WORDLEVEL, "default:chunk", true, 128, 3},
-    {143, 1000000, 10, WORDLEVEL, "default:block", true},
+    {140, 1000000, 10, DOCLEVEL, "default", true},
+    {141, 1000000, 10, DOCLEVEL, "default", true, 8, 3},
+    {142, 1000000, 10, DOCLEVEL, "default", true, 128, 3},
+    {143, 1000000, 10, DOCLEVEL, "realtime", true},
+    {144, 1000000, 10, DOCLEVEL, "realtime", true, 8, 3},
+    {145, 1000000, 10, DOCLEVEL, "realtime", true, 128, 3},
+    {146, 1000000, 10, DOCLEVEL, "default:chunk", true},
+    {147, 1000000, 10, DOCLEVEL, "default:chunk", true, 128, 3},
+    {148, 1000000, 10, DOCLEVEL, "default:block", true},
+    {149, 1000000, 10, DOCLEVEL, "default:simdblock", true},
+
+    {150, 1000000, 10, WORDLEVEL, "default", true},
+    {151, 1000000, 10, WORDLEVEL, "default", true, 8, 3},
+    {152, 1000000, 10, WORDLEVEL, "default", true, 128, 3},
+    {153, 1000000, 10, WORDLEVEL, "realtime", true},
+    {154, 1000000, 10, WORDLEVEL, "realtime", true, 8, 3},
+    {155, 1000000, 10, WORDLEVEL, "realtime", true, 128, 3},
+    {156, 1000000, 10, WORDLEVEL, "default:chunk", true},
+    {157, 1000000, 10, WORDLEVEL, "default:chunk", true, 128, 3},
+    {158, 1000000, 10, WORDLEVEL, "default:block", true},
+    {159, 1000000, 10, WORDLEVEL, "default:simdblock", true},
 
 
     // 10M
-    {144, 10000000, 10, DOCLEVEL, "default", true},
-    {145, 10000000, 10, DOCLEVEL, "default", true, 8, 3},
-    {146, 10000000, 10, DOCLEVEL, "default", true, 128, 3},
-    {147, 10000000, 10, DOCLEVEL, "realtime", true},
-    {148, 10000000, 10, DOCLEVEL, "realtime", true, 8, 3},
-    {149, 10000000, 10, DOCLEVEL, "realtime", true, 128, 3},
-    {150, 10000000, 10, DOCLEVEL, "default:chunk", true},
-    {151, 10000000, 10, DOCLEVEL, "default:chunk", true, 128, 3},
-    {152, 10000000, 10, DOCLEVEL, "default:block", true},
-
-    {153, 10000000, 10, WORDLEVEL, "default", true},
-    {154, 10000000, 10, WORDLEVEL, "default", true, 8, 3},
-    {155, 10000000, 10, WORDLEVEL, "default", true, 128, 3},
-    {156, 10000000, 10, WORDLEVEL, "realtime", true},
-    {157, 10000000, 10, WORDLEVEL, "realtime", true, 8, 3},
-    {158, 10000000, 10, WORDLEVEL, "realtime", true, 128, 3},
-    {159, 10000000, 10, WORDLEVEL, "default:chunk", true},
-    {160, 10000000, 10, WORDLEVEL, "default:chunk", true, 128, 3},
-    {161, 10000000, 10, WORDLEVEL, "default:block", true},
+    {160, 10000000, 10, DOCLEVEL, "default", true},
+    {161, 10000000, 10, DOCLEVEL, "default", true, 8, 3},
+    {162, 10000000, 10, DOCLEVEL, "default", true, 128, 3},
+    {163, 10000000, 10, DOCLEVEL, "realtime", true},
+    {164, 10000000, 10, DOCLEVEL, "realtime", true, 8, 3},
+    {165, 10000000, 10, DOCLEVEL, "realtime", true, 128, 3},
+    {166, 10000000, 10, DOCLEVEL, "default:chunk", true},
+    {167, 10000000, 10, DOCLEVEL, "default:chunk", true, 128, 3},
+    {168, 10000000, 10, DOCLEVEL, "default:block", true},
+    {169, 10000000, 10, DOCLEVEL, "default:simdblock", true},
+
+    {170, 10000000, 10, WORDLEVEL, "default", true},
+    {171, 10000000, 10, WORDLEVEL, "default", true, 8, 3},
+    {172, 10000000, 10, WORDLEVEL, "default", true, 128, 3},
+    {173, 10000000, 10, WORDLEVEL, "realtime", true},
+    {174, 10000000, 10, WORDLEVEL, "realtime", true, 8, 3},
+    {175, 10000000, 10, WORDLEVEL, "realtime", true, 128, 3},
+    {176, 10000000, 10, WORDLEVEL, "default:chunk", true},
+    {177, 10000000, 10, WORDLEVEL, "default:chunk", true, 128, 3},
+    {178, 10000000, 10, WORDLEVEL, "default:block", true},
+    {179, 10000000, 10, WORDLEVEL, "default:simdblock", true},
 };
 
 /** the parameter number */
 const int INDEXER_TEST_CONFIG_NUM = sizeof(INDEXER_TEST_CONFIGS) / sizeof(IndexerTestConfig);
 
 /** if the command options of "--run_config_list" or "--run_config_range" are not specified, run this config list */
-const int DEFAULT_CONFIG_LIST[] = {18, 22, 24, 26, 28, 30};
+const int DEFAULT_CONFIG_LIST[] = {20, 24, 26, 28, 29, 31, 33, 39};
 
 /** the command option to specify a list of config numbers, such as "--run_config_list 0 1 2 3" */
 const char* OPTION_CONFIG_LIST = "run_config_list";
@@ -0,0 +1,164 @@
+/// @file   t_int_codec_bench.cpp
+/// @brief  Size and decoding speed of the integer codecs on posting lists.
+///
+/// usage: manual_t_int_codec_bench [postings file] [block size]
+///
+/// The postings file is a sequence of [uint32 n][n sorted doc ids], as
+/// dumped from an index. Without a file, lists of zipfian lengths and
+/// densities are generated. The lists are coded as d-gaps by each codec of
+/// IntCodecRegistry, then by AutoIntCodec selecting per block.
+#include <util/compression/int/int_codec_registry.h>
+#include <util/ClockTimer.h>
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+
+using namespace izenelib::util::compression;
+
+typedef std::vector<std::vector<uint32_t> > lists_t;
+
+static bool load_postings(const char* path, lists_t& lists)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) return false;
+
+    uint32_t n;
+    while (ifs.read(reinterpret_cast<char*>(&n), sizeof(n)))
+    {
+        std::vector<uint32_t> list(n);
+        if (n && !ifs.read(reinterpret_cast<char*>(&list[0]), n * sizeof(uint32_t)))
+            break;
+        lists.push_back(list);
+    }
+    return true;
+}
+
+static void generate_postings(lists_t& lists)
+{
+    const uint32_t DOC_NUM = 1 << 24;
+    srand(7);
+    for (uint32_t i = 1; i <= 3000; ++i)
+    {
+        // the i-th term appears in about DOC_NUM / (8 * i) documents
+        uint32_t n = std::max(1U, DOC_NUM / (8 * i) / (1 + rand() % 4));
+        std::vector<uint32_t> list(n);
+        uint32_t doc = 0;
+        for (uint32_t j = 0; j < n; ++j)
+        {
+            // clustered documents, with a run of close ids now and then
+            doc += rand() % 16 ? 1 + rand() % (2 * DOC_NUM / n) : 1 + rand() % 4;
+            list[j] = doc;
+        }
+        lists.push_back(list);
+    }
+}
+
+static void to_gaps(lists_t& lists)
+{
+    for (size_t i = 0; i < lists.size(); ++i)
+    {
+        std::vector<uint32_t>& list = lists[i];
+        for (size_t j = list.size(); j-- > 1;)
+            list[j] -= list[j - 1];
+    }
+}
+
+/// encodes all lists, then decodes them several times
+static void run(const char* name, AutoIntCodec& codec, const lists_t& lists, uint64_t total)
+{
+    std::vector<std::vector<uint32_t> > encoded(lists.size());
+    uint64_t words = 0;
+
+    izenelib::util::ClockTimer timer;
+    for (size_t i = 0; i < lists.size(); ++i)
+    {
+        codec.encode(lists[i], encoded[i]);
+        words += encoded[i].size();
+    }
+    double encodeSeconds = timer.elapsed();
+
+    const int ROUNDS = 5;
+    std::vector<uint32_t> decoded;
+    bool ok = true;
+    timer.restart();
+    for (int r = 0; r < ROUNDS; ++r)
+    {
+        for (size_t i = 0; i < lists.size(); ++i)
+        {
+            decoded.resize(lists[i].size() + IntBlockCodec::DECODE_PADDING);
+            codec.decode(&encoded[i][0], &decoded[0]);
+        }
+    }
+    double decodeSeconds = timer.elapsed();
+
+    for (size_t i = 0; i < lists.size() && ok; ++i)
+    {
+        decoded.resize(lists[i].size() + IntBlockCodec::DECODE_PADDING);
+        codec.decode(&encoded[i][0], &decoded[0]);
+        ok = std::equal(lists[i].begin(), lists[i].end(), decoded.begin());
+    }
+
+    std::cout << std::setw(20) << std::left << name << std::right << std::fixed
+        << std::setprecision(2) << std::setw(10) << 32.0 * words / total
+        << std::setw(12) << total / encodeSeconds / 1e6
+        << std::setw(12) << ROUNDS * total / decodeSeconds / 1e6
+        << (ok ? "" : "  MISMATCH") << std::endl;
+}
+
+static void print_usage(const AutoIntCodec& codec)
+{
+    std::cout << "  blocks per codec:";
+    for (uint32_t tag = 0; tag < INT_CODEC_NUM; ++tag)
+    {
+        if (codec.codecUsage()[tag])
+            std::cout << " " << codec.registry().get(tag)->name() << "=" << codec.codecUsage()[tag];
+    }
+    std::cout << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    lists_t lists;
+    if (argc > 1 && argv[1][0] != '-')
+    {
+        if (!load_postings(argv[1], lists))
+        {
+            std::cerr << "can not read " << argv[1] << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        generate_postings(lists);
+    }
+    const uint32_t BLOCK_SIZE = argc > 2 ? atoi(argv[2]) : 1024;
+
+    to_gaps(lists);
+    uint64_t total = 0;
+    for (size_t i = 0; i < lists.size(); ++i)
+        total += lists[i].size();
+    std::cout << lists.size() << " lists, " << total << " postings, blocks of " << BLOCK_SIZE << std::endl;
+    std::cout << std::setw(20) << std::left << "codec" << std::right << std::setw(10) << "bits/int"
+        << std::setw(12) << "enc Mi/s" << std::setw(12) << "dec Mi/s" << std::endl;
+
+    for (uint32_t tag = 0; tag < INT_CODEC_NUM; ++tag)
+    {
+        AutoIntCodec codec(BLOCK_SIZE);
+        codec.setFixedCodec(tag);
+        run(codec.registry().get(tag)->name(), codec, lists, total);
+    }
+
+    AutoIntCodec estimate(BLOCK_SIZE, IntCodecSelector::ESTIMATE);
+    run("auto (estimate)", estimate, lists, total);
+    print_usage(estimate);
+
+    AutoIntCodec exhaustive(BLOCK_SIZE, IntCodecSelector::EXHAUSTIVE);
+    run("auto (exhaustive)", exhaustive, lists, total);
+    print_usage(exhaustive);
+
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include <util/compression/int/int_codec_registry.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <cstdlib>
+
+using namespace izenelib::util::compression;
+
+namespace
+{
+
+/// d-gaps of a sorted list with density 1 / gap, with outliers up to outlierBits
+void make_gaps(std::vector<uint32_t>& data, uint32_t size, uint32_t gap, uint32_t outlierBits)
+{
+    data.resize(size);
+    for (uint32_t i = 0; i < size; ++i)
+    {
+        data[i] = 1 + rand() % gap;
+        if (outlierBits && rand() % 64 == 0)
+            data[i] = rand() % (outlierBits == 32 ? 0xFFFFFFFF : (1U << outlierBits));
+    }
+}
+
+void check_block_codec(IntBlockCodec* codec, const std::vector<uint32_t>& data, uint32_t shift)
+{
+    std::vector<uint32_t> encoded(IntBlockCodec::maxEncodedWords(data.size()) + 8);
+    std::vector<uint32_t> decoded(data.size() + IntBlockCodec::DECODE_PADDING + 8);
+
+    uint32_t* out = &encoded[0];
+    while (reinterpret_cast<uintptr_t>(out) & 15) ++out;
+    uint32_t words = codec->encode(data.empty() ? NULL : &data[0], data.size(), out);
+
+    // decode from a copy moved by shift words, which breaks the alignment
+    std::vector<uint32_t> moved(words + 8);
+    std::copy(out, out + words, &moved[shift]);
+    codec->decode(&moved[shift], words, &decoded[shift], data.size());
+
+    BOOST_CHECK_MESSAGE(std::equal(data.begin(), data.end(), decoded.begin() + shift),
+            codec->name() << " size " << data.size() << " shift " << shift);
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(int_codec_registry_test)
+
+BOOST_AUTO_TEST_CASE(blockCodecs)
+{
+    IntCodecRegistry registry;
+    const uint32_t sizes[] = {1, 20, 127, 128, 129, 1000, 4096};
+    const uint32_t gaps[] = {1, 16, 4000, 1 << 20};
+
+    for (uint32_t tag = 0; tag < INT_CODEC_NUM; ++tag)
+    {
+        IntBlockCodec* codec = registry.get(tag);
+        BOOST_CHECK_EQUAL(registry.tagOf(codec->name()), tag);
+
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+        {
+            for (size_t g = 0; g < sizeof(gaps) / sizeof(gaps[0]); ++g)
+            {
+                std::vector<uint32_t> data;
+                make_gaps(data, sizes[s], gaps[g], 0);
+                check_block_codec(codec, data, 0);
+                check_block_codec(codec, data, 1);
+            }
+        }
+
+        std::vector<uint32_t> data(300, codec->maxValue());
+        check_block_codec(codec, data, 3);
+    }
+    BOOST_CHECK_EQUAL(registry.tagOf("none"), (uint32_t)INT_CODEC_NUM);
+}
+
+BOOST_AUTO_TEST_CASE(estimates)
+{
+    IntCodecRegistry registry;
+    IntCodecSelector selector(registry);
+    IntBlockStats stats;
+    std::vector<uint32_t> data;
+
+    // the estimates stay within a third of the real sizes
+    const uint32_t gaps[] = {2, 16, 300, 70000};
+    for (size_t g = 0; g < sizeof(gaps) / sizeof(gaps[0]); ++g)
+    {
+        make_gaps(data, 1024, gaps[g], 20);
+        stats.compute(&data[0], data.size());
+        std::vector<uint32_t> out(IntBlockCodec::maxEncodedWords(data.size()) + 4);
+        uint32_t* aligned = &out[0];
+        while (reinterpret_cast<uintptr_t>(aligned) & 15) ++aligned;
+
+        for (uint32_t tag = 0; tag < INT_CODEC_NUM; ++tag)
+        {
+            double real = 32.0 * registry.get(tag)->encode(&data[0], data.size(), aligned);
+            double estimate = selector.estimateBits(tag, &data[0], stats);
+            BOOST_CHECK_MESSAGE(estimate > real * 0.66 && estimate < real * 1.33,
+                    registry.get(tag)->name() << " gap " << gaps[g]
+                    << " real " << real << " estimate " << estimate);
+        }
+    }
+
+    data.assign(128, 1U << 30);
+    stats.compute(&data[0], data.size());
+    BOOST_CHECK_EQUAL(stats.maxBits, 31U);
+    BOOST_CHECK_EQUAL(selector.estimateBits(INT_CODEC_VBYTE, &data[0], stats), (uint64_t)-1);
+    BOOST_CHECK_EQUAL(selector.estimateBits(INT_CODEC_S16, &data[0], stats), (uint64_t)-1);
+    BOOST_CHECK(selector.estimateBits(INT_CODEC_FASTPFOR, &data[0], stats) != (uint64_t)-1);
+}
+
+BOOST_AUTO_TEST_CASE(autoCodec)
+{
+    const IntCodecSelector::Mode modes[] = {IntCodecSelector::ESTIMATE, IntCodecSelector::EXHAUSTIVE};
+    for (size_t m = 0; m < 2; ++m)
+    {
+        AutoIntCodec codec(512, modes[m]);
+
+        // blocks of different densities, and large values
+        std::vector<uint32_t> data, part;
+        const uint32_t gaps[] = {1, 3, 1 << 12, 1 << 24, 2};
+        for (size_t g = 0; g < sizeof(gaps) / sizeof(gaps[0]); ++g)
+        {
+            make_gaps(part, 700 + g * 37, gaps[g], g == 3 ? 32 : 0);
+            data.insert(data.end(), part.begin(), part.end());
+        }
+
+        std::vector<uint32_t> encoded;
+        codec.encode(data, encoded);
+        BOOST_CHECK(encoded.size() < data.size());
+
+        uint32_t size = AutoIntCodec::decodedSize(&encoded[0]);
+        BOOST_CHECK_EQUAL(size, data.size());
+        std::vector<uint32_t> decoded(size + IntBlockCodec::DECODE_PADDING);
+        BOOST_CHECK_EQUAL(codec.decode(&encoded[0], &decoded[0]), encoded.size());
+        BOOST_CHECK(std::equal(data.begin(), data.end(), decoded.begin()));
+
+        uint32_t used = 0;
+        for (uint32_t tag = 0; tag < INT_CODEC_NUM; ++tag)
+            used += codec.codecUsage()[tag] > 0;
+        BOOST_CHECK(used > 1);
+
+        // a misaligned copy decodes too
+        std::vector<uint32_t> moved(encoded.size() + 1);
+        std::copy(encoded.begin(), encoded.end(), moved.begin() + 1);
+        std::fill(decoded.begin(), decoded.end(), 0);
+        codec.decode(&moved[1], &decoded[0]);
+        BOOST_CHECK(std::equal(data.begin(), data.end(), decoded.begin()));
+    }
+
+    AutoIntCodec codec;
+    std::vector<uint32_t> empty, encoded, decoded(IntBlockCodec::DECODE_PADDING);
+    codec.encode(empty, encoded);
+    BOOST_CHECK_EQUAL(encoded.size(), AutoIntCodec::HEADER_WORDS);
+    BOOST_CHECK_EQUAL(codec.decode(&encoded[0], &decoded[0]), AutoIntCodec::HEADER_WORDS);
+
+    // a fixed codec not able to encode the values falls back to copy
+    std::vector<uint32_t> data(1000, 0xFFFFFFFF);
+    codec.setFixedCodec(INT_CODEC_VBYTE);
+    codec.encode(data, encoded);
+    decoded.resize(data.size() + IntBlockCodec::DECODE_PADDING);
+    codec.decode(&encoded[0], &decoded[0]);
+    BOOST_CHECK(std::equal(data.begin(), data.end(), decoded.begin()));
+    BOOST_CHECK_EQUAL(codec.codecUsage()[INT_CODEC_COPY], 1U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,160 @@
+/// @file   t_levenshtein_bench.cpp
+/// @brief  Building and matching time of the Levenshtein automata.
+///
+/// usage: manual_t_levenshtein_bench [words file] [query number]
+///
+/// The words file has a UTF-8 word per line. Without a file, words of mixed
+/// latin and CJK chars are generated. Each query, a word with a typo, is built
+/// into LevenshteinAutomata (NFA to DFA), LevenshteinBitAutomaton and
+/// ParametricLevenshteinAutomaton, and matched against all the words.
+#include <util/string/automata/LevenshteinAutomata.h>
+#include <util/string/automata/LevenshteinBitAutomaton.h>
+#include <util/string/automata/ParametricLevenshteinAutomaton.h>
+#include <util/ustring/UString.h>
+#include <util/ClockTimer.h>
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <stdlib.h>
+
+using izenelib::util::UString;
+using izenelib::util::ClockTimer;
+
+static void load_words(const char* path, std::vector<UString>& words)
+{
+    std::ifstream ifs(path);
+    std::string line;
+    while (std::getline(ifs, line))
+    {
+        if (!line.empty()) words.push_back(UString(line, UString::UTF_8));
+    }
+}
+
+static void generate_words(std::vector<UString>& words)
+{
+    srand(11);
+    for (size_t i = 0; i < 20000; ++i)
+    {
+        UString word;
+        size_t len = 2 + rand() % 10;
+        bool cjk = rand() % 2;
+        for (size_t j = 0; j < len; ++j)
+            word.push_back(cjk ? 0x4e00 + rand() % 200 : 'a' + rand() % 26);
+        words.push_back(word);
+    }
+}
+
+/// a word with a random edit
+static UString typo(const UString& word)
+{
+    UString query(word);
+    size_t pos = rand() % query.length();
+    switch (rand() % 3)
+    {
+    case 0: query.erase(pos, 1); break;
+    case 1: query.insert(pos, 1, query[rand() % query.length()]); break;
+    default: query[pos] = query[rand() % query.length()]; break;
+    }
+    return query;
+}
+
+template <class AutomatonT>
+static size_t count_matches(const AutomatonT& automaton, const std::vector<UString>& words)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < words.size(); ++i)
+    {
+        typename AutomatonT::State state = automaton.start();
+        size_t j = 0;
+        for (; j < words[i].length() && automaton.next(state, words[i][j], state); ++j);
+        if (j == words[i].length() && automaton.isFinal(state)) ++count;
+    }
+    return count;
+}
+
+static void report(const char* name, double build, double match, size_t query_num, size_t word_num, size_t matches)
+{
+    std::cout << std::setw(12) << name
+              << std::setw(14) << build * 1e6 / query_num
+              << std::setw(14) << match * 1e9 / query_num / word_num
+              << std::setw(10) << matches << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<UString> words;
+    if (argc > 1)
+        load_words(argv[1], words);
+    else
+        generate_words(words);
+    size_t query_num = argc > 2 ? atoi(argv[2]) : 100;
+    if (words.empty()) return 1;
+
+    std::vector<UString> queries;
+    for (size_t i = 0; i < query_num; ++i)
+        queries.push_back(typo(words[rand() % words.size()]));
+
+    std::cout << words.size() << " words, " << query_num << " queries" << std::endl;
+    for (unsigned int k = 1; k <= 2; ++k)
+    {
+        std::cout << "distance " << k << ":" << std::endl;
+        std::cout << std::setw(12) << "automaton"
+                  << std::setw(14) << "build us"
+                  << std::setw(14) << "match ns"
+                  << std::setw(10) << "matches" << std::endl;
+
+        // the DFA matches by strings of one char, so it reads fewer words
+        std::vector<UString> dfa_words(words.begin(), words.begin() + std::min(words.size(), (size_t)2000));
+        ClockTimer timer;
+        for (size_t i = 0; i < queries.size(); ++i)
+            izenelib::util::LevenshteinAutomata<UString> automaton(queries[i], k);
+        double build = timer.elapsed();
+
+        double match = 0;
+        size_t matches = 0;
+        for (size_t i = 0; i < queries.size(); ++i)
+        {
+            izenelib::util::LevenshteinAutomata<UString> automaton(queries[i], k);
+            timer.restart();
+            for (size_t j = 0; j < dfa_words.size(); ++j)
+                matches += automaton.Match(dfa_words[j]);
+            match += timer.elapsed();
+        }
+        report("nfa-dfa", build, match, query_num, dfa_words.size(), matches);
+
+        std::vector<izenelib::util::LevenshteinBitAutomaton<UString::value_type> > bit_automata(queries.size());
+        timer.restart();
+        for (size_t i = 0; i < queries.size(); ++i)
+            bit_automata[i].compile(queries[i], k);
+        build = timer.elapsed();
+
+        timer.restart();
+        matches = 0;
+        for (size_t i = 0; i < queries.size(); ++i)
+            matches += count_matches(bit_automata[i], words);
+        match = timer.elapsed();
+        report("bit", build, match, query_num, words.size(), matches);
+
+        for (int transposition = 0; transposition < 2; ++transposition)
+        {
+            // the tables are built once, at the first use
+            izenelib::util::ParametricLevenshteinTables::get(k, transposition);
+
+            std::vector<izenelib::util::ParametricLevenshteinAutomaton<UString::value_type> > automata(queries.size());
+            timer.restart();
+            for (size_t i = 0; i < queries.size(); ++i)
+                automata[i].compile(queries[i], k, transposition);
+            build = timer.elapsed();
+
+            timer.restart();
+            matches = 0;
+            for (size_t i = 0; i < queries.size(); ++i)
+                matches += count_matches(automata[i], words);
+            match = timer.elapsed();
+            report(transposition ? "parametric-t" : "parametric", build, match, query_num, words.size(), matches);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include <util/mpmc_queue.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+#include <string>
+#include <vector>
+
+using izenelib::util::mpmc_queue;
+
+namespace
+{
+
+void produce(mpmc_queue<int>* queue, int producer, int num)
+{
+    for (int i = 0; i < num; ++i)
+        queue->push(producer << 24 | i);
+}
+
+/// checks the elements of each producer are popped in their order
+void consume(mpmc_queue<int>* queue, int num, std::vector<int>* counts, int* errors)
+{
+    std::vector<int> last(counts->size(), -1);
+    for (int i = 0; i < num; ++i)
+    {
+        int v;
+        queue->pop(v);
+        int producer = v >> 24;
+        int seq = v & 0xffffff;
+        if (seq <= last[producer])
+            ++*errors;
+        last[producer] = seq;
+        ++(*counts)[producer];
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(t_mpmc_queue)
+
+BOOST_AUTO_TEST_CASE(push_pop)
+{
+    mpmc_queue<std::string> queue(5);
+    BOOST_CHECK_EQUAL(queue.capacity(), 8U);
+    BOOST_CHECK(queue.empty());
+
+    std::string s;
+    BOOST_CHECK(!queue.try_pop(s));
+    for (int i = 0; i < 8; ++i)
+        BOOST_CHECK(queue.try_push(std::string(i + 1, 'a')));
+    BOOST_CHECK(!queue.try_push("full"));
+    BOOST_CHECK_EQUAL(queue.size(), 8U);
+
+    // round the ring a few times
+    for (int i = 0; i < 20; ++i)
+    {
+        BOOST_REQUIRE(queue.try_pop(s));
+        BOOST_CHECK_EQUAL(s.size(), (size_t)(i % 8 + 1));
+        BOOST_CHECK(queue.try_push(s));
+    }
+    for (int i = 0; i < 8; ++i)
+        queue.pop(s);
+    BOOST_CHECK(queue.empty());
+}
+
+BOOST_AUTO_TEST_CASE(producers_consumers)
+{
+    const int producerNum = 4;
+    const int consumerNum = 4;
+    const int num = 100000;
+
+    mpmc_queue<int> queue(64);
+    std::vector<std::vector<int> > counts(consumerNum, std::vector<int>(producerNum));
+    std::vector<int> errors(consumerNum);
+
+    boost::thread_group threads;
+    for (int i = 0; i < consumerNum; ++i)
+        threads.create_thread(boost::bind(consume, &queue, num, &counts[i], &errors[i]));
+    for (int i = 0; i < producerNum; ++i)
+        threads.create_thread(boost::bind(produce, &queue, i, num));
+    threads.join_all();
+
+    BOOST_CHECK(queue.empty());
+    for (int p = 0; p < producerNum; ++p)
+    {
+        int total = 0;
+        for (int c = 0; c < consumerNum; ++c)
+            total += counts[c][p];
+        BOOST_CHECK_EQUAL(total, num);
+    }
+    for (int c = 0; c < consumerNum; ++c)
+        BOOST_CHECK_EQUAL(errors[c], 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,103 @@
+#include <boost/test/unit_test.hpp>
+
+#include <util/string/automata/ParametricLevenshteinAutomaton.h>
+#include <util/ustring/UString.h>
+
+#include <cstdlib>
+#include <string>
+
+using namespace izenelib::util;
+
+namespace
+{
+
+/// the edit distance, counting the swap of two adjacent chars as one edit if @p transposition
+size_t naiveDistance(const std::string &a, const std::string &b, bool transposition)
+{
+    std::vector<std::vector<size_t> > d(a.size() + 1, std::vector<size_t>(b.size() + 1));
+    for (size_t i = 0; i <= a.size(); ++i) d[i][0] = i;
+    for (size_t j = 0; j <= b.size(); ++j) d[0][j] = j;
+    for (size_t i = 1; i <= a.size(); ++i)
+    {
+        for (size_t j = 1; j <= b.size(); ++j)
+        {
+            d[i][j] = std::min(std::min(d[i - 1][j] + 1, d[i][j - 1] + 1),
+                    d[i - 1][j - 1] + (a[i - 1] != b[j - 1]));
+            if (transposition && i > 1 && j > 1 && a[i - 1] == b[j - 2] && a[i - 2] == b[j - 1])
+                d[i][j] = std::min(d[i][j], d[i - 2][j - 2] + 1);
+        }
+    }
+    return d[a.size()][b.size()];
+}
+
+std::string randomString(size_t max_len, size_t alphabet)
+{
+    std::string str(rand() % (max_len + 1), 'a');
+    for (size_t i = 0; i < str.size(); ++i)
+        str[i] = 'a' + rand() % alphabet;
+    return str;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(t_parametric_levenshtein)
+
+BOOST_AUTO_TEST_CASE(distance_test)
+{
+    srand(59);
+    for (size_t k = 0; k <= ParametricLevenshteinTables::kMaxDistance; ++k)
+    {
+        for (int transposition = 0; transposition < 2; ++transposition)
+        {
+            for (size_t n = 0; n < 300; ++n)
+            {
+                std::string pattern = randomString(12, 3);
+                ParametricLevenshteinAutomaton<char> automaton;
+                BOOST_REQUIRE(automaton.compile(pattern, k, transposition));
+
+                for (size_t m = 0; m < 30; ++m)
+                {
+                    // most strings close to the pattern
+                    std::string str = m % 3 ? pattern : randomString(12, 3);
+                    for (size_t e = rand() % 4; e > 0 && !str.empty(); --e)
+                    {
+                        size_t pos = rand() % str.size();
+                        switch (rand() % 4)
+                        {
+                        case 0: str.erase(pos, 1); break;
+                        case 1: str.insert(pos, 1, 'a' + rand() % 3); break;
+                        case 2: str[pos] = 'a' + rand() % 3; break;
+                        default: if (pos + 1 < str.size()) std::swap(str[pos], str[pos + 1]); break;
+                        }
+                    }
+
+                    size_t expected = std::min(naiveDistance(pattern, str, transposition), k + 1);
+                    BOOST_REQUIRE_EQUAL(automaton.distance(str), expected);
+                    BOOST_CHECK_EQUAL(automaton.match(str), expected <= k);
+                }
+            }
+        }
+    }
+
+    ParametricLevenshteinAutomaton<char> automaton;
+    BOOST_CHECK(!automaton.compile(std::string("abc"), 3));
+}
+
+BOOST_AUTO_TEST_CASE(ucs2_test)
+{
+    UString pattern("中华人民共和国", UString::UTF_8);
+    ParametricLevenshteinAutomaton<UString::value_type> automaton;
+    BOOST_REQUIRE(automaton.compile(pattern, 1));
+
+    BOOST_CHECK(automaton.match(pattern));
+    BOOST_CHECK(automaton.match(UString("中华人民和共国", UString::UTF_8)));
+    BOOST_CHECK(automaton.match(UString("中华民共和国", UString::UTF_8)));
+    BOOST_CHECK(automaton.match(UString("中华人民共和国人", UString::UTF_8)));
+    BOOST_CHECK(!automaton.match(UString("中华人共国", UString::UTF_8)));
+    BOOST_CHECK_EQUAL(automaton.distance(UString("中国人民共和国", UString::UTF_8)), 1U);
+
+    BOOST_REQUIRE(automaton.compile(pattern, 1, false));
+    BOOST_CHECK(!automaton.match(UString("中华人民和共国", UString::UTF_8)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
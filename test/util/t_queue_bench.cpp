@@ -0,0 +1,82 @@
+/// @file   t_queue_bench.cpp
+/// @brief  Throughput of concurrent_queue and mpmc_queue.
+///
+/// usage: manual_t_queue_bench [element number]
+///
+/// For 1, 2 and 4 producers and as many consumers, each producer pushes its
+/// share of the elements (2^22 by default) and the consumers pop them all,
+/// through a queue of 1024 elements.
+#include <util/concurrent_queue.h>
+#include <util/mpmc_queue.h>
+#include <util/ClockTimer.h>
+
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <stdlib.h>
+
+using izenelib::util::concurrent_queue;
+using izenelib::util::mpmc_queue;
+
+template <class QueueT>
+static void produce(QueueT* queue, size_t num)
+{
+    for (size_t i = 0; i < num; ++i)
+        queue->push(i);
+}
+
+template <class QueueT>
+static void consume(QueueT* queue, size_t num, size_t* sum)
+{
+    size_t s = 0;
+    size_t v;
+    for (size_t i = 0; i < num; ++i)
+    {
+        queue->pop(v);
+        s += v;
+    }
+    *sum = s;
+}
+
+template <class QueueT>
+static void bench(const char* name, size_t threadNum, size_t num)
+{
+    QueueT queue(1024);
+    std::vector<size_t> sums(threadNum);
+    size_t share = num / threadNum;
+
+    izenelib::util::ClockTimer timer;
+    boost::thread_group threads;
+    for (size_t i = 0; i < threadNum; ++i)
+        threads.create_thread(boost::bind(consume<QueueT>, &queue, share, &sums[i]));
+    for (size_t i = 0; i < threadNum; ++i)
+        threads.create_thread(boost::bind(produce<QueueT>, &queue, share));
+    threads.join_all();
+    double seconds = timer.elapsed();
+
+    size_t sum = 0;
+    for (size_t i = 0; i < threadNum; ++i)
+        sum += sums[i];
+
+    std::cout << std::setw(18) << name
+              << std::setw(4) << threadNum << "x" << threadNum
+              << std::setw(12) << seconds * 1e9 / (share * threadNum) << " ns"
+              << std::setw(12) << share * threadNum / seconds / 1e6 << " M/s"
+              << "  (" << sum << ")" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t num = argc > 1 ? strtoull(argv[1], NULL, 10) : 1U << 22;
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "hardware threads: " << boost::thread::hardware_concurrency() << std::endl;
+    for (size_t threadNum = 1; threadNum <= 4; threadNum *= 2)
+    {
+        bench<concurrent_queue<size_t> >("concurrent_queue", threadNum, num);
+        bench<mpmc_queue<size_t> >("mpmc_queue", threadNum, num);
+    }
+    return 0;
+}
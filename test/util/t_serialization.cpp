@@ -565,3 +565,128 @@ BOOST_AUTO_TEST_CASE(izene_serialization_test)
 	 test3();*/
 }
 
+
+struct FlatDoc {
+	uint32_t id;
+	std::string title;
+	std::vector<uint32_t> terms;
+	std::vector<std::string> tags;
+	std::map<std::string, int> attrs;
+
+	bool operator ==(const FlatDoc& other) const {
+		return id == other.id && title == other.title && terms == other.terms
+			&& tags == other.tags && attrs == other.attrs;
+	}
+
+	template<class Archive> void serialize(Archive & ar,
+			const unsigned int version) {
+		ar & id;
+		ar & title;
+		ar & terms;
+		ar & tags;
+		ar & attrs;
+	}
+};
+
+MAKE_FLAT_SERIALIZATION(FlatDoc)
+
+// FlatDoc with one field appended
+struct FlatDocV2 {
+	uint32_t id;
+	std::string title;
+	std::vector<uint32_t> terms;
+	std::vector<std::string> tags;
+	std::map<std::string, int> attrs;
+	double score;
+
+	FlatDocV2() : id(0), score(-1) {}
+
+	template<class Archive> void serialize(Archive & ar,
+			const unsigned int version) {
+		ar & id;
+		ar & title;
+		ar & terms;
+		ar & tags;
+		ar & attrs;
+		ar & score;
+	}
+};
+
+MAKE_FLAT_SERIALIZATION(FlatDocV2)
+MAKE_FLAT_VERSION(FlatDocV2, 2)
+
+BOOST_AUTO_TEST_CASE(izene_serialization_flat_test)
+{
+	FlatDoc doc;
+	doc.id = 42;
+	doc.title = "izenesoft";
+	for (uint32_t i = 0; i < 100; ++i)
+		doc.terms.push_back(i * 7);
+	doc.tags.push_back("aa");
+	doc.tags.push_back("abc");
+	doc.attrs["color"] = 3;
+	doc.attrs["brand"] = 5;
+	doc.attrs["size"] = 7;
+
+	// selected through the trait mechanism
+	test_serialization(doc);
+
+	// zero allocation encoding
+	char buf[4096];
+	BOOST_CHECK_EQUAL(flat_write(doc, buf, 10), 0U);
+	std::size_t size = flat_write(doc, buf, sizeof(buf));
+	BOOST_CHECK_EQUAL(size, flat_size(doc));
+
+	// in place access
+	flat::RecordView<FlatDoc> view = flat_view<FlatDoc>(buf);
+	BOOST_CHECK_EQUAL(view.size(), size);
+	BOOST_CHECK_EQUAL(view.nfields(), 5U);
+	BOOST_CHECK_EQUAL(view.field<uint32_t>(0), 42U);
+	BOOST_CHECK(view.field<std::string>(1) == doc.title);
+	flat::VectorView<uint32_t> terms = view.field<std::vector<uint32_t> >(2);
+	BOOST_CHECK_EQUAL(terms.size(), 100U);
+	BOOST_CHECK_EQUAL(terms[99], 99U * 7);
+	BOOST_CHECK_EQUAL(terms.lower_bound(14U), 2U);
+	flat::VectorView<std::string> tags = view.field<std::vector<std::string> >(3);
+	BOOST_CHECK(tags[1] == std::string("abc"));
+	flat::MapView<std::string, int> attrs = view.field<std::map<std::string, int> >(4);
+	BOOST_CHECK_EQUAL(attrs.value(attrs.find(std::string("color"))), 3);
+	BOOST_CHECK_EQUAL(attrs.value(attrs.find(std::string("size"))), 7);
+	BOOST_CHECK_EQUAL(attrs.find(std::string("weight")), attrs.size());
+
+	// old image read by new reader: appended field keeps its default
+	FlatDocV2 v2;
+	flat_read(buf, v2);
+	BOOST_CHECK_EQUAL(v2.id, 42U);
+	BOOST_CHECK(v2.attrs == doc.attrs);
+	BOOST_CHECK_EQUAL(v2.score, -1);
+
+	// new image read by old reader: unknown field is skipped
+	v2.score = 0.5;
+	flat_write(v2, buf, sizeof(buf));
+	BOOST_CHECK_EQUAL(flat_view<FlatDocV2>(buf).version(), 2U);
+	FlatDoc doc2;
+	flat_read(buf, doc2);
+	BOOST_CHECK(doc2 == doc);
+
+	// untrusted images are checked against their sizes
+	size = flat_write(doc, buf, sizeof(buf));
+	BOOST_CHECK(flat_check<FlatDoc>(buf, size));
+	for (std::size_t len = 0; len < size; len += 7)
+		BOOST_CHECK(!flat_check<FlatDoc>(buf, len));
+	BOOST_CHECK(!flat_check<FlatDoc>(buf, size - 1));
+	izene_deserialization_flat<FlatDoc> truncated(buf, size - 1);
+	BOOST_CHECK_THROW(truncated.read_image(doc2), std::runtime_error);
+
+	// an offset of the tags past the image
+	char bad[4096];
+	std::memcpy(bad, buf, size);
+	flat::store<uint32_t>(bad + flat::RECORD_HEADER_SIZE + 3 * sizeof(uint32_t), size + 100);
+	BOOST_CHECK(!flat_check<FlatDoc>(bad, size));
+	// a count of the attrs values differing from that of the keys
+	std::memcpy(bad, buf, size);
+	const char* attrs_image = buf + flat::load<uint32_t>(buf + flat::RECORD_HEADER_SIZE + 4 * sizeof(uint32_t));
+	std::size_t values_count = attrs_image - buf + flat::load<uint32_t>(attrs_image + sizeof(uint32_t));
+	flat::store<uint32_t>(bad + values_count, 2);
+	BOOST_CHECK(!flat_check<FlatDoc>(bad, size));
+}
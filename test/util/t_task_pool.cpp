@@ -0,0 +1,106 @@
+#include <util/task_pool.h>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+#include <boost/bind.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+using izenelib::util::task_pool;
+using izenelib::util::task_future;
+
+namespace
+{
+
+int square(int i)
+{
+    return i * i;
+}
+
+void fail()
+{
+    throw std::runtime_error("failed");
+}
+
+void record(std::vector<int>* order, int i)
+{
+    order->push_back(i);
+}
+
+void increase(boost::atomic<int>* count)
+{
+    ++*count;
+}
+
+/// forks the halves to the pool, the futures waited for running the others
+long sum(task_pool* pool, long begin, long end)
+{
+    if (end - begin <= 1000)
+    {
+        long s = 0;
+        for (long i = begin; i < end; ++i)
+            s += i;
+        return s;
+    }
+    long middle = begin + (end - begin) / 2;
+    task_future<long> left = pool->submit(boost::bind(sum, pool, begin, middle));
+    long right = sum(pool, middle, end);
+    return left.get() + right;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(t_task_pool)
+
+BOOST_AUTO_TEST_CASE(submit_get)
+{
+    task_pool pool(4);
+    BOOST_CHECK_EQUAL(pool.thread_num(), 4U);
+    BOOST_CHECK(!pool.in_worker());
+
+    std::vector<task_future<int> > futures;
+    for (int i = 0; i < 1000; ++i)
+        futures.push_back(pool.submit(boost::bind(square, i)));
+    for (int i = 0; i < 1000; ++i)
+        BOOST_CHECK_EQUAL(futures[i].get(), i * i);
+
+    task_future<void> failed = pool.submit(&fail);
+    BOOST_CHECK_THROW(failed.get(), std::runtime_error);
+    BOOST_CHECK(failed.is_ready());
+
+    boost::atomic<int> count(0);
+    for (int i = 0; i < 10000; ++i)
+        pool.post(boost::bind(increase, &count));
+    pool.post(&fail);
+    pool.wait();
+    BOOST_CHECK_EQUAL(count.load(), 10000);
+    BOOST_CHECK_EQUAL(pool.pending(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(one_thread_in_order)
+{
+    std::vector<int> order;
+    {
+        task_pool pool(1, 16);
+        for (int i = 0; i < 1000; ++i)
+            pool.post(boost::bind(record, &order, i));
+    }
+    BOOST_REQUIRE_EQUAL(order.size(), 1000U);
+    for (int i = 0; i < 1000; ++i)
+        BOOST_CHECK_EQUAL(order[i], i);
+}
+
+BOOST_AUTO_TEST_CASE(fork_join)
+{
+    task_pool pool(4);
+    const long n = 1000000;
+    task_future<long> total = pool.submit(boost::bind(sum, &pool, 0L, n));
+    BOOST_CHECK_EQUAL(total.get(), n * (n - 1) / 2);
+
+    // in a pool of one thread, the task waits running its own forks
+    task_pool single(1);
+    BOOST_CHECK_EQUAL(single.submit(boost::bind(sum, &single, 0L, n)).get(), n * (n - 1) / 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()